@@ -0,0 +1,3 @@
+# pjlib-util/build/os-auto.mak.  Generated from os-auto.mak.in by configure.
+export UTIL_TEST_OBJS = main.o
+
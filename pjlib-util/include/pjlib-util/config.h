@@ -220,6 +220,26 @@
 #endif
 
 
+/**
+ * Macro PJ_SCANNER_USE_SIMD is defined and non-zero will make the scanner
+ * use SIMD instructions to find the end of a token, 16 bytes at a time
+ * with SSSE3 or 32 bytes at a time with AVX2. The instruction set is
+ * selected at run-time based on the CPU, falling back to the byte by byte
+ * scan when neither is available. Each character input specification
+ * keeps a 32 bytes lookup table for this.
+ *
+ * Default: 1 for x86 and x86-64 with GCC 5 or Clang, otherwise 0.
+ */
+#ifndef PJ_SCANNER_USE_SIMD
+#  if (defined(__x86_64__) || defined(__i386__)) && \
+      (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#    define PJ_SCANNER_USE_SIMD                     1
+#  else
+#    define PJ_SCANNER_USE_SIMD                     0
+#  endif
+#endif
+
+
 
 /* **************************************************************************
  * STUN CLIENT CONFIGURATION
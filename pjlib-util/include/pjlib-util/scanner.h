@@ -43,6 +43,24 @@ PJ_BEGIN_DECL
 #  include <pjlib-util/scanner_cis_uint.h>
 #endif
 
+#if PJ_SCANNER_USE_SIMD
+/*
+ * The SIMD lookup table in pj_cis_t has one byte per low nibble of the
+ * character, for characters 0-127 (first 16 bytes) and 128-255 (last 16
+ * bytes), where bit N is set if the character with high nibble N (modulo
+ * 8) is in the set. These are used by PJ_CIS_SET() and PJ_CIS_CLR().
+ */
+#  define PJ_CIS_SIMD_IDX(c)    ((((pj_uint8_t)(c)) >> 3 & 16) | \
+                                 (((pj_uint8_t)(c)) & 15))
+#  define PJ_CIS_SIMD_BIT(c)    (1 << (((pj_uint8_t)(c)) >> 4 & 7))
+#  define PJ_CIS_SIMD_SET(cis,c) \
+            ((cis)->simd_tbl[PJ_CIS_SIMD_IDX(c)] |= \
+             (pj_uint8_t)PJ_CIS_SIMD_BIT(c))
+#  define PJ_CIS_SIMD_CLR(cis,c) \
+            ((cis)->simd_tbl[PJ_CIS_SIMD_IDX(c)] &= \
+             (pj_uint8_t)~PJ_CIS_SIMD_BIT(c))
+#endif
+
 /**
  * Initialize scanner input specification buffer.
  *
@@ -187,6 +205,18 @@ struct pj_scanner;
 typedef void (*pj_syn_err_func_ptr)(struct pj_scanner *scanner);
 
 
+/**
+ * This structure can be used by application to store the state of the parser,
+ * so that the scanner state can be rollback to this state when necessary.
+ */
+typedef struct pj_scan_state
+{
+    char *curptr;       /**< Current scanner's pointer. */
+    int   line;         /**< Current line.              */
+    char *start_line;   /**< Start of current line.     */
+} pj_scan_state;
+
+
 /**
  * The text scanner structure.
  */
@@ -199,26 +229,25 @@ typedef struct pj_scanner
     char *start_line;   /**< Where current line starts. */
     int   skip_ws;      /**< Skip whitespace flag.      */
     pj_syn_err_func_ptr callback;   /**< Syntax error callback. */
+    pj_status_t   err;       /**< First error recorded when the scanner
+                                  has no callback, or PJ_SUCCESS.     */
+    pj_scan_state err_state; /**< Scanner position where the recorded
+                                  error occurred.                      */
 } pj_scanner;
 
 
-/**
- * This structure can be used by application to store the state of the parser,
- * so that the scanner state can be rollback to this state when necessary.
- */
-typedef struct pj_scan_state
-{
-    char *curptr;       /**< Current scanner's pointer. */
-    int   line;         /**< Current line.              */
-    char *start_line;   /**< Start of current line.     */
-} pj_scan_state;
-
-
 /**
  * Initialize the scanner.
  * Note that the input string buffer MUST be NULL terminated and have
  * length at least buflen+1 (buflen MUST NOT include the NULL terminator).
  *
+ * If \a callback is NULL, the scanner does not report syntax errors with
+ * the callback (which normally throws an exception). Instead, the first
+ * error is recorded in the scanner (see #pj_scan_get_error()) and the
+ * scanner is moved to EOF position, so that subsequent operations fail
+ * quickly and return empty results. Application then checks the error
+ * after each logical unit that it parses, without needing PJ_TRY.
+ *
  * @param scanner   The scanner to be initialized.
  * @param bufstart  The input buffer to scan, which must be NULL terminated.
  * @param buflen    The length of the input buffer, which normally is
@@ -226,7 +255,8 @@ typedef struct pj_scan_state
  * @param options   Zero, or combination of PJ_SCAN_AUTOSKIP_WS or
  *                  PJ_SCAN_AUTOSKIP_WS_HEADER
  * @param callback  Callback to be called when the scanner encounters syntax
- *                  error condition.
+ *                  error condition, or NULL to record the error in the
+ *                  scanner instead.
  */
 PJ_DECL(void) pj_scan_init( pj_scanner *scanner, char *bufstart, 
                             pj_size_t buflen, 
@@ -255,6 +285,54 @@ PJ_INLINE(int) pj_scan_is_eof( const pj_scanner *scanner)
 }
 
 
+/**
+ * Report syntax error at the current scanner position. If the scanner has
+ * a callback, the callback will be called. Otherwise PJ_EINVAL will be
+ * recorded as the scanner error (unless an error has been recorded
+ * before) and the scanner is moved to EOF position.
+ *
+ * @param scanner   The scanner.
+ */
+PJ_DECL(void) pj_scan_syntax_err( pj_scanner *scanner );
+
+
+/**
+ * Record an error in a scanner that has no callback, as if a syntax error
+ * has occurred at the current position, but with the specified status
+ * code. Only the first error is recorded. This is useful for reporting
+ * semantic errors (such as out of range values) found by the application
+ * while parsing.
+ *
+ * @param scanner   The scanner.
+ * @param status    The error code, must not be PJ_SUCCESS.
+ */
+PJ_DECL(void) pj_scan_set_error( pj_scanner *scanner, pj_status_t status );
+
+
+/**
+ * Get the error recorded in a scanner that has no callback.
+ *
+ * @param scanner   The scanner.
+ *
+ * @return          PJ_SUCCESS if no error has occurred, or the first error
+ *                  recorded by the scanner.
+ */
+PJ_INLINE(pj_status_t) pj_scan_get_error( const pj_scanner *scanner )
+{
+    return scanner->err;
+}
+
+
+/**
+ * Clear the error recorded in the scanner and move the scanner back to
+ * the position where the error occurred, so that application can resume
+ * parsing from there (for example, after skipping the offending line).
+ *
+ * @param scanner   The scanner.
+ */
+PJ_DECL(void) pj_scan_clear_error( pj_scanner *scanner );
+
+
 /** 
  * Peek strings in current position according to parameter spec, and return
  * the strings in parameter out. The current scanner position will not be
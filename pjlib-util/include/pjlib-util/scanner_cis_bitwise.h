@@ -59,6 +59,9 @@ typedef struct pj_cis_t
 {
     pj_cis_elem_t   *cis_buf;       /**< Pointer to buffer.     */
     int              cis_id;        /**< Id.                    */
+#if PJ_SCANNER_USE_SIMD
+    pj_uint8_t       simd_tbl[32];  /**< SIMD lookup table.     */
+#endif
 } pj_cis_t;
 
 
@@ -69,7 +72,12 @@ typedef struct pj_cis_t
  * @param cis       Pointer to character input specification.
  * @param c         The character.
  */
-#define PJ_CIS_SET(cis,c)   ((cis)->cis_buf[(int)(c)] |= (1 << (cis)->cis_id))
+#if PJ_SCANNER_USE_SIMD
+#  define PJ_CIS_SET(cis,c)  ((cis)->cis_buf[(int)(c)] |= (1 << (cis)->cis_id), \
+                              PJ_CIS_SIMD_SET(cis,c))
+#else
+#  define PJ_CIS_SET(cis,c)  ((cis)->cis_buf[(int)(c)] |= (1 << (cis)->cis_id))
+#endif
 
 /**
  * Remove the membership of the specified character.
@@ -78,7 +86,12 @@ typedef struct pj_cis_t
  * @param cis       Pointer to character input specification.
  * @param c         The character to be removed from the membership.
  */
-#define PJ_CIS_CLR(cis,c)   ((cis)->cis_buf[(int)c] &= ~(1 << (cis)->cis_id))
+#if PJ_SCANNER_USE_SIMD
+#  define PJ_CIS_CLR(cis,c)  ((cis)->cis_buf[(int)c] &= ~(1 << (cis)->cis_id), \
+                              PJ_CIS_SIMD_CLR(cis,c))
+#else
+#  define PJ_CIS_CLR(cis,c)  ((cis)->cis_buf[(int)c] &= ~(1 << (cis)->cis_id))
+#endif
 
 /**
  * Check the membership of the specified character.
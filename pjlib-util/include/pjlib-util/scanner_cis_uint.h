@@ -46,6 +46,9 @@ typedef int pj_cis_buf_t;
 typedef struct pj_cis_t
 {
     PJ_CIS_ELEM_TYPE    cis_buf[256];   /**< Internal buffer.   */
+#if PJ_SCANNER_USE_SIMD
+    pj_uint8_t          simd_tbl[32];   /**< SIMD lookup table. */
+#endif
 } pj_cis_t;
 
 
@@ -56,7 +59,12 @@ typedef struct pj_cis_t
  * @param cis       Pointer to character input specification.
  * @param c         The character.
  */
-#define PJ_CIS_SET(cis,c)   ((cis)->cis_buf[(int)(c)] = 1)
+#if PJ_SCANNER_USE_SIMD
+#  define PJ_CIS_SET(cis,c)  ((cis)->cis_buf[(int)(c)] = 1, \
+                              PJ_CIS_SIMD_SET(cis,c))
+#else
+#  define PJ_CIS_SET(cis,c)  ((cis)->cis_buf[(int)(c)] = 1)
+#endif
 
 /**
  * Remove the membership of the specified character.
@@ -65,7 +73,12 @@ typedef struct pj_cis_t
  * @param cis       Pointer to character input specification.
  * @param c         The character to be removed from the membership.
  */
-#define PJ_CIS_CLR(cis,c)   ((cis)->cis_buf[(int)c] = 0)
+#if PJ_SCANNER_USE_SIMD
+#  define PJ_CIS_CLR(cis,c)  ((cis)->cis_buf[(int)c] = 0, \
+                              PJ_CIS_SIMD_CLR(cis,c))
+#else
+#  define PJ_CIS_CLR(cis,c)  ((cis)->cis_buf[(int)c] = 0)
+#endif
 
 /**
  * Check the membership of the specified character.
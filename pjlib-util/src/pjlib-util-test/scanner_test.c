@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "test.h"
+
+#define THIS_FILE       "scanner_test.c"
+
+#if INCLUDE_SCANNER_TEST
+
+#include <pjlib-util/scanner.h>
+#include <pj/log.h>
+#include <pj/rand.h>
+#include <pj/string.h>
+
+#define MAX_LEN     200
+#define ROUNDS      2000
+
+/* Characters used to fill the buffers. Runs of characters in and out of
+ * the sets are made long enough to cross the 16 and 32 bytes blocks.
+ */
+static const char alphabet[] =
+    "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+    "-.!%*_+`'~ \t\r\n:;,<>\"@/\x7F\x80\xC0\xFF";
+
+/* Reference scan, one character at a time. */
+static int ref_span(const pj_cis_t *cis, const char *s, const char *end,
+                    int in)
+{
+    const char *p = s;
+    while (p != end && (pj_cis_match(cis, *p) ? 1 : 0) == in)
+        ++p;
+    return (int)(p - s);
+}
+
+static void fill_buf(char *buf, int len)
+{
+    int i = 0;
+
+    while (i < len) {
+        /* Repeat a character to get runs of random length. */
+        char c = alphabet[pj_rand() % (sizeof(alphabet)-1)];
+        int run = 1 + (pj_rand() % 40);
+
+        while (run-- && i < len)
+            buf[i++] = (pj_rand() % 4) ? c :
+                       alphabet[pj_rand() % (sizeof(alphabet)-1)];
+    }
+    buf[len] = '\0';
+}
+
+static int verify_cis(const char *title, const pj_cis_t *cis)
+{
+    char buf[MAX_LEN+1];
+    unsigned round;
+
+    for (round=0; round < ROUNDS; ++round) {
+        int len = 1 + (pj_rand() % MAX_LEN);
+        pj_scanner scanner;
+        pj_str_t out;
+        int expected;
+
+        fill_buf(buf, len);
+
+        /* pj_scan_peek() */
+        pj_scan_init(&scanner, buf, len, 0, NULL);
+        pj_scan_peek(&scanner, cis, &out);
+        expected = ref_span(cis, buf, buf+len, 1);
+        if (out.slen != expected) {
+            PJ_LOG(3,(THIS_FILE, "  %s: pj_scan_peek() returns %d chars, "
+                      "expecting %d", title, (int)out.slen, expected));
+            return -10;
+        }
+
+        /* pj_scan_peek_until() */
+        pj_scan_init(&scanner, buf, len, 0, NULL);
+        pj_scan_peek_until(&scanner, cis, &out);
+        expected = ref_span(cis, buf, buf+len, 0);
+        if (out.slen != expected) {
+            PJ_LOG(3,(THIS_FILE, "  %s: pj_scan_peek_until() returns %d "
+                      "chars, expecting %d", title, (int)out.slen,
+                      expected));
+            return -20;
+        }
+
+        /* pj_scan_get_until(), from an offset */
+        if (len > 1) {
+            int off = pj_rand() % (len-1);
+
+            pj_scan_init(&scanner, buf, len, 0, NULL);
+            pj_scan_advance_n(&scanner, off, PJ_FALSE);
+            pj_scan_get_until(&scanner, cis, &out);
+            expected = ref_span(cis, buf+off, buf+len, 0);
+            if (out.ptr != buf+off || out.slen != expected ||
+                scanner.curptr != buf+off+expected)
+            {
+                PJ_LOG(3,(THIS_FILE, "  %s: pj_scan_get_until() returns %d "
+                          "chars, expecting %d", title, (int)out.slen,
+                          expected));
+                return -30;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int cis_test(void)
+{
+    pj_cis_buf_t cis_buf;
+    pj_cis_t token, not_newline, alpha, dup;
+    int rc;
+
+    PJ_LOG(3,(THIS_FILE, "  character input specification test.."));
+
+    pj_cis_buf_init(&cis_buf);
+
+    pj_cis_init(&cis_buf, &token);
+    pj_cis_add_alpha(&token);
+    pj_cis_add_num(&token);
+    pj_cis_add_str(&token, "-.!%*_+`'~");
+
+    pj_cis_init(&cis_buf, &not_newline);
+    pj_cis_add_str(&not_newline, "\r\n");
+    pj_cis_invert(&not_newline);
+
+    pj_cis_init(&cis_buf, &alpha);
+    pj_cis_add_range(&alpha, 'a', 'z'+1);
+    pj_cis_add_range(&alpha, 0xC0, 0x100);
+    pj_cis_del_range(&alpha, 'm', 'p');
+    pj_cis_del_str(&alpha, "\xFF");
+
+    pj_cis_dup(&dup, &token);
+    pj_cis_del_str(&dup, "0123456789");
+    pj_cis_add_str(&dup, "\x80");
+
+    rc = verify_cis("token", &token);
+    if (rc == 0)
+        rc = verify_cis("not_newline", &not_newline);
+    if (rc == 0)
+        rc = verify_cis("alpha", &alpha);
+    if (rc == 0)
+        rc = verify_cis("dup", &dup);
+
+    return rc;
+}
+
+static int get_until_ch_test(void)
+{
+    char buf[MAX_LEN+1];
+    unsigned round;
+
+    PJ_LOG(3,(THIS_FILE, "  pj_scan_get_until_ch() test.."));
+
+    for (round=0; round < ROUNDS; ++round) {
+        int len = 1 + (pj_rand() % MAX_LEN);
+        char ch = alphabet[pj_rand() % (sizeof(alphabet)-1)];
+        pj_scanner scanner;
+        pj_str_t out;
+        char *p;
+
+        fill_buf(buf, len);
+        p = (char*)pj_memchr(buf, ch, len);
+        if (!p)
+            p = buf + len;
+
+        pj_scan_init(&scanner, buf, len, 0, NULL);
+        pj_scan_get_until_ch(&scanner, ch, &out);
+        if (out.ptr != buf || out.ptr + out.slen != p ||
+            scanner.curptr != p)
+        {
+            PJ_LOG(3,(THIS_FILE, "  pj_scan_get_until_ch() returns %d chars, "
+                      "expecting %d", (int)out.slen, (int)(p-buf)));
+            return -40;
+        }
+    }
+
+    return 0;
+}
+
+int scanner_test(void)
+{
+    int rc;
+
+    rc = cis_test();
+    if (rc)
+        return rc;
+
+    rc = get_until_ch_test();
+    if (rc)
+        return rc;
+
+    return 0;
+}
+
+#else
+int scanner_test_dummy;
+#endif
@@ -59,6 +59,10 @@ static int test_inner(int argc, char *argv[])
     if (test_app.ut_app.prm_config)
         pj_dump_config();
 
+#if INCLUDE_SCANNER_TEST
+    UT_ADD_TEST(&test_app.ut_app, scanner_test, 0);
+#endif
+
 #if INCLUDE_XML_TEST
     UT_ADD_TEST(&test_app.ut_app, xml_test, 0);
 #endif
@@ -40,10 +40,157 @@
 #endif
 
 
+#if PJ_SCANNER_USE_SIMD
+#include <immintrin.h>
+
+/*
+ * Find the first character in [s, end) whose membership in the set
+ * described by the SIMD lookup table is not equal to "in", 16 or 32
+ * characters at a time. Only whole blocks are checked, so the returned
+ * pointer may be before the character when there are fewer than 16
+ * characters left, and the caller must continue with the scalar loop.
+ *
+ * For each character, the low nibble selects the byte in the table half
+ * for the character's top bit, and the high nibble (modulo 8) selects the
+ * bit in that byte.
+ */
+__attribute__((target("ssse3")))
+static char* cis_span_ssse3(const pj_uint8_t *tbl, char *s, char *end,
+                            int in)
+{
+    const __m128i tbl_lo = _mm_loadu_si128((const __m128i*)tbl);
+    const __m128i tbl_hi = _mm_loadu_si128((const __m128i*)(tbl + 16));
+    const __m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                       1, 2, 4, 8, 16, 32, 64, -128);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i zero = _mm_setzero_si128();
+    unsigned flip = in ? 0 : 0xFFFF;
+
+    while (end - s >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)s);
+        __m128i lo = _mm_and_si128(v, nibble);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+        __m128i top = _mm_cmplt_epi8(v, zero);
+        __m128i row = _mm_or_si128(
+                        _mm_and_si128(top, _mm_shuffle_epi8(tbl_hi, lo)),
+                        _mm_andnot_si128(top, _mm_shuffle_epi8(tbl_lo, lo)));
+        __m128i out = _mm_cmpeq_epi8(
+                        _mm_and_si128(row, _mm_shuffle_epi8(bits, hi)),
+                        zero);
+        unsigned mask = (unsigned)_mm_movemask_epi8(out) ^ flip;
+
+        if (mask)
+            return s + __builtin_ctz(mask);
+        s += 16;
+    }
+
+    return s;
+}
+
+/* AVX2 version of cis_span_ssse3() above. */
+__attribute__((target("avx2")))
+static char* cis_span_avx2(const pj_uint8_t *tbl, char *s, char *end,
+                           int in)
+{
+    const __m256i tbl_lo = _mm256_broadcastsi128_si256(
+                                _mm_loadu_si128((const __m128i*)tbl));
+    const __m256i tbl_hi = _mm256_broadcastsi128_si256(
+                                _mm_loadu_si128((const __m128i*)(tbl+16)));
+    const __m256i bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                          1, 2, 4, 8, 16, 32, 64, -128,
+                                          1, 2, 4, 8, 16, 32, 64, -128,
+                                          1, 2, 4, 8, 16, 32, 64, -128);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i zero = _mm256_setzero_si256();
+    pj_uint32_t flip = in ? 0 : 0xFFFFFFFF;
+
+    while (end - s >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)s);
+        __m256i lo = _mm256_and_si256(v, nibble);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+        __m256i row = _mm256_blendv_epi8(_mm256_shuffle_epi8(tbl_lo, lo),
+                                         _mm256_shuffle_epi8(tbl_hi, lo),
+                                         v);
+        __m256i out = _mm256_cmpeq_epi8(
+                        _mm256_and_si256(row, _mm256_shuffle_epi8(bits, hi)),
+                        zero);
+        pj_uint32_t mask = (pj_uint32_t)_mm256_movemask_epi8(out) ^ flip;
+
+        if (mask)
+            return s + __builtin_ctz(mask);
+        s += 32;
+    }
+
+    return cis_span_ssse3(tbl, s, end, in);
+}
+
+#endif  /* PJ_SCANNER_USE_SIMD */
+
+/* Skip characters that are in the set (when "in" is non-zero), or that
+ * are not in the set (when "in" is zero), and return pointer to the first
+ * character that is not skipped, or end.
+ */
+PJ_INLINE(char*) cis_span(const pj_cis_t *spec, char *s, char *end, int in)
+{
+#if PJ_SCANNER_USE_SIMD
+    if (end - s >= 16) {
+        if (__builtin_cpu_supports("avx2"))
+            s = cis_span_avx2(spec->simd_tbl, s, end, in);
+        else if (__builtin_cpu_supports("ssse3"))
+            s = cis_span_ssse3(spec->simd_tbl, s, end, in);
+    }
+#endif
+
+    if (in) {
+        while (s != end && pj_cis_match(spec, *s))
+            ++s;
+    } else {
+        while (s != end && !pj_cis_match(spec, *s))
+            ++s;
+    }
+    return s;
+}
+
+
 /* coverity[+kill] */
-static void pj_scan_syntax_err(pj_scanner *scanner)
+PJ_DEF(void) pj_scan_syntax_err(pj_scanner *scanner)
 {
-    (*scanner->callback)(scanner);
+    if (scanner->callback) {
+        (*scanner->callback)(scanner);
+        return;
+    }
+    pj_scan_set_error(scanner, PJ_EINVAL);
+}
+
+PJ_DEF(void) pj_scan_set_error(pj_scanner *scanner, pj_status_t status)
+{
+    pj_assert(status != PJ_SUCCESS);
+
+    if (scanner->err == PJ_SUCCESS) {
+        scanner->err = status;
+        pj_scan_save_state(scanner, &scanner->err_state);
+    }
+
+    /* Move to EOF so that the remaining operations fail quickly. Loops
+     * checking the current character will stop at the NULL terminator.
+     */
+    scanner->curptr = scanner->end;
+}
+
+PJ_DEF(void) pj_scan_clear_error(pj_scanner *scanner)
+{
+    if (scanner->err != PJ_SUCCESS) {
+        pj_scan_restore_state(scanner, &scanner->err_state);
+        scanner->err = PJ_SUCCESS;
+    }
+}
+
+/* Report syntax error and return empty string at current position. */
+static void scan_err_out(pj_scanner *scanner, pj_str_t *out)
+{
+    pj_scan_syntax_err(scanner);
+    out->ptr = scanner->curptr;
+    out->slen = 0;
 }
 
 
@@ -72,7 +219,7 @@ PJ_DEF(void) pj_cis_add_num(pj_cis_t *cis)
 PJ_DEF(void) pj_cis_add_str( pj_cis_t *cis, const char *str)
 {
     while (*str) {
-        PJ_CIS_SET(cis, *str);
+        PJ_CIS_SET(cis, (pj_uint8_t)*str);
         ++str;
     }
 }
@@ -97,7 +244,7 @@ PJ_DEF(void) pj_cis_del_range( pj_cis_t *cis, int cstart, int cend)
 PJ_DEF(void) pj_cis_del_str( pj_cis_t *cis, const char *str)
 {
     while (*str) {
-        PJ_CIS_CLR(cis, *str);
+        PJ_CIS_CLR(cis, (pj_uint8_t)*str);
         ++str;
     }
 }
@@ -126,6 +273,7 @@ PJ_DEF(void) pj_scan_init( pj_scanner *scanner, char *bufstart,
     scanner->start_line = scanner->begin;
     scanner->callback = callback;
     scanner->skip_ws = options;
+    scanner->err = PJ_SUCCESS;
 
     if (scanner->skip_ws) 
         pj_scan_skip_whitespace(scanner);
@@ -222,12 +370,11 @@ PJ_DEF(int) pj_scan_peek( pj_scanner *scanner,
     register char *s = scanner->curptr;
 
     if (s >= scanner->end) {
-        pj_scan_syntax_err(scanner);
+        scan_err_out(scanner, out);
         return -1;
     }
 
-    while (PJ_SCAN_CHECK_EOF(s) && pj_cis_match(spec, *s))
-        ++s;
+    s = cis_span(spec, s, scanner->end, 1);
 
     pj_strset3(out, scanner->curptr, s);
     return *s;
@@ -240,7 +387,7 @@ PJ_DEF(int) pj_scan_peek_n( pj_scanner *scanner,
     char *endpos = scanner->curptr + len;
 
     if (endpos > scanner->end) {
-        pj_scan_syntax_err(scanner);
+        scan_err_out(scanner, out);
         return -1;
     }
 
@@ -256,12 +403,11 @@ PJ_DEF(int) pj_scan_peek_until( pj_scanner *scanner,
     register char *s = scanner->curptr;
 
     if (s >= scanner->end) {
-        pj_scan_syntax_err(scanner);
+        scan_err_out(scanner, out);
         return -1;
     }
 
-    while (PJ_SCAN_CHECK_EOF(s) && !pj_cis_match( spec, *s))
-        ++s;
+    s = cis_span(spec, s, scanner->end, 0);
 
     pj_strset3(out, scanner->curptr, s);
     return *s;
@@ -276,13 +422,11 @@ PJ_DEF(void) pj_scan_get( pj_scanner *scanner,
     pj_assert(pj_cis_match(spec,0)==0);
 
     if (pj_scan_is_eof(scanner) || !pj_cis_match(spec, *s)) {
-        pj_scan_syntax_err(scanner);
+        scan_err_out(scanner, out);
         return;
     }
 
-    do {
-        ++s;
-    } while (PJ_SCAN_CHECK_EOF(s) && pj_cis_match(spec, *s));
+    s = cis_span(spec, s+1, scanner->end, 1);
 
     pj_strset3(out, scanner->curptr, s);
 
@@ -308,7 +452,7 @@ PJ_DEF(void) pj_scan_get_unescape( pj_scanner *scanner,
     pj_assert(pj_cis_match(spec,'%')==0);
 
     if (pj_scan_is_eof(scanner) || (!pj_cis_match(spec, *s) && *s != '%')) {
-        pj_scan_syntax_err(scanner);
+        scan_err_out(scanner, out);
         return;
     }
 
@@ -379,7 +523,7 @@ PJ_DEF(void) pj_scan_get_quotes(pj_scanner *scanner,
         }
     }
     if (qpair == -1) {
-        pj_scan_syntax_err(scanner);
+        scan_err_out(scanner, out);
         return;
     }
     ++s;
@@ -418,7 +562,7 @@ PJ_DEF(void) pj_scan_get_quotes(pj_scanner *scanner,
 
     /* Check and eat the end quote. */
     if (*s != end_quote[qpair]) {
-        pj_scan_syntax_err(scanner);
+        scan_err_out(scanner, out);
         return;
     }
     ++s;
@@ -439,7 +583,7 @@ PJ_DEF(void) pj_scan_get_n( pj_scanner *scanner,
                             unsigned N, pj_str_t *out)
 {
     if (scanner->curptr + N > scanner->end) {
-        pj_scan_syntax_err(scanner);
+        scan_err_out(scanner, out);
         return;
     }
 
@@ -522,13 +666,11 @@ PJ_DEF(void) pj_scan_get_until( pj_scanner *scanner,
     register char *s = scanner->curptr;
 
     if (s >= scanner->end) {
-        pj_scan_syntax_err(scanner);
+        scan_err_out(scanner, out);
         return;
     }
 
-    while (PJ_SCAN_CHECK_EOF(s) && !pj_cis_match(spec, *s)) {
-        ++s;
-    }
+    s = cis_span(spec, s, scanner->end, 0);
 
     pj_strset3(out, scanner->curptr, s);
 
@@ -548,13 +690,13 @@ PJ_DEF(void) pj_scan_get_until_ch( pj_scanner *scanner,
     register char *s = scanner->curptr;
 
     if (s >= scanner->end) {
-        pj_scan_syntax_err(scanner);
+        scan_err_out(scanner, out);
         return;
     }
 
-    while (PJ_SCAN_CHECK_EOF(s) && *s != until_char) {
-        ++s;
-    }
+    s = (char*)pj_memchr(s, until_char, scanner->end - s);
+    if (!s)
+        s = scanner->end;
 
     pj_strset3(out, scanner->curptr, s);
 
@@ -575,7 +717,7 @@ PJ_DEF(void) pj_scan_get_until_chr( pj_scanner *scanner,
     pj_size_t speclen;
 
     if (s >= scanner->end) {
-        pj_scan_syntax_err(scanner);
+        scan_err_out(scanner, out);
         return;
     }
 
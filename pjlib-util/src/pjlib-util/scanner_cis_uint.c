@@ -33,6 +33,9 @@ PJ_DEF(pj_status_t) pj_cis_init(pj_cis_buf_t *cis_buf, pj_cis_t *cis)
 {
     PJ_UNUSED_ARG(cis_buf);
     pj_bzero(cis->cis_buf, sizeof(cis->cis_buf));
+#if PJ_SCANNER_USE_SIMD
+    pj_bzero(cis->simd_tbl, sizeof(cis->simd_tbl));
+#endif
     return PJ_SUCCESS;
 }
 
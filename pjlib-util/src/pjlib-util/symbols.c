@@ -57,6 +57,9 @@ PJ_EXPORT_SYMBOL(pj_scan_stricmp)
 PJ_EXPORT_SYMBOL(pj_scan_skip_whitespace)
 PJ_EXPORT_SYMBOL(pj_scan_save_state)
 PJ_EXPORT_SYMBOL(pj_scan_restore_state)
+PJ_EXPORT_SYMBOL(pj_scan_syntax_err)
+PJ_EXPORT_SYMBOL(pj_scan_set_error)
+PJ_EXPORT_SYMBOL(pj_scan_clear_error)
 
 /*
  * stun.h
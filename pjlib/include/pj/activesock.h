@@ -210,7 +210,10 @@ typedef struct pj_activesock_cfg
      * field. Setting this field to more than one will allow more than one
      * incoming data or incoming connections to be processed simultaneously
      * on multiprocessor systems, when the ioqueue is polled by more than
-     * one threads.
+     * one threads. For datagram sockets, it also allows the ioqueue to
+     * read up to this many datagrams per readiness event (see
+     * PJ_IOQUEUE_MAX_RECV_BATCH), and the \a on_data_recvfrom() callback
+     * is then called for each of them in turn.
      *
      * The default value is 1.
      */
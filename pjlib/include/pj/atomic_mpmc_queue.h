@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2025 Teluu Inc. (http://www.teluu.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef __PJ_ATOMIC_MPMC_QUEUE_H__
+#define __PJ_ATOMIC_MPMC_QUEUE_H__
+
+/**
+ * @file atomic_mpmc_queue.h
+ * @brief Multi-producer multi-consumer atomic queue
+ * @{
+ *
+ * Bounded lock-free queue for multiple producers and multiple consumers.
+ * Unlike the single producer/consumer queue in atomic_queue.h, any number
+ * of threads may call #pj_atomic_mpmc_queue_put() and
+ * #pj_atomic_mpmc_queue_get() concurrently, e.g: to hand packets from
+ * several ioqueue threads to a pool of worker threads without a mutex.
+ *
+ * The queue is a ring buffer where each slot carries a sequence number,
+ * telling producers and consumers whether the slot is ready to be written
+ * or read. The head and tail positions are kept in separate cache lines.
+ * When the queue is full, put fails instead of discarding old items.
+ */
+
+#include <pj/types.h>
+
+PJ_BEGIN_DECL
+
+/**
+ * Create a new multi-producer multi-consumer atomic queue.
+ *
+ * @param pool          The pool to allocate the queue structure.
+ * @param max_item_cnt  The maximum number of items that can be stored.
+ *                      This will be rounded up to the next power of two.
+ * @param item_size     The size of each item.
+ * @param name          The name of the queue.
+ * @param queue         Pointer to hold the newly created queue.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pj_atomic_mpmc_queue_create(
+                                        pj_pool_t *pool,
+                                        unsigned max_item_cnt,
+                                        unsigned item_size,
+                                        const char *name,
+                                        pj_atomic_mpmc_queue_t **queue);
+
+/**
+ * Destroy the queue. Application must make sure that no other threads
+ * are using the queue.
+ *
+ * @param queue         The queue to be destroyed.
+ *
+ * @return              PJ_SUCCESS if success.
+ */
+PJ_DECL(pj_status_t) pj_atomic_mpmc_queue_destroy(
+                                        pj_atomic_mpmc_queue_t *queue);
+
+/**
+ * Put an item to the back of the queue.
+ *
+ * @param queue         The queue.
+ * @param item          The pointer to the data to store, with the size
+ *                      specified when creating the queue.
+ *
+ * @return              PJ_SUCCESS if success, or PJ_ETOOMANY if the queue
+ *                      is full.
+ */
+PJ_DECL(pj_status_t) pj_atomic_mpmc_queue_put(pj_atomic_mpmc_queue_t *queue,
+                                              const void *item);
+
+/**
+ * Get an item from the head of the queue.
+ *
+ * @param queue         The queue.
+ * @param item          The pointer to the buffer to receive the data.
+ *
+ * @return              PJ_SUCCESS if success, or PJ_ENOTFOUND if the queue
+ *                      is empty.
+ */
+PJ_DECL(pj_status_t) pj_atomic_mpmc_queue_get(pj_atomic_mpmc_queue_t *queue,
+                                              void *item);
+
+/**
+ * Get the approximate number of items in the queue. The value may be
+ * outdated by the time it is returned if other threads are using the
+ * queue.
+ *
+ * @param queue         The queue.
+ *
+ * @return              The number of items.
+ */
+PJ_DECL(unsigned) pj_atomic_mpmc_queue_size(pj_atomic_mpmc_queue_t *queue);
+
+/**
+ * @}
+ */
+
+PJ_END_DECL
+
+#endif
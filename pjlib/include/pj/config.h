@@ -560,6 +560,26 @@
 #endif
 
 
+/**
+ * Default number of released pools of each size class that the caching
+ * pool factory keeps in a per-thread cache, so that pools can be created
+ * and released without taking the caching pool lock. Set to zero to
+ * disable the per-thread cache. This can also be changed for each caching
+ * pool with pj_caching_pool_set_thread_cache().
+ *
+ * Pools that go through the per-thread cache are not listed in the
+ * caching pool's used list, hence they are not shown in the detailed
+ * dump, not counted in used_count, and not checked by PJ_SAFE_POOL.
+ * Released pools held in per-thread caches are not counted against the
+ * caching pool's max_capacity.
+ *
+ * Default: 0 (disabled)
+ */
+#ifndef PJ_CACHING_POOL_THREAD_CACHE_SIZE
+#   define PJ_CACHING_POOL_THREAD_CACHE_SIZE    0
+#endif
+
+
 /**
  * Enable timer debugging facility. When this is enabled, application
  * can call pj_timer_heap_dump() to show the contents of the timer
@@ -605,6 +625,21 @@
 #  define PJ_TIMER_USE_LINKED_LIST    0
 #endif
 
+/**
+ * Default timer heap implementation for timer heaps created with
+ * pj_timer_heap_create(). The value is one of pj_timer_heap_type:
+ * 0 (PJ_TIMER_HEAP_BINARY) for binary heap tree, or 1 (PJ_TIMER_HEAP_WHEEL)
+ * for hierarchical timing wheel. Timing wheel has O(1) schedule and cancel,
+ * which suits applications with large number of timers that are mostly
+ * cancelled before they expire (such as SIP transaction timers). It is not
+ * available when PJ_TIMER_USE_LINKED_LIST is enabled.
+ *
+ * Default: 0 (Use binary heap tree)
+ */
+#ifndef PJ_TIMER_HEAP_DEFAULT_TYPE
+#  define PJ_TIMER_HEAP_DEFAULT_TYPE  0
+#endif
+
 /**
  * Set this to 1 to enable debugging on the group lock. Default: 0
  */
@@ -717,6 +752,9 @@
 /** Using Symbian (deprecated) */
 #define PJ_IOQUEUE_IMP_SYMBIAN      6
 
+/** Using Linux io_uring (experimental, requires Linux 5.11 or later) */
+#define PJ_IOQUEUE_IMP_URING        7
+
 /**
  * I/O queue implementation backend.
  *
@@ -811,6 +849,39 @@
 #endif
 
 
+/**
+ * Maximum number of datagrams to be read with a single recvmmsg() call
+ * when a datagram socket becomes readable while it has more than one
+ * pending pj_ioqueue_recvfrom() operation. Each datagram completes one
+ * pending operation, and the read callbacks are called one after another
+ * without going back to the polling function. This is only used by the
+ * epoll ioqueue backend. Set to 1 to disable batch receive.
+ *
+ * Default: 16 on Linux, 1 otherwise
+ */
+#ifndef PJ_IOQUEUE_MAX_RECV_BATCH
+#   if defined(PJ_LINUX) && PJ_LINUX!=0
+#       define PJ_IOQUEUE_MAX_RECV_BATCH    16
+#   else
+#       define PJ_IOQUEUE_MAX_RECV_BATCH    1
+#   endif
+#endif
+
+
+/**
+ * Number of submission queue entries of the io_uring ring, when io_uring
+ * ioqueue backend (PJ_IOQUEUE_IMP_URING) is used. This limits how many
+ * operations can be queued to the kernel between two io_uring_enter()
+ * calls; the completion queue is twice as large. The kernel rounds the
+ * value up to a power of two.
+ *
+ * Default: 1024
+ */
+#ifndef PJ_IOQUEUE_URING_ENTRIES
+#   define PJ_IOQUEUE_URING_ENTRIES     1024
+#endif
+
+
 /**
  * Determine if FD_SETSIZE is changeable/set-able. If so, then we will
  * set it to PJ_IOQUEUE_MAX_HANDLES. Currently we detect this by checking
@@ -1182,6 +1253,54 @@
 #endif
 
 
+/**
+ * Maximum number of OpenSSL contexts (SSL_CTX) kept in the SSL context
+ * cache. SSL sockets with the same settings, i.e: credentials, protocols,
+ * ciphers, curves and verification mode, share one SSL context from the
+ * cache, so the certificates and keys are only loaded when the first of
+ * such socket is created. Use pj_ssl_ctx_cache_flush() to reload the
+ * credentials, e.g: after the certificate has been renewed. This is only
+ * applicable for OpenSSL backend.
+ *
+ * Set to zero to disable the cache.
+ *
+ * Default: 16
+ */
+#ifndef PJ_SSL_SOCK_OSSL_CTX_CACHE_SIZE
+#   define PJ_SSL_SOCK_OSSL_CTX_CACHE_SIZE  16
+#endif
+
+
+/**
+ * Maximum number of TLS sessions kept in the client session cache, used
+ * for resuming sessions when pj_ssl_sock_param.session_resumption is
+ * enabled. A cached session is only offered by SSL sockets sharing the
+ * SSL context of the socket that negotiated it, so this requires the SSL
+ * context cache (PJ_SSL_SOCK_OSSL_CTX_CACHE_SIZE). This is only applicable
+ * for OpenSSL backend.
+ *
+ * Set to zero to disable the cache.
+ *
+ * Default: 256
+ */
+#ifndef PJ_SSL_SOCK_OSSL_SESS_CACHE_SIZE
+#   define PJ_SSL_SOCK_OSSL_SESS_CACHE_SIZE 256
+#endif
+
+
+/**
+ * Number of SSL socket handshake worker threads, used by SSL sockets with
+ * pj_ssl_sock_param.async_handshake enabled. The threads are shared by
+ * all SSL sockets and started when the first asynchronous handshake is
+ * requested.
+ *
+ * Default: 2
+ */
+#ifndef PJ_SSL_SOCK_HANDSHAKE_THREAD_CNT
+#   define PJ_SSL_SOCK_HANDSHAKE_THREAD_CNT 2
+#endif
+
+
 /**
  * Disable WSAECONNRESET error for UDP sockets on Win32 platforms. See
  * https://github.com/pjsip/pjproject/issues/1197.
@@ -36,6 +36,11 @@ PJ_BEGIN_DECL
  * hash functions. Having the keys of more than one item map to the same 
  * position is called a collision. In this library, we will chain the nodes
  * that have the same key in a list.
+ *
+ * Alternatively, application may create a hash table with open addressing
+ * with #pj_hash_create2(). Such table stores the entries directly in an
+ * array and grows as more entries are added, so lookup stays fast when
+ * the number of entries is not known in advance.
  */
 
 /**
@@ -84,6 +89,34 @@ PJ_DECL(pj_uint32_t) pj_hash_calc_tolower(pj_uint32_t hval,
                                           char *result,
                                           const pj_str_t *key);
 
+/**
+ * Hash table types, see #pj_hash_create2().
+ */
+typedef enum pj_hash_type
+{
+    /**
+     * Fixed size table where entries with colliding hash are chained in
+     * a list. This is the type created by #pj_hash_create().
+     */
+    PJ_HASH_TYPE_CHAINED,
+
+    /**
+     * Open addressing (linear probing) table, which stores the entries
+     * and their hash values in an array, and doubles the array when it
+     * becomes three quarters full. The entries are moved to the new array
+     * a few at a time on subsequent insertions, so a single insertion
+     * never needs to rehash the whole table.
+     *
+     * Deleting entries while iterating the table is allowed, but entries
+     * must not be added while iterating. The memory of the arrays is
+     * allocated from the pool specified when creating the table and is
+     * not released until the pool is released, although the array is
+     * reused when the table is rehashed to remove deleted entries.
+     */
+    PJ_HASH_TYPE_OPEN_ADDRESSING
+
+} pj_hash_type;
+
 /**
  * Create a hash table with the specified 'bucket' size.
  *
@@ -95,6 +128,22 @@ PJ_DECL(pj_uint32_t) pj_hash_calc_tolower(pj_uint32_t hval,
 PJ_DECL(pj_hash_table_t*) pj_hash_create(pj_pool_t *pool, unsigned size);
 
 
+/**
+ * Create a hash table with the specified type. All other hash table
+ * functions work with both types of table.
+ *
+ * @param pool  the pool from which the hash table will be allocated from.
+ * @param size  for PJ_HASH_TYPE_CHAINED, the bucket size, which will be
+ *              round-up to the nearest 2^n-1. For
+ *              PJ_HASH_TYPE_OPEN_ADDRESSING, the expected number of
+ *              entries, which the table can hold without being resized.
+ * @param type  the hash table type.
+ * @return the hash table.
+ */
+PJ_DECL(pj_hash_table_t*) pj_hash_create2(pj_pool_t *pool, unsigned size,
+                                          pj_hash_type type);
+
+
 /**
  * Get the value associated with the specified key.
  *
@@ -25,6 +25,7 @@
  */
 
 #include <pj/types.h>
+#include <pj/sock.h>
 
 PJ_BEGIN_DECL
 
@@ -931,6 +932,37 @@ PJ_DECL(pj_status_t) pj_ioqueue_sendto( pj_ioqueue_key_t *key,
                                         int addrlen);
 
 
+/**
+ * Send several datagrams on the handle, possibly to different destinations,
+ * with as few system calls as possible (see #pj_sock_sendto_batch()).
+ * Unlike #pj_ioqueue_sendto(), this function never queues any datagram:
+ * it sends what can be sent immediately and reports how many datagrams
+ * have been sent, and the write callback will not be called. Datagrams
+ * that were not sent can be sent later with #pj_ioqueue_sendto().
+ *
+ * To keep the datagrams in order, nothing is sent while there is a pending
+ * write operation on the handle.
+ *
+ * @param key       the key that identifies the handle.
+ * @param msg       Array of datagrams to send. Upon return, the \a len
+ *                  field of each datagram that was sent is filled with
+ *                  the length of data sent.
+ * @param count     On input, the number of datagrams in \a msg. Upon
+ *                  return, it contains the number of datagrams sent.
+ * @param flags     send flags.
+ *
+ * @return
+ *  - PJ_SUCCESS    If at least one datagram was written.
+ *  - PJ_EBUSY      If there is a pending write operation on the handle.
+ *  - non-zero      The return value indicates the error code of sending
+ *                  the first datagram.
+ */
+PJ_DECL(pj_status_t) pj_ioqueue_sendto_batch( pj_ioqueue_key_t *key,
+                                              pj_sock_sendto_msg msg[],
+                                              unsigned *count,
+                                              pj_uint32_t flags);
+
+
 /**
  * Get the underlying OS handle associated with an ioqueue instance.
  *
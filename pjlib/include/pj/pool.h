@@ -955,6 +955,22 @@ struct pj_caching_pool
      * Mutex.
      */
     pj_lock_t      *lock;
+
+    /**
+     * Maximum number of pools of each size kept in a per-thread cache,
+     * zero if per-thread cache is disabled.
+     */
+    unsigned        thread_cache_size;
+
+    /**
+     * Thread local storage id of the per-thread cache.
+     */
+    long            thread_cache_id;
+
+    /**
+     * List of per-thread caches.
+     */
+    pj_list         thread_cache_list;
 };
 
 
@@ -982,6 +998,38 @@ PJ_DECL(void) pj_caching_pool_init( pj_caching_pool *ch_pool,
  */
 PJ_DECL(void) pj_caching_pool_destroy( pj_caching_pool *ch_pool );
 
+/**
+ * Set the maximum number of released pools of each size that the caching
+ * pool keeps in a per-thread cache. With per-thread cache, most pool
+ * creation and release will not need to take the caching pool lock, which
+ * helps when many threads create and release pools concurrently, such as
+ * when handling incoming SIP messages. Pools are moved between the
+ * per-thread cache and the shared cache in batches, and pools that are
+ * not used for a while are moved back to the shared cache.
+ *
+ * This must be called before any pool is created from the caching pool.
+ * See also PJ_CACHING_POOL_THREAD_CACHE_SIZE.
+ *
+ * @param ch_pool       The caching pool.
+ * @param size          Maximum number of pools of each size to be kept in
+ *                      each thread, or zero to disable per-thread cache.
+ *
+ * @return              PJ_SUCCESS, or the appropriate error code.
+ */
+PJ_DECL(pj_status_t) pj_caching_pool_set_thread_cache(pj_caching_pool *ch_pool,
+                                                      unsigned size);
+
+/**
+ * Move pools in the per-thread cache of the calling thread back to the
+ * shared cache of the caching pool. Application may call this before a
+ * thread that has created pools exits, so the pools can be reused by
+ * other threads. Otherwise the pools are only freed when the caching pool
+ * is destroyed.
+ *
+ * @param ch_pool       The caching pool.
+ */
+PJ_DECL(void) pj_caching_pool_flush_thread_cache(pj_caching_pool *ch_pool);
+
 /**
  * @}   // PJ_CACHING_POOL
  */
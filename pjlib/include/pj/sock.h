@@ -677,6 +677,26 @@ typedef struct pj_sockopt_params
     } options[PJ_MAX_SOCKOPT_PARAMS];
 } pj_sockopt_params;
 
+/**
+ * Describes one datagram to be sent with #pj_sock_sendto_batch().
+ */
+typedef struct pj_sock_sendto_msg
+{
+    /** Buffer containing the datagram. */
+    const void          *buf;
+
+    /** On input, the length of the datagram. Upon return, it will be
+     *  filled with the length of data sent. */
+    pj_ssize_t           len;
+
+    /** The destination address. */
+    const pj_sockaddr_t *addr;
+
+    /** The length of the destination address in bytes. */
+    int                  addr_len;
+
+} pj_sock_sendto_msg;
+
 /*****************************************************************************
  *
  * SOCKET ADDRESS MANIPULATION.
@@ -1493,6 +1513,33 @@ PJ_DECL(pj_status_t) pj_sock_sendto(pj_sock_t sockfd,
                                     const pj_sockaddr_t *to,
                                     int tolen);
 
+/**
+ * Transmit several datagrams, possibly to different destinations, with
+ * as few system calls as possible. On Linux this uses sendmmsg(), on
+ * other platforms the datagrams are sent one by one with sendto().
+ *
+ * The datagrams are sent in order, and sending stops at the first
+ * datagram that cannot be sent (for example because the socket send
+ * buffer is full).
+ *
+ * @param sockfd        Socket descriptor.
+ * @param msg           Array of datagrams to be sent. Upon return, the
+ *                      \a len field of each datagram that was sent is
+ *                      filled with the length of data sent.
+ * @param count         On input, the number of datagrams in \a msg.
+ *                      Upon return, it will be filled with the number of
+ *                      datagrams sent.
+ * @param flags         Flags (such as pj_MSG_DONTROUTE()).
+ *
+ * @return              PJ_SUCCESS if at least one datagram has been sent,
+ *                      otherwise the status code of sending the first
+ *                      datagram.
+ */
+PJ_DECL(pj_status_t) pj_sock_sendto_batch(pj_sock_t sockfd,
+                                          pj_sock_sendto_msg msg[],
+                                          unsigned *count,
+                                          unsigned flags);
+
 #if PJ_HAS_TCP
 /**
  * The shutdown call causes all or part of a full-duplex connection on the
@@ -398,6 +398,20 @@ PJ_DECL(pj_status_t) pj_ssl_cert_get_verify_status_strings(
 PJ_DECL(void) pj_ssl_cert_wipe_keys(pj_ssl_cert_t *cert);
 
 
+/**
+ * Invalidate all SSL contexts in the SSL context cache, e.g: after the
+ * certificate, private key or CA files have been replaced. SSL sockets
+ * created afterwards will load the credentials again, while existing
+ * SSL sockets keep using their current SSL context until they are
+ * destroyed. The client TLS sessions cache is cleared as well.
+ * See also PJ_SSL_SOCK_OSSL_CTX_CACHE_SIZE.
+ *
+ * @return              PJ_SUCCESS when successful, or PJ_ENOTSUP if the
+ *                      SSL backend does not have SSL context cache.
+ */
+PJ_DECL(pj_status_t) pj_ssl_ctx_cache_flush(void);
+
+
 /** 
  * Cipher suites enumeration.
  */
@@ -906,6 +920,14 @@ typedef struct pj_ssl_sock_info
      */
     pj_uint32_t         verify_status;
 
+    /**
+     * Describes whether the TLS session was resumed from a previous one,
+     * i.e: an abbreviated handshake was performed. Note that the peer
+     * certificate is not verified again on resumption, so verify_status
+     * describes the verification result of the original session.
+     */
+    pj_bool_t           session_reused;
+
     /**
      * Last native error returned by the backend.
      */
@@ -1210,6 +1232,58 @@ typedef struct pj_ssl_sock_param
      */
     pj_bool_t enable_renegotiation;
 
+    /**
+     * Specify if TLS session resumption is enabled, so a reconnecting
+     * client only needs an abbreviated handshake.
+     *
+     * When secure socket is acting as client, the session negotiated with
+     * a server is kept in the client session cache, keyed by the server
+     * name and address, and it is offered when connecting to the same
+     * server again. See PJ_SSL_SOCK_OSSL_SESS_CACHE_SIZE.
+     *
+     * When secure socket is acting as server, session tickets are issued
+     * in addition to the server session ID cache.
+     *
+     * This is currently only implemented for OpenSSL backend.
+     *
+     * Default: PJ_FALSE
+     */
+    pj_bool_t session_resumption;
+
+    /**
+     * Lifetime of resumable TLS sessions, in seconds. For server, this is
+     * the lifetime of the session ID cache entries and session tickets.
+     * For client, cached sessions older than this are not offered.
+     *
+     * Default: 0 (use the backend's default, i.e: 300 seconds for server)
+     */
+    unsigned session_timeout;
+
+    /**
+     * Specify if the TLS handshake is performed asynchronously by the SSL
+     * socket handshake worker threads, instead of by the thread polling
+     * the ioqueue. The handshake involves expensive public key operations,
+     * e.g: RSA/ECDSA signing and certificate verification, which would
+     * otherwise delay the delivery of other events of the same ioqueue,
+     * for example when many connections are (re)established at once.
+     *
+     * When enabled, the handshake callbacks, i.e: on_accept_complete2()
+     * and on_connect_complete(), are called from a handshake worker
+     * thread while holding the socket group lock. The number of worker
+     * threads is configured via PJ_SSL_SOCK_HANDSHAKE_THREAD_CNT, they
+     * are shared by all SSL sockets and started on first use.
+     *
+     * This requires the group lock (grp_lock) to be set, otherwise the
+     * handshake is performed synchronously. Renegotiation is always
+     * performed synchronously. The concurrency setting is ignored, the
+     * ioqueue concurrency of the socket is disabled so the network
+     * callbacks are serialized with the handshake callbacks by the group
+     * lock.
+     *
+     * Default: PJ_FALSE
+     */
+    pj_bool_t async_handshake;
+
 } pj_ssl_sock_param;
 
 
@@ -145,9 +145,74 @@ typedef struct pj_timer_entry
 #endif
 
 #endif
+
+    /**
+     * Internal: index of the shard where the entry is scheduled, if the
+     * timer heap is sharded. Application should not touch this field.
+     */
+    unsigned _timer_shard;
 } pj_timer_entry;
 
 
+/**
+ * Timer heap implementation types.
+ */
+typedef enum pj_timer_heap_type
+{
+    /**
+     * Binary heap tree. Scheduling, cancelling, and expiring timers is
+     * O(log N).
+     */
+    PJ_TIMER_HEAP_BINARY,
+
+    /**
+     * Hierarchical timing wheel with one millisecond resolution.
+     * Scheduling and cancelling timers is O(1), and expiring timers is
+     * amortized O(1). This suits large number of timers which are mostly
+     * cancelled before they expire.
+     */
+    PJ_TIMER_HEAP_WHEEL
+
+} pj_timer_heap_type;
+
+
+/**
+ * Timer heap settings, to be specified when creating the timer heap
+ * with #pj_timer_heap_create2().
+ */
+typedef struct pj_timer_heap_cfg
+{
+    /**
+     * The timer heap implementation.
+     *
+     * Default: PJ_TIMER_HEAP_DEFAULT_TYPE
+     */
+    pj_timer_heap_type type;
+
+    /**
+     * Number of shards. If greater than one, the timer heap is split into
+     * this many independent heaps, each with its own lock. Entries
+     * scheduled with a group lock are assigned to a shard based on the
+     * group lock, so timers of the same object stay in the same shard.
+     * Other entries go to the shard bound to the calling thread (see
+     * #pj_timer_heap_set_thread_shard()), or are spread based on the entry
+     * address. Cancelling works from any thread regardless of the shard.
+     *
+     * Default: 1
+     */
+    unsigned shard_cnt;
+
+} pj_timer_heap_cfg;
+
+
+/**
+ * Initialize timer heap settings with default values.
+ *
+ * @param cfg       The settings to be initialized.
+ */
+PJ_DECL(void) pj_timer_heap_cfg_default(pj_timer_heap_cfg *cfg);
+
+
 /**
  * Calculate memory size required to create a timer heap.
  *
@@ -175,6 +240,52 @@ PJ_DECL(pj_status_t) pj_timer_heap_create( pj_pool_t *pool,
                                            pj_size_t count,
                                            pj_timer_heap_t **ht);
 
+/**
+ * Create a timer heap with the specified settings.
+ *
+ * @param pool      The pool where allocations in the timer heap will be
+ *                  allocated. See #pj_timer_heap_create().
+ * @param count     The maximum number of timer entries to be supported
+ *                  initially. See #pj_timer_heap_create().
+ * @param cfg       Timer heap settings. If NULL, default settings will be
+ *                  used.
+ * @param ht        Pointer to receive the created timer heap.
+ *
+ * @return          PJ_SUCCESS, or the appropriate error code.
+ */
+PJ_DECL(pj_status_t) pj_timer_heap_create2( pj_pool_t *pool,
+                                            pj_size_t count,
+                                            const pj_timer_heap_cfg *cfg,
+                                            pj_timer_heap_t **ht);
+
+/**
+ * Get the number of shards of the timer heap.
+ *
+ * @param ht        The timer heap.
+ *
+ * @return          The number of shards, or 1 if the timer heap is not
+ *                  sharded.
+ */
+PJ_DECL(unsigned) pj_timer_heap_get_shard_cnt(pj_timer_heap_t *ht);
+
+/**
+ * Bind the calling thread to a shard of a sharded timer heap. Afterwards,
+ * #pj_timer_heap_poll() called by this thread will only poll that shard,
+ * and entries scheduled by this thread without a group lock will be put
+ * in that shard. Threads which are not bound poll all shards.
+ *
+ * Application must make sure that every shard is polled by some thread,
+ * e.g: by binding worker threads to shards in round robin fashion and
+ * having at least as many worker threads as shards.
+ *
+ * @param ht        The sharded timer heap.
+ * @param shard_idx The shard index, or -1 to unbind the calling thread.
+ *
+ * @return          PJ_SUCCESS, or the appropriate error code.
+ */
+PJ_DECL(pj_status_t) pj_timer_heap_set_thread_shard(pj_timer_heap_t *ht,
+                                                    int shard_idx);
+
 /**
  * Destroy the timer heap.
  *
@@ -187,6 +298,10 @@ PJ_DECL(void) pj_timer_heap_destroy( pj_timer_heap_t *ht );
  * Set lock object to be used by the timer heap. By default, the timer heap
  * uses dummy synchronization.
  *
+ * Shards of a sharded timer heap always use their own recursive mutex.
+ * For such timer heap, the lock set here is not used for synchronization,
+ * and is only destroyed with the timer heap if \a auto_del is set.
+ *
  * @param ht        The timer heap.
  * @param lock      The lock object to be used for synchronization.
  * @param auto_del  If nonzero, the lock object will be destroyed when
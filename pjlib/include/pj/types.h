@@ -261,6 +261,11 @@ typedef PJ_ATOMIC_VALUE_TYPE pj_atomic_value_t;
  */
 typedef struct pj_atomic_queue_t pj_atomic_queue_t;
 
+/**
+ * Opaque data type for multi-producer multi-consumer atomic queue.
+ */
+typedef struct pj_atomic_mpmc_queue_t pj_atomic_mpmc_queue_t;
+
 /* ************************************************************************* */
 
 /** Thread handle. */
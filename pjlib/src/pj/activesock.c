@@ -213,6 +213,14 @@ PJ_DEF(pj_status_t) pj_activesock_create( pj_pool_t *pool,
     asock->async_count = (opt? opt->async_cnt : 1);
     asock->whole_data = (opt? opt->whole_data : 1);
     asock->max_loop = PJ_ACTIVESOCK_MAX_LOOP;
+#if PJ_IOQUEUE_IMP==PJ_IOQUEUE_IMP_EPOLL && PJ_IOQUEUE_MAX_RECV_BATCH > 1
+    /* The ioqueue reads datagrams in batch when several recvfrom() are
+     * pending, so resubmit the read asynchronously instead of reading the
+     * next datagram immediately, to keep datagrams in arrival order.
+     */
+    if (!asock->stream_oriented && asock->async_count > 1)
+        asock->max_loop = 1;
+#endif
     asock->user_data = user_data;
     pj_memcpy(&asock->cb, cb, sizeof(*cb));
 
@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2025 Teluu Inc. (http://www.teluu.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <pj/assert.h>
+#include <pj/atomic_mpmc_queue.h>
+#include <pj/errno.h>
+#include <pj/log.h>
+#include <pj/pool.h>
+#include <pj/string.h>
+#include <atomic>
+#include <new>
+
+#if 0
+#   define TRACE_(arg) PJ_LOG(4,arg)
+#else
+#   define TRACE_(expr)
+#endif
+
+/* Assumed cache line size, used to keep the producer and consumer
+ * positions from sharing a cache line.
+ */
+#define CACHE_LINE_SIZE     64
+
+/*
+ * Bounded MPMC queue based on per-slot sequence numbers (D. Vyukov).
+ *
+ * Slot i starts with sequence i. A producer which claims position pos may
+ * write the slot when its sequence equals pos, and then publishes it by
+ * setting the sequence to pos+1. A consumer which claims position pos may
+ * read the slot when its sequence equals pos+1, and then releases it for
+ * the next round by setting the sequence to pos+capacity.
+ */
+class AtomicMpmcQueue {
+public:
+    /**
+     * Constructor. The capacity must be power of two.
+     */
+    AtomicMpmcQueue(unsigned capacity, unsigned itemSize,
+                    const char* name = ""):
+                    mask_(capacity - 1),
+                    itemSize_(itemSize),
+                    seq_(NULL),
+                    buffer_(NULL),
+                    name_(name),
+                    enqueuePos_(0),
+                    dequeuePos_(0)
+    {
+        seq_ = new std::atomic<pj_size_t>[capacity];
+        buffer_ = new char[(pj_size_t)capacity * itemSize_];
+        for (unsigned i = 0; i < capacity; ++i)
+            seq_[i].store(i, std::memory_order_relaxed);
+
+        /* Surpress warning when debugging log is disabled */
+        PJ_UNUSED_ARG(name_);
+        PJ_UNUSED_ARG(pad0_);
+        PJ_UNUSED_ARG(pad1_);
+        PJ_UNUSED_ARG(pad2_);
+
+        TRACE_((name_, "Created AtomicMpmcQueue: capacity=%d itemSize=%d",
+                capacity, itemSize_));
+    }
+
+    /**
+     * Destructor
+     */
+    ~AtomicMpmcQueue()
+    {
+        delete [] buffer_;
+        delete [] seq_;
+    }
+
+    /**
+     * Put an item to the back of the queue, return false if full.
+     */
+    bool put(const void* item)
+    {
+        pj_size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+
+        for (;;) {
+            std::atomic<pj_size_t> &seq = seq_[pos & mask_];
+            pj_size_t s = seq.load(std::memory_order_acquire);
+            pj_ssize_t diff = (pj_ssize_t)s - (pj_ssize_t)pos;
+
+            if (diff == 0) {
+                /* Slot is free, try to claim the position */
+                if (enqueuePos_.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed))
+                {
+                    pj_memcpy(&buffer_[(pos & mask_) * itemSize_], item,
+                              itemSize_);
+                    seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+                /* pos has been updated by the failed CAS */
+            } else if (diff < 0) {
+                /* Slot still holds an item from the previous round */
+                return false;
+            } else {
+                /* Another producer has claimed the position */
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Get an item from the head of the queue, return false if empty.
+     */
+    bool get(void* item)
+    {
+        pj_size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+
+        for (;;) {
+            std::atomic<pj_size_t> &seq = seq_[pos & mask_];
+            pj_size_t s = seq.load(std::memory_order_acquire);
+            pj_ssize_t diff = (pj_ssize_t)s - (pj_ssize_t)(pos + 1);
+
+            if (diff == 0) {
+                /* Slot is published, try to claim the position */
+                if (dequeuePos_.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed))
+                {
+                    pj_memcpy(item, &buffer_[(pos & mask_) * itemSize_],
+                              itemSize_);
+                    seq.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                /* Slot hasn't been published, queue is empty */
+                return false;
+            } else {
+                /* Another consumer has claimed the position */
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Approximate number of items.
+     */
+    unsigned size() const
+    {
+        pj_size_t tail = enqueuePos_.load(std::memory_order_relaxed);
+        pj_size_t head = dequeuePos_.load(std::memory_order_relaxed);
+        pj_ssize_t n = (pj_ssize_t)(tail - head);
+
+        if (n < 0)
+            return 0;
+        if (n > (pj_ssize_t)(mask_ + 1))
+            return (unsigned)(mask_ + 1);
+        return (unsigned)n;
+    }
+
+private:
+    /* Read-only after construction */
+    pj_size_t                    mask_;
+    unsigned                     itemSize_;
+    std::atomic<pj_size_t>      *seq_;
+    char                        *buffer_;
+    const char                  *name_;
+
+    /* Producer and consumer positions, each in its own cache line */
+    char                         pad0_[CACHE_LINE_SIZE];
+    std::atomic<pj_size_t>       enqueuePos_;
+    char                         pad1_[CACHE_LINE_SIZE -
+                                       sizeof(std::atomic<pj_size_t>)];
+    std::atomic<pj_size_t>       dequeuePos_;
+    char                         pad2_[CACHE_LINE_SIZE -
+                                       sizeof(std::atomic<pj_size_t>)];
+
+    AtomicMpmcQueue(const AtomicMpmcQueue&);
+    AtomicMpmcQueue& operator=(const AtomicMpmcQueue&);
+};
+
+struct pj_atomic_mpmc_queue_t
+{
+    AtomicMpmcQueue    *aQ;
+};
+
+PJ_DEF(pj_status_t) pj_atomic_mpmc_queue_create(
+                                        pj_pool_t *pool,
+                                        unsigned max_item_cnt,
+                                        unsigned item_size,
+                                        const char *name,
+                                        pj_atomic_mpmc_queue_t **queue)
+{
+    pj_atomic_mpmc_queue_t *aqueue;
+    unsigned capacity;
+
+    PJ_ASSERT_RETURN(pool && max_item_cnt && item_size && queue, PJ_EINVAL);
+    PJ_ASSERT_RETURN(max_item_cnt <= 0x80000000U, PJ_ETOOBIG);
+
+    /* Round up to power of two so position to slot is a simple mask */
+    capacity = 2;
+    while (capacity < max_item_cnt)
+        capacity <<= 1;
+
+    aqueue = PJ_POOL_ZALLOC_T(pool, pj_atomic_mpmc_queue_t);
+    aqueue->aQ = new (std::nothrow) AtomicMpmcQueue(capacity, item_size,
+                                                    name);
+    if (!aqueue->aQ)
+        return PJ_ENOMEM;
+
+    *queue = aqueue;
+    return PJ_SUCCESS;
+}
+
+PJ_DEF(pj_status_t) pj_atomic_mpmc_queue_destroy(
+                                        pj_atomic_mpmc_queue_t *queue)
+{
+    PJ_ASSERT_RETURN(queue && queue->aQ, PJ_EINVAL);
+    delete queue->aQ;
+    queue->aQ = NULL;
+    return PJ_SUCCESS;
+}
+
+PJ_DEF(pj_status_t) pj_atomic_mpmc_queue_put(pj_atomic_mpmc_queue_t *queue,
+                                             const void *item)
+{
+    PJ_ASSERT_RETURN(queue && queue->aQ && item, PJ_EINVAL);
+    return queue->aQ->put(item)? PJ_SUCCESS : PJ_ETOOMANY;
+}
+
+PJ_DEF(pj_status_t) pj_atomic_mpmc_queue_get(pj_atomic_mpmc_queue_t *queue,
+                                             void *item)
+{
+    PJ_ASSERT_RETURN(queue && queue->aQ && item, PJ_EINVAL);
+    return queue->aQ->get(item)? PJ_SUCCESS : PJ_ENOTFOUND;
+}
+
+PJ_DEF(unsigned) pj_atomic_mpmc_queue_size(pj_atomic_mpmc_queue_t *queue)
+{
+    PJ_ASSERT_RETURN(queue && queue->aQ, 0);
+    return queue->aQ->size();
+}
@@ -29,6 +29,14 @@
  */
 #define PJ_HASH_MULTIPLIER      33
 
+/* Minimum number of slots of open addressing table. */
+#define OA_MIN_CAPACITY         16
+
+/* Number of slots of the old table to be moved to the new table on
+ * each insertion while the open addressing table is being resized.
+ */
+#define OA_MIGRATE_CNT          4
+
 
 struct pj_hash_entry
 {
@@ -39,12 +47,47 @@ struct pj_hash_entry
     void *value;
 };
 
+/* Slot of open addressing table. Empty slot has NULL key, and deleted
+ * slot has OA_DELETED key.
+ */
+typedef struct oa_slot
+{
+    void *key;
+    void *value;
+    pj_uint32_t hash;
+    pj_uint32_t keylen;
+} oa_slot;
+
+/* Array of slots of open addressing table. */
+typedef struct oa_table
+{
+    oa_slot            *slots;
+    unsigned            cap;        /* Number of slots, power of two.   */
+    unsigned            bits;       /* log2(cap)                        */
+    unsigned            used;       /* Number of live and deleted slots */
+} oa_table;
+
+static char oa_deleted;
+#define OA_DELETED      ((void*)&oa_deleted)
+
 
 struct pj_hash_table_t
 {
     pj_hash_entry     **table;
     unsigned            count, rows;
     pj_hash_iterator_t  iterator;
+
+    /* Open addressing table. While being resized, entries are moved from
+     * "old" to "cur" incrementally, and "migrate_idx" is the next slot of
+     * "old" to be moved. The "spare" table is the previous "old" table,
+     * kept to be reused when the table is rehashed to the same size.
+     */
+    pj_hash_type        type;
+    pj_pool_t          *pool;
+    oa_table            cur;
+    oa_table            old;
+    oa_table            spare;
+    unsigned            migrate_idx;
 };
 
 
@@ -87,16 +130,62 @@ PJ_DEF(pj_uint32_t) pj_hash_calc_tolower( pj_uint32_t hval,
 }
 
 
+/* Allocate slots for open addressing table. */
+static pj_bool_t oa_alloc(pj_hash_table_t *ht, oa_table *tbl, unsigned cap)
+{
+    if (ht->spare.slots && ht->spare.cap == cap) {
+        *tbl = ht->spare;
+        pj_bzero(tbl->slots, cap * sizeof(oa_slot));
+        pj_bzero(&ht->spare, sizeof(ht->spare));
+    } else {
+        tbl->slots = (oa_slot*) pj_pool_calloc(ht->pool, cap, sizeof(oa_slot));
+        if (!tbl->slots)
+            return PJ_FALSE;
+        tbl->cap = cap;
+    }
+
+    for (tbl->bits = 0; (1U << tbl->bits) < cap; ++tbl->bits)
+        ;
+    tbl->used = 0;
+    return PJ_TRUE;
+}
+
 PJ_DEF(pj_hash_table_t*) pj_hash_create(pj_pool_t *pool, unsigned size)
+{
+    return pj_hash_create2(pool, size, PJ_HASH_TYPE_CHAINED);
+}
+
+PJ_DEF(pj_hash_table_t*) pj_hash_create2(pj_pool_t *pool, unsigned size,
+                                         pj_hash_type type)
 {
     pj_hash_table_t *h;
     unsigned table_size;
     
     /* Check that PJ_HASH_ENTRY_BUF_SIZE is correct. */
     PJ_ASSERT_RETURN(sizeof(pj_hash_entry)<=PJ_HASH_ENTRY_BUF_SIZE, NULL);
+    PJ_ASSERT_RETURN(pool && (type == PJ_HASH_TYPE_CHAINED ||
+                              type == PJ_HASH_TYPE_OPEN_ADDRESSING), NULL);
 
-    h = PJ_POOL_ALLOC_T(pool, pj_hash_table_t);
+    h = PJ_POOL_ZALLOC_T(pool, pj_hash_table_t);
     h->count = 0;
+    h->type = type;
+    h->pool = pool;
+
+    if (type == PJ_HASH_TYPE_OPEN_ADDRESSING) {
+        /* Initial capacity keeps the load below half when the table
+         * holds the specified number of entries.
+         */
+        table_size = OA_MIN_CAPACITY;
+        while (table_size < size * 2 && table_size < 0x40000000)
+            table_size <<= 1;
+
+        if (!oa_alloc(h, &h->cur, table_size))
+            return NULL;
+
+        PJ_LOG(6, ("hashtbl", "open addressing hash table %p created from "
+                   "pool %s", h, pj_pool_getobjname(pool)));
+        return h;
+    }
 
     PJ_LOG( 6, ("hashtbl", "hash table %p created from pool %s", h, pj_pool_getobjname(pool)));
 
@@ -116,13 +205,14 @@ PJ_DEF(pj_hash_table_t*) pj_hash_create(pj_pool_t *pool, unsigned size)
     return h;
 }
 
-static pj_hash_entry **find_entry( pj_pool_t *pool, pj_hash_table_t *ht, 
-                                   const void *key, unsigned keylen,
-                                   void *val, pj_uint32_t *hval,
-                                   void *entry_buf, pj_bool_t lower)
+/* Calculate the hash value of the key, or use the specified hash value if
+ * it's not zero. Also get the key length if it's PJ_HASH_KEY_STRING.
+ */
+static pj_uint32_t calc_hash(const void *key, unsigned *p_keylen,
+                             pj_uint32_t *hval, pj_bool_t lower)
 {
     pj_uint32_t hash;
-    pj_hash_entry **p_entry, *entry;
+    unsigned keylen = *p_keylen;
 
     if (hval && *hval != 0) {
         hash = *hval;
@@ -159,6 +249,20 @@ static pj_hash_entry **find_entry( pj_pool_t *pool, pj_hash_table_t *ht,
             *hval = hash;
     }
 
+    *p_keylen = keylen;
+    return hash;
+}
+
+static pj_hash_entry **find_entry( pj_pool_t *pool, pj_hash_table_t *ht, 
+                                   const void *key, unsigned keylen,
+                                   void *val, pj_uint32_t *hval,
+                                   void *entry_buf, pj_bool_t lower)
+{
+    pj_uint32_t hash;
+    pj_hash_entry **p_entry, *entry;
+
+    hash = calc_hash(key, &keylen, hval, lower);
+
     /* scan the linked list */
     for (p_entry = &ht->table[hash & ht->rows], entry=*p_entry; 
          entry; 
@@ -208,11 +312,191 @@ static pj_hash_entry **find_entry( pj_pool_t *pool, pj_hash_table_t *ht,
     return p_entry;
 }
 
+/* Get the first slot to probe for the hash value. The hash value is
+ * scrambled (Fibonacci hashing) as the low bits of the hash function
+ * are not well distributed.
+ */
+#define OA_INDEX(tbl, hash) \
+            ((pj_uint32_t)((hash) * 2654435769U) >> (32 - (tbl)->bits))
+
+/* Find live slot with the specified key. */
+static oa_slot *oa_find(const oa_table *tbl, const void *key,
+                        unsigned keylen, pj_uint32_t hash, pj_bool_t lower)
+{
+    unsigned mask = tbl->cap - 1;
+    unsigned i;
+
+    if (!tbl->slots)
+        return NULL;
+
+    /* There is always an empty slot, so this terminates */
+    for (i = OA_INDEX(tbl, hash); ; i = (i + 1) & mask) {
+        oa_slot *slot = &tbl->slots[i];
+
+        if (slot->key == NULL)
+            return NULL;
+
+        if (slot->hash == hash && slot->keylen == keylen &&
+            slot->key != OA_DELETED &&
+            ((lower && pj_ansi_strnicmp((const char*)slot->key,
+                                        (const char*)key, keylen)==0) ||
+             (!lower && pj_memcmp(slot->key, key, keylen)==0)))
+        {
+            return slot;
+        }
+    }
+}
+
+/* Get empty or deleted slot to insert new entry with the hash value. */
+static oa_slot *oa_insert_slot(oa_table *tbl, pj_uint32_t hash)
+{
+    unsigned mask = tbl->cap - 1;
+    unsigned i;
+
+    for (i = OA_INDEX(tbl, hash); ; i = (i + 1) & mask) {
+        oa_slot *slot = &tbl->slots[i];
+
+        if (slot->key == NULL) {
+            ++tbl->used;
+            return slot;
+        }
+        if (slot->key == OA_DELETED)
+            return slot;
+    }
+}
+
+/* Move up to cnt slots from the old table to the current table. */
+static void oa_migrate(pj_hash_table_t *ht, unsigned cnt)
+{
+    while (cnt-- && ht->migrate_idx < ht->old.cap) {
+        oa_slot *slot = &ht->old.slots[ht->migrate_idx++];
+
+        if (slot->key && slot->key != OA_DELETED) {
+            *oa_insert_slot(&ht->cur, slot->hash) = *slot;
+            slot->key = OA_DELETED;
+        }
+    }
+
+    if (ht->migrate_idx == ht->old.cap) {
+        ht->spare = ht->old;
+        pj_bzero(&ht->old, sizeof(ht->old));
+        ht->migrate_idx = 0;
+    }
+}
+
+/* Start moving the entries to a new table, which is twice as large if
+ * the table is getting full, or the same size if most used slots are
+ * deleted ones.
+ */
+static pj_bool_t oa_start_resize(pj_hash_table_t *ht)
+{
+    oa_table tbl;
+    unsigned cap;
+
+    /* Finish previous resizing */
+    if (ht->old.slots)
+        oa_migrate(ht, ht->old.cap);
+
+    cap = ht->cur.cap;
+    while (ht->count * 2 >= cap && cap < 0x80000000)
+        cap <<= 1;
+
+    if (!oa_alloc(ht, &tbl, cap))
+        return PJ_FALSE;
+
+    PJ_LOG(6, ("hashtbl", "%p: resizing from %u to %u slots, count=%u",
+               ht, ht->cur.cap, cap, ht->count));
+
+    ht->old = ht->cur;
+    ht->cur = tbl;
+    ht->migrate_idx = 0;
+    return PJ_TRUE;
+}
+
+static oa_slot *oa_get(pj_hash_table_t *ht, const void *key, unsigned keylen,
+                       pj_uint32_t *hval, pj_bool_t lower)
+{
+    pj_uint32_t hash;
+    oa_slot *slot;
+
+    hash = calc_hash(key, &keylen, hval, lower);
+    slot = oa_find(&ht->cur, key, keylen, hash, lower);
+    if (!slot && ht->old.slots)
+        slot = oa_find(&ht->old, key, keylen, hash, lower);
+
+    return slot;
+}
+
+static void oa_set( pj_pool_t *pool, pj_hash_table_t *ht,
+                    const void *key, unsigned keylen, pj_uint32_t hval,
+                    void *value, pj_bool_t np, pj_bool_t lower )
+{
+    oa_slot *slot;
+
+    slot = oa_get(ht, key, keylen, &hval, lower);
+    if (keylen == PJ_HASH_KEY_STRING)
+        keylen = (unsigned)pj_ansi_strlen((const char*)key);
+
+    if (slot) {
+        if (value == NULL) {
+            /* delete entry. The slot is marked as deleted rather than
+             * emptied so other entries are not moved, which keeps
+             * iterators valid.
+             */
+            PJ_LOG(6, ("hashtbl", "%p: slot %p deleted", ht, slot));
+            slot->key = OA_DELETED;
+            --ht->count;
+        } else {
+            /* overwrite */
+            slot->value = value;
+            PJ_LOG(6, ("hashtbl", "%p: slot %p value set to %p", ht,
+                       slot, value));
+        }
+        return;
+    }
+
+    if (value == NULL)
+        return;
+
+    /* Pool must be specified! */
+    PJ_ASSERT_ON_FAIL(pool != NULL || np, return);
+
+    if (ht->old.slots)
+        oa_migrate(ht, OA_MIGRATE_CNT);
+
+    /* Keep the load factor (including deleted slots) below 3/4 */
+    if ((ht->cur.used + 1) * 4 > ht->cur.cap * 3) {
+        if (!oa_start_resize(ht) && ht->cur.used + 1 >= ht->cur.cap) {
+            pj_assert(!"Hash table is full");
+            return;
+        }
+    }
+
+    slot = oa_insert_slot(&ht->cur, hval);
+    slot->hash = hval;
+    if (pool) {
+        slot->key = pj_pool_alloc(pool, keylen);
+        pj_memcpy(slot->key, key, keylen);
+    } else {
+        slot->key = (void*)key;
+    }
+    slot->keylen = keylen;
+    slot->value = value;
+
+    ++ht->count;
+}
+
 PJ_DEF(void *) pj_hash_get( pj_hash_table_t *ht,
                             const void *key, unsigned keylen,
                             pj_uint32_t *hval)
 {
     pj_hash_entry *entry;
+
+    if (ht->type == PJ_HASH_TYPE_OPEN_ADDRESSING) {
+        oa_slot *slot = oa_get(ht, key, keylen, hval, PJ_FALSE);
+        return slot ? slot->value : NULL;
+    }
+
     entry = *find_entry( NULL, ht, key, keylen, NULL, hval, NULL, PJ_FALSE);
     return entry ? entry->value : NULL;
 }
@@ -222,6 +506,12 @@ PJ_DEF(void *) pj_hash_get_lower( pj_hash_table_t *ht,
                                   pj_uint32_t *hval)
 {
     pj_hash_entry *entry;
+
+    if (ht->type == PJ_HASH_TYPE_OPEN_ADDRESSING) {
+        oa_slot *slot = oa_get(ht, key, keylen, hval, PJ_TRUE);
+        return slot ? slot->value : NULL;
+    }
+
     entry = *find_entry( NULL, ht, key, keylen, NULL, hval, NULL, PJ_TRUE);
     return entry ? entry->value : NULL;
 }
@@ -232,6 +522,11 @@ static void hash_set( pj_pool_t *pool, pj_hash_table_t *ht,
 {
     pj_hash_entry **p_entry;
 
+    if (ht->type == PJ_HASH_TYPE_OPEN_ADDRESSING) {
+        oa_set(pool, ht, key, keylen, hval, value, entry_buf != NULL, lower);
+        return;
+    }
+
     p_entry = find_entry( pool, ht, key, keylen, value, &hval, entry_buf,
                           lower);
     if (*p_entry) {
@@ -286,12 +581,37 @@ PJ_DEF(unsigned) pj_hash_count( pj_hash_table_t *ht )
     return ht->count;
 }
 
+/* Find the next live slot starting from the index. The index goes over
+ * the slots of the old table first, then the current table.
+ */
+static pj_hash_iterator_t *oa_iterate(pj_hash_table_t *ht,
+                                      pj_hash_iterator_t *it,
+                                      pj_uint32_t index)
+{
+    for (; index < ht->old.cap + ht->cur.cap; ++index) {
+        oa_slot *slot = (index < ht->old.cap) ? &ht->old.slots[index] :
+                                &ht->cur.slots[index - ht->old.cap];
+
+        if (slot->key && slot->key != OA_DELETED) {
+            it->index = index;
+            it->entry = (pj_hash_entry*)slot;
+            return it;
+        }
+    }
+
+    it->entry = NULL;
+    return NULL;
+}
+
 PJ_DEF(pj_hash_iterator_t*) pj_hash_first( pj_hash_table_t *ht,
                                            pj_hash_iterator_t *it )
 {
     it->index = 0;
     it->entry = NULL;
 
+    if (ht->type == PJ_HASH_TYPE_OPEN_ADDRESSING)
+        return oa_iterate(ht, it, 0);
+
     for (; it->index <= ht->rows; ++it->index) {
         it->entry = ht->table[it->index];
         if (it->entry) {
@@ -305,6 +625,9 @@ PJ_DEF(pj_hash_iterator_t*) pj_hash_first( pj_hash_table_t *ht,
 PJ_DEF(pj_hash_iterator_t*) pj_hash_next( pj_hash_table_t *ht, 
                                           pj_hash_iterator_t *it )
 {
+    if (ht->type == PJ_HASH_TYPE_OPEN_ADDRESSING)
+        return oa_iterate(ht, it, it->index + 1);
+
     it->entry = it->entry->next;
     if (it->entry) {
         return it;
@@ -323,7 +646,10 @@ PJ_DEF(pj_hash_iterator_t*) pj_hash_next( pj_hash_table_t *ht,
 PJ_DEF(void*) pj_hash_this( pj_hash_table_t *ht, pj_hash_iterator_t *it )
 {
     PJ_CHECK_STACK();
-    PJ_UNUSED_ARG(ht);
+
+    if (ht->type == PJ_HASH_TYPE_OPEN_ADDRESSING)
+        return ((oa_slot*)it->entry)->value;
+
     return it->entry->value;
 }
 
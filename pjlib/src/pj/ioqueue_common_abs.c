@@ -434,6 +434,123 @@ pj_bool_t ioqueue_dispatch_write_event( pj_ioqueue_t *ioqueue,
     return PJ_TRUE;
 }
 
+#if defined(IOQUEUE_HAS_RECV_BATCH) && IOQUEUE_HAS_RECV_BATCH!=0
+/*
+ * Complete several pending recvfrom() operations of a datagram key with a
+ * single recvmmsg() call. Must be called with the key locked. Returns
+ * PJ_FALSE, with the key still locked, if there are not enough pending
+ * recvfrom() operations to make a batch.
+ */
+static pj_bool_t ioqueue_dispatch_recvfrom_batch(pj_ioqueue_t *ioqueue,
+                                                 pj_ioqueue_key_t *h)
+{
+    struct read_operation *ops[PJ_IOQUEUE_MAX_RECV_BATCH];
+    struct mmsghdr msgs[PJ_IOQUEUE_MAX_RECV_BATCH];
+    struct iovec iov[PJ_IOQUEUE_MAX_RECV_BATCH];
+    pj_ssize_t bytes_read[PJ_IOQUEUE_MAX_RECV_BATCH];
+    struct read_operation *read_op;
+    unsigned i, cnt = 0;
+    int flags, rcvd;
+    pj_status_t rc = PJ_SUCCESS;
+    pj_bool_t has_lock;
+
+    /* Collect consecutive recvfrom() operations with the same flags */
+    flags = h->read_list.next->flags;
+    for (read_op = h->read_list.next;
+         read_op != &h->read_list && cnt < PJ_IOQUEUE_MAX_RECV_BATCH;
+         read_op = read_op->next)
+    {
+        struct msghdr *hdr = &msgs[cnt].msg_hdr;
+
+        if (read_op->op != PJ_IOQUEUE_OP_RECV_FROM ||
+            (int)read_op->flags != flags)
+        {
+            break;
+        }
+
+        iov[cnt].iov_base = read_op->buf;
+        iov[cnt].iov_len = read_op->size;
+        pj_bzero(&msgs[cnt], sizeof(msgs[cnt]));
+        if (read_op->rmt_addr && read_op->rmt_addrlen) {
+            hdr->msg_name = read_op->rmt_addr;
+            hdr->msg_namelen = *read_op->rmt_addrlen;
+        }
+        hdr->msg_iov = &iov[cnt];
+        hdr->msg_iovlen = 1;
+        ops[cnt++] = read_op;
+    }
+
+    if (cnt < 2)
+        return PJ_FALSE;
+
+    rcvd = recvmmsg(h->fd, msgs, cnt, flags, NULL);
+    if (rcvd < 1) {
+        /* Report the error (e.g. EWOULDBLOCK when another thread has
+         * drained the socket) to the first operation only, just like
+         * when the datagrams are read one by one.
+         */
+        rc = pj_get_netos_error();
+        if (rc == PJ_SUCCESS)
+            rc = PJ_STATUS_FROM_OS(PJ_BLOCKING_ERROR_VAL);
+        rcvd = 1;
+    }
+
+    /* Remove the completed operations from the list, and clear the
+     * operation so that the callback may submit them again.
+     */
+    for (i=0; i<(unsigned)rcvd; ++i) {
+        read_op = ops[i];
+        pj_list_erase(read_op);
+        read_op->op = PJ_IOQUEUE_OP_NONE;
+
+        if (rc != PJ_SUCCESS) {
+            bytes_read[i] = -rc;
+        } else {
+            bytes_read[i] = msgs[i].msg_len;
+            if (read_op->rmt_addr && read_op->rmt_addrlen) {
+                *read_op->rmt_addrlen = msgs[i].msg_hdr.msg_namelen;
+                PJ_SOCKADDR_RESET_LEN(read_op->rmt_addr);
+            }
+        }
+    }
+
+    /* Clear fdset if there is no pending read. */
+    if (pj_list_empty(&h->read_list))
+        ioqueue_remove_from_set(ioqueue, h, READABLE_EVENT);
+
+    /* Unlock; from this point we don't need to hold key's mutex
+     * (unless concurrency is disabled, which in this case we should
+     * hold the mutex while calling the callback) */
+    if (h->allow_concurrent) {
+        /* concurrency may be changed while we're in the callback, so
+         * save it to a flag.
+         */
+        has_lock = PJ_FALSE;
+        pj_ioqueue_unlock_key(h);
+        PJ_RACE_ME(5);
+    } else {
+        has_lock = PJ_TRUE;
+    }
+
+    /* Call callback for each datagram, stop if the key has been
+     * unregistered by one of the callbacks.
+     */
+    for (i=0; i<(unsigned)rcvd; ++i) {
+        if (!h->cb.on_read_complete || IS_CLOSING(h))
+            break;
+
+        (*h->cb.on_read_complete)(h, (pj_ioqueue_op_key_t*)ops[i],
+                                  bytes_read[i]);
+    }
+
+    if (has_lock) {
+        pj_ioqueue_unlock_key(h);
+    }
+
+    return PJ_TRUE;
+}
+#endif  /* IOQUEUE_HAS_RECV_BATCH */
+
 pj_bool_t ioqueue_dispatch_read_event( pj_ioqueue_t *ioqueue,
                                        pj_ioqueue_key_t *h )
 {
@@ -505,6 +622,17 @@ pj_bool_t ioqueue_dispatch_read_event( pj_ioqueue_t *ioqueue,
         pj_ssize_t bytes_read;
         pj_bool_t has_lock;
 
+#if defined(IOQUEUE_HAS_RECV_BATCH) && IOQUEUE_HAS_RECV_BATCH!=0
+        /* Drain several datagrams at once if more than one recvfrom()
+         * is pending.
+         */
+        if (h->fd_type == pj_SOCK_DGRAM() &&
+            ioqueue_dispatch_recvfrom_batch(ioqueue, h))
+        {
+            return PJ_TRUE;
+        }
+#endif
+
         /* Get one pending read operation from the list. */
         read_op = h->read_list.next;
         pj_list_erase(read_op);
@@ -965,6 +1093,39 @@ PJ_DEF(pj_status_t) pj_ioqueue_send( pj_ioqueue_key_t *key,
 }
 
 
+/*
+ * pj_ioqueue_sendto_batch()
+ *
+ * Send several datagrams immediately.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_sendto_batch( pj_ioqueue_key_t *key,
+                                             pj_sock_sendto_msg msg[],
+                                             unsigned *count,
+                                             pj_uint32_t flags)
+{
+    PJ_ASSERT_RETURN(key && msg && count, PJ_EINVAL);
+    PJ_CHECK_STACK();
+
+    /* Check if key is closing. */
+    if (IS_CLOSING(key)) {
+        *count = 0;
+        return PJ_ECANCELLED;
+    }
+
+    /* Don't overtake pending writes. See the note in pj_ioqueue_sendto()
+     * about checking the list without holding the key's lock.
+     */
+    if (!pj_list_empty(&key->write_list)) {
+        *count = 0;
+        return PJ_EBUSY;
+    }
+
+    flags &= ~(PJ_IOQUEUE_ALWAYS_ASYNC);
+
+    return pj_sock_sendto_batch(key->fd, msg, count, flags);
+}
+
+
 /*
  * pj_ioqueue_sendto()
  *
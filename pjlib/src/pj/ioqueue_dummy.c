@@ -169,6 +169,35 @@ PJ_DEF(pj_status_t) pj_ioqueue_sendto( pj_ioqueue_t *ioque,
     return -1;
 }
 
+PJ_DEF(pj_status_t) pj_ioqueue_sendto_batch( pj_ioqueue_key_t *key,
+                                             pj_sock_sendto_msg msg[],
+                                             unsigned *count,
+                                             pj_uint32_t flags)
+{
+    unsigned i;
+
+    PJ_ASSERT_RETURN(key && msg && count, PJ_EINVAL);
+
+    flags &= ~(PJ_IOQUEUE_ALWAYS_ASYNC);
+
+    for (i=0; i<*count; ++i) {
+        pj_status_t status;
+
+        status = pj_sock_sendto(key->fd, msg[i].buf, &msg[i].len, flags,
+                                msg[i].addr, msg[i].addr_len);
+        if (status != PJ_SUCCESS) {
+            if (i == 0) {
+                *count = 0;
+                return status;
+            }
+            break;
+        }
+    }
+
+    *count = i;
+    return PJ_SUCCESS;
+}
+
 #if PJ_HAS_TCP
 /*
  * Initiate overlapped accept() operation.
@@ -22,6 +22,9 @@
  * This is the implementation of IOQueue framework using /dev/epoll
  * API in _both_ Linux user-mode and kernel-mode.
  */
+#ifndef _GNU_SOURCE
+#   define _GNU_SOURCE      /* for recvmmsg() */
+#endif
 
 #include <pj/ioqueue.h>
 #include <pj/os.h>
@@ -46,6 +49,13 @@
 #include <errno.h>
 #include <unistd.h>
 
+/* Read several pending datagrams with a single recvmmsg() call. This
+ * relies on the key staying valid while the callbacks are called.
+ */
+#if PJ_IOQUEUE_MAX_RECV_BATCH > 1 && PJ_IOQUEUE_HAS_SAFE_UNREG
+#   define IOQUEUE_HAS_RECV_BATCH   1
+#endif
+
 #define epoll_data              data.ptr
 #define epoll_data_type         void*
 #define ioctl_val_type          unsigned long
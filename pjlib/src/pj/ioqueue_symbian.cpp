@@ -846,6 +846,38 @@ PJ_DEF(pj_status_t) pj_ioqueue_sendto( pj_ioqueue_key_t *key,
     return PJ_SUCCESS;
 }
 
+/*
+ * Send several datagrams. Sending is synchronous on Symbian, so just send
+ * them one at a time.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_sendto_batch( pj_ioqueue_key_t *key,
+                                             pj_sock_sendto_msg msg[],
+                                             unsigned *count,
+                                             pj_uint32_t flags)
+{
+    unsigned i;
+
+    PJ_ASSERT_RETURN(key && msg && count, PJ_EINVAL);
+
+    for (i=0; i<*count; ++i) {
+        pj_status_t status;
+
+        status = pj_ioqueue_sendto(key, NULL, msg[i].buf, &msg[i].len,
+                                   flags & ~PJ_IOQUEUE_ALWAYS_ASYNC,
+                                   msg[i].addr, msg[i].addr_len);
+        if (status != PJ_SUCCESS) {
+            if (i == 0) {
+                *count = 0;
+                return status;
+            }
+            break;
+        }
+    }
+
+    *count = i;
+    return PJ_SUCCESS;
+}
+
 PJ_DEF(pj_status_t) pj_ioqueue_set_concurrency(pj_ioqueue_key_t *key,
                                                                                            pj_bool_t allow)
 {
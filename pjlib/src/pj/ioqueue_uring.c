@@ -0,0 +1,2023 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+/*
+ * ioqueue_uring.c
+ *
+ * This is the implementation of IOQueue framework using Linux io_uring.
+ *
+ * Unlike the select/epoll backends, which wait for readiness and then
+ * perform the socket call themselves (see ioqueue_common_abs.c), this
+ * backend submits recv/recvfrom/send/sendto/accept to the kernel as real
+ * asynchronous operations and only reaps their completions (i.e. proactor
+ * pattern, similar to the IOCP backend). Pending connect() is completed
+ * with an io_uring poll for writability. Submissions made
+ * from inside completion callbacks are batched and flushed together with
+ * the next wait, so in steady state a single io_uring_enter() syscall
+ * both re-arms the pending operations and collects new completions.
+ *
+ * The ring is driven with raw syscalls, so liburing is not required.
+ * Linux 5.11 or later (IORING_FEAT_EXT_ARG) is needed.
+ */
+
+#include <pj/ioqueue.h>
+#include <pj/os.h>
+#include <pj/lock.h>
+#include <pj/log.h>
+#include <pj/list.h>
+#include <pj/pool.h>
+#include <pj/string.h>
+#include <pj/assert.h>
+#include <pj/errno.h>
+#include <pj/sock.h>
+#include <pj/compat/socket.h>
+
+
+/* Only build when the backend is using io_uring. */
+#if PJ_IOQUEUE_IMP == PJ_IOQUEUE_IMP_URING
+
+#if !PJ_IOQUEUE_HAS_SAFE_UNREG
+#   error "io_uring ioqueue requires PJ_IOQUEUE_HAS_SAFE_UNREG"
+#endif
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <errno.h>
+#include <unistd.h>
+
+#define os_ioctl                ioctl
+#define os_close                close
+
+#define THIS_FILE   "ioq_uring"
+
+//#define TRACE_(expr) PJ_LOG(3,expr)
+#define TRACE_(expr)
+
+/* Memory barriers for the rings shared with the kernel. */
+#define load_acquire(p)         __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define store_release(p, v)     __atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+
+/*
+ * An asynchronous operation that has been started on a key. The record is
+ * owned by the ioqueue (not by the application's op_key), because the
+ * kernel may still hold a reference to it after the application has
+ * cancelled the operation or unregistered the key.
+ */
+struct uring_req
+{
+    PJ_DECL_LIST_MEMBER(struct uring_req);
+    pj_ioqueue_key_t       *key;
+    pj_ioqueue_op_key_t    *op_key;
+    pj_ioqueue_operation_e  op;
+    pj_bool_t               submitted;
+    pj_bool_t               detached;
+
+    char                   *buf;
+    pj_size_t               size;
+    pj_ssize_t              written;
+    unsigned                flags;
+
+    pj_sock_t              *accept_fd;
+    pj_sockaddr_t          *local_addr;
+    pj_sockaddr_t          *rmt_addr;
+    int                    *rmt_addrlen;
+
+    /* Storage that must stay valid while the kernel owns the operation */
+    pj_sockaddr             addr;
+    socklen_t               addrlen;
+    struct msghdr           msg;
+    struct iovec            iov;
+};
+
+/*
+ * What is kept inside application's pj_ioqueue_op_key_t.
+ */
+struct uring_op_key
+{
+    pj_ioqueue_operation_e  op;
+    struct uring_req       *req;
+};
+
+/*
+ * This describes each key.
+ */
+struct pj_ioqueue_key_t
+{
+    PJ_DECL_LIST_MEMBER(struct pj_ioqueue_key_t);
+    pj_ioqueue_t           *ioqueue;
+    pj_grp_lock_t          *grp_lock;
+    pj_lock_t              *lock;
+    pj_bool_t               allow_concurrent;
+    pj_sock_t               fd;
+    int                     fd_type;
+    void                   *user_data;
+    pj_ioqueue_callback     cb;
+
+    struct uring_req        read_list;
+    struct uring_req        write_list;
+    struct uring_req        accept_list;
+    struct uring_req       *connect_req;
+
+    /* A queued stream operation could not be submitted because the ring
+     * was full. It is kept at the head of its list and retried by
+     * pj_ioqueue_poll().
+     */
+    pj_bool_t               stalled;
+
+    unsigned                ref_count;
+    pj_bool_t               closing;
+    pj_time_val             free_time;
+};
+
+/* Submission queue mapping */
+struct uring_sq
+{
+    unsigned               *khead;
+    unsigned               *ktail;
+    unsigned               *array;
+    unsigned                ring_mask;
+    unsigned                ring_entries;
+    unsigned                sqe_tail;
+    struct io_uring_sqe    *sqes;
+};
+
+/* Completion queue mapping */
+struct uring_cq
+{
+    unsigned               *khead;
+    unsigned               *ktail;
+    unsigned                ring_mask;
+    struct io_uring_cqe    *cqes;
+};
+
+/*
+ * This describes the I/O queue.
+ */
+struct pj_ioqueue_t
+{
+    pj_lock_t          *lock;
+    pj_bool_t           auto_delete_lock;
+    pj_ioqueue_cfg      cfg;
+
+    pj_pool_t          *pool;
+    unsigned            max, count;
+    pj_ioqueue_key_t    active_list;
+    pj_ioqueue_key_t    closing_list;
+    pj_ioqueue_key_t    free_list;
+    pj_mutex_t         *ref_cnt_mutex;
+
+    int                 ring_fd;
+    void               *sq_ring_ptr;
+    pj_size_t           sq_ring_sz;
+    void               *cq_ring_ptr;
+    pj_size_t           cq_ring_sz;
+    pj_size_t           sqes_sz;
+    struct uring_sq     sq;
+    struct uring_cq     cq;
+
+    /* Protects sq and dispatching */
+    pj_mutex_t         *sq_mutex;
+    /* Number of threads currently running completion callbacks. While
+     * non-zero, new submissions are left in the ring and flushed by the
+     * polling thread on its next io_uring_enter().
+     */
+    unsigned            dispatching;
+    /* Number of stalled keys, also protected by sq_mutex */
+    unsigned            stalled_cnt;
+
+    /* Protects cq */
+    pj_mutex_t         *cq_mutex;
+
+    /* Recycled request records */
+    pj_mutex_t         *req_mutex;
+    struct uring_req    req_free_list;
+};
+
+/* A reaped completion */
+struct uring_event
+{
+    struct uring_req   *req;
+    int                 res;
+};
+
+#define IS_CLOSING(key)     (key->closing)
+
+static void scan_closing_keys(pj_ioqueue_t *ioqueue);
+
+
+/*
+ * Syscall wrappers.
+ */
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit,
+                              unsigned min_complete, unsigned flags,
+                              const void *arg, pj_size_t argsz)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                        flags, arg, argsz);
+}
+
+/*
+ * pj_ioqueue_name()
+ */
+PJ_DEF(const char*) pj_ioqueue_name(void)
+{
+    return "io_uring";
+}
+
+PJ_DEF(void) pj_ioqueue_cfg_default(pj_ioqueue_cfg *cfg)
+{
+    pj_bzero(cfg, sizeof(*cfg));
+    cfg->epoll_flags = PJ_IOQUEUE_DEFAULT_EPOLL_FLAGS;
+    cfg->default_concurrency = PJ_IOQUEUE_DEFAULT_ALLOW_CONCURRENCY;
+}
+
+
+/* Create the ring and map its queues. */
+static pj_status_t ring_init(pj_ioqueue_t *ioqueue, unsigned entries)
+{
+    struct io_uring_params p;
+    pj_uint8_t *sq_ptr, *cq_ptr;
+    unsigned i;
+
+    pj_bzero(&p, sizeof(p));
+    ioqueue->ring_fd = sys_io_uring_setup(entries, &p);
+    if (ioqueue->ring_fd < 0) {
+        ioqueue->ring_fd = -1;
+        return PJ_RETURN_OS_ERROR(pj_get_native_os_error());
+    }
+
+    if ((p.features & IORING_FEAT_EXT_ARG) == 0) {
+        PJ_LOG(2,(THIS_FILE, "io_uring without IORING_FEAT_EXT_ARG is not "
+                             "supported (Linux 5.11 or later is required)"));
+        os_close(ioqueue->ring_fd);
+        ioqueue->ring_fd = -1;
+        return PJ_ENOTSUP;
+    }
+
+    ioqueue->sq_ring_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ioqueue->cq_ring_sz = p.cq_off.cqes +
+                          p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ioqueue->cq_ring_sz > ioqueue->sq_ring_sz)
+            ioqueue->sq_ring_sz = ioqueue->cq_ring_sz;
+        ioqueue->cq_ring_sz = ioqueue->sq_ring_sz;
+    }
+
+    ioqueue->sq_ring_ptr = mmap(NULL, ioqueue->sq_ring_sz,
+                                PROT_READ | PROT_WRITE,
+                                MAP_SHARED | MAP_POPULATE,
+                                ioqueue->ring_fd, IORING_OFF_SQ_RING);
+    if (ioqueue->sq_ring_ptr == MAP_FAILED)
+        goto on_error;
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        ioqueue->cq_ring_ptr = ioqueue->sq_ring_ptr;
+    } else {
+        ioqueue->cq_ring_ptr = mmap(NULL, ioqueue->cq_ring_sz,
+                                    PROT_READ | PROT_WRITE,
+                                    MAP_SHARED | MAP_POPULATE,
+                                    ioqueue->ring_fd, IORING_OFF_CQ_RING);
+        if (ioqueue->cq_ring_ptr == MAP_FAILED)
+            goto on_error;
+    }
+
+    ioqueue->sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+    ioqueue->sq.sqes = (struct io_uring_sqe*)
+                       mmap(NULL, ioqueue->sqes_sz, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE,
+                            ioqueue->ring_fd, IORING_OFF_SQES);
+    if (ioqueue->sq.sqes == MAP_FAILED)
+        goto on_error;
+
+    sq_ptr = (pj_uint8_t*)ioqueue->sq_ring_ptr;
+    ioqueue->sq.khead = (unsigned*)(sq_ptr + p.sq_off.head);
+    ioqueue->sq.ktail = (unsigned*)(sq_ptr + p.sq_off.tail);
+    ioqueue->sq.array = (unsigned*)(sq_ptr + p.sq_off.array);
+    ioqueue->sq.ring_mask = *(unsigned*)(sq_ptr + p.sq_off.ring_mask);
+    ioqueue->sq.ring_entries = *(unsigned*)(sq_ptr + p.sq_off.ring_entries);
+    ioqueue->sq.sqe_tail = *ioqueue->sq.ktail;
+
+    /* SQ index array is used as identity mapping */
+    for (i=0; i<ioqueue->sq.ring_entries; ++i)
+        ioqueue->sq.array[i] = i;
+
+    cq_ptr = (pj_uint8_t*)ioqueue->cq_ring_ptr;
+    ioqueue->cq.khead = (unsigned*)(cq_ptr + p.cq_off.head);
+    ioqueue->cq.ktail = (unsigned*)(cq_ptr + p.cq_off.tail);
+    ioqueue->cq.ring_mask = *(unsigned*)(cq_ptr + p.cq_off.ring_mask);
+    ioqueue->cq.cqes = (struct io_uring_cqe*)(cq_ptr + p.cq_off.cqes);
+
+    return PJ_SUCCESS;
+
+on_error:
+    {
+        pj_status_t status;
+
+        status = PJ_RETURN_OS_ERROR(pj_get_native_os_error());
+        if (ioqueue->sq.sqes && ioqueue->sq.sqes != MAP_FAILED)
+            munmap(ioqueue->sq.sqes, ioqueue->sqes_sz);
+        if (ioqueue->cq_ring_ptr && ioqueue->cq_ring_ptr != MAP_FAILED &&
+            ioqueue->cq_ring_ptr != ioqueue->sq_ring_ptr)
+        {
+            munmap(ioqueue->cq_ring_ptr, ioqueue->cq_ring_sz);
+        }
+        if (ioqueue->sq_ring_ptr && ioqueue->sq_ring_ptr != MAP_FAILED)
+            munmap(ioqueue->sq_ring_ptr, ioqueue->sq_ring_sz);
+        ioqueue->sq.sqes = NULL;
+        ioqueue->cq_ring_ptr = ioqueue->sq_ring_ptr = NULL;
+        os_close(ioqueue->ring_fd);
+        ioqueue->ring_fd = -1;
+        return status;
+    }
+}
+
+static void ring_destroy(pj_ioqueue_t *ioqueue)
+{
+    if (ioqueue->sq.sqes)
+        munmap(ioqueue->sq.sqes, ioqueue->sqes_sz);
+    if (ioqueue->cq_ring_ptr && ioqueue->cq_ring_ptr != ioqueue->sq_ring_ptr)
+        munmap(ioqueue->cq_ring_ptr, ioqueue->cq_ring_sz);
+    if (ioqueue->sq_ring_ptr)
+        munmap(ioqueue->sq_ring_ptr, ioqueue->sq_ring_sz);
+    ioqueue->sq.sqes = NULL;
+    ioqueue->cq_ring_ptr = ioqueue->sq_ring_ptr = NULL;
+
+    if (ioqueue->ring_fd >= 0)
+        os_close(ioqueue->ring_fd);
+    ioqueue->ring_fd = -1;
+}
+
+/* Number of SQEs that have been queued but not consumed by the kernel. */
+PJ_INLINE(unsigned) sq_pending(pj_ioqueue_t *ioqueue)
+{
+    return ioqueue->sq.sqe_tail - load_acquire(ioqueue->sq.khead);
+}
+
+/* Hand the queued SQEs to the kernel, optionally waiting for completion.
+ * Returns zero or the (positive) errno value.
+ */
+static int ring_enter(pj_ioqueue_t *ioqueue, unsigned to_submit,
+                      int wait_msec)
+{
+    int rc;
+
+    if (wait_msec > 0) {
+        struct __kernel_timespec ts;
+        struct io_uring_getevents_arg arg;
+
+        ts.tv_sec = wait_msec / 1000;
+        ts.tv_nsec = (wait_msec % 1000) * 1000000;
+        pj_bzero(&arg, sizeof(arg));
+        arg.ts = (pj_uint64_t)(pj_size_t)&ts;
+
+        rc = sys_io_uring_enter(ioqueue->ring_fd, to_submit, 1,
+                                IORING_ENTER_GETEVENTS |
+                                IORING_ENTER_EXT_ARG,
+                                &arg, sizeof(arg));
+    } else if (to_submit) {
+        rc = sys_io_uring_enter(ioqueue->ring_fd, to_submit, 0, 0, NULL, 0);
+    } else {
+        return 0;
+    }
+
+    return (rc < 0) ? errno : 0;
+}
+
+/* Get a vacant SQE. Must be called with sq_mutex held. */
+static struct io_uring_sqe *get_sqe(pj_ioqueue_t *ioqueue)
+{
+    struct io_uring_sqe *sqe;
+
+    if (sq_pending(ioqueue) >= ioqueue->sq.ring_entries) {
+        /* Ring is full, push what we have to the kernel */
+        ring_enter(ioqueue, sq_pending(ioqueue), 0);
+        if (sq_pending(ioqueue) >= ioqueue->sq.ring_entries)
+            return NULL;
+    }
+
+    sqe = &ioqueue->sq.sqes[ioqueue->sq.sqe_tail & ioqueue->sq.ring_mask];
+    pj_bzero(sqe, sizeof(*sqe));
+    return sqe;
+}
+
+/* Publish the SQE obtained with get_sqe(). Must be called with sq_mutex
+ * held. Returns the number of SQEs that the caller should submit after
+ * releasing the mutex, or zero if a polling thread will submit them.
+ */
+static unsigned commit_sqe(pj_ioqueue_t *ioqueue, pj_bool_t urgent)
+{
+    ++ioqueue->sq.sqe_tail;
+    store_release(ioqueue->sq.ktail, ioqueue->sq.sqe_tail);
+
+    if (ioqueue->dispatching && !urgent)
+        return 0;
+
+    return sq_pending(ioqueue);
+}
+
+
+/*
+ * Request records.
+ */
+static struct uring_req *alloc_req(pj_ioqueue_t *ioqueue)
+{
+    struct uring_req *req;
+
+    pj_mutex_lock(ioqueue->req_mutex);
+    if (!pj_list_empty(&ioqueue->req_free_list)) {
+        req = ioqueue->req_free_list.next;
+        pj_list_erase(req);
+    } else {
+        req = PJ_POOL_ALLOC_T(ioqueue->pool, struct uring_req);
+    }
+    pj_mutex_unlock(ioqueue->req_mutex);
+
+    if (req)
+        pj_bzero(req, sizeof(*req));
+
+    return req;
+}
+
+static void free_req(pj_ioqueue_t *ioqueue, struct uring_req *req)
+{
+    pj_mutex_lock(ioqueue->req_mutex);
+    pj_list_push_back(&ioqueue->req_free_list, req);
+    pj_mutex_unlock(ioqueue->req_mutex);
+}
+
+
+/* Increment key's reference counter */
+static void increment_counter(pj_ioqueue_key_t *key)
+{
+    pj_mutex_lock(key->ioqueue->ref_cnt_mutex);
+    ++key->ref_count;
+    pj_mutex_unlock(key->ioqueue->ref_cnt_mutex);
+}
+
+/* Decrement the key's reference counter, and when the counter reach zero,
+ * destroy the key.
+ *
+ * Note: MUST NOT CALL THIS FUNCTION WHILE HOLDING ioqueue's LOCK.
+ */
+static void decrement_counter(pj_ioqueue_key_t *key)
+{
+    pj_lock_acquire(key->ioqueue->lock);
+    pj_mutex_lock(key->ioqueue->ref_cnt_mutex);
+    --key->ref_count;
+    if (key->ref_count == 0) {
+
+        pj_assert(key->closing == 1);
+        pj_gettickcount(&key->free_time);
+        key->free_time.msec += PJ_IOQUEUE_KEY_FREE_DELAY;
+        pj_time_val_normalize(&key->free_time);
+
+        pj_list_erase(key);
+        pj_list_push_back(&key->ioqueue->closing_list, key);
+
+    }
+    pj_mutex_unlock(key->ioqueue->ref_cnt_mutex);
+    pj_lock_release(key->ioqueue->lock);
+}
+
+
+/* Submit the request to the kernel. Must be called with key's lock held.
+ * While in the kernel, the request holds a reference to the key and to
+ * its group lock, so that neither goes away before the completion is
+ * reaped.
+ */
+static pj_status_t submit_req(pj_ioqueue_key_t *key, struct uring_req *req)
+{
+    pj_ioqueue_t *ioqueue = key->ioqueue;
+    struct io_uring_sqe *sqe;
+    unsigned to_submit;
+
+    pj_mutex_lock(ioqueue->sq_mutex);
+
+    sqe = get_sqe(ioqueue);
+    if (!sqe) {
+        pj_mutex_unlock(ioqueue->sq_mutex);
+        return PJ_ETOOMANY;
+    }
+
+    sqe->fd = key->fd;
+    sqe->user_data = (pj_uint64_t)(pj_size_t)req;
+
+    switch (req->op) {
+    case PJ_IOQUEUE_OP_RECV:
+        sqe->opcode = IORING_OP_RECV;
+        sqe->addr = (pj_uint64_t)(pj_size_t)req->buf;
+        sqe->len = (pj_uint32_t)req->size;
+        sqe->msg_flags = req->flags;
+        break;
+    case PJ_IOQUEUE_OP_RECV_FROM:
+        req->iov.iov_base = req->buf;
+        req->iov.iov_len = req->size;
+        pj_bzero(&req->msg, sizeof(req->msg));
+        if (req->rmt_addr) {
+            req->msg.msg_name = &req->addr;
+            req->msg.msg_namelen = sizeof(req->addr);
+        }
+        req->msg.msg_iov = &req->iov;
+        req->msg.msg_iovlen = 1;
+        sqe->opcode = IORING_OP_RECVMSG;
+        sqe->addr = (pj_uint64_t)(pj_size_t)&req->msg;
+        sqe->len = 1;
+        sqe->msg_flags = req->flags;
+        break;
+    case PJ_IOQUEUE_OP_SEND:
+        sqe->opcode = IORING_OP_SEND;
+        sqe->addr = (pj_uint64_t)(pj_size_t)(req->buf + req->written);
+        sqe->len = (pj_uint32_t)(req->size - req->written);
+        sqe->msg_flags = req->flags | MSG_NOSIGNAL;
+        break;
+    case PJ_IOQUEUE_OP_SEND_TO:
+        req->iov.iov_base = req->buf;
+        req->iov.iov_len = req->size;
+        pj_bzero(&req->msg, sizeof(req->msg));
+        req->msg.msg_name = &req->addr;
+        req->msg.msg_namelen = req->addrlen;
+        req->msg.msg_iov = &req->iov;
+        req->msg.msg_iovlen = 1;
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->addr = (pj_uint64_t)(pj_size_t)&req->msg;
+        sqe->len = 1;
+        sqe->msg_flags = req->flags | MSG_NOSIGNAL;
+        break;
+#if PJ_HAS_TCP
+    case PJ_IOQUEUE_OP_ACCEPT:
+        req->addrlen = sizeof(req->addr);
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->addr = (pj_uint64_t)(pj_size_t)&req->addr;
+        sqe->addr2 = (pj_uint64_t)(pj_size_t)&req->addrlen;
+        break;
+    case PJ_IOQUEUE_OP_CONNECT:
+        /* connect() has been started by pj_ioqueue_connect(), wait until
+         * the socket becomes writable.
+         */
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->poll32_events = POLLOUT;
+        break;
+#endif
+    default:
+        pj_assert(!"Invalid operation type!");
+        pj_mutex_unlock(ioqueue->sq_mutex);
+        return PJ_EBUG;
+    }
+
+    req->submitted = PJ_TRUE;
+    increment_counter(key);
+    if (key->grp_lock)
+        pj_grp_lock_add_ref_dbg(key->grp_lock, "ioqueue", 0);
+
+    to_submit = commit_sqe(ioqueue, PJ_FALSE);
+    pj_mutex_unlock(ioqueue->sq_mutex);
+
+    if (to_submit) {
+        int err = ring_enter(ioqueue, to_submit, 0);
+        if (err && err != EBUSY && err != EAGAIN && err != EINTR) {
+            PJ_PERROR(2,(THIS_FILE, PJ_STATUS_FROM_OS(err),
+                         "io_uring_enter() error"));
+        }
+    }
+
+    return PJ_SUCCESS;
+}
+
+/* Ask the kernel to cancel an in-flight request. The cancellation is
+ * submitted immediately, so that by the time this function returns the
+ * kernel no longer touches the operation's buffer (network operations
+ * are poll driven and are cancelled synchronously).
+ */
+static void cancel_req(pj_ioqueue_t *ioqueue, struct uring_req *req)
+{
+    struct io_uring_sqe *sqe;
+    unsigned to_submit;
+
+    pj_mutex_lock(ioqueue->sq_mutex);
+    sqe = get_sqe(ioqueue);
+    if (!sqe) {
+        pj_mutex_unlock(ioqueue->sq_mutex);
+        PJ_LOG(2,(THIS_FILE, "Unable to cancel operation %p: ring is full",
+                  req));
+        return;
+    }
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = (pj_uint64_t)(pj_size_t)req;
+    sqe->user_data = 0;
+    to_submit = commit_sqe(ioqueue, PJ_TRUE);
+    pj_mutex_unlock(ioqueue->sq_mutex);
+
+    ring_enter(ioqueue, to_submit, 0);
+}
+
+/* Set or clear the key's stalled state. Must be called with key's lock
+ * held.
+ */
+static void set_stalled(pj_ioqueue_key_t *key, pj_bool_t stalled)
+{
+    pj_ioqueue_t *ioqueue = key->ioqueue;
+
+    if (key->stalled == stalled)
+        return;
+
+    key->stalled = stalled;
+    pj_mutex_lock(ioqueue->sq_mutex);
+    if (stalled)
+        ++ioqueue->stalled_cnt;
+    else
+        --ioqueue->stalled_cnt;
+    pj_mutex_unlock(ioqueue->sq_mutex);
+}
+
+/* Start the first queued (not yet submitted) request in the list. Stream
+ * sockets only keep one operation per direction in the kernel, so that
+ * data is neither reordered nor interleaved. If the request can't be
+ * submitted, it stays at the head of the list and the key is marked as
+ * stalled, so that the submission is retried by pj_ioqueue_poll() before
+ * any later operation. Must be called with key's lock held.
+ */
+static void submit_next(pj_ioqueue_key_t *key, struct uring_req *list)
+{
+    struct uring_req *req = list->next;
+    pj_status_t status;
+
+    if (req == list || req->submitted)
+        return;
+
+    status = submit_req(key, req);
+    if (status != PJ_SUCCESS) {
+        PJ_PERROR(4,(THIS_FILE, status,
+                     "Unable to submit queued operation, will retry"));
+        set_stalled(key, PJ_TRUE);
+    }
+}
+
+/* Retry the submission of the queued operations of stalled keys. */
+static void submit_stalled(pj_ioqueue_t *ioqueue)
+{
+    pj_ioqueue_key_t *key;
+    unsigned stalled_cnt;
+
+    pj_mutex_lock(ioqueue->sq_mutex);
+    stalled_cnt = ioqueue->stalled_cnt;
+    pj_mutex_unlock(ioqueue->sq_mutex);
+
+    if (stalled_cnt == 0)
+        return;
+
+    /* Key's lock must be acquired before ioqueue's lock, so just skip
+     * the busy keys, they will be retried on the next poll.
+     */
+    pj_lock_acquire(ioqueue->lock);
+    for (key = ioqueue->active_list.next; key != &ioqueue->active_list;
+         key = key->next)
+    {
+        if (!key->stalled || pj_ioqueue_trylock_key(key) != PJ_SUCCESS)
+            continue;
+
+        if (key->stalled && !IS_CLOSING(key)) {
+            set_stalled(key, PJ_FALSE);
+            submit_next(key, &key->read_list);
+            submit_next(key, &key->write_list);
+        }
+        pj_ioqueue_unlock_key(key);
+    }
+    pj_lock_release(ioqueue->lock);
+}
+
+/* Detach the request from the key (and the application's op_key), and
+ * cancel it if it is already in the kernel. Must be called with key's
+ * lock held.
+ */
+static void detach_req(pj_ioqueue_key_t *key, struct uring_req *req)
+{
+    pj_list_erase(req);
+    if (req->op_key)
+        ((struct uring_op_key*)req->op_key)->op = PJ_IOQUEUE_OP_NONE;
+    req->op_key = NULL;
+
+    if (req->submitted) {
+        /* The completion will release it */
+        req->detached = PJ_TRUE;
+        cancel_req(key->ioqueue, req);
+    } else {
+        free_req(key->ioqueue, req);
+    }
+}
+
+static void detach_all_req(pj_ioqueue_key_t *key)
+{
+    set_stalled(key, PJ_FALSE);
+    while (!pj_list_empty(&key->read_list))
+        detach_req(key, key->read_list.next);
+    while (!pj_list_empty(&key->write_list))
+        detach_req(key, key->write_list.next);
+    while (!pj_list_empty(&key->accept_list))
+        detach_req(key, key->accept_list.next);
+    if (key->connect_req) {
+        key->connect_req->detached = PJ_TRUE;
+        cancel_req(key->ioqueue, key->connect_req);
+        key->connect_req = NULL;
+    }
+}
+
+/* Queue the request to the key and submit it if possible. */
+static pj_status_t start_req(pj_ioqueue_key_t *key,
+                             pj_ioqueue_op_key_t *op_key,
+                             struct uring_req *req,
+                             struct uring_req *list)
+{
+    struct uring_op_key *op = (struct uring_op_key*)op_key;
+    pj_bool_t submit;
+    pj_status_t status;
+
+    pj_ioqueue_lock_key(key);
+
+    /* Check again. Handle may have been closed after the previous check
+     * in multithreaded app.
+     */
+    if (IS_CLOSING(key)) {
+        pj_ioqueue_unlock_key(key);
+        free_req(key->ioqueue, req);
+        return PJ_ECANCELLED;
+    }
+
+    req->key = key;
+    req->op_key = op_key;
+    op->op = req->op;
+    op->req = req;
+
+    submit = (list == &key->accept_list) ||
+             (key->fd_type != pj_SOCK_STREAM()) || pj_list_empty(list);
+    pj_list_push_back(list, req);
+
+    if (submit) {
+        status = submit_req(key, req);
+        if (status != PJ_SUCCESS) {
+            pj_list_erase(req);
+            op->op = PJ_IOQUEUE_OP_NONE;
+            pj_ioqueue_unlock_key(key);
+            free_req(key->ioqueue, req);
+            return status;
+        }
+    }
+
+    pj_ioqueue_unlock_key(key);
+    return PJ_EPENDING;
+}
+
+
+/*
+ * pj_ioqueue_create()
+ *
+ * Create io_uring ioqueue.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_create( pj_pool_t *pool,
+                                       pj_size_t max_fd,
+                                       pj_ioqueue_t **p_ioqueue)
+{
+    return pj_ioqueue_create2(pool, max_fd, NULL, p_ioqueue);
+}
+
+/*
+ * pj_ioqueue_create2()
+ *
+ * Create io_uring ioqueue.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_create2(pj_pool_t *pool,
+                                       pj_size_t max_fd,
+                                       const pj_ioqueue_cfg *cfg,
+                                       pj_ioqueue_t **p_ioqueue)
+{
+    pj_ioqueue_t *ioqueue;
+    pj_lock_t *lock;
+    pj_status_t rc;
+    pj_size_t i;
+
+    /* Check that arguments are valid. */
+    PJ_ASSERT_RETURN(pool != NULL && p_ioqueue != NULL &&
+                     max_fd > 0, PJ_EINVAL);
+
+    /* Check that size of pj_ioqueue_op_key_t is sufficient */
+    PJ_ASSERT_RETURN(sizeof(pj_ioqueue_op_key_t)-sizeof(void*) >=
+                     sizeof(struct uring_op_key), PJ_EBUG);
+
+    ioqueue = PJ_POOL_ZALLOC_T(pool, pj_ioqueue_t);
+    ioqueue->ring_fd = -1;
+
+    if (cfg)
+        pj_memcpy(&ioqueue->cfg, cfg, sizeof(*cfg));
+    else
+        pj_ioqueue_cfg_default(&ioqueue->cfg);
+
+    ioqueue->max = (unsigned)max_fd;
+    ioqueue->count = 0;
+    pj_list_init(&ioqueue->active_list);
+    pj_list_init(&ioqueue->free_list);
+    pj_list_init(&ioqueue->closing_list);
+    pj_list_init(&ioqueue->req_free_list);
+
+    /* Request records are allocated on demand from a private pool, since
+     * application's pool may not be safe to use from polling threads.
+     */
+    ioqueue->pool = pj_pool_create(pool->factory, "ioq_uring%p",
+                                   4000, 4000, NULL);
+    if (!ioqueue->pool)
+        return PJ_ENOMEM;
+
+    rc = pj_mutex_create_simple(pool, NULL, &ioqueue->ref_cnt_mutex);
+    if (rc != PJ_SUCCESS)
+        goto on_error;
+
+    rc = pj_mutex_create_simple(pool, NULL, &ioqueue->sq_mutex);
+    if (rc != PJ_SUCCESS)
+        goto on_error;
+
+    rc = pj_mutex_create_simple(pool, NULL, &ioqueue->cq_mutex);
+    if (rc != PJ_SUCCESS)
+        goto on_error;
+
+    rc = pj_mutex_create_simple(pool, NULL, &ioqueue->req_mutex);
+    if (rc != PJ_SUCCESS)
+        goto on_error;
+
+    /* Pre-create all keys according to max_fd */
+    for (i=0; i<max_fd; ++i) {
+        pj_ioqueue_key_t *key;
+
+        key = PJ_POOL_ZALLOC_T(pool, pj_ioqueue_key_t);
+        rc = pj_lock_create_recursive_mutex(pool, NULL, &key->lock);
+        if (rc != PJ_SUCCESS)
+            goto on_error;
+
+        pj_list_push_back(&ioqueue->free_list, key);
+    }
+
+    rc = pj_lock_create_simple_mutex(pool, "ioq%p", &lock);
+    if (rc != PJ_SUCCESS)
+        goto on_error;
+
+    rc = pj_ioqueue_set_lock(ioqueue, lock, PJ_TRUE);
+    if (rc != PJ_SUCCESS)
+        goto on_error;
+
+    rc = ring_init(ioqueue, PJ_IOQUEUE_URING_ENTRIES);
+    if (rc != PJ_SUCCESS) {
+        PJ_PERROR(1,(THIS_FILE, rc, "io_uring_setup() error"));
+        goto on_error;
+    }
+
+    PJ_LOG(4, ("pjlib", "io_uring I/O Queue created (entries:%u, ptr=%p)",
+               ioqueue->sq.ring_entries, ioqueue));
+
+    *p_ioqueue = ioqueue;
+    return PJ_SUCCESS;
+
+on_error:
+    {
+        pj_ioqueue_key_t *key = ioqueue->free_list.next;
+        while (key != &ioqueue->free_list) {
+            pj_lock_destroy(key->lock);
+            key = key->next;
+        }
+    }
+    if (ioqueue->auto_delete_lock && ioqueue->lock)
+        pj_lock_destroy(ioqueue->lock);
+    if (ioqueue->req_mutex)
+        pj_mutex_destroy(ioqueue->req_mutex);
+    if (ioqueue->cq_mutex)
+        pj_mutex_destroy(ioqueue->cq_mutex);
+    if (ioqueue->sq_mutex)
+        pj_mutex_destroy(ioqueue->sq_mutex);
+    if (ioqueue->ref_cnt_mutex)
+        pj_mutex_destroy(ioqueue->ref_cnt_mutex);
+    pj_pool_release(ioqueue->pool);
+    return rc;
+}
+
+/*
+ * pj_ioqueue_destroy()
+ *
+ * Destroy ioqueue.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_destroy(pj_ioqueue_t *ioqueue)
+{
+    pj_ioqueue_key_t *key;
+
+    PJ_ASSERT_RETURN(ioqueue, PJ_EINVAL);
+    PJ_ASSERT_RETURN(ioqueue->ring_fd >= 0, PJ_EINVALIDOP);
+
+    pj_lock_acquire(ioqueue->lock);
+
+    /* Closing the ring cancels whatever is still in the kernel */
+    ring_destroy(ioqueue);
+
+    key = ioqueue->active_list.next;
+    while (key != &ioqueue->active_list) {
+        pj_lock_destroy(key->lock);
+        key = key->next;
+    }
+
+    key = ioqueue->closing_list.next;
+    while (key != &ioqueue->closing_list) {
+        pj_lock_destroy(key->lock);
+        key = key->next;
+    }
+
+    key = ioqueue->free_list.next;
+    while (key != &ioqueue->free_list) {
+        pj_lock_destroy(key->lock);
+        key = key->next;
+    }
+
+    pj_mutex_destroy(ioqueue->req_mutex);
+    pj_mutex_destroy(ioqueue->cq_mutex);
+    pj_mutex_destroy(ioqueue->sq_mutex);
+    pj_mutex_destroy(ioqueue->ref_cnt_mutex);
+    pj_pool_release(ioqueue->pool);
+
+    if (ioqueue->auto_delete_lock && ioqueue->lock ) {
+        pj_lock_release(ioqueue->lock);
+        return pj_lock_destroy(ioqueue->lock);
+    }
+
+    return PJ_SUCCESS;
+}
+
+/*
+ * pj_ioqueue_set_lock()
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_set_lock( pj_ioqueue_t *ioqueue,
+                                         pj_lock_t *lock,
+                                         pj_bool_t auto_delete )
+{
+    PJ_ASSERT_RETURN(ioqueue && lock, PJ_EINVAL);
+
+    if (ioqueue->auto_delete_lock && ioqueue->lock) {
+        pj_lock_destroy(ioqueue->lock);
+    }
+
+    ioqueue->lock = lock;
+    ioqueue->auto_delete_lock = auto_delete;
+
+    return PJ_SUCCESS;
+}
+
+/*
+ * pj_ioqueue_register_sock()
+ *
+ * Register a socket to ioqueue.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_register_sock2(pj_pool_t *pool,
+                                              pj_ioqueue_t *ioqueue,
+                                              pj_sock_t sock,
+                                              pj_grp_lock_t *grp_lock,
+                                              void *user_data,
+                                              const pj_ioqueue_callback *cb,
+                                              pj_ioqueue_key_t **p_key)
+{
+    pj_ioqueue_key_t *key = NULL;
+    pj_uint32_t value;
+    int optlen;
+    pj_status_t status = PJ_SUCCESS;
+
+    PJ_ASSERT_RETURN(pool && ioqueue && sock != PJ_INVALID_SOCKET &&
+                     cb && p_key, PJ_EINVAL);
+
+    pj_lock_acquire(ioqueue->lock);
+
+    if (ioqueue->count >= ioqueue->max) {
+        status = PJ_ETOOMANY;
+        TRACE_((THIS_FILE, "pj_ioqueue_register_sock error: too many files"));
+        goto on_return;
+    }
+
+    /* Set socket to nonblocking. The send fast path relies on this, and
+     * io_uring handles EAGAIN internally for the submitted operations.
+     */
+    value = 1;
+    if (os_ioctl(sock, FIONBIO, (unsigned long)&value)) {
+        status = pj_get_netos_error();
+        goto on_return;
+    }
+
+    /* Scan closing_keys first to let them come back to free_list */
+    scan_closing_keys(ioqueue);
+
+    pj_assert(!pj_list_empty(&ioqueue->free_list));
+    if (pj_list_empty(&ioqueue->free_list)) {
+        status = PJ_ETOOMANY;
+        goto on_return;
+    }
+
+    key = ioqueue->free_list.next;
+    pj_list_erase(key);
+
+    key->ioqueue = ioqueue;
+    key->fd = sock;
+    key->user_data = user_data;
+    pj_memcpy(&key->cb, cb, sizeof(pj_ioqueue_callback));
+    pj_list_init(&key->read_list);
+    pj_list_init(&key->write_list);
+    pj_list_init(&key->accept_list);
+    key->connect_req = NULL;
+    key->stalled = PJ_FALSE;
+
+    /* Set initial reference count to 1 */
+    pj_assert(key->ref_count == 0);
+    ++key->ref_count;
+    key->closing = 0;
+
+    status = pj_ioqueue_set_concurrency(key, ioqueue->cfg.default_concurrency);
+    if (status != PJ_SUCCESS) {
+        key->ref_count = 0;
+        pj_list_push_back(&ioqueue->free_list, key);
+        key = NULL;
+        goto on_return;
+    }
+
+    /* Get socket type. Operations on stream sockets are serialized. */
+    optlen = sizeof(key->fd_type);
+    status = pj_sock_getsockopt(sock, pj_SOL_SOCKET(), pj_SO_TYPE(),
+                                &key->fd_type, &optlen);
+    if (status != PJ_SUCCESS)
+        key->fd_type = pj_SOCK_STREAM();
+    status = PJ_SUCCESS;
+
+    /* Group lock */
+    key->grp_lock = grp_lock;
+    if (key->grp_lock) {
+        pj_grp_lock_add_ref_dbg(key->grp_lock, "ioqueue", 0);
+    }
+
+    /* Register */
+    pj_list_insert_before(&ioqueue->active_list, key);
+    ++ioqueue->count;
+
+on_return:
+    *p_key = key;
+    pj_lock_release(ioqueue->lock);
+
+    return status;
+}
+
+PJ_DEF(pj_status_t) pj_ioqueue_register_sock( pj_pool_t *pool,
+                                              pj_ioqueue_t *ioqueue,
+                                              pj_sock_t sock,
+                                              void *user_data,
+                                              const pj_ioqueue_callback *cb,
+                                              pj_ioqueue_key_t **p_key)
+{
+    return pj_ioqueue_register_sock2(pool, ioqueue, sock, NULL, user_data,
+                                     cb, p_key);
+}
+
+/*
+ * pj_ioqueue_unregister()
+ *
+ * Unregister handle from ioqueue.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_unregister( pj_ioqueue_key_t *key)
+{
+    pj_ioqueue_t *ioqueue;
+
+    PJ_ASSERT_RETURN(key != NULL, PJ_EINVAL);
+
+    ioqueue = key->ioqueue;
+
+    /* Lock the key to make sure no callback is simultaneously modifying
+     * the key. We need to lock the key before ioqueue here to prevent
+     * deadlock.
+     */
+    pj_ioqueue_lock_key(key);
+
+    /* Best effort to avoid double key-unregistration */
+    if (IS_CLOSING(key)) {
+        pj_ioqueue_unlock_key(key);
+        return PJ_SUCCESS;
+    }
+
+    /* Also lock ioqueue */
+    pj_lock_acquire(ioqueue->lock);
+
+    /* Avoid "negative" ioqueue count */
+    if (ioqueue->count > 0) {
+        --ioqueue->count;
+    } else {
+        /* If this happens, very likely there is double unregistration
+         * of a key.
+         */
+        pj_assert(!"Bad ioqueue count in key unregistration!");
+        PJ_LOG(1,(THIS_FILE, "Bad ioqueue count in key unregistration!"));
+    }
+
+    /* Mark key is closing. */
+    key->closing = 1;
+
+    pj_lock_release(ioqueue->lock);
+
+    /* Cancel everything that is still in the kernel. The completions of
+     * cancelled operations are discarded by the polling thread.
+     */
+    detach_all_req(key);
+
+    /* Destroy the key. */
+    pj_sock_close(key->fd);
+
+    /* Decrement counter. */
+    decrement_counter(key);
+
+    /* Done. */
+    if (key->grp_lock) {
+        /* just dec_ref and unlock. we will set grp_lock to NULL
+         * elsewhere */
+        pj_grp_lock_t *grp_lock = key->grp_lock;
+        // Don't set grp_lock to NULL otherwise the other thread
+        // will crash. Just leave it as dangling pointer, but this
+        // should be safe
+        //key->grp_lock = NULL;
+        pj_grp_lock_dec_ref_dbg(grp_lock, "ioqueue", 0);
+        pj_grp_lock_release(grp_lock);
+    } else {
+        pj_ioqueue_unlock_key(key);
+    }
+
+    return PJ_SUCCESS;
+}
+
+/* Scan closing keys to be put to free list again */
+static void scan_closing_keys(pj_ioqueue_t *ioqueue)
+{
+    pj_time_val now;
+    pj_ioqueue_key_t *h;
+
+    pj_gettickcount(&now);
+    h = ioqueue->closing_list.next;
+    while (h != &ioqueue->closing_list) {
+        pj_ioqueue_key_t *next = h->next;
+
+        pj_assert(h->closing != 0);
+
+        if (PJ_TIME_VAL_GTE(now, h->free_time)) {
+            pj_list_erase(h);
+            // Don't set grp_lock to NULL otherwise the other thread
+            // will crash. Just leave it as dangling pointer, but this
+            // should be safe
+            //h->grp_lock = NULL;
+            pj_list_push_back(&ioqueue->free_list, h);
+        }
+        h = next;
+    }
+}
+
+/*
+ * pj_ioqueue_get_user_data()
+ *
+ * Obtain value associated with a key.
+ */
+PJ_DEF(void*) pj_ioqueue_get_user_data( pj_ioqueue_key_t *key )
+{
+    PJ_ASSERT_RETURN(key != NULL, NULL);
+    return key->user_data;
+}
+
+/*
+ * pj_ioqueue_set_user_data()
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_set_user_data( pj_ioqueue_key_t *key,
+                                              void *user_data,
+                                              void **old_data)
+{
+    PJ_ASSERT_RETURN(key, PJ_EINVAL);
+
+    if (old_data)
+        *old_data = key->user_data;
+    key->user_data = user_data;
+
+    return PJ_SUCCESS;
+}
+
+
+/* Convert CQE result to the bytes/status convention of the callbacks */
+PJ_INLINE(pj_ssize_t) res_to_bytes_status(int res)
+{
+    return (res >= 0) ? (pj_ssize_t)res : -(pj_ssize_t)PJ_STATUS_FROM_OS(-res);
+}
+
+/*
+ * Process one completion. Returns PJ_TRUE if a callback was called.
+ */
+static pj_bool_t dispatch_completion(pj_ioqueue_t *ioqueue,
+                                     struct uring_req *req,
+                                     int res)
+{
+    pj_ioqueue_key_t *key = req->key;
+    pj_grp_lock_t *grp_lock = key->grp_lock;
+    pj_ioqueue_op_key_t *op_key;
+    pj_status_t status = PJ_SUCCESS;
+    pj_bool_t has_lock, called = PJ_FALSE, resubmitted = PJ_FALSE;
+
+    pj_ioqueue_lock_key(key);
+
+    if (req->detached || IS_CLOSING(key)) {
+        pj_ioqueue_unlock_key(key);
+        goto on_return;
+    }
+
+    op_key = req->op_key;
+    req->submitted = PJ_FALSE;
+
+    switch (req->op) {
+    case PJ_IOQUEUE_OP_RECV:
+    case PJ_IOQUEUE_OP_RECV_FROM:
+        pj_list_erase(req);
+        ((struct uring_op_key*)op_key)->op = PJ_IOQUEUE_OP_NONE;
+
+        if (res >= 0 && req->op == PJ_IOQUEUE_OP_RECV_FROM &&
+            req->rmt_addr && req->rmt_addrlen)
+        {
+            int len = (int)req->msg.msg_namelen;
+            if (len > *req->rmt_addrlen)
+                len = *req->rmt_addrlen;
+            pj_memcpy(req->rmt_addr, &req->addr, len);
+            *req->rmt_addrlen = (int)req->msg.msg_namelen;
+        }
+
+        if (key->fd_type == pj_SOCK_STREAM())
+            submit_next(key, &key->read_list);
+        break;
+
+    case PJ_IOQUEUE_OP_SEND:
+    case PJ_IOQUEUE_OP_SEND_TO:
+        if (res > 0 && key->fd_type == pj_SOCK_STREAM() &&
+            req->written + res < (pj_ssize_t)req->size)
+        {
+            /* Partial write on stream, send the remaining */
+            req->written += res;
+            if (submit_req(key, req) == PJ_SUCCESS) {
+                resubmitted = PJ_TRUE;
+                pj_ioqueue_unlock_key(key);
+                goto on_return;
+            }
+            res = -EIO;
+        }
+
+        pj_list_erase(req);
+        ((struct uring_op_key*)op_key)->op = PJ_IOQUEUE_OP_NONE;
+        if (res >= 0)
+            res += (int)req->written;
+
+        if (key->fd_type == pj_SOCK_STREAM())
+            submit_next(key, &key->write_list);
+        break;
+
+#if PJ_HAS_TCP
+    case PJ_IOQUEUE_OP_ACCEPT:
+        pj_list_erase(req);
+        ((struct uring_op_key*)op_key)->op = PJ_IOQUEUE_OP_NONE;
+
+        if (res >= 0) {
+            *req->accept_fd = res;
+            if (req->rmt_addr) {
+                int len = (int)req->addrlen;
+                if (len > *req->rmt_addrlen)
+                    len = *req->rmt_addrlen;
+                pj_memcpy(req->rmt_addr, &req->addr, len);
+                *req->rmt_addrlen = (int)req->addrlen;
+            }
+            if (req->local_addr) {
+                status = pj_sock_getsockname(res, req->local_addr,
+                                             req->rmt_addrlen);
+            }
+        } else {
+            *req->accept_fd = PJ_INVALID_SOCKET;
+            status = PJ_STATUS_FROM_OS(-res);
+        }
+        break;
+
+    case PJ_IOQUEUE_OP_CONNECT:
+        key->connect_req = NULL;
+        if (res < 0) {
+            status = PJ_STATUS_FROM_OS(-res);
+        } else {
+            int value;
+            int vallen = sizeof(value);
+
+            /* Socket is writable, see if connect() was successful */
+            if (pj_sock_getsockopt(key->fd, SOL_SOCKET, SO_ERROR,
+                                   &value, &vallen) == PJ_SUCCESS &&
+                value != 0)
+            {
+                status = PJ_STATUS_FROM_OS(value);
+            }
+        }
+        break;
+#endif
+
+    default:
+        pj_assert(!"Invalid operation type!");
+        pj_ioqueue_unlock_key(key);
+        goto on_return;
+    }
+
+    /* Unlock; from this point we don't need to hold key's mutex
+     * (unless concurrency is disabled, which in this case we should
+     * hold the mutex while calling the callback) */
+    if (key->allow_concurrent) {
+        /* concurrency may be changed while we're in the callback, so
+         * save it to a flag.
+         */
+        has_lock = PJ_FALSE;
+        pj_ioqueue_unlock_key(key);
+        PJ_RACE_ME(5);
+    } else {
+        has_lock = PJ_TRUE;
+    }
+
+    /* Call callback. */
+    if (!IS_CLOSING(key)) {
+        switch (req->op) {
+        case PJ_IOQUEUE_OP_RECV:
+        case PJ_IOQUEUE_OP_RECV_FROM:
+            if (key->cb.on_read_complete) {
+                (*key->cb.on_read_complete)(key, op_key,
+                                            res_to_bytes_status(res));
+            }
+            break;
+        case PJ_IOQUEUE_OP_SEND:
+        case PJ_IOQUEUE_OP_SEND_TO:
+            if (key->cb.on_write_complete) {
+                (*key->cb.on_write_complete)(key, op_key,
+                                             res_to_bytes_status(res));
+            }
+            break;
+#if PJ_HAS_TCP
+        case PJ_IOQUEUE_OP_ACCEPT:
+            if (key->cb.on_accept_complete) {
+                (*key->cb.on_accept_complete)(key, op_key,
+                                              *req->accept_fd, status);
+            }
+            break;
+        case PJ_IOQUEUE_OP_CONNECT:
+            if (key->cb.on_connect_complete)
+                (*key->cb.on_connect_complete)(key, status);
+            break;
+#endif
+        default:
+            break;
+        }
+    }
+    called = PJ_TRUE;
+
+    if (has_lock) {
+        pj_ioqueue_unlock_key(key);
+    }
+
+on_return:
+    /* Release the references held by the completed submission. A
+     * resubmitted request has taken new references.
+     */
+    if (!resubmitted)
+        free_req(ioqueue, req);
+    decrement_counter(key);
+    if (grp_lock)
+        pj_grp_lock_dec_ref_dbg(grp_lock, "ioqueue", 0);
+
+    return called;
+}
+
+/* Copy completions out of the CQ. */
+static unsigned reap_cqes(pj_ioqueue_t *ioqueue, struct uring_event *events,
+                          unsigned max_events)
+{
+    unsigned head, tail, count = 0;
+
+    pj_mutex_lock(ioqueue->cq_mutex);
+
+    head = *ioqueue->cq.khead;
+    tail = load_acquire(ioqueue->cq.ktail);
+    while (head != tail && count < max_events) {
+        struct io_uring_cqe *cqe;
+
+        cqe = &ioqueue->cq.cqes[head & ioqueue->cq.ring_mask];
+        ++head;
+
+        /* Completions of cancel requests carry no user data */
+        if (cqe->user_data == 0)
+            continue;
+
+        events[count].req = (struct uring_req*)(pj_size_t)cqe->user_data;
+        events[count].res = cqe->res;
+        ++count;
+    }
+    store_release(ioqueue->cq.khead, head);
+
+    pj_mutex_unlock(ioqueue->cq_mutex);
+
+    return count;
+}
+
+/*
+ * pj_ioqueue_poll()
+ *
+ */
+PJ_DEF(int) pj_ioqueue_poll( pj_ioqueue_t *ioqueue, const pj_time_val *timeout)
+{
+    enum { MAX_EVENTS = PJ_IOQUEUE_MAX_CAND_EVENTS };
+    struct uring_event events[MAX_EVENTS];
+    unsigned i, count, to_submit, processed_cnt = 0;
+    int msec;
+
+    PJ_CHECK_STACK();
+
+    msec = timeout ? PJ_TIME_VAL_MSEC(*timeout) : 9000;
+
+    submit_stalled(ioqueue);
+
+    count = reap_cqes(ioqueue, events, MAX_EVENTS);
+    if (count == 0) {
+        int err;
+
+        /* Submit the pending operations and wait for completions in one
+         * syscall.
+         */
+        pj_mutex_lock(ioqueue->sq_mutex);
+        to_submit = sq_pending(ioqueue);
+        pj_mutex_unlock(ioqueue->sq_mutex);
+
+        TRACE_((THIS_FILE, "start io_uring_enter, submit=%u msec=%d",
+                to_submit, msec));
+
+        err = ring_enter(ioqueue, to_submit, msec);
+        if (err && err != ETIME && err != EINTR && err != EBUSY &&
+            err != EAGAIN)
+        {
+            TRACE_((THIS_FILE, "  io_uring_enter error"));
+            return -PJ_STATUS_FROM_OS(err);
+        }
+
+        count = reap_cqes(ioqueue, events, MAX_EVENTS);
+    }
+
+    if (count == 0) {
+        /* Check the closing keys only when there's no activity and when
+         * there are pending closing keys.
+         */
+        if (!pj_list_empty(&ioqueue->closing_list)) {
+            pj_lock_acquire(ioqueue->lock);
+            scan_closing_keys(ioqueue);
+            pj_lock_release(ioqueue->lock);
+        }
+        TRACE_((THIS_FILE, "  io_uring_enter timed out"));
+        return 0;
+    }
+
+    /* Operations started from the callbacks are batched and submitted
+     * after all events have been dispatched.
+     */
+    pj_mutex_lock(ioqueue->sq_mutex);
+    ++ioqueue->dispatching;
+    pj_mutex_unlock(ioqueue->sq_mutex);
+
+    for (i=0; i<count; ++i) {
+        if (dispatch_completion(ioqueue, events[i].req, events[i].res))
+            ++processed_cnt;
+    }
+
+    pj_mutex_lock(ioqueue->sq_mutex);
+    --ioqueue->dispatching;
+    to_submit = sq_pending(ioqueue);
+    pj_mutex_unlock(ioqueue->sq_mutex);
+
+    if (to_submit)
+        ring_enter(ioqueue, to_submit, 0);
+
+    TRACE_((THIS_FILE, "     poll: count=%u processed=%u",
+            count, processed_cnt));
+
+    return processed_cnt;
+}
+
+/*
+ * pj_ioqueue_recv()
+ *
+ * Start asynchronous recv() from the socket.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_recv(  pj_ioqueue_key_t *key,
+                                      pj_ioqueue_op_key_t *op_key,
+                                      void *buffer,
+                                      pj_ssize_t *length,
+                                      unsigned flags )
+{
+    struct uring_op_key *op;
+    struct uring_req *req;
+
+    PJ_ASSERT_RETURN(key && op_key && buffer && length, PJ_EINVAL);
+    PJ_CHECK_STACK();
+
+    /* Check if key is closing (need to do this first before accessing
+     * other variables, since they might have been destroyed. See ticket
+     * #469).
+     */
+    if (IS_CLOSING(key))
+        return PJ_ECANCELLED;
+
+    op = (struct uring_op_key*)op_key;
+    PJ_ASSERT_RETURN(op->op == PJ_IOQUEUE_OP_NONE, PJ_EPENDING);
+
+    /* Unlike the readiness based backends, we don't try to read
+     * synchronously first; the operation is always completed by the
+     * kernel, which saves a syscall per packet.
+     */
+    req = alloc_req(key->ioqueue);
+    if (!req)
+        return PJ_ENOMEM;
+
+    req->op = PJ_IOQUEUE_OP_RECV;
+    req->buf = (char*)buffer;
+    req->size = *length;
+    req->flags = flags & ~(PJ_IOQUEUE_ALWAYS_ASYNC);
+
+    return start_req(key, op_key, req, &key->read_list);
+}
+
+/*
+ * pj_ioqueue_recvfrom()
+ *
+ * Start asynchronous recvfrom() from the socket.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_recvfrom( pj_ioqueue_key_t *key,
+                                         pj_ioqueue_op_key_t *op_key,
+                                         void *buffer,
+                                         pj_ssize_t *length,
+                                         unsigned flags,
+                                         pj_sockaddr_t *addr,
+                                         int *addrlen)
+{
+    struct uring_op_key *op;
+    struct uring_req *req;
+
+    PJ_ASSERT_RETURN(key && op_key && buffer && length, PJ_EINVAL);
+    PJ_CHECK_STACK();
+
+    /* Check if key is closing. */
+    if (IS_CLOSING(key))
+        return PJ_ECANCELLED;
+
+    op = (struct uring_op_key*)op_key;
+    PJ_ASSERT_RETURN(op->op == PJ_IOQUEUE_OP_NONE, PJ_EPENDING);
+
+    req = alloc_req(key->ioqueue);
+    if (!req)
+        return PJ_ENOMEM;
+
+    req->op = PJ_IOQUEUE_OP_RECV_FROM;
+    req->buf = (char*)buffer;
+    req->size = *length;
+    req->flags = flags & ~(PJ_IOQUEUE_ALWAYS_ASYNC);
+    req->rmt_addr = addr;
+    req->rmt_addrlen = addrlen;
+
+    return start_req(key, op_key, req, &key->read_list);
+}
+
+/* Common part of pj_ioqueue_send() and pj_ioqueue_sendto() */
+static pj_status_t start_write(pj_ioqueue_key_t *key,
+                               pj_ioqueue_op_key_t *op_key,
+                               pj_ioqueue_operation_e op_type,
+                               const void *data,
+                               pj_ssize_t *length,
+                               unsigned flags,
+                               const pj_sockaddr_t *addr,
+                               int addrlen)
+{
+    struct uring_op_key *op;
+    struct uring_req *req;
+    pj_status_t status;
+    pj_ssize_t sent;
+
+    /* Fast track:
+     *   Try to send data immediately, only if there's no pending write!
+     * Note:
+     *  We are speculating that the list is empty here without properly
+     *  acquiring key's mutex first. This is intentional, to maximize
+     *  performance via parallelism. See ioqueue_common_abs.c.
+     */
+    if (pj_list_empty(&key->write_list)) {
+        sent = *length;
+        if (op_type == PJ_IOQUEUE_OP_SEND)
+            status = pj_sock_send(key->fd, data, &sent, flags);
+        else
+            status = pj_sock_sendto(key->fd, data, &sent, flags,
+                                    addr, addrlen);
+        if (status == PJ_SUCCESS) {
+            /* Success! */
+            *length = sent;
+            return PJ_SUCCESS;
+        } else {
+            /* If error is not EWOULDBLOCK (or EAGAIN on Linux), report
+             * the error to caller.
+             */
+            if (status != PJ_STATUS_FROM_OS(PJ_BLOCKING_ERROR_VAL)) {
+                return status;
+            }
+        }
+    }
+
+    /*
+     * Schedule asynchronous send.
+     */
+    op = (struct uring_op_key*)op_key;
+    if (op->op != PJ_IOQUEUE_OP_NONE) {
+        /* Aplication should specify multiple write operation keys on
+         * situation like this.
+         */
+        return PJ_EBUSY;
+    }
+
+    req = alloc_req(key->ioqueue);
+    if (!req)
+        return PJ_ENOMEM;
+
+    req->op = op_type;
+    req->buf = (char*)data;
+    req->size = *length;
+    req->flags = flags;
+    if (addr) {
+        pj_memcpy(&req->addr, addr, addrlen);
+        req->addrlen = addrlen;
+    }
+
+    return start_req(key, op_key, req, &key->write_list);
+}
+
+/*
+ * pj_ioqueue_send()
+ *
+ * Start asynchronous send() to the descriptor.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_send( pj_ioqueue_key_t *key,
+                                     pj_ioqueue_op_key_t *op_key,
+                                     const void *data,
+                                     pj_ssize_t *length,
+                                     unsigned flags)
+{
+    PJ_ASSERT_RETURN(key && op_key && data && length, PJ_EINVAL);
+    PJ_CHECK_STACK();
+
+    /* Check if key is closing. */
+    if (IS_CLOSING(key))
+        return PJ_ECANCELLED;
+
+    /* We can not use PJ_IOQUEUE_ALWAYS_ASYNC for socket write. */
+    flags &= ~(PJ_IOQUEUE_ALWAYS_ASYNC);
+
+    return start_write(key, op_key, PJ_IOQUEUE_OP_SEND, data, length,
+                       flags, NULL, 0);
+}
+
+/*
+ * pj_ioqueue_sendto()
+ *
+ * Start asynchronous write() to the descriptor.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_sendto( pj_ioqueue_key_t *key,
+                                       pj_ioqueue_op_key_t *op_key,
+                                       const void *data,
+                                       pj_ssize_t *length,
+                                       pj_uint32_t flags,
+                                       const pj_sockaddr_t *addr,
+                                       int addrlen)
+{
+    PJ_ASSERT_RETURN(key && op_key && data && length, PJ_EINVAL);
+    PJ_CHECK_STACK();
+
+    /* Check if key is closing. */
+    if (IS_CLOSING(key))
+        return PJ_ECANCELLED;
+
+    /* We can not use PJ_IOQUEUE_ALWAYS_ASYNC for socket write */
+    flags &= ~(PJ_IOQUEUE_ALWAYS_ASYNC);
+
+    /*
+     * Check that address storage can hold the address parameter.
+     */
+    PJ_ASSERT_RETURN(addrlen <= (int)sizeof(pj_sockaddr), PJ_EBUG);
+
+    return start_write(key, op_key, PJ_IOQUEUE_OP_SEND_TO, data, length,
+                       flags, addr, addrlen);
+}
+
+/*
+ * pj_ioqueue_sendto_batch()
+ *
+ * Send several datagrams immediately.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_sendto_batch( pj_ioqueue_key_t *key,
+                                             pj_sock_sendto_msg msg[],
+                                             unsigned *count,
+                                             pj_uint32_t flags)
+{
+    PJ_ASSERT_RETURN(key && msg && count, PJ_EINVAL);
+    PJ_CHECK_STACK();
+
+    /* Check if key is closing. */
+    if (IS_CLOSING(key)) {
+        *count = 0;
+        return PJ_ECANCELLED;
+    }
+
+    /* Don't overtake pending writes (see start_write()) */
+    if (!pj_list_empty(&key->write_list)) {
+        *count = 0;
+        return PJ_EBUSY;
+    }
+
+    flags &= ~(PJ_IOQUEUE_ALWAYS_ASYNC);
+
+    return pj_sock_sendto_batch(key->fd, msg, count, flags);
+}
+
+#if PJ_HAS_TCP
+/*
+ * Initiate overlapped accept() operation.
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_accept( pj_ioqueue_key_t *key,
+                                       pj_ioqueue_op_key_t *op_key,
+                                       pj_sock_t *new_sock,
+                                       pj_sockaddr_t *local,
+                                       pj_sockaddr_t *remote,
+                                       int *addrlen)
+{
+    struct uring_op_key *op;
+    struct uring_req *req;
+
+    /* check parameters. All must be specified! */
+    PJ_ASSERT_RETURN(key && op_key && new_sock, PJ_EINVAL);
+
+    /* Check if key is closing. */
+    if (IS_CLOSING(key))
+        return PJ_ECANCELLED;
+
+    op = (struct uring_op_key*)op_key;
+    PJ_ASSERT_RETURN(op->op == PJ_IOQUEUE_OP_NONE, PJ_EPENDING);
+
+    req = alloc_req(key->ioqueue);
+    if (!req)
+        return PJ_ENOMEM;
+
+    req->op = PJ_IOQUEUE_OP_ACCEPT;
+    req->accept_fd = new_sock;
+    req->local_addr = local;
+    req->rmt_addr = remote;
+    req->rmt_addrlen = addrlen;
+    if (!addrlen) {
+        req->local_addr = NULL;
+        req->rmt_addr = NULL;
+    }
+
+    return start_req(key, op_key, req, &key->accept_list);
+}
+
+/*
+ * Initiate overlapped connect() operation (well, it's non-blocking actually,
+ * the completion is detected by polling the socket for writability).
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_connect( pj_ioqueue_key_t *key,
+                                        const pj_sockaddr_t *addr,
+                                        int addrlen )
+{
+    struct uring_req *req;
+    pj_status_t status;
+
+    /* check parameters. All must be specified! */
+    PJ_ASSERT_RETURN(key && addr && addrlen, PJ_EINVAL);
+
+    /* Check if key is closing. */
+    if (IS_CLOSING(key))
+        return PJ_ECANCELLED;
+
+    /* Check if socket has not been marked for connecting */
+    if (key->connect_req != NULL)
+        return PJ_EPENDING;
+
+    /* Non-blocking connect() completes immediately for datagram sockets
+     * and often for loopback, otherwise wait for writability.
+     */
+    status = pj_sock_connect(key->fd, addr, addrlen);
+    if (status == PJ_SUCCESS) {
+        /* Connected! */
+        return PJ_SUCCESS;
+    } else if (status != PJ_STATUS_FROM_OS(PJ_BLOCKING_CONNECT_ERROR_VAL)) {
+        /* Error! */
+        return status;
+    }
+
+    req = alloc_req(key->ioqueue);
+    if (!req)
+        return PJ_ENOMEM;
+
+    req->op = PJ_IOQUEUE_OP_CONNECT;
+
+    pj_ioqueue_lock_key(key);
+    /* Check again. Handle may have been closed after the previous
+     * check in multithreaded app. See #913
+     */
+    if (IS_CLOSING(key) || key->connect_req) {
+        status = IS_CLOSING(key) ? PJ_ECANCELLED : PJ_EPENDING;
+        pj_ioqueue_unlock_key(key);
+        free_req(key->ioqueue, req);
+        return status;
+    }
+
+    req->key = key;
+    status = submit_req(key, req);
+    if (status != PJ_SUCCESS) {
+        pj_ioqueue_unlock_key(key);
+        free_req(key->ioqueue, req);
+        return status;
+    }
+    key->connect_req = req;
+    pj_ioqueue_unlock_key(key);
+
+    return PJ_EPENDING;
+}
+#endif  /* PJ_HAS_TCP */
+
+
+PJ_DEF(void) pj_ioqueue_op_key_init( pj_ioqueue_op_key_t *op_key,
+                                     pj_size_t size )
+{
+    pj_bzero(op_key, size);
+}
+
+
+/*
+ * pj_ioqueue_is_pending()
+ */
+PJ_DEF(pj_bool_t) pj_ioqueue_is_pending( pj_ioqueue_key_t *key,
+                                         pj_ioqueue_op_key_t *op_key )
+{
+    struct uring_op_key *op = (struct uring_op_key*)op_key;
+
+    PJ_UNUSED_ARG(key);
+
+    return op->op != PJ_IOQUEUE_OP_NONE;
+}
+
+
+/*
+ * pj_ioqueue_post_completion()
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_post_completion( pj_ioqueue_key_t *key,
+                                                pj_ioqueue_op_key_t *op_key,
+                                                pj_ssize_t bytes_status )
+{
+    struct uring_op_key *op = (struct uring_op_key*)op_key;
+    struct uring_req *req;
+    pj_ioqueue_operation_e op_type;
+
+    PJ_ASSERT_RETURN(key && op_key, PJ_EINVAL);
+
+    pj_ioqueue_lock_key(key);
+
+    req = op->req;
+    if (op->op == PJ_IOQUEUE_OP_NONE || !req || req->key != key ||
+        req->op_key != op_key)
+    {
+        /* Clear connecting operation. */
+        if (key->connect_req) {
+            key->connect_req->detached = PJ_TRUE;
+            cancel_req(key->ioqueue, key->connect_req);
+            key->connect_req = NULL;
+        }
+        pj_ioqueue_unlock_key(key);
+        return PJ_EINVALIDOP;
+    }
+
+    op_type = req->op;
+    detach_req(key, req);
+
+    /* Start the next queued operation on stream socket */
+    if (key->fd_type == pj_SOCK_STREAM()) {
+        if (op_type == PJ_IOQUEUE_OP_RECV || op_type == PJ_IOQUEUE_OP_RECV_FROM)
+            submit_next(key, &key->read_list);
+        else if (op_type == PJ_IOQUEUE_OP_SEND ||
+                 op_type == PJ_IOQUEUE_OP_SEND_TO)
+            submit_next(key, &key->write_list);
+    }
+
+    pj_ioqueue_unlock_key(key);
+
+    switch (op_type) {
+    case PJ_IOQUEUE_OP_RECV:
+    case PJ_IOQUEUE_OP_RECV_FROM:
+        if (key->cb.on_read_complete)
+            (*key->cb.on_read_complete)(key, op_key, bytes_status);
+        break;
+    case PJ_IOQUEUE_OP_SEND:
+    case PJ_IOQUEUE_OP_SEND_TO:
+        if (key->cb.on_write_complete)
+            (*key->cb.on_write_complete)(key, op_key, bytes_status);
+        break;
+#if PJ_HAS_TCP
+    case PJ_IOQUEUE_OP_ACCEPT:
+        if (key->cb.on_accept_complete) {
+            (*key->cb.on_accept_complete)(key, op_key,
+                                          PJ_INVALID_SOCKET,
+                                          (pj_status_t)bytes_status);
+        }
+        break;
+#endif
+    default:
+        break;
+    }
+
+    return PJ_SUCCESS;
+}
+
+
+PJ_DEF(pj_status_t) pj_ioqueue_clear_key( pj_ioqueue_key_t *key )
+{
+    PJ_ASSERT_RETURN(key, PJ_EINVAL);
+
+    pj_ioqueue_lock_key(key);
+    detach_all_req(key);
+    pj_ioqueue_unlock_key(key);
+
+    return PJ_SUCCESS;
+}
+
+
+PJ_DEF(pj_status_t) pj_ioqueue_set_default_concurrency( pj_ioqueue_t *ioqueue,
+                                                        pj_bool_t allow)
+{
+    PJ_ASSERT_RETURN(ioqueue != NULL, PJ_EINVAL);
+    ioqueue->cfg.default_concurrency = allow;
+    return PJ_SUCCESS;
+}
+
+
+PJ_DEF(pj_status_t) pj_ioqueue_set_concurrency(pj_ioqueue_key_t *key,
+                                               pj_bool_t allow)
+{
+    PJ_ASSERT_RETURN(key, PJ_EINVAL);
+    key->allow_concurrent = allow;
+    return PJ_SUCCESS;
+}
+
+PJ_DEF(pj_status_t) pj_ioqueue_lock_key(pj_ioqueue_key_t *key)
+{
+    if (key->grp_lock)
+        return pj_grp_lock_acquire(key->grp_lock);
+    else
+        return pj_lock_acquire(key->lock);
+}
+
+PJ_DEF(pj_status_t) pj_ioqueue_trylock_key(pj_ioqueue_key_t *key)
+{
+    if (key->grp_lock)
+        return pj_grp_lock_tryacquire(key->grp_lock);
+    else
+        return pj_lock_tryacquire(key->lock);
+}
+
+PJ_DEF(pj_status_t) pj_ioqueue_unlock_key(pj_ioqueue_key_t *key)
+{
+    if (key->grp_lock)
+        return pj_grp_lock_release(key->grp_lock);
+    else
+        return pj_lock_release(key->lock);
+}
+
+PJ_DEF(pj_oshandle_t) pj_ioqueue_get_os_handle( pj_ioqueue_t *ioqueue )
+{
+    return ioqueue ? (pj_oshandle_t)&ioqueue->ring_fd : NULL;
+}
+
+#endif /* PJ_IOQUEUE_IMP == PJ_IOQUEUE_IMP_URING */
@@ -1415,6 +1415,28 @@ PJ_DEF(pj_status_t) pj_ioqueue_sendto( pj_ioqueue_key_t *key,
     return PJ_EPENDING;
 }
 
+/*
+ * pj_ioqueue_sendto_batch()
+ */
+PJ_DEF(pj_status_t) pj_ioqueue_sendto_batch( pj_ioqueue_key_t *key,
+                                             pj_sock_sendto_msg msg[],
+                                             unsigned *count,
+                                             pj_uint32_t flags)
+{
+    PJ_CHECK_STACK();
+    PJ_ASSERT_RETURN(key && msg && count, PJ_EINVAL);
+
+    /* Check key is not closing */
+    if (key->closing) {
+        *count = 0;
+        return PJ_ECANCELLED;
+    }
+
+    flags &= ~(PJ_IOQUEUE_ALWAYS_ASYNC);
+
+    return pj_sock_sendto_batch((pj_sock_t)key->hnd, msg, count, flags);
+}
+
 #if PJ_HAS_TCP
 
 /*
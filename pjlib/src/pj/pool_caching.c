@@ -24,6 +24,7 @@
 #include <pj/lock.h>
 #include <pj/os.h>
 #include <pj/pool_buf.h>
+#include <pj/errno.h>
 
 #if !PJ_HAS_POOL_ALT_API
 
@@ -50,6 +51,38 @@ static pj_size_t pool_sizes[PJ_CACHING_POOL_ARRAY_SIZE] =
  */
 #define START_SIZE  5
 
+/* Flag in pool's factory_data to indicate that the pool was created from
+ * per-thread cache and is not in the used list.
+ */
+#define THREAD_CACHED               0x10000
+
+/* Number of create/release operations in a thread before its cache is
+ * rebalanced, i.e: pools which have not been used since the previous
+ * rebalancing are partly moved back to the shared free list.
+ */
+#define THREAD_CACHE_REBALANCE_CNT  1024
+
+/* Per-thread cache of released pools. It is only accessed by its owner
+ * thread, except when the caching pool is destroyed.
+ */
+typedef struct thread_cache
+{
+    PJ_DECL_LIST_MEMBER(struct thread_cache);
+
+    /* Released pools, indexed by pool size */
+    pj_list     free_list[PJ_CACHING_POOL_ARRAY_SIZE];
+
+    /* Number of pools in each free list */
+    unsigned    cnt[PJ_CACHING_POOL_ARRAY_SIZE];
+
+    /* Lowest number of pools in each free list since last rebalancing */
+    unsigned    low_cnt[PJ_CACHING_POOL_ARRAY_SIZE];
+
+    /* Number of operations since last rebalancing */
+    unsigned    op_cnt;
+
+} thread_cache;
+
 
 PJ_DEF(void) pj_caching_pool_init( pj_caching_pool *cp, 
                                    const pj_pool_factory_policy *policy,
@@ -67,6 +100,8 @@ PJ_DEF(void) pj_caching_pool_init( pj_caching_pool *cp,
     pj_list_init(&cp->used_list);
     for (i=0; i<PJ_CACHING_POOL_ARRAY_SIZE; ++i)
         pj_list_init(&cp->free_list[i]);
+    cp->thread_cache_id = -1;
+    pj_list_init(&cp->thread_cache_list);
 
     if (policy == NULL) {
         policy = &pj_pool_factory_default_policy;
@@ -90,6 +125,29 @@ PJ_DEF(void) pj_caching_pool_init( pj_caching_pool *cp,
     /* This mostly serves to silent coverity warning about unchecked 
      * return value. There's not much we can do if it fails. */
     PJ_ASSERT_ON_FAIL(status==PJ_SUCCESS, return);
+
+#if PJ_CACHING_POOL_THREAD_CACHE_SIZE
+    pj_caching_pool_set_thread_cache(cp, PJ_CACHING_POOL_THREAD_CACHE_SIZE);
+#endif
+}
+
+PJ_DEF(pj_status_t) pj_caching_pool_set_thread_cache(pj_caching_pool *cp,
+                                                     unsigned size)
+{
+    PJ_ASSERT_RETURN(cp, PJ_EINVAL);
+
+    /* Pools must not have been created */
+    PJ_ASSERT_RETURN(cp->used_count == 0 &&
+                     pj_list_empty(&cp->thread_cache_list), PJ_EINVALIDOP);
+
+    if (size && cp->thread_cache_id == -1) {
+        pj_status_t status = pj_thread_local_alloc(&cp->thread_cache_id);
+        if (status != PJ_SUCCESS)
+            return status;
+    }
+    cp->thread_cache_size = size;
+
+    return PJ_SUCCESS;
 }
 
 PJ_DEF(void) pj_caching_pool_destroy( pj_caching_pool *cp )
@@ -99,6 +157,26 @@ PJ_DEF(void) pj_caching_pool_destroy( pj_caching_pool *cp )
 
     PJ_CHECK_STACK();
 
+    /* Delete all per-thread caches */
+    while (!pj_list_empty(&cp->thread_cache_list)) {
+        thread_cache *tc = (thread_cache*)cp->thread_cache_list.next;
+
+        pj_list_erase(tc);
+        for (i=0; i < PJ_CACHING_POOL_ARRAY_SIZE; ++i) {
+            while (!pj_list_empty(&tc->free_list[i])) {
+                pool = (pj_pool_t*) tc->free_list[i].next;
+                pj_list_erase(pool);
+                pj_pool_destroy_int(pool);
+            }
+        }
+        (*cp->factory.policy.block_free)(&cp->factory, tc, sizeof(*tc));
+    }
+    if (cp->thread_cache_id != -1) {
+        pj_thread_local_free(cp->thread_cache_id);
+        cp->thread_cache_id = -1;
+    }
+    cp->thread_cache_size = 0;
+
     /* Delete all pool in free list */
     for (i=0; i < PJ_CACHING_POOL_ARRAY_SIZE; ++i) {
         pj_pool_t *next;
@@ -127,26 +205,13 @@ PJ_DEF(void) pj_caching_pool_destroy( pj_caching_pool *cp )
     }
 }
 
-static pj_pool_t* cpool_create_pool(pj_pool_factory *pf, 
-                                    const char *name, 
-                                    pj_size_t initial_size, 
-                                    pj_size_t increment_sz,
-                                    pj_size_t alignment,
-                                    pj_pool_callback *callback)
+/* Get the index of the pool size in pool_sizes[], or
+ * PJ_CACHING_POOL_ARRAY_SIZE if the size is too large to be cached.
+ */
+static int get_size_index(pj_size_t initial_size)
 {
-    pj_caching_pool *cp = (pj_caching_pool*)pf;
-    pj_pool_t *pool;
     int idx;
 
-    PJ_CHECK_STACK();
-
-    pj_lock_acquire(cp->lock);
-
-    /* Use pool factory's policy when callback is NULL */
-    if (callback == NULL) {
-        callback = pf->policy.callback;
-    }
-
     /* Search the suitable size for the pool. 
      * We'll just do linear search to the size array, as the array size itself
      * is only a few elements. Binary search I suspect will be less efficient
@@ -166,6 +231,244 @@ static pj_pool_t* cpool_create_pool(pj_pool_factory *pf,
             ;
     }
 
+    return idx;
+}
+
+/* Get the cache of the calling thread, create one if it doesn't exist. */
+static thread_cache *get_thread_cache(pj_caching_pool *cp)
+{
+    thread_cache *tc;
+    unsigned i;
+
+    tc = (thread_cache*) pj_thread_local_get(cp->thread_cache_id);
+    if (tc)
+        return tc;
+
+    tc = (thread_cache*)
+         (*cp->factory.policy.block_alloc)(&cp->factory, sizeof(*tc));
+    if (!tc)
+        return NULL;
+
+    pj_bzero(tc, sizeof(*tc));
+    for (i=0; i < PJ_CACHING_POOL_ARRAY_SIZE; ++i)
+        pj_list_init(&tc->free_list[i]);
+
+    if (pj_thread_local_set(cp->thread_cache_id, tc) != PJ_SUCCESS) {
+        (*cp->factory.policy.block_free)(&cp->factory, tc, sizeof(*tc));
+        return NULL;
+    }
+
+    pj_lock_acquire(cp->lock);
+    pj_list_push_back(&cp->thread_cache_list, tc);
+    pj_lock_release(cp->lock);
+
+    return tc;
+}
+
+/* Move the oldest pools from the thread cache to the shared free list.
+ * Caller must hold the caching pool lock.
+ */
+static void thread_cache_flush(pj_caching_pool *cp, thread_cache *tc,
+                               unsigned idx, unsigned cnt)
+{
+    while (cnt-- && tc->cnt[idx]) {
+        pj_pool_t *pool = (pj_pool_t*) tc->free_list[idx].prev;
+        pj_size_t pool_capacity = pj_pool_get_capacity(pool);
+
+        pj_list_erase(pool);
+        --tc->cnt[idx];
+
+        if (cp->capacity + pool_capacity > cp->max_capacity) {
+            pj_pool_destroy_int(pool);
+        } else {
+            pool->factory_data = (void*) (pj_ssize_t) idx;
+            pj_list_insert_after(&cp->free_list[idx], pool);
+            cp->capacity += pool_capacity;
+        }
+    }
+
+    if (tc->low_cnt[idx] > tc->cnt[idx])
+        tc->low_cnt[idx] = tc->cnt[idx];
+}
+
+/* Count an operation on the thread cache, and once in a while return the
+ * pools which have not been needed during the last period to the shared
+ * free list, so idle pools don't stay in one thread.
+ */
+static void thread_cache_tick(pj_caching_pool *cp, thread_cache *tc)
+{
+    pj_bool_t locked = PJ_FALSE;
+    unsigned i;
+
+    if (++tc->op_cnt < THREAD_CACHE_REBALANCE_CNT)
+        return;
+
+    tc->op_cnt = 0;
+    for (i=0; i < PJ_CACHING_POOL_ARRAY_SIZE; ++i) {
+        unsigned cnt = (tc->low_cnt[i] + 1) / 2;
+
+        if (cnt) {
+            if (!locked) {
+                pj_lock_acquire(cp->lock);
+                locked = PJ_TRUE;
+            }
+            thread_cache_flush(cp, tc, i, cnt);
+        }
+        tc->low_cnt[i] = tc->cnt[i];
+    }
+    if (locked)
+        pj_lock_release(cp->lock);
+}
+
+/* Create pool from the thread cache. Returns NULL if the shared path
+ * should be used instead.
+ */
+static pj_pool_t *thread_cache_create_pool(pj_caching_pool *cp,
+                                           unsigned idx,
+                                           const char *name,
+                                           pj_size_t increment_sz,
+                                           pj_size_t alignment,
+                                           pj_pool_callback *callback)
+{
+    thread_cache *tc;
+    pj_pool_t *pool;
+
+    tc = get_thread_cache(cp);
+    if (!tc)
+        return NULL;
+
+    if (tc->cnt[idx] == 0) {
+        /* Refill half of the thread cache from the shared free list */
+        unsigned cnt = (cp->thread_cache_size + 1) / 2;
+
+        pj_lock_acquire(cp->lock);
+        while (cnt-- && !pj_list_empty(&cp->free_list[idx])) {
+            pool = (pj_pool_t*) cp->free_list[idx].next;
+            pj_list_erase(pool);
+            if (cp->capacity > pj_pool_get_capacity(pool)) {
+                cp->capacity -= pj_pool_get_capacity(pool);
+            } else {
+                cp->capacity = 0;
+            }
+            pj_list_push_back(&tc->free_list[idx], pool);
+            ++tc->cnt[idx];
+        }
+        pj_lock_release(cp->lock);
+    }
+
+    if (tc->cnt[idx]) {
+        pool = (pj_pool_t*) tc->free_list[idx].next;
+        pj_list_erase(pool);
+        --tc->cnt[idx];
+        if (tc->low_cnt[idx] > tc->cnt[idx])
+            tc->low_cnt[idx] = tc->cnt[idx];
+
+        pj_pool_init_int(pool, name, increment_sz, alignment, callback);
+
+        PJ_LOG(6, (pool->obj_name, "pool reused from thread cache, size=%lu",
+                   (unsigned long)pool->capacity));
+    } else {
+        pool = pj_pool_create_int(&cp->factory, name, pool_sizes[idx],
+                                  increment_sz, alignment, callback);
+        if (!pool)
+            return NULL;
+    }
+
+    /* The pool is not in the used list */
+    pj_list_init(pool);
+    pool->factory_data = (void*) (pj_ssize_t) (idx | THREAD_CACHED);
+
+    thread_cache_tick(cp, tc);
+
+    return pool;
+}
+
+/* Release pool created from a thread cache to the calling thread's cache.
+ * Returns PJ_FALSE if the shared path should be used instead.
+ */
+static pj_bool_t thread_cache_release_pool(pj_caching_pool *cp,
+                                           pj_pool_t *pool,
+                                           unsigned idx)
+{
+    thread_cache *tc;
+
+    tc = get_thread_cache(cp);
+    if (!tc)
+        return PJ_FALSE;
+
+    if (pj_pool_get_capacity(pool) > pool_sizes[PJ_CACHING_POOL_ARRAY_SIZE-1])
+    {
+        pj_pool_destroy_int(pool);
+        return PJ_TRUE;
+    }
+
+    pj_pool_reset(pool);
+
+    /* Move half of the full cache to the shared free list */
+    if (tc->cnt[idx] >= cp->thread_cache_size) {
+        pj_lock_acquire(cp->lock);
+        thread_cache_flush(cp, tc, idx,
+                           tc->cnt[idx] - cp->thread_cache_size / 2);
+        pj_lock_release(cp->lock);
+    }
+
+    pj_list_insert_after(&tc->free_list[idx], pool);
+    ++tc->cnt[idx];
+
+    thread_cache_tick(cp, tc);
+
+    return PJ_TRUE;
+}
+
+PJ_DEF(void) pj_caching_pool_flush_thread_cache(pj_caching_pool *cp)
+{
+    thread_cache *tc;
+    unsigned i;
+
+    PJ_ASSERT_ON_FAIL(cp, return);
+
+    if (!cp->thread_cache_size)
+        return;
+
+    tc = (thread_cache*) pj_thread_local_get(cp->thread_cache_id);
+    if (!tc)
+        return;
+
+    pj_lock_acquire(cp->lock);
+    for (i=0; i < PJ_CACHING_POOL_ARRAY_SIZE; ++i)
+        thread_cache_flush(cp, tc, i, tc->cnt[i]);
+    pj_lock_release(cp->lock);
+}
+
+static pj_pool_t* cpool_create_pool(pj_pool_factory *pf, 
+                                    const char *name, 
+                                    pj_size_t initial_size, 
+                                    pj_size_t increment_sz,
+                                    pj_size_t alignment,
+                                    pj_pool_callback *callback)
+{
+    pj_caching_pool *cp = (pj_caching_pool*)pf;
+    pj_pool_t *pool;
+    int idx;
+
+    PJ_CHECK_STACK();
+
+    /* Use pool factory's policy when callback is NULL */
+    if (callback == NULL) {
+        callback = pf->policy.callback;
+    }
+
+    idx = get_size_index(initial_size);
+
+    if (cp->thread_cache_size && idx < PJ_CACHING_POOL_ARRAY_SIZE) {
+        pool = thread_cache_create_pool(cp, idx, name, increment_sz,
+                                        alignment, callback);
+        if (pool)
+            return pool;
+    }
+
+    pj_lock_acquire(cp->lock);
+
     /* Check whether there's a pool in the list. */
     if (idx==PJ_CACHING_POOL_ARRAY_SIZE || pj_list_empty(&cp->free_list[idx])) {
         /* No pool is available. */
@@ -223,6 +526,31 @@ static void cpool_release_pool( pj_pool_factory *pf, pj_pool_t *pool)
 
     PJ_ASSERT_ON_FAIL(pf && pool, return);
 
+    i = (unsigned) (unsigned long) (pj_ssize_t) pool->factory_data;
+    if (i & THREAD_CACHED) {
+        i &= ~THREAD_CACHED;
+        pj_assert(i < PJ_CACHING_POOL_ARRAY_SIZE);
+
+        if (cp->thread_cache_size &&
+            thread_cache_release_pool(cp, pool, i))
+        {
+            return;
+        }
+
+        /* Put to the shared free list */
+        pj_pool_reset(pool);
+        pj_lock_acquire(cp->lock);
+        if (cp->capacity + pj_pool_get_capacity(pool) > cp->max_capacity) {
+            pj_pool_destroy_int(pool);
+        } else {
+            pool->factory_data = (void*) (pj_ssize_t) i;
+            pj_list_insert_after(&cp->free_list[i], pool);
+            cp->capacity += pj_pool_get_capacity(pool);
+        }
+        pj_lock_release(cp->lock);
+        return;
+    }
+
     pj_lock_acquire(cp->lock);
 
 #if PJ_SAFE_POOL
@@ -294,6 +622,13 @@ static void cpool_dump_status(pj_pool_factory *factory, pj_bool_t detail )
     PJ_LOG(3,("cachpool", "   Capacity=%lu, max_capacity=%lu, used_cnt=%lu",
               (unsigned long)cp->capacity, (unsigned long)cp->max_capacity,
               (unsigned long)cp->used_count));
+    if (cp->thread_cache_size) {
+        PJ_LOG(3,("cachpool", "   Thread caches=%lu, size=%u (pools "
+                              "created from thread caches are not "
+                              "listed)",
+                  (unsigned long)pj_list_size(&cp->thread_cache_list),
+                  cp->thread_cache_size));
+    }
     if (detail) {
         pj_pool_t *pool = (pj_pool_t*) cp->used_list.next;
         pj_size_t total_used = 0, total_capacity = 0;
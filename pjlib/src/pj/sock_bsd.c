@@ -16,6 +16,9 @@
  * along with this program; if not, write to the Free Software
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA 
  */
+#ifndef _GNU_SOURCE
+#   define _GNU_SOURCE      /* for sendmmsg() */
+#endif
 #include <pj/sock.h>
 #include <pj/os.h>
 #include <pj/assert.h>
@@ -758,6 +761,94 @@ PJ_DEF(pj_status_t) pj_sock_sendto(pj_sock_t sock,
         return PJ_SUCCESS;
 }
 
+/*
+ * Send several datagrams.
+ */
+PJ_DEF(pj_status_t) pj_sock_sendto_batch(pj_sock_t sock,
+                                         pj_sock_sendto_msg msg[],
+                                         unsigned *count,
+                                         unsigned flags)
+{
+#if defined(PJ_LINUX) && PJ_LINUX!=0
+    enum { MAX_BATCH = 64 };
+    struct mmsghdr hdr[MAX_BATCH];
+    struct iovec iov[MAX_BATCH];
+    unsigned total = 0;
+#else
+    unsigned i;
+#endif
+
+    PJ_CHECK_STACK();
+    PJ_ASSERT_RETURN(msg && count, PJ_EINVAL);
+
+#ifdef MSG_NOSIGNAL
+    /* Suppress SIGPIPE. See https://github.com/pjsip/pjproject/issues/1538 */
+    flags |= MSG_NOSIGNAL;
+#endif
+
+#if defined(PJ_LINUX) && PJ_LINUX!=0
+    while (total < *count) {
+        unsigned i, cnt = *count - total;
+        int sent;
+
+        if (cnt > MAX_BATCH)
+            cnt = MAX_BATCH;
+
+        pj_bzero(hdr, cnt * sizeof(hdr[0]));
+        for (i=0; i<cnt; ++i) {
+            pj_sock_sendto_msg *m = &msg[total + i];
+
+            CHECK_ADDR_LEN(m->addr, m->addr_len);
+
+            iov[i].iov_base = (void*)m->buf;
+            iov[i].iov_len = m->len;
+            hdr[i].msg_hdr.msg_name = (void*)m->addr;
+            hdr[i].msg_hdr.msg_namelen = m->addr_len;
+            hdr[i].msg_hdr.msg_iov = &iov[i];
+            hdr[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        sent = sendmmsg(sock, hdr, cnt, flags);
+        if (sent < 0) {
+            if (total == 0) {
+                *count = 0;
+                return PJ_RETURN_OS_ERROR(pj_get_native_netos_error());
+            }
+            break;
+        }
+
+        for (i=0; i<(unsigned)sent; ++i)
+            msg[total + i].len = hdr[i].msg_len;
+
+        total += sent;
+        if ((unsigned)sent < cnt)
+            break;
+    }
+
+    *count = total;
+    return PJ_SUCCESS;
+
+#else
+    for (i=0; i<*count; ++i) {
+        pj_sock_sendto_msg *m = &msg[i];
+        pj_status_t status;
+
+        status = pj_sock_sendto(sock, m->buf, &m->len, flags,
+                                m->addr, m->addr_len);
+        if (status != PJ_SUCCESS) {
+            if (i == 0) {
+                *count = 0;
+                return status;
+            }
+            break;
+        }
+    }
+
+    *count = i;
+    return PJ_SUCCESS;
+#endif
+}
+
 /*
  * Receive data.
  */
@@ -715,6 +715,39 @@ PJ_DEF(pj_status_t) pj_sock_sendto(pj_sock_t sock,
         return PJ_RETURN_OS_ERROR(reqStatus.Int());
 }
 
+/*
+ * Send several datagrams, one at a time.
+ */
+PJ_DEF(pj_status_t) pj_sock_sendto_batch(pj_sock_t sock,
+                                         pj_sock_sendto_msg msg[],
+                                         unsigned *count,
+                                         unsigned flags)
+{
+    unsigned i;
+
+    PJ_CHECK_STACK();
+    PJ_ASSERT_RETURN(msg && count, PJ_EINVAL);
+
+    for (i=0; i<*count; ++i) {
+        pj_sock_sendto_msg *m = &msg[i];
+        pj_status_t status;
+
+        status = pj_sock_sendto(sock, m->buf, &m->len, flags,
+                                m->addr, m->addr_len);
+        if (status != PJ_SUCCESS) {
+            if (i == 0) {
+                *count = 0;
+                return status;
+            }
+            break;
+        }
+    }
+
+    *count = i;
+    return PJ_SUCCESS;
+}
+
+
 /*
  * Receive data.
  */
@@ -693,6 +693,17 @@ pj_status_t pj_ssl_sock_ossl_test_send_buf(pj_pool_t *pool)
 }
 #endif
 
+/* Check if the handshake is performed by the handshake worker threads */
+static pj_bool_t use_hs_worker(pj_ssl_sock_t *ssock)
+{
+#ifdef SSL_SOCK_IMP_USE_HS_WORKER
+    return ssock->param.async_handshake && ssock->param.grp_lock;
+#else
+    PJ_UNUSED_ARG(ssock);
+    return PJ_FALSE;
+#endif
+}
+
 static void on_timer(pj_timer_heap_t *th, struct pj_timer_entry *te)
 {
     pj_ssl_sock_t *ssock = (pj_ssl_sock_t*)te->user_data;
@@ -707,7 +718,16 @@ static void on_timer(pj_timer_heap_t *th, struct pj_timer_entry *te)
         PJ_LOG(1,(ssock->pool->obj_name, "SSL timeout after %ld.%lds",
                   ssock->param.timeout.sec, ssock->param.timeout.msec));
 
-        on_handshake_complete(ssock, PJ_ETIMEDOUT);
+        /* Wait for the running handshake step of the handshake worker, as
+         * the socket is reset on the failure.
+         */
+        if (use_hs_worker(ssock)) {
+            pj_grp_lock_acquire(ssock->param.grp_lock);
+            on_handshake_complete(ssock, PJ_ETIMEDOUT);
+            pj_grp_lock_release(ssock->param.grp_lock);
+        } else {
+            on_handshake_complete(ssock, PJ_ETIMEDOUT);
+        }
         break;
     case TIMER_CLOSE:
         pj_ssl_sock_close(ssock);
@@ -741,6 +761,260 @@ static void ssl_on_destroy(void *arg)
 }
 
 
+#ifdef SSL_SOCK_IMP_USE_HS_WORKER
+/*
+ *******************************************************************
+ * Handshake worker threads.
+ *******************************************************************
+ */
+
+/* Handshake worker threads, shared by all SSL sockets */
+static struct hs_worker
+{
+    pj_caching_pool      cp;
+    pj_pool_t           *pool;
+    pj_lock_t           *lock;
+    pj_sem_t            *sem;
+    pj_bool_t            quit;
+    unsigned             thread_cnt;
+    pj_thread_t         *thread[PJ_SSL_SOCK_HANDSHAKE_THREAD_CNT];
+    hs_job_t             queue;
+} hs_worker;
+
+/* Run handshake job of an SSL socket, the job holds a reference of the
+ * socket group lock.
+ *
+ * Each handshake step runs on the socket group lock, which serializes it
+ * with the network callbacks, the handshake timer, and closing the socket.
+ * The ioqueue only tries to lock the key when dispatching events, so the
+ * polling thread is not blocked by a running step, the events of this
+ * socket are just dispatched after the step.
+ */
+static void hs_job_run(pj_ssl_sock_t *ssock)
+{
+    pj_status_t status;
+    pj_bool_t again;
+
+    do {
+        pj_grp_lock_acquire(ssock->param.grp_lock);
+        if (ssock->ssl_state == SSL_STATE_HANDSHAKING && !ssock->is_closing)
+        {
+            status = ssl_do_handshake(ssock);
+            if (status != PJ_EPENDING)
+                on_handshake_complete(ssock, status);
+        } else {
+            status = PJ_ECANCELLED;
+        }
+        pj_grp_lock_release(ssock->param.grp_lock);
+
+        /* Run again if more handshake data arrived in the meantime */
+        pj_lock_acquire(hs_worker.lock);
+        again = (status == PJ_EPENDING && ssock->hs_job.again);
+        ssock->hs_job.again = PJ_FALSE;
+        if (!again)
+            ssock->hs_job.state = HS_JOB_IDLE;
+        pj_lock_release(hs_worker.lock);
+    } while (again);
+
+    pj_grp_lock_dec_ref(ssock->param.grp_lock);
+}
+
+static int hs_worker_thread(void *arg)
+{
+    PJ_UNUSED_ARG(arg);
+
+    for (;;) {
+        hs_job_t *job;
+
+        pj_sem_wait(hs_worker.sem);
+        if (hs_worker.quit)
+            break;
+
+        pj_lock_acquire(hs_worker.lock);
+        if (pj_list_empty(&hs_worker.queue)) {
+            pj_lock_release(hs_worker.lock);
+            continue;
+        }
+        job = hs_worker.queue.next;
+        pj_list_erase(job);
+        job->state = HS_JOB_RUNNING;
+        pj_lock_release(hs_worker.lock);
+
+        hs_job_run(job->ssock);
+    }
+
+    return 0;
+}
+
+/* Stop handshake worker threads */
+static void hs_worker_destroy(void)
+{
+    unsigned i;
+
+    if (!hs_worker.pool)
+        return;
+
+    hs_worker.quit = PJ_TRUE;
+    for (i = 0; i < hs_worker.thread_cnt; ++i)
+        pj_sem_post(hs_worker.sem);
+
+    for (i = 0; i < hs_worker.thread_cnt; ++i) {
+        pj_thread_join(hs_worker.thread[i]);
+        pj_thread_destroy(hs_worker.thread[i]);
+    }
+    hs_worker.thread_cnt = 0;
+
+    /* Release unprocessed jobs */
+    while (!pj_list_empty(&hs_worker.queue)) {
+        hs_job_t *job = hs_worker.queue.next;
+
+        pj_list_erase(job);
+        job->state = HS_JOB_IDLE;
+        pj_grp_lock_dec_ref(job->ssock->param.grp_lock);
+    }
+
+    if (hs_worker.sem) {
+        pj_sem_destroy(hs_worker.sem);
+        hs_worker.sem = NULL;
+    }
+    if (hs_worker.lock) {
+        pj_lock_destroy(hs_worker.lock);
+        hs_worker.lock = NULL;
+    }
+    pj_pool_release(hs_worker.pool);
+    hs_worker.pool = NULL;
+    pj_caching_pool_destroy(&hs_worker.cp);
+}
+
+/* Start handshake worker threads */
+static pj_status_t hs_worker_init(void)
+{
+    unsigned i;
+    pj_status_t status;
+
+    pj_caching_pool_init(&hs_worker.cp, NULL, 0);
+
+    hs_worker.pool = pj_pool_create(&hs_worker.cp.factory, "ssl-hs",
+                                    512, 512, NULL);
+    if (!hs_worker.pool) {
+        pj_caching_pool_destroy(&hs_worker.cp);
+        return PJ_ENOMEM;
+    }
+
+    hs_worker.quit = PJ_FALSE;
+    pj_list_init(&hs_worker.queue);
+
+    status = pj_lock_create_simple_mutex(hs_worker.pool, "ssl-hs",
+                                         &hs_worker.lock);
+    if (status != PJ_SUCCESS)
+        goto on_error;
+
+    status = pj_sem_create(hs_worker.pool, "ssl-hs", 0, PJ_MAXINT32,
+                           &hs_worker.sem);
+    if (status != PJ_SUCCESS)
+        goto on_error;
+
+    for (i = 0; i < PJ_SSL_SOCK_HANDSHAKE_THREAD_CNT; ++i) {
+        status = pj_thread_create(hs_worker.pool, "ssl-hs%p",
+                                  &hs_worker_thread, NULL, 0, 0,
+                                  &hs_worker.thread[i]);
+        if (status != PJ_SUCCESS)
+            goto on_error;
+        hs_worker.thread_cnt++;
+    }
+
+    status = pj_atexit(&hs_worker_destroy);
+    if (status != PJ_SUCCESS) {
+        PJ_PERROR(1, ("ssl-hs", status, "Warning! Unable to set SSL "
+                      "handshake worker destroy method."));
+    }
+
+    return PJ_SUCCESS;
+
+on_error:
+    hs_worker_destroy();
+    return status;
+}
+
+/* Queue the handshake of an SSL socket to the handshake worker threads */
+static pj_status_t hs_job_schedule(pj_ssl_sock_t *ssock)
+{
+    /* Lazily start the worker threads */
+    if (!hs_worker.pool) {
+        pj_status_t status = PJ_SUCCESS;
+
+        pj_enter_critical_section();
+        if (!hs_worker.pool)
+            status = hs_worker_init();
+        pj_leave_critical_section();
+
+        if (status != PJ_SUCCESS) {
+            PJ_PERROR(2, (ssock->pool->obj_name, status,
+                          "Failed to start SSL handshake worker"));
+            return status;
+        }
+    }
+
+    pj_lock_acquire(hs_worker.lock);
+    switch (ssock->hs_job.state) {
+    case HS_JOB_IDLE:
+        pj_grp_lock_add_ref(ssock->param.grp_lock);
+        ssock->hs_job.ssock = ssock;
+        ssock->hs_job.state = HS_JOB_QUEUED;
+        pj_list_push_back(&hs_worker.queue, &ssock->hs_job);
+        pj_sem_post(hs_worker.sem);
+        break;
+    case HS_JOB_RUNNING:
+        ssock->hs_job.again = PJ_TRUE;
+        break;
+    default:
+        /* Already queued */
+        break;
+    }
+    pj_lock_release(hs_worker.lock);
+
+    return PJ_SUCCESS;
+}
+#endif  /* SSL_SOCK_IMP_USE_HS_WORKER */
+
+/* Perform SSL handshake, on the handshake worker threads when asynchronous
+ * handshake is enabled, in which case PJ_EPENDING is returned and the
+ * handshake is completed by the worker.
+ */
+static pj_status_t do_handshake(pj_ssl_sock_t *ssock)
+{
+#ifdef SSL_SOCK_IMP_USE_HS_WORKER
+    if (use_hs_worker(ssock) && hs_job_schedule(ssock) == PJ_SUCCESS)
+        return PJ_EPENDING;
+#endif
+
+    return ssl_do_handshake(ssock);
+}
+
+/* Check if the initial handshake is still in progress, i.e: its completion
+ * has not been reported yet.
+ */
+static pj_bool_t is_handshaking(pj_ssl_sock_t *ssock)
+{
+    return ssock->ssl_state == SSL_STATE_HANDSHAKING ||
+           (ssock->ssl_state == SSL_STATE_ESTABLISHED &&
+            ssock->handshake_status == PJ_EUNKNOWN);
+}
+
+/* Get the concurrency setting of the active socket. The handshake worker
+ * runs the handshake steps while holding the socket group lock, which is
+ * serialized with the network callbacks only when the ioqueue holds the
+ * lock while calling them, i.e: when concurrency is disabled.
+ */
+static int get_asock_concurrency(pj_ssl_sock_t *ssock)
+{
+    if (use_hs_worker(ssock))
+        return 0;
+
+    return ssock->param.concurrency;
+}
+
+
 /*
  *******************************************************************
  * Network callbacks.
@@ -786,11 +1060,18 @@ static pj_bool_t ssock_on_data_read (pj_ssl_sock_t *ssock,
     }
 
     /* Check if SSL handshake hasn't finished yet */
-    if (ssock->ssl_state == SSL_STATE_HANDSHAKING) {
+    if (is_handshaking(ssock)) {
         pj_bool_t ret = PJ_TRUE;
 
-        if (status == PJ_SUCCESS)
-            status = ssl_do_handshake(ssock);
+        if (status == PJ_SUCCESS) {
+            /* Keep the data until the handshake worker reports the
+             * completion of the established session.
+             */
+            if (ssock->ssl_state != SSL_STATE_HANDSHAKING)
+                return PJ_TRUE;
+
+            status = do_handshake(ssock);
+        }
 
         /* Not pending is either success or failed */
         if (status != PJ_EPENDING)
@@ -891,7 +1172,7 @@ static pj_bool_t ssock_on_data_read (pj_ssl_sock_t *ssock,
     return PJ_TRUE;
 
 on_error:
-    if (ssock->ssl_state == SSL_STATE_HANDSHAKING)
+    if (is_handshaking(ssock))
         return on_handshake_complete(ssock, status);
 
     if (ssock->read_started && ssock->param.cb.on_data_read) {
@@ -928,7 +1209,7 @@ static pj_bool_t ssock_on_data_sent (pj_ssl_sock_t *ssock,
         /* Initial handshaking */
         pj_status_t status;
         
-        status = ssl_do_handshake(ssock);
+        status = do_handshake(ssock);
         /* Not pending is either success or failed */
         if (status != PJ_EPENDING)
             return on_handshake_complete(ssock, status);
@@ -1109,7 +1390,7 @@ static pj_bool_t ssock_on_accept_complete (pj_ssl_sock_t *ssock_parent,
     pj_activesock_cfg_default(&asock_cfg);
     asock_cfg.grp_lock = ssock->param.grp_lock;
     asock_cfg.async_cnt = ssock->param.async_cnt;
-    asock_cfg.concurrency = ssock->param.concurrency;
+    asock_cfg.concurrency = get_asock_concurrency(ssock);
     asock_cfg.whole_data = PJ_TRUE;
 
     pj_bzero(&asock_cb, sizeof(asock_cb));
@@ -1181,7 +1462,7 @@ static pj_bool_t ssock_on_accept_complete (pj_ssl_sock_t *ssock_parent,
         pj_lock_acquire(ssock->circ_buf_input_mutex);
     ssock->ssl_state = SSL_STATE_HANDSHAKING;
     ssl_set_state(ssock, PJ_TRUE);
-    status = ssl_do_handshake(ssock);
+    status = do_handshake(ssock);
     if (ssock->circ_buf_input_mutex)
         pj_lock_release(ssock->circ_buf_input_mutex);
 
@@ -1262,7 +1543,7 @@ static pj_bool_t ssock_on_connect_complete (pj_ssl_sock_t *ssock,
     ssock->ssl_state = SSL_STATE_HANDSHAKING;
     ssl_set_state(ssock, PJ_FALSE);
 
-    status = ssl_do_handshake(ssock);
+    status = do_handshake(ssock);
     if (status != PJ_EPENDING)
         goto on_return;
 
@@ -1555,7 +1836,16 @@ PJ_DEF(pj_status_t) pj_ssl_sock_close(pj_ssl_sock_t *ssock)
         ssock->timer.id = TIMER_NONE;
     }
 
-    ssl_reset_sock_state(ssock);
+    /* Wait for the running handshake step of the handshake worker, the
+     * worker does not start another one once the socket is closing.
+     */
+    if (use_hs_worker(ssock)) {
+        pj_grp_lock_acquire(ssock->param.grp_lock);
+        ssl_reset_sock_state(ssock);
+        pj_grp_lock_release(ssock->param.grp_lock);
+    } else {
+        ssl_reset_sock_state(ssock);
+    }
 
     /* Wipe out cert & key buffer. */
     if (ssock->cert) {
@@ -1628,6 +1918,7 @@ PJ_DEF(pj_status_t) pj_ssl_sock_get_info (pj_ssl_sock_t *ssock,
 
     /* Verification status */
     info->verify_status = ssock->verify_status;
+    info->session_reused = ssock->session_reused;
 
     /* Last known SSL error code */
     info->last_native_err = ssock->last_err;
@@ -2185,7 +2476,7 @@ PJ_DEF(pj_status_t) pj_ssl_sock_start_connect2(
     /* Create active socket */
     pj_activesock_cfg_default(&asock_cfg);
     asock_cfg.async_cnt = ssock->param.async_cnt;
-    asock_cfg.concurrency = ssock->param.concurrency;
+    asock_cfg.concurrency = get_asock_concurrency(ssock);
     asock_cfg.whole_data = PJ_TRUE;
     asock_cfg.grp_lock = ssock->param.grp_lock;
 
@@ -2302,6 +2593,16 @@ PJ_DEF(void) pj_ssl_cert_wipe_keys(pj_ssl_cert_t *cert)
     }
 }
 
+PJ_DEF(pj_status_t) pj_ssl_ctx_cache_flush(void)
+{
+#ifdef SSL_SOCK_IMP_USE_CTX_CACHE
+    ssl_ctx_cache_flush();
+    return PJ_SUCCESS;
+#else
+    return PJ_ENOTSUP;
+#endif
+}
+
 /* Load credentials from files. */
 PJ_DEF(pj_status_t) pj_ssl_cert_load_from_files (pj_pool_t *pool,
                                                  const pj_str_t *CA_file,
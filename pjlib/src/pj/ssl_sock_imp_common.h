@@ -42,6 +42,37 @@ enum timer_id
     TIMER_CLOSE
 };
 
+/*
+ * Asynchronous handshake, the handshake is performed by the SSL socket
+ * handshake worker threads. This is not applicable for backends that
+ * manage the network themselves.
+ */
+#if defined(PJ_HAS_THREADS) && PJ_HAS_THREADS != 0 && \
+    !defined(SSL_SOCK_IMP_USE_OWN_NETWORK)
+#   define SSL_SOCK_IMP_USE_HS_WORKER
+#endif
+
+/*
+ * Handshake job states.
+ */
+enum hs_job_state
+{
+    HS_JOB_IDLE,
+    HS_JOB_QUEUED,
+    HS_JOB_RUNNING
+};
+
+/*
+ * Structure of handshake job, each SSL socket has one.
+ */
+typedef struct hs_job_t
+{
+    PJ_DECL_LIST_MEMBER(struct hs_job_t);
+    pj_ssl_sock_t       *ssock;
+    enum hs_job_state    state;
+    pj_bool_t            again;     /* new data arrived while running   */
+} hs_job_t;
+
 /*
  * Structure of SSL socket read buffer.
  */
@@ -112,6 +143,7 @@ struct pj_ssl_sock_t
     pj_ioqueue_op_key_t   shutdown_op_key;
     pj_timer_entry        timer;
     pj_status_t           verify_status;
+    pj_bool_t             session_reused;
     pj_status_t           handshake_status;
 
     pj_bool_t             is_closing;
@@ -144,6 +176,9 @@ struct pj_ssl_sock_t
 
     circ_buf_t            circ_buf_output;
     pj_lock_t            *circ_buf_output_mutex;
+
+    hs_job_t              hs_job;   /* asynchronous handshake job,
+                                     * protected by handshake worker lock */
 };
 
 
@@ -278,6 +313,11 @@ static pj_status_t ssl_read(pj_ssl_sock_t *ssock, void *data, int *size);
 static pj_status_t ssl_write(pj_ssl_sock_t *ssock, const void *data,
                              pj_ssize_t size, int *nwritten);
 
+#ifdef SSL_SOCK_IMP_USE_CTX_CACHE
+/* Invalidate all cached SSL contexts */
+static void ssl_ctx_cache_flush(void);
+#endif
+
 #ifdef SSL_SOCK_IMP_USE_OWN_NETWORK
 
 static void ssl_close_sockets(pj_ssl_sock_t *ssock);
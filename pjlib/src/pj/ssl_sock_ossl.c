@@ -21,6 +21,7 @@
 #include <pj/assert.h>
 #include <pj/errno.h>
 #include <pj/file_access.h>
+#include <pj/hash.h>
 #include <pj/list.h>
 #include <pj/lock.h>
 #include <pj/log.h>
@@ -36,6 +37,18 @@
 #if defined(PJ_HAS_SSL_SOCK) && PJ_HAS_SSL_SOCK != 0 && \
     (PJ_SSL_SOCK_IMP == PJ_SSL_SOCK_IMP_OPENSSL)
 
+/* Share SSL contexts among SSL sockets with the same settings */
+#if PJ_SSL_SOCK_OSSL_CTX_CACHE_SIZE > 0
+#   define SSL_SOCK_IMP_USE_CTX_CACHE
+#endif
+
+/* Keep client sessions for resumption, sessions are bound to the cached
+ * SSL contexts.
+ */
+#if defined(SSL_SOCK_IMP_USE_CTX_CACHE) && PJ_SSL_SOCK_OSSL_SESS_CACHE_SIZE > 0
+#   define SSL_SOCK_IMP_USE_SESS_CACHE
+#endif
+
 #include "ssl_sock_imp_common.h"
 
 #define THIS_FILE               "ssl_sock_ossl.c"
@@ -53,6 +66,7 @@
 #endif
 
 #include <openssl/rand.h>
+#include <openssl/evp.h>
 #include <openssl/opensslconf.h>
 #include <openssl/opensslv.h>
 
@@ -95,6 +109,16 @@
 #      define USING_BORINGSSL 0
 #endif
 
+/* SSL_CTX_up_ref() is only available since OpenSSL 1.1.0 and
+ * LibreSSL 2.7.0.
+ */
+#if (!USING_LIBRESSL && !USING_BORINGSSL && \
+     OPENSSL_VERSION_NUMBER < 0x10100000L) || \
+    (USING_LIBRESSL && LIBRESSL_VERSION_NUMBER < 0x2070000fL)
+#   define SSL_CTX_up_ref(ctx) \
+            CRYPTO_add(&(ctx)->references, 1, CRYPTO_LOCK_SSL_CTX)
+#endif
+
 #if !USING_LIBRESSL && !defined(OPENSSL_NO_EC) \
         && OPENSSL_VERSION_NUMBER >= 0x1000200fL
 
@@ -230,6 +254,9 @@ typedef struct ossl_sock_t
     SSL                  *ossl_ssl;
     BIO                  *ossl_rbio;
     BIO                  *ossl_wbio;
+#ifdef SSL_SOCK_IMP_USE_SESS_CACHE
+    pj_status_t           sess_verify_status; /* of the offered session */
+#endif
 } ossl_sock_t;
 
 
@@ -686,6 +713,426 @@ static pj_status_t init_ossl_lock()
 
 #endif
 
+#ifdef SSL_SOCK_IMP_USE_CTX_CACHE
+
+/* SSL context cache key length, i.e: SHA-256 digest of the settings */
+#define CTX_CACHE_KEY_LEN       32
+
+/* SSL context cache entry */
+typedef struct ctx_cache_entry
+{
+    PJ_DECL_LIST_MEMBER(struct ctx_cache_entry);
+
+    /* Digest of the SSL socket settings used to create the context */
+    unsigned char        key[CTX_CACHE_KEY_LEN];
+
+    /* The context, the cache holds one reference of it */
+    SSL_CTX             *ctx;
+} ctx_cache_entry;
+
+/* SSL context cache, the most recently used entry is put at the front */
+static struct ctx_cache
+{
+    pj_caching_pool      cp;
+    pj_pool_t           *pool;
+    pj_lock_t           *lock;
+    unsigned             count;
+    ctx_cache_entry      list;
+    ctx_cache_entry      free_list;
+} ctx_cache;
+
+#ifdef SSL_SOCK_IMP_USE_SESS_CACHE
+
+/* Maximum length of client session cache key, i.e: "server_name|addr" */
+#define SESS_CACHE_KEY_LEN      (PJ_MAX_HOSTNAME + PJ_INET6_ADDRSTRLEN + 10)
+
+/* Client session cache entry */
+typedef struct sess_cache_entry
+{
+    PJ_DECL_LIST_MEMBER(struct sess_cache_entry);
+    pj_hash_entry_buf    hbuf;
+    char                 key[SESS_CACHE_KEY_LEN];
+    unsigned             key_len;
+
+    /* The context the session was negotiated with, the session can only
+     * be offered by SSL instances of this context.
+     */
+    SSL_CTX             *ctx;
+    SSL_SESSION         *sess;
+
+    /* Certificate verification status of the original handshake, as
+     * verification is skipped when the session is resumed.
+     */
+    pj_status_t          verify_status;
+} sess_cache_entry;
+
+/* Client session cache, protected by the SSL context cache lock. The most
+ * recently used entry is put at the front.
+ */
+static struct sess_cache
+{
+    pj_hash_table_t     *table;
+    unsigned             count;
+    sess_cache_entry     list;
+    sess_cache_entry     free_list;
+} sess_cache;
+
+/* Remove a client session cache entry, SSL context cache lock must be
+ * held.
+ */
+static void sess_cache_remove(sess_cache_entry *e)
+{
+    pj_hash_set_np(sess_cache.table, e->key, e->key_len, 0, NULL, NULL);
+    pj_list_erase(e);
+    SSL_SESSION_free(e->sess);
+    SSL_CTX_free(e->ctx);
+    e->sess = NULL;
+    e->ctx = NULL;
+    pj_list_push_back(&sess_cache.free_list, e);
+    --sess_cache.count;
+}
+
+#endif  /* SSL_SOCK_IMP_USE_SESS_CACHE */
+
+/* Invalidate all cached SSL contexts and client sessions. SSL sockets
+ * using them hold their own reference, so the contexts are only freed
+ * when unused.
+ */
+static void ssl_ctx_cache_flush(void)
+{
+    if (!ctx_cache.lock)
+        return;
+
+    pj_lock_acquire(ctx_cache.lock);
+    while (!pj_list_empty(&ctx_cache.list)) {
+        ctx_cache_entry *e = ctx_cache.list.next;
+
+        pj_list_erase(e);
+        SSL_CTX_free(e->ctx);
+        e->ctx = NULL;
+        pj_list_push_back(&ctx_cache.free_list, e);
+    }
+    ctx_cache.count = 0;
+
+#ifdef SSL_SOCK_IMP_USE_SESS_CACHE
+    while (!pj_list_empty(&sess_cache.list))
+        sess_cache_remove(sess_cache.list.next);
+#endif
+
+    pj_lock_release(ctx_cache.lock);
+}
+
+/* Destroy SSL context cache */
+static void release_ctx_cache(void)
+{
+    if (!ctx_cache.lock)
+        return;
+
+    ssl_ctx_cache_flush();
+
+    pj_lock_destroy(ctx_cache.lock);
+    ctx_cache.lock = NULL;
+    pj_pool_release(ctx_cache.pool);
+    ctx_cache.pool = NULL;
+    pj_caching_pool_destroy(&ctx_cache.cp);
+}
+
+/* Create SSL context cache */
+static pj_status_t init_ctx_cache(void)
+{
+    pj_status_t status;
+
+    pj_caching_pool_init(&ctx_cache.cp, NULL, 0);
+
+    ctx_cache.pool = pj_pool_create(&ctx_cache.cp.factory, "ossl-ctx",
+                                    512, 512, NULL);
+    if (!ctx_cache.pool) {
+        pj_caching_pool_destroy(&ctx_cache.cp);
+        return PJ_ENOMEM;
+    }
+
+    status = pj_lock_create_simple_mutex(ctx_cache.pool, "ossl-ctx",
+                                         &ctx_cache.lock);
+    if (status != PJ_SUCCESS) {
+        pj_pool_release(ctx_cache.pool);
+        ctx_cache.pool = NULL;
+        pj_caching_pool_destroy(&ctx_cache.cp);
+        return status;
+    }
+
+    pj_list_init(&ctx_cache.list);
+    pj_list_init(&ctx_cache.free_list);
+    ctx_cache.count = 0;
+
+#ifdef SSL_SOCK_IMP_USE_SESS_CACHE
+    sess_cache.table = pj_hash_create(ctx_cache.pool,
+                                      PJ_SSL_SOCK_OSSL_SESS_CACHE_SIZE);
+    pj_list_init(&sess_cache.list);
+    pj_list_init(&sess_cache.free_list);
+    sess_cache.count = 0;
+#endif
+
+    status = pj_atexit(&release_ctx_cache);
+    if (status != PJ_SUCCESS) {
+        PJ_PERROR(1, (THIS_FILE, status, "Warning! Unable to set SSL "
+                      "context cache release method."));
+    }
+
+    return PJ_SUCCESS;
+}
+
+/* Add length prefixed string to the digest */
+static int ctx_cache_digest_str(EVP_MD_CTX *mdctx, const pj_str_t *str)
+{
+    pj_uint32_t len = (pj_uint32_t)str->slen;
+
+    return EVP_DigestUpdate(mdctx, &len, sizeof(len)) &&
+           (len == 0 || EVP_DigestUpdate(mdctx, str->ptr, len));
+}
+
+/* Calculate SSL context cache key, i.e: digest of all SSL socket settings
+ * applied to the SSL context or the SSL instances created from it.
+ */
+static pj_bool_t ctx_cache_calc_key(const pj_ssl_sock_t *ssock,
+                                    unsigned char key[CTX_CACHE_KEY_LEN])
+{
+    const pj_ssl_sock_param *param = &ssock->param;
+    const pj_ssl_cert_t *cert = ssock->cert;
+    EVP_MD_CTX *mdctx;
+    pj_uint32_t val[10];
+    unsigned key_len = 0;
+    int ok;
+
+    mdctx = EVP_MD_CTX_create();
+    if (!mdctx)
+        return PJ_FALSE;
+
+    val[0] = ssock->is_server;
+    val[1] = param->proto;
+    val[2] = param->enable_renegotiation;
+    val[3] = param->verify_peer;
+    val[4] = param->require_client_cert;
+    val[5] = param->ciphers_num;
+    val[6] = param->curves_num;
+    val[7] = (cert != NULL);
+    val[8] = param->session_resumption;
+    val[9] = param->session_timeout;
+
+    ok = EVP_DigestInit_ex(mdctx, EVP_sha256(), NULL) &&
+         EVP_DigestUpdate(mdctx, val, sizeof(val));
+    if (ok && param->ciphers_num) {
+        ok = EVP_DigestUpdate(mdctx, param->ciphers,
+                              param->ciphers_num * sizeof(param->ciphers[0]));
+    }
+    if (ok && param->curves_num) {
+        ok = EVP_DigestUpdate(mdctx, param->curves,
+                              param->curves_num * sizeof(param->curves[0]));
+    }
+    if (ok && cert) {
+        ok = ctx_cache_digest_str(mdctx, &cert->CA_file) &&
+             ctx_cache_digest_str(mdctx, &cert->CA_path) &&
+             ctx_cache_digest_str(mdctx, &cert->cert_file) &&
+             ctx_cache_digest_str(mdctx, &cert->privkey_file) &&
+             ctx_cache_digest_str(mdctx, &cert->privkey_pass) &&
+             ctx_cache_digest_str(mdctx, &cert->CA_buf) &&
+             ctx_cache_digest_str(mdctx, &cert->cert_buf) &&
+             ctx_cache_digest_str(mdctx, &cert->privkey_buf);
+    }
+    if (ok)
+        ok = EVP_DigestFinal_ex(mdctx, key, &key_len);
+
+    EVP_MD_CTX_destroy(mdctx);
+
+    return (ok && key_len == CTX_CACHE_KEY_LEN);
+}
+
+/* Find SSL context in the cache, and add a reference to it */
+static SSL_CTX *ctx_cache_get(const unsigned char key[CTX_CACHE_KEY_LEN])
+{
+    ctx_cache_entry *e;
+    SSL_CTX *ctx = NULL;
+
+    pj_lock_acquire(ctx_cache.lock);
+    for (e = ctx_cache.list.next; e != &ctx_cache.list; e = e->next) {
+        if (pj_memcmp(e->key, key, CTX_CACHE_KEY_LEN) == 0) {
+            ctx = e->ctx;
+            SSL_CTX_up_ref(ctx);
+
+            pj_list_erase(e);
+            pj_list_push_front(&ctx_cache.list, e);
+            break;
+        }
+    }
+    pj_lock_release(ctx_cache.lock);
+
+    return ctx;
+}
+
+/* Add SSL context to the cache. When the cache is full, the least
+ * recently used entry is evicted.
+ */
+static void ctx_cache_add(const unsigned char key[CTX_CACHE_KEY_LEN],
+                          SSL_CTX *ctx)
+{
+    ctx_cache_entry *e;
+
+    pj_lock_acquire(ctx_cache.lock);
+
+    /* Another socket may have added a context with the same settings */
+    for (e = ctx_cache.list.next; e != &ctx_cache.list; e = e->next) {
+        if (pj_memcmp(e->key, key, CTX_CACHE_KEY_LEN) == 0) {
+            pj_lock_release(ctx_cache.lock);
+            return;
+        }
+    }
+
+    if (ctx_cache.count >= PJ_SSL_SOCK_OSSL_CTX_CACHE_SIZE) {
+        e = ctx_cache.list.prev;
+        pj_list_erase(e);
+        SSL_CTX_free(e->ctx);
+        --ctx_cache.count;
+    } else if (!pj_list_empty(&ctx_cache.free_list)) {
+        e = ctx_cache.free_list.next;
+        pj_list_erase(e);
+    } else {
+        e = PJ_POOL_ZALLOC_T(ctx_cache.pool, ctx_cache_entry);
+    }
+
+    pj_memcpy(e->key, key, CTX_CACHE_KEY_LEN);
+    e->ctx = ctx;
+    SSL_CTX_up_ref(ctx);
+
+    /* The credential of the creating socket is no longer needed, and it
+     * may be destroyed before the context.
+     */
+    SSL_CTX_set_default_passwd_cb_userdata(ctx, NULL);
+
+    pj_list_push_front(&ctx_cache.list, e);
+    ++ctx_cache.count;
+
+    pj_lock_release(ctx_cache.lock);
+}
+
+#ifdef SSL_SOCK_IMP_USE_SESS_CACHE
+
+/* Get client session cache key of the ssock, i.e: the server name and
+ * the server address, so the session is only offered to the same server.
+ */
+static pj_bool_t sess_cache_get_key(const pj_ssl_sock_t *ssock,
+                                    char key[SESS_CACHE_KEY_LEN],
+                                    unsigned *key_len)
+{
+    char addr[PJ_INET6_ADDRSTRLEN + 10];
+    int len;
+
+    if (!pj_sockaddr_has_addr(&ssock->rem_addr))
+        return PJ_FALSE;
+
+    pj_sockaddr_print(&ssock->rem_addr, addr, sizeof(addr), 3);
+    len = pj_ansi_snprintf(key, SESS_CACHE_KEY_LEN, "%.*s|%s",
+                           (int)ssock->param.server_name.slen,
+                           ssock->param.server_name.ptr, addr);
+    if (len < 0 || len >= SESS_CACHE_KEY_LEN)
+        return PJ_FALSE;
+
+    *key_len = len;
+    return PJ_TRUE;
+}
+
+/* New client session callback, store the session in the client session
+ * cache, replacing the previous session of the same server.
+ */
+static int sess_new_cb(SSL *ssl, SSL_SESSION *sess)
+{
+    pj_ssl_sock_t *ssock;
+    sess_cache_entry *e;
+    char key[SESS_CACHE_KEY_LEN];
+    unsigned key_len;
+
+    ssock = (pj_ssl_sock_t *)SSL_get_ex_data(ssl, sslsock_idx);
+    if (!ssock || !ctx_cache.lock || !sess_cache_get_key(ssock, key, &key_len))
+        return 0;
+
+    pj_lock_acquire(ctx_cache.lock);
+
+    e = (sess_cache_entry *)pj_hash_get(sess_cache.table, key, key_len, NULL);
+    if (e) {
+        sess_cache_remove(e);
+    } else if (sess_cache.count >= PJ_SSL_SOCK_OSSL_SESS_CACHE_SIZE) {
+        sess_cache_remove(sess_cache.list.prev);
+    }
+
+    e = sess_cache.free_list.next;
+    if (e != &sess_cache.free_list) {
+        pj_list_erase(e);
+    } else {
+        e = PJ_POOL_ZALLOC_T(ctx_cache.pool, sess_cache_entry);
+    }
+
+    pj_memcpy(e->key, key, key_len);
+    e->key_len = key_len;
+    e->ctx = SSL_get_SSL_CTX(ssl);
+    SSL_CTX_up_ref(e->ctx);
+    e->sess = sess;
+    e->verify_status = ssock->verify_status;
+
+    pj_hash_set_np(sess_cache.table, e->key, e->key_len, 0, e->hbuf, e);
+    pj_list_push_front(&sess_cache.list, e);
+    ++sess_cache.count;
+
+    pj_lock_release(ctx_cache.lock);
+
+    /* Keep the reference of the session */
+    return 1;
+}
+
+/* Offer the cached session of the server, if any, in the client
+ * handshake.
+ */
+static void sess_cache_set_session(pj_ssl_sock_t *ssock)
+{
+    ossl_sock_t *ossock = (ossl_sock_t *)ssock;
+    sess_cache_entry *e;
+    char key[SESS_CACHE_KEY_LEN];
+    unsigned key_len;
+
+    if (!ctx_cache.lock || !sess_cache_get_key(ssock, key, &key_len))
+        return;
+
+    pj_lock_acquire(ctx_cache.lock);
+
+    e = (sess_cache_entry *)pj_hash_get(sess_cache.table, key, key_len, NULL);
+    if (e) {
+        long age = (long)(time(NULL) - SSL_SESSION_get_time(e->sess));
+        long timeout = SSL_SESSION_get_timeout(e->sess);
+
+        if (ssock->param.session_timeout &&
+            (long)ssock->param.session_timeout < timeout)
+        {
+            timeout = ssock->param.session_timeout;
+        }
+
+        if (age < 0 || age >= timeout) {
+            /* Expired */
+            sess_cache_remove(e);
+        } else if (e->ctx == ossock->ossl_ctx &&
+                   SSL_set_session(ossock->ossl_ssl, e->sess))
+        {
+            ossock->sess_verify_status = e->verify_status;
+            pj_list_erase(e);
+            pj_list_push_front(&sess_cache.list, e);
+            PJ_LOG(5,(ssock->pool->obj_name, "Offering cached TLS session "
+                      "for %s", e->key));
+        }
+    }
+
+    pj_lock_release(ctx_cache.lock);
+}
+
+#endif  /* SSL_SOCK_IMP_USE_SESS_CACHE */
+
+#endif  /* SSL_SOCK_IMP_USE_CTX_CACHE */
+
 /* Initialize OpenSSL */
 static pj_status_t init_openssl(void)
 {
@@ -899,6 +1346,13 @@ static pj_status_t init_openssl(void)
         return status;
 #endif
 
+#ifdef SSL_SOCK_IMP_USE_CTX_CACHE
+    /* Failure here is not fatal, SSL sockets just won't share contexts */
+    if (init_ctx_cache() != PJ_SUCCESS) {
+        PJ_LOG(2, (THIS_FILE, "Warning! SSL context cache is disabled"));
+    }
+#endif
+
     return status;
 }
 
@@ -915,7 +1369,7 @@ static int password_cb(char *buf, int num, int rwflag, void *user_data)
 
     PJ_UNUSED_ARG(rwflag);
 
-    if(num < cert->privkey_pass.slen)
+    if (!cert || num < cert->privkey_pass.slen)
         return 0;
     
     pj_memcpy(buf, cert->privkey_pass.ptr, cert->privkey_pass.slen);
@@ -1052,6 +1506,8 @@ static pj_status_t set_curves_list(pj_ssl_sock_t *ssock);
 static pj_status_t set_sigalgs(pj_ssl_sock_t *ssock);
 /* Setting entropy for rng */
 static void set_entropy(pj_ssl_sock_t *ssock);
+/* Server Name Indication server callback */
+static int sni_cb(SSL *ssl, int *al, void *arg);
 
 
 static pj_ssl_sock_t *ssl_alloc(pj_pool_t *pool)
@@ -1126,8 +1582,8 @@ static void set_dh_use_option(BIO *bio, const pj_ssl_sock_t* ssock,
 
 #endif
 
-/* Initialize OpenSSL context for the ssock */
-static pj_status_t init_ossl_ctx(pj_ssl_sock_t *ssock)
+/* Create and initialize new OpenSSL context for the ssock */
+static pj_status_t create_ossl_ctx(pj_ssl_sock_t *ssock)
 {
     ossl_sock_t *ossock = (ossl_sock_t *)ssock;
     SSL_CTX *ctx = NULL;
@@ -1200,16 +1656,23 @@ static pj_status_t init_ossl_ctx(pj_ssl_sock_t *ssock)
         unsigned int sid_ctx = SERVER_SESSION_ID_CONTEXT;
 
 #if SERVER_DISABLE_SESSION_TICKETS
-        /* Disable session tickets for TLSv1.2 and below. */
-        ssl_opt |= SSL_OP_NO_TICKET;
+        /* Session tickets are only issued when session resumption is
+         * explicitly enabled. The ticket keys are generated randomly by
+         * OpenSSL per context, so tickets do not survive a restart.
+         */
+        if (!ssock->param.session_resumption) {
+            /* Disable session tickets for TLSv1.2 and below. */
+            ssl_opt |= SSL_OP_NO_TICKET;
 #ifdef SSL_CTX_set_num_tickets
-        /* Set the number of TLSv1.3 session tickets issued to 0. */
-        SSL_CTX_set_num_tickets(ctx, 0);
+            /* Set the number of TLSv1.3 session tickets issued to 0. */
+            SSL_CTX_set_num_tickets(ctx, 0);
 #endif
-
+        }
 #endif
 
-        SSL_CTX_set_timeout(ctx, SERVER_SESSION_TIMEOUT);
+        SSL_CTX_set_timeout(ctx, ssock->param.session_timeout?
+                                 ssock->param.session_timeout :
+                                 SERVER_SESSION_TIMEOUT);
         if (!SSL_CTX_set_session_id_context(ctx,
                  (const unsigned char *)&sid_ctx, sizeof(sid_ctx)))
         {
@@ -1217,6 +1680,18 @@ static pj_status_t init_ossl_ctx(pj_ssl_sock_t *ssock)
                                   "context. Session reuse will not work."));
         }
     }
+#ifdef SSL_SOCK_IMP_USE_SESS_CACHE
+    else if (ssock->param.session_resumption) {
+        /* Client sessions are stored in our own session cache, keyed by
+         * the server, as OpenSSL internal cache is only used by servers.
+         */
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT |
+                                            SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(ctx, &sess_new_cb);
+        if (ssock->param.session_timeout)
+            SSL_CTX_set_timeout(ctx, ssock->param.session_timeout);
+    }
+#endif
 
 #ifdef SSL_OP_NO_RENEGOTIATION
     if (!ssock->param.enable_renegotiation) {
@@ -1227,6 +1702,13 @@ static pj_status_t init_ossl_ctx(pj_ssl_sock_t *ssock)
     if (ssl_opt)
         SSL_CTX_set_options(ctx, ssl_opt);
 
+#if defined(SSL_CTX_set_tlsext_servername_callback) && \
+    defined(SSL_CTX_set_tlsext_servername_arg)
+    /* Server name is checked against the setting of each SSL socket */
+    if (ssock->is_server)
+        SSL_CTX_set_tlsext_servername_callback(ctx, &sni_cb);
+#endif
+
     /* Set cipher list */
     status = set_cipher_list(ssock);
     if (status != PJ_SUCCESS) {
@@ -1592,6 +2074,48 @@ static pj_status_t init_ossl_ctx(pj_ssl_sock_t *ssock)
 }
 
 
+/* Initialize OpenSSL context for the ssock, the context is shared with
+ * other SSL sockets with the same settings via the SSL context cache.
+ */
+static pj_status_t init_ossl_ctx(pj_ssl_sock_t *ssock)
+{
+#ifdef SSL_SOCK_IMP_USE_CTX_CACHE
+    ossl_sock_t *ossock = (ossl_sock_t *)ssock;
+    unsigned char key[CTX_CACHE_KEY_LEN];
+    pj_bool_t use_cache;
+    pj_status_t status;
+
+    if (ssock->param.proto == PJ_SSL_SOCK_PROTO_DEFAULT) {
+        ssock->param.proto = PJ_SSL_SOCK_PROTO_TLS1_2 |
+                             PJ_SSL_SOCK_PROTO_TLS1_3;
+    }
+
+    /* The key must be calculated before the credentials are wiped */
+    use_cache = ctx_cache.lock && ctx_cache_calc_key(ssock, key);
+    if (use_cache) {
+        ossock->ossl_ctx = ctx_cache_get(key);
+        if (ossock->ossl_ctx) {
+            PJ_LOG(5,(ssock->pool->obj_name, "Using cached SSL context"));
+
+            /* Same early sensitive data cleanup as create_ossl_ctx() */
+            if (ssock->cert && (!ssock->is_server || ssock->parent))
+                pj_ssl_cert_wipe_keys(ssock->cert);
+
+            return PJ_SUCCESS;
+        }
+    }
+
+    status = create_ossl_ctx(ssock);
+    if (status == PJ_SUCCESS && use_cache)
+        ctx_cache_add(key, ossock->ossl_ctx);
+
+    return status;
+#else
+    return create_ossl_ctx(ssock);
+#endif
+}
+
+
 /* Create and initialize new SSL context and instance */
 static pj_status_t ssl_create(pj_ssl_sock_t *ssock)
 {
@@ -1872,17 +2396,12 @@ static pj_status_t set_curves_list(pj_ssl_sock_t *ssock)
         curves[cnt] = get_nid_from_cid(ssock->param.curves[cnt]);
     }
 
-    if( SSL_is_server(ossock->ossl_ssl) ) {
-        ret = SSL_set1_curves(ossock->ossl_ssl, curves,
-                              ssock->param.curves_num);
-        if (ret < 1)
-            return GET_SSL_STATUS(ssock);
-    } else {
-        ret = SSL_CTX_set1_curves(ossock->ossl_ctx, curves,
-                                  ssock->param.curves_num);
-        if (ret < 1)
-            return GET_SSL_STATUS(ssock);
-    }
+    /* Set on the SSL instance, as the SSL context may be shared with
+     * other SSL sockets via the SSL context cache.
+     */
+    ret = SSL_set1_curves(ossock->ossl_ssl, curves, ssock->param.curves_num);
+    if (ret < 1)
+        return GET_SSL_STATUS(ssock);
 #else
     PJ_UNUSED_ARG(ssock);
 #endif
@@ -2297,6 +2816,10 @@ static void ssl_set_state(pj_ssl_sock_t *ssock, pj_bool_t is_server)
     if (is_server) {
         SSL_set_accept_state(ossock->ossl_ssl);
     } else {
+#ifdef SSL_SOCK_IMP_USE_SESS_CACHE
+        if (ssock->param.session_resumption)
+            sess_cache_set_session(ssock);
+#endif
         SSL_set_connect_state(ossock->ossl_ssl);
     }
 }
@@ -2305,10 +2828,21 @@ static void ssl_set_state(pj_ssl_sock_t *ssock, pj_bool_t is_server)
 /* Server Name Indication server callback */
 static int sni_cb(SSL *ssl, int *al, void *arg)
 {
-    pj_ssl_sock_t *ssock = (pj_ssl_sock_t *)arg;
+    pj_ssl_sock_t *ssock;
     const char *sname;
 
     PJ_UNUSED_ARG(al);
+    PJ_UNUSED_ARG(arg);
+
+    /* The SSL context may be shared by SSL sockets with different server
+     * names, so get the SSL socket from the SSL instance.
+     */
+    ssock = (pj_ssl_sock_t *)SSL_get_ex_data(ssl, sslsock_idx);
+    if (!ssock || !ssock->param.server_name.slen ||
+        get_ip_addr_ver(&ssock->param.server_name) != 0)
+    {
+        return SSL_TLSEXT_ERR_NOACK;
+    }
 
     sname = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
     if (!sname || pj_stricmp2(&ssock->param.server_name, sname)) {
@@ -2328,13 +2862,7 @@ static void ssl_set_peer_name(pj_ssl_sock_t *ssock)
         get_ip_addr_ver(&ssock->param.server_name) == 0)
     {
         if (ssock->is_server) {
-#if defined(SSL_CTX_set_tlsext_servername_callback) && \
-    defined(SSL_CTX_set_tlsext_servername_arg)
-
-            SSL_CTX_set_tlsext_servername_callback(ossock->ossl_ctx, &sni_cb);
-            SSL_CTX_set_tlsext_servername_arg(ossock->ossl_ctx, ssock);
-
-#endif
+            /* SNI callback is set when creating the SSL context */
         } else {
 #ifdef SSL_set_tlsext_host_name
             /* Server name is null terminated already */
@@ -2431,6 +2959,18 @@ static pj_status_t ssl_do_handshake(pj_ssl_sock_t *ssock)
         }
 #endif
 
+        if (ssock->ssl_state != SSL_STATE_ESTABLISHED) {
+            ssock->session_reused = SSL_session_reused(ossock->ossl_ssl);
+
+#ifdef SSL_SOCK_IMP_USE_SESS_CACHE
+            /* Certificate is not verified on resumption, restore the
+             * verification status of the original session.
+             */
+            if (!ssock->is_server && ssock->session_reused)
+                ssock->verify_status = ossock->sess_verify_status;
+#endif
+        }
+
         ssock->ssl_state = SSL_STATE_ESTABLISHED;
         return PJ_SUCCESS;
     }
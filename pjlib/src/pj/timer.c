@@ -116,6 +116,45 @@ typedef pj_timer_entry pj_timer_entry_dup;
 
 #endif
 
+#if !PJ_TIMER_USE_LINKED_LIST
+
+#define WHEEL_BITS      8
+#define WHEEL_SLOTS     (1 << WHEEL_BITS)
+#define WHEEL_MASK      (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS    4
+
+/* Convert time value to wheel tick (millisecond) */
+#define TIME_TO_TICK(t) ((pj_uint64_t)(t).sec * 1000 + (t).msec)
+
+/**
+ * Hierarchical timing wheel with one millisecond resolution. Level 0 has
+ * one slot for each of the next 256 ticks, and each upper level covers 256
+ * times the range of the level below it. Entries in upper levels are moved
+ * down (cascaded) as the wheel turns. The slots are circular lists linked
+ * by timer id, so schedule and cancel don't need to search.
+ */
+typedef struct timer_wheel
+{
+    /** The tick being processed, all entries up to this tick are due. */
+    pj_uint64_t     cur_tick;
+
+    /** Number of entries in each level. */
+    unsigned        level_cnt[WHEEL_LEVELS];
+
+    /** The first timer id in each slot, or zero if the slot is empty. */
+    pj_timer_id_t   slot[WHEEL_LEVELS][WHEEL_SLOTS];
+
+    /** Next and previous timer id in the slot, indexed by timer id. */
+    pj_timer_id_t  *next;
+    pj_timer_id_t  *prev;
+
+    /** Level and slot of each timer id (level * WHEEL_SLOTS + slot). */
+    pj_uint16_t    *where;
+
+} timer_wheel;
+
+#endif
+
 /**
  * The implementation of timer heap.
  */
@@ -181,6 +220,28 @@ struct pj_timer_heap_t
     /** Callback to be called when a timer expires. */
     pj_timer_heap_callback *callback;
 
+#if !PJ_TIMER_USE_LINKED_LIST
+    /**
+     * The timing wheel, if the timer heap is created with
+     * PJ_TIMER_HEAP_WHEEL. In this case, the <heap> array is indexed by
+     * timer id instead of being a heap, and <timer_ids> maps each active
+     * timer id to itself.
+     */
+    timer_wheel *wheel;
+#endif
+
+    /**
+     * For sharded timer heap: the shards, and the thread local id to store
+     * the shard index (plus one) bound to a thread. Only the shards hold
+     * timer entries.
+     */
+    unsigned shard_cnt;
+    pj_timer_heap_t **shards;
+    long shard_tls_id;
+
+    /** For a shard: its index and the sharded timer heap owning it. */
+    unsigned shard_idx;
+    pj_timer_heap_t *owner;
 };
 
 
@@ -299,6 +360,208 @@ static void reheap_up( pj_timer_heap_t *ht, pj_timer_entry_dup *moved_node,
 }
 
 
+#if !PJ_TIMER_USE_LINKED_LIST
+
+static void wheel_link(pj_timer_heap_t *ht, pj_timer_id_t id)
+{
+    timer_wheel *w = ht->wheel;
+    pj_uint64_t expires = TIME_TO_TICK(ht->heap[id]->_timer_value);
+    pj_uint64_t delta;
+    pj_timer_id_t *head;
+    unsigned level, idx;
+
+    if (expires < w->cur_tick)
+        expires = w->cur_tick;
+    delta = expires - w->cur_tick;
+
+    for (level=0; level < WHEEL_LEVELS-1; ++level) {
+        if (delta < ((pj_uint64_t)1 << ((level+1) * WHEEL_BITS)))
+            break;
+    }
+    if (level == WHEEL_LEVELS-1 &&
+        delta >= ((pj_uint64_t)1 << (WHEEL_LEVELS * WHEEL_BITS)))
+    {
+        /* Too far in the future, park it at the far end of the wheel. It
+         * will be placed again when its slot is cascaded.
+         */
+        expires = w->cur_tick +
+                  ((pj_uint64_t)1 << (WHEEL_LEVELS * WHEEL_BITS)) - 1;
+    }
+    idx = (unsigned)(expires >> (level * WHEEL_BITS)) & WHEEL_MASK;
+
+    /* Append to the tail of the circular list */
+    head = &w->slot[level][idx];
+    if (*head == 0) {
+        *head = w->next[id] = w->prev[id] = id;
+    } else {
+        pj_timer_id_t tail = w->prev[*head];
+        w->next[tail] = id;
+        w->prev[id] = tail;
+        w->next[id] = *head;
+        w->prev[*head] = id;
+    }
+    w->where[id] = (pj_uint16_t)(level * WHEEL_SLOTS + idx);
+    w->level_cnt[level]++;
+}
+
+static void wheel_unlink(pj_timer_heap_t *ht, pj_timer_id_t id)
+{
+    timer_wheel *w = ht->wheel;
+    unsigned level = w->where[id] / WHEEL_SLOTS;
+    pj_timer_id_t *head = &w->slot[level][w->where[id] % WHEEL_SLOTS];
+
+    if (w->next[id] == id) {
+        *head = 0;
+    } else {
+        w->next[w->prev[id]] = w->next[id];
+        w->prev[w->next[id]] = w->prev[id];
+        if (*head == id)
+            *head = w->next[id];
+    }
+    w->level_cnt[level]--;
+}
+
+/* Move entries of upper levels down when the wheel passes their slot. */
+static void wheel_cascade(pj_timer_heap_t *ht)
+{
+    timer_wheel *w = ht->wheel;
+    unsigned level;
+
+    for (level=1; level < WHEEL_LEVELS; ++level) {
+        unsigned idx = (unsigned)(w->cur_tick >> (level * WHEEL_BITS)) &
+                       WHEEL_MASK;
+        pj_timer_id_t id;
+
+        while ((id = w->slot[level][idx]) != 0) {
+            wheel_unlink(ht, id);
+            wheel_link(ht, id);
+        }
+
+        if (idx != 0)
+            break;
+    }
+}
+
+/* Turn the wheel up to the specified tick, and return the id of an entry
+ * that has expired, or zero if there is none.
+ */
+static pj_timer_id_t wheel_get_expired(pj_timer_heap_t *ht,
+                                       pj_uint64_t now_tick)
+{
+    timer_wheel *w = ht->wheel;
+
+    while (w->slot[0][w->cur_tick & WHEEL_MASK] == 0) {
+        if (w->cur_tick >= now_tick)
+            return 0;
+
+        if (ht->cur_size == 0) {
+            w->cur_tick = now_tick;
+            return 0;
+        }
+
+        if (w->level_cnt[0] == 0) {
+            /* Nothing can expire before the next cascade of the lowest
+             * non-empty level, skip there.
+             */
+            pj_uint64_t next;
+            unsigned level = 1;
+
+            while (level < WHEEL_LEVELS-1 && w->level_cnt[level] == 0)
+                ++level;
+            next = (w->cur_tick |
+                    (((pj_uint64_t)1 << (level * WHEEL_BITS)) - 1)) + 1;
+            if (next > now_tick) {
+                w->cur_tick = now_tick;
+                return 0;
+            }
+            w->cur_tick = next;
+        } else {
+            ++w->cur_tick;
+        }
+
+        if ((w->cur_tick & WHEEL_MASK) == 0)
+            wheel_cascade(ht);
+    }
+
+    return w->slot[0][w->cur_tick & WHEEL_MASK];
+}
+
+/* Get the earliest expiration time in the wheel. */
+static void wheel_get_earliest(pj_timer_heap_t *ht, pj_time_val *earliest)
+{
+    timer_wheel *w = ht->wheel;
+    pj_timer_entry_dup *min_node = NULL;
+    unsigned level;
+
+    for (level=0; level < WHEEL_LEVELS; ++level) {
+        unsigned i, idx;
+        pj_timer_id_t id;
+
+        if (w->level_cnt[level] == 0)
+            continue;
+
+        /* Level 0 starts at the current tick, while for the upper levels,
+         * the current slot holds the farthest entries.
+         */
+        idx = (unsigned)(w->cur_tick >> (level * WHEEL_BITS));
+        if (level > 0)
+            ++idx;
+
+        for (i=0; i < WHEEL_SLOTS; ++i, ++idx) {
+            id = w->slot[level][idx & WHEEL_MASK];
+            if (id != 0)
+                break;
+        }
+        pj_assert(id != 0);
+
+        /* Entries in the first non-empty slot are earlier than the rest
+         * of the level, but entries in different levels may overlap.
+         */
+        do {
+            pj_timer_entry_dup *node = ht->heap[id];
+            if (!min_node ||
+                PJ_TIME_VAL_LT(node->_timer_value, min_node->_timer_value))
+            {
+                min_node = node;
+            }
+            id = w->next[id];
+        } while (id != w->slot[level][idx & WHEEL_MASK]);
+    }
+
+    pj_assert(min_node);
+    *earliest = min_node->_timer_value;
+}
+
+static pj_status_t wheel_grow(pj_timer_heap_t *ht, pj_size_t new_size)
+{
+    timer_wheel *w = ht->wheel;
+    pj_timer_id_t *new_next, *new_prev;
+    pj_uint16_t *new_where;
+
+    new_next = (pj_timer_id_t*)
+               pj_pool_alloc(ht->pool, new_size * sizeof(pj_timer_id_t));
+    new_prev = (pj_timer_id_t*)
+               pj_pool_alloc(ht->pool, new_size * sizeof(pj_timer_id_t));
+    new_where = (pj_uint16_t*)
+                pj_pool_alloc(ht->pool, new_size * sizeof(pj_uint16_t));
+    if (!new_next || !new_prev || !new_where)
+        return PJ_ENOMEM;
+
+    if (ht->max_size) {
+        memcpy(new_next, w->next, ht->max_size * sizeof(pj_timer_id_t));
+        memcpy(new_prev, w->prev, ht->max_size * sizeof(pj_timer_id_t));
+        memcpy(new_where, w->where, ht->max_size * sizeof(pj_uint16_t));
+    }
+    w->next = new_next;
+    w->prev = new_prev;
+    w->where = new_where;
+
+    return PJ_SUCCESS;
+}
+
+#endif  /* !PJ_TIMER_USE_LINKED_LIST */
+
+
 static pj_timer_entry_dup * remove_node( pj_timer_heap_t *ht, size_t slot)
 {
     pj_timer_entry_dup *removed_node = ht->heap[slot];
@@ -336,9 +599,13 @@ static pj_timer_entry_dup * remove_node( pj_timer_heap_t *ht, size_t slot)
     GET_FIELD(removed_node, _timer_id) = -1;
 
 #if !PJ_TIMER_USE_LINKED_LIST
-    // Only try to reheapify if we're not deleting the last entry.
+    if (ht->wheel) {
+        // In timing wheel, the slot is the timer id.
+        wheel_unlink(ht, (pj_timer_id_t)slot);
+    }
 
-    if (slot < ht->cur_size)
+    // Only try to reheapify if we're not deleting the last entry.
+    else if (slot < ht->cur_size)
     {
         pj_size_t parent;
         pj_timer_entry_dup *moved_node = ht->heap[ht->cur_size];
@@ -404,6 +671,16 @@ static pj_status_t grow_heap(pj_timer_heap_t *ht)
 
     memcpy(new_timer_dups, ht->timer_dups,
            ht->max_size * sizeof(pj_timer_entry_dup));
+#if !PJ_TIMER_USE_LINKED_LIST
+    if (ht->wheel) {
+        // The heap array is indexed by timer id, and the node of timer
+        // id i is timer_dups[i].
+        for (i = 0; i < ht->max_size; i++) {
+            if (ht->timer_ids[i] >= 0)
+                new_heap[i] = &new_timer_dups[i];
+        }
+    } else
+#endif
     for (i = 0; i < ht->cur_size; i++) {
         int idx = (int)(ht->heap[i] - ht->timer_dups);
         // Point to the address in the new array
@@ -415,6 +692,14 @@ static pj_status_t grow_heap(pj_timer_heap_t *ht)
     memcpy(new_heap, ht->heap, ht->max_size * sizeof(pj_timer_entry *));
 #endif
 
+#if !PJ_TIMER_USE_LINKED_LIST
+    if (ht->wheel) {
+        pj_status_t status = wheel_grow(ht, new_size);
+        if (status != PJ_SUCCESS)
+            return status;
+    }
+#endif
+
 #if PJ_TIMER_USE_LINKED_LIST
     tmp_dup = ht->head_list.next;
     pj_list_init(&ht->head_list);
@@ -481,7 +766,12 @@ static pj_status_t insert_node(pj_timer_heap_t *ht,
     timer_copy->_timer_value = *future_time;
 
 #if !PJ_TIMER_USE_LINKED_LIST
-    reheap_up(ht, timer_copy, ht->cur_size, HEAP_PARENT(ht->cur_size));
+    if (ht->wheel) {
+        copy_node(ht, new_node->_timer_id, timer_copy);
+        wheel_link(ht, new_node->_timer_id);
+    } else {
+        reheap_up(ht, timer_copy, ht->cur_size, HEAP_PARENT(ht->cur_size));
+    }
 #else
     if (ht->cur_size == 0) {
         pj_list_push_back(&ht->head_list, timer_copy);
@@ -569,18 +859,70 @@ static int cancel( pj_timer_heap_t *ht,
 }
 
 
+/* Get the slot of the earliest entry if it has expired. */
+static pj_bool_t get_expired_slot(pj_timer_heap_t *ht,
+                                  const pj_time_val *now,
+                                  pj_timer_id_t *slot)
+{
+#if PJ_TIMER_USE_LINKED_LIST
+    *slot = ht->timer_ids[GET_FIELD(ht->head_list.next, _timer_id)];
+#else
+    if (ht->wheel) {
+        *slot = wheel_get_expired(ht, TIME_TO_TICK(*now));
+        return (*slot != 0);
+    }
+    *slot = 0;
+#endif
+    return PJ_TIME_VAL_LTE(ht->heap[*slot]->_timer_value, *now);
+}
+
+/* Get the time of the earliest entry. */
+static void get_earliest_time(pj_timer_heap_t *ht, pj_time_val *earliest)
+{
+#if PJ_TIMER_USE_LINKED_LIST
+    *earliest = ht->head_list.next->_timer_value;
+#else
+    if (ht->wheel)
+        wheel_get_earliest(ht, earliest);
+    else
+        *earliest = ht->heap[0]->_timer_value;
+#endif
+}
+
+
 /*
  * Calculate memory size required to create a timer heap.
  */
 PJ_DEF(pj_size_t) pj_timer_heap_mem_size(pj_size_t count)
 {
-    return /* size of the timer heap itself: */
+    pj_size_t size;
+
+    size = /* size of the timer heap itself: */
            sizeof(pj_timer_heap_t) + 
            /* size of each entry: */
            (count+2) * (sizeof(pj_timer_entry_dup*)+sizeof(pj_timer_id_t)+
            sizeof(pj_timer_entry_dup)) +
            /* lock, pool etc: */
            132;
+
+#if !PJ_TIMER_USE_LINKED_LIST
+    if (PJ_TIMER_HEAP_DEFAULT_TYPE == PJ_TIMER_HEAP_WHEEL) {
+        size += sizeof(timer_wheel) +
+                (count+2) * (2*sizeof(pj_timer_id_t) + sizeof(pj_uint16_t));
+    }
+#endif
+
+    return size;
+}
+
+/*
+ * Initialize timer heap settings.
+ */
+PJ_DEF(void) pj_timer_heap_cfg_default(pj_timer_heap_cfg *cfg)
+{
+    pj_bzero(cfg, sizeof(*cfg));
+    cfg->type = (pj_timer_heap_type)PJ_TIMER_HEAP_DEFAULT_TYPE;
+    cfg->shard_cnt = 1;
 }
 
 /*
@@ -590,6 +932,153 @@ PJ_DEF(pj_status_t) pj_timer_heap_create( pj_pool_t *pool,
                                           pj_size_t size,
                                           pj_timer_heap_t **p_heap)
 {
+    return pj_timer_heap_create2(pool, size, NULL, p_heap);
+}
+
+/*
+ * Create a sharded timer heap.
+ */
+static pj_status_t create_sharded(pj_pool_t *pool,
+                                  pj_size_t size,
+                                  const pj_timer_heap_cfg *cfg,
+                                  pj_timer_heap_t **p_heap)
+{
+    pj_timer_heap_cfg shard_cfg;
+    pj_timer_heap_t *ht;
+    unsigned i;
+    pj_status_t status;
+
+    ht = PJ_POOL_ZALLOC_T(pool, pj_timer_heap_t);
+    if (!ht)
+        return PJ_ENOMEM;
+
+    ht->pool = pool;
+    ht->max_entries_per_poll = DEFAULT_MAX_TIMED_OUT_PER_POLL;
+    ht->shard_tls_id = -1;
+    ht->shards = (pj_timer_heap_t**)
+                 pj_pool_calloc(pool, cfg->shard_cnt, sizeof(ht->shards[0]));
+    if (!ht->shards)
+        return PJ_ENOMEM;
+
+    status = pj_thread_local_alloc(&ht->shard_tls_id);
+    if (status != PJ_SUCCESS)
+        return status;
+
+    shard_cfg = *cfg;
+    shard_cfg.shard_cnt = 1;
+
+    for (i = 0; i < cfg->shard_cnt; ++i) {
+        pj_timer_heap_t *shard;
+        pj_pool_t *shard_pool;
+        pj_lock_t *lock;
+
+        /* Each shard grows independently under its own lock, so it needs
+         * its own pool.
+         */
+        shard_pool = pj_pool_create(pool->factory, "tshard%p", 512, 512,
+                                    NULL);
+        if (!shard_pool) {
+            status = PJ_ENOMEM;
+            goto on_error;
+        }
+
+        status = pj_timer_heap_create2(shard_pool,
+                                       size / cfg->shard_cnt + 1,
+                                       &shard_cfg, &shard);
+        if (status != PJ_SUCCESS) {
+            pj_pool_release(shard_pool);
+            goto on_error;
+        }
+        shard->shard_idx = i;
+        shard->owner = ht;
+        ht->shards[i] = shard;
+        ++ht->shard_cnt;
+
+        status = pj_lock_create_recursive_mutex(shard_pool, "tshard%p",
+                                                &lock);
+        if (status != PJ_SUCCESS)
+            goto on_error;
+        pj_timer_heap_set_lock(shard, lock, PJ_TRUE);
+    }
+
+    *p_heap = ht;
+    return PJ_SUCCESS;
+
+on_error:
+    pj_timer_heap_destroy(ht);
+    return status;
+}
+
+/* Select the shard for the entry to be scheduled. */
+static pj_timer_heap_t *select_shard(pj_timer_heap_t *ht,
+                                     pj_timer_entry *entry,
+                                     pj_grp_lock_t *grp_lock)
+{
+    pj_size_t idx;
+
+    if (grp_lock) {
+        /* Keep timers of the same object in the same shard */
+        idx = (pj_size_t)grp_lock >> 4;
+    } else {
+        idx = (pj_size_t)pj_thread_local_get(ht->shard_tls_id);
+        if (idx)
+            return ht->shards[idx - 1];
+
+        idx = (pj_size_t)entry >> 4;
+    }
+
+    return ht->shards[idx % ht->shard_cnt];
+}
+
+/* Lock the shard selected for the entry to be scheduled, and also the
+ * shard where the entry was last scheduled if it is another one, as the
+ * running state of the entry is only updated under the lock of the latter.
+ * The locks are taken in the order of the shard index. Return the latter
+ * shard if it has been locked too.
+ */
+static pj_timer_heap_t *lock_shards(pj_timer_heap_t *ht,
+                                    pj_timer_heap_t *shard,
+                                    pj_timer_entry *entry)
+{
+    for (;;) {
+        unsigned idx = entry->_timer_shard;
+        pj_timer_heap_t *last;
+
+        if (idx >= ht->shard_cnt || idx == shard->shard_idx) {
+            lock_timer_heap(shard);
+            if (entry->_timer_shard == idx)
+                return NULL;
+            unlock_timer_heap(shard);
+            continue;
+        }
+
+        last = ht->shards[idx];
+        if (idx < shard->shard_idx) {
+            lock_timer_heap(last);
+            lock_timer_heap(shard);
+        } else {
+            lock_timer_heap(shard);
+            lock_timer_heap(last);
+        }
+
+        /* The entry has been scheduled to another shard meanwhile */
+        if (entry->_timer_shard == idx)
+            return last;
+
+        unlock_timer_heap(last);
+        unlock_timer_heap(shard);
+    }
+}
+
+/*
+ * Create a new timer heap with the specified settings.
+ */
+PJ_DEF(pj_status_t) pj_timer_heap_create2( pj_pool_t *pool,
+                                           pj_size_t size,
+                                           const pj_timer_heap_cfg *cfg,
+                                           pj_timer_heap_t **p_heap)
+{
+    pj_timer_heap_cfg default_cfg;
     pj_timer_heap_t *ht;
     pj_size_t i;
 
@@ -597,6 +1086,21 @@ PJ_DEF(pj_status_t) pj_timer_heap_create( pj_pool_t *pool,
 
     *p_heap = NULL;
 
+    if (!cfg) {
+        pj_timer_heap_cfg_default(&default_cfg);
+        cfg = &default_cfg;
+    }
+
+#if PJ_TIMER_USE_LINKED_LIST
+    PJ_ASSERT_RETURN(cfg->type == PJ_TIMER_HEAP_BINARY, PJ_ENOTSUP);
+#else
+    PJ_ASSERT_RETURN(cfg->type == PJ_TIMER_HEAP_BINARY ||
+                     cfg->type == PJ_TIMER_HEAP_WHEEL, PJ_EINVAL);
+#endif
+
+    if (cfg->shard_cnt > 1)
+        return create_sharded(pool, size, cfg, p_heap);
+
     /* Magic? */
     size += 2;
 
@@ -645,6 +1149,25 @@ PJ_DEF(pj_status_t) pj_timer_heap_create( pj_pool_t *pool,
 
 #if PJ_TIMER_USE_LINKED_LIST
     pj_list_init(&ht->head_list);
+#else
+    if (cfg->type == PJ_TIMER_HEAP_WHEEL) {
+        pj_time_val now;
+        pj_status_t status;
+
+        ht->wheel = PJ_POOL_ZALLOC_T(pool, timer_wheel);
+        if (!ht->wheel)
+            return PJ_ENOMEM;
+
+        // wheel_grow() copies max_size elements, start from nothing.
+        ht->max_size = 0;
+        status = wheel_grow(ht, size);
+        ht->max_size = size;
+        if (status != PJ_SUCCESS)
+            return status;
+
+        pj_gettickcount(&now);
+        ht->wheel->cur_tick = TIME_TO_TICK(now);
+    }
 #endif
 
     *p_heap = ht;
@@ -653,6 +1176,23 @@ PJ_DEF(pj_status_t) pj_timer_heap_create( pj_pool_t *pool,
 
 PJ_DEF(void) pj_timer_heap_destroy( pj_timer_heap_t *ht )
 {
+    if (ht->shards) {
+        unsigned i;
+
+        for (i = 0; i < ht->shard_cnt; ++i) {
+            pj_pool_t *shard_pool = ht->shards[i]->pool;
+
+            pj_timer_heap_destroy(ht->shards[i]);
+            pj_pool_release(shard_pool);
+        }
+        ht->shard_cnt = 0;
+
+        if (ht->shard_tls_id != -1) {
+            pj_thread_local_free(ht->shard_tls_id);
+            ht->shard_tls_id = -1;
+        }
+    }
+
     if (ht->lock && ht->auto_delete_lock) {
         pj_lock_destroy(ht->lock);
         ht->lock = NULL;
@@ -674,11 +1214,33 @@ PJ_DEF(void) pj_timer_heap_set_lock(  pj_timer_heap_t *ht,
 PJ_DEF(unsigned) pj_timer_heap_set_max_timed_out_per_poll(pj_timer_heap_t *ht,
                                                           unsigned count )
 {
-    unsigned old_count = ht->max_entries_per_poll;
+    unsigned i, old_count = ht->max_entries_per_poll;
     ht->max_entries_per_poll = count;
+    for (i = 0; i < ht->shard_cnt; ++i)
+        ht->shards[i]->max_entries_per_poll = count;
     return old_count;
 }
 
+PJ_DEF(unsigned) pj_timer_heap_get_shard_cnt(pj_timer_heap_t *ht)
+{
+    PJ_ASSERT_RETURN(ht, 1);
+    return ht->shards? ht->shard_cnt : 1;
+}
+
+PJ_DEF(pj_status_t) pj_timer_heap_set_thread_shard(pj_timer_heap_t *ht,
+                                                   int shard_idx)
+{
+    PJ_ASSERT_RETURN(ht, PJ_EINVAL);
+    PJ_ASSERT_RETURN(ht->shards, PJ_EINVALIDOP);
+    PJ_ASSERT_RETURN(shard_idx < (int)ht->shard_cnt, PJ_EINVAL);
+
+    if (shard_idx < 0)
+        shard_idx = -1;
+
+    return pj_thread_local_set(ht->shard_tls_id,
+                               (void*)(pj_ssize_t)(shard_idx + 1));
+}
+
 PJ_DEF(pj_timer_entry*) pj_timer_entry_init( pj_timer_entry *entry,
                                              int id,
                                              void *user_data,
@@ -687,6 +1249,7 @@ PJ_DEF(pj_timer_entry*) pj_timer_entry_init( pj_timer_entry *entry,
     pj_assert(entry && cb);
 
     entry->_timer_id = -1;
+    entry->_timer_shard = 0;
     entry->id = id;
     entry->user_data = user_data;
     entry->cb = cb;
@@ -722,6 +1285,7 @@ static pj_status_t schedule_w_grp_lock(pj_timer_heap_t *ht,
 {
     pj_status_t status;
     pj_time_val expires;
+    pj_timer_heap_t *last_shard = NULL;
 
     PJ_ASSERT_RETURN(ht && entry && delay, PJ_EINVAL);
     PJ_ASSERT_RETURN(entry->cb != NULL, PJ_EINVAL);
@@ -732,10 +1296,19 @@ static pj_status_t schedule_w_grp_lock(pj_timer_heap_t *ht,
     pj_gettickcount(&expires);
     PJ_TIME_VAL_ADD(expires, *delay);
 
-    lock_timer_heap(ht);
+    if (ht->shards) {
+        pj_timer_heap_t *shard = select_shard(ht, entry, grp_lock);
+
+        last_shard = lock_shards(ht, shard, entry);
+        ht = shard;
+    } else {
+        lock_timer_heap(ht);
+    }
 
     /* Prevent same entry from being scheduled more than once */
     if (pj_timer_entry_running(entry)) {
+        if (last_shard)
+            unlock_timer_heap(last_shard);
         unlock_timer_heap(ht);
         PJ_LOG(3,(THIS_FILE, "Warning! Rescheduling outstanding entry (%p)",
                   entry));
@@ -748,6 +1321,7 @@ static pj_status_t schedule_w_grp_lock(pj_timer_heap_t *ht,
 
         if (set_id)
             GET_FIELD(timer_copy, id) = entry->id = id_val;
+        entry->_timer_shard = ht->shard_idx;
         timer_copy->_grp_lock = grp_lock;
         if (timer_copy->_grp_lock) {
             pj_grp_lock_add_ref(timer_copy->_grp_lock);
@@ -757,6 +1331,8 @@ static pj_status_t schedule_w_grp_lock(pj_timer_heap_t *ht,
         timer_copy->src_line = src_line;
 #endif
     }
+    if (last_shard)
+        unlock_timer_heap(last_shard);
     unlock_timer_heap(ht);
 
     return status;
@@ -805,6 +1381,11 @@ PJ_DEF(pj_status_t) pj_timer_heap_schedule_w_grp_lock(pj_timer_heap_t *ht,
 }
 #endif
 
+static int cancel_sharded_timer(pj_timer_heap_t *ht,
+                                pj_timer_entry *entry,
+                                unsigned flags,
+                                int id_val);
+
 static int cancel_timer(pj_timer_heap_t *ht,
                         pj_timer_entry *entry,
                         unsigned flags,
@@ -816,6 +1397,9 @@ static int cancel_timer(pj_timer_heap_t *ht,
 
     PJ_ASSERT_RETURN(ht && entry, PJ_EINVAL);
 
+    if (ht->shards)
+        return cancel_sharded_timer(ht, entry, flags, id_val);
+
     lock_timer_heap(ht);
 
     // Check to see if the timer_id is out of range
@@ -842,6 +1426,38 @@ static int cancel_timer(pj_timer_heap_t *ht,
     return count;
 }
 
+static int cancel_sharded_timer(pj_timer_heap_t *ht,
+                                pj_timer_entry *entry,
+                                unsigned flags,
+                                int id_val)
+{
+    for (;;) {
+        unsigned idx = entry->_timer_shard;
+        pj_timer_heap_t *shard;
+        int count;
+
+        if (idx >= ht->shard_cnt)
+            return 0;
+
+        shard = ht->shards[idx];
+        lock_timer_heap(shard);
+
+        /* The entry may have been rescheduled to another shard by another
+         * thread before we get the lock, retry with that shard.
+         */
+        if (entry->_timer_shard != idx) {
+            unlock_timer_heap(shard);
+            continue;
+        }
+
+        /* The shard lock is recursive */
+        count = cancel_timer(shard, entry, flags, id_val);
+        unlock_timer_heap(shard);
+
+        return count;
+    }
+}
+
 PJ_DEF(int) pj_timer_heap_cancel( pj_timer_heap_t *ht,
                                   pj_timer_entry *entry)
 {
@@ -855,16 +1471,42 @@ PJ_DEF(int) pj_timer_heap_cancel_if_active(pj_timer_heap_t *ht,
     return cancel_timer(ht, entry, F_SET_ID | F_DONT_ASSERT, id_val);
 }
 
+/* Poll the shard bound to the calling thread, or all shards. */
+static unsigned poll_shards(pj_timer_heap_t *ht, pj_time_val *next_delay)
+{
+    pj_size_t bound;
+    unsigned i, count = 0;
+
+    bound = (pj_size_t)pj_thread_local_get(ht->shard_tls_id);
+    if (bound)
+        return pj_timer_heap_poll(ht->shards[bound - 1], next_delay);
+
+    if (next_delay)
+        next_delay->sec = next_delay->msec = PJ_MAXINT32;
+
+    for (i = 0; i < ht->shard_cnt; ++i) {
+        pj_time_val delay;
+
+        count += pj_timer_heap_poll(ht->shards[i], &delay);
+        if (next_delay && PJ_TIME_VAL_LT(delay, *next_delay))
+            *next_delay = delay;
+    }
+
+    return count;
+}
+
 PJ_DEF(unsigned) pj_timer_heap_poll( pj_timer_heap_t *ht, 
                                      pj_time_val *next_delay )
 {
     pj_time_val now;
-    pj_time_val min_time_node = {0,0};
     unsigned count;
     pj_timer_id_t slot = 0;
 
     PJ_ASSERT_RETURN(ht, 0);
 
+    if (ht->shards)
+        return poll_shards(ht, next_delay);
+
     lock_timer_heap(ht);
     if (!ht->cur_size && next_delay) {
         next_delay->sec = next_delay->msec = PJ_MAXINT32;
@@ -875,16 +1517,9 @@ PJ_DEF(unsigned) pj_timer_heap_poll( pj_timer_heap_t *ht,
     count = 0;
     pj_gettickcount(&now);
 
-    if (ht->cur_size) {
-#if PJ_TIMER_USE_LINKED_LIST
-        slot = ht->timer_ids[GET_FIELD(ht->head_list.next, _timer_id)];
-#endif
-        min_time_node = ht->heap[slot]->_timer_value;
-    }
-
     while ( ht->cur_size && 
-            PJ_TIME_VAL_LTE(min_time_node, now) &&
-            count < ht->max_entries_per_poll ) 
+            count < ht->max_entries_per_poll &&
+            get_expired_slot(ht, &now, &slot) ) 
     {
         pj_timer_entry_dup *node = remove_node(ht, slot);
         pj_timer_entry *entry = GET_ENTRY(node);
@@ -922,8 +1557,9 @@ PJ_DEF(unsigned) pj_timer_heap_poll( pj_timer_heap_t *ht,
 
         PJ_RACE_ME(5);
 
+        /* Callback gets the timer heap known by the application */
         if (valid && entry->cb)
-            (*entry->cb)(ht, entry);
+            (*entry->cb)(ht->owner? ht->owner : ht, entry);
 
         if (valid && grp_lock)
             pj_grp_lock_dec_ref(grp_lock);
@@ -933,16 +1569,12 @@ PJ_DEF(unsigned) pj_timer_heap_poll( pj_timer_heap_t *ht,
         ///push_freelist(ht, node_timer_id);
 
         if (ht->cur_size) {
-#if PJ_TIMER_USE_LINKED_LIST
-            slot = ht->timer_ids[GET_FIELD(ht->head_list.next, _timer_id)];
-#endif
-            min_time_node = ht->heap[slot]->_timer_value;
             /* Update now */
             pj_gettickcount(&now);
         }
     }
     if (ht->cur_size && next_delay) {
-        *next_delay = ht->heap[0]->_timer_value;
+        get_earliest_time(ht, next_delay);
         if (count > 0)
             pj_gettickcount(&now);
         PJ_TIME_VAL_SUB(*next_delay, now);
@@ -960,18 +1592,47 @@ PJ_DEF(pj_size_t) pj_timer_heap_count( pj_timer_heap_t *ht )
 {
     PJ_ASSERT_RETURN(ht, 0);
 
+    if (ht->shards) {
+        pj_size_t count = 0;
+        unsigned i;
+
+        for (i = 0; i < ht->shard_cnt; ++i)
+            count += ht->shards[i]->cur_size;
+        return count;
+    }
+
     return ht->cur_size;
 }
 
 PJ_DEF(pj_status_t) pj_timer_heap_earliest_time( pj_timer_heap_t * ht,
                                                  pj_time_val *timeval)
 {
+    if (ht->shards) {
+        pj_bool_t found = PJ_FALSE;
+        unsigned i;
+
+        for (i = 0; i < ht->shard_cnt; ++i) {
+            pj_timer_heap_t *shard = ht->shards[i];
+            pj_time_val t;
+
+            lock_timer_heap(shard);
+            if (shard->cur_size) {
+                get_earliest_time(shard, &t);
+                if (!found || PJ_TIME_VAL_LT(t, *timeval))
+                    *timeval = t;
+                found = PJ_TRUE;
+            }
+            unlock_timer_heap(shard);
+        }
+        return found? PJ_SUCCESS : PJ_ENOTFOUND;
+    }
+
     pj_assert(ht->cur_size != 0);
     if (ht->cur_size == 0)
         return PJ_ENOTFOUND;
 
     lock_timer_heap(ht);
-    *timeval = ht->heap[0]->_timer_value;
+    get_earliest_time(ht, timeval);
     unlock_timer_heap(ht);
 
     return PJ_SUCCESS;
@@ -980,6 +1641,16 @@ PJ_DEF(pj_status_t) pj_timer_heap_earliest_time( pj_timer_heap_t * ht,
 #if PJ_TIMER_DEBUG
 PJ_DEF(void) pj_timer_heap_dump(pj_timer_heap_t *ht)
 {
+    if (ht->shards) {
+        unsigned i;
+
+        for (i = 0; i < ht->shard_cnt; ++i) {
+            PJ_LOG(3,(THIS_FILE, "Timer heap shard %d:", i));
+            pj_timer_heap_dump(ht->shards[i]);
+        }
+        return;
+    }
+
     lock_timer_heap(ht);
 
     PJ_LOG(3,(THIS_FILE, "Dumping timer heap:"));
@@ -1001,9 +1672,14 @@ PJ_DEF(void) pj_timer_heap_dump(pj_timer_heap_t *ht)
         pj_gettickcount(&now);
 
 #if !PJ_TIMER_USE_LINKED_LIST
-        for (i=0; i<(unsigned)ht->cur_size; ++i)
+        for (i=0; i<(unsigned)(ht->wheel? ht->max_size: ht->cur_size); ++i)
         {
-            pj_timer_entry_dup *e = ht->heap[i];
+            pj_timer_entry_dup *e;
+
+            // In timing wheel, the heap array is indexed by timer id.
+            if (ht->wheel && ht->timer_ids[i] < 0)
+                continue;
+            e = ht->heap[i];
 #else
         for (tmp_dup = ht->head_list.next; tmp_dup != &ht->head_list;
              tmp_dup = tmp_dup->next)
@@ -0,0 +1,347 @@
+/*
+ * Copyright (C) 2025 Teluu Inc. (http://www.teluu.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "test.h"
+
+/**
+ * \page page_pjlib_atomic_mpmc_queue_test Test: MPMC Atomic Queue
+ *
+ * This file provides implementation of \b atomic_mpmc_queue_test(). It
+ * tests the functionality of the multi-producer multi-consumer atomic
+ * queue, and benchmarks it against a mutex protected queue under
+ * contention.
+ *
+ * API tested:
+ *  - pj_atomic_mpmc_queue_create()
+ *  - pj_atomic_mpmc_queue_put()
+ *  - pj_atomic_mpmc_queue_get()
+ *  - pj_atomic_mpmc_queue_size()
+ *  - pj_atomic_mpmc_queue_destroy()
+ *
+ * This file is <b>pjlib-test/atomic_mpmc_queue.c</b>
+ *
+ * \include pjlib-test/atomic_mpmc_queue.c
+ */
+
+#if INCLUDE_ATOMIC_MPMC_QUEUE_TEST
+
+#include <pjlib.h>
+
+#define THIS_FILE           "atomic_mpmc_queue.c"
+#define QUEUE_SIZE          256
+#define PRODUCER_CNT        4
+#define CONSUMER_CNT        4
+#define ITEMS_PER_PRODUCER  200000
+
+typedef struct item_t
+{
+    unsigned    producer;
+    unsigned    seq;
+} item_t;
+
+/* Interface of the queues being tested, so the same threads can run
+ * against the atomic queue and the mutex protected queue.
+ */
+typedef struct queue_op
+{
+    const char *name;
+    pj_status_t (*put)(void *q, const item_t *item);
+    pj_status_t (*get)(void *q, item_t *item);
+} queue_op;
+
+/* Mutex protected ring buffer, for comparison */
+typedef struct mutex_queue
+{
+    pj_mutex_t *mutex;
+    item_t      items[QUEUE_SIZE];
+    unsigned    head;
+    unsigned    cnt;
+} mutex_queue;
+
+struct thread_param
+{
+    const queue_op  *op;
+    void            *q;
+    unsigned         idx;
+    pj_atomic_t     *consumed;
+    unsigned         total;
+    pj_uint64_t      sum;
+    unsigned         last_seq[PRODUCER_CNT];
+    int              err;
+};
+
+static pj_status_t atomic_put(void *q, const item_t *item)
+{
+    return pj_atomic_mpmc_queue_put((pj_atomic_mpmc_queue_t*)q, item);
+}
+
+static pj_status_t atomic_get(void *q, item_t *item)
+{
+    return pj_atomic_mpmc_queue_get((pj_atomic_mpmc_queue_t*)q, item);
+}
+
+static pj_status_t mutex_put(void *q, const item_t *item)
+{
+    mutex_queue *mq = (mutex_queue*)q;
+    pj_status_t status = PJ_SUCCESS;
+
+    pj_mutex_lock(mq->mutex);
+    if (mq->cnt == QUEUE_SIZE) {
+        status = PJ_ETOOMANY;
+    } else {
+        mq->items[(mq->head + mq->cnt) % QUEUE_SIZE] = *item;
+        ++mq->cnt;
+    }
+    pj_mutex_unlock(mq->mutex);
+    return status;
+}
+
+static pj_status_t mutex_get(void *q, item_t *item)
+{
+    mutex_queue *mq = (mutex_queue*)q;
+    pj_status_t status = PJ_SUCCESS;
+
+    pj_mutex_lock(mq->mutex);
+    if (mq->cnt == 0) {
+        status = PJ_ENOTFOUND;
+    } else {
+        *item = mq->items[mq->head];
+        mq->head = (mq->head + 1) % QUEUE_SIZE;
+        --mq->cnt;
+    }
+    pj_mutex_unlock(mq->mutex);
+    return status;
+}
+
+static const queue_op atomic_queue_op = { "atomic mpmc", &atomic_put,
+                                          &atomic_get };
+static const queue_op mutex_queue_op = { "mutex", &mutex_put, &mutex_get };
+
+static int producer_thread(void *arg)
+{
+    struct thread_param *prm = (struct thread_param*)arg;
+    unsigned i;
+
+    for (i = 1; i <= ITEMS_PER_PRODUCER; ++i) {
+        item_t item;
+
+        item.producer = prm->idx;
+        item.seq = i;
+        while (prm->op->put(prm->q, &item) != PJ_SUCCESS)
+            pj_thread_sleep(0);
+    }
+    return 0;
+}
+
+static int consumer_thread(void *arg)
+{
+    struct thread_param *prm = (struct thread_param*)arg;
+    const unsigned total = PRODUCER_CNT * ITEMS_PER_PRODUCER;
+
+    while (pj_atomic_get(prm->consumed) < (pj_atomic_value_t)total) {
+        item_t item;
+
+        if (prm->op->get(prm->q, &item) != PJ_SUCCESS) {
+            pj_thread_sleep(0);
+            continue;
+        }
+        pj_atomic_inc(prm->consumed);
+
+        if (item.producer >= PRODUCER_CNT || item.seq == 0 ||
+            item.seq > ITEMS_PER_PRODUCER)
+        {
+            prm->err = -100;
+            continue;
+        }
+
+        /* Items of the same producer must come out in order */
+        if (item.seq <= prm->last_seq[item.producer])
+            prm->err = -110;
+        prm->last_seq[item.producer] = item.seq;
+
+        ++prm->total;
+        prm->sum += item.seq;
+    }
+    return 0;
+}
+
+static int run_threads(pj_pool_t *pool, const queue_op *op, void *q,
+                       pj_timestamp *elapsed)
+{
+    struct thread_param prm[PRODUCER_CNT + CONSUMER_CNT];
+    pj_thread_t *thread[PRODUCER_CNT + CONSUMER_CNT];
+    pj_atomic_t *consumed;
+    pj_timestamp t1, t2;
+    pj_uint64_t sum = 0, expected_sum;
+    unsigned i, total = 0;
+    int rc = 0;
+
+    PJ_TEST_SUCCESS(pj_atomic_create(pool, 0, &consumed), NULL, return -10);
+
+    pj_bzero(prm, sizeof(prm));
+    pj_bzero(thread, sizeof(thread));
+    pj_get_timestamp(&t1);
+
+    for (i = 0; i < PRODUCER_CNT + CONSUMER_CNT; ++i) {
+        pj_bool_t is_producer = (i < PRODUCER_CNT);
+
+        prm[i].op = op;
+        prm[i].q = q;
+        prm[i].idx = is_producer? i : i - PRODUCER_CNT;
+        prm[i].consumed = consumed;
+        PJ_TEST_SUCCESS(pj_thread_create(pool, "mpmcq",
+                                         is_producer? &producer_thread :
+                                                      &consumer_thread,
+                                         &prm[i], 0, 0, &thread[i]),
+                        NULL, { rc = -20; goto on_return; });
+    }
+
+on_return:
+    for (i = 0; i < PRODUCER_CNT + CONSUMER_CNT; ++i) {
+        if (thread[i]) {
+            pj_thread_join(thread[i]);
+            pj_thread_destroy(thread[i]);
+        }
+    }
+    pj_get_timestamp(&t2);
+    *elapsed = t2;
+    pj_sub_timestamp(elapsed, &t1);
+    pj_atomic_destroy(consumed);
+
+    if (rc != 0)
+        return rc;
+
+    for (i = PRODUCER_CNT; i < PRODUCER_CNT + CONSUMER_CNT; ++i) {
+        PJ_TEST_EQ(prm[i].err, 0, op->name, return prm[i].err);
+        total += prm[i].total;
+        sum += prm[i].sum;
+    }
+
+    /* Every item must be received exactly once */
+    expected_sum = (pj_uint64_t)PRODUCER_CNT * ITEMS_PER_PRODUCER *
+                   (ITEMS_PER_PRODUCER + 1) / 2;
+    PJ_TEST_EQ(total, PRODUCER_CNT * ITEMS_PER_PRODUCER, op->name,
+               return -30);
+    PJ_TEST_TRUE(sum == expected_sum, op->name, return -40);
+
+    return 0;
+}
+
+static int basic_test(pj_pool_t *pool)
+{
+    pj_atomic_mpmc_queue_t *q;
+    item_t item;
+    unsigned i;
+
+    PJ_TEST_SUCCESS(pj_atomic_mpmc_queue_create(pool, 5, sizeof(item_t),
+                                                "mpmcq", &q),
+                    NULL, return -200);
+
+    /* Capacity is rounded up to 8 */
+    for (i = 0; i < 8; ++i) {
+        item.producer = 0;
+        item.seq = i;
+        PJ_TEST_SUCCESS(pj_atomic_mpmc_queue_put(q, &item), NULL,
+                        return -210);
+    }
+    PJ_TEST_EQ(pj_atomic_mpmc_queue_size(q), 8, NULL, return -220);
+    PJ_TEST_EQ(pj_atomic_mpmc_queue_put(q, &item), PJ_ETOOMANY, NULL,
+               return -230);
+
+    /* Wrap around a few times */
+    for (i = 0; i < 20; ++i) {
+        PJ_TEST_SUCCESS(pj_atomic_mpmc_queue_get(q, &item), NULL,
+                        return -240);
+        PJ_TEST_EQ(item.seq, i, NULL, return -250);
+
+        item.seq = i + 8;
+        PJ_TEST_SUCCESS(pj_atomic_mpmc_queue_put(q, &item), NULL,
+                        return -260);
+    }
+
+    for (i = 20; i < 28; ++i) {
+        PJ_TEST_SUCCESS(pj_atomic_mpmc_queue_get(q, &item), NULL,
+                        return -270);
+        PJ_TEST_EQ(item.seq, i, NULL, return -280);
+    }
+    PJ_TEST_EQ(pj_atomic_mpmc_queue_size(q), 0, NULL, return -290);
+    PJ_TEST_EQ(pj_atomic_mpmc_queue_get(q, &item), PJ_ENOTFOUND, NULL,
+               return -300);
+
+    pj_atomic_mpmc_queue_destroy(q);
+    return 0;
+}
+
+int atomic_mpmc_queue_test()
+{
+    pj_pool_t *pool;
+    pj_atomic_mpmc_queue_t *q = NULL;
+    mutex_queue *mq = NULL;
+    pj_timestamp freq, elapsed;
+    const unsigned total = PRODUCER_CNT * ITEMS_PER_PRODUCER;
+    int rc;
+
+    pool = pj_pool_create(mem, "mpmcq", 4000, 4000, NULL);
+    PJ_TEST_NOT_NULL(pool, NULL, return -1);
+
+    rc = basic_test(pool);
+    if (rc != 0)
+        goto on_return;
+
+    PJ_TEST_SUCCESS(pj_get_timestamp_freq(&freq), NULL,
+                    { rc = -2; goto on_return; });
+
+    PJ_LOG(3,(THIS_FILE, "  %d producers, %d consumers, %d items",
+              PRODUCER_CNT, CONSUMER_CNT, total));
+
+    PJ_TEST_SUCCESS(pj_atomic_mpmc_queue_create(pool, QUEUE_SIZE,
+                                                sizeof(item_t), "mpmcq", &q),
+                    NULL, { rc = -3; goto on_return; });
+    rc = run_threads(pool, &atomic_queue_op, q, &elapsed);
+    if (rc != 0)
+        goto on_return;
+    PJ_LOG(3,(THIS_FILE, "    %s: %u items/sec", atomic_queue_op.name,
+              (unsigned)(freq.u64 * total / (elapsed.u64? elapsed.u64:1))));
+
+#if WITH_BENCHMARK
+    mq = PJ_POOL_ZALLOC_T(pool, mutex_queue);
+    PJ_TEST_SUCCESS(pj_mutex_create_simple(pool, "mpmcq", &mq->mutex), NULL,
+                    { rc = -4; goto on_return; });
+    rc = run_threads(pool, &mutex_queue_op, mq, &elapsed);
+    if (rc != 0)
+        goto on_return;
+    PJ_LOG(3,(THIS_FILE, "    %s: %u items/sec", mutex_queue_op.name,
+              (unsigned)(freq.u64 * total / (elapsed.u64? elapsed.u64:1))));
+#else
+    PJ_UNUSED_ARG(mutex_queue_op);
+#endif
+
+on_return:
+    if (q)
+        pj_atomic_mpmc_queue_destroy(q);
+    if (mq && mq->mutex)
+        pj_mutex_destroy(mq->mutex);
+    pj_pool_release(pool);
+    return rc;
+}
+
+#else
+/* To prevent warning about "translation unit is empty"
+ * when this test is disabled.
+ */
+int dummy_atomic_mpmc_queue_test;
+#endif  /* INCLUDE_ATOMIC_MPMC_QUEUE_TEST */
@@ -20,6 +20,8 @@
 #include <pj/rand.h>
 #include <pj/log.h>
 #include <pj/pool.h>
+#include <pj/os.h>
+#include <pj/string.h>
 #include "test.h"
 
 #if INCLUDE_HASH_TEST
@@ -28,14 +30,21 @@
 #define THIS_FILE   "hash_test.c"
 
 
-static int hash_test_with_key(pj_pool_t *pool, unsigned char key)
+static const char *get_type_name(pj_hash_type type)
+{
+    return type==PJ_HASH_TYPE_CHAINED ? "chained" : "open addressing";
+}
+
+static int hash_test_with_key(pj_pool_t *pool, pj_hash_type type,
+                              unsigned char key)
 {
     pj_hash_table_t *ht;
     unsigned value = 0x12345;
     pj_hash_iterator_t it_buf, *it;
     unsigned *entry;
 
-    PJ_TEST_NOT_NULL( (ht=pj_hash_create(pool, HASH_COUNT)), NULL, return -10);
+    PJ_TEST_NOT_NULL( (ht=pj_hash_create2(pool, HASH_COUNT, type)), NULL,
+                      return -10);
 
     pj_hash_set(pool, ht, &key, sizeof(key), 0, &value);
 
@@ -61,7 +70,7 @@ static int hash_test_with_key(pj_pool_t *pool, unsigned char key)
 }
 
 
-static int hash_collision_test(pj_pool_t *pool)
+static int hash_collision_test(pj_pool_t *pool, pj_hash_type type)
 {
     enum {
         COUNT = HASH_COUNT * 4
@@ -71,7 +80,8 @@ static int hash_collision_test(pj_pool_t *pool)
     unsigned char *values;
     unsigned i;
 
-    PJ_TEST_NOT_NULL((ht=pj_hash_create(pool, HASH_COUNT)), NULL, return -200);
+    PJ_TEST_NOT_NULL((ht=pj_hash_create2(pool, HASH_COUNT, type)), NULL,
+                     return -200);
 
     values = (unsigned char*) pj_pool_alloc(pool, COUNT);
 
@@ -101,29 +111,211 @@ static int hash_collision_test(pj_pool_t *pool)
 }
 
 
+/* Add and delete many entries, so open addressing table is resized and
+ * rehashed, and check case-insensitive lookup and deletion while
+ * iterating.
+ */
+static int hash_grow_test(pj_pool_t *pool, pj_hash_type type)
+{
+    enum {
+        COUNT = 2000,
+        ROUNDS = 4
+    };
+    pj_hash_table_t *ht;
+    pj_hash_iterator_t it_buf, *it;
+    char key[32], upper[32];
+    unsigned i, round, n;
+
+    PJ_TEST_NOT_NULL((ht=pj_hash_create2(pool, 8, type)), NULL, return -300);
+
+    for (round=0; round<ROUNDS; ++round) {
+        /* Add */
+        for (i=0; i<COUNT; ++i) {
+            pj_str_t k;
+
+            pj_ansi_snprintf(key, sizeof(key), "key-%u-%u", round, i);
+            pj_strdup2(pool, &k, key);
+            pj_hash_set_lower(pool, ht, k.ptr, (unsigned)k.slen, 0,
+                              (void*)(pj_ssize_t)(i+1));
+        }
+        PJ_TEST_EQ(pj_hash_count(ht), COUNT, NULL, return -310);
+
+        /* Find with different case */
+        for (i=0; i<COUNT; ++i) {
+            void *value;
+            pj_uint32_t hval = 0;
+
+            pj_ansi_snprintf(upper, sizeof(upper), "KEY-%u-%u", round, i);
+            value = pj_hash_get_lower(ht, upper, PJ_HASH_KEY_STRING, &hval);
+            PJ_TEST_EQ(value, (void*)(pj_ssize_t)(i+1), upper, return -320);
+
+            /* With precalculated hash */
+            value = pj_hash_get_lower(ht, upper, PJ_HASH_KEY_STRING, &hval);
+            PJ_TEST_EQ(value, (void*)(pj_ssize_t)(i+1), upper, return -325);
+
+            /* Case sensitive lookup must not find it */
+            PJ_TEST_EQ(pj_hash_get(ht, upper, PJ_HASH_KEY_STRING, NULL),
+                       NULL, upper, return -330);
+        }
+
+        /* Previous round's keys are gone */
+        pj_ansi_snprintf(key, sizeof(key), "key-%u-%u", round-1, 0);
+        PJ_TEST_EQ(pj_hash_get_lower(ht, key, PJ_HASH_KEY_STRING, NULL),
+                   NULL, key, return -340);
+
+        /* Delete all while iterating */
+        n = 0;
+        it = pj_hash_first(ht, &it_buf);
+        while (it) {
+            pj_hash_iterator_t *next;
+            pj_ssize_t idx = (pj_ssize_t)pj_hash_this(ht, it) - 1;
+
+            next = pj_hash_next(ht, it);
+            pj_ansi_snprintf(key, sizeof(key), "key-%u-%u", round,
+                             (unsigned)idx);
+            pj_hash_set_lower(NULL, ht, key, PJ_HASH_KEY_STRING, 0, NULL);
+            ++n;
+            it = next;
+        }
+        PJ_TEST_EQ(n, COUNT, NULL, return -350);
+        PJ_TEST_EQ(pj_hash_count(ht), 0, NULL, return -360);
+    }
+
+    return 0;
+}
+
+
+#if WITH_BENCHMARK
+/* Lookup and insert/delete throughput. The table holds ENTRY_CNT entries
+ * with keys similar to SIP transaction keys, which is more than the
+ * table size so the chained table has long chains.
+ */
+static int hash_bench(pj_pool_t *pool, pj_hash_type type)
+{
+    enum {
+        TABLE_SIZE = 1024,
+        ENTRY_CNT = 16384,
+        OPS_CNT = 1000000
+    };
+    pj_hash_table_t *ht;
+    pj_str_t *keys;
+    pj_uint32_t *hvals;
+    pj_hash_entry_buf *bufs;
+    pj_timestamp t1, t2;
+    pj_uint32_t usec;
+    unsigned i, found = 0;
+
+    ht = pj_hash_create2(pool, TABLE_SIZE, type);
+    PJ_TEST_NOT_NULL(ht, NULL, return -400);
+
+    keys = (pj_str_t*) pj_pool_calloc(pool, ENTRY_CNT, sizeof(pj_str_t));
+    hvals = (pj_uint32_t*) pj_pool_calloc(pool, ENTRY_CNT,
+                                          sizeof(pj_uint32_t));
+    bufs = (pj_hash_entry_buf*) pj_pool_calloc(pool, ENTRY_CNT,
+                                               sizeof(pj_hash_entry_buf));
+    for (i=0; i<ENTRY_CNT; ++i) {
+        char key[64];
+
+        pj_ansi_snprintf(key, sizeof(key),
+                         "c$z9hG4bKPj%08x-%04x$10.0.0.1:5060$INVITE",
+                         pj_rand(), i);
+        pj_strdup2(pool, &keys[i], key);
+        hvals[i] = pj_hash_calc_tolower(0, NULL, &keys[i]);
+    }
+
+    /* Insert */
+    pj_get_timestamp(&t1);
+    for (i=0; i<ENTRY_CNT; ++i) {
+        pj_hash_set_np_lower(ht, keys[i].ptr, (unsigned)keys[i].slen,
+                             hvals[i], bufs[i], &keys[i]);
+    }
+    pj_get_timestamp(&t2);
+    usec = pj_elapsed_usec(&t1, &t2);
+    PJ_LOG(3,(THIS_FILE, "    %s: insert %d entries: %u usec",
+              get_type_name(type), ENTRY_CNT, usec));
+
+    /* Lookup */
+    pj_get_timestamp(&t1);
+    for (i=0; i<OPS_CNT; ++i) {
+        unsigned idx = (i * 7919) % ENTRY_CNT;
+        if (pj_hash_get_lower(ht, keys[idx].ptr, (unsigned)keys[idx].slen,
+                              &hvals[idx]))
+        {
+            ++found;
+        }
+    }
+    pj_get_timestamp(&t2);
+    usec = pj_elapsed_usec(&t1, &t2);
+    PJ_TEST_EQ(found, OPS_CNT, NULL, return -410);
+    PJ_LOG(3,(THIS_FILE, "    %s: %d lookups: %u usec (%u lookups/sec)",
+              get_type_name(type), OPS_CNT, usec,
+              (unsigned)(OPS_CNT * 1000000.0 / (usec ? usec : 1))));
+
+    /* Delete and insert, like transactions being created and destroyed */
+    pj_get_timestamp(&t1);
+    for (i=0; i<OPS_CNT; ++i) {
+        unsigned idx = (i * 7919) % ENTRY_CNT;
+        pj_hash_set_np_lower(ht, keys[idx].ptr, (unsigned)keys[idx].slen,
+                             hvals[idx], NULL, NULL);
+        pj_hash_set_np_lower(ht, keys[idx].ptr, (unsigned)keys[idx].slen,
+                             hvals[idx], bufs[idx], &keys[idx]);
+    }
+    pj_get_timestamp(&t2);
+    usec = pj_elapsed_usec(&t1, &t2);
+    PJ_TEST_EQ(pj_hash_count(ht), ENTRY_CNT, NULL, return -420);
+    PJ_LOG(3,(THIS_FILE, "    %s: %d delete+insert: %u usec (%u ops/sec)",
+              get_type_name(type), OPS_CNT, usec,
+              (unsigned)(OPS_CNT * 1000000.0 / (usec ? usec : 1))));
+
+    return 0;
+}
+#endif  /* WITH_BENCHMARK */
+
+
 /*
  * Hash table test.
  */
 int hash_test(void)
 {
     pj_pool_t *pool = pj_pool_create(mem, "hash", 512, 512, NULL);
+    pj_hash_type types[] = { PJ_HASH_TYPE_CHAINED,
+                             PJ_HASH_TYPE_OPEN_ADDRESSING };
     int rc;
-    unsigned i;
+    unsigned i, t;
+
+    for (t=0; t<PJ_ARRAY_SIZE(types); ++t) {
+        PJ_LOG(3,(THIS_FILE, "  %s hash table", get_type_name(types[t])));
+
+        /* Test to fill in each row in the table */
+        for (i=0; i<=HASH_COUNT; ++i) {
+            rc = hash_test_with_key(pool, types[t], (unsigned char)i);
+            if (rc != 0) {
+                pj_pool_release(pool);
+                return rc;
+            }
+        }
 
-    /* Test to fill in each row in the table */
-    for (i=0; i<=HASH_COUNT; ++i) {
-        rc = hash_test_with_key(pool, (unsigned char)i);
+        /* Collision test */
+        rc = hash_collision_test(pool, types[t]);
         if (rc != 0) {
             pj_pool_release(pool);
             return rc;
         }
-    }
 
-    /* Collision test */
-    rc = hash_collision_test(pool);
-    if (rc != 0) {
-        pj_pool_release(pool);
-        return rc;
+        /* Grow test */
+        rc = hash_grow_test(pool, types[t]);
+        if (rc != 0) {
+            pj_pool_release(pool);
+            return rc;
+        }
+
+#if WITH_BENCHMARK
+        rc = hash_bench(pool, types[t]);
+        if (rc != 0) {
+            pj_pool_release(pool);
+            return rc;
+        }
+#endif
     }
 
     pj_pool_release(pool);
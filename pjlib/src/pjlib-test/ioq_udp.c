@@ -675,6 +675,207 @@ static int many_handles_test(const pj_ioqueue_cfg *cfg)
     return 0;
 }
 
+/*
+ * Multiple pending recvfrom() on a single socket. Each datagram must
+ * complete exactly one operation, in the order the operations were
+ * submitted, whether the backend reads the datagrams one by one or in a
+ * batch (PJ_IOQUEUE_MAX_RECV_BATCH). The datagrams are sent with
+ * pj_ioqueue_sendto_batch().
+ */
+typedef struct batch_recv_op
+{
+    pj_ioqueue_op_key_t  op_key;
+    char                 buf[64];
+    pj_ssize_t           len;
+    pj_sockaddr_in       src;
+    int                  src_len;
+    pj_bool_t            done;
+} batch_recv_op;
+
+static void on_read_complete_batch(pj_ioqueue_key_t *key,
+                                   pj_ioqueue_op_key_t *op_key,
+                                   pj_ssize_t bytes_read)
+{
+    unsigned *p_packet_cnt = (unsigned*) pj_ioqueue_get_user_data(key);
+    batch_recv_op *op = (batch_recv_op*) op_key;
+
+    op->len = bytes_read;
+    op->done = PJ_TRUE;
+    (*p_packet_cnt)++;
+}
+
+static int batch_test(const pj_ioqueue_cfg *cfg)
+{
+    enum { COUNT = 8 };
+    pj_pool_t *pool;
+    pj_ioqueue_t *ioqueue = NULL;
+    pj_ioqueue_key_t *key = NULL, *ckey = NULL;
+    pj_sock_sendto_msg msg[COUNT];
+    char pkt[COUNT][32];
+    unsigned sent_cnt;
+    pj_sock_t ssock = PJ_INVALID_SOCKET, csock = PJ_INVALID_SOCKET;
+    pj_sockaddr_in saddr, caddr;
+    pj_ioqueue_callback cb;
+    batch_recv_op *ops;
+    unsigned packet_cnt = 0;
+    pj_time_val timeout;
+    pj_timestamp t1, t2;
+    int addrlen, i, rc = 0;
+    pj_status_t status;
+
+    PJ_LOG(3,(THIS_FILE,"...batch send/receive test"));
+
+    pool = pj_pool_create(mem, NULL, 4000, 4000, NULL);
+    if (!pool)
+        return PJ_ENOMEM;
+
+    ops = (batch_recv_op*) pj_pool_zalloc(pool, COUNT*sizeof(*ops));
+
+    status = pj_sock_socket(pj_AF_INET(), pj_SOCK_DGRAM(), 0, &ssock);
+    if (status == PJ_SUCCESS)
+        status = pj_sock_socket(pj_AF_INET(), pj_SOCK_DGRAM(), 0, &csock);
+    if (status != PJ_SUCCESS) {
+        app_perror("...error in pj_sock_socket", status);
+        rc = -200; goto on_return;
+    }
+
+    pj_sockaddr_in_init(&saddr, NULL, 0);
+    saddr.sin_addr = pj_inet_addr2("127.0.0.1");
+    caddr = saddr;
+    status = pj_sock_bind(ssock, &saddr, sizeof(saddr));
+    if (status == PJ_SUCCESS)
+        status = pj_sock_bind(csock, &caddr, sizeof(caddr));
+    if (status != PJ_SUCCESS) {
+        app_perror("...error in pj_sock_bind", status);
+        rc = -210; goto on_return;
+    }
+
+    addrlen = sizeof(saddr);
+    pj_sock_getsockname(ssock, &saddr, &addrlen);
+    addrlen = sizeof(caddr);
+    pj_sock_getsockname(csock, &caddr, &addrlen);
+
+    status = pj_ioqueue_create2(pool, 4, cfg, &ioqueue);
+    if (status != PJ_SUCCESS) {
+        app_perror("...error in pj_ioqueue_create", status);
+        rc = -220; goto on_return;
+    }
+
+    pj_bzero(&cb, sizeof(cb));
+    cb.on_read_complete = &on_read_complete_batch;
+    status = pj_ioqueue_register_sock(pool, ioqueue, ssock, &packet_cnt,
+                                      &cb, &key);
+    if (status != PJ_SUCCESS) {
+        app_perror("...error in pj_ioqueue_register_sock", status);
+        rc = -230; goto on_return;
+    }
+
+    pj_bzero(&cb, sizeof(cb));
+    status = pj_ioqueue_register_sock(pool, ioqueue, csock, NULL,
+                                      &cb, &ckey);
+    if (status != PJ_SUCCESS) {
+        app_perror("...error in pj_ioqueue_register_sock", status);
+        rc = -232; goto on_return;
+    }
+
+    for (i=0; i<COUNT; ++i) {
+        pj_ssize_t len = sizeof(ops[i].buf);
+
+        pj_ioqueue_op_key_init(&ops[i].op_key, sizeof(ops[i].op_key));
+        ops[i].src_len = sizeof(ops[i].src);
+        status = pj_ioqueue_recvfrom(key, &ops[i].op_key, ops[i].buf, &len,
+                                     PJ_IOQUEUE_ALWAYS_ASYNC,
+                                     &ops[i].src, &ops[i].src_len);
+        if (status != PJ_EPENDING) {
+            app_perror("...error in pj_ioqueue_recvfrom", status);
+            rc = -240; goto on_return;
+        }
+    }
+
+    /* Each datagram carries its sequence number in every byte and has a
+     * different length.
+     */
+    for (i=0; i<COUNT; ++i) {
+        pj_memset(pkt[i], i, sizeof(pkt[i]));
+        msg[i].buf = pkt[i];
+        msg[i].len = i + 1;
+        msg[i].addr = &saddr;
+        msg[i].addr_len = sizeof(saddr);
+    }
+
+    sent_cnt = COUNT;
+    status = pj_ioqueue_sendto_batch(ckey, msg, &sent_cnt, 0);
+    if (status != PJ_SUCCESS) {
+        app_perror("...error in pj_ioqueue_sendto_batch", status);
+        rc = -250; goto on_return;
+    }
+    if (sent_cnt != COUNT) {
+        PJ_LOG(1,(THIS_FILE, "....error: only %d of %d datagrams sent",
+                             sent_cnt, COUNT));
+        rc = -252; goto on_return;
+    }
+    for (i=0; i<COUNT; ++i) {
+        if (msg[i].len != i + 1) {
+            PJ_LOG(1,(THIS_FILE, "....error: datagram %d sent %d bytes, "
+                                 "expecting %d", i, (int)msg[i].len, i + 1));
+            rc = -254; goto on_return;
+        }
+    }
+
+    pj_get_timestamp(&t1);
+    while (packet_cnt < COUNT) {
+        timeout.sec = 0; timeout.msec = 100;
+        pj_ioqueue_poll(ioqueue, &timeout);
+
+        pj_get_timestamp(&t2);
+        if (pj_elapsed_msec(&t1, &t2) > 5000) {
+            PJ_LOG(1,(THIS_FILE, "....error: timed out, only %d of %d "
+                                 "datagrams received", packet_cnt, COUNT));
+            rc = -260; goto on_return;
+        }
+    }
+
+    for (i=0; i<COUNT; ++i) {
+        int j;
+
+        if (!ops[i].done || ops[i].len != i + 1) {
+            PJ_LOG(1,(THIS_FILE, "....error: operation %d got %d bytes, "
+                                 "expecting %d", i, (int)ops[i].len, i + 1));
+            rc = -270; goto on_return;
+        }
+        for (j=0; j<ops[i].len; ++j) {
+            if (ops[i].buf[j] != (char)i) {
+                PJ_LOG(1,(THIS_FILE, "....error: operation %d got wrong "
+                                     "content", i));
+                rc = -280; goto on_return;
+            }
+        }
+        if (ops[i].src.sin_port != caddr.sin_port ||
+            ops[i].src_len != (int)sizeof(caddr))
+        {
+            PJ_LOG(1,(THIS_FILE, "....error: operation %d got wrong source "
+                                 "address", i));
+            rc = -290; goto on_return;
+        }
+    }
+
+    PJ_LOG(3,(THIS_FILE,"....batch_test() ok"));
+
+on_return:
+    if (key)
+        pj_ioqueue_unregister(key);
+    else if (ssock != PJ_INVALID_SOCKET)
+        pj_sock_close(ssock);
+    if (ckey)
+        pj_ioqueue_unregister(ckey);
+    else if (csock != PJ_INVALID_SOCKET)
+        pj_sock_close(csock);
+    if (ioqueue)
+        pj_ioqueue_destroy(ioqueue);
+    pj_pool_release(pool);
+    return rc;
+}
+
 #if PJ_HAS_THREADS
 typedef struct parallel_recv_data
 {
@@ -1203,6 +1404,10 @@ static int udp_ioqueue_test_imp(const pj_ioqueue_cfg *cfg)
     if ((status=many_handles_test(cfg)) != 0) {
         return status;
     }
+
+    if ((status=batch_test(cfg)) != 0) {
+        return status;
+    }
     
     //return 0;
 
@@ -21,6 +21,7 @@
 #include <pj/rand.h>
 #include <pj/log.h>
 #include <pj/except.h>
+#include <pj/os.h>
 #include <pj/unittest.h>
 #include "test.h"
 
@@ -351,6 +352,129 @@ static int pool_buf_test(void)
     return 0;
 }
 
+#if PJ_HAS_POOL_ALT_API == 0 && PJ_HAS_THREADS
+/* Test caching pool with per-thread cache */
+enum {
+    TC_THREAD_CNT = 4,
+    TC_LOOP = 20000,
+    TC_HELD = 8
+};
+
+static struct tc_test_t
+{
+    pj_caching_pool  cp;
+    pj_pool_t       *pool;
+    pj_mutex_t      *mutex;
+    pj_pool_t       *handover;   /* pool to be released by another thread */
+    int              rc;
+} tc_test;
+
+static int tc_worker(void *arg)
+{
+    pj_pool_t *held[TC_HELD];
+    unsigned i;
+
+    PJ_UNUSED_ARG(arg);
+    pj_bzero(held, sizeof(held));
+
+    for (i=0; i<TC_LOOP && tc_test.rc==0; ++i) {
+        unsigned slot = pj_rand() % TC_HELD;
+        pj_size_t size = 256 << (pj_rand() % 9);
+        pj_pool_t *pool;
+
+        if (held[slot]) {
+            pj_pool_release(held[slot]);
+            held[slot] = NULL;
+        }
+
+        pool = pj_pool_create(&tc_test.cp.factory, "tc", size, 512, NULL);
+        if (!pool || !pj_pool_alloc(pool, size/2)) {
+            tc_test.rc = -300;
+            break;
+        }
+
+        /* Once in a while, swap the pool with another thread's so that
+         * pools are released by threads other than the creator.
+         */
+        if ((i & 15) == 0) {
+            pj_mutex_lock(tc_test.mutex);
+            held[slot] = tc_test.handover;
+            tc_test.handover = pool;
+            pj_mutex_unlock(tc_test.mutex);
+        } else {
+            held[slot] = pool;
+        }
+    }
+
+    for (i=0; i<TC_HELD; ++i) {
+        if (held[i])
+            pj_pool_release(held[i]);
+    }
+    pj_caching_pool_flush_thread_cache(&tc_test.cp);
+
+    return 0;
+}
+
+static int thread_cache_test(void)
+{
+    pj_pool_t *pool, *pool2;
+    pj_thread_t *threads[TC_THREAD_CNT];
+    unsigned i;
+    int rc = 0;
+
+    PJ_LOG(3,("test", "...thread cache test"));
+
+    pj_bzero(&tc_test, sizeof(tc_test));
+    pj_caching_pool_init(&tc_test.cp, NULL, 256*1024);
+    PJ_TEST_SUCCESS(pj_caching_pool_set_thread_cache(&tc_test.cp, 8),
+                    NULL, { rc=-200; goto on_return; });
+
+    /* Released pool must be reused by the same thread */
+    pool = pj_pool_create(&tc_test.cp.factory, "tc", 1000, 1000, NULL);
+    PJ_TEST_NOT_NULL(pool, NULL, { rc=-210; goto on_return; });
+    pj_pool_release(pool);
+    pool2 = pj_pool_create(&tc_test.cp.factory, "tc", 1000, 1000, NULL);
+    PJ_TEST_EQ(pool, pool2, NULL, { rc=-220; goto on_return; });
+    PJ_TEST_EQ(tc_test.cp.used_count, 0, NULL, { rc=-225; goto on_return; });
+    pj_pool_release(pool2);
+
+    /* Flushed pools must go to the shared free list */
+    pj_caching_pool_flush_thread_cache(&tc_test.cp);
+    PJ_TEST_GT(tc_test.cp.capacity, 0, NULL, { rc=-230; goto on_return; });
+
+    tc_test.pool = pj_pool_create(mem, "tc", 4000, 4000, NULL);
+    PJ_TEST_NOT_NULL(tc_test.pool, NULL, { rc=-235; goto on_return; });
+    PJ_TEST_SUCCESS(pj_mutex_create_simple(tc_test.pool, "tc",
+                                           &tc_test.mutex),
+                    NULL, { rc=-240; goto on_return; });
+
+    for (i=0; i<TC_THREAD_CNT; ++i) {
+        PJ_TEST_SUCCESS(pj_thread_create(tc_test.pool, "tc", &tc_worker,
+                                         NULL, 0, 0, &threads[i]),
+                        NULL, { rc=-250; goto on_return; });
+    }
+    for (i=0; i<TC_THREAD_CNT; ++i) {
+        pj_thread_join(threads[i]);
+        pj_thread_destroy(threads[i]);
+    }
+
+    if (tc_test.handover)
+        pj_pool_release(tc_test.handover);
+
+    rc = tc_test.rc;
+    PJ_TEST_LTE(tc_test.cp.capacity, tc_test.cp.max_capacity, NULL,
+                { rc=-260; goto on_return; });
+
+on_return:
+    if (tc_test.mutex)
+        pj_mutex_destroy(tc_test.mutex);
+    if (tc_test.pool)
+        pj_pool_release(tc_test.pool);
+    pj_caching_pool_destroy(&tc_test.cp);
+    return rc;
+}
+#endif  /* PJ_HAS_POOL_ALT_API == 0 && PJ_HAS_THREADS */
+
 
 int pool_test(void)
 {
@@ -387,6 +511,12 @@ int pool_test(void)
         return rc;
 #endif  //PJ_HAS_POOL_ALT_API == 0
 
+#if PJ_HAS_POOL_ALT_API == 0 && PJ_HAS_THREADS
+    rc = thread_cache_test();
+    if (rc != 0)
+        return rc;
+#endif
+
     PJ_UNUSED_ARG(loop);
     return 0;
 }
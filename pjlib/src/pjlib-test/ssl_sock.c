@@ -88,6 +88,8 @@ struct test_state
     pj_bool_t       check_echo;     /* flag to compare sent & echoed data   */
     const char     *check_echo_ptr; /* pointer/cursor for comparing data    */
     struct send_key send_key;       /* send op key                          */
+    pj_bool_t       session_reused; /* TLS session was resumed              */
+    pj_thread_t    *connect_thread; /* thread calling on_connect_complete() */
 };
 
 static void dump_ssl_info(const pj_ssl_sock_info *si)
@@ -151,6 +153,9 @@ static pj_bool_t ssl_on_connect_complete(pj_ssl_sock_t *ssock,
     pj_sockaddr_print((pj_sockaddr_t*)&info.remote_addr, buf2, sizeof(buf2), 1);
     PJ_LOG(3, ("", "...Connected %s -> %s!", buf1, buf2));
 
+    st->session_reused = info.session_reused;
+    st->connect_thread = pj_thread_this();
+
     if (st->is_verbose)
         dump_ssl_info(&info);
 
@@ -1583,6 +1588,471 @@ on_return:
 }
 #endif
 
+#if (WITH_BENCHMARK && (PJ_SSL_SOCK_IMP == PJ_SSL_SOCK_IMP_OPENSSL)) || \
+    ((PJ_SSL_SOCK_IMP == PJ_SSL_SOCK_IMP_OPENSSL) && \
+     PJ_SSL_SOCK_OSSL_CTX_CACHE_SIZE > 0 && \
+     PJ_SSL_SOCK_OSSL_SESS_CACHE_SIZE > 0) || \
+    PJ_HAS_THREADS
+#  define HAS_ECHO_SERVER   1
+#else
+#  define HAS_ECHO_SERVER   0
+#endif
+
+#if HAS_ECHO_SERVER
+/* Echo server on the loopback address shared by the tests below. The
+ * tests adjust param before starting the server, and it is then used as
+ * the template for the clients.
+ */
+struct echo_server
+{
+    pj_pool_t          *pool;
+    pj_ioqueue_t       *ioqueue;
+    pj_timer_heap_t    *timer;
+    pj_grp_lock_t      *grp_lock;
+    pj_ssl_cert_t      *cert;
+    pj_ssl_sock_param   param;
+    pj_ssl_sock_t      *ssock;
+    struct test_state   state;
+    pj_sockaddr         addr;
+    pj_sockaddr         listen_addr;
+};
+
+/* Create the pool, ioqueue and timer heap, and load the credentials. */
+static pj_status_t echo_server_init(struct echo_server *srv,
+                                    const char *name,
+                                    pj_size_t max_handles)
+{
+    pj_str_t ca_file = pj_str(CERT_CA_FILE);
+    pj_str_t cert_file = pj_str(CERT_FILE);
+    pj_str_t privkey_file = pj_str(CERT_PRIVKEY_FILE);
+    pj_str_t privkey_pass = pj_str(CERT_PRIVKEY_PASS);
+    pj_str_t tmp_st;
+    pj_status_t status;
+
+    pj_bzero(srv, sizeof(*srv));
+    srv->pool = pj_pool_create(mem, name, 256, 256, NULL);
+
+    status = pj_ioqueue_create(srv->pool, max_handles, &srv->ioqueue);
+    if (status != PJ_SUCCESS)
+        return status;
+
+    status = pj_timer_heap_create(srv->pool, max_handles, &srv->timer);
+    if (status != PJ_SUCCESS)
+        return status;
+
+    pj_ssl_sock_param_default(&srv->param);
+    srv->param.cb.on_accept_complete2 = &ssl_on_accept_complete;
+    srv->param.cb.on_connect_complete = &ssl_on_connect_complete;
+    srv->param.cb.on_data_read = &ssl_on_data_read;
+    srv->param.cb.on_data_sent = &ssl_on_data_sent;
+    srv->param.ioqueue = srv->ioqueue;
+    srv->param.timer_heap = srv->timer;
+
+    pj_sockaddr_init(PJ_AF_INET, &srv->addr,
+                     pj_strset2(&tmp_st, "127.0.0.1"), 0);
+
+    return pj_ssl_cert_load_from_files(srv->pool, &ca_file, &cert_file,
+                                       &privkey_file, &privkey_pass,
+                                       &srv->cert);
+}
+
+/* Start the server with the current param. */
+static pj_status_t echo_server_start(struct echo_server *srv)
+{
+    pj_ssl_sock_info info;
+    pj_status_t status;
+
+    /* Asynchronous handshake requires group lock */
+    if (srv->param.async_handshake) {
+        status = pj_grp_lock_create(srv->pool, NULL, &srv->grp_lock);
+        if (status != PJ_SUCCESS)
+            return status;
+        pj_grp_lock_add_ref(srv->grp_lock);
+    }
+
+    srv->param.user_data = &srv->state;
+    srv->param.grp_lock = srv->grp_lock;
+
+    srv->state.pool = srv->pool;
+    srv->state.echo = PJ_TRUE;
+    srv->state.is_server = PJ_TRUE;
+
+    status = pj_ssl_sock_create(srv->pool, &srv->param, &srv->ssock);
+    if (status != PJ_SUCCESS)
+        return status;
+
+    status = pj_ssl_sock_set_certificate(srv->ssock, srv->pool, srv->cert);
+    if (status != PJ_SUCCESS)
+        return status;
+
+    status = pj_ssl_sock_start_accept(srv->ssock, srv->pool, &srv->addr,
+                                      pj_sockaddr_get_len(&srv->addr));
+    if (status != PJ_SUCCESS)
+        return status;
+
+    /* Get listening address for clients to connect to */
+    pj_ssl_sock_get_info(srv->ssock, &info);
+    pj_sockaddr_cp(&srv->listen_addr, &info.local_addr);
+
+    return PJ_SUCCESS;
+}
+
+/* Connect a client with the current param, the client sends the data in
+ * state and checks the echo. The client loads the credentials if cert is
+ * set.
+ */
+static pj_status_t echo_client_start(struct echo_server *srv,
+                                     struct test_state *state,
+                                     pj_ssl_cert_t *cert)
+{
+    pj_ssl_sock_t *ssock;
+    pj_status_t status;
+
+    state->pool = srv->pool;
+    state->check_echo = PJ_TRUE;
+    srv->param.user_data = state;
+
+    status = pj_ssl_sock_create(srv->pool, &srv->param, &ssock);
+    if (status != PJ_SUCCESS) {
+        app_perror("...ERROR pj_ssl_sock_create()", status);
+        return status;
+    }
+
+    if (cert) {
+        status = pj_ssl_sock_set_certificate(ssock, srv->pool, cert);
+        if (status != PJ_SUCCESS) {
+            pj_ssl_sock_close(ssock);
+            return status;
+        }
+    }
+
+    status = pj_ssl_sock_start_connect(ssock, srv->pool, &srv->addr,
+                                       &srv->listen_addr,
+                                       pj_sockaddr_get_len(&srv->addr));
+    if (status == PJ_SUCCESS) {
+        ssl_on_connect_complete(ssock, PJ_SUCCESS);
+    } else if (status != PJ_EPENDING) {
+        app_perror("...ERROR pj_ssl_sock_start_connect()", status);
+        pj_ssl_sock_close(ssock);
+        return status;
+    }
+
+    return PJ_SUCCESS;
+}
+
+/* Wait until clients_num clients have received the echo or got error. */
+static void echo_clients_wait(struct echo_server *srv)
+{
+    while (clients_num) {
+        pj_time_val delay = {0, 10};
+        pj_ioqueue_poll(srv->ioqueue, &delay);
+        pj_timer_heap_poll(srv->timer, NULL);
+    }
+}
+
+static void echo_server_destroy(struct echo_server *srv)
+{
+    if (srv->ssock)
+        pj_ssl_sock_close(srv->ssock);
+
+    /* Clean up sockets */
+    if (srv->ioqueue) {
+        pj_time_val delay = {0, 100};
+        while (pj_ioqueue_poll(srv->ioqueue, &delay) > 0);
+        pj_ioqueue_destroy(srv->ioqueue);
+    }
+    if (srv->grp_lock)
+        pj_grp_lock_dec_ref(srv->grp_lock);
+    if (srv->timer)
+        pj_timer_heap_destroy(srv->timer);
+    if (srv->pool)
+        pj_pool_release(srv->pool);
+}
+#endif
+
+#if WITH_BENCHMARK && (PJ_SSL_SOCK_IMP == PJ_SSL_SOCK_IMP_OPENSSL)
+/* Test will perform sequential SSL handshakes to a single server, each
+ * followed by a short echo, with the client loading its credentials for
+ * every connection. Without the SSL context cache, the certificate, private
+ * key and CA list are parsed again for each handshake.
+ */
+static int handshake_rate_test(unsigned count, pj_bool_t use_ctx_cache)
+{
+    struct echo_server srv;
+    struct test_state state_cli;
+    char send_str[16] = "handshake-rate";
+    pj_time_val start, stop;
+    int log_level = pj_log_get_level();
+    /* Each handshake uses two ioqueue keys */
+    unsigned batch = PJ_IOQUEUE_MAX_HANDLES / 2 - 2;
+    unsigned i, msec;
+    pj_status_t status;
+
+    /* Both server and clients use the same credentials */
+    status = echo_server_init(&srv, "ssl_hs_rate", PJ_IOQUEUE_MAX_HANDLES);
+    if (status == PJ_SUCCESS)
+        status = echo_server_start(&srv);
+    if (status != PJ_SUCCESS)
+        goto on_return;
+
+    /* CLIENTS */
+    pj_ssl_ctx_cache_flush();
+    pj_log_set_level(2);
+    pj_gettickcount(&start);
+
+    for (i = 0; i < count; ++i) {
+        /* Closed sockets only release their ioqueue keys after
+         * PJ_IOQUEUE_KEY_FREE_DELAY, wait for it without counting the
+         * waiting time.
+         */
+        if (i && (i % batch) == 0) {
+            pj_time_val wait_start, now;
+
+            pj_gettickcount(&wait_start);
+            do {
+                pj_time_val delay = {0, 10};
+                pj_ioqueue_poll(srv.ioqueue, &delay);
+                pj_gettickcount(&now);
+                PJ_TIME_VAL_SUB(now, wait_start);
+            } while (PJ_TIME_VAL_MSEC(now) < PJ_IOQUEUE_KEY_FREE_DELAY+100);
+
+            pj_gettickcount(&now);
+            PJ_TIME_VAL_SUB(now, wait_start);
+            PJ_TIME_VAL_ADD(start, now);
+        }
+
+        if (!use_ctx_cache)
+            pj_ssl_ctx_cache_flush();
+
+        pj_bzero(&state_cli, sizeof(state_cli));
+        state_cli.send_str = send_str;
+        state_cli.send_str_len = sizeof(send_str);
+        clients_num = 1;
+
+        status = echo_client_start(&srv, &state_cli, srv.cert);
+        if (status != PJ_SUCCESS)
+            goto on_return;
+
+        echo_clients_wait(&srv);
+
+        status = state_cli.err;
+        if (status != PJ_SUCCESS) {
+            app_perror("...ERROR handshake", status);
+            goto on_return;
+        }
+    }
+
+    pj_gettickcount(&stop);
+    PJ_TIME_VAL_SUB(stop, start);
+    msec = PJ_TIME_VAL_MSEC(stop);
+    if (msec == 0) msec = 1;
+
+    pj_log_set_level(log_level);
+    PJ_LOG(3, ("", ".....%u handshakes in %u.%03us: %u handshakes/sec",
+               count, msec / 1000, msec % 1000, count * 1000 / msec));
+
+on_return:
+    pj_log_set_level(log_level);
+    echo_server_destroy(&srv);
+
+    return status;
+}
+#endif
+
+#if (PJ_SSL_SOCK_IMP == PJ_SSL_SOCK_IMP_OPENSSL) && \
+    PJ_SSL_SOCK_OSSL_CTX_CACHE_SIZE > 0 && PJ_SSL_SOCK_OSSL_SESS_CACHE_SIZE > 0
+/* Test will connect a client to a server twice with session resumption
+ * enabled, the first connection should perform a full handshake and the
+ * second one should resume the session.
+ */
+static int session_resumption_test(pj_ssl_sock_proto proto)
+{
+    struct echo_server srv;
+    struct test_state state_cli;
+    char send_str[16] = "resumption";
+    unsigned i;
+    pj_status_t status;
+
+    status = echo_server_init(&srv, "ssl_resume", PJ_IOQUEUE_MAX_HANDLES);
+    if (status != PJ_SUCCESS)
+        goto on_return;
+
+    srv.param.proto = proto;
+    srv.param.session_resumption = PJ_TRUE;
+
+    status = echo_server_start(&srv);
+    if (status != PJ_SUCCESS)
+        goto on_return;
+
+    /* CLIENT */
+    for (i = 0; i < 2; ++i) {
+        pj_bzero(&state_cli, sizeof(state_cli));
+        state_cli.send_str = send_str;
+        state_cli.send_str_len = sizeof(send_str);
+        clients_num = 1;
+
+        status = echo_client_start(&srv, &state_cli, NULL);
+        if (status != PJ_SUCCESS)
+            goto on_return;
+
+        echo_clients_wait(&srv);
+
+        status = state_cli.err;
+        if (status != PJ_SUCCESS)
+            goto on_return;
+
+        if (state_cli.session_reused != (i == 1)) {
+            PJ_LOG(3, ("", "...ERROR: session %sreused on connection #%d",
+                       (state_cli.session_reused? "" : "not "), i + 1));
+            status = PJ_EBUG;
+            goto on_return;
+        }
+    }
+
+    PJ_LOG(3, ("", "...Done!"));
+
+on_return:
+    echo_server_destroy(&srv);
+
+    return status;
+}
+#endif
+
+#if PJ_HAS_THREADS
+/* Test will perform the handshakes on the SSL socket handshake worker
+ * threads, the connect callback should be called by one of the workers
+ * instead of by the thread polling the ioqueue.
+ */
+static int async_handshake_test(pj_ssl_sock_proto proto)
+{
+    struct echo_server srv;
+    pj_grp_lock_t *glock_cli = NULL;
+    struct test_state state_cli = { 0 };
+    char send_str[] = "Hello from asynchronous handshake";
+    pj_status_t status;
+
+    status = echo_server_init(&srv, "ssl_async_hs", 4);
+    if (status != PJ_SUCCESS)
+        goto on_return;
+
+    srv.param.proto = proto;
+    srv.param.async_handshake = PJ_TRUE;
+
+    status = echo_server_start(&srv);
+    if (status != PJ_SUCCESS)
+        goto on_return;
+
+    /* CLIENT, also with asynchronous handshake */
+    status = pj_grp_lock_create(srv.pool, NULL, &glock_cli);
+    if (status != PJ_SUCCESS)
+        goto on_return;
+    pj_grp_lock_add_ref(glock_cli);
+
+    state_cli.send_str = send_str;
+    state_cli.send_str_len = sizeof(send_str);
+    srv.param.grp_lock = glock_cli;
+    clients_num = 1;
+
+    status = echo_client_start(&srv, &state_cli, NULL);
+    if (status != PJ_SUCCESS)
+        goto on_return;
+
+    echo_clients_wait(&srv);
+
+    status = state_cli.err;
+    if (status != PJ_SUCCESS)
+        goto on_return;
+
+    if (state_cli.connect_thread == pj_thread_this()) {
+        PJ_LOG(1, ("", "...ERROR handshake was not performed by worker"));
+        status = PJ_EBUG;
+        goto on_return;
+    }
+
+    PJ_LOG(3, ("", "...Done!"));
+
+on_return:
+    echo_server_destroy(&srv);
+    if (glock_cli)
+        pj_grp_lock_dec_ref(glock_cli);
+
+    return status;
+}
+#endif
+
+#if PJ_HAS_THREADS
+/* Test the clients sending data right after their handshake, which may
+ * arrive at the server while the server handshake worker is reporting the
+ * completion. The server should echo all the data.
+ */
+#define ASYNC_HS_DATA_CLIENTS   8
+#define ASYNC_HS_DATA_LEN       4096
+
+static int async_handshake_data_test(pj_ssl_sock_proto proto)
+{
+    struct echo_server srv;
+    struct test_state state_cli[ASYNC_HS_DATA_CLIENTS];
+    char *send_str;
+    unsigned i;
+    pj_status_t status;
+
+    pj_bzero(state_cli, sizeof(state_cli));
+
+    status = echo_server_init(&srv, "ssl_async_hs_data",
+                              ASYNC_HS_DATA_CLIENTS*2 + 1);
+    if (status != PJ_SUCCESS)
+        goto on_return;
+
+    /* SERVER, with asynchronous handshake */
+    srv.param.proto = proto;
+    srv.param.async_handshake = PJ_TRUE;
+
+    status = echo_server_start(&srv);
+    if (status != PJ_SUCCESS)
+        goto on_return;
+
+    /* CLIENTS, the data is sent as soon as the handshake completes */
+    send_str = (char*)pj_pool_alloc(srv.pool, ASYNC_HS_DATA_LEN);
+    for (i = 0; i < ASYNC_HS_DATA_LEN; ++i)
+        send_str[i] = (char)('a' + (i % 26));
+
+    srv.param.grp_lock = NULL;
+    srv.param.async_handshake = PJ_FALSE;
+    clients_num = ASYNC_HS_DATA_CLIENTS;
+
+    for (i = 0; i < ASYNC_HS_DATA_CLIENTS; ++i) {
+        state_cli[i].send_str = send_str;
+        state_cli[i].send_str_len = ASYNC_HS_DATA_LEN;
+
+        status = echo_client_start(&srv, &state_cli[i], NULL);
+        if (status != PJ_SUCCESS)
+            goto on_return;
+    }
+
+    echo_clients_wait(&srv);
+
+    for (i = 0; i < ASYNC_HS_DATA_CLIENTS; ++i) {
+        status = state_cli[i].err;
+        if (status != PJ_SUCCESS)
+            goto on_return;
+        if (state_cli[i].recv != ASYNC_HS_DATA_LEN) {
+            PJ_LOG(1, ("", "...ERROR client %d received %lu of %d bytes",
+                       i, (unsigned long)state_cli[i].recv,
+                       ASYNC_HS_DATA_LEN));
+            status = PJ_EBUG;
+            goto on_return;
+        }
+    }
+
+    PJ_LOG(3, ("", "...Done!"));
+
+on_return:
+    echo_server_destroy(&srv);
+
+    return status;
+}
+#endif
+
 #if 0 && (!defined(PJ_SYMBIAN) || PJ_SYMBIAN==0)
 pj_status_t pj_ssl_sock_ossl_test_send_buf(pj_pool_t *pool);
 static int ossl_test_send_buf()
@@ -1717,6 +2187,41 @@ int ssl_sock_test(void)
         return ret;
 #endif
 
+#if (PJ_SSL_SOCK_IMP == PJ_SSL_SOCK_IMP_OPENSSL) && \
+    PJ_SSL_SOCK_OSSL_CTX_CACHE_SIZE > 0 && PJ_SSL_SOCK_OSSL_SESS_CACHE_SIZE > 0
+    PJ_LOG(3,("", "..session resumption test w/ TLSv1.2"));
+    ret = session_resumption_test(PJ_SSL_SOCK_PROTO_TLS1_2);
+    if (ret != 0)
+        return ret;
+
+    PJ_LOG(3,("", "..session resumption test w/ TLSv1.3"));
+    ret = session_resumption_test(PJ_SSL_SOCK_PROTO_TLS1_3);
+    if (ret != 0)
+        return ret;
+#endif
+
+#if PJ_HAS_THREADS
+    PJ_LOG(3,("", "..asynchronous handshake test w/ TLSv1.2"));
+    ret = async_handshake_test(PJ_SSL_SOCK_PROTO_TLS1_2);
+    if (ret != 0)
+        return ret;
+
+    PJ_LOG(3,("", "..asynchronous handshake test w/ TLSv1.3"));
+    ret = async_handshake_test(PJ_SSL_SOCK_PROTO_TLS1_3);
+    if (ret != 0)
+        return ret;
+
+    PJ_LOG(3,("", "..asynchronous handshake data test w/ TLSv1.2"));
+    ret = async_handshake_data_test(PJ_SSL_SOCK_PROTO_TLS1_2);
+    if (ret != 0)
+        return ret;
+
+    PJ_LOG(3,("", "..asynchronous handshake data test w/ TLSv1.3"));
+    ret = async_handshake_data_test(PJ_SSL_SOCK_PROTO_TLS1_3);
+    if (ret != 0)
+        return ret;
+#endif
+
 #if WITH_BENCHMARK
 #if (PJ_SSL_SOCK_IMP != PJ_SSL_SOCK_IMP_MBEDTLS)
     PJ_LOG(3,("", "..performance test"));
@@ -1726,6 +2231,18 @@ int ssl_sock_test(void)
 #else
     PJ_UNUSED_ARG(perf_test);
 #endif
+
+#if (PJ_SSL_SOCK_IMP == PJ_SSL_SOCK_IMP_OPENSSL)
+    PJ_LOG(3,("", "..handshake rate test without SSL context cache"));
+    ret = handshake_rate_test(100, PJ_FALSE);
+    if (ret != 0)
+        return ret;
+
+    PJ_LOG(3,("", "..handshake rate test with SSL context cache"));
+    ret = handshake_rate_test(100, PJ_TRUE);
+    if (ret != 0)
+        return ret;
+#endif
 #endif
 
     PJ_LOG(3,("", "..client non-SSL (handshake timeout 5 secs)"));
@@ -252,6 +252,11 @@ static int features_tests(int argc, char *argv[])
     UT_ADD_TEST(&test_app.ut_app, hash_test, 0);
 #endif
 
+#if INCLUDE_ATOMIC_MPMC_QUEUE_TEST
+    UT_ADD_TEST(&test_app.ut_app, atomic_mpmc_queue_test,
+                PJ_TEST_EXCLUSIVE);
+#endif
+
     /* GH CI oftent fails with:
 
     07:27:13.217 ...testing frequency accuracy (pls wait)
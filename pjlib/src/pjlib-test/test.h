@@ -57,6 +57,7 @@
 #   endif
 #endif
 
+#define INCLUDE_ATOMIC_MPMC_QUEUE_TEST (PJ_HAS_THREADS && GROUP_DATA_STRUCTURE)
 #define INCLUDE_HASH_TEST           GROUP_DATA_STRUCTURE
 #define INCLUDE_POOL_TEST           GROUP_LIBC
 #define INCLUDE_POOL_PERF_TEST      (GROUP_LIBC && WITH_BENCHMARK)
@@ -103,6 +104,7 @@ extern int rand_test(void);
 extern int list_test(void);
 extern int atomic_slist_test(void);
 extern int atomic_slist_mt_test(void);
+extern int atomic_mpmc_queue_test(void);
 extern int hash_test(void);
 extern int log_test(void);
 extern int os_test(void);
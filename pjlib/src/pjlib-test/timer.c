@@ -50,7 +50,12 @@ static void timer_callback(pj_timer_heap_t *ht, pj_timer_entry *e)
     PJ_UNUSED_ARG(e);
 }
 
-static int test_timer_heap(void)
+static const char *get_type_name(pj_timer_heap_type type)
+{
+    return (type == PJ_TIMER_HEAP_WHEEL? "timing wheel": "binary heap");
+}
+
+static int test_timer_heap(pj_timer_heap_type type)
 {
     int i, j;
     pj_timer_entry *entry;
@@ -61,8 +66,9 @@ static int test_timer_heap(void)
     int err=0;
     pj_size_t size;
     unsigned count;
+    pj_timer_heap_cfg cfg;
 
-    PJ_LOG(3,("test", "...Basic test"));
+    PJ_LOG(3,("test", "...Basic test (%s)", get_type_name(type)));
 
     size = pj_timer_heap_mem_size(MAX_COUNT)+MAX_COUNT*sizeof(pj_timer_entry);
     pool = pj_pool_create( mem, NULL, size, 4000, NULL);
@@ -79,7 +85,9 @@ static int test_timer_heap(void)
     for (i=0; i<MAX_COUNT; ++i) {
         entry[i].cb = &timer_callback;
     }
-    status = pj_timer_heap_create(pool, MAX_COUNT, &timer);
+    pj_timer_heap_cfg_default(&cfg);
+    cfg.type = type;
+    status = pj_timer_heap_create2(pool, MAX_COUNT, &cfg, &timer);
     if (status != PJ_SUCCESS) {
         app_perror("...error: unable to create timer heap", status);
         return -30;
@@ -467,7 +475,7 @@ static int cancel_worker(void *arg)
 }
 #endif
 
-static int timer_stress_test(void)
+static int timer_stress_test(pj_timer_heap_type type, unsigned shard_cnt)
 {
     unsigned count = 0, n_sched = 0, n_cancel = 0, n_poll = 0;
     int i;
@@ -483,13 +491,15 @@ static int timer_stress_test(void)
     pj_thread_t **poll_threads = NULL;
     pj_thread_t **cancel_threads = NULL;
     struct thread_param tparam = {0};
+    pj_timer_heap_cfg cfg;
 #if SIMULATE_CRASH
     pj_timer_entry *entry;
     pj_pool_t *tmp_pool;
     pj_time_val delay = {0};
 #endif
 
-    PJ_LOG(3,("test", "...Stress test"));
+    PJ_LOG(3,("test", "...Stress test (%s, %d shard(s))",
+              get_type_name(type), shard_cnt));
 
     pool = pj_pool_create( mem, NULL, 128, 128, NULL);
     if (!pool) {
@@ -502,7 +512,10 @@ static int timer_stress_test(void)
      * Initially we only create a fraction of what's required,
      * to test the timer heap growth algorithm.
      */
-    status = pj_timer_heap_create(pool, ST_ENTRY_COUNT/64, &timer);
+    pj_timer_heap_cfg_default(&cfg);
+    cfg.type = type;
+    cfg.shard_cnt = shard_cnt;
+    status = pj_timer_heap_create2(pool, ST_ENTRY_COUNT/64, &cfg, &timer);
     if (status != PJ_SUCCESS) {
         app_perror("...error: unable to create timer heap", status);
         err = -20;
@@ -947,25 +960,163 @@ static int timer_bench_test(void)
     return err;
 }
 
+/*
+ * Schedule/cancel churn benchmark, simulating protocol timers which are
+ * mostly cancelled (or rescheduled) before they expire.
+ */
+#define CT_ENTRY_COUNT  100000
+#define CT_OPS_COUNT    1000000
+#define CT_MAX_DELAY    32000
+
+static int churn_bench(pj_timer_heap_type type, pj_timestamp freq)
+{
+    pj_pool_t *pool;
+    pj_timer_heap_t *timer = NULL;
+    pj_timer_entry *entries;
+    pj_timer_heap_cfg cfg;
+    pj_timestamp t1, t2;
+    pj_time_val delay;
+    pj_status_t status;
+    char ops_str[64];
+    unsigned i, ops_sec;
+    int err = 0;
+
+    pool = pj_pool_create( mem, NULL, 4000, 4000, NULL);
+    if (!pool)
+        return -10;
+
+    pj_timer_heap_cfg_default(&cfg);
+    cfg.type = type;
+    status = pj_timer_heap_create2(pool, CT_ENTRY_COUNT/64, &cfg, &timer);
+    if (status != PJ_SUCCESS) {
+        app_perror("...error: unable to create timer heap", status);
+        err = -20;
+        goto on_return;
+    }
+
+    entries = (pj_timer_entry*)pj_pool_calloc(pool, CT_ENTRY_COUNT,
+                                              sizeof(*entries));
+    if (!entries) {
+        err = -30;
+        goto on_return;
+    }
+
+    for (i = 0; i < CT_ENTRY_COUNT; ++i) {
+        pj_timer_entry_init(&entries[i], 0, NULL, &dummy_callback);
+        delay.sec = 0;
+        delay.msec = pj_rand() % CT_MAX_DELAY;
+        status = pj_timer_heap_schedule(timer, &entries[i], &delay);
+        if (status != PJ_SUCCESS) {
+            err = -40;
+            goto on_return;
+        }
+    }
+
+    /* Cancel random entries and schedule them again */
+    pj_get_timestamp(&t1);
+    for (i = 0; i < CT_OPS_COUNT; ++i) {
+        pj_timer_entry *e = &entries[pj_rand() % CT_ENTRY_COUNT];
+
+        pj_timer_heap_cancel_if_active(timer, e, 0);
+
+        delay.sec = 0;
+        delay.msec = pj_rand() % CT_MAX_DELAY;
+        status = pj_timer_heap_schedule(timer, e, &delay);
+        if (status != PJ_SUCCESS) {
+            err = -50;
+            goto on_return;
+        }
+
+        if ((i & 0xFF) == 0)
+            pj_timer_heap_poll(timer, NULL);
+    }
+    pj_get_timestamp(&t2);
+    pj_sub_timestamp(&t2, &t1);
+
+    ops_sec = (unsigned)(freq.u64 * CT_OPS_COUNT / (t2.u64 ? t2.u64 : 1));
+    get_format_num(ops_sec, ops_str);
+    PJ_LOG(3, (THIS_FILE, "    %s: %s cancel+schedule/sec",
+               get_type_name(type), ops_str));
+
+    for (i = 0; i < CT_ENTRY_COUNT; ++i)
+        pj_timer_heap_cancel_if_active(timer, &entries[i], 0);
+
+on_return:
+    if (timer)
+        pj_timer_heap_destroy(timer);
+    pj_pool_safe_release(&pool);
+    return err;
+}
+
+static int timer_churn_bench_test(void)
+{
+    pj_timestamp freq;
+    pj_status_t status;
+    int rc;
+
+    PJ_LOG(3,("test", "...Schedule/cancel churn benchmark (%d entries)",
+              CT_ENTRY_COUNT));
+
+    status = pj_get_timestamp_freq(&freq);
+    if (status != PJ_SUCCESS) {
+        PJ_LOG(3,("test", "...error: unable to get timestamp freq"));
+        return -10;
+    }
+
+    rc = churn_bench(PJ_TIMER_HEAP_BINARY, freq);
+    if (rc != 0)
+        return rc;
+
+#if !PJ_TIMER_USE_LINKED_LIST
+    rc = churn_bench(PJ_TIMER_HEAP_WHEEL, freq);
+    if (rc != 0)
+        return rc - 100;
+#endif
+
+    return 0;
+}
+
 int timer_test()
 {
     int rc;
 
-    rc = test_timer_heap();
+    rc = test_timer_heap(PJ_TIMER_HEAP_BINARY);
     if (rc != 0)
         return rc;
 
-    rc = timer_stress_test();
+    rc = timer_stress_test(PJ_TIMER_HEAP_BINARY, 1);
     if (rc != 0)
         return rc;
 
+    /* Entries move between shards as they are rescheduled with and
+     * without group lock.
+     */
+    rc = timer_stress_test(PJ_TIMER_HEAP_BINARY, 4);
+    if (rc != 0)
+        return rc - 2000;
+
+#if !PJ_TIMER_USE_LINKED_LIST
+    rc = test_timer_heap(PJ_TIMER_HEAP_WHEEL);
+    if (rc != 0)
+        return rc - 1000;
+
+    rc = timer_stress_test(PJ_TIMER_HEAP_WHEEL, 1);
+    if (rc != 0)
+        return rc - 1000;
+#endif
+
 #if WITH_BENCHMARK
     rc = timer_bench_test();
     if (rc != 0)
         return rc;
+
+    rc = timer_churn_bench_test();
+    if (rc != 0)
+        return rc;
 #else
     /* Avoid unused warning */
     PJ_UNUSED_ARG(timer_bench_test);
+    PJ_UNUSED_ARG(timer_churn_bench_test);
 #endif
 
     return 0;
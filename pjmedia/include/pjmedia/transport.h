@@ -457,6 +457,19 @@ struct pjmedia_transport_op
      */
     pj_status_t (*attach2)(pjmedia_transport *tp,
                            pjmedia_transport_attach_param *att_param);
+
+    /**
+     * This function is called to send several RTP packets at once using
+     * the transport. This member is optional, when it is not implemented
+     * the packets are sent one by one with <tt>send_rtp()</tt>.
+     *
+     * Application should call #pjmedia_transport_send_rtp_batch() instead
+     * of calling this function directly.
+     */
+    pj_status_t (*send_rtp_batch)(pjmedia_transport *tp,
+                                  const void *pkt[],
+                                  const pj_size_t size[],
+                                  unsigned count);
 };
 
 
@@ -873,6 +886,42 @@ PJ_INLINE(pj_status_t) pjmedia_transport_send_rtp(pjmedia_transport *tp,
 }
 
 
+/**
+ * Send several RTP packets with the specified media transport, to the
+ * destination address specified in #pjmedia_transport_attach(). If the
+ * transport implements <tt>send_rtp_batch()</tt>, it may send the packets
+ * with fewer system calls (for example, UDP media transport uses
+ * #pj_ioqueue_sendto_batch()), otherwise the packets are sent one by one
+ * with <tt>send_rtp()</tt>. All packets are always attempted.
+ *
+ * @param tp        The media transport.
+ * @param pkt       Array of packets to send.
+ * @param size      Array of packet sizes.
+ * @param count     Number of packets.
+ *
+ * @return          PJ_SUCCESS on success, or the error code of the last
+ *                  packet that failed to be sent.
+ */
+PJ_INLINE(pj_status_t) pjmedia_transport_send_rtp_batch(pjmedia_transport *tp,
+                                                        const void *pkt[],
+                                                        const pj_size_t size[],
+                                                        unsigned count)
+{
+    pj_status_t status = PJ_SUCCESS;
+    unsigned i;
+
+    if (tp->op->send_rtp_batch)
+        return (*tp->op->send_rtp_batch)(tp, pkt, size, count);
+
+    for (i=0; i<count; ++i) {
+        pj_status_t st = (*tp->op->send_rtp)(tp, pkt[i], size[i]);
+        if (st != PJ_SUCCESS)
+            status = st;
+    }
+    return status;
+}
+
+
 /**
  * Send RTCP packet with the specified media transport. This is just a simple
  * wrapper which calls <tt>send_rtcp()</tt> member of the transport. The 
@@ -40,6 +40,9 @@
 /* Maximum pending write operations */
 #define MAX_PENDING 4
 
+/* Maximum number of RTP packets per pj_ioqueue_sendto_batch() call */
+#define MAX_SEND_BATCH  16
+
 #if 1
 #  define TRACE_(expr)
 #else
@@ -141,6 +144,10 @@ static void        transport_detach   (pjmedia_transport *tp,
 static pj_status_t transport_send_rtp( pjmedia_transport *tp,
                                        const void *pkt,
                                        pj_size_t size);
+static pj_status_t transport_send_rtp_batch(pjmedia_transport *tp,
+                                            const void *pkt[],
+                                            const pj_size_t size[],
+                                            unsigned count);
 static pj_status_t transport_send_rtcp(pjmedia_transport *tp,
                                        const void *pkt,
                                        pj_size_t size);
@@ -186,7 +193,8 @@ static pjmedia_transport_op transport_udp_op =
     &transport_media_stop,
     &transport_simulate_lost,
     &transport_destroy,
-    &transport_attach2
+    &transport_attach2,
+    &transport_send_rtp_batch
 };
 
 static const pj_str_t STR_RTCP_MUX      = { "rtcp-mux", 8 };
@@ -1126,6 +1134,66 @@ static pj_status_t transport_send_rtp( pjmedia_transport *tp,
     return status;
 }
 
+/* Called by application to send several RTP packets */
+static pj_status_t transport_send_rtp_batch(pjmedia_transport *tp,
+                                            const void *pkt[],
+                                            const pj_size_t size[],
+                                            unsigned count)
+{
+    struct transport_udp *udp = (struct transport_udp*)tp;
+    pj_status_t status = PJ_SUCCESS;
+    unsigned i = 0;
+
+    if (!udp->started) {
+        return PJ_SUCCESS;
+    }
+
+    while (i < count) {
+        pj_sock_sendto_msg msg[MAX_SEND_BATCH];
+        unsigned j, cnt;
+        pj_status_t st;
+
+        cnt = count - i;
+        if (cnt > MAX_SEND_BATCH)
+            cnt = MAX_SEND_BATCH;
+
+        for (j=0; j<cnt; ++j) {
+            PJ_ASSERT_RETURN(size[i+j] <= PJMEDIA_MAX_MTU, PJ_ETOOBIG);
+
+            msg[j].buf = pkt[i+j];
+            msg[j].len = size[i+j];
+            msg[j].addr = &udp->rem_rtp_addr;
+            msg[j].addr_len = udp->addr_len;
+        }
+
+        if (udp->tx_drop_pct) {
+            /* Leave packet lost simulation to transport_send_rtp() */
+            st = PJ_EIGNORED;
+        } else {
+            /* The packets are sent directly from caller's buffers, since
+             * pj_ioqueue_sendto_batch() never leaves a pending operation.
+             */
+            st = pj_ioqueue_sendto_batch(udp->rtp_key, msg, &cnt, 0);
+        }
+
+        if (st != PJ_SUCCESS || cnt == 0) {
+            /* The packet can't be sent immediately, e.g: socket buffer is
+             * full or there is a pending write. Send it the usual way so
+             * that it gets queued (or its error is reported).
+             */
+            st = transport_send_rtp(tp, pkt[i], size[i]);
+            if (st != PJ_SUCCESS)
+                status = st;
+            cnt = 1;
+        }
+
+        i += cnt;
+    }
+
+    return status;
+}
+
+
 /* Called by application to send RTCP packet */
 static pj_status_t transport_send_rtcp(pjmedia_transport *tp,
                                        const void *pkt,
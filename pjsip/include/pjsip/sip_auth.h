@@ -254,6 +254,15 @@ typedef struct pjsip_cached_auth
 #endif
     pjsip_auth_algorithm_type    challenge_algorithm_type; /**< Challenge
                                                                 algorithm   */
+    const pjsip_cred_info       *ha1_cred;  /**< Credential the precomputed
+                                                 HA1 was created from.      */
+    pjsip_auth_algorithm_type    ha1_algorithm_type; /**< Algorithm of the
+                                                          precomputed HA1.  */
+    pj_str_t                     ha1;       /**< Precomputed HA1 for the
+                                                 realm, reused for each
+                                                 request in this session.   */
+    char                         ha1_buf[PJSIP_AUTH_MAX_DIGEST_BUFFER_LENGTH*2];
+                                            /**< Buffer for the HA1.        */
 } pjsip_cached_auth;
 
 
@@ -437,6 +446,9 @@ typedef pj_status_t pjsip_auth_lookup_cred2(
 /** Flag to specify that server is a proxy. */
 #define PJSIP_AUTH_SRV_IS_PROXY     1
 
+/** Opaque declaration of server authorization cache. */
+typedef struct pjsip_auth_srv_cache pjsip_auth_srv_cache;
+
 /**
  * This structure describes server authentication information.
  */
@@ -447,9 +459,82 @@ typedef struct pjsip_auth_srv
     pjsip_auth_lookup_cred  *lookup;    /**< Lookup function.               */
     pjsip_auth_lookup_cred2 *lookup2;   /**< Lookup function with additional
                                              info in its input param.       */
+    pjsip_auth_srv_cache    *cache;     /**< Optional authorization cache,
+                                             see pjsip_auth_srv_enable_cache */
 } pjsip_auth_srv;
 
 
+/**
+ * This structure describes the settings of server authorization cache,
+ * see #pjsip_auth_srv_enable_cache(). Use
+ * #pjsip_auth_srv_cache_param_default() to initialize this structure.
+ */
+typedef struct pjsip_auth_srv_cache_param
+{
+    /**
+     * Time-to-live (in seconds) of the HA1 cached for each account of the
+     * realm. While the HA1 of an account is cached, the lookup function is
+     * not called to verify its requests. Set to zero to disable the HA1
+     * cache.
+     *
+     * Default: PJSIP_AUTH_SRV_HA1_TTL
+     */
+    unsigned            ha1_ttl;
+
+    /**
+     * Maximum number of accounts whose HA1 are cached. The least recently
+     * used entry is evicted when the cache is full.
+     *
+     * Default: PJSIP_AUTH_SRV_MAX_HA1
+     */
+    unsigned            max_ha1;
+
+    /**
+     * Lifetime (in seconds) of the nonces issued by the server. When
+     * non-zero, #pjsip_auth_srv_challenge() creates a nonce signed with
+     * \a secret which carries its creation time, so the nonce can be
+     * validated without keeping any state. Authorization with a nonce that
+     * was not issued by the server is rejected with PJSIP_EAUTHINNONCE,
+     * and with an expired nonce with PJSIP_EAUTHSTALENONCE. Set to zero to
+     * disable signed nonces.
+     *
+     * Replay of a nonce is only detected for authorization with qop (see
+     * \a max_nonce). Without qop, a captured authorization can be replayed
+     * for the same request until the nonce expires.
+     *
+     * The creation time is taken from the wall clock, so that servers
+     * sharing the secret agree on it. Stepping the system clock shortens
+     * or extends the lifetime of the nonces issued before the step.
+     *
+     * Default: PJSIP_AUTH_SRV_NONCE_TTL
+     */
+    unsigned            nonce_ttl;
+
+    /**
+     * Maximum number of signed nonces whose last nonce count (nc) are
+     * tracked. Authorization with qop whose nonce count is not greater than
+     * the last one seen for the nonce is rejected with PJSIP_EAUTHNCREPLAY.
+     * Set to zero to disable the tracking.
+     *
+     * Default: PJSIP_AUTH_SRV_MAX_NONCE
+     */
+    unsigned            max_nonce;
+
+    /**
+     * Secret key to sign the nonces. Servers sharing the same realm and
+     * secret accept the nonces issued by each other. If empty, a random
+     * secret will be generated with the secure random generator of the
+     * SSL backend; when there is none (e.g. built without OpenSSL),
+     * #pjsip_auth_srv_enable_cache() fails with PJ_ENOTSUP unless the
+     * secret is supplied or \a nonce_ttl is zero.
+     *
+     * Default: empty
+     */
+    pj_str_t            secret;
+
+} pjsip_auth_srv_cache_param;
+
+
 /**
  * Initialize client authentication session data structure, and set the 
  * session to use pool for its subsequent memory allocation. The argument 
@@ -681,12 +766,73 @@ PJ_DECL(pj_status_t) pjsip_auth_srv_init2(
  *                      - PJSIP_EAUTHACCDISABLED
  *                      - PJSIP_EAUTHINVALIDREALM
  *                      - PJSIP_EAUTHINVALIDDIGEST
+ *                      When authorization cache is enabled, the function
+ *                      may also return:
+ *                      - PJSIP_EAUTHINNONCE
+ *                      - PJSIP_EAUTHSTALENONCE
+ *                      - PJSIP_EAUTHNCREPLAY
  */
 PJ_DECL(pj_status_t) pjsip_auth_srv_verify( pjsip_auth_srv *auth_srv,
                                             pjsip_rx_data *rdata,
                                             int *status_code );
 
 
+/**
+ * Initialize server authorization cache settings with default values.
+ *
+ * @param param         The settings to be initialized.
+ */
+PJ_DECL(void) pjsip_auth_srv_cache_param_default(
+                                    pjsip_auth_srv_cache_param *param);
+
+
+/**
+ * Enable authorization cache in the server authorization session to speed
+ * up the verification of requests. Once enabled, the server caches the HA1
+ * of the accounts, issues signed nonces with expiry and tracks the nonce
+ * count of the nonces, according to the settings. Application must call
+ * #pjsip_auth_srv_deinit() when the server authorization session is no
+ * longer used.
+ *
+ * @param pool          Pool to allocate the cache. The pool must remain
+ *                      valid until #pjsip_auth_srv_deinit() is called.
+ * @param auth_srv      The server authentication structure.
+ * @param param         Optional settings, if NULL the default settings
+ *                      will be used.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjsip_auth_srv_enable_cache(
+                                    pj_pool_t *pool,
+                                    pjsip_auth_srv *auth_srv,
+                                    const pjsip_auth_srv_cache_param *param);
+
+
+/**
+ * Remove the cached HA1 of the account from the server authorization cache,
+ * for example after the password of the account has been changed, so the
+ * lookup function will be called on the next request of the account.
+ *
+ * @param auth_srv      The server authentication structure.
+ * @param acc_name      The account name, or NULL to remove all accounts.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjsip_auth_srv_invalidate_cred(pjsip_auth_srv *auth_srv,
+                                                    const pj_str_t *acc_name);
+
+
+/**
+ * Release the resources of the server authorization session, i.e: the
+ * authorization cache if it was enabled.
+ *
+ * @param auth_srv      The server authentication structure.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjsip_auth_srv_deinit(pjsip_auth_srv *auth_srv);
+
+
 /**
  * Add authentication challenge headers to the outgoing response in tdata. 
  * Application may specify its customized nonce and opaque for the challenge, 
@@ -823,6 +969,32 @@ PJ_DECL(pj_status_t) pjsip_auth_create_digestSHA256(pj_str_t* result,
                                             const pjsip_cred_info* cred_info,
                                             const pj_str_t* method);
 
+/**
+ * Helper function to create the "ha1" hash of the credential, i.e:
+ * username + ":" + realm + ":" + password hashed using the specified
+ * algorithm. The result can be used as the data of a credential with
+ * #PJSIP_CRED_DATA_DIGEST data type to skip hashing the password for
+ * each digest.
+ *
+ * If pjsip_cred_info::data_type is #PJSIP_CRED_DATA_DIGEST, the data
+ * is copied to the result, and pjsip_cred_info::algorithm_type must
+ * match the algorithm_type passed to this function or left unset.
+ *
+ * @param result         String to store the ha1. This string must have
+ *                       been preallocated by the caller with the buffer
+ *                       at least as large as the digest_str_length
+ *                       member of the appropriate pjsip_auth_algorithm.
+ * @param realm          Realm.
+ * @param cred_info      Credential info.
+ * @param algorithm_type The hash algorithm to use.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjsip_auth_create_ha1(pj_str_t *result,
+                                 const pj_str_t *realm,
+                                 const pjsip_cred_info *cred_info,
+                                 const pjsip_auth_algorithm_type algorithm_type);
+
 /**
  * Helper function to create a digest out of the specified
  * parameters.
@@ -188,6 +188,27 @@ typedef struct pjsip_cfg_t
          */
         pj_bool_t keep_inv_after_tsx_timeout;
 
+        /**
+         * Defer parsing of incoming message headers until they are looked
+         * up with pjsip_msg_find_hdr() and friends. Headers needed to fill
+         * in \a msg_info of pjsip_rx_data are always parsed. Until it is
+         * looked up, a deferred header appears as generic string header
+         * to code that walks the header list directly.
+         *
+         * Default is PJSIP_LAZY_HDR_PARSING.
+         */
+        pj_bool_t lazy_hdr_parsing;
+
+        /**
+         * Pre-encode the headers that pjsip_endpt_create_response() copies
+         * from the request (Via, Record-Route, Call-ID, From, and CSeq),
+         * so that they are printed only once for all responses to the
+         * same request. See PJSIP_ENCODE_RSP_HDR.
+         *
+         * Default is PJSIP_ENCODE_RSP_HDR.
+         */
+        pj_bool_t encode_rsp_hdr;
+
     } endpt;
 
     /** Transaction layer settings. */
@@ -221,6 +242,15 @@ typedef struct pjsip_cfg_t
          */
         unsigned td;
 
+        /** Number of lock stripes of the transaction table. With more than
+         *  one stripe, transactions are spread over several hash tables
+         *  by the transaction key, each protected by its own mutex, so
+         *  threads looking up different transactions don't contend on a
+         *  single lock. The value is initialized with
+         *  PJSIP_TSX_LAYER_LOCK_STRIPE_CNT.
+         */
+        unsigned lock_stripe_cnt;
+
     } tsx;
 
     /* Dialog layer settings .. TODO */
@@ -316,6 +346,21 @@ PJ_INLINE(pjsip_cfg_t*) pjsip_cfg(void)
 #   define PJSIP_MAX_TSX_COUNT          (1024-1)
 #endif
 
+/**
+ * Specify the number of lock stripes of the transaction table, i.e. the
+ * default value of pjsip_cfg()->tsx.lock_stripe_cnt. With more than one
+ * stripe, each stripe holds the transactions whose key hashes to it, in
+ * its own hash table and protected by its own mutex. This reduces lock
+ * contention when many worker threads process messages concurrently.
+ * The transaction table size (PJSIP_MAX_TSX_COUNT) is divided among the
+ * stripes.
+ *
+ * Default: 1 (single lock)
+ */
+#ifndef PJSIP_TSX_LAYER_LOCK_STRIPE_CNT
+#   define PJSIP_TSX_LAYER_LOCK_STRIPE_CNT  1
+#endif
+
 /**
  * Specify maximum number of dialogs in the dialog hash table.
  * For efficiency, the value should be 2^n-1 since it will be
@@ -327,6 +372,19 @@ PJ_INLINE(pjsip_cfg_t*) pjsip_cfg(void)
 #   define PJSIP_MAX_DIALOG_COUNT       (512-1)
 #endif
 
+/**
+ * Specify the default number of lock stripes of the dialog table in the
+ * user agent layer (see pjsip_ua_init_param.lock_stripe_cnt). Each stripe
+ * holds the dialog sets whose local tag hashes to it, in its own hash
+ * table and protected by its own mutex. This reduces lock contention when
+ * many worker threads process in-dialog messages concurrently.
+ *
+ * Default: 1 (single lock)
+ */
+#ifndef PJSIP_UA_LOCK_STRIPE_CNT
+#   define PJSIP_UA_LOCK_STRIPE_CNT     1
+#endif
+
 
 /**
  * Specify maximum number of transports.
@@ -339,13 +397,31 @@ PJ_INLINE(pjsip_cfg_t*) pjsip_cfg(void)
 
 
 /**
- * Transport manager hash table size (must be 2^n-1). 
+ * Initial size of the transport manager hash table. The table grows as
+ * more transports are registered, so this only needs to be large enough
+ * to avoid growing it in the common case.
  * See also PJSIP_MAX_TRANSPORTS
  */
 #ifndef PJSIP_TPMGR_HTABLE_SIZE
 #   define PJSIP_TPMGR_HTABLE_SIZE      31
 #endif
 
+/**
+ * Specify the number of lock stripes of the transport manager table. Each
+ * stripe holds the transports whose key (type and remote address) hashes
+ * to it, in its own hash table and protected by its own lock, so that
+ * looking up transports to different destinations, and registering and
+ * destroying connections, do not contend on a single lock. Creating new
+ * transports and managing factories still use the transport manager lock.
+ *
+ * Set to 1 to use a single lock for the whole table.
+ *
+ * Default: 8
+ */
+#ifndef PJSIP_TPMGR_LOCK_STRIPE_CNT
+#   define PJSIP_TPMGR_LOCK_STRIPE_CNT  8
+#endif
+
 
 /**
  * Specify maximum URL size.
@@ -454,6 +530,52 @@ PJ_INLINE(pjsip_cfg_t*) pjsip_cfg(void)
 #endif
 
 
+/**
+ * Defer parsing of the headers of incoming messages, except the ones
+ * needed to fill in \a msg_info of pjsip_rx_data, until they are looked
+ * up with pjsip_msg_find_hdr(), pjsip_msg_find_hdr_by_name(), or
+ * pjsip_msg_find_hdr_by_names(). Messages which are only routed or
+ * rejected then never pay for parsing headers nobody reads.
+ *
+ * Looking up a deferred header modifies the message header list, so
+ * the same message must not be searched by multiple threads at once.
+ * Syntax errors in deferred headers are not reported by the parser; such
+ * headers are kept as generic string headers.
+ *
+ * This option can also be controlled at run-time by the
+ * \a lazy_hdr_parsing setting in pjsip_cfg_t.
+ *
+ * Default is PJ_FALSE.
+ */
+#ifndef PJSIP_LAZY_HDR_PARSING
+#   define PJSIP_LAZY_HDR_PARSING                   PJ_FALSE
+#endif
+
+
+/**
+ * Make pjsip_endpt_create_response() put pre-encoded copies (see
+ * #pjsip_hdr_encode()) of the Via, Record-Route, Call-ID, From, and CSeq
+ * headers of the request in the response. The headers are cloned and
+ * encoded once per request, in a pool that is shared by the request and
+ * its responses, and the responses get shallow clones of them. Creating
+ * and printing the second and later responses to the same request then
+ * mostly copies memory. The To header is not pre-encoded since its tag is
+ * often set later.
+ *
+ * Modifying the fields of those headers in the response does not change
+ * how the response is printed, the header must be replaced with a full
+ * clone instead. The stack itself never modifies them.
+ *
+ * This option can also be controlled at run-time by the
+ * \a encode_rsp_hdr setting in pjsip_cfg_t.
+ *
+ * Default is PJ_FALSE.
+ */
+#ifndef PJSIP_ENCODE_RSP_HDR
+#   define PJSIP_ENCODE_RSP_HDR                     PJ_FALSE
+#endif
+
+
 /**
  * Specify whether "alias" param should be added to the Via header
  * in any outgoing request with connection oriented transport.
@@ -967,6 +1089,21 @@ PJ_INLINE(pjsip_cfg_t*) pjsip_cfg(void)
                                          2*PJSIP_MAX_DIALOG_COUNT)
 #endif
 
+/**
+ * Specify the number of shards of the endpoint timer heap. With more than
+ * one shard, timers are spread over independent heaps, each with its own
+ * lock, and worker threads can poll different shards without contending
+ * on a single timer heap lock (see pj_timer_heap_set_thread_shard()).
+ * Timers scheduled with a group lock stay in the same shard. This is
+ * useful when running many worker threads, and should normally be set
+ * to the number of worker threads.
+ *
+ * Default: 1 (no sharding)
+ */
+#ifndef PJSIP_TIMER_HEAP_SHARD_CNT
+#   define PJSIP_TIMER_HEAP_SHARD_CNT   1
+#endif
+
 /**
  * Initial memory block for the endpoint.
  */
@@ -998,6 +1135,19 @@ PJ_INLINE(pjsip_cfg_t*) pjsip_cfg(void)
 #   define PJSIP_POOL_RDATA_INC         4000
 #endif
 
+/**
+ * Initial memory block for rdata of connection oriented transports, such
+ * as TCP and TLS. Each connection keeps this block for as long as it is
+ * open, so servers with many mostly idle connections may reduce this to
+ * save memory, at the cost of allocating another block (of
+ * PJSIP_POOL_RDATA_INC size) for each message that needs more.
+ *
+ * Default: 2000
+ */
+#ifndef PJSIP_POOL_RDATA_CONN_LEN
+#   define PJSIP_POOL_RDATA_CONN_LEN    2000
+#endif
+
 /**
  * Initial memory block for SIP transport.
  */
@@ -1026,6 +1176,74 @@ PJ_INLINE(pjsip_cfg_t*) pjsip_cfg(void)
 #   define PJSIP_POOL_INC_TDATA         4000
 #endif
 
+/**
+ * Initial memory block size for the pre-encoded response headers of a
+ * request (see PJSIP_ENCODE_RSP_HDR).
+ */
+#ifndef PJSIP_POOL_LEN_RSP_HDR
+#   define PJSIP_POOL_LEN_RSP_HDR       6000
+#endif
+
+/**
+ * Memory increment for the pre-encoded response headers of a request.
+ */
+#ifndef PJSIP_POOL_INC_RSP_HDR
+#   define PJSIP_POOL_INC_RSP_HDR       2000
+#endif
+
+/**
+ * Maximum number of transmit buffers that the endpoint keeps for reuse
+ * by #pjsip_endpt_respond_stateless_raw(). Each of them holds a
+ * PJSIP_MAX_PKT_LEN buffer. Buffers beyond this number are still
+ * created when needed, but are destroyed once the response is sent.
+ *
+ * Default: 16
+ */
+#ifndef PJSIP_MAX_RAW_RSP_TDATA
+#   define PJSIP_MAX_RAW_RSP_TDATA      16
+#endif
+
+/**
+ * Default number of messages queued to a receive worker above which the
+ * endpoint considers itself overloaded, see #pjsip_overload_param.
+ *
+ * Default: 500
+ */
+#ifndef PJSIP_OVERLOAD_MAX_QUEUE_LEN
+#   define PJSIP_OVERLOAD_MAX_QUEUE_LEN         500
+#endif
+
+/**
+ * Default time, in msec, that the oldest message queued to a receive
+ * worker may wait before the endpoint considers itself overloaded, see
+ * #pjsip_overload_param.
+ *
+ * Default: 200
+ */
+#ifndef PJSIP_OVERLOAD_MAX_QUEUE_DELAY
+#   define PJSIP_OVERLOAD_MAX_QUEUE_DELAY       200
+#endif
+
+/**
+ * Default Retry-After value, in seconds, of the 503 response sent to
+ * requests rejected by overload control.
+ *
+ * Default: 5
+ */
+#ifndef PJSIP_OVERLOAD_RETRY_AFTER
+#   define PJSIP_OVERLOAD_RETRY_AFTER           5
+#endif
+
+/**
+ * Default "oc-validity" value, in msec, sent to clients that support
+ * overload control (RFC 7339).
+ *
+ * Default: 2000
+ */
+#ifndef PJSIP_OVERLOAD_OC_VALIDITY
+#   define PJSIP_OVERLOAD_OC_VALIDITY           2000
+#endif
+
 /**
  * Initial memory size for UA layer
  */
@@ -1371,6 +1589,54 @@ PJ_INLINE(pjsip_cfg_t*) pjsip_cfg(void)
 #   define PJSIP_AUTH_ALLOW_MULTIPLE_AUTH_HEADER 0
 #endif
 
+
+/**
+ * Default time-to-live (in seconds) of the digest HA1 cached by the server
+ * authorization cache, see #pjsip_auth_srv_cache_param. A cached HA1 lets
+ * the server skip the credential lookup callback, so changes to the
+ * account credentials only take effect after this period unless the entry
+ * is invalidated with pjsip_auth_srv_invalidate_cred().
+ *
+ * Default: 300 seconds
+ */
+#ifndef PJSIP_AUTH_SRV_HA1_TTL
+#   define PJSIP_AUTH_SRV_HA1_TTL               300
+#endif
+
+
+/**
+ * Default maximum number of accounts whose HA1 are kept in the server
+ * authorization cache.
+ *
+ * Default: 1024
+ */
+#ifndef PJSIP_AUTH_SRV_MAX_HA1
+#   define PJSIP_AUTH_SRV_MAX_HA1               1024
+#endif
+
+
+/**
+ * Default lifetime (in seconds) of the signed nonces issued by the server
+ * authorization cache. Authorization using an older nonce is rejected with
+ * PJSIP_EAUTHSTALENONCE.
+ *
+ * Default: 300 seconds
+ */
+#ifndef PJSIP_AUTH_SRV_NONCE_TTL
+#   define PJSIP_AUTH_SRV_NONCE_TTL             300
+#endif
+
+
+/**
+ * Default maximum number of nonces whose nonce count are tracked by the
+ * server authorization cache to detect replayed requests.
+ *
+ * Default: 1024
+ */
+#ifndef PJSIP_AUTH_SRV_MAX_NONCE
+#   define PJSIP_AUTH_SRV_MAX_NONCE             1024
+#endif
+
 /*****************************************************************************
  *  SIP Event framework and presence settings.
  */
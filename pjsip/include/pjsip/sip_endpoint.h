@@ -323,6 +323,190 @@ PJ_DECL(pj_status_t) pjsip_endpt_process_rx_data(pjsip_endpoint *endpt,
                                                  pjsip_process_rdata_param *p,
                                                  pj_bool_t *p_handled);
 
+/**
+ * This describes the statistics of a receive worker, see
+ * #pjsip_endpt_start_rx_workers().
+ */
+typedef struct pjsip_rx_worker_stat
+{
+    /** Number of messages currently queued to the worker. */
+    unsigned    queue_len;
+
+    /** Highest number of messages that have been queued to the worker. */
+    unsigned    max_queue_len;
+
+    /** Number of messages that have been processed by the worker. */
+    pj_uint32_t msg_cnt;
+
+    /** Average time the messages wait in the queue, in microseconds. */
+    pj_uint32_t avg_delay_usec;
+
+    /** Longest time a message has waited in the queue, in microseconds. */
+    pj_uint32_t max_delay_usec;
+
+} pjsip_rx_worker_stat;
+
+/**
+ * Start worker threads to process incoming messages. Normally incoming
+ * messages are given to the modules by the thread that polls the
+ * transport. Once the workers are started, the endpoint clones each
+ * incoming message with #pjsip_rx_data_clone() and queues it to one of
+ * the workers, chosen by the hash of the Call-ID. This way, the polling
+ * thread is not blocked by slow module callbacks, and messages of the
+ * same Call-ID are processed in order by the same thread.
+ *
+ * This function, and #pjsip_endpt_stop_rx_workers(), must not be called
+ * while other threads are handling events of the endpoint.
+ *
+ * @param endpt         The endpoint instance.
+ * @param worker_cnt    Number of worker threads.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjsip_endpt_start_rx_workers(pjsip_endpoint *endpt,
+                                                  unsigned worker_cnt);
+
+/**
+ * Stop the worker threads started by #pjsip_endpt_start_rx_workers(),
+ * after they have processed all the queued messages. Incoming messages
+ * will be processed by the polling thread again. This is called
+ * automatically when the endpoint is destroyed.
+ *
+ * @param endpt         The endpoint instance.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjsip_endpt_stop_rx_workers(pjsip_endpoint *endpt);
+
+/**
+ * Get the statistics of the receive workers.
+ *
+ * @param endpt         The endpoint instance.
+ * @param count         On input, the number of elements in the array.
+ *                      On output, the number of workers whose statistics
+ *                      have been filled in, zero if the workers are not
+ *                      running.
+ * @param stat          Array to receive the statistics of each worker.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjsip_endpt_get_rx_worker_stat(pjsip_endpoint *endpt,
+                                                    unsigned *count,
+                                                    pjsip_rx_worker_stat stat[]);
+
+/**
+ * This describes the overload control setting of the endpoint, see
+ * #pjsip_endpt_set_overload_param().
+ */
+typedef struct pjsip_overload_param
+{
+    /**
+     * Number of messages queued to a receive worker above which the
+     * endpoint is overloaded. Zero disables this check.
+     *
+     * Default: PJSIP_OVERLOAD_MAX_QUEUE_LEN
+     */
+    unsigned    max_queue_len;
+
+    /**
+     * Time, in msec, that the oldest message queued to a receive worker
+     * may wait before the endpoint is overloaded. Zero disables this
+     * check.
+     *
+     * Default: PJSIP_OVERLOAD_MAX_QUEUE_DELAY
+     */
+    unsigned    max_queue_delay;
+
+    /**
+     * Retry-After value, in seconds, of the 503 response. Zero to omit
+     * the Retry-After header.
+     *
+     * Default: PJSIP_OVERLOAD_RETRY_AFTER
+     */
+    unsigned    retry_after;
+
+    /**
+     * The "oc-validity" value, in msec, sent to clients that support
+     * overload control (RFC 7339).
+     *
+     * Default: PJSIP_OVERLOAD_OC_VALIDITY
+     */
+    unsigned    oc_validity;
+
+} pjsip_overload_param;
+
+/**
+ * This describes the overload control statistics of the endpoint.
+ */
+typedef struct pjsip_overload_stat
+{
+    /** Number of requests rejected with 503 because of overload. */
+    pj_uint32_t shed_cnt;
+
+    /** The last computed reduction percentage, zero if not overloaded. */
+    unsigned    reduction;
+
+} pjsip_overload_stat;
+
+/**
+ * Initialize overload control setting with default values.
+ *
+ * @param prm           The setting to be initialized.
+ */
+PJ_DECL(void) pjsip_overload_param_default(pjsip_overload_param *prm);
+
+/**
+ * Enable or disable overload control. When enabled, the endpoint checks
+ * the queue of the receive worker (see #pjsip_endpt_start_rx_workers())
+ * that would handle each new INVITE or REGISTER request, i.e. one without
+ * To tag. When the queue is longer or older than the limits, the endpoint
+ * computes a reduction percentage from how far the limit is exceeded, and
+ * rejects that percentage of new requests with a stateless 503 response
+ * (see #pjsip_endpt_respond_stateless_raw()) before the request is
+ * cloned or a transaction is created. Requests within a dialog, ACK,
+ * CANCEL, and responses are never rejected.
+ *
+ * If the client indicates support for overload control by adding "oc"
+ * parameter in its top Via (RFC 7339), the response also carries the
+ * "oc", "oc-algo", "oc-validity", and "oc-seq" parameters, so that the
+ * client can reduce its traffic before it is rejected.
+ *
+ * @param endpt         The endpoint instance.
+ * @param prm           The setting, or NULL to disable overload control.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjsip_endpt_set_overload_param(
+                                        pjsip_endpoint *endpt,
+                                        const pjsip_overload_param *prm);
+
+/**
+ * Set the reduction percentage applied regardless of the receive worker
+ * queues, for example when application's own policy detects that it is
+ * overloaded (CPU usage, database latency, etc). The higher of this
+ * value and the one computed from the queues is used. Overload control
+ * must have been enabled with #pjsip_endpt_set_overload_param().
+ *
+ * @param endpt         The endpoint instance.
+ * @param reduction     Percentage (0-100) of new requests to reject.
+ *                      Zero to clear.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjsip_endpt_set_overloaded(pjsip_endpoint *endpt,
+                                                unsigned reduction);
+
+/**
+ * Get the overload control statistics.
+ *
+ * @param endpt         The endpoint instance.
+ * @param stat          To receive the statistics.
+ *
+ * @return              PJ_SUCCESS on success.
+ */
+PJ_DECL(pj_status_t) pjsip_endpt_get_overload_stat(pjsip_endpoint *endpt,
+                                                   pjsip_overload_stat *stat);
+
 /**
  * Create pool from the endpoint. All SIP components should allocate their
  * memory pool by calling this function, to make sure that the pools are
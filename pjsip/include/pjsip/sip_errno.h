@@ -400,6 +400,18 @@ PJ_BEGIN_DECL
  * No challenge is found in the challenge.
  */
 #define PJSIP_EAUTHNOCHAL       (PJSIP_ERRNO_START_PJSIP + 114) /* 171114 */
+/**
+ * @hideinitializer
+ * The nonce in the authorization has expired, the client should be
+ * challenged again with stale=true.
+ */
+#define PJSIP_EAUTHSTALENONCE   (PJSIP_ERRNO_START_PJSIP + 115) /* 171115 */
+/**
+ * @hideinitializer
+ * The nonce count in the authorization has been used before, i.e: the
+ * request is possibly replayed.
+ */
+#define PJSIP_EAUTHNCREPLAY     (PJSIP_ERRNO_START_PJSIP + 116) /* 171116 */
 
 /************************************************************
  * UA AND DIALOG ERRORS
@@ -349,6 +349,43 @@ PJ_DECL(void*) pjsip_hdr_clone( pj_pool_t *pool, const void *hdr );
  */
 PJ_DECL(void*) pjsip_hdr_shallow_clone( pj_pool_t *pool, const void *hdr );
 
+/**
+ * Create a pre-encoded copy of the header. The copy is a normal header of
+ * the same type and with the same values, so it can be found with
+ * #pjsip_msg_find_hdr() and its fields can be read as usual, but it is
+ * printed by copying the text encoded when this function was called. This
+ * is useful for headers that are put in many messages without changes,
+ * such as User-Agent or the headers that are copied from a request to its
+ * responses.
+ *
+ * Shallow clone of a pre-encoded header (with #pjsip_hdr_shallow_clone())
+ * shares the encoded text, and is pre-encoded too. Full clone (with
+ * #pjsip_hdr_clone()) is a normal header. If the header is already
+ * pre-encoded, the encoded text is copied instead of printing it again.
+ *
+ * Modifying the fields of a pre-encoded header does not change how it is
+ * printed, so application that needs to modify it must replace it with
+ * a full clone first.
+ *
+ * @param pool      The pool to allocate memory from.
+ * @param hdr       The header to encode.
+ *
+ * @return          A new pre-encoded header, or NULL if the header can't
+ *                  be printed.
+ */
+PJ_DECL(void*) pjsip_hdr_encode( pj_pool_t *pool, const void *hdr );
+
+/**
+ * Check if the header is a pre-encoded header created with
+ * #pjsip_hdr_encode() or its shallow clone.
+ *
+ * @param hdr       The header.
+ *
+ * @return          PJ_TRUE if the header is pre-encoded.
+ */
+PJ_DECL(pj_bool_t) pjsip_hdr_is_encoded( const void *hdr );
+
+
 /**
  * This generic function will print any header, by calling "print" 
  * function in header's virtual function table.
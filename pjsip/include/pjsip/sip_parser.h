@@ -144,6 +144,11 @@ typedef void* (pjsip_parse_uri_func)(pj_scanner *scanner, pj_pool_t *pool,
  * specification of header parser handler function. New registration 
  * overwrites previous registration with the same name.
  *
+ * The parser reports errors by throwing PJSIP_SYN_ERR_EXCEPTION as
+ * described above. The built-in parsers run without exception handling;
+ * registered handlers are always called inside a PJ_TRY block and the
+ * exception is converted to a parse error on the way out.
+ *
  * @param hname         The header name.
  * @param hshortname    The short header name or NULL.
  * @param fptr          The pointer to function to parser the header.
@@ -322,6 +327,31 @@ PJ_DECL(void*) pjsip_parse_hdr( pj_pool_t *pool, const pj_str_t *hname,
                                 char *line, pj_size_t size,
                                 int *parsed_len);
 
+/**
+ * Parse a header whose parsing has been deferred by the lazy header
+ * parsing mode (see \a lazy_hdr_parsing in pjsip_cfg_t), if it matches
+ * the specified header type or name. On success, the deferred header is
+ * replaced in its list by the parsed header(s). If the value turns out
+ * to be invalid, it is replaced by a generic string header instead.
+ *
+ * This function is called by the header lookup functions such as
+ * pjsip_msg_find_hdr(), so applications normally don't need to call it.
+ *
+ * @param hdr           The header.
+ * @param type          The header type to match, used when both \a name
+ *                      and \a sname are NULL.
+ * @param name          Header name to match, or NULL.
+ * @param sname         Optional short header name to match, or NULL.
+ *
+ * @return              The first header which replaced \a hdr in the list,
+ *                      or NULL if \a hdr is not a deferred header or
+ *                      doesn't match.
+ */
+PJ_DECL(pjsip_hdr*) pjsip_parse_lazy_hdr( pjsip_hdr *hdr,
+                                          pjsip_hdr_e type,
+                                          const pj_str_t *name,
+                                          const pj_str_t *sname);
+
 /**
  * Parse header line(s). Multiple headers can be parsed by this function.
  * When there are multiple headers, the headers MUST be separated by either
@@ -26,6 +26,24 @@
 
 #include <pjsip/sip_types.h>
 
+PJ_BEGIN_DECL
+
+/*
+ * Get a transmit buffer for pjsip_endpt_respond_stateless_raw(), reusing
+ * one from a previous response if available (sip_endpoint.c).
+ */
+pj_status_t pjsip_endpt_acquire_raw_tdata(pjsip_endpoint *endpt,
+                                          pjsip_tx_data **p_tdata);
+
+/*
+ * Return the transmit buffer acquired with pjsip_endpt_acquire_raw_tdata()
+ * (sip_endpoint.c).
+ */
+void pjsip_endpt_release_raw_tdata(pjsip_endpoint *endpt,
+                                   pjsip_tx_data *tdata);
+
+PJ_END_DECL
+
 
 #endif /* __PJSIP_PRIVATE_I_H__ */
 
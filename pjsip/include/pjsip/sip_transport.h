@@ -316,6 +316,20 @@ typedef struct pjsip_rx_data_op_key
 } pjsip_rx_data_op_key;
 
 
+/**
+ * Pre-encoded headers of a request that are copied to its responses (see
+ * PJSIP_ENCODE_RSP_HDR). It is shared by the pjsip_rx_data of the request
+ * and the responses created for it, and destroyed when the last of them
+ * releases it. Application should not use this.
+ */
+typedef struct pjsip_rsp_hdr_cache
+{
+    pj_pool_t           *pool;      /**< Pool for the headers.          */
+    pj_atomic_t         *ref_cnt;   /**< Reference counter.             */
+    pjsip_hdr            hdr;       /**< The pre-encoded headers.       */
+} pjsip_rsp_hdr_cache;
+
+
 /**
  * Incoming message buffer.
  * This structure keep all the information regarding the received message. This
@@ -445,6 +459,13 @@ struct pjsip_rx_data
          */
         pjsip_parser_err_report parse_err;
 
+        /** Pre-encoded copies of the request headers that are copied to
+         *  responses, created by pjsip_endpt_create_response() when
+         *  \a encode_rsp_hdr in pjsip_cfg_t is enabled, or NULL.
+         *  Application should not use this.
+         */
+        pjsip_rsp_hdr_cache     *rsp_hdr;
+
     } msg_info;
 
 
@@ -493,6 +514,17 @@ PJ_DECL(pj_status_t) pjsip_rx_data_clone(const pjsip_rx_data *src,
                                          unsigned flags,
                                          pjsip_rx_data **p_rdata);
 
+/**
+ * Release the pre-encoded response headers of the request in the rdata,
+ * if any (see PJSIP_ENCODE_RSP_HDR). The transport manager calls this
+ * after the message has been processed, and #pjsip_rx_data_free_cloned()
+ * calls it too, so application only needs to call it for pjsip_rx_data
+ * that it creates by itself.
+ *
+ * @param rdata     The receive data buffer.
+ */
+PJ_DECL(void) pjsip_rx_data_release_rsp_hdr(pjsip_rx_data *rdata);
+
 /**
  * Free cloned pjsip_rx_data. This function must be and must only
  * be called for a cloned pjsip_rx_data. Specifically, it must NOT
@@ -673,6 +705,13 @@ struct pjsip_tx_data
      */
     pjsip_host_port          via_addr;      /**< Via address.           */
     const void              *via_tp;        /**< Via transport.         */
+
+    /**
+     * Pre-encoded headers shared with the request, if this is a response
+     * created by pjsip_endpt_create_response() with \a encode_rsp_hdr in
+     * pjsip_cfg_t enabled. Application should not use this.
+     */
+    pjsip_rsp_hdr_cache     *rsp_hdr;
 };
 
 
@@ -936,6 +975,14 @@ struct pjsip_transport
      */
     pj_status_t (*destroy)(pjsip_transport *transport);
 
+    /**
+     * Internal: time when the reference counter became zero, as
+     * pj_gettickcount(). The idle timer is not cancelled when the transport
+     * is used again, so it checks this when it expires. Application and
+     * transport implementations should not touch this field.
+     */
+    pj_time_val             idle_ts;
+
     /*
      * Application may extend this structure..
      */
@@ -403,6 +403,36 @@ typedef struct pjsip_tls_setting
      */
     pj_bool_t enable_renegotiation;
 
+    /**
+     * Specify if TLS session resumption is enabled. When enabled, outgoing
+     * connections will try to resume the session previously negotiated with
+     * the same server, avoiding the full handshake, and the listener will
+     * issue session tickets. Currently it's only implemented for OpenSSL
+     * backend.
+     *
+     * Default: PJ_FALSE
+     */
+    pj_bool_t session_resumption;
+
+    /**
+     * Lifetime of resumable TLS sessions, in seconds. See also
+     * #pj_ssl_sock_param.session_timeout.
+     *
+     * Default: 0 (use the SSL backend's default)
+     */
+    unsigned session_timeout;
+
+    /**
+     * Specify if TLS handshakes are performed by the SSL socket handshake
+     * worker threads instead of by the ioqueue polling thread, so that
+     * expensive handshakes, e.g: when many clients reconnect at once, do
+     * not delay other SIP and media events. See also
+     * #pj_ssl_sock_param.async_handshake.
+     *
+     * Default: PJ_FALSE
+     */
+    pj_bool_t async_handshake;
+
     /**
      * Callback to be called when a accept operation of the TLS listener fails.
      *
@@ -120,6 +120,32 @@ typedef struct pjsip_udp_transport_cfg
      */
     pj_sockopt_params   sockopt_params;
 
+    /**
+     * Number of sockets to back the transport with. When this is greater
+     * than one, all sockets are bound to the same address with
+     * SO_REUSEPORT, so the kernel distributes incoming packets among them
+     * by flow hash. Each socket is registered to the ioqueue with its own
+     * key and \a async_cnt pending read operations, so incoming packets
+     * of different flows can be received and processed concurrently.
+     * Outgoing messages are always sent with the first socket.
+     *
+     * Values greater than one require SO_REUSEPORT support (e.g. Linux
+     * 3.9 or later), otherwise the transport creation will fail with
+     * PJ_ENOTSUP.
+     *
+     * Default: 1
+     */
+    unsigned            sock_cnt;
+
+    /**
+     * Specify whether each socket should be polled by its own ioqueue and
+     * worker thread, created by the transport, instead of by the endpoint
+     * ioqueue (i.e. by the threads calling pjsip_endpt_handle_events()).
+     *
+     * Default: PJ_FALSE
+     */
+    pj_bool_t           sock_worker_thread;
+
 } pjsip_udp_transport_cfg;
 
 
@@ -233,7 +259,9 @@ PJ_DECL(pj_status_t) pjsip_udp_transport_attach2(pjsip_endpoint *endpt,
  * Retrieve the internal socket handle used by the UDP transport. Note
  * that this socket normally is registered to ioqueue, so if application
  * wants to make use of this socket, it should temporarily pause the
- * transport.
+ * transport. If the transport is backed by several sockets (see
+ * \a sock_cnt in #pjsip_udp_transport_cfg), this returns the first socket,
+ * which is the one used for sending.
  *
  * @param transport     The UDP transport.
  *
@@ -346,7 +374,13 @@ PJ_DECL(pj_status_t) pjsip_udp_transport_restart(pjsip_transport *transport,
  *    may specify the published address of the socket in \a a_name
  *    argument. This is another version of pjsip_udp_transport_restart() 
  *    able to restart IPv6 transport.
- * 
+ *
+ * If the transport is backed by several sockets (see \a sock_cnt in
+ * #pjsip_udp_transport_cfg), the additional sockets are recreated and
+ * bound to the address of the new socket with SO_REUSEPORT. If this
+ * fails (e.g. because application specified its own socket without
+ * SO_REUSEPORT), the transport continues with the new socket only.
+ *
  * Note that prior to calling this method, any locks acquired need to 
  * be released temporarily to avoid any deadlock scenario.  
  * This method will loop to wait for read operation to finish before actually 
@@ -57,6 +57,15 @@ typedef struct pjsip_ua_init_param
      *  dialog has forked.
      */
     pjsip_dialog* (*on_dlg_forked)(pjsip_dialog *first_set, pjsip_rx_data *res);
+
+    /** Number of lock stripes of the dialog table. With more than one
+     *  stripe, dialog sets are spread over several hash tables by the
+     *  local tag, each protected by its own mutex, so threads processing
+     *  messages of different dialogs don't contend on a single lock.
+     *  Zero means to use PJSIP_UA_LOCK_STRIPE_CNT.
+     */
+    unsigned lock_stripe_cnt;
+
 } pjsip_ua_init_param;
 
 /**
@@ -337,6 +337,31 @@ PJ_DECL(pj_status_t) pjsip_endpt_create_response( pjsip_endpoint *endpt,
                                                   const pj_str_t *st_text,
                                                   pjsip_tx_data **p_tdata);
 
+/**
+ * Print a minimal response for the received request directly to a buffer,
+ * without creating the transmit data and the message. The output is the
+ * same as printing the response created by #pjsip_endpt_create_response()
+ * with the headers in \a hdr_list added to it and without message body.
+ *
+ * @param rdata     The request receive data.
+ * @param st_code   Status code to be put in the response.
+ * @param st_text   Optional status text, or NULL to get the default text.
+ * @param hdr_list  Optional list of headers to be added to the response,
+ *                  for example WWW-Authenticate or Retry-After. Headers
+ *                  that are pre-encoded with #pjsip_hdr_encode() are
+ *                  printed with a single copy.
+ * @param buf       The buffer.
+ * @param size      The size of the buffer.
+ *
+ * @return          The length of the response printed to the buffer, or
+ *                  -1 if the buffer is too small.
+ */
+PJ_DECL(pj_ssize_t) pjsip_print_stateless_response(const pjsip_rx_data *rdata,
+                                                  int st_code,
+                                                  const pj_str_t *st_text,
+                                                  const pjsip_hdr *hdr_list,
+                                                  char *buf, pj_size_t size);
+
 /**
  * Construct a full ACK request for the received non-2xx final response.
  * This utility function is normally called by the transaction to construct
@@ -719,6 +744,36 @@ PJ_DECL(pj_status_t) pjsip_endpt_respond_stateless(pjsip_endpoint *endpt,
                                                    const pj_str_t *st_text,
                                                    const pjsip_hdr *hdr_list,
                                                    const pjsip_msg_body *body);
+
+/**
+ * Send a response without message body statelessly to an incoming request,
+ * like #pjsip_endpt_respond_stateless(), but without creating the transmit
+ * data pool and the response message. The response is printed with
+ * #pjsip_print_stateless_response() to a transmit buffer that is reused
+ * across calls, and sent with the transport where the request was
+ * received. This is meant for high volume of simple responses such as
+ * 100, 401/407 with challenge, 403, 404, 408, 480, or 503 with
+ * Retry-After.
+ *
+ * Since there is no response message, the response is not passed to
+ * the modules' \a on_tx_response() callback. Requests whose response
+ * must be sent to the maddr parameter of the Via header are responded
+ * with #pjsip_endpt_respond_stateless().
+ *
+ * @param endpt     The endpoint instance.
+ * @param rdata     The incoming request message.
+ * @param st_code   Status code of the response.
+ * @param st_text   Optional status text of the response.
+ * @param hdr_list  Optional header list to be added to the response.
+ *
+ * @return          PJ_SUCCESS if response message has successfully been
+ *                  sent.
+ */
+PJ_DECL(pj_status_t) pjsip_endpt_respond_stateless_raw(pjsip_endpoint *endpt,
+                                                       pjsip_rx_data *rdata,
+                                                       int st_code,
+                                                       const pj_str_t *st_text,
+                                                       const pjsip_hdr *hdr_list);
                                                     
 /**
  * @}
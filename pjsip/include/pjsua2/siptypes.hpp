@@ -409,6 +409,29 @@ struct TlsConfig : public PersistentObject
      */
     bool                enableRenegotiation;
 
+    /**
+     * Specify if TLS session resumption is enabled, so reconnecting to the
+     * same server only needs an abbreviated handshake.
+     *
+     * Default: false
+     */
+    bool                sessionResumption;
+
+    /**
+     * Lifetime of resumable TLS sessions, in seconds.
+     *
+     * Default: 0 (use the SSL backend's default)
+     */
+    unsigned            sessionTimeout;
+
+    /**
+     * Specify if TLS handshakes are performed by dedicated handshake
+     * worker threads instead of by the ioqueue polling thread.
+     *
+     * Default: false
+     */
+    bool                asyncHandshake;
+
 public:
     /** Default constructor initialises with default values */
     TlsConfig();
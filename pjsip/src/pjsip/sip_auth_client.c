@@ -20,6 +20,7 @@
 #include <pjsip/sip_auth.h>
 #include <pjsip/sip_auth_parser.h>      /* just to get pjsip_DIGEST_STR */
 #include <pjsip/sip_auth_aka.h>
+#include <pjsip/sip_parser.h>
 #include <pjsip/sip_transport.h>
 #include <pjsip/sip_endpoint.h>
 #include <pjsip/sip_errno.h>
@@ -208,6 +209,92 @@ static void digestNtoStr(const unsigned char digest[], int n, char *output)
 }
 
 
+/*
+ * Compute the ASCII "ha1" of the credential. The cred_info, and for digest
+ * credential its length, must have been validated by caller.
+ */
+static void compute_ha1(const EVP_MD *md,
+                        const pjsip_auth_algorithm *algorithm,
+                        const pj_str_t *realm,
+                        const pjsip_cred_info *cred_info,
+                        char ha1[])
+{
+    if (PJSIP_CRED_DATA_IS_PASSWD(cred_info))
+    {
+        unsigned char digest[PJSIP_AUTH_MAX_DIGEST_BUFFER_LENGTH];
+        unsigned dig_len = algorithm->digest_length;
+        DEFINE_HASH_CONTEXT;
+
+        AUTH_TRACE_((THIS_FILE, " Using plain text password for %.*s digest",
+                (int)algorithm->iana_name.slen, algorithm->iana_name.ptr));
+        /***
+         *** ha1 = (digest)(username ":" realm ":" password)
+         ***/
+        mdctx = EVP_MD_CTX_new();
+
+        EVP_DigestInit_ex(mdctx, md, NULL);
+        EVP_DigestUpdate(mdctx, cred_info->username.ptr, cred_info->username.slen);
+        EVP_DigestUpdate(mdctx, ":", 1);
+        EVP_DigestUpdate(mdctx, realm->ptr, realm->slen);
+        EVP_DigestUpdate(mdctx, ":", 1);
+        EVP_DigestUpdate(mdctx, cred_info->data.ptr, cred_info->data.slen);
+
+        EVP_DigestFinal_ex(mdctx, digest, &dig_len);
+        EVP_MD_CTX_free(mdctx);
+        digestNtoStr(digest, dig_len, ha1);
+
+    } else {
+        AUTH_TRACE_((THIS_FILE, " Using pre computed digest for %.*s digest",
+                (int)algorithm->iana_name.slen, algorithm->iana_name.ptr));
+        pj_memcpy( ha1, cred_info->data.ptr, algorithm->digest_str_length );
+    }
+}
+
+
+/*
+ * Create the "ha1" of the credential and store the ASCII in 'result'.
+ */
+PJ_DEF(pj_status_t) pjsip_auth_create_ha1(pj_str_t *result,
+                                          const pj_str_t *realm,
+                                          const pjsip_cred_info *cred_info,
+                                          const pjsip_auth_algorithm_type algorithm_type)
+{
+    const pjsip_auth_algorithm *algorithm;
+    const EVP_MD* md;
+
+    PJ_ASSERT_RETURN(result && realm && cred_info, PJ_EINVAL);
+
+    algorithm = pjsip_auth_get_algorithm_by_type(algorithm_type);
+    if (!algorithm || !pjsip_auth_is_algorithm_supported(algorithm_type))
+        return PJ_ENOTSUP;
+
+    if (result->slen < (pj_ssize_t)algorithm->digest_str_length)
+        return PJ_ETOOSMALL;
+
+    if (PJSIP_CRED_DATA_IS_DIGEST(cred_info)) {
+        if (cred_info->algorithm_type != PJSIP_AUTH_ALGORITHM_NOT_SET &&
+            cred_info->algorithm_type != algorithm_type)
+        {
+            return PJ_EINVAL;
+        }
+        PJ_ASSERT_RETURN(cred_info->data.slen >=
+                         (pj_ssize_t)algorithm->digest_str_length,
+                         PJ_EINVAL);
+    } else if (!PJSIP_CRED_DATA_IS_PASSWD(cred_info)) {
+        return PJ_EINVAL;
+    }
+
+    md = EVP_get_digestbyname(algorithm->openssl_name);
+    if (md == NULL)
+        return PJ_ENOTSUP;
+
+    compute_ha1(md, algorithm, realm, cred_info, result->ptr);
+    result->slen = algorithm->digest_str_length;
+
+    return PJ_SUCCESS;
+}
+
+
 /*
  * Create response digest based on the parameters and store the
  * digest ASCII in 'result'.
@@ -302,31 +389,7 @@ PJ_DEF(pj_status_t) pjsip_auth_create_digest2( pj_str_t *result,
     AUTH_TRACE_((THIS_FILE, "Begin creating %.*s digest",
             (int)algorithm->iana_name.slen, algorithm->iana_name.ptr));
 
-    if (PJSIP_CRED_DATA_IS_PASSWD(cred_info))
-    {
-        AUTH_TRACE_((THIS_FILE, " Using plain text password for %.*s digest",
-                (int)algorithm->iana_name.slen, algorithm->iana_name.ptr));
-        /***
-         *** ha1 = (digest)(username ":" realm ":" password)
-         ***/
-        mdctx = EVP_MD_CTX_new();
-
-        EVP_DigestInit_ex(mdctx, md, NULL);
-        EVP_DigestUpdate(mdctx, cred_info->username.ptr, cred_info->username.slen);
-        EVP_DigestUpdate(mdctx, ":", 1);
-        EVP_DigestUpdate(mdctx, realm->ptr, realm->slen);
-        EVP_DigestUpdate(mdctx, ":", 1);
-        EVP_DigestUpdate(mdctx, cred_info->data.ptr, cred_info->data.slen);
-
-        EVP_DigestFinal_ex(mdctx, digest, &dig_len);
-        EVP_MD_CTX_free(mdctx);
-        digestNtoStr(digest, dig_len, ha1);
-
-    } else {
-        AUTH_TRACE_((THIS_FILE, " Using pre computed digest for %.*s digest",
-                (int)algorithm->iana_name.slen, algorithm->iana_name.ptr));
-        pj_memcpy( ha1, cred_info->data.ptr, cred_info->data.slen );
-    }
+    compute_ha1(md, algorithm, realm, cred_info, ha1);
 
     AUTH_TRACE_((THIS_FILE, " ha1=%.*s", algorithm->digest_str_length, ha1));
 
@@ -944,9 +1007,18 @@ PJ_DEF(pj_status_t) pjsip_auth_clt_set_credentials( pjsip_auth_clt_sess *sess,
                                                     int cred_cnt,
                                                     const pjsip_cred_info *c)
 {
+    pjsip_cached_auth *auth;
+
     PJ_ASSERT_RETURN(sess && c, PJ_EINVAL);
     DO_ON_PARENT_LOCKED(sess, pjsip_auth_clt_set_credentials(sess->parent, cred_cnt, c));
 
+    /* Precomputed HA1 belongs to the old credentials */
+    auth = sess->cached_auth.next;
+    while (auth != &sess->cached_auth) {
+        auth->ha1_cred = NULL;
+        auth = auth->next;
+    }
+
     if (cred_cnt == 0) {
         sess->cred_cnt = 0;
     } else {
@@ -1100,6 +1172,7 @@ static pj_status_t auth_respond( pj_pool_t *req_pool,
     if (!pj_stricmp(&hdr->scheme, &pjsip_DIGEST_STR)) {
         pj_str_t *cnonce = NULL;
         pj_uint32_t nc = 1;
+        pjsip_cred_info ha1_cred;
 
         /* Update the session (nonce-count etc) if required. */
 #       if PJSIP_AUTH_QOP_SUPPORT
@@ -1113,6 +1186,37 @@ static pj_status_t auth_respond( pj_pool_t *req_pool,
         }
 #       endif   /* PJSIP_AUTH_QOP_SUPPORT */
 
+        /* Hash the plain text password into HA1 only once per session
+         * and realm, subsequent requests reuse the precomputed HA1.
+         */
+        if (PJSIP_CRED_DATA_IS_PASSWD(cred_info) &&
+            !pj_strcmp(&hdr->challenge.digest.realm, &cached_auth->realm))
+        {
+            if (cached_auth->ha1_cred != cred_info ||
+                cached_auth->ha1_algorithm_type != challenge_algorithm_type)
+            {
+                cached_auth->ha1.ptr = cached_auth->ha1_buf;
+                cached_auth->ha1.slen = sizeof(cached_auth->ha1_buf);
+                status = pjsip_auth_create_ha1(&cached_auth->ha1,
+                                               &cached_auth->realm, cred_info,
+                                               challenge_algorithm_type);
+                if (status == PJ_SUCCESS) {
+                    cached_auth->ha1_cred = cred_info;
+                    cached_auth->ha1_algorithm_type = challenge_algorithm_type;
+                } else {
+                    cached_auth->ha1_cred = NULL;
+                }
+            }
+
+            if (cached_auth->ha1_cred == cred_info) {
+                ha1_cred = *cred_info;
+                ha1_cred.data_type = PJSIP_CRED_DATA_DIGEST;
+                ha1_cred.data = cached_auth->ha1;
+                ha1_cred.algorithm_type = challenge_algorithm_type;
+                cred_info = &ha1_cred;
+            }
+        }
+
         hauth->scheme = pjsip_DIGEST_STR;
         status = respond_digest( pool, &hauth->credential.digest,
                                  &hdr->challenge.digest, &uri_str, cred_info,
@@ -1652,6 +1756,23 @@ PJ_DEF(pj_status_t) pjsip_auth_clt_reinit_req(  pjsip_auth_clt_sess *sess,
                hdr->type != PJSIP_H_WWW_AUTHENTICATE &&
                hdr->type != PJSIP_H_PROXY_AUTHENTICATE)
         {
+            /* Parse the header if its parsing has been deferred */
+            if (hdr->type == PJSIP_H_OTHER) {
+                pjsip_hdr *parsed;
+
+                parsed = pjsip_parse_lazy_hdr((pjsip_hdr*)hdr,
+                                              PJSIP_H_WWW_AUTHENTICATE,
+                                              NULL, NULL);
+                if (!parsed) {
+                    parsed = pjsip_parse_lazy_hdr((pjsip_hdr*)hdr,
+                                                  PJSIP_H_PROXY_AUTHENTICATE,
+                                                  NULL, NULL);
+                }
+                if (parsed) {
+                    hdr = parsed;
+                    continue;
+                }
+            }
             hdr = hdr->next;
         }
         if (hdr == &rdata->msg_info.msg->hdr)
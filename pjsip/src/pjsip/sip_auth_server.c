@@ -22,10 +22,36 @@
 #include <pjsip/sip_auth_msg.h>
 #include <pjsip/sip_errno.h>
 #include <pjsip/sip_transport.h>
+#include <pjlib-util/hmac_sha1.h>
+#include <pjlib-util/sha1.h>
+#include <pj/ctype.h>
+#include <pj/hash.h>
+#include <pj/list.h>
+#include <pj/lock.h>
 #include <pj/log.h>
+#include <pj/os.h>
+#include <pj/pool.h>
+#include <pj/rand.h>
 #include <pj/string.h>
 #include <pj/assert.h>
 
+#if defined(PJ_HAS_SSL_SOCK) && PJ_HAS_SSL_SOCK != 0 && \
+    PJ_SSL_SOCK_IMP==PJ_SSL_SOCK_IMP_OPENSSL
+#  include <openssl/rand.h>
+#  define HAS_SECURE_RANDOM     1
+
+#  ifdef _MSC_VER
+#    include <openssl/opensslv.h>
+#    if OPENSSL_VERSION_NUMBER >= 0x10100000L
+#      pragma comment(lib, "libcrypto")
+#    else
+#      pragma comment(lib, "libeay32")
+#    endif
+#  endif
+#else
+#  define HAS_SECURE_RANDOM     0
+#endif
+
 /* Logging. */
 #define THIS_FILE   "sip_auth_server.c"
 #if 0
@@ -34,6 +60,60 @@
 #  define AUTH_TRACE_(expr)
 #endif
 
+/* Signed nonce layout: creation time, random and the truncated HMAC-SHA1
+ * of both, all in hex.
+ */
+#define NONCE_TS_LEN    8
+#define NONCE_RAND_LEN  8
+#define NONCE_SIG_LEN   24
+#define NONCE_LEN       (NONCE_TS_LEN + NONCE_RAND_LEN + NONCE_SIG_LEN)
+
+/* Longest account name whose HA1 will be cached */
+#define MAX_ACC_NAME    255
+
+/* Cached HA1 of an account, keyed by algorithm type followed by the
+ * account name.
+ */
+typedef struct ha1_entry
+{
+    PJ_DECL_LIST_MEMBER(struct ha1_entry);
+    pj_hash_entry_buf            hbuf;
+    char                        *key;
+    unsigned                     key_len;
+    unsigned                     key_cap;
+    char                         ha1[PJSIP_AUTH_MAX_DIGEST_BUFFER_LENGTH*2];
+    unsigned                     ha1_len;
+    long                         expire;
+} ha1_entry;
+
+/* Last nonce count seen for a signed nonce */
+typedef struct nc_entry
+{
+    PJ_DECL_LIST_MEMBER(struct nc_entry);
+    pj_hash_entry_buf            hbuf;
+    char                         nonce[NONCE_LEN];
+    pj_uint32_t                  nc;
+    long                         expire;
+} nc_entry;
+
+/* Server authorization cache */
+struct pjsip_auth_srv_cache
+{
+    pj_pool_t                   *pool;
+    pj_lock_t                   *lock;
+    pjsip_auth_srv_cache_param   param;
+
+    pj_hash_table_t             *ha1_table;
+    ha1_entry                    ha1_list;  /* Most recently used first */
+    ha1_entry                    ha1_free;
+    unsigned                     ha1_cnt;
+
+    pj_hash_table_t             *nc_table;
+    nc_entry                     nc_list;   /* Most recently used first */
+    nc_entry                     nc_free;
+    unsigned                     nc_cnt;
+};
+
 
 /*
  * Initialize server authorization session data structure to serve the 
@@ -77,6 +157,421 @@ PJ_DEF(pj_status_t) pjsip_auth_srv_init2(
 }
 
 
+/*
+ * Initialize server authorization cache settings with default values.
+ */
+PJ_DEF(void) pjsip_auth_srv_cache_param_default(
+                                    pjsip_auth_srv_cache_param *param)
+{
+    pj_bzero(param, sizeof(*param));
+    param->ha1_ttl = PJSIP_AUTH_SRV_HA1_TTL;
+    param->max_ha1 = PJSIP_AUTH_SRV_MAX_HA1;
+    param->nonce_ttl = PJSIP_AUTH_SRV_NONCE_TTL;
+    param->max_nonce = PJSIP_AUTH_SRV_MAX_NONCE;
+}
+
+
+/* Fill buf with cryptographically secure random bytes. */
+static pj_status_t secure_random(void *buf, unsigned len)
+{
+#if HAS_SECURE_RANDOM
+    if (RAND_bytes((unsigned char*)buf, (int)len) != 1)
+        return PJ_EUNKNOWN;
+    return PJ_SUCCESS;
+#else
+    PJ_UNUSED_ARG(buf);
+    PJ_UNUSED_ARG(len);
+    return PJ_ENOTSUP;
+#endif
+}
+
+
+/*
+ * Enable authorization cache.
+ */
+PJ_DEF(pj_status_t) pjsip_auth_srv_enable_cache(
+                                    pj_pool_t *pool,
+                                    pjsip_auth_srv *auth_srv,
+                                    const pjsip_auth_srv_cache_param *param)
+{
+    pjsip_auth_srv_cache *cache;
+    pj_status_t status;
+
+    PJ_ASSERT_RETURN(pool && auth_srv, PJ_EINVAL);
+    PJ_ASSERT_RETURN(auth_srv->cache == NULL, PJ_EINVALIDOP);
+
+    cache = PJ_POOL_ZALLOC_T(pool, pjsip_auth_srv_cache);
+    cache->pool = pool;
+    if (param)
+        pj_memcpy(&cache->param, param, sizeof(*param));
+    else
+        pjsip_auth_srv_cache_param_default(&cache->param);
+
+    if (cache->param.secret.slen) {
+        pj_strdup(pool, &cache->param.secret, &param->secret);
+    } else if (cache->param.nonce_ttl) {
+        /* Generate random secret to sign the nonces. A guessable secret
+         * would let anyone forge the nonces, so refuse to continue if no
+         * secure random generator is available.
+         */
+        cache->param.secret.ptr = (char*)pj_pool_alloc(pool,
+                                                       PJ_SHA1_DIGEST_SIZE);
+        cache->param.secret.slen = PJ_SHA1_DIGEST_SIZE;
+        status = secure_random(cache->param.secret.ptr, PJ_SHA1_DIGEST_SIZE);
+        if (status != PJ_SUCCESS) {
+            PJ_PERROR(2,(THIS_FILE, status, "Unable to generate nonce "
+                         "secret, application must supply the secret"));
+            return status;
+        }
+    }
+
+    pj_list_init(&cache->ha1_list);
+    pj_list_init(&cache->ha1_free);
+    if (cache->param.ha1_ttl && cache->param.max_ha1) {
+        cache->ha1_table = pj_hash_create(pool, cache->param.max_ha1);
+        PJ_ASSERT_RETURN(cache->ha1_table, PJ_ENOMEM);
+    } else {
+        cache->param.ha1_ttl = 0;
+    }
+
+    pj_list_init(&cache->nc_list);
+    pj_list_init(&cache->nc_free);
+    if (cache->param.nonce_ttl && cache->param.max_nonce) {
+        cache->nc_table = pj_hash_create(pool, cache->param.max_nonce);
+        PJ_ASSERT_RETURN(cache->nc_table, PJ_ENOMEM);
+    } else {
+        cache->param.max_nonce = 0;
+    }
+
+    status = pj_lock_create_simple_mutex(pool, "authsrv%p", &cache->lock);
+    if (status != PJ_SUCCESS)
+        return status;
+
+    auth_srv->cache = cache;
+
+    return PJ_SUCCESS;
+}
+
+
+/*
+ * Release the resources of the server authorization session.
+ */
+PJ_DEF(pj_status_t) pjsip_auth_srv_deinit(pjsip_auth_srv *auth_srv)
+{
+    PJ_ASSERT_RETURN(auth_srv, PJ_EINVAL);
+
+    if (auth_srv->cache) {
+        pj_lock_destroy(auth_srv->cache->lock);
+        auth_srv->cache = NULL;
+    }
+
+    return PJ_SUCCESS;
+}
+
+
+/* Build HA1 cache key into buf, return the key length or zero if the
+ * account name is too long to be cached.
+ */
+static unsigned ha1_key(char buf[], const pj_str_t *acc_name,
+                        pjsip_auth_algorithm_type algorithm_type)
+{
+    if (acc_name->slen > MAX_ACC_NAME)
+        return 0;
+
+    buf[0] = (char)algorithm_type;
+    pj_memcpy(buf + 1, acc_name->ptr, acc_name->slen);
+    return (unsigned)acc_name->slen + 1;
+}
+
+
+/* Move HA1 cache entry to the free list. Cache must be locked. */
+static void ha1_entry_remove(pjsip_auth_srv_cache *cache, ha1_entry *e)
+{
+    pj_hash_set_np(cache->ha1_table, e->key, e->key_len, 0, e->hbuf, NULL);
+    pj_list_erase(e);
+    pj_list_push_back(&cache->ha1_free, e);
+    --cache->ha1_cnt;
+}
+
+
+/* Get the cached HA1 of the account. */
+static pj_bool_t ha1_cache_get(pjsip_auth_srv_cache *cache,
+                               const pj_str_t *acc_name,
+                               pjsip_auth_algorithm_type algorithm_type,
+                               long now,
+                               pj_str_t *ha1)
+{
+    char key[MAX_ACC_NAME + 1];
+    unsigned key_len;
+    ha1_entry *e;
+    pj_bool_t found = PJ_FALSE;
+
+    key_len = ha1_key(key, acc_name, algorithm_type);
+    if (!key_len)
+        return PJ_FALSE;
+
+    pj_lock_acquire(cache->lock);
+    e = (ha1_entry*) pj_hash_get(cache->ha1_table, key, key_len, NULL);
+    if (e) {
+        if (now - e->expire >= 0) {
+            ha1_entry_remove(cache, e);
+        } else {
+            pj_memcpy(ha1->ptr, e->ha1, e->ha1_len);
+            ha1->slen = e->ha1_len;
+            pj_list_erase(e);
+            pj_list_push_front(&cache->ha1_list, e);
+            found = PJ_TRUE;
+        }
+    }
+    pj_lock_release(cache->lock);
+
+    return found;
+}
+
+
+/* Add or update the cached HA1 of the account. */
+static void ha1_cache_put(pjsip_auth_srv_cache *cache,
+                          const pj_str_t *acc_name,
+                          pjsip_auth_algorithm_type algorithm_type,
+                          long now,
+                          const pj_str_t *ha1)
+{
+    char key[MAX_ACC_NAME + 1];
+    unsigned key_len;
+    ha1_entry *e;
+
+    key_len = ha1_key(key, acc_name, algorithm_type);
+    if (!key_len || ha1->slen > (pj_ssize_t)sizeof(e->ha1))
+        return;
+
+    pj_lock_acquire(cache->lock);
+
+    e = (ha1_entry*) pj_hash_get(cache->ha1_table, key, key_len, NULL);
+    if (!e) {
+        if (cache->ha1_cnt >= cache->param.max_ha1) {
+            /* Evict the least recently used */
+            ha1_entry_remove(cache, cache->ha1_list.prev);
+        }
+
+        if (!pj_list_empty(&cache->ha1_free)) {
+            e = cache->ha1_free.next;
+            pj_list_erase(e);
+        } else {
+            e = PJ_POOL_ZALLOC_T(cache->pool, ha1_entry);
+        }
+
+        if (e->key_cap < key_len) {
+            e->key = (char*)pj_pool_alloc(cache->pool, key_len);
+            e->key_cap = key_len;
+        }
+        pj_memcpy(e->key, key, key_len);
+        e->key_len = key_len;
+
+        pj_hash_set_np(cache->ha1_table, e->key, e->key_len, 0, e->hbuf, e);
+        ++cache->ha1_cnt;
+    } else {
+        pj_list_erase(e);
+    }
+
+    pj_memcpy(e->ha1, ha1->ptr, ha1->slen);
+    e->ha1_len = (unsigned)ha1->slen;
+    e->expire = now + (long)cache->param.ha1_ttl;
+    pj_list_push_front(&cache->ha1_list, e);
+
+    pj_lock_release(cache->lock);
+}
+
+
+/*
+ * Remove cached HA1 of the account.
+ */
+PJ_DEF(pj_status_t) pjsip_auth_srv_invalidate_cred(pjsip_auth_srv *auth_srv,
+                                                   const pj_str_t *acc_name)
+{
+    pjsip_auth_srv_cache *cache;
+    ha1_entry *e;
+
+    PJ_ASSERT_RETURN(auth_srv, PJ_EINVAL);
+
+    cache = auth_srv->cache;
+    if (!cache || !cache->param.ha1_ttl)
+        return PJ_SUCCESS;
+
+    pj_lock_acquire(cache->lock);
+    e = cache->ha1_list.next;
+    while (e != &cache->ha1_list) {
+        ha1_entry *next = e->next;
+
+        if (!acc_name ||
+            (e->key_len == (unsigned)acc_name->slen + 1 &&
+             pj_memcmp(e->key + 1, acc_name->ptr, acc_name->slen) == 0))
+        {
+            ha1_entry_remove(cache, e);
+        }
+        e = next;
+    }
+    pj_lock_release(cache->lock);
+
+    return PJ_SUCCESS;
+}
+
+
+/* Calculate the signature of the nonce into sig (NONCE_SIG_LEN chars). */
+static void nonce_sign(const pjsip_auth_srv_cache *cache,
+                       const pj_str_t *realm,
+                       const char *nonce,
+                       char sig[])
+{
+    pj_hmac_sha1_context hctx;
+    pj_uint8_t digest[PJ_SHA1_DIGEST_SIZE];
+    unsigned i;
+
+    pj_hmac_sha1_init(&hctx, (const pj_uint8_t*)cache->param.secret.ptr,
+                      (unsigned)cache->param.secret.slen);
+    pj_hmac_sha1_update(&hctx, (const pj_uint8_t*)nonce,
+                        NONCE_TS_LEN + NONCE_RAND_LEN);
+    pj_hmac_sha1_update(&hctx, (const pj_uint8_t*)realm->ptr,
+                        (unsigned)realm->slen);
+    pj_hmac_sha1_final(&hctx, digest);
+
+    for (i = 0; i < NONCE_SIG_LEN / 2; ++i)
+        pj_val_to_hex_digit(digest[i], sig + i * 2);
+}
+
+
+/* Create signed nonce into buf (NONCE_LEN chars). */
+static void nonce_create(const pjsip_auth_srv_cache *cache,
+                         const pj_str_t *realm,
+                         long now,
+                         char buf[])
+{
+    pj_uint32_t val;
+    unsigned i;
+
+    val = (pj_uint32_t)now;
+    for (i = 0; i < 4; ++i)
+        pj_val_to_hex_digit((val >> (24 - i * 8)) & 0xFF, buf + i * 2);
+
+    /* The signature is what makes the nonce unforgeable, the random part
+     * only keeps nonces created in the same second distinct.
+     */
+    if (secure_random(&val, sizeof(val)) != PJ_SUCCESS)
+        val = ((pj_uint32_t)pj_rand() << 16) ^ (pj_uint32_t)pj_rand();
+    for (i = 0; i < 4; ++i)
+        pj_val_to_hex_digit((val >> (24 - i * 8)) & 0xFF,
+                            buf + NONCE_TS_LEN + i * 2);
+
+    nonce_sign(cache, realm, buf, buf + NONCE_TS_LEN + NONCE_RAND_LEN);
+}
+
+
+/* Check that the nonce was issued by us, and whether it has expired. */
+static pj_status_t nonce_check(const pjsip_auth_srv_cache *cache,
+                               const pj_str_t *realm,
+                               const pj_str_t *nonce,
+                               long now,
+                               long *expire)
+{
+    char sig[NONCE_SIG_LEN];
+    pj_uint32_t ts = 0;
+    unsigned i, diff = 0;
+
+    if (nonce->slen != NONCE_LEN)
+        return PJSIP_EAUTHINNONCE;
+
+    for (i = 0; i < NONCE_TS_LEN; ++i) {
+        if (!pj_isxdigit(nonce->ptr[i]))
+            return PJSIP_EAUTHINNONCE;
+        ts = (ts << 4) | pj_hex_digit_to_val((unsigned char)nonce->ptr[i]);
+    }
+
+    /* Constant time comparison of the signature */
+    nonce_sign(cache, realm, nonce->ptr, sig);
+    for (i = 0; i < NONCE_SIG_LEN; ++i)
+        diff |= sig[i] ^ nonce->ptr[NONCE_TS_LEN + NONCE_RAND_LEN + i];
+    if (diff)
+        return PJSIP_EAUTHINNONCE;
+
+    /* Compare as signed offset to survive wrap around of the timestamp */
+    *expire = now + (pj_int32_t)(ts + cache->param.nonce_ttl -
+                                 (pj_uint32_t)now);
+    return (now - *expire >= 0) ? PJSIP_EAUTHSTALENONCE : PJ_SUCCESS;
+}
+
+
+/* Move nonce count entry to the free list. Cache must be locked. */
+static void nc_entry_remove(pjsip_auth_srv_cache *cache, nc_entry *e)
+{
+    pj_hash_set_np(cache->nc_table, e->nonce, NONCE_LEN, 0, e->hbuf, NULL);
+    pj_list_erase(e);
+    pj_list_push_back(&cache->nc_free, e);
+    --cache->nc_cnt;
+}
+
+
+/* Check that the nonce count has not been used with the nonce before. */
+static pj_status_t nc_check(pjsip_auth_srv_cache *cache,
+                            const pj_str_t *nonce,
+                            const pj_str_t *nc_str,
+                            long now,
+                            long expire)
+{
+    pj_uint32_t nc;
+    nc_entry *e;
+    pj_status_t status = PJ_SUCCESS;
+
+    nc = (pj_uint32_t)pj_strtoul2(nc_str, NULL, 16);
+    if (nc == 0)
+        return PJSIP_EAUTHNCREPLAY;
+
+    pj_lock_acquire(cache->lock);
+
+    e = (nc_entry*) pj_hash_get(cache->nc_table, nonce->ptr, NONCE_LEN, NULL);
+    if (e && now - e->expire >= 0) {
+        nc_entry_remove(cache, e);
+        e = NULL;
+    }
+
+    if (e) {
+        if (nc <= e->nc) {
+            status = PJSIP_EAUTHNCREPLAY;
+        } else {
+            e->nc = nc;
+            pj_list_erase(e);
+            pj_list_push_front(&cache->nc_list, e);
+        }
+    } else if (nc != 1) {
+        /* The nonce has been evicted, the client must get a new one since
+         * we can no longer tell whether the nonce count has been used.
+         */
+        status = PJSIP_EAUTHSTALENONCE;
+    } else {
+        if (cache->nc_cnt >= cache->param.max_nonce) {
+            /* Evict the least recently used */
+            nc_entry_remove(cache, cache->nc_list.prev);
+        }
+
+        if (!pj_list_empty(&cache->nc_free)) {
+            e = cache->nc_free.next;
+            pj_list_erase(e);
+        } else {
+            e = PJ_POOL_ZALLOC_T(cache->pool, nc_entry);
+        }
+
+        pj_memcpy(e->nonce, nonce->ptr, NONCE_LEN);
+        e->nc = nc;
+        e->expire = expire;
+        pj_hash_set_np(cache->nc_table, e->nonce, NONCE_LEN, 0, e->hbuf, e);
+        pj_list_push_front(&cache->nc_list, e);
+        ++cache->nc_cnt;
+    }
+
+    pj_lock_release(cache->lock);
+
+    return status;
+}
+
+
 /* Verify incoming Authorization/Proxy-Authorization header against the 
  * specified credential.
  */
@@ -161,24 +656,99 @@ static pj_status_t pjsip_auth_verify( const pjsip_authorization_hdr *hdr,
 }
 
 
-/*
- * Request the authorization server framework to verify the authorization 
- * information in the specified request in rdata.
+/* Find the credential information for the account, from the HA1 cache
+ * if it is enabled.
  */
-PJ_DEF(pj_status_t) pjsip_auth_srv_verify( pjsip_auth_srv *auth_srv,
-                                           pjsip_rx_data *rdata,
-                                           int *status_code)
+static pj_status_t get_cred(pjsip_auth_srv *auth_srv,
+                            pjsip_rx_data *rdata,
+                            pjsip_authorization_hdr *h_auth,
+                            pjsip_auth_algorithm_type algorithm_type,
+                            long now,
+                            pj_str_t *ha1,
+                            pjsip_cred_info *cred_info,
+                            pj_bool_t *from_cache)
+{
+    pjsip_auth_srv_cache *cache = auth_srv->cache;
+    const pj_str_t *acc_name = &h_auth->credential.digest.username;
+    pj_status_t status;
+
+    pj_bzero(cred_info, sizeof(*cred_info));
+    *from_cache = PJ_FALSE;
+
+    if (cache && cache->param.ha1_ttl &&
+        ha1_cache_get(cache, acc_name, algorithm_type, now, ha1))
+    {
+        cred_info->realm = h_auth->credential.digest.realm;
+        cred_info->username = *acc_name;
+        cred_info->data_type = PJSIP_CRED_DATA_DIGEST;
+        cred_info->data = *ha1;
+        cred_info->algorithm_type = algorithm_type;
+        *from_cache = PJ_TRUE;
+        return PJ_SUCCESS;
+    }
+
+    if (auth_srv->lookup2) {
+        pjsip_auth_lookup_cred_param param;
+
+        pj_bzero(&param, sizeof(param));
+        param.realm = auth_srv->realm;
+        param.acc_name = *acc_name;
+        param.rdata = rdata;
+        param.auth_hdr = h_auth;
+        status = (*auth_srv->lookup2)(rdata->tp_info.pool, &param, cred_info);
+    } else {
+        status = (*auth_srv->lookup)(rdata->tp_info.pool, &auth_srv->realm,
+                                     acc_name, cred_info);
+    }
+    if (status != PJ_SUCCESS)
+        return status;
+
+    /*
+     * If the data type is DIGEST and an auth algorithm isn't set,
+     * default it to MD5.
+     */
+    if (PJSIP_CRED_DATA_IS_DIGEST(cred_info) &&
+        cred_info->algorithm_type == PJSIP_AUTH_ALGORITHM_NOT_SET) {
+        cred_info->algorithm_type = PJSIP_AUTH_ALGORITHM_MD5;
+    }
+
+    /* Keep the HA1 of the credential, and use it for this request too. */
+    if (cache && cache->param.ha1_ttl &&
+        pj_strcmp(&cred_info->username, acc_name) == 0 &&
+        pj_strcmp(&cred_info->realm, &h_auth->credential.digest.realm) == 0 &&
+        pjsip_auth_create_ha1(ha1, &cred_info->realm, cred_info,
+                              algorithm_type) == PJ_SUCCESS)
+    {
+        ha1_cache_put(cache, acc_name, algorithm_type, now, ha1);
+        cred_info->data_type = PJSIP_CRED_DATA_DIGEST;
+        cred_info->data = *ha1;
+        cred_info->algorithm_type = algorithm_type;
+    }
+
+    return PJ_SUCCESS;
+}
+
+
+/* Verify the request, now is the current time of the cache. */
+static pj_status_t verify_request( pjsip_auth_srv *auth_srv,
+                                   pjsip_rx_data *rdata,
+                                   long now,
+                                   int *status_code)
 {
     pjsip_authorization_hdr *h_auth;
     pjsip_msg *msg = rdata->msg_info.msg;
     pjsip_hdr_e htype;
-    pj_str_t acc_name;
     pjsip_cred_info cred_info;
     pj_status_t status;
     const pjsip_auth_algorithm *algorithm;
+    pjsip_auth_srv_cache *cache = auth_srv->cache;
+    pj_status_t nonce_status = PJ_SUCCESS;
+    long nonce_expire = 0;
+    char ha1_buf[PJSIP_AUTH_MAX_DIGEST_BUFFER_LENGTH * 2];
+    pj_str_t ha1;
+    pj_bool_t from_cache;
 
 
-    PJ_ASSERT_RETURN(auth_srv && rdata, PJ_EINVAL);
     PJ_ASSERT_RETURN(msg->type == PJSIP_REQUEST_MSG, PJSIP_ENOTREQUESTMSG);
 
     htype = auth_srv->is_proxy ? PJSIP_H_PROXY_AUTHORIZATION : 
@@ -208,9 +778,7 @@ PJ_DEF(pj_status_t) pjsip_auth_srv_verify( pjsip_auth_srv *auth_srv,
     }
 
     /* Check authorization scheme. */
-    if (pj_stricmp(&h_auth->scheme, &pjsip_DIGEST_STR) == 0)
-        acc_name = h_auth->credential.digest.username;
-    else {
+    if (pj_stricmp(&h_auth->scheme, &pjsip_DIGEST_STR) != 0) {
         *status_code = auth_srv->is_proxy ? 407 : 401;
         return PJSIP_EINVALIDAUTHSCHEME;
     }
@@ -223,47 +791,92 @@ PJ_DEF(pj_status_t) pjsip_auth_srv_verify( pjsip_auth_srv *auth_srv,
         return PJSIP_EINVALIDALGORITHM;
     }
 
-    /* Find the credential information for the account. */
-    pj_bzero(&cred_info, sizeof(cred_info));
-
-    if (auth_srv->lookup2) {
-        pjsip_auth_lookup_cred_param param;
-
-        pj_bzero(&param, sizeof(param));
-        param.realm = auth_srv->realm;
-        param.acc_name = acc_name;
-        param.rdata = rdata;
-        param.auth_hdr = h_auth;
-        status = (*auth_srv->lookup2)(rdata->tp_info.pool, &param, &cred_info);
-        if (status != PJ_SUCCESS) {
-            *status_code = PJSIP_SC_FORBIDDEN;
-            return status;
-        }
-    } else {
-        status = (*auth_srv->lookup)(rdata->tp_info.pool, &auth_srv->realm,
-                                     &acc_name, &cred_info);
-        if (status != PJ_SUCCESS) {
-            *status_code = PJSIP_SC_FORBIDDEN;
-            return status;
+    /* Reject nonce that was not issued by us before doing any hashing.
+     * Expired nonce is only reported after the digest is verified, so
+     * stale=true is given to clients with the correct credential only.
+     */
+    if (cache && cache->param.nonce_ttl) {
+        nonce_status = nonce_check(cache, &auth_srv->realm,
+                                   &h_auth->credential.digest.nonce,
+                                   now, &nonce_expire);
+        if (nonce_status == PJSIP_EAUTHINNONCE) {
+            *status_code = auth_srv->is_proxy ? 407 : 401;
+            return nonce_status;
         }
     }
 
-    /*
-     * If the data type is DIGEST and an auth algorithm isn't set,
-     * default it to MD5.
-     */
-    if (PJSIP_CRED_DATA_IS_DIGEST(&cred_info) &&
-        cred_info.algorithm_type == PJSIP_AUTH_ALGORITHM_NOT_SET) {
-        cred_info.algorithm_type = PJSIP_AUTH_ALGORITHM_MD5;
+    /* Find the credential information for the account. */
+    ha1.ptr = ha1_buf;
+    ha1.slen = sizeof(ha1_buf);
+    status = get_cred(auth_srv, rdata, h_auth, algorithm->algorithm_type,
+                      now, &ha1, &cred_info, &from_cache);
+    if (status != PJ_SUCCESS) {
+        *status_code = PJSIP_SC_FORBIDDEN;
+        return status;
     }
 
     /* Authenticate with the specified credential. */
     status = pjsip_auth_verify(h_auth, &msg->line.req.method.name, 
                                &cred_info);
+    if (status != PJ_SUCCESS && from_cache) {
+        /* The credential may have changed since it was cached */
+        pjsip_auth_srv_invalidate_cred(auth_srv,
+                                       &h_auth->credential.digest.username);
+
+        ha1.slen = sizeof(ha1_buf);
+        status = get_cred(auth_srv, rdata, h_auth, algorithm->algorithm_type,
+                          now, &ha1, &cred_info, &from_cache);
+        if (status == PJ_SUCCESS) {
+            status = pjsip_auth_verify(h_auth, &msg->line.req.method.name,
+                                       &cred_info);
+        }
+    }
     if (status != PJ_SUCCESS) {
         *status_code = PJSIP_SC_FORBIDDEN;
+        return status;
     }
-    return status;
+
+    /* Check the nonce lifetime and nonce count replay */
+    if (nonce_status == PJ_SUCCESS && cache && cache->param.max_nonce &&
+        h_auth->credential.digest.qop.slen)
+    {
+        nonce_status = nc_check(cache, &h_auth->credential.digest.nonce,
+                                &h_auth->credential.digest.nc,
+                                now, nonce_expire);
+    }
+    if (nonce_status != PJ_SUCCESS) {
+        *status_code = auth_srv->is_proxy ? 407 : 401;
+        return nonce_status;
+    }
+
+    return PJ_SUCCESS;
+}
+
+
+/* Get the current time for the authorization cache. */
+static long cache_now(const pjsip_auth_srv *auth_srv)
+{
+    pj_time_val now;
+
+    if (!auth_srv->cache)
+        return 0;
+
+    pj_gettimeofday(&now);
+    return now.sec;
+}
+
+
+/*
+ * Request the authorization server framework to verify the authorization 
+ * information in the specified request in rdata.
+ */
+PJ_DEF(pj_status_t) pjsip_auth_srv_verify( pjsip_auth_srv *auth_srv,
+                                           pjsip_rx_data *rdata,
+                                           int *status_code)
+{
+    PJ_ASSERT_RETURN(auth_srv && rdata, PJ_EINVAL);
+
+    return verify_request(auth_srv, rdata, cache_now(auth_srv), status_code);
 }
 
 
@@ -284,6 +897,7 @@ PJ_DEF(pj_status_t) pjsip_auth_srv_challenge2(  pjsip_auth_srv *auth_srv,
     pjsip_www_authenticate_hdr *hdr;
     char nonce_buf[16];
     pj_str_t random;
+    pjsip_auth_srv_cache *cache = auth_srv ? auth_srv->cache : NULL;
     const pjsip_auth_algorithm *algorithm =
             pjsip_auth_get_algorithm_by_type(algorithm_type);
 
@@ -310,6 +924,13 @@ PJ_DEF(pj_status_t) pjsip_auth_srv_challenge2(  pjsip_auth_srv *auth_srv,
     pj_strdup(tdata->pool, &hdr->challenge.digest.algorithm, &algorithm->iana_name);
     if (nonce) {
         pj_strdup(tdata->pool, &hdr->challenge.digest.nonce, nonce);
+    } else if (cache && cache->param.nonce_ttl) {
+        pj_str_t *hnonce = &hdr->challenge.digest.nonce;
+
+        hnonce->ptr = (char*)pj_pool_alloc(tdata->pool, NONCE_LEN);
+        hnonce->slen = NONCE_LEN;
+        nonce_create(cache, &auth_srv->realm, cache_now(auth_srv),
+                     hnonce->ptr);
     } else {
         pj_create_random_string(nonce_buf, sizeof(nonce_buf));
         pj_strdup(tdata->pool, &hdr->challenge.digest.nonce, &random);
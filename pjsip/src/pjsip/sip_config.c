@@ -39,7 +39,9 @@ pjsip_cfg_t pjsip_sip_cfg_var =
        0,
        PJSIP_ENCODE_SHORT_HNAME,
        PJSIP_ACCEPT_MULTIPLE_SDP_ANSWERS,
-       0
+       0,
+       PJSIP_LAZY_HDR_PARSING,
+       PJSIP_ENCODE_RSP_HDR
     },
 
     /* Transaction settings */
@@ -48,7 +50,8 @@ pjsip_cfg_t pjsip_sip_cfg_var =
        PJSIP_T1_TIMEOUT,
        PJSIP_T2_TIMEOUT,
        PJSIP_T4_TIMEOUT,
-       PJSIP_TD_TIMEOUT
+       PJSIP_TD_TIMEOUT,
+       PJSIP_TSX_LAYER_LOCK_STRIPE_CNT
     },
 
     /* Client registration client */
@@ -76,6 +79,8 @@ PJ_DEF(void) pjsip_dump_config(void)
                PJSIP_MAX_TRANSPORTS));
     PJ_LOG(3, (id, " PJSIP_TPMGR_HTABLE_SIZE                            : %d", 
                PJSIP_TPMGR_HTABLE_SIZE));
+    PJ_LOG(3, (id, " PJSIP_TPMGR_LOCK_STRIPE_CNT                        : %d", 
+               PJSIP_TPMGR_LOCK_STRIPE_CNT));
     PJ_LOG(3, (id, " PJSIP_MAX_URL_SIZE                                 : %d", 
                PJSIP_MAX_URL_SIZE));
     PJ_LOG(3, (id, " PJSIP_MAX_MODULE                                   : %d", 
@@ -238,6 +243,10 @@ PJ_DEF(void) pjsip_dump_config(void)
                pjsip_cfg()->endpt.accept_multiple_sdp_answers));
     PJ_LOG(3, (id, " pjsip_cfg()->endpt.keep_inv_after_tsx_timeout      : %d", 
                pjsip_cfg()->endpt.keep_inv_after_tsx_timeout));
+    PJ_LOG(3, (id, " pjsip_cfg()->endpt.lazy_hdr_parsing                : %d", 
+               pjsip_cfg()->endpt.lazy_hdr_parsing));
+    PJ_LOG(3, (id, " pjsip_cfg()->endpt.encode_rsp_hdr                  : %d", 
+               pjsip_cfg()->endpt.encode_rsp_hdr));
     PJ_LOG(3, (id, " pjsip_cfg()->tsx.max_count                         : %d", 
                pjsip_cfg()->tsx.max_count));
     PJ_LOG(3, (id, " pjsip_cfg()->tsx.t1                                : %d", 
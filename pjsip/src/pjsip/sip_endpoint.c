@@ -34,6 +34,7 @@
 #include <pj/errno.h>
 #include <pj/lock.h>
 #include <pj/math.h>
+#include <pj/rand.h>
 
 #define PJSIP_EX_NO_MEMORY  pj_NO_MEMORY_EXCEPTION()
 #define THIS_FILE           "sip_endpoint.c"
@@ -49,6 +50,34 @@ typedef struct exit_cb
 } exit_cb;
 
 
+/* Message queued to receive worker. */
+typedef struct rx_queue_item
+{
+    PJ_DECL_LIST_MEMBER             (struct rx_queue_item);
+    pjsip_rx_data                  *rdata;
+    pj_timestamp                    ts;
+} rx_queue_item;
+
+
+/* Receive worker, see pjsip_endpt_start_rx_workers(). */
+typedef struct rx_worker
+{
+    pjsip_endpoint     *endpt;
+    pj_thread_t        *thread;
+    pj_sem_t           *sem;
+    pj_mutex_t         *mutex;
+    rx_queue_item       queue;
+    pj_bool_t           quit;
+
+    /* Statistics, protected by mutex. */
+    unsigned            queue_len;
+    unsigned            max_queue_len;
+    pj_uint32_t         msg_cnt;
+    pj_uint64_t         total_delay_usec;
+    pj_uint32_t         max_delay_usec;
+} rx_worker;
+
+
 /**
  * The SIP endpoint.
  */
@@ -98,6 +127,40 @@ struct pjsip_endpoint
 
     /** List of exit callback. */
     exit_cb              exit_cb_list;
+
+    /** Transmit buffers kept for stateless raw responses. */
+    pjsip_tx_data       *raw_rsp_tdata[PJSIP_MAX_RAW_RSP_TDATA];
+
+    /** Number of transmit buffers in raw_rsp_tdata. */
+    unsigned             raw_rsp_tdata_cnt;
+
+    /** Set when the endpoint is being destroyed. Transmit buffers released
+     *  after this are destroyed instead of kept in raw_rsp_tdata. */
+    pj_bool_t            raw_rsp_tdata_closed;
+
+    /** Pool for the receive workers. */
+    pj_pool_t           *rx_worker_pool;
+
+    /** Receive workers. */
+    rx_worker           *rx_workers;
+
+    /** Number of receive workers, zero if not running. */
+    unsigned             rx_worker_cnt;
+
+    /** Whether overload control is enabled. */
+    pj_bool_t            oc_enabled;
+
+    /** Overload control setting. */
+    pjsip_overload_param oc_param;
+
+    /** Reduction percentage set by pjsip_endpt_set_overloaded(). */
+    unsigned             oc_forced_reduction;
+
+    /** Last computed reduction percentage. */
+    pj_atomic_t         *oc_reduction;
+
+    /** Number of requests rejected because of overload. */
+    pj_atomic_t         *oc_shed_cnt;
 };
 
 
@@ -116,6 +179,7 @@ struct pjsip_endpoint
  */
 static void endpt_on_rx_msg( pjsip_endpoint*, 
                              pj_status_t, pjsip_rx_data*);
+static void endpt_process_rx_msg( pjsip_endpoint*, pjsip_rx_data*);
 static pj_status_t endpt_on_tx_msg( pjsip_endpoint *endpt,
                                     pjsip_tx_data *tdata );
 static pj_status_t unload_module(pjsip_endpoint *endpt,
@@ -434,6 +498,7 @@ PJ_DEF(pj_status_t) pjsip_endpt_create(pj_pool_factory *pf,
     pjsip_endpoint *endpt;
     pjsip_max_fwd_hdr *mf_hdr;
     pj_lock_t *lock = NULL;
+    pj_timer_heap_cfg timer_cfg;
 
 
     status = pj_register_strerror(PJSIP_ERRNO_START, PJ_ERRNO_SPACE_SIZE,
@@ -488,18 +553,25 @@ PJ_DEF(pj_status_t) pjsip_endpt_create(pj_pool_factory *pf,
     }
 
     /* Create timer heap to manage all timers within this endpoint. */
-    status = pj_timer_heap_create( endpt->pool, PJSIP_MAX_TIMER_COUNT, 
-                                   &endpt->timer_heap);
+    pj_timer_heap_cfg_default(&timer_cfg);
+    timer_cfg.shard_cnt = PJSIP_TIMER_HEAP_SHARD_CNT;
+    status = pj_timer_heap_create2( endpt->pool, PJSIP_MAX_TIMER_COUNT, 
+                                    &timer_cfg, &endpt->timer_heap);
     if (status != PJ_SUCCESS) {
         goto on_error;
     }
 
-    /* Set recursive lock for the timer heap. */
-    status = pj_lock_create_recursive_mutex( endpt->pool, "edpt%p", &lock);
-    if (status != PJ_SUCCESS) {
-        goto on_error;
+    /* Set recursive lock for the timer heap. Shards of a sharded timer
+     * heap have their own locks.
+     */
+    if (timer_cfg.shard_cnt <= 1) {
+        status = pj_lock_create_recursive_mutex( endpt->pool, "edpt%p",
+                                                 &lock);
+        if (status != PJ_SUCCESS) {
+            goto on_error;
+        }
+        pj_timer_heap_set_lock(endpt->timer_heap, lock, PJ_TRUE);
     }
-    pj_timer_heap_set_lock(endpt->timer_heap, lock, PJ_TRUE);
 
     /* Set maximum timed out entries to process in a single poll. */
     pj_timer_heap_set_max_timed_out_per_poll(endpt->timer_heap, 
@@ -582,6 +654,9 @@ PJ_DEF(void) pjsip_endpt_destroy(pjsip_endpoint *endpt)
 
     PJ_LOG(5, (THIS_FILE, "Destroying endpoint instance.."));
 
+    /* Process the messages that are still queued to receive workers. */
+    pjsip_endpt_stop_rx_workers(endpt);
+
     /* Phase 1: stop all modules */
     mod = endpt->module_list.prev;
     while (mod != &endpt->module_list) {
@@ -603,9 +678,30 @@ PJ_DEF(void) pjsip_endpt_destroy(pjsip_endpoint *endpt)
     /* Destroy resolver */
     pjsip_resolver_destroy(endpt->resolver);
 
+    /* Stop keeping transmit buffers for stateless raw responses. Responses
+     * still pending in a transport complete while the transport manager
+     * below is destroying the transports, and their buffers must be
+     * destroyed then, while the transport manager is still alive.
+     */
+    pj_mutex_lock(endpt->mutex);
+    endpt->raw_rsp_tdata_closed = PJ_TRUE;
+    pj_mutex_unlock(endpt->mutex);
+    while (endpt->raw_rsp_tdata_cnt) {
+        pjsip_tx_data_dec_ref(endpt->raw_rsp_tdata[--endpt->raw_rsp_tdata_cnt]);
+    }
+
     /* Shutdown and destroy all transports. */
     pjsip_tpmgr_destroy(endpt->transport_mgr);
 
+    /* Destroy overload control counters, after the transports so that no
+     * more messages are received.
+     */
+    endpt->oc_enabled = PJ_FALSE;
+    if (endpt->oc_reduction)
+        pj_atomic_destroy(endpt->oc_reduction);
+    if (endpt->oc_shed_cnt)
+        pj_atomic_destroy(endpt->oc_shed_cnt);
+
     /* Destroy ioqueue */
     pj_ioqueue_destroy(endpt->ioqueue);
 
@@ -959,20 +1055,487 @@ on_return:
     return status;
 }
 
+/*
+ * Receive worker thread.
+ */
+static int rx_worker_thread(void *arg)
+{
+    rx_worker *w = (rx_worker*) arg;
+
+    for (;;) {
+        rx_queue_item *item;
+        pjsip_rx_data *rdata;
+        pj_timestamp now;
+        pj_uint32_t delay;
+
+        pj_sem_wait(w->sem);
+
+        pj_mutex_lock(w->mutex);
+        if (pj_list_empty(&w->queue)) {
+            pj_bool_t quit = w->quit;
+            pj_mutex_unlock(w->mutex);
+            if (quit)
+                break;
+            continue;
+        }
+
+        item = w->queue.next;
+        pj_list_erase(item);
+        --w->queue_len;
+
+        pj_get_timestamp(&now);
+        delay = pj_elapsed_usec(&item->ts, &now);
+        ++w->msg_cnt;
+        w->total_delay_usec += delay;
+        if (delay > w->max_delay_usec)
+            w->max_delay_usec = delay;
+        pj_mutex_unlock(w->mutex);
+
+        /* The item is allocated from the rdata's pool. */
+        rdata = item->rdata;
+        endpt_process_rx_msg(w->endpt, rdata);
+        pjsip_rx_data_free_cloned(rdata);
+    }
+
+    return 0;
+}
+
+/*
+ * Get the receive worker that handles the Call-ID of the message.
+ */
+static rx_worker *get_rx_worker( pjsip_endpoint *endpt,
+                                 const pjsip_rx_data *rdata )
+{
+    const pj_str_t *call_id = &rdata->msg_info.cid->id;
+
+    return &endpt->rx_workers[pj_hash_calc(0, call_id->ptr,
+                                           (unsigned)call_id->slen) %
+                              endpt->rx_worker_cnt];
+}
+
+/*
+ * Queue incoming message to the receive worker chosen by its Call-ID.
+ */
+static pj_status_t dispatch_rx_msg( pjsip_endpoint *endpt,
+                                    pjsip_rx_data *rdata )
+{
+    pjsip_rx_data *clone;
+    rx_queue_item *item;
+    rx_worker *w;
+    pj_status_t status;
+
+    status = pjsip_rx_data_clone(rdata, 0, &clone);
+    if (status != PJ_SUCCESS)
+        return status;
+
+    item = PJ_POOL_ALLOC_T(clone->tp_info.pool, rx_queue_item);
+    item->rdata = clone;
+    pj_get_timestamp(&item->ts);
+
+    w = get_rx_worker(endpt, rdata);
+
+    pj_mutex_lock(w->mutex);
+    pj_list_push_back(&w->queue, item);
+    if (++w->queue_len > w->max_queue_len)
+        w->max_queue_len = w->queue_len;
+    pj_mutex_unlock(w->mutex);
+
+    pj_sem_post(w->sem);
+    return PJ_SUCCESS;
+}
+
+/*
+ * Start receive workers.
+ */
+PJ_DEF(pj_status_t) pjsip_endpt_start_rx_workers(pjsip_endpoint *endpt,
+                                                 unsigned worker_cnt)
+{
+    rx_worker *workers;
+    unsigned i;
+    pj_status_t status;
+
+    PJ_ASSERT_RETURN(endpt && worker_cnt, PJ_EINVAL);
+    PJ_ASSERT_RETURN(endpt->rx_worker_cnt == 0, PJ_EINVALIDOP);
+
+    endpt->rx_worker_pool = pjsip_endpt_create_pool(endpt, "rxworker%p",
+                                                    512, 512);
+    if (!endpt->rx_worker_pool)
+        return PJ_ENOMEM;
+
+    workers = (rx_worker*) pj_pool_calloc(endpt->rx_worker_pool, worker_cnt,
+                                          sizeof(rx_worker));
+    for (i=0; i<worker_cnt; ++i) {
+        rx_worker *w = &workers[i];
+        char name[PJ_MAX_OBJ_NAME];
+
+        w->endpt = endpt;
+        pj_list_init(&w->queue);
+
+        pj_ansi_snprintf(name, sizeof(name), "rxworker%d", i);
+        status = pj_mutex_create_simple(endpt->rx_worker_pool, name,
+                                        &w->mutex);
+        if (status != PJ_SUCCESS)
+            goto on_error;
+
+        status = pj_sem_create(endpt->rx_worker_pool, name, 0, INT_MAX,
+                               &w->sem);
+        if (status != PJ_SUCCESS)
+            goto on_error;
+
+        status = pj_thread_create(endpt->rx_worker_pool, name,
+                                  &rx_worker_thread, w, 0, 0, &w->thread);
+        if (status != PJ_SUCCESS)
+            goto on_error;
+    }
+
+    endpt->rx_workers = workers;
+    endpt->rx_worker_cnt = worker_cnt;
+
+    PJ_LOG(4,(THIS_FILE, "Started %d receive workers", worker_cnt));
+    return PJ_SUCCESS;
+
+on_error:
+    endpt->rx_workers = workers;
+    endpt->rx_worker_cnt = worker_cnt;
+    pjsip_endpt_stop_rx_workers(endpt);
+    return status;
+}
+
+/*
+ * Stop receive workers.
+ */
+PJ_DEF(pj_status_t) pjsip_endpt_stop_rx_workers(pjsip_endpoint *endpt)
+{
+    rx_worker *workers = endpt->rx_workers;
+    unsigned i, worker_cnt = endpt->rx_worker_cnt;
+
+    PJ_ASSERT_RETURN(endpt, PJ_EINVAL);
+
+    if (worker_cnt == 0)
+        return PJ_SUCCESS;
+
+    /* Stop queueing new messages. */
+    endpt->rx_worker_cnt = 0;
+
+    for (i=0; i<worker_cnt; ++i) {
+        rx_worker *w = &workers[i];
+
+        if (w->thread) {
+            pj_mutex_lock(w->mutex);
+            w->quit = PJ_TRUE;
+            pj_mutex_unlock(w->mutex);
+
+            pj_sem_post(w->sem);
+            pj_thread_join(w->thread);
+            pj_thread_destroy(w->thread);
+        }
+        if (w->sem)
+            pj_sem_destroy(w->sem);
+        if (w->mutex)
+            pj_mutex_destroy(w->mutex);
+    }
+
+    endpt->rx_workers = NULL;
+    pjsip_endpt_release_pool(endpt, endpt->rx_worker_pool);
+    endpt->rx_worker_pool = NULL;
+
+    PJ_LOG(4,(THIS_FILE, "Receive workers stopped"));
+    return PJ_SUCCESS;
+}
+
+static void get_rx_worker_stat(rx_worker *w, pjsip_rx_worker_stat *stat)
+{
+    pj_mutex_lock(w->mutex);
+    stat->queue_len = w->queue_len;
+    stat->max_queue_len = w->max_queue_len;
+    stat->msg_cnt = w->msg_cnt;
+    stat->avg_delay_usec = w->msg_cnt ?
+                (pj_uint32_t)(w->total_delay_usec / w->msg_cnt) : 0;
+    stat->max_delay_usec = w->max_delay_usec;
+    pj_mutex_unlock(w->mutex);
+}
+
+/*
+ * Get receive worker statistics.
+ */
+PJ_DEF(pj_status_t) pjsip_endpt_get_rx_worker_stat(pjsip_endpoint *endpt,
+                                                   unsigned *count,
+                                                   pjsip_rx_worker_stat stat[])
+{
+    unsigned i;
+
+    PJ_ASSERT_RETURN(endpt && count && (*count == 0 || stat), PJ_EINVAL);
+
+    if (*count > endpt->rx_worker_cnt)
+        *count = endpt->rx_worker_cnt;
+
+    for (i=0; i<*count; ++i)
+        get_rx_worker_stat(&endpt->rx_workers[i], &stat[i]);
+
+    return PJ_SUCCESS;
+}
+
+/*
+ * Initialize overload control setting with default values.
+ */
+PJ_DEF(void) pjsip_overload_param_default(pjsip_overload_param *prm)
+{
+    pj_bzero(prm, sizeof(*prm));
+    prm->max_queue_len = PJSIP_OVERLOAD_MAX_QUEUE_LEN;
+    prm->max_queue_delay = PJSIP_OVERLOAD_MAX_QUEUE_DELAY;
+    prm->retry_after = PJSIP_OVERLOAD_RETRY_AFTER;
+    prm->oc_validity = PJSIP_OVERLOAD_OC_VALIDITY;
+}
+
+/*
+ * Enable or disable overload control.
+ */
+PJ_DEF(pj_status_t) pjsip_endpt_set_overload_param(
+                                        pjsip_endpoint *endpt,
+                                        const pjsip_overload_param *prm)
+{
+    pj_status_t status = PJ_SUCCESS;
+
+    PJ_ASSERT_RETURN(endpt, PJ_EINVAL);
+
+    pj_mutex_lock(endpt->mutex);
+
+    if (prm == NULL) {
+        endpt->oc_enabled = PJ_FALSE;
+        goto on_return;
+    }
+
+    if (endpt->oc_reduction == NULL) {
+        status = pj_atomic_create(endpt->pool, 0, &endpt->oc_reduction);
+        if (status != PJ_SUCCESS)
+            goto on_return;
+    }
+    if (endpt->oc_shed_cnt == NULL) {
+        status = pj_atomic_create(endpt->pool, 0, &endpt->oc_shed_cnt);
+        if (status != PJ_SUCCESS)
+            goto on_return;
+    }
+
+    pj_memcpy(&endpt->oc_param, prm, sizeof(*prm));
+    endpt->oc_enabled = PJ_TRUE;
+
+on_return:
+    pj_mutex_unlock(endpt->mutex);
+    return status;
+}
+
+/*
+ * Set the reduction percentage of application's own overload policy.
+ */
+PJ_DEF(pj_status_t) pjsip_endpt_set_overloaded(pjsip_endpoint *endpt,
+                                               unsigned reduction)
+{
+    PJ_ASSERT_RETURN(endpt && reduction <= 100, PJ_EINVAL);
+    PJ_ASSERT_RETURN(endpt->oc_enabled, PJ_EINVALIDOP);
+
+    endpt->oc_forced_reduction = reduction;
+    return PJ_SUCCESS;
+}
+
+/*
+ * Get overload control statistics.
+ */
+PJ_DEF(pj_status_t) pjsip_endpt_get_overload_stat(pjsip_endpoint *endpt,
+                                                  pjsip_overload_stat *stat)
+{
+    PJ_ASSERT_RETURN(endpt && stat, PJ_EINVAL);
+
+    pj_bzero(stat, sizeof(*stat));
+    if (endpt->oc_shed_cnt) {
+        stat->shed_cnt = (pj_uint32_t)pj_atomic_get(endpt->oc_shed_cnt);
+        stat->reduction = (unsigned)pj_atomic_get(endpt->oc_reduction);
+    }
+
+    return PJ_SUCCESS;
+}
+
+/*
+ * Check if the request is subject to overload control, i.e. an INVITE or
+ * REGISTER outside of dialog. Everything else is let through, since it
+ * either completes work that has been accepted or costs little.
+ */
+static pj_bool_t is_oc_candidate(const pjsip_rx_data *rdata)
+{
+    const pjsip_msg *msg = rdata->msg_info.msg;
+
+    if (msg->type != PJSIP_REQUEST_MSG || rdata->msg_info.to->tag.slen)
+        return PJ_FALSE;
+
+    return msg->line.req.method.id == PJSIP_INVITE_METHOD ||
+           msg->line.req.method.id == PJSIP_REGISTER_METHOD;
+}
+
+/*
+ * Check if the request is a retransmission of a request that already has
+ * a server transaction. It is absorbed by the transaction instead of
+ * being rejected, since the request has been accepted already.
+ */
+static pj_bool_t is_uas_tsx_retransmission(pjsip_rx_data *rdata)
+{
+    pj_str_t key;
+
+    if (pjsip_tsx_layer_instance()->id == -1)
+        return PJ_FALSE;
+
+    if (pjsip_tsx_create_key(rdata->tp_info.pool, &key, PJSIP_ROLE_UAS,
+                             &rdata->msg_info.msg->line.req.method,
+                             rdata) != PJ_SUCCESS)
+    {
+        return PJ_FALSE;
+    }
+
+    return pjsip_tsx_layer_find_tsx(&key, PJ_FALSE) != NULL;
+}
+
+/*
+ * Reduction percentage for a value that exceeds its limit: proportional
+ * to the excess, reaching 100% at twice the limit.
+ */
+static unsigned calc_oc_reduction(unsigned value, unsigned limit)
+{
+    enum { MIN_REDUCTION = 10 };
+    pj_uint64_t r;
+
+    if (limit == 0 || value <= limit)
+        return 0;
+
+    r = (pj_uint64_t)(value - limit) * 100 / limit;
+    if (r < MIN_REDUCTION)
+        return MIN_REDUCTION;
+    return r > 100 ? 100 : (unsigned)r;
+}
+
+/*
+ * Get the percentage of new requests to reject, from the state of the
+ * receive worker that would process the request.
+ */
+static unsigned get_oc_reduction( pjsip_endpoint *endpt,
+                                  const pjsip_rx_data *rdata )
+{
+    const pjsip_overload_param *prm = &endpt->oc_param;
+    unsigned reduction = endpt->oc_forced_reduction;
+
+    if (endpt->rx_worker_cnt) {
+        rx_worker *w = get_rx_worker(endpt, rdata);
+        unsigned queue_len, delay = 0, r;
+
+        pj_mutex_lock(w->mutex);
+        queue_len = w->queue_len;
+        if (queue_len) {
+            pj_timestamp now;
+
+            pj_get_timestamp(&now);
+            delay = pj_elapsed_msec(&w->queue.next->ts, &now);
+        }
+        pj_mutex_unlock(w->mutex);
+
+        r = calc_oc_reduction(queue_len, prm->max_queue_len);
+        if (r > reduction)
+            reduction = r;
+        r = calc_oc_reduction(delay, prm->max_queue_delay);
+        if (r > reduction)
+            reduction = r;
+    }
+
+    pj_atomic_set(endpt->oc_reduction, reduction);
+    return reduction;
+}
+
+/*
+ * Set the value of Via parameter, adding the parameter if it's not there.
+ */
+static void set_via_param(pj_pool_t *pool, pjsip_via_hdr *via,
+                          const pj_str_t *name, const pj_str_t *value)
+{
+    pjsip_param *p = pjsip_param_find(&via->other_param, name);
+
+    if (!p) {
+        p = PJ_POOL_ALLOC_T(pool, pjsip_param);
+        p->name = *name;
+        pj_list_push_back(&via->other_param, p);
+    }
+    pj_strdup(pool, &p->value, value);
+}
+
+/*
+ * Reject new request with 503 because of overload.
+ */
+static void reject_overload( pjsip_endpoint *endpt,
+                             pjsip_rx_data *rdata,
+                             unsigned reduction )
+{
+    static const pj_str_t STR_OC = { "oc", 2 };
+    static const pj_str_t STR_OC_ALGO = { "oc-algo", 7 };
+    static const pj_str_t STR_OC_VALIDITY = { "oc-validity", 11 };
+    static const pj_str_t STR_OC_SEQ = { "oc-seq", 6 };
+    static const pj_str_t STR_LOSS = { "\"loss\"", 6 };
+    pj_pool_t *pool = rdata->tp_info.pool;
+    pjsip_via_hdr *via = rdata->msg_info.via;
+    pjsip_hdr hdr_list;
+    pj_status_t status;
+
+    pj_list_init(&hdr_list);
+
+    if (endpt->oc_param.retry_after) {
+        pjsip_retry_after_hdr *ra;
+
+        ra = pjsip_retry_after_hdr_create(pool, endpt->oc_param.retry_after);
+        pj_list_push_back(&hdr_list, ra);
+    }
+
+    /* Tell client that supports overload control (RFC 7339) how much
+     * traffic to reduce, for how long.
+     */
+    if (pjsip_param_find(&via->other_param, &STR_OC)) {
+        char buf[40];
+        pj_str_t value;
+        pj_time_val now;
+
+        value.ptr = buf;
+        value.slen = pj_utoa(reduction, buf);
+        set_via_param(pool, via, &STR_OC, &value);
+
+        set_via_param(pool, via, &STR_OC_ALGO, &STR_LOSS);
+
+        value.slen = pj_utoa(endpt->oc_param.oc_validity, buf);
+        set_via_param(pool, via, &STR_OC_VALIDITY, &value);
+
+        pj_gettimeofday(&now);
+        value.slen = pj_ansi_snprintf(buf, sizeof(buf), "%lu.%03u",
+                                      (unsigned long)now.sec,
+                                      (unsigned)now.msec);
+        set_via_param(pool, via, &STR_OC_SEQ, &value);
+    }
+
+    status = pjsip_endpt_respond_stateless_raw(endpt, rdata,
+                                               PJSIP_SC_SERVICE_UNAVAILABLE,
+                                               NULL, &hdr_list);
+    if (status != PJ_SUCCESS) {
+        PJ_PERROR(4,(THIS_FILE, status, "Error sending 503 to %s",
+                     pjsip_rx_data_get_info(rdata)));
+    }
+
+    pj_atomic_inc(endpt->oc_shed_cnt);
+
+    PJ_LOG(5,(THIS_FILE, "Overloaded (reduction=%u%%), rejected %s from "
+              "%s:%d", reduction, pjsip_rx_data_get_info(rdata),
+              rdata->pkt_info.src_name, rdata->pkt_info.src_port));
+}
+
 /*
  * This is the callback that is called by the transport manager when it 
- * receives a message from the network.
+ * receives a message from the network. The message is queued to receive
+ * worker if there is any, otherwise it's processed by this thread.
  */
 static void endpt_on_rx_msg( pjsip_endpoint *endpt,
                              pj_status_t status,
                              pjsip_rx_data *rdata )
 {
-    pjsip_msg *msg = rdata->msg_info.msg;
-    pjsip_process_rdata_param proc_prm;
-    pj_bool_t handled = PJ_FALSE;
-
-    PJ_UNUSED_ARG(msg);
-
     if (status != PJ_SUCCESS) {
         char info[30];
         char errmsg[PJ_ERR_MSG_SIZE];
@@ -1014,6 +1577,41 @@ static void endpt_on_rx_msg( pjsip_endpoint *endpt,
         return;
     }
 
+    /* Reject new INVITE or REGISTER when we're overloaded, before
+     * spending anything on it.
+     */
+    if (endpt->oc_enabled && is_oc_candidate(rdata)) {
+        unsigned reduction = get_oc_reduction(endpt, rdata);
+
+        if (reduction && (reduction >= 100 ||
+                          (unsigned)(pj_rand() % 100) < reduction) &&
+            !is_uas_tsx_retransmission(rdata))
+        {
+            reject_overload(endpt, rdata, reduction);
+            return;
+        }
+    }
+
+    /* Queue the message to receive worker, if any. */
+    if (endpt->rx_worker_cnt && dispatch_rx_msg(endpt, rdata) == PJ_SUCCESS)
+        return;
+
+    endpt_process_rx_msg(endpt, rdata);
+}
+
+/*
+ * Distribute incoming message to modules. This is called by the thread
+ * that receives the message, or by receive worker.
+ */
+static void endpt_process_rx_msg( pjsip_endpoint *endpt,
+                                  pjsip_rx_data *rdata )
+{
+    pjsip_msg *msg = rdata->msg_info.msg;
+    pjsip_process_rdata_param proc_prm;
+    pj_bool_t handled = PJ_FALSE;
+
+    PJ_UNUSED_ARG(msg);
+
     PJ_LOG(5, (THIS_FILE, "Processing incoming message: %s", 
                pjsip_rx_data_get_info(rdata)));
     pj_log_push_indent();
@@ -1148,6 +1746,59 @@ PJ_DEF(pj_status_t) pjsip_endpt_create_tdata(  pjsip_endpoint *endpt,
     return pjsip_tx_data_create(endpt->transport_mgr, p_tdata);
 }
 
+/*
+ * Get a transmit buffer for pjsip_endpt_respond_stateless_raw(), reusing
+ * one from a previous response if available. The buffer is large enough
+ * for PJSIP_MAX_PKT_LEN bytes. Called by sip_util.c.
+ */
+pj_status_t pjsip_endpt_acquire_raw_tdata(pjsip_endpoint *endpt,
+                                          pjsip_tx_data **p_tdata)
+{
+    pjsip_tx_data *tdata = NULL;
+    pj_status_t status;
+
+    pj_mutex_lock(endpt->mutex);
+    if (endpt->raw_rsp_tdata_cnt)
+        tdata = endpt->raw_rsp_tdata[--endpt->raw_rsp_tdata_cnt];
+    pj_mutex_unlock(endpt->mutex);
+
+    if (tdata == NULL) {
+        status = pjsip_tx_data_create(endpt->transport_mgr, &tdata);
+        if (status != PJ_SUCCESS)
+            return status;
+
+        pjsip_tx_data_add_ref(tdata);
+        tdata->info = "raw response";
+        tdata->buf.start = (char*) pj_pool_alloc(tdata->pool,
+                                                 PJSIP_MAX_PKT_LEN);
+        tdata->buf.end = tdata->buf.start + PJSIP_MAX_PKT_LEN;
+    }
+
+    tdata->buf.cur = tdata->buf.start;
+    *p_tdata = tdata;
+    return PJ_SUCCESS;
+}
+
+/*
+ * Return the transmit buffer acquired with pjsip_endpt_acquire_raw_tdata()
+ * once the transport is done with it. Called by sip_util.c.
+ */
+void pjsip_endpt_release_raw_tdata(pjsip_endpoint *endpt,
+                                   pjsip_tx_data *tdata)
+{
+    pj_mutex_lock(endpt->mutex);
+    if (!endpt->raw_rsp_tdata_closed &&
+        endpt->raw_rsp_tdata_cnt < PJ_ARRAY_SIZE(endpt->raw_rsp_tdata))
+    {
+        endpt->raw_rsp_tdata[endpt->raw_rsp_tdata_cnt++] = tdata;
+        tdata = NULL;
+    }
+    pj_mutex_unlock(endpt->mutex);
+
+    if (tdata)
+        pjsip_tx_data_dec_ref(tdata);
+}
+
 /*
  * Create the DNS resolver instance. 
  */
@@ -1306,6 +1957,8 @@ PJ_DEF(void) pjsip_endpt_log_error(  pjsip_endpoint *endpt,
 PJ_DEF(void) pjsip_endpt_dump( pjsip_endpoint *endpt, pj_bool_t detail )
 {
 #if PJ_LOG_MAX_LEVEL >= 3
+    unsigned i;
+
     PJ_LOG(5, (THIS_FILE, "pjsip_endpt_dump()"));
 
     /* Lock mutex. */
@@ -1340,6 +1993,26 @@ PJ_DEF(void) pjsip_endpt_dump( pjsip_endpoint *endpt, pj_bool_t detail )
               (unsigned long)pj_timer_heap_count(endpt->timer_heap)));
 #endif
 
+    /* Receive workers. */
+    for (i=0; i<endpt->rx_worker_cnt; ++i) {
+        pjsip_rx_worker_stat stat;
+
+        get_rx_worker_stat(&endpt->rx_workers[i], &stat);
+        PJ_LOG(3,(THIS_FILE, " Receive worker %d: queue=%u (max %u), "
+                  "msgs=%u, delay avg=%uus max=%uus", i, stat.queue_len,
+                  stat.max_queue_len, stat.msg_cnt, stat.avg_delay_usec,
+                  stat.max_delay_usec));
+    }
+
+    /* Overload control. */
+    if (endpt->oc_enabled) {
+        pjsip_overload_stat stat;
+
+        pjsip_endpt_get_overload_stat(endpt, &stat);
+        PJ_LOG(3,(THIS_FILE, " Overload control: reduction=%u%%, "
+                  "rejected=%u", stat.reduction, stat.shed_cnt));
+    }
+
     /* Unlock mutex. */
     pj_mutex_unlock(endpt->mutex);
 #else
@@ -365,6 +365,13 @@ PJ_DEF(void*)  pjsip_hdr_find( const void *hdr_list,
         hdr = end->next;
     }
     for (; hdr!=end; hdr = hdr->next) {
+        if (hdr->type == PJSIP_H_OTHER && hdr_type != PJSIP_H_OTHER) {
+            /* Parse the header if it was deferred and is what we want */
+            pjsip_hdr *parsed = pjsip_parse_lazy_hdr((pjsip_hdr*)hdr,
+                                                     hdr_type, NULL, NULL);
+            if (parsed)
+                hdr = parsed;
+        }
         if (hdr->type == hdr_type)
             return (void*)hdr;
     }
@@ -381,8 +388,16 @@ PJ_DEF(void*)  pjsip_hdr_find_by_name( const void *hdr_list,
         hdr = end->next;
     }
     for (; hdr!=end; hdr = hdr->next) {
-        if (pj_stricmp(&hdr->name, name) == 0)
+        if (pj_stricmp(&hdr->name, name) == 0) {
+            if (hdr->type == PJSIP_H_OTHER) {
+                pjsip_hdr *parsed = pjsip_parse_lazy_hdr((pjsip_hdr*)hdr,
+                                                         PJSIP_H_OTHER,
+                                                         name, NULL);
+                if (parsed)
+                    hdr = parsed;
+            }
             return (void*)hdr;
+        }
     }
     return NULL;
 }
@@ -398,10 +413,18 @@ PJ_DEF(void*)  pjsip_hdr_find_by_names( const void *hdr_list,
         hdr = end->next;
     }
     for (; hdr!=end; hdr = hdr->next) {
-        if (pj_stricmp(&hdr->name, name) == 0)
-            return (void*)hdr;
-        if (pj_stricmp(&hdr->name, sname) == 0)
+        if (pj_stricmp(&hdr->name, name) == 0 ||
+            pj_stricmp(&hdr->name, sname) == 0)
+        {
+            if (hdr->type == PJSIP_H_OTHER) {
+                pjsip_hdr *parsed = pjsip_parse_lazy_hdr((pjsip_hdr*)hdr,
+                                                         PJSIP_H_OTHER,
+                                                         name, sname);
+                if (parsed)
+                    hdr = parsed;
+            }
             return (void*)hdr;
+        }
     }
     return NULL;
 }
@@ -629,6 +652,133 @@ PJ_DEF(int) pjsip_hdr_print_on( void *hdr_ptr, char *buf, pj_size_t len)
     return (*hdr->vptr->print_on)(hdr_ptr, buf, len);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/*
+ * Pre-encoded header.
+ *
+ * A pre-encoded header is a normal header of its type, with its vptr
+ * replaced by an encoded_hdr_vptr, which keeps the original vptr and the
+ * printed header. The vptr is shared by the shallow clones of the header.
+ */
+#define ENCODED_HDR_BUF_LEN     512
+
+typedef struct encoded_hdr_vptr
+{
+    pjsip_hdr_vptr      vptr;
+    pjsip_hdr_vptr     *orig;
+    pj_str_t            text;
+} encoded_hdr_vptr;
+
+static int encoded_hdr_print(pjsip_hdr *hdr, char *buf, pj_size_t size);
+static pjsip_hdr* encoded_hdr_clone(pj_pool_t *pool, const pjsip_hdr *hdr);
+static pjsip_hdr* encoded_hdr_shallow_clone(pj_pool_t *pool, 
+                                            const pjsip_hdr *hdr);
+
+PJ_INLINE(pj_bool_t) is_encoded_hdr(const pjsip_hdr *hdr)
+{
+    return hdr->vptr->print_on == (pjsip_hdr_print_fptr)&encoded_hdr_print;
+}
+
+static int encoded_hdr_print(pjsip_hdr *hdr, char *buf, pj_size_t size)
+{
+    const encoded_hdr_vptr *evptr = (const encoded_hdr_vptr*) hdr->vptr;
+
+    if ((pj_ssize_t)size < evptr->text.slen)
+        return -1;
+
+    pj_memcpy(buf, evptr->text.ptr, evptr->text.slen);
+    return (int)evptr->text.slen;
+}
+
+static pjsip_hdr* encoded_hdr_clone(pj_pool_t *pool, const pjsip_hdr *hdr)
+{
+    const encoded_hdr_vptr *evptr = (const encoded_hdr_vptr*) hdr->vptr;
+    pjsip_hdr *new_hdr;
+
+    /* Full clone may be modified, so it's a normal header. */
+    new_hdr = (pjsip_hdr*) (*evptr->orig->clone)(pool, hdr);
+    new_hdr->vptr = evptr->orig;
+    return new_hdr;
+}
+
+static pjsip_hdr* encoded_hdr_shallow_clone(pj_pool_t *pool, 
+                                            const pjsip_hdr *hdr)
+{
+    const encoded_hdr_vptr *evptr = (const encoded_hdr_vptr*) hdr->vptr;
+    pjsip_hdr *new_hdr;
+
+    new_hdr = (pjsip_hdr*) (*evptr->orig->shallow_clone)(pool, hdr);
+    new_hdr->vptr = hdr->vptr;
+    return new_hdr;
+}
+
+PJ_DEF(void*) pjsip_hdr_encode( pj_pool_t *pool, const void *hdr_ptr )
+{
+    const pjsip_hdr *hdr = (const pjsip_hdr*) hdr_ptr;
+    encoded_hdr_vptr *evptr;
+    pjsip_hdr *new_hdr;
+
+    PJ_ASSERT_RETURN(pool && hdr && hdr->vptr, NULL);
+
+    if (is_encoded_hdr(hdr)) {
+        const encoded_hdr_vptr *src = (const encoded_hdr_vptr*) hdr->vptr;
+
+        /* Just copy the text, which is put right after the vptr. */
+        evptr = (encoded_hdr_vptr*)
+                pj_pool_alloc(pool, sizeof(encoded_hdr_vptr) +
+                                    src->text.slen);
+        evptr->text.ptr = (char*)(evptr + 1);
+        evptr->text.slen = src->text.slen;
+        pj_memcpy(evptr->text.ptr, src->text.ptr, src->text.slen);
+        evptr->orig = src->orig;
+
+    } else {
+        char tmp[ENCODED_HDR_BUF_LEN];
+        int len;
+
+        /* Most headers fit in the stack buffer, so only the printed
+         * length is allocated from the pool. Larger ones are printed
+         * directly to a pool buffer, growing it as needed.
+         */
+        len = pjsip_hdr_print_on((void*)hdr, tmp, sizeof(tmp));
+        if (len >= 0) {
+            evptr = (encoded_hdr_vptr*)
+                    pj_pool_alloc(pool, sizeof(encoded_hdr_vptr) + len);
+            evptr->text.ptr = (char*)(evptr + 1);
+            pj_memcpy(evptr->text.ptr, tmp, len);
+        } else {
+            pj_size_t size = sizeof(tmp);
+
+            evptr = PJ_POOL_ALLOC_T(pool, encoded_hdr_vptr);
+            do {
+                size <<= 2;
+                evptr->text.ptr = (char*) pj_pool_alloc(pool, size);
+                len = pjsip_hdr_print_on((void*)hdr, evptr->text.ptr, size);
+            } while (len < 0 && size < PJSIP_MAX_PKT_LEN);
+
+            if (len < 0)
+                return NULL;
+        }
+        evptr->text.slen = len;
+        evptr->orig = hdr->vptr;
+    }
+
+    evptr->vptr.clone = (pjsip_hdr_clone_fptr) &encoded_hdr_clone;
+    evptr->vptr.shallow_clone = (pjsip_hdr_clone_fptr)
+                                &encoded_hdr_shallow_clone;
+    evptr->vptr.print_on = (pjsip_hdr_print_fptr) &encoded_hdr_print;
+
+    new_hdr = (pjsip_hdr*) (*evptr->orig->clone)(pool, hdr);
+    new_hdr->vptr = &evptr->vptr;
+    return new_hdr;
+}
+
+PJ_DEF(pj_bool_t) pjsip_hdr_is_encoded( const void *hdr_ptr )
+{
+    const pjsip_hdr *hdr = (const pjsip_hdr*) hdr_ptr;
+    return hdr->vptr && is_encoded_hdr(hdr);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /*
  * Status/Reason Phrase
@@ -23,6 +23,7 @@
 #include <pjsip/sip_auth_parser.h>
 #include <pjsip/sip_errno.h>
 #include <pjsip/sip_transport.h>        /* rdata structure */
+#include <pjsip/print_util.h>
 #include <pjlib-util/scanner.h>
 #include <pjlib-util/string.h>
 #include <pj/except.h>
@@ -57,8 +58,6 @@
  */
 #define GENERIC_URI_CHARS   "#?;:@&=+-_.!~*'()%$,/" "%"
 
-#define UNREACHED(expr)
-
 #define IS_NEWLINE(c)   ((c)=='\r' || (c)=='\n')
 #define IS_SPACE(c)     ((c)==' ' || (c)=='\t')
 
@@ -71,12 +70,82 @@ typedef struct handler_rec
     pj_size_t             hname_len;
     pj_uint32_t           hname_hash;
     pjsip_parse_hdr_func *handler;
+    int                   name_idx;
+    pj_bool_t             nothrow;
 } handler_rec;
 
 static handler_rec handler[PJSIP_MAX_HEADER_TYPES];
 static unsigned handler_count;
+
+/*
+ * Built-in header parsers (the ones in this file) are kept in a separate
+ * table, indexed by the lower-cased first character and length of the
+ * header name. Each slot contains the index+1 of the first record in
+ * builtin_handler[] with that first character and length, and records
+ * with the same slot are chained with next_idx. With the built-in names
+ * there is at most one record per slot, so the lookup is a table access
+ * and one case-insensitive compare. Names are stored in lower-case.
+ *
+ * Parsers registered by other modules with pjsip_register_hdr_parser()
+ * are kept in the sorted handler[] array above.
+ */
+typedef struct builtin_handler_rec
+{
+    handler_rec           rec;
+    pj_uint8_t            next_idx;
+} builtin_handler_rec;
+
+#define BUILTIN_HANDLER_MAX     64
+
+static builtin_handler_rec builtin_handler[BUILTIN_HANDLER_MAX];
+static unsigned builtin_handler_count;
+static pj_uint8_t builtin_handler_slot[26][PJSIP_MAX_HNAME_LEN+1];
 static int parser_is_initialized;
 
+/*
+ * Names of the headers as registered with pjsip_register_hdr_parser(),
+ * used to name the headers whose parsing is deferred. Unlike the handler
+ * records, these are never moved so headers can point to them.
+ */
+typedef struct hdr_name_rec
+{
+    char                  name[PJSIP_MAX_HNAME_LEN+1];
+    char                  sname[PJSIP_MAX_HNAME_LEN+1];
+} hdr_name_rec;
+
+static hdr_name_rec hdr_names[PJSIP_MAX_HEADER_TYPES];
+static unsigned hdr_name_count;
+
+/*
+ * Header whose parsing is deferred until it is looked up, when
+ * lazy_hdr_parsing in pjsip_cfg_t is enabled. The layout is compatible
+ * with pjsip_generic_string_hdr, with hvalue containing the raw value of
+ * the header, so code that walks the header list sees it as a generic
+ * string header (with PJSIP_H_OTHER type).
+ */
+typedef struct lazy_hdr
+{
+    PJSIP_DECL_HDR_MEMBER(struct lazy_hdr);
+    pj_str_t              hvalue;
+    pjsip_parse_hdr_func *handler;
+    pj_bool_t             nothrow;
+    pj_pool_t            *pool;
+} lazy_hdr;
+
+static int lazy_hdr_print(lazy_hdr *hdr, char *buf, pj_size_t size);
+static lazy_hdr* lazy_hdr_clone(pj_pool_t *pool, const lazy_hdr *rhs);
+static lazy_hdr* lazy_hdr_shallow_clone(pj_pool_t *pool, const lazy_hdr *rhs);
+
+static lazy_hdr* create_lazy_hdr(pjsip_parse_ctx *ctx,
+                                 const handler_rec *rec);
+
+static pjsip_hdr_vptr lazy_hdr_vptr = 
+{
+    (pjsip_hdr_clone_fptr) &lazy_hdr_clone,
+    (pjsip_hdr_clone_fptr) &lazy_hdr_shallow_clone,
+    (pjsip_hdr_print_fptr) &lazy_hdr_print,
+};
+
 /*
  * URI parser records.
  */
@@ -185,6 +254,11 @@ static pjsip_hdr*   parse_hdr_to( pjsip_parse_ctx *ctx );
 static pjsip_hdr*   parse_hdr_unsupported( pjsip_parse_ctx *ctx );
 static pjsip_hdr*   parse_hdr_via( pjsip_parse_ctx *ctx );
 static pjsip_hdr*   parse_hdr_generic_string( pjsip_parse_ctx *ctx);
+static pj_bool_t    is_eager_handler(pjsip_parse_hdr_func *func);
+static pj_status_t  register_hdr_parser( const char *hname,
+                                         const char *hshortname,
+                                         pjsip_parse_hdr_func *fptr,
+                                         pj_bool_t nothrow );
 
 /* Convert non NULL terminated string to integer. */
 static unsigned long pj_strtoul_mindigit(const pj_str_t *str, 
@@ -206,6 +280,12 @@ static unsigned long pj_strtoul_mindigit(const pj_str_t *str,
 /* Case insensitive comparison */
 #define parser_stricmp(s1, s2)  (s1.slen!=s2.slen || pj_stricmp_alnum(&s1, &s2))
 
+/* Check if an error has been recorded in the scanner. This only happens
+ * when the scanner has no syntax error callback, otherwise the error is
+ * reported by throwing exception.
+ */
+#define PARSE_FAILED(scanner)   (pj_scan_get_error(scanner) != PJ_SUCCESS)
+
 /* Get a token and unescape */
 PJ_INLINE(void) parser_get_and_unescape(pj_scanner *scanner, pj_pool_t *pool,
                                         const pj_cis_t *spec, 
@@ -230,8 +310,25 @@ static void on_syntax_error(pj_scanner *scanner)
     PJ_THROW(PJSIP_SYN_ERR_EXCEPTION);
 }
 
+/* Get the exception ID to be put in the error report for the error
+ * recorded in the scanner.
+ */
+static int get_except_code(pj_status_t err)
+{
+    return (err == PJ_EINVAL) ? PJSIP_SYN_ERR_EXCEPTION :
+                                PJSIP_EINVAL_ERR_EXCEPTION;
+}
+
+/* Record exception thrown by external parser in the scanner. */
+static void set_except_error(pj_scanner *scanner, int except_code)
+{
+    pj_scan_set_error(scanner, (except_code == PJSIP_SYN_ERR_EXCEPTION) ?
+                                PJ_EINVAL : PJSIP_EINVALIDHDR);
+}
+
 /* Syntax error handler for parser. */
-static void on_str_parse_error(const pj_str_t *str, int rc)
+static void on_str_parse_error(pj_scanner *scanner, const pj_str_t *str,
+                               int rc)
 {
     char *s;
 
@@ -256,17 +353,25 @@ static void on_str_parse_error(const pj_str_t *str, int rc)
     } else {
         PJ_LOG(1, (THIS_FILE, "Can't parse input string: %s", s));
     }
-    PJ_THROW(PJSIP_EINVAL_ERR_EXCEPTION);
+
+    if (scanner->callback) {
+        PJ_THROW(PJSIP_EINVAL_ERR_EXCEPTION);
+    }
+    pj_scan_set_error(scanner, (rc == PJ_EINVAL) ? PJSIP_EINVALIDHDR : rc);
 }
 
-static void strtoi_validate(const pj_str_t *str, int min_val,
-                            int max_val, int *value)
+static void strtoi_validate(pj_scanner *scanner, const pj_str_t *str,
+                            int min_val, int max_val, int *value)
 { 
     long retval;
     pj_status_t status;
 
+    /* The string is empty when a previous scanning has failed */
+    if (PARSE_FAILED(scanner))
+        return;
+
     if (!str || !value) {
-        on_str_parse_error(str, PJ_EINVAL);
+        on_str_parse_error(scanner, str, PJ_EINVAL);
         return;
     }
     status = pj_strtol2(str, &retval);
@@ -282,7 +387,7 @@ static void strtoi_validate(const pj_str_t *str, int min_val,
     }
 
     if (status != PJ_SUCCESS)
-        on_str_parse_error(str, status);
+        on_str_parse_error(scanner, str, status);
 }
 
 /* Get parser constants. */
@@ -472,68 +577,68 @@ static pj_status_t init_parser()
      * Register header parsers.
      */
 
-    status = pjsip_register_hdr_parser( "Accept", NULL, &parse_hdr_accept);
+    status = register_hdr_parser("Accept", NULL, &parse_hdr_accept, PJ_TRUE);
     PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
-    status = pjsip_register_hdr_parser( "Allow", NULL, &parse_hdr_allow);
+    status = register_hdr_parser("Allow", NULL, &parse_hdr_allow, PJ_TRUE);
     PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
-    status = pjsip_register_hdr_parser( "Call-ID", "i", &parse_hdr_call_id);
+    status = register_hdr_parser("Call-ID", "i", &parse_hdr_call_id, PJ_TRUE);
     PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
-    status = pjsip_register_hdr_parser( "Contact", "m", &parse_hdr_contact);
+    status = register_hdr_parser("Contact", "m", &parse_hdr_contact, PJ_TRUE);
     PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
-    status = pjsip_register_hdr_parser( "Content-Length", "l", 
-                                        &parse_hdr_content_len);
+    status = register_hdr_parser("Content-Length", "l",
+                                 &parse_hdr_content_len, PJ_TRUE);
     PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
-    status = pjsip_register_hdr_parser( "Content-Type", "c", 
-                                        &parse_hdr_content_type);
+    status = register_hdr_parser("Content-Type", "c",
+                                 &parse_hdr_content_type, PJ_TRUE);
     PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
-    status = pjsip_register_hdr_parser( "CSeq", NULL, &parse_hdr_cseq);
+    status = register_hdr_parser("CSeq", NULL, &parse_hdr_cseq, PJ_TRUE);
     PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
-    status = pjsip_register_hdr_parser( "Expires", NULL, &parse_hdr_expires);
+    status = register_hdr_parser("Expires", NULL, &parse_hdr_expires, PJ_TRUE);
     PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
-    status = pjsip_register_hdr_parser( "From", "f", &parse_hdr_from);
+    status = register_hdr_parser("From", "f", &parse_hdr_from, PJ_TRUE);
     PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
-    status = pjsip_register_hdr_parser( "Max-Forwards", NULL, 
-                                        &parse_hdr_max_forwards);
+    status = register_hdr_parser("Max-Forwards", NULL,
+                                 &parse_hdr_max_forwards, PJ_TRUE);
     PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
-    status = pjsip_register_hdr_parser( "Min-Expires", NULL, 
-                                        &parse_hdr_min_expires);
+    status = register_hdr_parser("Min-Expires", NULL,
+                                 &parse_hdr_min_expires, PJ_TRUE);
     PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
-    status = pjsip_register_hdr_parser( "Record-Route", NULL, &parse_hdr_rr);
+    status = register_hdr_parser("Record-Route", NULL, &parse_hdr_rr, PJ_TRUE);
     PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
-    status = pjsip_register_hdr_parser( "Route", NULL, &parse_hdr_route);
+    status = register_hdr_parser("Route", NULL, &parse_hdr_route, PJ_TRUE);
     PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
-    status = pjsip_register_hdr_parser( "Require", NULL, &parse_hdr_require);
+    status = register_hdr_parser("Require", NULL, &parse_hdr_require, PJ_TRUE);
     PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
-    status = pjsip_register_hdr_parser( "Retry-After", NULL, 
-                                        &parse_hdr_retry_after);
+    status = register_hdr_parser("Retry-After", NULL,
+                                 &parse_hdr_retry_after, PJ_TRUE);
     PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
-    status = pjsip_register_hdr_parser( "Supported", "k", 
-                                        &parse_hdr_supported);
+    status = register_hdr_parser("Supported", "k",
+                                 &parse_hdr_supported, PJ_TRUE);
     PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
-    status = pjsip_register_hdr_parser( "To", "t", &parse_hdr_to);
+    status = register_hdr_parser("To", "t", &parse_hdr_to, PJ_TRUE);
     PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
-    status = pjsip_register_hdr_parser( "Unsupported", NULL, 
-                                        &parse_hdr_unsupported);
+    status = register_hdr_parser("Unsupported", NULL,
+                                 &parse_hdr_unsupported, PJ_TRUE);
     PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
-    status = pjsip_register_hdr_parser( "Via", "v", &parse_hdr_via);
+    status = register_hdr_parser("Via", "v", &parse_hdr_via, PJ_TRUE);
     PJ_ASSERT_RETURN(status == PJ_SUCCESS, status);
 
     /* 
@@ -561,6 +666,11 @@ void deinit_sip_parser(void)
         /* Clear header handlers */
         pj_bzero(handler, sizeof(handler));
         handler_count = 0;
+        pj_bzero(builtin_handler, sizeof(builtin_handler));
+        builtin_handler_count = 0;
+        pj_bzero(builtin_handler_slot, sizeof(builtin_handler_slot));
+        pj_bzero(hdr_names, sizeof(hdr_names));
+        hdr_name_count = 0;
 
         /* Clear URI handlers */
         pj_bzero(uri_handler, sizeof(uri_handler));
@@ -604,9 +714,90 @@ PJ_INLINE(int) compare_handler( const handler_rec *r1,
     return pj_memcmp(r1->hname, name, name_len);
 }
 
+/* Find built-in handler for the header name, ignoring case. */
+PJ_INLINE(const handler_rec*) find_builtin_handler(const char *name,
+                                                   pj_size_t name_len)
+{
+    unsigned c, idx;
+
+    if (name_len == 0 || name_len > PJSIP_MAX_HNAME_LEN)
+        return NULL;
+
+    c = (unsigned)(pj_tolower(name[0]) - 'a');
+    if (c >= PJ_ARRAY_SIZE(builtin_handler_slot))
+        return NULL;
+
+    for (idx = builtin_handler_slot[c][name_len]; idx != 0;
+         idx = builtin_handler[idx-1].next_idx)
+    {
+        const handler_rec *rec = &builtin_handler[idx-1].rec;
+        pj_size_t i;
+
+        /* First character has been matched by the slot. */
+        for (i=1; i<name_len; ++i) {
+            if (pj_tolower(name[i]) != rec->hname[i])
+                break;
+        }
+        if (i == name_len)
+            return rec;
+    }
+
+    return NULL;
+}
+
+/* Register one built-in handler for one header name. */
+static pj_status_t int_register_builtin_parser( const char *name,
+                                                pjsip_parse_hdr_func *fptr,
+                                                int name_idx )
+{
+    builtin_handler_rec *brec;
+    pj_size_t i, len;
+    unsigned c;
+
+    len = pj_ansi_strlen(name);
+    if (len == 0 || len > PJSIP_MAX_HNAME_LEN) {
+        pj_assert(!"Invalid header name length!");
+        return PJ_ENAMETOOLONG;
+    }
+
+    c = (unsigned)(pj_tolower(name[0]) - 'a');
+    if (c >= PJ_ARRAY_SIZE(builtin_handler_slot)) {
+        pj_assert(!"Built-in header name must start with a letter!");
+        return PJ_EINVAL;
+    }
+
+    if (find_builtin_handler(name, len)) {
+        pj_assert(0);
+        return PJ_EEXISTS;
+    }
+
+    if (builtin_handler_count >= PJ_ARRAY_SIZE(builtin_handler)) {
+        pj_assert(!"Too many built-in handlers!");
+        return PJ_ETOOMANY;
+    }
+
+    brec = &builtin_handler[builtin_handler_count];
+    for (i=0; i<len; ++i)
+        brec->rec.hname[i] = (char)pj_tolower(name[i]);
+    brec->rec.hname[len] = '\0';
+    brec->rec.hname_len = len;
+    brec->rec.hname_hash = 0;
+    brec->rec.handler = fptr;
+    brec->rec.name_idx = name_idx;
+    brec->rec.nothrow = PJ_TRUE;
+
+    /* Add to the head of the slot's chain. */
+    brec->next_idx = builtin_handler_slot[c][len];
+    builtin_handler_slot[c][len] = (pj_uint8_t)++builtin_handler_count;
+
+    return PJ_SUCCESS;
+}
+
 /* Register one handler for one header name. */
 static pj_status_t int_register_parser( const char *name, 
-                                        pjsip_parse_hdr_func *fptr )
+                                        pjsip_parse_hdr_func *fptr,
+                                        int name_idx,
+                                        pj_bool_t nothrow )
 {
     unsigned    pos;
     handler_rec rec;
@@ -618,6 +809,8 @@ static pj_status_t int_register_parser( const char *name,
 
     /* Initialize temporary handler. */
     rec.handler = fptr;
+    rec.name_idx = name_idx;
+    rec.nothrow = nothrow;
     rec.hname_len = strlen(name);
     if (rec.hname_len >= sizeof(rec.hname)) {
         pj_assert(!"Header name is too long!");
@@ -627,6 +820,12 @@ static pj_status_t int_register_parser( const char *name,
     pj_memcpy(rec.hname, name, rec.hname_len);
     rec.hname[rec.hname_len] = '\0';
 
+    /* Built-in handler can't be overridden. */
+    if (find_builtin_handler(rec.hname, rec.hname_len)) {
+        pj_assert(0);
+        return PJ_EEXISTS;
+    }
+
     /* Calculate hash value. */
     rec.hname_hash = pj_hash_calc(0, rec.hname, (unsigned)rec.hname_len);
 
@@ -657,26 +856,55 @@ static pj_status_t int_register_parser( const char *name,
 }
 
 /* Register parser handler. If both header name and short name are valid,
- * then two instances of handler will be registered.
+ * then two instances of handler will be registered. The nothrow flag
+ * tells that the handler reports error to the scanner instead of throwing
+ * exception, which is the case for the handlers in this file, and these
+ * are registered in the built-in handler table.
  */
-PJ_DEF(pj_status_t) pjsip_register_hdr_parser( const char *hname,
-                                               const char *hshortname,
-                                               pjsip_parse_hdr_func *fptr)
+static pj_status_t register_hdr_parser( const char *hname,
+                                        const char *hshortname,
+                                        pjsip_parse_hdr_func *fptr,
+                                        pj_bool_t nothrow )
 {
     unsigned i;
     pj_size_t len;
     char hname_lcase[PJSIP_MAX_HNAME_LEN+1];
+    int name_idx = -1;
     pj_status_t status;
 
     /* Check that name is not too long */
     len = pj_ansi_strlen(hname);
-    if (len > PJSIP_MAX_HNAME_LEN) {
+    if (len > PJSIP_MAX_HNAME_LEN ||
+        (hshortname && pj_ansi_strlen(hshortname) > PJSIP_MAX_HNAME_LEN))
+    {
         pj_assert(!"Header name is too long!");
         return PJ_ENAMETOOLONG;
     }
 
+    /* Save the names for lazy parsing. If there's no room, the header
+     * will just always be parsed.
+     */
+    if (hdr_name_count < PJ_ARRAY_SIZE(hdr_names)) {
+        name_idx = hdr_name_count++;
+        pj_ansi_strxcpy(hdr_names[name_idx].name, hname,
+                        sizeof(hdr_names[name_idx].name));
+        pj_ansi_strxcpy(hdr_names[name_idx].sname,
+                        (hshortname? hshortname : hname),
+                        sizeof(hdr_names[name_idx].sname));
+    }
+
+    /* Built-in handlers are looked up ignoring case, so only the name
+     * and the short name need to be registered.
+     */
+    if (nothrow) {
+        status = int_register_builtin_parser(hname, fptr, name_idx);
+        if (status == PJ_SUCCESS && hshortname)
+            status = int_register_builtin_parser(hshortname, fptr, name_idx);
+        return status;
+    }
+
     /* Register the normal Mixed-Case name */
-    status = int_register_parser(hname, fptr);
+    status = int_register_parser(hname, fptr, name_idx, nothrow);
     if (status != PJ_SUCCESS) {
         return status;
     }
@@ -688,7 +916,7 @@ PJ_DEF(pj_status_t) pjsip_register_hdr_parser( const char *hname,
     hname_lcase[len] = '\0';
 
     /* Register the lower-case version of the name */
-    status = int_register_parser(hname_lcase, fptr);
+    status = int_register_parser(hname_lcase, fptr, name_idx, nothrow);
     if (status != PJ_SUCCESS) {
         return status;
     }
@@ -696,17 +924,26 @@ PJ_DEF(pj_status_t) pjsip_register_hdr_parser( const char *hname,
 
     /* Register the shortname version of the name */
     if (hshortname) {
-        status = int_register_parser(hshortname, fptr);
+        status = int_register_parser(hshortname, fptr, name_idx,
+                                     nothrow);
         if (status != PJ_SUCCESS) 
             return status;
     }
     return PJ_SUCCESS;
 }
 
+/* Register parser handler from other modules. */
+PJ_DEF(pj_status_t) pjsip_register_hdr_parser( const char *hname,
+                                               const char *hshortname,
+                                               pjsip_parse_hdr_func *fptr)
+{
+    return register_hdr_parser(hname, hshortname, fptr, PJ_FALSE);
+}
+
 
 /* Find handler to parse the header name. */
-static pjsip_parse_hdr_func * find_handler_imp(pj_uint32_t  hash, 
-                                               const pj_str_t *hname)
+static const handler_rec* find_handler_imp(pj_uint32_t  hash, 
+                                           const pj_str_t *hname)
 {
     handler_rec *first;
     int          comp;
@@ -732,28 +969,35 @@ static pjsip_parse_hdr_func * find_handler_imp(pj_uint32_t  hash,
         }
     }
 
-    return comp==0 ? first->handler : NULL;
+    return comp==0 ? first : NULL;
 }
 
 
-/* Find handler to parse the header name. */
-static pjsip_parse_hdr_func* find_handler(const pj_str_t *hname)
+/* Find handler record to parse the header name. */
+static const handler_rec* find_handler_rec(const pj_str_t *hname)
 {
     pj_uint32_t hash;
     char hname_copy[PJSIP_MAX_HNAME_LEN];
     pj_str_t tmp;
-    pjsip_parse_hdr_func *func;
+    const handler_rec *rec;
 
     if (hname->slen >= PJSIP_MAX_HNAME_LEN) {
         /* Guaranteed not to be able to find handler. */
         return NULL;
     }
 
-    /* First, common case, try to find handler with exact name */
+    /* Most headers are handled by the built-in handlers. */
+    rec = find_builtin_handler(hname->ptr, hname->slen);
+    if (rec || handler_count == 0)
+        return rec;
+
+    /* Then the handlers registered by other modules. First, common case,
+     * try to find handler with exact name.
+     */
     hash = pj_hash_calc(0, hname->ptr, (unsigned)hname->slen);
-    func = find_handler_imp(hash, hname);
-    if (func)
-        return func;
+    rec = find_handler_imp(hash, hname);
+    if (rec)
+        return rec;
 
 
     /* If not found, try converting the header name to lowercase and
@@ -777,6 +1021,64 @@ static pjsip_parse_uri_func* find_uri_handler(const pj_str_t *scheme)
     return &int_parse_other_uri;
 }
 
+/* Call header parser handler. Handlers registered by other modules use
+ * exception to report error, so when the scanner has no syntax error
+ * callback, these are called with a temporary callback inside PJ_TRY
+ * block and the exception is recorded as scanner error.
+ */
+static pjsip_hdr* call_hdr_handler(pjsip_parse_hdr_func *func,
+                                   pj_bool_t nothrow,
+                                   pjsip_parse_ctx *ctx)
+{
+    pj_scanner *scanner = ctx->scanner;
+    pjsip_hdr *volatile hdr = NULL;
+    PJ_USE_EXCEPTION;
+
+    if (nothrow || scanner->callback)
+        return (*func)(ctx);
+
+    scanner->callback = &on_syntax_error;
+    PJ_TRY {
+        hdr = (*func)(ctx);
+    }
+    PJ_CATCH_ANY {
+        set_except_error(scanner, PJ_GET_EXCEPTION());
+        hdr = NULL;
+    }
+    PJ_END;
+    scanner->callback = NULL;
+
+    return hdr;
+}
+
+/* Call URI parser, see call_hdr_handler() above. */
+static void* call_uri_parser(pjsip_parse_uri_func *func,
+                             pj_scanner *scanner, pj_pool_t *pool,
+                             pj_bool_t parse_params)
+{
+    void *volatile uri = NULL;
+    PJ_USE_EXCEPTION;
+
+    if (func == &int_parse_sip_url || func == &int_parse_other_uri ||
+        scanner->callback)
+    {
+        return (*func)(scanner, pool, parse_params);
+    }
+
+    scanner->callback = &on_syntax_error;
+    PJ_TRY {
+        uri = (*func)(scanner, pool, parse_params);
+    }
+    PJ_CATCH_ANY {
+        set_except_error(scanner, PJ_GET_EXCEPTION());
+        uri = NULL;
+    }
+    PJ_END;
+    scanner->callback = NULL;
+
+    return uri;
+}
+
 /* Register URI parser. */
 PJ_DEF(pj_status_t) pjsip_register_uri_parser( char *scheme,
                                                pjsip_parse_uri_func *func)
@@ -800,8 +1102,7 @@ PJ_DEF(pjsip_msg*) pjsip_parse_msg( pj_pool_t *pool,
     pj_scanner scanner;
     pjsip_parse_ctx context;
 
-    pj_scan_init(&scanner, buf, size, PJ_SCAN_AUTOSKIP_WS_HEADER, 
-                 &on_syntax_error);
+    pj_scan_init(&scanner, buf, size, PJ_SCAN_AUTOSKIP_WS_HEADER, NULL);
 
     context.scanner = &scanner;
     context.pool = pool;
@@ -820,8 +1121,7 @@ PJ_DEF(pjsip_msg *) pjsip_parse_rdata( char *buf, pj_size_t size,
     pj_scanner scanner;
     pjsip_parse_ctx context;
 
-    pj_scan_init(&scanner, buf, size, PJ_SCAN_AUTOSKIP_WS_HEADER, 
-                 &on_syntax_error);
+    pj_scan_init(&scanner, buf, size, PJ_SCAN_AUTOSKIP_WS_HEADER, NULL);
 
     context.scanner = &scanner;
     context.pool = rdata->tp_info.pool;
@@ -838,10 +1138,10 @@ PJ_DEF(pj_status_t) pjsip_find_msg( const char *buf, pj_size_t size,
                                   pj_bool_t is_datagram, pj_size_t *msg_size)
 {
 #if PJ_HAS_TCP
-    const char *volatile hdr_end;
-    const char *volatile body_start;
+    const char *hdr_end;
+    const char *body_start;
     const char *pos;
-    const char *volatile line;
+    const char *line;
     int content_length = -1;
     pj_str_t cur_msg;
     pj_status_t status = PJSIP_EMISSINGHDR;
@@ -879,48 +1179,42 @@ PJ_DEF(pj_status_t) pjsip_find_msg( const char *buf, pj_size_t size,
         {
             /* Try to parse the header. */
             pj_scanner scanner;
-            PJ_USE_EXCEPTION;
+            pj_str_t str_clen;
+            pj_status_t err;
 
             /* The buffer passed to the scanner is not NULL terminated,
              * but should be safe. See ticket #2063.
              */ 
             pj_scan_init(&scanner, (char*)line, hdr_end-line, 
-                         PJ_SCAN_AUTOSKIP_WS_HEADER, &on_syntax_error);
+                         PJ_SCAN_AUTOSKIP_WS_HEADER, NULL);
 
-            PJ_TRY {
-                pj_str_t str_clen;
+            /* Get "Content-Length" or "L" name */
+            if (*line=='C' || *line=='c')
+                pj_scan_advance_n(&scanner, 14, PJ_TRUE);
+            else if (*line=='l' || *line=='L')
+                pj_scan_advance_n(&scanner, 1, PJ_TRUE);
 
-                /* Get "Content-Length" or "L" name */
-                if (*line=='C' || *line=='c')
-                    pj_scan_advance_n(&scanner, 14, PJ_TRUE);
-                else if (*line=='l' || *line=='L')
-                    pj_scan_advance_n(&scanner, 1, PJ_TRUE);
+            /* Get colon */
+            if (pj_scan_get_char(&scanner) != ':') {
+                pj_scan_syntax_err(&scanner);
+            }
 
-                /* Get colon */
-                if (pj_scan_get_char(&scanner) != ':') {
-                    PJ_THROW(PJSIP_SYN_ERR_EXCEPTION);
-                }
+            /* Get number */
+            pj_scan_get(&scanner, &pconst.pjsip_DIGIT_SPEC, &str_clen);
 
-                /* Get number */
-                pj_scan_get(&scanner, &pconst.pjsip_DIGIT_SPEC, &str_clen);
+            /* Get newline. */
+            pj_scan_get_newline(&scanner);
 
-                /* Get newline. */
-                pj_scan_get_newline(&scanner);
+            /* Found a valid Content-Length header? */
+            strtoi_validate(&scanner, &str_clen, PJSIP_MIN_CONTENT_LENGTH,
+                            PJSIP_MAX_CONTENT_LENGTH, &content_length);
 
-                /* Found a valid Content-Length header. */
-                strtoi_validate(&str_clen, PJSIP_MIN_CONTENT_LENGTH,
-                                PJSIP_MAX_CONTENT_LENGTH, &content_length);
-            }
-            PJ_CATCH_ANY {
-                int eid = PJ_GET_EXCEPTION();
-                if (eid == PJSIP_SYN_ERR_EXCEPTION) {
-                    status = PJSIP_EMISSINGHDR;
-                } else if (eid == PJSIP_EINVAL_ERR_EXCEPTION) {
-                    status = PJSIP_EINVALIDHDR;
-                }
+            err = pj_scan_get_error(&scanner);
+            if (err != PJ_SUCCESS) {
+                status = (err == PJ_EINVAL) ? PJSIP_EMISSINGHDR :
+                                              PJSIP_EINVALIDHDR;
                 content_length = -1;
             }
-            PJ_END
 
             pj_scan_fini(&scanner);
         }
@@ -960,18 +1254,14 @@ PJ_DEF(pjsip_uri*) pjsip_parse_uri( pj_pool_t *pool,
 {
     pj_scanner scanner;
     pjsip_uri *uri = NULL;
-    PJ_USE_EXCEPTION;
 
-    pj_scan_init(&scanner, buf, size, 0, &on_syntax_error);
+    pj_scan_init(&scanner, buf, size, 0, NULL);
 
-    
-    PJ_TRY {
-        uri = int_parse_uri_or_name_addr(&scanner, pool, option);
-    }
-    PJ_CATCH_ANY {
-        uri = NULL;
+    uri = int_parse_uri_or_name_addr(&scanner, pool, option);
+    if (PARSE_FAILED(&scanner)) {
+        pj_scan_fini(&scanner);
+        return NULL;
     }
-    PJ_END;
 
     /* Must have exhausted all inputs. */
     if (pj_scan_is_eof(&scanner) || IS_NEWLINE(*scanner.curptr)) {
@@ -994,10 +1284,10 @@ static void parse_sip_version(pj_scanner *scanner)
 
     pj_scan_get( scanner, &pconst.pjsip_ALPHA_SPEC, &sip);
     if (pj_scan_get_char(scanner) != '/')
-        on_syntax_error(scanner);
+        pj_scan_syntax_err(scanner);
     pj_scan_get_n( scanner, 3, &version);
     if (pj_stricmp(&sip, &SIP) || pj_stricmp(&version, &V2))
-        on_syntax_error(scanner);
+        pj_scan_syntax_err(scanner);
 }
 
 static pj_bool_t is_next_sip_version(pj_scanner *scanner)
@@ -1015,195 +1305,211 @@ static pj_bool_t is_next_sip_version(pj_scanner *scanner)
     return c && (c=='/' || c==' ' || c=='\t') && pj_stricmp(&sip, &SIP)==0;
 }
 
-/* Internal function to parse SIP message */
+/* Add error report for the error recorded in the scanner, and clear the
+ * error so that parsing can be resumed from the error position.
+ */
+static void report_parse_error(pj_scanner *scanner, pj_pool_t *pool,
+                               pjsip_parser_err_report *err_list,
+                               const pj_str_t *hname)
+{
+    pj_status_t err = pj_scan_get_error(scanner);
+
+    pj_scan_clear_error(scanner);
+
+    if (err_list) {
+        pjsip_parser_err_report *err_info;
+        
+        err_info = PJ_POOL_ALLOC_T(pool, pjsip_parser_err_report);
+        err_info->except_code = get_except_code(err);
+        err_info->line = scanner->line;
+        /* Scanner's column is zero based, so add 1 */
+        err_info->col = pj_scan_get_col(scanner) + 1;
+        if (hname)
+            err_info->hname = *hname;
+        else
+            err_info->hname.slen = 0;
+        
+        pj_list_insert_before(err_list, err_info);
+    }
+}
+
+/* Skip the rest of the header after parsing error. */
+static void skip_hdr_on_error(pj_scanner *scanner, int skip_ws)
+{
+    if (!pj_scan_is_eof(scanner)) {
+        /* Skip until next line.
+         * Watch for header continuation.
+         */
+        do {
+            pj_scan_skip_line(scanner);
+        } while (IS_SPACE(*scanner->curptr));
+    }
+
+    /* Restore flag. Flag may be set in int_parse_sip_url() */
+    scanner->skip_ws = skip_ws;
+}
+
+/* Internal function to parse SIP message. The scanner must not have
+ * syntax error callback, errors are recorded in the scanner and checked
+ * after each header, so no exception is used unless there are header or
+ * URI parsers registered by other modules.
+ */
 static pjsip_msg *int_parse_msg( pjsip_parse_ctx *ctx,
                                  pjsip_parser_err_report *err_list)
 {
-    /* These variables require "volatile" so their values get
-     * preserved when re-entering the PJ_TRY block after an error.
-     */
-    volatile pj_bool_t parsing_headers;
-    pjsip_msg *volatile msg = NULL;
-    pjsip_ctype_hdr *volatile ctype_hdr = NULL;
-
+    pjsip_msg *msg = NULL;
+    pjsip_ctype_hdr *ctype_hdr = NULL;
     pj_str_t hname;
     pj_scanner *scanner = ctx->scanner;
     pj_pool_t *pool = ctx->pool;
-    PJ_USE_EXCEPTION;
+    int skip_ws = scanner->skip_ws;
 
-    parsing_headers = PJ_FALSE;
+    pj_assert(scanner->callback == NULL);
 
-retry_parse:
-    PJ_TRY 
-    {
-        if (parsing_headers)
-            goto parse_headers;
+    /* Skip leading newlines. */
+    while (IS_NEWLINE(*scanner->curptr)) {
+        pj_scan_get_newline(scanner);
+    }
 
-        /* Skip leading newlines. */
-        while (IS_NEWLINE(*scanner->curptr)) {
-            pj_scan_get_newline(scanner);
-        }
+    /* Check if we still have valid packet.
+     * Sometimes endpoints just send blank (CRLF) packets just to keep
+     * NAT bindings open.
+     */
+    if (pj_scan_is_eof(scanner))
+        return NULL;
 
-        /* Check if we still have valid packet.
-         * Sometimes endpoints just send blank (CRLF) packets just to keep
-         * NAT bindings open.
-         */
-        if (pj_scan_is_eof(scanner))
-            return NULL;
+    /* Parse request or status line */
+    if (is_next_sip_version(scanner)) {
+        msg = pjsip_msg_create(pool, PJSIP_RESPONSE_MSG);
+        int_parse_status_line( scanner, &msg->line.status );
+    } else {
+        msg = pjsip_msg_create(pool, PJSIP_REQUEST_MSG);
+        int_parse_req_line(scanner, pool, &msg->line.req );
+    }
 
-        /* Parse request or status line */
-        if (is_next_sip_version(scanner)) {
-            msg = pjsip_msg_create(pool, PJSIP_RESPONSE_MSG);
-            int_parse_status_line( scanner, &msg->line.status );
-        } else {
-            msg = pjsip_msg_create(pool, PJSIP_REQUEST_MSG);
-            int_parse_req_line(scanner, pool, &msg->line.req );
+    if (PARSE_FAILED(scanner)) {
+        pj_str_t line_name;
+
+        if (msg->type == PJSIP_REQUEST_MSG)
+            line_name = pj_str("Request Line");
+        else
+            line_name = pj_str("Status Line");
+
+        report_parse_error(scanner, pool, err_list, &line_name);
+        return NULL;
+    }
+
+    /* Parse headers. */
+    do {
+        const handler_rec *rec;
+        pjsip_hdr *hdr = NULL;
+
+        /* Get hname. */
+        pj_scan_get( scanner, &pconst.pjsip_TOKEN_SPEC, &hname);
+        if (pj_scan_get_char( scanner ) != ':') {
+            pj_scan_syntax_err(scanner);
         }
 
-        parsing_headers = PJ_TRUE;
+        /* Find handler. */
+        rec = PARSE_FAILED(scanner) ? NULL : find_handler_rec(&hname);
 
-parse_headers:
-        /* Parse headers. */
-        do {
-            pjsip_parse_hdr_func * func;
-            pjsip_hdr *hdr = NULL;
+        /* Call the handler if found.
+         * If no handler is found, then treat the header as generic
+         * hname/hvalue pair.
+         */
+        if (PARSE_FAILED(scanner)) {
+            ;   /* Error in header name */
 
-            /* Init hname just in case parsing fails.
-             * Ref: PROTOS #2412
-             */
-            hname.slen = 0;
-            
-            /* Get hname. */
-            pj_scan_get( scanner, &pconst.pjsip_TOKEN_SPEC, &hname);
-            if (pj_scan_get_char( scanner ) != ':') {
-                PJ_THROW(PJSIP_SYN_ERR_EXCEPTION);
-            }
-            
-            /* Find handler. */
-            func = find_handler(&hname);
-            
-            /* Call the handler if found.
-             * If no handler is found, then treat the header as generic
-             * hname/hvalue pair.
+        } else if (rec && ctx->rdata &&
+                   pjsip_cfg()->endpt.lazy_hdr_parsing &&
+                   rec->name_idx >= 0 && !is_eager_handler(rec->handler))
+        {
+            /* Just save the value, the header will be parsed when
+             * it's looked up.
              */
-            if (func) {
-                hdr = (*func)(ctx);
+            hdr = (pjsip_hdr*)create_lazy_hdr(ctx, rec);
 
-                /* Note:
-                 *  hdr MAY BE NULL, if parsing does not yield a new header
-                 *  instance, e.g. the values have been added to existing
-                 *  header. See https://github.com/pjsip/pjproject/issues/940
-                 */
+        } else if (rec) {
+            hdr = call_hdr_handler(rec->handler, rec->nothrow, ctx);
 
-                /* Check if we've just parsed a Content-Type header. 
-                 * We will check for a message body if we've got Content-Type 
-                 * header.
-                 */
-                if (hdr && hdr->type == PJSIP_H_CONTENT_TYPE) {
-                    ctype_hdr = (pjsip_ctype_hdr*)hdr;
-                }
-
-            } else {
-                hdr = parse_hdr_generic_string(ctx);
-                hdr->name = hdr->sname = hname;
-            }
-            
-            /* Single parse of header line can produce multiple headers.
-             * For example, if one Contact: header contains Contact list
-             * separated by comma, then these Contacts will be split into
-             * different Contact headers.
-             * So here we must insert list instead of just insert one header.
+            /* Note:
+             *  hdr MAY BE NULL, if parsing does not yield a new header
+             *  instance, e.g. the values have been added to existing
+             *  header. See https://github.com/pjsip/pjproject/issues/940
              */
-            if (hdr)
-                pj_list_insert_nodes_before(&msg->hdr, hdr);
-            
-            /* Parse until EOF or an empty line is found. */
-        } while (!pj_scan_is_eof(scanner) && !IS_NEWLINE(*scanner->curptr));
-        
-        parsing_headers = PJ_FALSE;
 
-        /* If empty line is found, eat it. */
-        if (!pj_scan_is_eof(scanner)) {
-            if (IS_NEWLINE(*scanner->curptr)) {
-                pj_scan_get_newline(scanner);
-            }
+        } else {
+            hdr = parse_hdr_generic_string(ctx);
+            hdr->name = hdr->sname = hname;
         }
 
-        /* If we have Content-Type header, treat the rest of the message 
-         * as body.
-         */
-        if (ctype_hdr && scanner->curptr!=scanner->end) {
-            /* New: if Content-Type indicates that this is a multipart
-             * message body, parse it.
+        if (PARSE_FAILED(scanner)) {
+            /* Skip until newline, and parse next header. The message
+             * is discarded if the error is in the last header.
              */
-            const pj_str_t STR_MULTIPART = { "multipart", 9 };
-            pjsip_msg_body *body;
+            report_parse_error(scanner, pool, err_list, &hname);
+            skip_hdr_on_error(scanner, skip_ws);
 
-            if (pj_stricmp(&ctype_hdr->media.type, &STR_MULTIPART)==0) {
-                body = pjsip_multipart_parse(pool, scanner->curptr,
-                                             scanner->end - scanner->curptr,
-                                             &ctype_hdr->media, 0);
-            } else {
-                body = PJ_POOL_ALLOC_T(pool, pjsip_msg_body);
-                pjsip_media_type_cp(pool, &body->content_type,
-                                    &ctype_hdr->media);
-
-                body->data = scanner->curptr;
-                body->len = (unsigned)(scanner->end - scanner->curptr);
-                body->print_body = &pjsip_print_text_body;
-                body->clone_data = &pjsip_clone_text_data;
-            }
+            if (pj_scan_is_eof(scanner) || IS_NEWLINE(*scanner->curptr))
+                return NULL;
 
-            msg->body = body;
+            continue;
         }
-    }
-    PJ_CATCH_ANY 
-    {
-        /* Exception was thrown during parsing. 
-         * Skip until newline, and parse next header. 
+
+        /* Check if we've just parsed a Content-Type header. 
+         * We will check for a message body if we've got Content-Type 
+         * header.
          */
-        if (err_list) {
-            pjsip_parser_err_report *err_info;
-            
-            err_info = PJ_POOL_ALLOC_T(pool, pjsip_parser_err_report);
-            err_info->except_code = PJ_GET_EXCEPTION();
-            err_info->line = scanner->line;
-            /* Scanner's column is zero based, so add 1 */
-            err_info->col = pj_scan_get_col(scanner) + 1;
-            if (parsing_headers)
-                err_info->hname = hname;
-            else if (msg && msg->type == PJSIP_REQUEST_MSG)
-                err_info->hname = pj_str("Request Line");
-            else if (msg && msg->type == PJSIP_RESPONSE_MSG)
-                err_info->hname = pj_str("Status Line");
-            else
-                err_info->hname.slen = 0;
-            
-            pj_list_insert_before(err_list, err_info);
+        if (hdr && hdr->type == PJSIP_H_CONTENT_TYPE) {
+            ctype_hdr = (pjsip_ctype_hdr*)hdr;
         }
+
+        /* Single parse of header line can produce multiple headers.
+         * For example, if one Contact: header contains Contact list
+         * separated by comma, then these Contacts will be split into
+         * different Contact headers.
+         * So here we must insert list instead of just insert one header.
+         */
+        if (hdr)
+            pj_list_insert_nodes_before(&msg->hdr, hdr);
         
-        if (parsing_headers) {
-            if (!pj_scan_is_eof(scanner)) {
-                /* Skip until next line.
-                 * Watch for header continuation.
-                 */
-                do {
-                    pj_scan_skip_line(scanner);
-                } while (IS_SPACE(*scanner->curptr));
-            }
+        /* Parse until EOF or an empty line is found. */
+    } while (!pj_scan_is_eof(scanner) && !IS_NEWLINE(*scanner->curptr));
+    
+    /* If empty line is found, eat it. */
+    if (!pj_scan_is_eof(scanner)) {
+        if (IS_NEWLINE(*scanner->curptr)) {
+            pj_scan_get_newline(scanner);
+        }
+    }
 
-            /* Restore flag. Flag may be set in int_parse_sip_url() */
-            scanner->skip_ws = PJ_SCAN_AUTOSKIP_WS_HEADER;
+    /* If we have Content-Type header, treat the rest of the message 
+     * as body.
+     */
+    if (ctype_hdr && scanner->curptr!=scanner->end) {
+        /* New: if Content-Type indicates that this is a multipart
+         * message body, parse it.
+         */
+        const pj_str_t STR_MULTIPART = { "multipart", 9 };
+        pjsip_msg_body *body;
 
-            /* Continue parse next header, if any. */
-            if (!pj_scan_is_eof(scanner) && !IS_NEWLINE(*scanner->curptr)) {
-                goto retry_parse;
-            }
+        if (pj_stricmp(&ctype_hdr->media.type, &STR_MULTIPART)==0) {
+            body = pjsip_multipart_parse(pool, scanner->curptr,
+                                         scanner->end - scanner->curptr,
+                                         &ctype_hdr->media, 0);
+        } else {
+            body = PJ_POOL_ALLOC_T(pool, pjsip_msg_body);
+            pjsip_media_type_cp(pool, &body->content_type,
+                                &ctype_hdr->media);
+
+            body->data = scanner->curptr;
+            body->len = (unsigned)(scanner->end - scanner->curptr);
+            body->print_body = &pjsip_print_text_body;
+            body->clone_data = &pjsip_clone_text_data;
         }
 
-        msg = NULL;
+        msg->body = body;
     }
-    PJ_END;
 
     return msg;
 }
@@ -1233,7 +1539,9 @@ static void parse_param_imp( pj_scanner *scanner, pj_pool_t *pool,
             /* pvalue can be a quoted string. */
             if (*scanner->curptr == '"') {
                 pj_scan_get_quote( scanner, '"', '"', pvalue);
-                if (option & PJSIP_PARSE_REMOVE_QUOTE) {
+                if ((option & PJSIP_PARSE_REMOVE_QUOTE) &&
+                    !PARSE_FAILED(scanner))
+                {
                     pvalue->ptr++;
                     pvalue->slen -= 2;
                 }
@@ -1363,7 +1671,8 @@ static void int_parse_uri_host_port( pj_scanner *scanner,
         pj_str_t port;
         pj_scan_get_char(scanner);
         pj_scan_get(scanner, &pconst.pjsip_DIGIT_SPEC, &port);
-        strtoi_validate(&port, PJSIP_MIN_PORT, PJSIP_MAX_PORT, p_port);
+        strtoi_validate(scanner, &port, PJSIP_MIN_PORT, PJSIP_MAX_PORT,
+                        p_port);
     } else {
         *p_port = 0;
     }
@@ -1430,12 +1739,13 @@ static pjsip_uri *int_parse_uri_or_name_addr( pj_scanner *scanner, pj_pool_t *po
 
             if (func == NULL) {
                 /* Unsupported URI scheme */
-                PJ_THROW(PJSIP_SYN_ERR_EXCEPTION);
+                pj_scan_syntax_err(scanner);
+                return NULL;
             }
 
             uri = (pjsip_uri*)
-                  (*func)(scanner, pool, 
-                          (opt & PJSIP_PARSE_URI_IN_FROM_TO_HDR)==0);
+                  call_uri_parser(func, scanner, pool, 
+                                  (opt & PJSIP_PARSE_URI_IN_FROM_TO_HDR)==0);
 
 
         } else {
@@ -1478,17 +1788,19 @@ static pjsip_uri *int_parse_uri(pj_scanner *scanner, pj_pool_t *pool,
         /* Get scheme. */
         colon = pj_scan_peek(scanner, &pconst.pjsip_TOKEN_SPEC, &scheme);
         if (colon != ':') {
-            PJ_THROW(PJSIP_SYN_ERR_EXCEPTION);
+            pj_scan_syntax_err(scanner);
+            return NULL;
         }
 
         func = find_uri_handler(&scheme);
         if (func)  {
-            return (pjsip_uri*)(*func)(scanner, pool, parse_params);
+            return (pjsip_uri*)call_uri_parser(func, scanner, pool,
+                                               parse_params);
 
         } else {
             /* Unsupported URI scheme */
-            PJ_THROW(PJSIP_SYN_ERR_EXCEPTION);
-            UNREACHED({ return NULL; /* Not reached. */ })
+            pj_scan_syntax_err(scanner);
+            return NULL;
         }
 
     /*
@@ -1512,22 +1824,23 @@ static void* int_parse_sip_url( pj_scanner *scanner,
     pj_scan_get(scanner, &pconst.pjsip_TOKEN_SPEC, &scheme);
     colon = pj_scan_get_char(scanner);
     if (colon != ':') {
-        PJ_THROW(PJSIP_SYN_ERR_EXCEPTION);
+        pj_scan_syntax_err(scanner);
     }
 
-    if (parser_stricmp(scheme, pconst.pjsip_SIP_STR)==0) {
+    if (PARSE_FAILED(scanner)) {
+        scanner->skip_ws = skip_ws;
+        return NULL;
+
+    } else if (parser_stricmp(scheme, pconst.pjsip_SIP_STR)==0) {
         url = pjsip_sip_uri_create(pool, 0);
 
     } else if (parser_stricmp(scheme, pconst.pjsip_SIPS_STR)==0) {
         url = pjsip_sip_uri_create(pool, 1);
 
     } else {
-        PJ_THROW(PJSIP_SYN_ERR_EXCEPTION);
-        /* should not reach here */
-        UNREACHED({
-            pj_assert(0);
-            return 0;
-        })
+        pj_scan_syntax_err(scanner);
+        scanner->skip_ws = skip_ws;
+        return NULL;
     }
 
     if (int_is_next_user(scanner)) {
@@ -1564,7 +1877,7 @@ static void* int_parse_sip_url( pj_scanner *scanner,
             url->transport_param = pvalue;
 
         } else if (!parser_stricmp(pname, pconst.pjsip_TTL_STR) && pvalue.slen) {
-            strtoi_validate(&pvalue, PJSIP_MIN_TTL, PJSIP_MAX_TTL,
+            strtoi_validate(scanner, &pvalue, PJSIP_MIN_TTL, PJSIP_MAX_TTL,
                             &url->ttl_param);
         } else if (!parser_stricmp(pname, pconst.pjsip_MADDR_STR) && pvalue.slen) {
             url->maddr_param = pvalue;
@@ -1607,6 +1920,9 @@ static pjsip_name_addr *int_parse_name_addr( pj_scanner *scanner,
 
     if (*scanner->curptr == '"') {
         pj_scan_get_quote( scanner, '"', '"', &name_addr->display);
+        if (PARSE_FAILED(scanner))
+            return name_addr;
+
         /* Trim the leading and ending quote */
         name_addr->display.ptr++;
         name_addr->display.slen -= 2;
@@ -1640,12 +1956,13 @@ static pjsip_name_addr *int_parse_name_addr( pj_scanner *scanner,
          * Allowing (invalid) name-addr to pass URI verification will
          * cause us to send invalid URI to the wire.
          */
-        PJ_THROW( PJSIP_SYN_ERR_EXCEPTION);
+        pj_scan_syntax_err(scanner);
+        return name_addr;
     }
     name_addr->uri = int_parse_uri( scanner, pool, PJ_TRUE );
     if (has_bracket) {
         if (pj_scan_get_char(scanner) != '>')
-            PJ_THROW( PJSIP_SYN_ERR_EXCEPTION);
+            pj_scan_syntax_err(scanner);
     }
 
     return name_addr;
@@ -1669,7 +1986,7 @@ static void* int_parse_other_uri(pj_scanner *scanner,
     
     pj_scan_get(scanner, &pc->pjsip_TOKEN_SPEC, &uri->scheme);
     if (pj_scan_get_char(scanner) != ':') {
-        PJ_THROW(PJSIP_SYN_ERR_EXCEPTION);
+        pj_scan_syntax_err(scanner);
     }
     
     pj_scan_get(scanner, &pc->pjsip_OTHER_URI_CONTENT, &uri->content);
@@ -1701,8 +2018,8 @@ static void int_parse_status_line( pj_scanner *scanner,
 
     parse_sip_version(scanner);
     pj_scan_get( scanner, &pconst.pjsip_DIGIT_SPEC, &token);
-    strtoi_validate(&token, PJSIP_MIN_STATUS_CODE, PJSIP_MAX_STATUS_CODE,
-                    &status_line->code);
+    strtoi_validate(scanner, &token, PJSIP_MIN_STATUS_CODE,
+                    PJSIP_MAX_STATUS_CODE, &status_line->code);
     if (*scanner->curptr != '\r' && *scanner->curptr != '\n')
         pj_scan_get( scanner, &pconst.pjsip_NOT_NEWLINE, &status_line->reason);
     else
@@ -1718,23 +2035,18 @@ PJ_DEF(pj_status_t) pjsip_parse_status_line( char *buf, pj_size_t size,
                                              pjsip_status_line *status_line)
 {
     pj_scanner scanner;
-    PJ_USE_EXCEPTION;
 
     pj_bzero(status_line, sizeof(*status_line));
-    pj_scan_init(&scanner, buf, size, PJ_SCAN_AUTOSKIP_WS_HEADER, 
-                 &on_syntax_error);
+    pj_scan_init(&scanner, buf, size, PJ_SCAN_AUTOSKIP_WS_HEADER, NULL);
 
-    PJ_TRY {
-        int_parse_status_line(&scanner, status_line);
-    } 
-    PJ_CATCH_ANY {
+    int_parse_status_line(&scanner, status_line);
+    if (PARSE_FAILED(&scanner)) {
         /* Tolerate the error if it is caused only by missing newline */
         if (status_line->code == 0 && status_line->reason.slen == 0) {
             pj_scan_fini(&scanner);
             return PJSIP_EINVALIDMSG;
         }
     }
-    PJ_END;
 
     pj_scan_fini(&scanner);
     return PJ_SUCCESS;
@@ -1774,12 +2086,14 @@ static void parse_generic_array_hdr( pjsip_generic_array_hdr *hdr,
 
     if (hdr->count >= PJ_ARRAY_SIZE(hdr->values)) {
         /* Too many elements */
-        on_syntax_error(scanner);
+        pj_scan_syntax_err(scanner);
         return;
     }
 
     pj_scan_get( scanner, &pconst.pjsip_NOT_COMMA_OR_NEWLINE, 
                  &hdr->values[hdr->count]);
+    if (PARSE_FAILED(scanner))
+        return;
     hdr->count++;
 
     while ((hdr->count < PJSIP_GENERIC_ARRAY_MAX_COUNT) &&
@@ -1788,6 +2102,8 @@ static void parse_generic_array_hdr( pjsip_generic_array_hdr *hdr,
         pj_scan_get_char(scanner);
         pj_scan_get( scanner, &pconst.pjsip_NOT_COMMA_OR_NEWLINE, 
                      &hdr->values[hdr->count]);
+        if (PARSE_FAILED(scanner))
+            return;
         hdr->count++;
     }
 
@@ -1869,7 +2185,7 @@ static pjsip_hdr* parse_hdr_call_id(pjsip_parse_ctx *ctx)
     pj_scan_get( ctx->scanner, &pconst.pjsip_NOT_NEWLINE, &hdr->id);
     parse_hdr_end(ctx->scanner);
 
-    if (ctx->rdata)
+    if (ctx->rdata && !PARSE_FAILED(ctx->scanner))
         ctx->rdata->msg_info.cid = hdr;
 
     return (pjsip_hdr*)hdr;
@@ -1887,16 +2203,16 @@ static void int_parse_contact_param( pjsip_contact_hdr *hdr,
         if (!parser_stricmp(pname, pconst.pjsip_Q_STR) && pvalue.slen) {
             char *dot_pos = (char*) pj_memchr(pvalue.ptr, '.', pvalue.slen);
             if (!dot_pos) {
-                strtoi_validate(&pvalue, PJSIP_MIN_Q1000, PJSIP_MAX_Q1000,
-                                &hdr->q1000);
+                strtoi_validate(scanner, &pvalue, PJSIP_MIN_Q1000,
+                                PJSIP_MAX_Q1000, &hdr->q1000);
                 hdr->q1000 *= 1000;
             } else {
                 pj_str_t tmp = pvalue;
                 unsigned long qval_frac;
 
                 tmp.slen = dot_pos - pvalue.ptr;
-                strtoi_validate(&tmp, PJSIP_MIN_Q1000, PJSIP_MAX_Q1000,
-                                &hdr->q1000);
+                strtoi_validate(scanner, &tmp, PJSIP_MIN_Q1000,
+                                PJSIP_MAX_Q1000, &hdr->q1000);
                 hdr->q1000 *= 1000;
 
                 pvalue.slen = (pvalue.ptr+pvalue.slen) - (dot_pos+1);
@@ -1906,7 +2222,8 @@ static void int_parse_contact_param( pjsip_contact_hdr *hdr,
                 }
                 qval_frac = pj_strtoul_mindigit(&pvalue, 3);
                 if ((unsigned)hdr->q1000 > (PJ_MAXINT32 - qval_frac)) {
-                    PJ_THROW(PJSIP_SYN_ERR_EXCEPTION);
+                    pj_scan_syntax_err(scanner);
+                    return;
                 }
                 hdr->q1000 += qval_frac;
             }    
@@ -1980,7 +2297,7 @@ static pjsip_hdr* parse_hdr_content_len( pjsip_parse_ctx *ctx )
     hdr->len = pj_strtoul(&digit);
     parse_hdr_end(ctx->scanner);
 
-    if (ctx->rdata)
+    if (ctx->rdata && !PARSE_FAILED(ctx->scanner))
         ctx->rdata->msg_info.clen = hdr;
 
     return (pjsip_hdr*)hdr;
@@ -2008,7 +2325,7 @@ static pjsip_hdr* parse_hdr_content_type( pjsip_parse_ctx *ctx )
 
     parse_hdr_end(ctx->scanner);
 
-    if (ctx->rdata)
+    if (ctx->rdata && !PARSE_FAILED(ctx->scanner))
         ctx->rdata->msg_info.ctype = hdr;
 
     return (pjsip_hdr*)hdr;
@@ -2022,7 +2339,8 @@ static pjsip_hdr* parse_hdr_cseq( pjsip_parse_ctx *ctx )
     int cseq_val = 0;
 
     pj_scan_get( ctx->scanner, &pconst.pjsip_DIGIT_SPEC, &cseq);
-    strtoi_validate(&cseq, PJSIP_MIN_CSEQ, PJSIP_MAX_CSEQ, &cseq_val);
+    strtoi_validate(ctx->scanner, &cseq, PJSIP_MIN_CSEQ, PJSIP_MAX_CSEQ,
+                    &cseq_val);
 
     hdr = pjsip_cseq_hdr_create(ctx->pool);
     hdr->cseq = cseq_val;
@@ -2031,7 +2349,7 @@ static pjsip_hdr* parse_hdr_cseq( pjsip_parse_ctx *ctx )
     parse_hdr_end( ctx->scanner );
 
     pjsip_method_init_np(&hdr->method, &method);
-    if (ctx->rdata) {
+    if (ctx->rdata && !PARSE_FAILED(ctx->scanner)) {
         ctx->rdata->msg_info.cseq = hdr;
     }
 
@@ -2079,7 +2397,7 @@ static pjsip_hdr* parse_hdr_from( pjsip_parse_ctx *ctx )
 {
     pjsip_from_hdr *hdr = pjsip_from_hdr_create(ctx->pool);
     parse_hdr_fromto(ctx->scanner, ctx->pool, hdr);
-    if (ctx->rdata)
+    if (ctx->rdata && !PARSE_FAILED(ctx->scanner))
         ctx->rdata->msg_info.from = hdr;
 
     return (pjsip_hdr*)hdr;
@@ -2115,14 +2433,17 @@ static pjsip_hdr* parse_hdr_retry_after(pjsip_parse_ctx *ctx)
     hdr = pjsip_retry_after_hdr_create(ctx->pool, 0);
     
     pj_scan_get(scanner, &pconst.pjsip_DIGIT_SPEC, &tmp);
-    strtoi_validate(&tmp, PJSIP_MIN_RETRY_AFTER, PJSIP_MAX_RETRY_AFTER,
-                    &hdr->ivalue);
+    strtoi_validate(scanner, &tmp, PJSIP_MIN_RETRY_AFTER,
+                    PJSIP_MAX_RETRY_AFTER, &hdr->ivalue);
 
     while (!pj_scan_is_eof(scanner) && *scanner->curptr!='\r' &&
            *scanner->curptr!='\n')
     {
         if (*scanner->curptr=='(') {
             pj_scan_get_quote(scanner, '(', ')', &hdr->comment);
+            if (PARSE_FAILED(scanner))
+                break;
+
             /* Trim the leading and ending parens */
             hdr->comment.ptr++;
             hdr->comment.slen -= 2;
@@ -2131,7 +2452,7 @@ static pjsip_hdr* parse_hdr_retry_after(pjsip_parse_ctx *ctx)
             int_parse_param(scanner, ctx->pool, &prm->name, &prm->value, 0);
             pj_list_push_back(&hdr->param, prm);
         } else {
-            on_syntax_error(scanner);
+            pj_scan_syntax_err(scanner);
         }
     }
 
@@ -2164,7 +2485,7 @@ static pjsip_hdr* parse_hdr_to( pjsip_parse_ctx *ctx )
     pjsip_to_hdr *hdr = pjsip_to_hdr_create(ctx->pool);
     parse_hdr_fromto(ctx->scanner, ctx->pool, hdr);
 
-    if (ctx->rdata)
+    if (ctx->rdata && !PARSE_FAILED(ctx->scanner))
         ctx->rdata->msg_info.to = hdr;
 
     return (pjsip_hdr*)hdr;
@@ -2208,7 +2529,7 @@ static void int_parse_via_param( pjsip_via_hdr *hdr, pj_scanner *scanner,
             hdr->branch_param = pvalue;
 
         } else if (!parser_stricmp(pname, pconst.pjsip_TTL_STR) && pvalue.slen) {
-            strtoi_validate(&pvalue, PJSIP_MIN_TTL, PJSIP_MAX_TTL,
+            strtoi_validate(scanner, &pvalue, PJSIP_MIN_TTL, PJSIP_MAX_TTL,
                             &hdr->ttl_param);
             
         } else if (!parser_stricmp(pname, pconst.pjsip_MADDR_STR) && pvalue.slen) {
@@ -2219,8 +2540,8 @@ static void int_parse_via_param( pjsip_via_hdr *hdr, pj_scanner *scanner,
 
         } else if (!parser_stricmp(pname, pconst.pjsip_RPORT_STR)) {
             if (pvalue.slen) {
-                strtoi_validate(&pvalue, PJSIP_MIN_PORT, PJSIP_MAX_PORT,
-                                &hdr->rport_param);
+                strtoi_validate(scanner, &pvalue, PJSIP_MIN_PORT,
+                                PJSIP_MAX_PORT, &hdr->rport_param);
             } else
                 hdr->rport_param = 0;
         } else {
@@ -2239,7 +2560,7 @@ static pjsip_hdr* parse_hdr_max_forwards( pjsip_parse_ctx *ctx )
     hdr = pjsip_max_fwd_hdr_create(ctx->pool, 0);
     parse_generic_int_hdr(hdr, ctx->scanner);
 
-    if (ctx->rdata)
+    if (ctx->rdata && !PARSE_FAILED(ctx->scanner))
         ctx->rdata->msg_info.max_fwd = hdr;
 
     return (pjsip_hdr*)hdr;
@@ -2292,7 +2613,8 @@ static pjsip_hdr* parse_hdr_rr( pjsip_parse_ctx *ctx)
     } while (1);
     parse_hdr_end(scanner);
 
-    if (ctx->rdata && ctx->rdata->msg_info.record_route==NULL)
+    if (ctx->rdata && !PARSE_FAILED(scanner) &&
+        ctx->rdata->msg_info.record_route==NULL)
         ctx->rdata->msg_info.record_route = first;
 
     return (pjsip_hdr*)first;
@@ -2320,7 +2642,8 @@ static pjsip_hdr* parse_hdr_route( pjsip_parse_ctx *ctx )
     } while (1);
     parse_hdr_end(scanner);
 
-    if (ctx->rdata && ctx->rdata->msg_info.route==NULL)
+    if (ctx->rdata && !PARSE_FAILED(scanner) &&
+        ctx->rdata->msg_info.route==NULL)
         ctx->rdata->msg_info.route = first;
 
     return (pjsip_hdr*)first;
@@ -2341,7 +2664,7 @@ static pjsip_hdr* parse_hdr_via( pjsip_parse_ctx *ctx )
 
         parse_sip_version(scanner);
         if (pj_scan_get_char(scanner) != '/')
-            on_syntax_error(scanner);
+            pj_scan_syntax_err(scanner);
 
         pj_scan_get( scanner, &pconst.pjsip_TOKEN_SPEC, &hdr->transport);
         int_parse_host(scanner, &hdr->sent_by.host);
@@ -2350,7 +2673,7 @@ static pjsip_hdr* parse_hdr_via( pjsip_parse_ctx *ctx )
             pj_str_t digit;
             pj_scan_get_char(scanner);
             pj_scan_get(scanner, &pconst.pjsip_DIGIT_SPEC, &digit);
-            strtoi_validate(&digit, PJSIP_MIN_PORT, PJSIP_MAX_PORT,
+            strtoi_validate(scanner, &digit, PJSIP_MIN_PORT, PJSIP_MAX_PORT,
                             &hdr->sent_by.port);
         }
         
@@ -2371,7 +2694,8 @@ static pjsip_hdr* parse_hdr_via( pjsip_parse_ctx *ctx )
 
     parse_hdr_end(scanner);
 
-    if (ctx->rdata && ctx->rdata->msg_info.via == NULL)
+    if (ctx->rdata && !PARSE_FAILED(scanner) &&
+        ctx->rdata->msg_info.via == NULL)
         ctx->rdata->msg_info.via = first;
 
     return (pjsip_hdr*)first;
@@ -2388,6 +2712,156 @@ static pjsip_hdr* parse_hdr_generic_string( pjsip_parse_ctx *ctx )
 
 }
 
+/* Check if the handler must be called when the message is parsed, i.e.
+ * it fills in rdata->msg_info.
+ */
+static pj_bool_t is_eager_handler(pjsip_parse_hdr_func *func)
+{
+    return func == &parse_hdr_call_id || func == &parse_hdr_content_len ||
+           func == &parse_hdr_content_type || func == &parse_hdr_cseq ||
+           func == &parse_hdr_from || func == &parse_hdr_to ||
+           func == &parse_hdr_require || func == &parse_hdr_supported ||
+           func == &parse_hdr_max_forwards || func == &parse_hdr_rr ||
+           func == &parse_hdr_route || func == &parse_hdr_via;
+}
+
+/* Create a header whose parsing is deferred. */
+static lazy_hdr* create_lazy_hdr(pjsip_parse_ctx *ctx,
+                                 const handler_rec *rec)
+{
+    lazy_hdr *hdr = PJ_POOL_ZALLOC_T(ctx->pool, lazy_hdr);
+    hdr_name_rec *names = &hdr_names[rec->name_idx];
+
+    hdr->type = PJSIP_H_OTHER;
+    hdr->name = pj_str(names->name);
+    hdr->sname = pj_str(names->sname);
+    hdr->vptr = &lazy_hdr_vptr;
+    pj_list_init(hdr);
+    hdr->handler = rec->handler;
+    hdr->nothrow = rec->nothrow;
+    hdr->pool = ctx->pool;
+
+    parse_generic_string_hdr((pjsip_generic_string_hdr*)hdr, ctx);
+    return hdr;
+}
+
+static int lazy_hdr_print(lazy_hdr *hdr, char *buf, pj_size_t size)
+{
+    char *p = buf;
+    const pj_str_t *hname = pjsip_cfg()->endpt.use_compact_form? 
+                            &hdr->sname : &hdr->name;
+    
+    if ((pj_ssize_t)size < hname->slen + hdr->hvalue.slen + 5)
+        return -1;
+
+    pj_memcpy(p, hname->ptr, hname->slen);
+    p += hname->slen;
+    *p++ = ':';
+    *p++ = ' ';
+    pj_memcpy(p, hdr->hvalue.ptr, hdr->hvalue.slen);
+    p += hdr->hvalue.slen;
+    *p = '\0';
+
+    return (int)(p - buf);
+}
+
+static lazy_hdr* lazy_hdr_clone(pj_pool_t *pool, const lazy_hdr *rhs)
+{
+    lazy_hdr *hdr = PJ_POOL_ZALLOC_T(pool, lazy_hdr);
+
+    hdr->type = rhs->type;
+    pj_strdup(pool, &hdr->name, &rhs->name);
+    pj_strdup(pool, &hdr->sname, &rhs->sname);
+    hdr->vptr = rhs->vptr;
+    pj_list_init(hdr);
+    pj_strdup(pool, &hdr->hvalue, &rhs->hvalue);
+    hdr->handler = rhs->handler;
+    hdr->nothrow = rhs->nothrow;
+    hdr->pool = pool;
+    return hdr;
+}
+
+static lazy_hdr* lazy_hdr_shallow_clone(pj_pool_t *pool, const lazy_hdr *rhs)
+{
+    lazy_hdr *hdr = PJ_POOL_ALLOC_T(pool, lazy_hdr);
+    pj_memcpy(hdr, rhs, sizeof(*hdr));
+    hdr->pool = pool;
+    return hdr;
+}
+
+/* Parse a deferred header and put the result in its place in the list. */
+static pjsip_hdr* parse_lazy_hdr(lazy_hdr *lhdr)
+{
+    pj_scanner scanner;
+    pjsip_parse_ctx context;
+    pj_str_t value;
+    pjsip_hdr *hdr = NULL;
+
+    /* Scanner needs NULL terminated input */
+    pj_strdup_with_null(lhdr->pool, &value, &lhdr->hvalue);
+    pj_scan_init(&scanner, value.ptr, value.slen,
+                 PJ_SCAN_AUTOSKIP_WS_HEADER, NULL);
+
+    context.scanner = &scanner;
+    context.pool = lhdr->pool;
+    context.rdata = NULL;
+
+    hdr = call_hdr_handler(lhdr->handler, lhdr->nothrow, &context);
+    if (PARSE_FAILED(&scanner))
+        hdr = NULL;
+
+    pj_scan_fini(&scanner);
+
+    if (hdr == NULL) {
+        /* Keep the value as generic string header, so it can still be
+         * found and printed.
+         */
+        PJ_LOG(4,(THIS_FILE, "Error parsing %.*s header value \"%.*s\"",
+                  (int)lhdr->name.slen, lhdr->name.ptr,
+                  (int)lhdr->hvalue.slen, lhdr->hvalue.ptr));
+        hdr = (pjsip_hdr*)
+              pjsip_generic_string_hdr_create(lhdr->pool, &lhdr->name,
+                                              &lhdr->hvalue);
+        hdr->sname = lhdr->sname;
+    }
+
+    pj_list_insert_nodes_before(lhdr, hdr);
+    pj_list_erase(lhdr);
+
+    return hdr;
+}
+
+/* Parse a deferred header if it matches the type or name. */
+PJ_DEF(pjsip_hdr*) pjsip_parse_lazy_hdr( pjsip_hdr *hdr,
+                                         pjsip_hdr_e type,
+                                         const pj_str_t *name,
+                                         const pj_str_t *sname)
+{
+    lazy_hdr *lhdr = (lazy_hdr*)hdr;
+
+    PJ_ASSERT_RETURN(hdr, NULL);
+
+    if (hdr->vptr != &lazy_hdr_vptr)
+        return NULL;
+
+    if (name || sname) {
+        if ((!name || pj_stricmp(&lhdr->name, name) != 0) &&
+            (!sname || (pj_stricmp(&lhdr->name, sname) != 0 &&
+                        pj_stricmp(&lhdr->sname, sname) != 0)))
+        {
+            return NULL;
+        }
+    } else {
+        if (type >= PJSIP_H_OTHER ||
+            pj_stricmp2(&lhdr->name, pjsip_hdr_names[type].name) != 0)
+        {
+            return NULL;
+        }
+    }
+
+    return parse_lazy_hdr(lhdr);
+}
+
 /* Public function to parse a header value. */
 PJ_DEF(void*) pjsip_parse_hdr( pj_pool_t *pool, const pj_str_t *hname,
                                char *buf, pj_size_t size, int *parsed_len )
@@ -2395,31 +2869,29 @@ PJ_DEF(void*) pjsip_parse_hdr( pj_pool_t *pool, const pj_str_t *hname,
     pj_scanner scanner;
     pjsip_hdr *hdr = NULL;
     pjsip_parse_ctx context;
-    PJ_USE_EXCEPTION;
+    const handler_rec *rec;
 
-    pj_scan_init(&scanner, buf, size, PJ_SCAN_AUTOSKIP_WS_HEADER, 
-                 &on_syntax_error);
+    pj_scan_init(&scanner, buf, size, PJ_SCAN_AUTOSKIP_WS_HEADER, NULL);
 
     context.scanner = &scanner;
     context.pool = pool;
     context.rdata = NULL;
 
-    PJ_TRY {
-        pjsip_parse_hdr_func *func = find_handler(hname);
-        if (func) {
-            hdr = (*func)(&context);
-        } else {
-            hdr = parse_hdr_generic_string(&context);
-            hdr->type = PJSIP_H_OTHER;
-            pj_strdup(pool, &hdr->name, hname);
-            hdr->sname = hdr->name;
-        }
+    rec = find_handler_rec(hname);
+    if (rec) {
+        hdr = call_hdr_handler(rec->handler, rec->nothrow, &context);
+    } else {
+        hdr = parse_hdr_generic_string(&context);
+        hdr->type = PJSIP_H_OTHER;
+        pj_strdup(pool, &hdr->name, hname);
+        hdr->sname = hdr->name;
+    }
 
-    } 
-    PJ_CATCH_ANY {
+    if (PARSE_FAILED(&scanner)) {
+        /* Move back to where the error occurred */
+        pj_scan_clear_error(&scanner);
         hdr = NULL;
     }
-    PJ_END
 
     if (parsed_len) {
         *parsed_len = (unsigned)(scanner.curptr - scanner.begin);
@@ -2440,99 +2912,74 @@ PJ_DEF(pj_status_t) pjsip_parse_headers( pj_pool_t *pool, char *input,
     pj_scanner scanner;
     pjsip_parse_ctx ctx;
 
-    PJ_USE_EXCEPTION;
-
-    pj_scan_init(&scanner, input, size, PJ_SCAN_AUTOSKIP_WS_HEADER,
-                 &on_syntax_error);
+    pj_scan_init(&scanner, input, size, PJ_SCAN_AUTOSKIP_WS_HEADER, NULL);
 
     pj_bzero(&ctx, sizeof(ctx));
     ctx.scanner = &scanner;
     ctx.pool = pool;
 
-retry_parse:
-    PJ_TRY
-    {
-        /* Parse headers. */
-        do {
-            pjsip_parse_hdr_func * func;
-            pjsip_hdr *hdr = NULL;
-
-            /* Init hname just in case parsing fails.
-             * Ref: PROTOS #2412
-             */
-            hname.slen = 0;
-
-            /* Get hname. */            
-            pj_scan_get( &scanner, &pconst.pjsip_TOKEN_SPEC, &hname);
-            if (pj_scan_get_char( &scanner ) != ':') {
-                PJ_THROW(PJSIP_SYN_ERR_EXCEPTION);
-            }
+    /* Parse headers. */
+    do {
+        const handler_rec *rec;
+        pjsip_hdr *hdr = NULL;
 
-            /* Find handler. */
-            func = find_handler(&hname);
+        /* Get hname. */            
+        pj_scan_get( &scanner, &pconst.pjsip_TOKEN_SPEC, &hname);
+        if (pj_scan_get_char( &scanner ) != ':') {
+            pj_scan_syntax_err(&scanner);
+        }
 
-            /* Call the handler if found.
-             * If no handler is found, then treat the header as generic
-             * hname/hvalue pair.
-             */
-            if (func) {
-                hdr = (*func)(&ctx);
+        /* Find handler and call it if found.
+         * If no handler is found, then treat the header as generic
+         * hname/hvalue pair.
+         */
+        if (!PARSE_FAILED(&scanner)) {
+            rec = find_handler_rec(&hname);
+            if (rec) {
+                hdr = call_hdr_handler(rec->handler, rec->nothrow, &ctx);
             } else {
                 hdr = parse_hdr_generic_string(&ctx);
                 hdr->name = hdr->sname = hname;
             }
+        }
 
-            /* Single parse of header line can produce multiple headers.
-             * For example, if one Contact: header contains Contact list
-             * separated by comma, then these Contacts will be split into
-             * different Contact headers.
-             * So here we must insert list instead of just insert one header.
-             */
-            if (hdr)
-                pj_list_insert_nodes_before(hlist, hdr);
+        if (PARSE_FAILED(&scanner)) {
+            pj_scan_clear_error(&scanner);
 
-            /* Parse until EOF or an empty line is found. */
-        } while (!pj_scan_is_eof(&scanner) && !IS_NEWLINE(*scanner.curptr));
+            PJ_LOG(4,(THIS_FILE, "Error parsing header: '%.*s' line %d col %d",
+                      (int)hname.slen, hname.ptr, scanner.line,
+                      pj_scan_get_col(&scanner)));
 
-        /* If empty line is found, eat it. */
-        if (!pj_scan_is_eof(&scanner)) {
-            if (IS_NEWLINE(*scanner.curptr)) {
-                pj_scan_get_newline(&scanner);
+            if ((options & STOP_ON_ERROR) == STOP_ON_ERROR) {
+                pj_scan_fini(&scanner);
+                return PJSIP_EINVALIDHDR;
             }
-        }
-    }
-    PJ_CATCH_ANY
-    {
-        PJ_LOG(4,(THIS_FILE, "Error parsing header: '%.*s' line %d col %d",
-                  (int)hname.slen, hname.ptr, scanner.line,
-                  pj_scan_get_col(&scanner)));
 
-        /* Exception was thrown during parsing. */
-        if ((options & STOP_ON_ERROR) == STOP_ON_ERROR) {
-            pj_scan_fini(&scanner);
-            return PJSIP_EINVALIDHDR;
-        }
+            /* Skip until newline, and parse next header. */
+            skip_hdr_on_error(&scanner, PJ_SCAN_AUTOSKIP_WS_HEADER);
 
-        /* Skip until newline, and parse next header. */
-        if (!pj_scan_is_eof(&scanner)) {
-            /* Skip until next line.
-             * Watch for header continuation.
-             */
-            do {
-                pj_scan_skip_line(&scanner);
-            } while (IS_SPACE(*scanner.curptr));
+            /* Continue parse next header, if any. */
+            continue;
         }
 
-        /* Restore flag. Flag may be set in int_parse_sip_url() */
-        scanner.skip_ws = PJ_SCAN_AUTOSKIP_WS_HEADER;
+        /* Single parse of header line can produce multiple headers.
+         * For example, if one Contact: header contains Contact list
+         * separated by comma, then these Contacts will be split into
+         * different Contact headers.
+         * So here we must insert list instead of just insert one header.
+         */
+        if (hdr)
+            pj_list_insert_nodes_before(hlist, hdr);
 
-        /* Continue parse next header, if any. */
-        if (!pj_scan_is_eof(&scanner) && !IS_NEWLINE(*scanner.curptr)) {
-            goto retry_parse;
-        }
+        /* Parse until EOF or an empty line is found. */
+    } while (!pj_scan_is_eof(&scanner) && !IS_NEWLINE(*scanner.curptr));
 
+    /* If empty line is found, eat it. */
+    if (!pj_scan_is_eof(&scanner)) {
+        if (IS_NEWLINE(*scanner.curptr)) {
+            pj_scan_get_newline(&scanner);
+        }
     }
-    PJ_END;
 
     return PJ_SUCCESS;
 }
@@ -66,15 +66,25 @@ static pj_status_t mod_tsx_layer_unload(void);
 static pj_bool_t   mod_tsx_layer_on_rx_request(pjsip_rx_data *rdata);
 static pj_bool_t   mod_tsx_layer_on_rx_response(pjsip_rx_data *rdata);
 
+/* Stripe of the transaction table. Transactions are distributed among
+ * the stripes by the hash value of the transaction key, and each stripe
+ * is protected by its own mutex.
+ */
+typedef struct tsx_stripe
+{
+    pj_mutex_t          *mutex;
+    pj_hash_table_t     *htable;
+    pj_hash_table_t     *htable2;
+} tsx_stripe;
+
 /* Transaction layer module definition. */
 static struct mod_tsx_layer
 {
     struct pjsip_module  mod;
     pj_pool_t           *pool;
     pjsip_endpoint      *endpt;
-    pj_mutex_t          *mutex;
-    pj_hash_table_t     *htable;
-    pj_hash_table_t     *htable2;
+    unsigned             stripe_cnt;
+    tsx_stripe          *stripes;
 } mod_tsx_layer = 
 {   {
         NULL, NULL,                     /* List's prev and next.    */
@@ -500,6 +510,7 @@ PJ_DEF(void) pjsip_tsx_set_max_retransmit_count(int max)
 PJ_DEF(pj_status_t) pjsip_tsx_layer_init_module(pjsip_endpoint *endpt)
 {
     pj_pool_t *pool;
+    unsigned i;
     pj_status_t status;
 
 
@@ -526,32 +537,37 @@ PJ_DEF(pj_status_t) pjsip_tsx_layer_init_module(pjsip_endpoint *endpt)
     /* Initialize some attributes. */
     mod_tsx_layer.pool = pool;
     mod_tsx_layer.endpt = endpt;
+    mod_tsx_layer.stripe_cnt = pjsip_cfg()->tsx.lock_stripe_cnt;
+    if (mod_tsx_layer.stripe_cnt == 0)
+        mod_tsx_layer.stripe_cnt = 1;
+    mod_tsx_layer.stripes = (tsx_stripe*)
+                            pj_pool_calloc(pool, mod_tsx_layer.stripe_cnt,
+                                           sizeof(tsx_stripe));
+
+    for (i=0; i<mod_tsx_layer.stripe_cnt; ++i) {
+        tsx_stripe *stripe = &mod_tsx_layer.stripes[i];
+        unsigned size = pjsip_cfg()->tsx.max_count / mod_tsx_layer.stripe_cnt;
+
+        /* Create hash table. */
+        stripe->htable = pj_hash_create( pool, size );
+        stripe->htable2 = pj_hash_create( pool, size );
+        if (!stripe->htable || !stripe->htable2) {
+            status = PJ_ENOMEM;
+            goto on_error;
+        }
 
-
-    /* Create hash table. */
-    mod_tsx_layer.htable = pj_hash_create( pool, pjsip_cfg()->tsx.max_count );
-    mod_tsx_layer.htable2 = pj_hash_create(pool, pjsip_cfg()->tsx.max_count);
-    if (!mod_tsx_layer.htable || !mod_tsx_layer.htable2) {
-        pjsip_endpt_release_pool(endpt, pool);
-        return PJ_ENOMEM;
-    }
-
-    /* Create group lock. */
-    status = pj_mutex_create_recursive(pool, "tsxlayer", &mod_tsx_layer.mutex);
-    if (status != PJ_SUCCESS) {
-        pjsip_endpt_release_pool(endpt, pool);
-        return status;
+        /* Create mutex. */
+        status = pj_mutex_create_recursive(pool, "tsxlayer", &stripe->mutex);
+        if (status != PJ_SUCCESS)
+            goto on_error;
     }
 
     /*
      * Register transaction layer module to endpoint.
      */
     status = pjsip_endpt_register_module( endpt, &mod_tsx_layer.mod );
-    if (status != PJ_SUCCESS) {
-        pj_mutex_destroy(mod_tsx_layer.mutex);
-        pjsip_endpt_release_pool(endpt, pool);
-        return status;
-    }
+    if (status != PJ_SUCCESS)
+        goto on_error;
 
     /* Register mod_stateful_util module (sip_util_statefull.c) */
     status = pjsip_endpt_register_module(endpt, &mod_stateful_util);
@@ -560,6 +576,36 @@ PJ_DEF(pj_status_t) pjsip_tsx_layer_init_module(pjsip_endpoint *endpt)
     }
 
     return PJ_SUCCESS;
+
+on_error:
+    for (i=0; i<mod_tsx_layer.stripe_cnt; ++i) {
+        if (mod_tsx_layer.stripes[i].mutex)
+            pj_mutex_destroy(mod_tsx_layer.stripes[i].mutex);
+    }
+    pjsip_endpt_release_pool(endpt, pool);
+    mod_tsx_layer.endpt = NULL;
+    return status;
+}
+
+
+/*
+ * Get the stripe of the transaction table for the key. If hval is zero,
+ * it will be filled with the hash value of the key.
+ *
+ * The hash table picks its bucket from the low bits of hval, so the stripe
+ * is chosen from the high bits of a re-mixed hval instead; otherwise every
+ * stripe would only ever use a fraction of its buckets.
+ */
+static tsx_stripe *get_stripe(const pj_str_t *key, pj_uint32_t *hval)
+{
+    pj_uint32_t mix;
+
+    if (*hval == 0)
+        *hval = pj_hash_calc_tolower(0, NULL, key);
+
+    mix = *hval * 2654435761U;
+    return &mod_tsx_layer.stripes[((pj_uint64_t)mix *
+                                   mod_tsx_layer.stripe_cnt) >> 32];
 }
 
 
@@ -593,21 +639,32 @@ PJ_DEF(pj_status_t) pjsip_tsx_layer_destroy(void)
  */
 static pj_status_t mod_tsx_layer_register_tsx( pjsip_transaction *tsx)
 {
+    tsx_stripe *stripe, *stripe2 = NULL;
+    pj_uint32_t hval = 0, hval2 = 0;
+
     pj_assert(tsx->transaction_key.slen != 0);
 
+#ifdef PRECALC_HASH
+    hval = tsx->hashed_key;
+    hval2 = tsx->hashed_key2;
+#endif
+    stripe = get_stripe(&tsx->transaction_key, &hval);
+    if (tsx->role == PJSIP_ROLE_UAS)
+        stripe2 = get_stripe(&tsx->transaction_key2, &hval2);
+
     /* Lock hash table mutex. */
-    pj_mutex_lock(mod_tsx_layer.mutex);
+    pj_mutex_lock(stripe->mutex);
 
     /* Check if no transaction with the same key exists. 
      * Do not use PJ_ASSERT_RETURN since it evaluates the expression
      * twice!
      */
-    if(pj_hash_get_lower(mod_tsx_layer.htable, 
+    if(pj_hash_get_lower(stripe->htable, 
                          tsx->transaction_key.ptr,
                          (unsigned)tsx->transaction_key.slen, 
-                         NULL))
+                         &hval))
     {
-        pj_mutex_unlock(mod_tsx_layer.mutex);
+        pj_mutex_unlock(stripe->mutex);
         PJ_LOG(2,(THIS_FILE, 
                   "Unable to register %.*s transaction (key exists)",
                   (int)tsx->method.name.slen,
@@ -622,32 +679,27 @@ static pj_status_t mod_tsx_layer_register_tsx( pjsip_transaction *tsx)
 
     /* Register the transaction to the hash tables. We register the tsx
      * to the secondary hash table only if it's UAS, for the purpose of
-     * detecting merged requests.
+     * detecting merged requests. The secondary key may belong to another
+     * stripe, whose mutex is only taken after releasing the first one
+     * so stripe mutexes are never nested.
      */
-#ifdef PRECALC_HASH
-    pj_hash_set_lower( tsx->pool, mod_tsx_layer.htable,
+    pj_hash_set_lower( tsx->pool, stripe->htable,
                        tsx->transaction_key.ptr,
                        (unsigned)tsx->transaction_key.slen, 
-                       tsx->hashed_key, tsx);
-    if (tsx->role == PJSIP_ROLE_UAS) {
-        pj_hash_set_lower( tsx->pool, mod_tsx_layer.htable2,
-                           tsx->transaction_key2.ptr,
-                           (unsigned)tsx->transaction_key2.slen,
-                           tsx->hashed_key2, tsx);
+                       hval, tsx);
+    if (stripe2 && stripe2 != stripe) {
+        pj_mutex_unlock(stripe->mutex);
+        pj_mutex_lock(stripe2->mutex);
     }
-#else
-    pj_hash_set_lower( tsx->pool, mod_tsx_layer.htable,
-                       tsx->transaction_key.ptr,
-                       tsx->transaction_key.slen, 0, tsx);
-    if (tsx->role == PJSIP_ROLE_UAS) {
-        pj_hash_set_lower( tsx->pool, mod_tsx_layer.htable2,
+    if (stripe2) {
+        pj_hash_set_lower( tsx->pool, stripe2->htable2,
                            tsx->transaction_key2.ptr,
-                           tsx->transaction_key2.slen, 0, tsx);
+                           (unsigned)tsx->transaction_key2.slen,
+                           hval2, tsx);
     }
-#endif
 
     /* Unlock mutex. */
-    pj_mutex_unlock(mod_tsx_layer.mutex);
+    pj_mutex_unlock(stripe2? stripe2->mutex : stripe->mutex);
 
     return PJ_SUCCESS;
 }
@@ -658,6 +710,9 @@ static pj_status_t mod_tsx_layer_register_tsx( pjsip_transaction *tsx)
  */
 static void mod_tsx_layer_unregister_tsx( pjsip_transaction *tsx)
 {
+    tsx_stripe *stripe;
+    pj_uint32_t hval = 0, hval2 = 0;
+
     if (mod_tsx_layer.mod.id == -1) {
         /* The transaction layer has been unregistered. This could happen
          * if the transaction was pending on transport and the application
@@ -670,37 +725,33 @@ static void mod_tsx_layer_unregister_tsx( pjsip_transaction *tsx)
     pj_assert(tsx->transaction_key.slen != 0);
     //pj_assert(tsx->state != PJSIP_TSX_STATE_NULL);
 
-    /* Lock hash table mutex. */
-    pj_mutex_lock(mod_tsx_layer.mutex);
+#ifdef PRECALC_HASH
+    hval = tsx->hashed_key;
+    hval2 = tsx->hashed_key2;
+#endif
+    stripe = get_stripe(&tsx->transaction_key, &hval);
 
     /* Unregister the transaction from the hash tables. */
-#ifdef PRECALC_HASH
-    pj_hash_set_lower( NULL, mod_tsx_layer.htable, tsx->transaction_key.ptr,
-                       (unsigned)tsx->transaction_key.slen, tsx->hashed_key,
-                       NULL);
+    pj_mutex_lock(stripe->mutex);
+    pj_hash_set_lower( NULL, stripe->htable, tsx->transaction_key.ptr,
+                       (unsigned)tsx->transaction_key.slen, hval, NULL);
+    pj_mutex_unlock(stripe->mutex);
+
     if (tsx->role == PJSIP_ROLE_UAS) {
-        pj_hash_set_lower(NULL, mod_tsx_layer.htable2,
+        stripe = get_stripe(&tsx->transaction_key2, &hval2);
+
+        pj_mutex_lock(stripe->mutex);
+        pj_hash_set_lower(NULL, stripe->htable2,
                           tsx->transaction_key2.ptr,
                           (unsigned)tsx->transaction_key2.slen,
-                          tsx->hashed_key2, NULL);
+                          hval2, NULL);
+        pj_mutex_unlock(stripe->mutex);
     }
-#else
-    pj_hash_set_lower( NULL, mod_tsx_layer.htable, tsx->transaction_key.ptr,
-                       tsx->transaction_key.slen, 0, NULL);
-    if (tsx->role == PJSIP_ROLE_UAS) {
-        pj_hash_set_lower(NULL, mod_tsx_layer.htable2,
-                          tsx->transaction_key2.ptr,
-                          tsx->transaction_key2.slen, 0, NULL);
-    }
-#endif
 
     TSX_TRACE_((THIS_FILE, 
                 "Transaction %p unregistered, hkey=0x%p and key=%.*s",
                 tsx, tsx->hashed_key, tsx->transaction_key.slen,
                 tsx->transaction_key.ptr));
-
-    /* Unlock mutex. */
-    pj_mutex_unlock(mod_tsx_layer.mutex);
 }
 
 
@@ -710,14 +761,18 @@ static void mod_tsx_layer_unregister_tsx( pjsip_transaction *tsx)
  */
 PJ_DEF(unsigned) pjsip_tsx_layer_get_tsx_count(void)
 {
-    unsigned count;
+    unsigned i, count = 0;
 
     /* Are we registered? */
     PJ_ASSERT_RETURN(mod_tsx_layer.endpt!=NULL, 0);
 
-    pj_mutex_lock(mod_tsx_layer.mutex);
-    count = pj_hash_count(mod_tsx_layer.htable);
-    pj_mutex_unlock(mod_tsx_layer.mutex);
+    for (i=0; i<mod_tsx_layer.stripe_cnt; ++i) {
+        tsx_stripe *stripe = &mod_tsx_layer.stripes[i];
+
+        pj_mutex_lock(stripe->mutex);
+        count += pj_hash_count(stripe->htable);
+        pj_mutex_unlock(stripe->mutex);
+    }
 
     return count;
 }
@@ -730,11 +785,14 @@ static pjsip_transaction* find_tsx( const pj_str_t *key, pj_bool_t lock,
                                     pj_bool_t add_ref )
 {
     pjsip_transaction *tsx;
+    tsx_stripe *stripe;
     pj_uint32_t hval = 0;
 
-    pj_mutex_lock(mod_tsx_layer.mutex);
+    stripe = get_stripe(key, &hval);
+
+    pj_mutex_lock(stripe->mutex);
     tsx = (pjsip_transaction*)
-          pj_hash_get_lower( mod_tsx_layer.htable, key->ptr, 
+          pj_hash_get_lower( stripe->htable, key->ptr, 
                              (unsigned)key->slen, &hval );
     
     /* Prevent the transaction to get deleted before we have chance to lock it.
@@ -742,7 +800,7 @@ static pjsip_transaction* find_tsx( const pj_str_t *key, pj_bool_t lock,
     if (tsx)
         pj_grp_lock_add_ref(tsx->grp_lock);
     
-    pj_mutex_unlock(mod_tsx_layer.mutex);
+    pj_mutex_unlock(stripe->mutex);
 
     TSX_TRACE_((THIS_FILE, 
                 "Finding tsx with hkey=0x%p and key=%.*s: found %p",
@@ -802,27 +860,50 @@ static pj_status_t mod_tsx_layer_start(void)
 static pj_status_t mod_tsx_layer_stop(void)
 {
     pj_hash_iterator_t it_buf, *it;
+    unsigned i;
 
     PJ_LOG(4,(THIS_FILE, "Stopping transaction layer module"));
 
-    pj_mutex_lock(mod_tsx_layer.mutex);
-
-    /* Destroy all transactions. */
-    it = pj_hash_first(mod_tsx_layer.htable, &it_buf);
-    while (it) {
-        pjsip_transaction *tsx = (pjsip_transaction*) 
-                                 pj_hash_this(mod_tsx_layer.htable, it);
-        pj_hash_iterator_t *next = pj_hash_next(mod_tsx_layer.htable, it);
-        if (tsx) {
-            pjsip_tsx_terminate(tsx, PJSIP_SC_SERVICE_UNAVAILABLE);
-            mod_tsx_layer_unregister_tsx(tsx);
-            tsx_shutdown(tsx);
+    for (i=0; i<mod_tsx_layer.stripe_cnt; ++i) {
+        tsx_stripe *stripe = &mod_tsx_layer.stripes[i];
+
+        /* Destroy all transactions. Unregistering a transaction locks the
+         * stripe of its second key too, so collect a batch of transactions
+         * under the stripe lock and destroy them after releasing it, to
+         * avoid nesting stripe locks.
+         */
+        for (;;) {
+            pjsip_transaction *tsx_list[16];
+            unsigned j, cnt = 0;
+
+            pj_mutex_lock(stripe->mutex);
+            it = pj_hash_first(stripe->htable, &it_buf);
+            while (it && cnt < PJ_ARRAY_SIZE(tsx_list)) {
+                pjsip_transaction *tsx = (pjsip_transaction*) 
+                                         pj_hash_this(stripe->htable, it);
+                if (tsx) {
+                    /* Keep the transaction alive until we're done */
+                    pj_grp_lock_add_ref(tsx->grp_lock);
+                    tsx_list[cnt++] = tsx;
+                }
+                it = pj_hash_next(stripe->htable, it);
+            }
+            pj_mutex_unlock(stripe->mutex);
+
+            if (cnt == 0)
+                break;
+
+            for (j=0; j<cnt; ++j) {
+                pjsip_transaction *tsx = tsx_list[j];
+
+                pjsip_tsx_terminate(tsx, PJSIP_SC_SERVICE_UNAVAILABLE);
+                mod_tsx_layer_unregister_tsx(tsx);
+                tsx_shutdown(tsx);
+                pj_grp_lock_dec_ref(tsx->grp_lock);
+            }
         }
-        it = next;
     }
 
-    pj_mutex_unlock(mod_tsx_layer.mutex);
-
     PJ_LOG(4,(THIS_FILE, "Stopped transaction layer module"));
 
     return PJ_SUCCESS;
@@ -832,10 +913,13 @@ static pj_status_t mod_tsx_layer_stop(void)
 /* Destroy this module */
 static void tsx_layer_destroy(pjsip_endpoint *endpt)
 {
+    unsigned i;
+
     PJ_UNUSED_ARG(endpt);
 
-    /* Destroy mutex. */
-    pj_mutex_destroy(mod_tsx_layer.mutex);
+    /* Destroy mutexes. */
+    for (i=0; i<mod_tsx_layer.stripe_cnt; ++i)
+        pj_mutex_destroy(mod_tsx_layer.stripes[i].mutex);
 
     /* Release pool. */
     pjsip_endpt_release_pool(mod_tsx_layer.endpt, mod_tsx_layer.pool);
@@ -858,7 +942,7 @@ static pj_status_t mod_tsx_layer_unload(void)
      * crash when the pending transaction finally got error response
      * from transport and when it tries to unregister itself.
      */
-    if (pj_hash_count(mod_tsx_layer.htable) != 0) {
+    if (pjsip_tsx_layer_get_tsx_count() != 0) {
         pj_status_t status;
         status = pjsip_endpt_atexit(mod_tsx_layer.endpt, &tsx_layer_destroy);
         if (status != PJ_SUCCESS) {
@@ -881,6 +965,7 @@ pjsip_tsx_detect_merged_requests(pjsip_rx_data *rdata)
     pj_str_t key, key2;
     pj_uint32_t hval = 0;
     pjsip_transaction *tsx = NULL;
+    tsx_stripe *stripe;
     pj_status_t status;
 
     PJ_ASSERT_RETURN(rdata->msg_info.msg->type == PJSIP_REQUEST_MSG, NULL);
@@ -896,18 +981,21 @@ pjsip_tsx_detect_merged_requests(pjsip_rx_data *rdata)
     if (status != PJ_SUCCESS)
         return NULL;
 
-    pj_mutex_lock( mod_tsx_layer.mutex );
+    stripe = get_stripe(&key, &hval);
+    pj_mutex_lock( stripe->mutex );
 
     /* This request must not match any transaction in our primary hash
      * table.
      */
-    if (pj_hash_get_lower(mod_tsx_layer.htable, key.ptr, (unsigned)key.slen,
+    if (pj_hash_get_lower(stripe->htable, key.ptr, (unsigned)key.slen,
                           &hval) != NULL)
     {
-        pj_mutex_unlock( mod_tsx_layer.mutex);
+        pj_mutex_unlock( stripe->mutex);
         return NULL;
     }
 
+    pj_mutex_unlock( stripe->mutex);
+
     /* Now check it against our secondary hash table, based on a key that
      * consists of From tag, CSeq, and Call-ID.
      */
@@ -915,15 +1003,15 @@ pjsip_tsx_detect_merged_requests(pjsip_rx_data *rdata)
                                  &rdata->msg_info.cseq->method, rdata,
                                  PJ_FALSE);
     if (status != PJ_SUCCESS) {
-        pj_mutex_unlock( mod_tsx_layer.mutex);
         return NULL;
     }
 
     hval = 0;
-    tsx = pj_hash_get_lower(mod_tsx_layer.htable2, key2.ptr,
+    stripe = get_stripe(&key2, &hval);
+    pj_mutex_lock( stripe->mutex );
+    tsx = pj_hash_get_lower(stripe->htable2, key2.ptr,
                             (unsigned)key2.slen, &hval);
-
-    pj_mutex_unlock( mod_tsx_layer.mutex);
+    pj_mutex_unlock( stripe->mutex);
 
     return tsx;
 }
@@ -936,15 +1024,17 @@ static pj_bool_t mod_tsx_layer_on_rx_request(pjsip_rx_data *rdata)
     pj_str_t key;
     pj_uint32_t hval = 0;
     pjsip_transaction *tsx;
+    tsx_stripe *stripe;
 
     pjsip_tsx_create_key(rdata->tp_info.pool, &key, PJSIP_ROLE_UAS,
                          &rdata->msg_info.cseq->method, rdata);
 
     /* Find transaction. */
-    pj_mutex_lock( mod_tsx_layer.mutex );
+    stripe = get_stripe(&key, &hval);
+    pj_mutex_lock( stripe->mutex );
 
     tsx = (pjsip_transaction*) 
-          pj_hash_get_lower( mod_tsx_layer.htable, key.ptr, (unsigned)key.slen, 
+          pj_hash_get_lower( stripe->htable, key.ptr, (unsigned)key.slen, 
                              &hval );
 
 
@@ -958,7 +1048,7 @@ static pj_bool_t mod_tsx_layer_on_rx_request(pjsip_rx_data *rdata)
          * Reject the request so that endpoint passes the request to
          * upper layer modules.
          */
-        pj_mutex_unlock( mod_tsx_layer.mutex);
+        pj_mutex_unlock( stripe->mutex);
         return PJ_FALSE;
     }
 
@@ -970,7 +1060,7 @@ static pj_bool_t mod_tsx_layer_on_rx_request(pjsip_rx_data *rdata)
         tsx->method.id == PJSIP_INVITE_METHOD &&
         tsx->status_code/100 == 2)
     {
-        pj_mutex_unlock( mod_tsx_layer.mutex);
+        pj_mutex_unlock( stripe->mutex);
         return PJ_FALSE;
     }
 
@@ -980,7 +1070,7 @@ static pj_bool_t mod_tsx_layer_on_rx_request(pjsip_rx_data *rdata)
     pj_grp_lock_add_ref(tsx->grp_lock);
     
     /* Unlock hash table. */
-    pj_mutex_unlock( mod_tsx_layer.mutex );
+    pj_mutex_unlock( stripe->mutex );
 
     /* Simulate race condition! */
     PJ_RACE_ME(5);
@@ -1002,15 +1092,17 @@ static pj_bool_t mod_tsx_layer_on_rx_response(pjsip_rx_data *rdata)
     pj_str_t key;
     pj_uint32_t hval = 0;
     pjsip_transaction *tsx;
+    tsx_stripe *stripe;
 
     pjsip_tsx_create_key(rdata->tp_info.pool, &key, PJSIP_ROLE_UAC,
                          &rdata->msg_info.cseq->method, rdata);
 
     /* Find transaction. */
-    pj_mutex_lock( mod_tsx_layer.mutex );
+    stripe = get_stripe(&key, &hval);
+    pj_mutex_lock( stripe->mutex );
 
     tsx = (pjsip_transaction*) 
-          pj_hash_get_lower( mod_tsx_layer.htable, key.ptr, (unsigned)key.slen, 
+          pj_hash_get_lower( stripe->htable, key.ptr, (unsigned)key.slen, 
                              &hval );
 
 
@@ -1024,7 +1116,7 @@ static pj_bool_t mod_tsx_layer_on_rx_response(pjsip_rx_data *rdata)
          * Reject the request so that endpoint passes the request to
          * upper layer modules.
          */
-        pj_mutex_unlock( mod_tsx_layer.mutex);
+        pj_mutex_unlock( stripe->mutex);
         return PJ_FALSE;
     }
 
@@ -1034,7 +1126,7 @@ static pj_bool_t mod_tsx_layer_on_rx_response(pjsip_rx_data *rdata)
     pj_grp_lock_add_ref(tsx->grp_lock);
 
     /* Unlock hash table. */
-    pj_mutex_unlock( mod_tsx_layer.mutex );
+    pj_mutex_unlock( stripe->mutex );
 
     /* Simulate race condition! */
     PJ_RACE_ME(5);
@@ -1065,22 +1157,26 @@ PJ_DEF(void) pjsip_tsx_layer_dump(pj_bool_t detail)
 {
 #if PJ_LOG_MAX_LEVEL >= 3
     pj_hash_iterator_t itbuf, *it;
+    unsigned i, count;
 
-    /* Lock mutex. */
-    pj_mutex_lock(mod_tsx_layer.mutex);
+    count = pjsip_tsx_layer_get_tsx_count();
 
     PJ_LOG(3, (THIS_FILE, "Dumping transaction table:"));
-    PJ_LOG(3, (THIS_FILE, " Total %d transactions", 
-                          pj_hash_count(mod_tsx_layer.htable)));
+    PJ_LOG(3, (THIS_FILE, " Total %d transactions", count));
 
-    if (detail) {
-        it = pj_hash_first(mod_tsx_layer.htable, &itbuf);
-        if (it == NULL) {
-            PJ_LOG(3, (THIS_FILE, " - none - "));
-        } else {
+    if (detail && count == 0) {
+        PJ_LOG(3, (THIS_FILE, " - none - "));
+    } else if (detail) {
+        for (i=0; i<mod_tsx_layer.stripe_cnt; ++i) {
+            tsx_stripe *stripe = &mod_tsx_layer.stripes[i];
+
+            /* Lock mutex. */
+            pj_mutex_lock(stripe->mutex);
+
+            it = pj_hash_first(stripe->htable, &itbuf);
             while (it != NULL) {
                 pjsip_transaction *tsx = (pjsip_transaction*) 
-                                         pj_hash_this(mod_tsx_layer.htable,it);
+                                         pj_hash_this(stripe->htable, it);
 
                 PJ_LOG(3, (THIS_FILE, " %s %s|%d|%s",
                            tsx->obj_name,
@@ -1090,13 +1186,13 @@ PJ_DEF(void) pjsip_tsx_layer_dump(pj_bool_t detail)
                            tsx->status_code,
                            pjsip_tsx_state_str(tsx->state)));
 
-                it = pj_hash_next(mod_tsx_layer.htable, it);
+                it = pj_hash_next(stripe->htable, it);
             }
+
+            /* Unlock mutex. */
+            pj_mutex_unlock(stripe->mutex);
         }
     }
-
-    /* Unlock mutex. */
-    pj_mutex_unlock(mod_tsx_layer.mutex);
 #endif
 }
 
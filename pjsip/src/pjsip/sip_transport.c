@@ -137,12 +137,27 @@ typedef struct transport
     pjsip_transport *tp;
 } transport;
 
+/* Stripe of the transport table. Transports are distributed among the
+ * stripes by the hash value of their key, and each stripe has its own
+ * lock, and its own pool for the hash table and the transport entries.
+ */
+typedef struct tp_stripe
+{
+    pj_pool_t       *pool;
+    pj_lock_t       *lock;
+    pj_hash_table_t *table;
+
+    /* List of free transport entry. */
+    transport        tp_entry_freelist;
+} tp_stripe;
+
 /*
  * Transport manager.
  */
 struct pjsip_tpmgr 
 {
-    pj_hash_table_t *table;
+    unsigned         stripe_cnt;
+    tp_stripe       *stripes;
     pj_lock_t       *lock;
     pjsip_endpoint  *endpt;
     pjsip_tpfactory  factory_list;
@@ -160,9 +175,6 @@ struct pjsip_tpmgr
      * is destroyed.
      */
     pjsip_tx_data    tdata_list;
-
-    /* List of free transport entry. */
-    transport        tp_entry_freelist;
 };
 
 
@@ -546,6 +558,15 @@ PJ_DEF(void) pjsip_tx_data_add_ref( pjsip_tx_data *tdata )
     pj_atomic_inc(tdata->ref_cnt);
 }
 
+/* Release a reference to the pre-encoded response headers. */
+static void rsp_hdr_dec_ref(pjsip_rsp_hdr_cache *rsp_hdr)
+{
+    if (pj_atomic_dec_and_get(rsp_hdr->ref_cnt) == 0) {
+        pj_atomic_destroy(rsp_hdr->ref_cnt);
+        pj_pool_release(rsp_hdr->pool);
+    }
+}
+
 static void tx_data_destroy(pjsip_tx_data *tdata)
 {
     PJ_LOG(5,(tdata->obj_name, "Destroying txdata %s",
@@ -562,6 +583,9 @@ static void tx_data_destroy(pjsip_tx_data *tdata)
     pj_lock_release(tdata->mgr->lock);
 #endif
 
+    if (tdata->rsp_hdr)
+        rsp_hdr_dec_ref(tdata->rsp_hdr);
+
     pj_atomic_destroy( tdata->ref_cnt );
     pj_lock_destroy( tdata->lock );
     pjsip_endpt_release_pool( tdata->mgr->endpt, tdata->pool );
@@ -855,11 +879,22 @@ PJ_DEF(pj_status_t) pjsip_rx_data_clone( const pjsip_rx_data *src,
     return pjsip_transport_add_ref(dst->tp_info.transport);
 }
 
+/* Release the pre-encoded response headers of the request. */
+PJ_DEF(void) pjsip_rx_data_release_rsp_hdr(pjsip_rx_data *rdata)
+{
+    if (rdata->msg_info.rsp_hdr) {
+        rsp_hdr_dec_ref(rdata->msg_info.rsp_hdr);
+        rdata->msg_info.rsp_hdr = NULL;
+    }
+}
+
 /* Free previously cloned pjsip_rx_data. */
 PJ_DEF(pj_status_t) pjsip_rx_data_free_cloned(pjsip_rx_data *rdata)
 {
     PJ_ASSERT_RETURN(rdata, PJ_EINVAL);
 
+    pjsip_rx_data_release_rsp_hdr(rdata);
+
     pjsip_transport_dec_ref(rdata->tp_info.transport);
     pj_pool_release(rdata->tp_info.pool);
 
@@ -1092,11 +1127,53 @@ PJ_DEF(pj_status_t) pjsip_tpmgr_send_raw(pjsip_tpmgr *mgr,
 }
 
 
+/*
+ * Get the stripe of the transport table for the key, and the hash value
+ * of the key.
+ */
+static tp_stripe *get_stripe(pjsip_tpmgr *mgr,
+                             const pjsip_transport_key *key, int key_len,
+                             pj_uint32_t *hval)
+{
+    *hval = pj_hash_calc(0, key, key_len);
+    return &mgr->stripes[*hval % mgr->stripe_cnt];
+}
+
+/* Get the idle timer delay of the transport, when its reference counter
+ * becomes zero.
+ */
+static void get_idle_delay(const pjsip_transport *tp, pj_time_val *delay,
+                           int *timer_id)
+{
+    *timer_id = IDLE_TIMER_ID;
+
+    /* If transport is in graceful shutdown, then this is the
+     * last user who uses the transport. Schedule to destroy the
+     * transport immediately. Otherwise schedule idle timer.
+     */
+    if (tp->is_shutdown) {
+        delay->sec = delay->msec = 0;
+    } else {
+        if (tp->dir == PJSIP_TP_DIR_OUTGOING) {
+            delay->sec = PJSIP_TRANSPORT_IDLE_TIME;
+        } else {
+            delay->sec = PJSIP_TRANSPORT_SERVER_IDLE_TIME;
+            if (tp->last_recv_ts.u64 == 0 && tp->initial_timeout) {
+                *timer_id = INITIAL_IDLE_TIMER_ID;
+                delay->sec = tp->initial_timeout;
+            }
+        }
+        delay->msec = 0;
+    }
+}
+
 static void transport_idle_callback(pj_timer_heap_t *timer_heap,
                                     struct pj_timer_entry *entry)
 {
     pjsip_transport *tp = (pjsip_transport*) entry->user_data;
     int entry_id = entry->id;
+    tp_stripe *stripe;
+    pj_uint32_t hval;
 
     pj_assert(tp != NULL);
 
@@ -1107,12 +1184,45 @@ static void transport_idle_callback(pj_timer_heap_t *timer_heap,
 
     entry->id = PJ_FALSE;
 
-    /* Set is_destroying flag under transport manager mutex to avoid
+    /* Set is_destroying flag under transport table lock to avoid
      * race condition with pjsip_tpmgr_acquire_transport2().
      */
-    pj_lock_acquire(tp->tpmgr->lock);
+    stripe = get_stripe(tp->tpmgr, &tp->key,
+                        sizeof(tp->key.type) + tp->addr_len, &hval);
+    pj_lock_acquire(stripe->lock);
+
+    /* The timer may have been rescheduled by pjsip_transport_dec_ref()
+     * before we got the lock, in which case that schedule takes over.
+     */
+    if (pj_timer_entry_running(&tp->idle_timer)) {
+        pj_lock_release(stripe->lock);
+        return;
+    }
 
     if (pj_atomic_get(tp->ref_cnt) == 0) {
+        /* The idle timer is not cancelled when the transport is used
+         * (see pjsip_transport_add_ref()), so the transport may have
+         * become idle again later. Wait for the rest of the idle time.
+         */
+        if (entry_id == IDLE_TIMER_ID && !tp->is_shutdown) {
+            pj_time_val delay, elapsed;
+            int timer_id;
+
+            get_idle_delay(tp, &delay, &timer_id);
+            pj_gettickcount(&elapsed);
+            PJ_TIME_VAL_SUB(elapsed, tp->idle_ts);
+            if (timer_id == IDLE_TIMER_ID && PJ_TIME_VAL_LT(elapsed, delay)) {
+                PJ_TIME_VAL_SUB(delay, elapsed);
+                pjsip_endpt_schedule_timer_w_grp_lock(tp->tpmgr->endpt,
+                                                      &tp->idle_timer,
+                                                      &delay,
+                                                      IDLE_TIMER_ID,
+                                                      tp->grp_lock);
+                pj_lock_release(stripe->lock);
+                return;
+            }
+        }
+
         tp->is_destroying = PJ_TRUE;
         PJ_LOG(4, (THIS_FILE, "Transport %s is being destroyed "
                   "due to timeout in %s timer", tp->obj_name, 
@@ -1129,22 +1239,22 @@ static void transport_idle_callback(pj_timer_heap_t *timer_heap,
             }
         }
     } else {
-        pj_lock_release(tp->tpmgr->lock);
+        pj_lock_release(stripe->lock);
         return;
     }
-    pj_lock_release(tp->tpmgr->lock);
+    pj_lock_release(stripe->lock);
 
     pjsip_transport_destroy(tp);
 }
 
 
-static pj_bool_t is_transport_valid(pjsip_transport *tp, pjsip_tpmgr *tpmgr,
+static pj_bool_t is_transport_valid(pjsip_transport *tp, tp_stripe *stripe,
                                     const pjsip_transport_key *key,
-                                    int key_len)
+                                    int key_len, pj_uint32_t hval)
 {
     transport *tp_entry;
 
-    tp_entry = (transport *)pj_hash_get(tpmgr->table, key, key_len, NULL);
+    tp_entry = (transport *)pj_hash_get(stripe->table, key, key_len, &hval);
     if (tp_entry != NULL) {
 
         transport *tp_iter = tp_entry;
@@ -1164,8 +1274,9 @@ static pj_bool_t is_transport_valid(pjsip_transport *tp, pjsip_tpmgr *tpmgr,
  */
 PJ_DEF(pj_status_t) pjsip_transport_add_ref( pjsip_transport *tp )
 {
-    pjsip_tpmgr *tpmgr;
     pjsip_transport_key key;
+    tp_stripe *stripe;
+    pj_uint32_t hval;
     int key_len;
 
     PJ_ASSERT_RETURN(tp != NULL, PJ_EINVAL);
@@ -1175,24 +1286,30 @@ PJ_DEF(pj_status_t) pjsip_transport_add_ref( pjsip_transport *tp )
         pj_grp_lock_add_ref(tp->grp_lock);
 
     /* Cache some vars for checking transport validity later */
-    tpmgr = tp->tpmgr;
     key_len = sizeof(tp->key.type) + tp->addr_len;
     pj_memcpy(&key, &tp->key, key_len);
+    stripe = get_stripe(tp->tpmgr, &key, key_len, &hval);
 
     if (pj_atomic_inc_and_get(tp->ref_cnt) == 1) {
-        pj_lock_acquire(tpmgr->lock);
+        pj_lock_acquire(stripe->lock);
         /* Verify again. But first, make sure transport is still valid
          * (see #1883).
+         *
+         * The idle timer is left running, it will check the reference
+         * counter when it expires. This avoids cancelling and scheduling
+         * the timer each time a busy transport is used.
          */
-        if (is_transport_valid(tp, tpmgr, &key, key_len) &&
+        if (is_transport_valid(tp, stripe, &key, key_len, hval) &&
             pj_atomic_get(tp->ref_cnt) == 1)
         {
-            if (tp->idle_timer.id != PJ_FALSE) {
+            if (tp->idle_timer.id != PJ_FALSE &&
+                tp->idle_timer.id != IDLE_TIMER_ID)
+            {
                 tp->idle_timer.id = PJ_FALSE;
                 pjsip_endpt_cancel_timer(tp->tpmgr->endpt, &tp->idle_timer);
             }
         }
-        pj_lock_release(tpmgr->lock);
+        pj_lock_release(stripe->lock);
     }
 
     return PJ_SUCCESS;
@@ -1203,64 +1320,59 @@ PJ_DEF(pj_status_t) pjsip_transport_add_ref( pjsip_transport *tp )
  */
 PJ_DEF(pj_status_t) pjsip_transport_dec_ref( pjsip_transport *tp )
 {
-    pjsip_tpmgr *tpmgr;
     pjsip_transport_key key;
+    tp_stripe *stripe;
+    pj_uint32_t hval;
     int key_len;
 
     PJ_ASSERT_RETURN(tp != NULL, PJ_EINVAL);
     pj_assert(pj_atomic_get(tp->ref_cnt) > 0);
 
     /* Cache some vars for checking transport validity later */
-    tpmgr = tp->tpmgr;
     key_len = sizeof(tp->key.type) + tp->addr_len;
     pj_memcpy(&key, &tp->key, key_len);
+    stripe = get_stripe(tp->tpmgr, &key, key_len, &hval);
 
     if (pj_atomic_dec_and_get(tp->ref_cnt) == 0) {
-        pj_lock_acquire(tpmgr->lock);
+        pj_lock_acquire(stripe->lock);
         /* Verify again. Do not register timer if the transport is
          * being destroyed. But first, make sure transport is still valid
          * (see #1883).
          */
-        if (is_transport_valid(tp, tpmgr, &key, key_len) &&
+        if (is_transport_valid(tp, stripe, &key, key_len, hval) &&
             !tp->is_destroying && pj_atomic_get(tp->ref_cnt) == 0)
         {
             pj_time_val delay;
-            
-            int timer_id = IDLE_TIMER_ID;
+            int timer_id;
 
-            /* If transport is in graceful shutdown, then this is the
-             * last user who uses the transport. Schedule to destroy the
-             * transport immediately. Otherwise schedule idle timer.
-             */
-            if (tp->is_shutdown) {
-                delay.sec = delay.msec = 0;
-            } else {
-                if (tp->dir == PJSIP_TP_DIR_OUTGOING) {
-                    delay.sec = PJSIP_TRANSPORT_IDLE_TIME;
-                } else {
-                    delay.sec = PJSIP_TRANSPORT_SERVER_IDLE_TIME;
-                    if (tp->last_recv_ts.u64 == 0 && tp->initial_timeout) {
-                        PJ_LOG(4, (THIS_FILE, 
-                                   "Starting transport %s initial timer",
-                                   tp->obj_name));
-                        timer_id = INITIAL_IDLE_TIMER_ID;
-                        delay.sec = tp->initial_timeout;
-                    }
-                }
-                delay.msec = 0;
+            get_idle_delay(tp, &delay, &timer_id);
+            if (timer_id == INITIAL_IDLE_TIMER_ID) {
+                PJ_LOG(4, (THIS_FILE, "Starting transport %s initial timer",
+                           tp->obj_name));
             }
+            pj_gettickcount(&tp->idle_ts);
 
-            /* Avoid double timer entry scheduling */
-            if (pj_timer_entry_running(&tp->idle_timer))
-                pjsip_endpt_cancel_timer(tp->tpmgr->endpt, &tp->idle_timer);
+            /* The idle timer that is still running from previous idle
+             * period will wait for the rest of the idle time when it
+             * expires. Otherwise (re)schedule the timer, avoiding double
+             * timer entry scheduling.
+             */
+            if (tp->idle_timer.id != IDLE_TIMER_ID ||
+                timer_id != IDLE_TIMER_ID || delay.sec == 0)
+            {
+                if (pj_timer_entry_running(&tp->idle_timer)) {
+                    pjsip_endpt_cancel_timer(tp->tpmgr->endpt,
+                                             &tp->idle_timer);
+                }
 
-            pjsip_endpt_schedule_timer_w_grp_lock(tp->tpmgr->endpt,
-                                                  &tp->idle_timer,
-                                                  &delay,
-                                                  timer_id,
-                                                  tp->grp_lock);
+                pjsip_endpt_schedule_timer_w_grp_lock(tp->tpmgr->endpt,
+                                                      &tp->idle_timer,
+                                                      &delay,
+                                                      timer_id,
+                                                      tp->grp_lock);
+            }
         }
-        pj_lock_release(tpmgr->lock);
+        pj_lock_release(stripe->lock);
     }
 
     /* Dec ref transport group lock, if any */
@@ -1280,6 +1392,7 @@ PJ_DEF(pj_status_t) pjsip_transport_register( pjsip_tpmgr *mgr,
 {
     int key_len;
     pj_uint32_t hval;
+    tp_stripe *stripe;
     transport *tp_ref = NULL;
     transport *tp_add = NULL;
 
@@ -1293,28 +1406,29 @@ PJ_DEF(pj_status_t) pjsip_transport_register( pjsip_tpmgr *mgr,
      * Register to hash table (see Trac ticket #42).
      */
     key_len = sizeof(tp->key.type) + tp->addr_len;
-    pj_lock_acquire(mgr->lock);
+    stripe = get_stripe(mgr, &tp->key, key_len, &hval);
+    pj_lock_acquire(stripe->lock);
 
-    hval = 0;
-    tp_ref = (transport *)pj_hash_get(mgr->table, &tp->key, key_len, &hval);
+    tp_ref = (transport *)pj_hash_get(stripe->table, &tp->key, key_len,
+                                      &hval);
 
     /* Get an empty entry from the freelist. */
-    if (pj_list_empty(&mgr->tp_entry_freelist)) {
+    if (pj_list_empty(&stripe->tp_entry_freelist)) {
         unsigned i = 0;
 
         TRACE_((THIS_FILE, "Transport list is full, allocate new entry"));
         /* Allocate new entry for the freelist. */
         for (; i < PJSIP_TRANSPORT_ENTRY_ALLOC_CNT; ++i) {
-            tp_add = PJ_POOL_ZALLOC_T(mgr->pool, transport);
+            tp_add = PJ_POOL_ZALLOC_T(stripe->pool, transport);
             if (!tp_add){
-                pj_lock_release(mgr->lock);
+                pj_lock_release(stripe->lock);
                 return PJ_ENOMEM;
             }  
             pj_list_init(tp_add);
-            pj_list_push_back(&mgr->tp_entry_freelist, tp_add);
+            pj_list_push_back(&stripe->tp_entry_freelist, tp_add);
         }
     }
-    tp_add = mgr->tp_entry_freelist.next;
+    tp_add = stripe->tp_entry_freelist.next;
     tp_add->tp = tp;
     pj_list_erase(tp_add);
 
@@ -1327,7 +1441,7 @@ PJ_DEF(pj_status_t) pjsip_transport_register( pjsip_tpmgr *mgr,
                            "appended the transport to the list"));
     } else {
         /* Transport list not found, add it to the hash table. */
-        pj_hash_set_np(mgr->table, &tp->key, key_len, hval, tp_add->tp_buf,
+        pj_hash_set_np(stripe->table, &tp->key, key_len, hval, tp_add->tp_buf,
                        tp_add);
         TRACE_((THIS_FILE, "Remote address not registered, "
                            "added the transport to the hash"));
@@ -1337,7 +1451,7 @@ PJ_DEF(pj_status_t) pjsip_transport_register( pjsip_tpmgr *mgr,
     if (tp->grp_lock)
         pj_grp_lock_add_ref(tp->grp_lock);
 
-    pj_lock_release(mgr->lock);
+    pj_lock_release(stripe->lock);
 
     TRACE_((THIS_FILE, "Transport %s registered: type=%s, remote=%s:%d",
             tp->obj_name,
@@ -1356,14 +1470,18 @@ static pj_status_t destroy_transport( pjsip_tpmgr *mgr,
 {
     int key_len;
     pj_uint32_t hval;
+    tp_stripe *stripe;
     void *entry;
 
     tp->is_destroying = PJ_TRUE;
 
     TRACE_((THIS_FILE, "Transport %s is being destroyed", tp->obj_name));
 
+    key_len = sizeof(tp->key.type) + tp->addr_len;
+    stripe = get_stripe(mgr, &tp->key, key_len, &hval);
+
     pj_lock_acquire(tp->lock);
-    pj_lock_acquire(mgr->lock);
+    pj_lock_acquire(stripe->lock);
 
     /*
      * Unregister timer, if any.
@@ -1377,9 +1495,7 @@ static pj_status_t destroy_transport( pjsip_tpmgr *mgr,
     /*
      * Unregister from hash table (see Trac ticket #42).
      */
-    key_len = sizeof(tp->key.type) + tp->addr_len;
-    hval = 0;
-    entry = pj_hash_get(mgr->table, &tp->key, key_len, &hval);
+    entry = pj_hash_get(stripe->table, &tp->key, key_len, &hval);
     if (entry) {
         transport *tp_ref = (transport *)entry;
         transport *tp_iter = tp_ref;
@@ -1393,13 +1509,14 @@ static pj_status_t destroy_transport( pjsip_tpmgr *mgr,
                  * - the entry is the first element of the transport list.
                  */
                 if (tp_iter == tp_ref) {
-                    pj_hash_set(NULL, mgr->table, &tp->key, key_len, hval,
+                    pj_hash_set(NULL, stripe->table, &tp->key, key_len, hval,
                                 NULL);
 
                     if (tp_ref->next != tp_ref) {
                         /* The transport list has multiple entry. */
-                        pj_hash_set_np(mgr->table, &tp_next->tp->key, key_len,
-                                       hval, tp_next->tp_buf, tp_next);
+                        pj_hash_set_np(stripe->table, &tp_next->tp->key,
+                                       key_len, hval, tp_next->tp_buf,
+                                       tp_next);
                         TRACE_((THIS_FILE, "Hash entry updated after "
                                            "transport %s being destroyed",
                                            tp->obj_name));
@@ -1412,7 +1529,7 @@ static pj_status_t destroy_transport( pjsip_tpmgr *mgr,
 
                 pj_list_erase(tp_iter);
                 /* Put back to the transport freelist. */
-                pj_list_push_back(&mgr->tp_entry_freelist, tp_iter);
+                pj_list_push_back(&stripe->tp_entry_freelist, tp_iter);
 
                 break;
             }
@@ -1428,7 +1545,7 @@ static pj_status_t destroy_transport( pjsip_tpmgr *mgr,
                               "not found in the hash table", tp->obj_name));
     }
 
-    pj_lock_release(mgr->lock);
+    pj_lock_release(stripe->lock);
     pj_lock_release(tp->lock);
 
     /* Dec ref transport group lock, if any */
@@ -1617,6 +1734,22 @@ static pj_bool_t pjsip_tpmgr_is_tpfactory_valid(pjsip_tpmgr *mgr,
  *
  *****************************************************************************/
 
+/* Destroy the locks and pools of the transport table stripes. */
+static void destroy_stripes(pjsip_tpmgr *mgr)
+{
+    unsigned i;
+
+    for (i=0; i<mgr->stripe_cnt; ++i) {
+        tp_stripe *stripe = &mgr->stripes[i];
+
+        if (stripe->lock)
+            pj_lock_destroy(stripe->lock);
+        if (stripe->pool)
+            pjsip_endpt_release_pool(mgr->endpt, stripe->pool);
+    }
+    mgr->stripe_cnt = 0;
+}
+
 /*
  * Create a new transport manager.
  */
@@ -1653,32 +1786,62 @@ PJ_DEF(pj_status_t) pjsip_tpmgr_create( pj_pool_t *pool,
 
     pj_list_init(&mgr->factory_list);
     pj_list_init(&mgr->tdata_list);
-    pj_list_init(&mgr->tp_entry_freelist);
-
-    mgr->table = pj_hash_create(mgr->pool, PJSIP_TPMGR_HTABLE_SIZE);
-    if (!mgr->table)
-        return PJ_ENOMEM;
 
     status = pj_lock_create_recursive_mutex(mgr->pool, "tmgr%p", &mgr->lock);
     if (status != PJ_SUCCESS)
         return status;
 
-    for (; i < PJSIP_TRANSPORT_ENTRY_ALLOC_CNT; ++i) {
-        transport *tp_add = NULL;
+    mgr->stripe_cnt = PJSIP_TPMGR_LOCK_STRIPE_CNT;
+    if (mgr->stripe_cnt == 0)
+        mgr->stripe_cnt = 1;
+    mgr->stripes = (tp_stripe*) pj_pool_calloc(mgr->pool, mgr->stripe_cnt,
+                                               sizeof(tp_stripe));
 
-        tp_add = PJ_POOL_ZALLOC_T(mgr->pool, transport);
-        if (!tp_add)
-            return PJ_ENOMEM;
-        pj_list_init(tp_add);
-        pj_list_push_back(&mgr->tp_entry_freelist, tp_add);
+    for (i=0; i<mgr->stripe_cnt; ++i) {
+        tp_stripe *stripe = &mgr->stripes[i];
+        unsigned j;
+
+        pj_list_init(&stripe->tp_entry_freelist);
+
+        stripe->pool = pjsip_endpt_create_pool(endpt, "tpstripe",
+                                               TPMGR_POOL_INIT_SIZE,
+                                               TPMGR_POOL_INC_SIZE);
+        if (!stripe->pool) {
+            status = PJ_ENOMEM;
+            goto on_error;
+        }
+
+        stripe->table = pj_hash_create2(stripe->pool,
+                                        PJSIP_TPMGR_HTABLE_SIZE /
+                                            mgr->stripe_cnt + 1,
+                                        PJ_HASH_TYPE_OPEN_ADDRESSING);
+        if (!stripe->table) {
+            status = PJ_ENOMEM;
+            goto on_error;
+        }
+
+        status = pj_lock_create_recursive_mutex(stripe->pool, "tpstripe%p",
+                                                &stripe->lock);
+        if (status != PJ_SUCCESS)
+            goto on_error;
+
+        for (j=0; j < PJSIP_TRANSPORT_ENTRY_ALLOC_CNT; ++j) {
+            transport *tp_add = NULL;
+
+            tp_add = PJ_POOL_ZALLOC_T(stripe->pool, transport);
+            if (!tp_add) {
+                status = PJ_ENOMEM;
+                goto on_error;
+            }
+            pj_list_init(tp_add);
+            pj_list_push_back(&stripe->tp_entry_freelist, tp_add);
+        }
     }
 
 #if defined(PJ_DEBUG) && PJ_DEBUG!=0
     status = pj_atomic_create(mgr->pool, 0, &mgr->tdata_counter);
-    if (status != PJ_SUCCESS) {
-        pj_lock_destroy(mgr->lock);
-        return status;
-    }
+    if (status != PJ_SUCCESS)
+        goto on_error;
 #endif
 
     /* Set transport state callback */
@@ -1688,6 +1851,11 @@ PJ_DEF(pj_status_t) pjsip_tpmgr_create( pj_pool_t *pool,
 
     *p_mgr = mgr;
     return PJ_SUCCESS;
+
+on_error:
+    destroy_stripes(mgr);
+    pj_lock_destroy(mgr->lock);
+    return status;
 }
 
 /* Get the interface to send packet to the specified address */
@@ -1920,26 +2088,30 @@ PJ_DEF(unsigned) pjsip_tpmgr_get_transport_count_by_type(pjsip_tpmgr *mgr,
     pj_hash_iterator_t itr_val;
     pj_hash_iterator_t *itr;
     int nr_of_transports = 0;
+    unsigned i;
 
-    pj_lock_acquire(mgr->lock);
+    for (i=0; i<mgr->stripe_cnt; ++i) {
+        tp_stripe *stripe = &mgr->stripes[i];
 
-    itr = pj_hash_first(mgr->table, &itr_val);
-    while (itr) {
-        transport *tp_entry = (transport *)pj_hash_this(mgr->table, itr);
-        if (type<0) {
-            nr_of_transports += (int)pj_list_size(tp_entry);
-        } else {
-            transport *node = tp_entry->next;
-            for (; node!=tp_entry; node=node->next) {
-                if (tp_entry->tp->key.type==type)
-                    ++nr_of_transports;
+        pj_lock_acquire(stripe->lock);
+        itr = pj_hash_first(stripe->table, &itr_val);
+        while (itr) {
+            transport *tp_entry = (transport *)pj_hash_this(stripe->table,
+                                                            itr);
+            if (type<0) {
+                nr_of_transports += (int)pj_list_size(tp_entry);
+            } else {
+                transport *node = tp_entry->next;
+                for (; node!=tp_entry; node=node->next) {
+                    if (tp_entry->tp->key.type==type)
+                        ++nr_of_transports;
+                }
             }
+            itr = pj_hash_next(stripe->table, itr);
         }
-        itr = pj_hash_next(mgr->table, itr);
+        pj_lock_release(stripe->lock);
     }
 
-    pj_lock_release(mgr->lock);
-
     return nr_of_transports;
 }
 
@@ -1954,6 +2126,7 @@ PJ_DEF(pj_status_t) pjsip_tpmgr_destroy( pjsip_tpmgr *mgr )
     pj_hash_iterator_t *itr;
     pjsip_tpfactory *factory;
     pjsip_endpoint *endpt = mgr->endpt;
+    unsigned i;
 
     PJ_LOG(5, (THIS_FILE, "Destroying transport manager"));
 
@@ -1962,12 +2135,18 @@ PJ_DEF(pj_status_t) pjsip_tpmgr_destroy( pjsip_tpmgr *mgr )
     /*
      * Destroy all transports in the hash table.
      */
-    for (itr = pj_hash_first(mgr->table, &itr_val); itr;
-         itr = pj_hash_first(mgr->table, &itr_val))
-    {
-        transport *tp_ref;
-        tp_ref = pj_hash_this(mgr->table, itr);
-        destroy_transport(mgr, tp_ref->tp);
+    for (i=0; i<mgr->stripe_cnt; ++i) {
+        tp_stripe *stripe = &mgr->stripes[i];
+
+        pj_lock_acquire(stripe->lock);
+        for (itr = pj_hash_first(stripe->table, &itr_val); itr;
+             itr = pj_hash_first(stripe->table, &itr_val))
+        {
+            transport *tp_ref;
+            tp_ref = pj_hash_this(stripe->table, itr);
+            destroy_transport(mgr, tp_ref->tp);
+        }
+        pj_lock_release(stripe->lock);
     }
 
     /*
@@ -2013,6 +2192,7 @@ PJ_DEF(pj_status_t) pjsip_tpmgr_destroy( pjsip_tpmgr *mgr )
     pj_atomic_destroy(mgr->tdata_counter);
 #endif
 
+    destroy_stripes(mgr);
     pj_lock_destroy(mgr->lock);
 
     /* Unregister mod_msg_print. */
@@ -2050,6 +2230,7 @@ PJ_DEF(pj_status_t) pjsip_tpmgr_shutdown_all(
 {
     pj_hash_iterator_t itr_val;
     pj_hash_iterator_t *itr;
+    unsigned i;
 
     PJ_ASSERT_RETURN(mgr, PJ_EINVAL);
 
@@ -2057,23 +2238,30 @@ PJ_DEF(pj_status_t) pjsip_tpmgr_shutdown_all(
 
     pj_lock_acquire(mgr->lock);
 
-    itr = pj_hash_first(mgr->table, &itr_val);
-    while (itr) {
-        transport *tp_entry = (transport*)pj_hash_this(mgr->table, itr);
-        if (tp_entry) {
-            transport *tp_iter = tp_entry;
-            do {
-                pjsip_transport *tp = tp_iter->tp;
-                if (prm->include_udp ||
-                    ((tp->key.type & ~PJSIP_TRANSPORT_IPV6) !=
-                            PJSIP_TRANSPORT_UDP))
-                {
-                    pjsip_transport_shutdown2(tp, prm->force);
-                }
-                tp_iter = tp_iter->next;
-            } while (tp_iter != tp_entry);
+    for (i=0; i<mgr->stripe_cnt; ++i) {
+        tp_stripe *stripe = &mgr->stripes[i];
+
+        pj_lock_acquire(stripe->lock);
+        itr = pj_hash_first(stripe->table, &itr_val);
+        while (itr) {
+            transport *tp_entry = (transport*)pj_hash_this(stripe->table,
+                                                           itr);
+            if (tp_entry) {
+                transport *tp_iter = tp_entry;
+                do {
+                    pjsip_transport *tp = tp_iter->tp;
+                    if (prm->include_udp ||
+                        ((tp->key.type & ~PJSIP_TRANSPORT_IPV6) !=
+                                PJSIP_TRANSPORT_UDP))
+                    {
+                        pjsip_transport_shutdown2(tp, prm->force);
+                    }
+                    tp_iter = tp_iter->next;
+                } while (tp_iter != tp_entry);
+            }
+            itr = pj_hash_next(stripe->table, itr);
         }
-        itr = pj_hash_next(mgr->table, itr);
+        pj_lock_release(stripe->lock);
     }
 
     pj_lock_release(mgr->lock);
@@ -2417,6 +2605,8 @@ PJ_DEF(pj_ssize_t) pjsip_tpmgr_receive_packet( pjsip_tpmgr *mgr,
 
 
 finish_process_fragment:
+        pjsip_rx_data_release_rsp_hdr(rdata);
+
         total_processed += msg_fragment_size;
         current_pkt += msg_fragment_size;
         remaining_len -= msg_fragment_size;
@@ -2446,11 +2636,87 @@ PJ_DEF(pj_status_t) pjsip_tpmgr_acquire_transport(pjsip_tpmgr *mgr,
 }
 
 
+/*
+ * Find a transport registered with the key that can be used to send to
+ * the destination, and add reference to it. Only the stripe of the key
+ * is locked.
+ */
+static pjsip_transport *find_transport(pjsip_tpmgr *mgr,
+                                       const pjsip_transport_key *key,
+                                       int key_len,
+                                       const pjsip_tpselector *sel,
+                                       const pjsip_tx_data *tdata)
+{
+    unsigned flag = pjsip_transport_get_flag_from_type(key->type);
+    pjsip_transport *tp_ref = NULL;
+    transport *tp_entry;
+    tp_stripe *stripe;
+    pj_uint32_t hval;
+
+    stripe = get_stripe(mgr, key, key_len, &hval);
+    pj_lock_acquire(stripe->lock);
+
+    tp_entry = (transport *)pj_hash_get(stripe->table, key, key_len, &hval);
+    if (tp_entry) {
+        transport *tp_iter = tp_entry;
+
+        TRACE_((THIS_FILE, "Found one, checking further (e.g: "
+                           "destroying, verify hostname, etc).."));
+
+        do {
+            /* Don't use transport being shutdown/destroyed */
+            if (!tp_iter->tp->is_shutdown &&
+                !tp_iter->tp->is_destroying)
+            {
+                if ((flag & PJSIP_TRANSPORT_SECURE) && tdata) {
+                    /* For secure transport, make sure tdata's
+                     * destination host matches the transport's
+                     * remote host.
+                     */
+                    if (pj_stricmp(&tdata->dest_info.name,
+                                   &tp_iter->tp->remote_name.host))
+                    {
+                        TRACE_((THIS_FILE, "Skipping secure transport "
+                                           "with different hostname"));
+                        tp_iter = tp_iter->next;
+                        continue;
+                    }
+                }
+
+                if (sel && sel->type == PJSIP_TPSELECTOR_LISTENER &&
+                    sel->u.listener)
+                {
+                    /* Match listener if selector is set */
+                    if (tp_iter->tp->factory == sel->u.listener) {
+                        tp_ref = tp_iter->tp;
+                        break;
+                    }
+                    TRACE_((THIS_FILE, "Skipping transport "
+                                       "with different listener"));
+                } else {
+                    tp_ref = tp_iter->tp;
+                    break;
+                }
+            }
+            tp_iter = tp_iter->next;
+        } while (tp_iter != tp_entry);
+    }
+
+    if (tp_ref)
+        pjsip_transport_add_ref(tp_ref);
+
+    pj_lock_release(stripe->lock);
+
+    return tp_ref;
+}
+
 /*
  * pjsip_tpmgr_acquire_transport2()
  *
  * Get transport suitable to communicate to remote. Create a new one
- * if necessary.
+ * if necessary. Existing transports are looked up with only the lock
+ * of the transport table stripe, the transport manager lock is only
+ * held when a new transport needs to be created.
  */
 PJ_DEF(pj_status_t) pjsip_tpmgr_acquire_transport2(pjsip_tpmgr *mgr,
                                                    pjsip_transport_type_e type,
@@ -2461,6 +2727,10 @@ PJ_DEF(pj_status_t) pjsip_tpmgr_acquire_transport2(pjsip_tpmgr *mgr,
                                                    pjsip_transport **tp)
 {
     pjsip_tpfactory *factory;
+    pjsip_transport_key key;
+    int key_len;
+    pjsip_transport *tp_ref = NULL;
+    pj_bool_t reuse;
     pj_status_t status;
 
     TRACE_((THIS_FILE, "Acquiring transport type=%s, sel=%s remote=%s:%d "
@@ -2472,10 +2742,6 @@ PJ_DEF(pj_status_t) pjsip_tpmgr_acquire_transport2(pjsip_tpmgr *mgr,
                        tdata? tdata->dest_info.name.slen : 10,
                        tdata? tdata->dest_info.name.ptr  : "-no tdata-"));
 
-    pj_lock_acquire(mgr->lock);
-
-    TRACE_((THIS_FILE, "Acquiring transport got the lock"));
-
     /* If transport is specified, then just use it if it is suitable
      * for the destination.
      */
@@ -2483,17 +2749,22 @@ PJ_DEF(pj_status_t) pjsip_tpmgr_acquire_transport2(pjsip_tpmgr *mgr,
         sel->u.transport) 
     {
         pjsip_transport *seltp = sel->u.transport;
+        tp_stripe *stripe;
+        pj_uint32_t hval;
 
         /* See if the transport is (not) suitable */
         if (seltp->key.type != type) {
-            pj_lock_release(mgr->lock);
             TRACE_((THIS_FILE, "Transport type in tpsel not matched"));
             return PJSIP_ETPNOTSUITABLE;
         }
 
         /* Make sure the transport is not being destroyed */
+        stripe = get_stripe(mgr, &seltp->key,
+                            sizeof(seltp->key.type) + seltp->addr_len,
+                            &hval);
+        pj_lock_acquire(stripe->lock);
         if (seltp->is_destroying) {
-            pj_lock_release(mgr->lock);
+            pj_lock_release(stripe->lock);
             TRACE_((THIS_FILE,"Transport to be acquired is being destroyed"));
             return PJ_ENOTFOUND;
         }
@@ -2509,234 +2780,151 @@ PJ_DEF(pj_status_t) pjsip_tpmgr_acquire_transport2(pjsip_tpmgr *mgr,
 
         /* Transport looks to be suitable to use, so just use it. */
         pjsip_transport_add_ref(seltp);
-        pj_lock_release(mgr->lock);
+        pj_lock_release(stripe->lock);
         *tp = seltp;
 
         TRACE_((THIS_FILE, "Transport %s acquired", seltp->obj_name));
         return PJ_SUCCESS;
+    }
 
-    } else {
-
-        /*
-         * This is the "normal" flow, where application doesn't specify
-         * specific transport to be used to send message to.
-         * In this case, lookup the transport from the hash table.
-         */
-        pjsip_transport_key key;
-        int key_len;
-        pjsip_transport *tp_ref = NULL;
-        transport *tp_entry = NULL;
-        unsigned flag = pjsip_transport_get_flag_from_type(type);
+    /*
+     * This is the "normal" flow, where application doesn't specify
+     * specific transport to be used to send message to.
+     * In this case, lookup the transport from the hash table.
+     */
 
-        /* If listener is specified, verify that the listener type matches
-         * the destination type.
-         */
-        if (sel && sel->type == PJSIP_TPSELECTOR_LISTENER && sel->u.listener)
+    /* If listener is specified, verify that the listener type matches
+     * the destination type.
+     */
+    if (sel && sel->type == PJSIP_TPSELECTOR_LISTENER && sel->u.listener)
+    {
+        if (sel->u.listener->type != type) {
+            TRACE_((THIS_FILE, "Listener type in tpsel not matched"));
+            return PJSIP_ETPNOTSUITABLE;
+        }
+    } else if (sel && sel->type == PJSIP_TPSELECTOR_IP_VER) {
+        if ((sel->u.ip_ver == PJSIP_TPSELECTOR_USE_IPV4_ONLY &&
+             pjsip_transport_type_get_af(type) != pj_AF_INET()) ||
+            (sel->u.ip_ver == PJSIP_TPSELECTOR_USE_IPV6_ONLY &&
+             pjsip_transport_type_get_af(type) != pj_AF_INET6()))
         {
-            if (sel->u.listener->type != type) {
-                pj_lock_release(mgr->lock);
-                TRACE_((THIS_FILE, "Listener type in tpsel not matched"));
-                return PJSIP_ETPNOTSUITABLE;
-            }
-        } else if (sel && sel->type == PJSIP_TPSELECTOR_IP_VER) {
-            if ((sel->u.ip_ver == PJSIP_TPSELECTOR_USE_IPV4_ONLY &&
-                 pjsip_transport_type_get_af(type) != pj_AF_INET()) ||
-                (sel->u.ip_ver == PJSIP_TPSELECTOR_USE_IPV6_ONLY &&
-                 pjsip_transport_type_get_af(type) != pj_AF_INET6()))
-            {
-                pj_lock_release(mgr->lock);
-                TRACE_((THIS_FILE, "Address type in tpsel not matched"));
-                return PJSIP_ETPNOTSUITABLE;
-            }
+            TRACE_((THIS_FILE, "Address type in tpsel not matched"));
+            return PJSIP_ETPNOTSUITABLE;
         }
+    }
 
-        if (!sel || sel->disable_connection_reuse == PJ_FALSE) {
-            pj_bzero(&key, sizeof(key));
-            key_len = sizeof(key.type) + addr_len;
-
-            TRACE_((THIS_FILE, "Search transport by remote address"));
-
-            /* First try to get exact destination. */
-            key.type = type;
-            pj_memcpy(&key.rem_addr, remote, addr_len);
+    pj_bzero(&key, sizeof(key));
+    key_len = sizeof(key.type) + addr_len;
+    key.type = type;
+    pj_memcpy(&key.rem_addr, remote, addr_len);
 
-            tp_entry = (transport *)pj_hash_get(mgr->table, &key, key_len,
-                                                NULL);
-            if (tp_entry) {
-                transport *tp_iter = tp_entry;
+    reuse = (!sel || sel->disable_connection_reuse == PJ_FALSE);
+    if (reuse) {
+        pjsip_transport_key zero_key;
+        unsigned flag = pjsip_transport_get_flag_from_type(type);
 
-                TRACE_((THIS_FILE, "Found one, checking further (e.g: "
-                                   "destroying, verify hostname, etc).."));
+        TRACE_((THIS_FILE, "Search transport by remote address"));
 
-                do {
-                    /* Don't use transport being shutdown/destroyed */
-                    if (!tp_iter->tp->is_shutdown &&
-                        !tp_iter->tp->is_destroying)
-                    {
-                        if ((flag & PJSIP_TRANSPORT_SECURE) && tdata) {
-                            /* For secure transport, make sure tdata's
-                             * destination host matches the transport's
-                             * remote host.
-                             */
-                            if (pj_stricmp(&tdata->dest_info.name,
-                                           &tp_iter->tp->remote_name.host))
-                            {
-                                TRACE_((THIS_FILE, "Skipping secure transport "
-                                                   "with different hostname"));
-                                tp_iter = tp_iter->next;
-                                continue;
-                            }
-                        }
-
-                        if (sel && sel->type == PJSIP_TPSELECTOR_LISTENER &&
-                            sel->u.listener)
-                        {
-                            /* Match listener if selector is set */
-                            if (tp_iter->tp->factory == sel->u.listener) {
-                                tp_ref = tp_iter->tp;
-                                break;
-                            }
-                            TRACE_((THIS_FILE, "Skipping transport "
-                                               "with different listener"));
-                        } else {
-                            tp_ref = tp_iter->tp;
-                            break;
-                        }
-                    }
-                    tp_iter = tp_iter->next;
-                } while (tp_iter != tp_entry);
+        /* First try to get exact destination. */
+        tp_ref = find_transport(mgr, &key, key_len, sel, tdata);
 
-                TRACE_((THIS_FILE, "Search by remote address found %s",
-                                   tp_ref? "one" : "none"));
-            }
-        }
+        TRACE_((THIS_FILE, "Search by remote address found %s",
+                           tp_ref? "one" : "none"));
 
+        /* Ignore address for loop transports, and for datagram
+         * transports, try lookup with zero address.
+         */
         if (tp_ref == NULL &&
-            (!sel || sel->disable_connection_reuse == PJ_FALSE))
+            (type == PJSIP_TRANSPORT_LOOP ||
+             type == PJSIP_TRANSPORT_LOOP_DGRAM ||
+             (flag & PJSIP_TRANSPORT_DATAGRAM)))
         {
-            const pj_sockaddr *remote_addr = (const pj_sockaddr*)remote;
-
             TRACE_((THIS_FILE, "Search loop & datagram transports "
                                "with address zero"));
 
-            /* Ignore address for loop transports. */
-            if (type == PJSIP_TRANSPORT_LOOP ||
-                type == PJSIP_TRANSPORT_LOOP_DGRAM)
+            pj_bzero(&zero_key, sizeof(zero_key));
+            zero_key.type = type;
+            if (type != PJSIP_TRANSPORT_LOOP &&
+                type != PJSIP_TRANSPORT_LOOP_DGRAM)
             {
-                pj_sockaddr *addr = &key.rem_addr;
-
-                pj_bzero(addr, addr_len);
-                key_len = sizeof(key.type) + addr_len;
-                tp_entry = (transport *) pj_hash_get(mgr->table, &key,
-                                                     key_len, NULL);
-                if (tp_entry) {
-                    tp_ref = tp_entry->tp;
-                }
-            }
-            /* For datagram transports, try lookup with zero address.
-             */
-            else if (flag & PJSIP_TRANSPORT_DATAGRAM)
-            {
-                pj_sockaddr *addr = &key.rem_addr;
-
-                pj_bzero(addr, addr_len);
-                addr->addr.sa_family = remote_addr->addr.sa_family;
-
-                key_len = sizeof(key.type) + addr_len;
-                tp_entry = (transport *) pj_hash_get(mgr->table, &key,
-                                                     key_len, NULL);
-                if (tp_entry) {
-                    transport *tp_iter = tp_entry;
-                    do {
-                        tp_ref = tp_iter->tp;
-                        if (!tp_ref->is_shutdown && !tp_ref->is_destroying)
-                            break;
-                        tp_iter = tp_iter->next;
-                    } while (tp_iter != tp_entry);
-                }
+                zero_key.rem_addr.addr.sa_family =
+                    ((const pj_sockaddr*)remote)->addr.sa_family;
             }
+            tp_ref = find_transport(mgr, &zero_key, key_len, NULL, NULL);
 
             TRACE_((THIS_FILE, "Search loop & datagram transports found %s",
                                tp_ref? "one" : "none"));
         }
 
-        /* If transport is found and listener is specified, verify listener */
-        else if (sel && sel->type == PJSIP_TPSELECTOR_LISTENER &&
-                 sel->u.listener && tp_ref && tp_ref->factory != sel->u.listener)
-        {
-            tp_ref = NULL;
-            /* This will cause a new transport to be created which will be a
-             * 'duplicate' of the existing transport (same type & remote addr,
-             * but different factory).
-             */
-            TRACE_((THIS_FILE, "Transport found but from different listener"));
-        }
-
-        if (tp_ref!=NULL && !tp_ref->is_shutdown && !tp_ref->is_destroying) {
+        if (tp_ref) {
             /*
              * Transport found!
              */
-            pjsip_transport_add_ref(tp_ref);
-            pj_lock_release(mgr->lock);
             *tp = tp_ref;
 
             TRACE_((THIS_FILE, "Transport %s acquired", tp_ref->obj_name));
             return PJ_SUCCESS;
         }
+    }
 
+    pj_lock_acquire(mgr->lock);
 
-        /*
-         * Either transport not found, or we don't want to use the existing
-         * transport (such as in the case of different factory or
-         * if connection reuse is disabled). So we need to create one,
-         * find factory that can create such transport.
-         *
-         * If there's an existing transport, its place in the hash table
-         * will be replaced by this new one. And eventually the existing
-         * transport will still be freed (by application or #1774).
-         */
-        if (sel && sel->type == PJSIP_TPSELECTOR_LISTENER && sel->u.listener)
-        {
-            /* Application has requested that a specific listener is to
-             * be used.
-             */
+    TRACE_((THIS_FILE, "Acquiring transport got the lock"));
 
-            /* Verify that the listener type matches the destination type */
-            /* Already checked above. */
-            /*
-            if (sel->u.listener->type != type) {
-                pj_lock_release(mgr->lock);
-                return PJSIP_ETPNOTSUITABLE;
-            }
-            */
+    /* Another thread may have created the transport while we were not
+     * holding the transport manager lock.
+     */
+    if (reuse) {
+        tp_ref = find_transport(mgr, &key, key_len, sel, tdata);
+        if (tp_ref) {
+            pj_lock_release(mgr->lock);
+            *tp = tp_ref;
 
-            /* We'll use this listener to create transport */
-            factory = sel->u.listener;
+            TRACE_((THIS_FILE, "Transport %s acquired", tp_ref->obj_name));
+            return PJ_SUCCESS;
+        }
+    }
 
-            /* Verify if listener is still valid */
-            if (!pjsip_tpmgr_is_tpfactory_valid(mgr, factory)) {
-                pj_lock_release(mgr->lock);
-                PJ_LOG(3,(THIS_FILE, "Specified factory for creating "
-                                     "transport is not found"));
-                return PJ_ENOTFOUND;
-            }
+    /*
+     * Either transport not found, or we don't want to use the existing
+     * transport (such as in the case of different factory or
+     * if connection reuse is disabled). So we need to create one,
+     * find factory that can create such transport.
+     *
+     * If there's an existing transport, its place in the hash table
+     * will be replaced by this new one. And eventually the existing
+     * transport will still be freed (by application or #1774).
+     */
+    if (sel && sel->type == PJSIP_TPSELECTOR_LISTENER && sel->u.listener)
+    {
+        /* Application has requested that a specific listener is to
+         * be used. The listener type has been verified above.
+         */
+        factory = sel->u.listener;
 
-        } else {
+        /* Verify if listener is still valid */
+        if (!pjsip_tpmgr_is_tpfactory_valid(mgr, factory)) {
+            pj_lock_release(mgr->lock);
+            PJ_LOG(3,(THIS_FILE, "Specified factory for creating "
+                                 "transport is not found"));
+            return PJ_ENOTFOUND;
+        }
 
-            /* Find factory with type matches the destination type */
-            factory = mgr->factory_list.next;
-            while (factory != &mgr->factory_list) {
-                if (factory->type == type)
-                    break;
-                factory = factory->next;
-            }
+    } else {
 
-            if (factory == &mgr->factory_list) {
-                /* No factory can create the transport! */
-                pj_lock_release(mgr->lock);
-                TRACE_((THIS_FILE, "No suitable factory was found either"));
-                return PJSIP_EUNSUPTRANSPORT;
-            }
+        /* Find factory with type matches the destination type */
+        factory = mgr->factory_list.next;
+        while (factory != &mgr->factory_list) {
+            if (factory->type == type)
+                break;
+            factory = factory->next;
+        }
+
+        if (factory == &mgr->factory_list) {
+            /* No factory can create the transport! */
+            pj_lock_release(mgr->lock);
+            TRACE_((THIS_FILE, "No suitable factory was found either"));
+            return PJSIP_EUNSUPTRANSPORT;
         }
     }
 
@@ -2771,6 +2959,7 @@ PJ_DEF(void) pjsip_tpmgr_dump_transports(pjsip_tpmgr *mgr)
     pj_hash_iterator_t itr_val;
     pj_hash_iterator_t *itr;
     pjsip_tpfactory *factory;
+    unsigned i;
 
     pj_lock_acquire(mgr->lock);
 
@@ -2791,17 +2980,21 @@ PJ_DEF(void) pjsip_tpmgr_dump_transports(pjsip_tpmgr *mgr)
         factory = factory->next;
     }
 
-    itr = pj_hash_first(mgr->table, &itr_val);
-    if (itr) {
-        PJ_LOG(3, (THIS_FILE, " Dumping transports:"));
+    PJ_LOG(3, (THIS_FILE, " Dumping transports:"));
+    for (i=0; i<mgr->stripe_cnt; ++i) {
+        tp_stripe *stripe = &mgr->stripes[i];
 
-        do {
-            transport *tp_entry = (transport *) pj_hash_this(mgr->table, itr);
+        pj_lock_acquire(stripe->lock);
+        itr = pj_hash_first(stripe->table, &itr_val);
+        while (itr) {
+            transport *tp_entry = (transport *)pj_hash_this(stripe->table,
+                                                            itr);
             if (tp_entry) {
                 transport *tp_iter = tp_entry;
 
                 do {
                     pjsip_transport *tp_ref = tp_iter->tp;
+                    long ref_cnt = pj_atomic_get(tp_ref->ref_cnt);
 
                     PJ_LOG(3, (THIS_FILE, "  %s %s%s%s%s(refcnt=%ld%s)",
                                tp_ref->obj_name,
@@ -2809,14 +3002,16 @@ PJ_DEF(void) pjsip_tpmgr_dump_transports(pjsip_tpmgr *mgr)
                                (tp_ref->factory)?" listener[":"",
                                (tp_ref->factory)?tp_ref->factory->obj_name:"",
                                (tp_ref->factory)?"]":"",
-                               pj_atomic_get(tp_ref->ref_cnt),
-                               (tp_ref->idle_timer.id ? " [idle]" : "")));
+                               ref_cnt,
+                               (tp_ref->idle_timer.id && ref_cnt == 0 ?
+                                    " [idle]" : "")));
 
                     tp_iter = tp_iter->next;
                 } while (tp_iter != tp_entry);
             }
-            itr = pj_hash_next(mgr->table, itr);
-        } while (itr);
+            itr = pj_hash_next(stripe->table, itr);
+        }
+        pj_lock_release(stripe->lock);
     }
 
     pj_lock_release(mgr->lock);
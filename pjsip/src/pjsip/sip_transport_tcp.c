@@ -934,7 +934,7 @@ static pj_status_t tcp_start_read(struct tcp_transport *tcp)
     /* Init rdata */
     pool = pjsip_endpt_create_pool(tcp->base.endpt,
                                    "rtd%p",
-                                   PJSIP_POOL_RDATA_LEN,
+                                   PJSIP_POOL_RDATA_CONN_LEN,
                                    PJSIP_POOL_RDATA_INC);
     if (!pool) {
         tcp_perror(tcp->base.obj_name, "Unable to create pool", PJ_ENOMEM);
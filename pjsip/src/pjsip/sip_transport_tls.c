@@ -343,6 +343,9 @@ static void set_ssock_param(pj_ssl_sock_param *ssock_param,
 
     ssock_param->enable_renegotiation =
                                     listener->tls_setting.enable_renegotiation;
+    ssock_param->session_resumption = listener->tls_setting.session_resumption;
+    ssock_param->session_timeout = listener->tls_setting.session_timeout;
+    ssock_param->async_handshake = listener->tls_setting.async_handshake;
     /* Copy the sockopt */
     if (listener->tls_setting.sockopt_params.cnt > 0) {
         pj_memcpy(&ssock_param->sockopt_params, 
@@ -1160,7 +1163,7 @@ static pj_status_t tls_start_read(struct tls_transport *tls)
     /* Init rdata */
     pool = pjsip_endpt_create_pool(tls->base.endpt,
                                    "rtd%p",
-                                   PJSIP_POOL_RDATA_LEN,
+                                   PJSIP_POOL_RDATA_CONN_LEN,
                                    PJSIP_POOL_RDATA_INC);
     if (!pool) {
         tls_perror(tls->base.obj_name, "Unable to create pool", PJ_ENOMEM,
@@ -1283,6 +1286,9 @@ static pj_status_t lis_create_transport(pjsip_tpfactory *factory,
                                      listener->tls_setting.sockopt_ignore_error;
 
     ssock_param.enable_renegotiation = listener->tls_setting.enable_renegotiation;
+    ssock_param.session_resumption = listener->tls_setting.session_resumption;
+    ssock_param.session_timeout = listener->tls_setting.session_timeout;
+    ssock_param.async_handshake = listener->tls_setting.async_handshake;
     /* Copy the sockopt */
     if (listener->tls_setting.sockopt_params.cnt > 0) {
         pj_memcpy(&ssock_param.sockopt_params, 
@@ -65,12 +65,29 @@
 #endif
 
 
+/* One of the sockets backing the UDP transport. When there are more than
+ * one, they are all bound to the same address with SO_REUSEPORT.
+ */
+struct udp_shard
+{
+    pj_sock_t           sock;
+    pj_ioqueue_key_t   *key;
+
+    /* Own ioqueue and the thread polling it, if sock_worker_thread is
+     * enabled. Otherwise the socket is registered to endpoint's ioqueue.
+     */
+    pj_ioqueue_t       *ioqueue;
+    pj_thread_t        *thread;
+    pj_bool_t           quit_thread;
+};
+
 /* Struct udp_transport "inherits" struct pjsip_transport */
 struct udp_transport
 {
     pjsip_transport     base;
-    pj_sock_t           sock;
-    pj_ioqueue_key_t   *key;
+    unsigned            shard_cnt;
+    struct udp_shard   *shards;
+    unsigned            async_cnt;
     int                 rdata_cnt;
     pjsip_rx_data     **rdata;
     int                 is_closing;
@@ -82,6 +99,16 @@ struct udp_transport
 };
 
 
+/*
+ * Get the ioqueue key of the socket where the rdata is read from. Each
+ * socket has async_cnt rdata.
+ */
+static pj_ioqueue_key_t *get_rdata_key(struct udp_transport *tp,
+                                       unsigned rdata_index)
+{
+    return tp->shards[rdata_index / tp->async_cnt].key;
+}
+
 /*
  * Initialize transport's receive buffer from the specified pool.
  */
@@ -382,7 +409,7 @@ static pj_status_t udp_send_msg( pjsip_transport *transport,
 
     /* Send to ioqueue! */
     size = tdata->buf.cur - tdata->buf.start;
-    status = pj_ioqueue_sendto(tp->key, (pj_ioqueue_op_key_t*)&tdata->op_key,
+    status = pj_ioqueue_sendto(tp->shards[0].key, (pj_ioqueue_op_key_t*)&tdata->op_key,
                                tdata->buf.start, &size, 0,
                                rem_addr, addr_len);
 
@@ -438,6 +465,32 @@ static void udp_on_destroy(void *arg)
 }
 
 
+/*
+ * Unregister all sockets from ioqueue, which also closes them, or close
+ * the sockets if they have not been registered.
+ */
+static void close_sockets(struct udp_transport *tp)
+{
+    unsigned i;
+
+    for (i=0; i<tp->shard_cnt; ++i) {
+        struct udp_shard *shard = &tp->shards[i];
+
+        if (shard->key) {
+            /* This implicitly closes the socket */
+            pj_ioqueue_unregister(shard->key);
+            shard->key = NULL;
+        } else {
+            /* Close socket. */
+            if (shard->sock != PJ_INVALID_SOCKET) {
+                pj_sock_close(shard->sock);
+            }
+        }
+        shard->sock = PJ_INVALID_SOCKET;
+    }
+}
+
+
 /*
  * udp_destroy()
  *
@@ -459,22 +512,13 @@ static pj_status_t udp_destroy( pjsip_transport *transport )
      *      and another one for closing the socket.
      *
     for (i=0; i<tp->rdata_cnt; ++i) {
-        pj_ioqueue_post_completion(tp->key, 
+        pj_ioqueue_post_completion(get_rdata_key(tp, i), 
                                    &tp->rdata[i]->tp_info.op_key.op_key, -1);
     }
     */
 
     /* Unregister from ioqueue. */
-    if (tp->key) {
-        pj_ioqueue_unregister(tp->key);
-        tp->key = NULL;
-    } else {
-        /* Close socket. */
-        if (tp->sock != PJ_INVALID_SOCKET) {
-            pj_sock_close(tp->sock);
-            tp->sock = PJ_INVALID_SOCKET;
-        }
-    }
+    close_sockets(tp);
 
     /* Must poll ioqueue because IOCP calls the callback when socket
      * is closed. We poll the ioqueue until all pending callbacks 
@@ -490,6 +534,24 @@ static pj_status_t udp_destroy( pjsip_transport *transport )
             break;
     }
 
+    /* Stop the socket worker threads, which poll the remaining callbacks
+     * of their own ioqueue before quitting.
+     */
+    for (i=0; i<(int)tp->shard_cnt; ++i) {
+        struct udp_shard *shard = &tp->shards[i];
+
+        if (shard->thread) {
+            shard->quit_thread = PJ_TRUE;
+            pj_thread_join(shard->thread);
+            pj_thread_destroy(shard->thread);
+            shard->thread = NULL;
+        }
+        if (shard->ioqueue) {
+            pj_ioqueue_destroy(shard->ioqueue);
+            shard->ioqueue = NULL;
+        }
+    }
+
     /* When creating this transport, reference count was incremented to flag
      * this transport as permanent so it will not be destroyed by transport
      * manager whenever idle. Application may or may not have cleared the
@@ -524,19 +586,40 @@ static pj_status_t udp_shutdown(pjsip_transport *transport)
 }
 
 
-/* Create socket */
+/* Create socket, optionally with SO_REUSEPORT so that several sockets
+ * can be bound to the same address.
+ */
 static pj_status_t create_socket(int af, const pj_sockaddr_t *local_a,
-                                 int addr_len, pj_sock_t *p_sock)
+                                 int addr_len, pj_bool_t reuse_port,
+                                 pj_sock_t *p_sock)
 {
     pj_sock_t sock;
     pj_sockaddr_in tmp_addr;
     pj_sockaddr_in6 tmp_addr6;
     pj_status_t status;
 
+#if !defined(SO_REUSEPORT)
+    if (reuse_port)
+        return PJ_ENOTSUP;
+#endif
+
     status = pj_sock_socket(af, pj_SOCK_DGRAM() | pj_SOCK_CLOEXEC(), 0, &sock);
     if (status != PJ_SUCCESS)
         return status;
 
+#if defined(SO_REUSEPORT)
+    if (reuse_port) {
+        int enabled = 1;
+
+        status = pj_sock_setsockopt(sock, pj_SOL_SOCKET(), SO_REUSEPORT,
+                                    &enabled, sizeof(enabled));
+        if (status != PJ_SUCCESS) {
+            pj_sock_close(sock);
+            return status;
+        }
+    }
+#endif
+
     if (local_a == NULL) {
         if (af == pj_AF_INET6()) {
             pj_bzero(&tmp_addr6, sizeof(tmp_addr6));
@@ -662,6 +745,7 @@ static void udp_set_pub_name(struct udp_transport *tp,
 
 /* Set the socket handle of the transport */
 static void udp_set_socket(struct udp_transport *tp,
+                           unsigned shard_idx,
                            pj_sock_t sock,
                            const pjsip_host_port *a_name)
 {
@@ -691,23 +775,50 @@ static void udp_set_socket(struct udp_transport *tp,
 #endif
 
     /* Set the socket. */
-    tp->sock = sock;
+    tp->shards[shard_idx].sock = sock;
 
     /* Init address name (published address) */
-    udp_set_pub_name(tp, a_name);
+    if (a_name)
+        udp_set_pub_name(tp, a_name);
 }
 
-/* Register socket to ioqueue */
+/* Worker thread polling the own ioqueue of a socket */
+static int udp_worker_thread(void *arg)
+{
+    struct udp_shard *shard = (struct udp_shard*)arg;
+
+    while (!shard->quit_thread) {
+        pj_time_val timeout = {0, 10};
+        pj_ioqueue_poll(shard->ioqueue, &timeout);
+    }
+
+    return 0;
+}
+
+/* Create the own ioqueue and worker thread of a socket */
+static pj_status_t start_worker_thread(struct udp_transport *tp,
+                                       struct udp_shard *shard)
+{
+    pj_status_t status;
+
+    /* Only one socket is registered, but leave room for the keys
+     * being closed when the transport is restarted.
+     */
+    status = pj_ioqueue_create(tp->base.pool, 4, &shard->ioqueue);
+    if (status != PJ_SUCCESS)
+        return status;
+
+    return pj_thread_create(tp->base.pool, "udpw%p", &udp_worker_thread,
+                            shard, 0, 0, &shard->thread);
+}
+
+/* Register sockets to ioqueue */
 static pj_status_t register_to_ioqueue(struct udp_transport *tp)
 {
-    pj_ioqueue_t *ioqueue;
     pj_ioqueue_callback ioqueue_cb;
+    unsigned i;
     pj_status_t status;
 
-    /* Ignore if already registered */
-    if (tp->key != NULL)
-        return PJ_SUCCESS;
-
     /* Create group lock if not yet (don't need to do so on UDP restart) */
     if (!tp->grp_lock) {
         status = pj_grp_lock_create(tp->base.pool, NULL, &tp->grp_lock);
@@ -722,13 +833,29 @@ static pj_status_t register_to_ioqueue(struct udp_transport *tp)
     }
     
     /* Register to ioqueue. */
-    ioqueue = pjsip_endpt_get_ioqueue(tp->base.endpt);
     pj_memset(&ioqueue_cb, 0, sizeof(ioqueue_cb));
     ioqueue_cb.on_read_complete = &udp_on_read_complete;
     ioqueue_cb.on_write_complete = &udp_on_write_complete;
 
-    return pj_ioqueue_register_sock2(tp->base.pool, ioqueue, tp->sock,
-                                     tp->grp_lock, tp, &ioqueue_cb, &tp->key);
+    for (i=0; i<tp->shard_cnt; ++i) {
+        struct udp_shard *shard = &tp->shards[i];
+        pj_ioqueue_t *ioqueue;
+
+        /* Ignore if already registered or socket is not available */
+        if (shard->key != NULL || shard->sock == PJ_INVALID_SOCKET)
+            continue;
+
+        ioqueue = shard->ioqueue? shard->ioqueue :
+                                  pjsip_endpt_get_ioqueue(tp->base.endpt);
+
+        status = pj_ioqueue_register_sock2(tp->base.pool, ioqueue,
+                                           shard->sock, tp->grp_lock, tp,
+                                           &ioqueue_cb, &shard->key);
+        if (status != PJ_SUCCESS)
+            return status;
+    }
+
+    return PJ_SUCCESS;
 }
 
 /* Start ioqueue asynchronous reading to all rdata */
@@ -739,11 +866,16 @@ static pj_status_t start_async_read(struct udp_transport *tp)
 
     /* Start reading the ioqueue. */
     for (i=0; i<tp->rdata_cnt; ++i) {
+        pj_ioqueue_key_t *key = get_rdata_key(tp, i);
         pj_ssize_t size;
 
+        /* Socket is not available (e.g. failed to recreate on restart) */
+        if (key == NULL)
+            continue;
+
         size = sizeof(tp->rdata[i]->pkt_info.packet);
         tp->rdata[i]->pkt_info.src_addr_len = sizeof(tp->rdata[i]->pkt_info.src_addr);
-        status = pj_ioqueue_recvfrom(tp->key, 
+        status = pj_ioqueue_recvfrom(key, 
                                      &tp->rdata[i]->tp_info.op_key.op_key,
                                      tp->rdata[i]->pkt_info.packet,
                                      &size, PJ_IOQUEUE_ALWAYS_ASYNC,
@@ -751,7 +883,7 @@ static pj_status_t start_async_read(struct udp_transport *tp)
                                      &tp->rdata[i]->pkt_info.src_addr_len);
         if (status == PJ_SUCCESS) {
             pj_assert(!"Shouldn't happen because PJ_IOQUEUE_ALWAYS_ASYNC!");
-            udp_on_read_complete(tp->key, &tp->rdata[i]->tp_info.op_key.op_key,
+            udp_on_read_complete(key, &tp->rdata[i]->tp_info.op_key.op_key,
                                  size);
         } else if (status != PJ_EPENDING) {
             /* Error! */
@@ -766,11 +898,14 @@ static pj_status_t start_async_read(struct udp_transport *tp)
 /*
  * pjsip_udp_transport_attach()
  *
- * Attach UDP socket and start transport.
+ * Attach UDP sockets and start transport. All sockets must be bound to
+ * the same address, the first one is used for sending.
  */
 static pj_status_t transport_attach( pjsip_endpoint *endpt,
                                      pjsip_transport_type_e type,
-                                     pj_sock_t sock,
+                                     const pj_sock_t sock[],
+                                     unsigned sock_cnt,
+                                     pj_bool_t sock_worker_thread,
                                      const pjsip_host_port *a_name,
                                      unsigned async_cnt,
                                      pjsip_transport **p_transport)
@@ -781,7 +916,8 @@ static pj_status_t transport_attach( pjsip_endpoint *endpt,
     unsigned i;
     pj_status_t status;
 
-    PJ_ASSERT_RETURN(endpt && sock!=PJ_INVALID_SOCKET && a_name && async_cnt>0,
+    PJ_ASSERT_RETURN(endpt && sock && sock_cnt>0 &&
+                     sock[0]!=PJ_INVALID_SOCKET && a_name && async_cnt>0,
                      PJ_EINVAL);
 
     /* Object name. */
@@ -814,6 +950,14 @@ static pj_status_t transport_attach( pjsip_endpoint *endpt,
 
     pj_memcpy(tp->base.obj_name, pool->obj_name, PJ_MAX_OBJ_NAME);
 
+    /* Init sockets. */
+    tp->shard_cnt = sock_cnt;
+    tp->shards = (struct udp_shard*)
+                 pj_pool_calloc(pool, sock_cnt, sizeof(struct udp_shard));
+    for (i=0; i<sock_cnt; ++i)
+        tp->shards[i].sock = PJ_INVALID_SOCKET;
+    tp->async_cnt = async_cnt;
+
     /* Init reference counter. */
     status = pj_atomic_create(pool, 0, &tp->base.ref_cnt);
     if (status != PJ_SUCCESS)
@@ -843,7 +987,7 @@ static pj_status_t transport_attach( pjsip_endpoint *endpt,
     tp->base.addr_len = sizeof(tp->base.local_addr);
 
     /* Init local address. */
-    status = pj_sock_getsockname(sock, &tp->base.local_addr, 
+    status = pj_sock_getsockname(sock[0], &tp->base.local_addr, 
                                  &tp->base.addr_len);
     if (status != PJ_SUCCESS)
         goto on_error;
@@ -863,8 +1007,18 @@ static pj_status_t transport_attach( pjsip_endpoint *endpt,
 
     /* Transport manager and timer will be initialized by tpmgr */
 
-    /* Attach socket and assign name. */
-    udp_set_socket(tp, sock, a_name);
+    /* Attach sockets and assign name. */
+    for (i=0; i<sock_cnt; ++i)
+        udp_set_socket(tp, i, sock[i], (i==0? a_name : NULL));
+
+    /* Start the worker threads polling the sockets, if configured */
+    if (sock_worker_thread) {
+        for (i=0; i<sock_cnt; ++i) {
+            status = start_worker_thread(tp, &tp->shards[i]);
+            if (status != PJ_SUCCESS)
+                goto on_error;
+        }
+    }
 
     /* Register to ioqueue */
     status = register_to_ioqueue(tp);
@@ -888,12 +1042,12 @@ static pj_status_t transport_attach( pjsip_endpoint *endpt,
      */
     pjsip_transport_add_ref(&tp->base);
 
-    /* Create rdata and put it in the array. */
+    /* Create rdata for each socket and put it in the array. */
     tp->rdata_cnt = 0;
     tp->rdata = (pjsip_rx_data**)
-                pj_pool_calloc(tp->base.pool, async_cnt, 
+                pj_pool_calloc(tp->base.pool, sock_cnt * async_cnt, 
                                sizeof(pjsip_rx_data*));
-    for (i=0; i<async_cnt; ++i) {
+    for (i=0; i<sock_cnt * async_cnt; ++i) {
         pj_pool_t *rdata_pool = pjsip_endpt_create_pool(endpt, "rtd%p", 
                                                         PJSIP_POOL_RDATA_LEN,
                                                         PJSIP_POOL_RDATA_INC);
@@ -919,13 +1073,15 @@ static pj_status_t transport_attach( pjsip_endpoint *endpt,
         *p_transport = &tp->base;
     
     PJ_LOG(4,(tp->base.obj_name, 
-              "SIP %s started, published address is %s%.*s%s:%d",
+              "SIP %s started, published address is %s%.*s%s:%d, "
+              "%d socket(s)",
               pjsip_transport_get_type_desc((pjsip_transport_type_e)tp->base.key.type),
               ipv6_quoteb,
               (int)tp->base.local_name.host.slen,
               tp->base.local_name.host.ptr,
               ipv6_quotee,
-              tp->base.local_name.port));
+              tp->base.local_name.port,
+              sock_cnt));
 
     return PJ_SUCCESS;
 
@@ -941,8 +1097,8 @@ PJ_DEF(pj_status_t) pjsip_udp_transport_attach( pjsip_endpoint *endpt,
                                                 unsigned async_cnt,
                                                 pjsip_transport **p_transport)
 {
-    return transport_attach(endpt, PJSIP_TRANSPORT_UDP, sock, a_name,
-                            async_cnt, p_transport);
+    return transport_attach(endpt, PJSIP_TRANSPORT_UDP, &sock, 1, PJ_FALSE,
+                            a_name, async_cnt, p_transport);
 }
 
 PJ_DEF(pj_status_t) pjsip_udp_transport_attach2( pjsip_endpoint *endpt,
@@ -952,8 +1108,8 @@ PJ_DEF(pj_status_t) pjsip_udp_transport_attach2( pjsip_endpoint *endpt,
                                                  unsigned async_cnt,
                                                  pjsip_transport **p_transport)
 {
-    return transport_attach(endpt, type, sock, a_name,
-                            async_cnt, p_transport);
+    return transport_attach(endpt, type, &sock, 1, PJ_FALSE,
+                            a_name, async_cnt, p_transport);
 }
 
 
@@ -967,6 +1123,7 @@ PJ_DEF(void) pjsip_udp_transport_cfg_default(pjsip_udp_transport_cfg *cfg,
     cfg->af = af;
     pj_sockaddr_init(cfg->af, &cfg->bind_addr, NULL, 0);
     cfg->async_cnt = 1;
+    cfg->sock_cnt = 1;
 }
 
 
@@ -980,15 +1137,21 @@ PJ_DEF(pj_status_t) pjsip_udp_transport_start2(
                                         const pjsip_udp_transport_cfg *cfg,
                                         pjsip_transport **p_transport)
 {
-    pj_sock_t sock;
+    enum { MAX_SOCK_CNT = 64 };
+    pj_sock_t sock[MAX_SOCK_CNT];
+    unsigned i, sock_cnt;
     pj_status_t status;
     pjsip_host_port addr_name;
     char addr_buf[PJ_INET6_ADDRSTRLEN];
     pjsip_transport_type_e transport_type;
+    pj_sockaddr bound_addr;
     pj_uint16_t af;
     int addr_len;
 
     PJ_ASSERT_RETURN(endpt && cfg && cfg->async_cnt, PJ_EINVAL);
+    PJ_ASSERT_RETURN(cfg->sock_cnt <= MAX_SOCK_CNT, PJ_ETOOMANY);
+
+    sock_cnt = cfg->sock_cnt? cfg->sock_cnt : 1;
 
     if (cfg->bind_addr.addr.sa_family == pj_AF_INET()) {
         af = pj_AF_INET();
@@ -1000,35 +1163,62 @@ PJ_DEF(pj_status_t) pjsip_udp_transport_start2(
         addr_len = sizeof(pj_sockaddr_in6);
     }
 
-    status = create_socket(af, &cfg->bind_addr, addr_len, &sock);
+    status = create_socket(af, &cfg->bind_addr, addr_len, (sock_cnt > 1),
+                           &sock[0]);
     if (status != PJ_SUCCESS)
         return status;
 
-    /* Apply QoS, if specified */
-    pj_sock_apply_qos2(sock, cfg->qos_type, &cfg->qos_params,
-                       2, THIS_FILE, "SIP UDP transport");
+    /* Bind the other sockets to the address actually bound by the first
+     * socket, in case the port was not specified.
+     */
+    if (sock_cnt > 1) {
+        int bound_len = sizeof(bound_addr);
+
+        status = pj_sock_getsockname(sock[0], &bound_addr, &bound_len);
+        if (status != PJ_SUCCESS) {
+            pj_sock_close(sock[0]);
+            return status;
+        }
+
+        for (i=1; i<sock_cnt; ++i) {
+            status = create_socket(af, &bound_addr, bound_len, PJ_TRUE,
+                                   &sock[i]);
+            if (status != PJ_SUCCESS) {
+                while (i > 0)
+                    pj_sock_close(sock[--i]);
+                return status;
+            }
+        }
+    }
 
-    /* Apply sockopt, if specified */
-    if (cfg->sockopt_params.cnt)
-        pj_sock_setsockopt_params(sock, &cfg->sockopt_params);
+    for (i=0; i<sock_cnt; ++i) {
+        /* Apply QoS, if specified */
+        pj_sock_apply_qos2(sock[i], cfg->qos_type, &cfg->qos_params,
+                           2, THIS_FILE, "SIP UDP transport");
+
+        /* Apply sockopt, if specified */
+        if (cfg->sockopt_params.cnt)
+            pj_sock_setsockopt_params(sock[i], &cfg->sockopt_params);
+    }
 
     if (cfg->addr_name.host.slen == 0) {
         /* Address name is not specified.
          * Build a name based on bound address.
          */
-        status = get_published_name(sock, addr_buf, sizeof(addr_buf),
+        status = get_published_name(sock[0], addr_buf, sizeof(addr_buf),
                                     &addr_name);
         if (status != PJ_SUCCESS) {
-            pj_sock_close(sock);
+            for (i=0; i<sock_cnt; ++i)
+                pj_sock_close(sock[i]);
             return status;
         }
     } else {
         addr_name = cfg->addr_name;
     }
 
-    return pjsip_udp_transport_attach2(endpt, transport_type, sock,
-                                       &addr_name, cfg->async_cnt,
-                                       p_transport);
+    return transport_attach(endpt, transport_type, sock, sock_cnt,
+                            cfg->sock_worker_thread, &addr_name,
+                            cfg->async_cnt, p_transport);
 }
 
 /*
@@ -1088,7 +1278,7 @@ PJ_DEF(pj_sock_t) pjsip_udp_transport_get_socket(pjsip_transport *transport)
 
     tp = (struct udp_transport*) transport;
 
-    return tp->sock;
+    return tp->shards[0].sock;
 }
 
 
@@ -1119,25 +1309,18 @@ PJ_DEF(pj_status_t) pjsip_udp_transport_pause(pjsip_transport *transport,
 
     /* Cancel the ioqueue operation. */
     for (i=0; i<(unsigned)tp->rdata_cnt; ++i) {
-        pj_ioqueue_post_completion(tp->key, 
-                                   &tp->rdata[i]->tp_info.op_key.op_key, -1);
+        pj_ioqueue_key_t *key = get_rdata_key(tp, i);
+
+        if (key) {
+            pj_ioqueue_post_completion(key,
+                                       &tp->rdata[i]->tp_info.op_key.op_key,
+                                       -1);
+        }
     }
 
     /* Destroy the socket? */
     if (option & PJSIP_UDP_TRANSPORT_DESTROY_SOCKET) {
-        if (tp->key) {
-            /* This implicitly closes the socket */
-            pj_ioqueue_unregister(tp->key);
-            tp->key = NULL;
-        } else {
-            /* Close socket. */
-            if (tp->sock != PJ_INVALID_SOCKET) {
-                pj_sock_close(tp->sock);
-                tp->sock = PJ_INVALID_SOCKET;
-            }
-        }
-        tp->sock = PJ_INVALID_SOCKET;
-        
+        close_sockets(tp);
     }
 
     PJ_LOG(4,(tp->base.obj_name, "SIP UDP transport paused"));
@@ -1195,24 +1378,13 @@ PJ_DEF(pj_status_t) pjsip_udp_transport_restart2(pjsip_transport *transport,
         /* Request to recreate transport */
 
         /* Destroy existing socket, if any. */
-        if (tp->key) {
-            /* This implicitly closes the socket */
-            pj_ioqueue_unregister(tp->key);
-            tp->key = NULL;
-        } else {
-            /* Close socket. */
-            if (tp->sock != PJ_INVALID_SOCKET) {
-                pj_sock_close(tp->sock);
-                tp->sock = PJ_INVALID_SOCKET;
-            }
-        }
-        tp->sock = PJ_INVALID_SOCKET;
+        close_sockets(tp);
 
         /* Create the socket if it's not specified */
         if (sock == PJ_INVALID_SOCKET) {
             status = create_socket(local?local->addr.sa_family:pj_AF_UNSPEC(), 
                                    local, local?pj_sockaddr_get_len(local):0, 
-                                   &sock);
+                                   (tp->shard_cnt > 1), &sock);
             if (status != PJ_SUCCESS)
                 return status;
         }
@@ -1240,7 +1412,22 @@ PJ_DEF(pj_status_t) pjsip_udp_transport_restart2(pjsip_transport *transport,
         }
 
         /* Assign the socket and published address to transport. */
-        udp_set_socket(tp, sock, a_name);
+        udp_set_socket(tp, 0, sock, a_name);
+
+        /* Recreate the other sockets bound to the same address */
+        for (i=1; i<(int)tp->shard_cnt; ++i) {
+            status = create_socket(tp->base.local_addr.addr.sa_family,
+                                   &tp->base.local_addr,
+                                   pj_sockaddr_get_len(&tp->base.local_addr),
+                                   PJ_TRUE, &sock);
+            if (status != PJ_SUCCESS) {
+                PJ_PERROR(3,(tp->base.obj_name, status,
+                             "Unable to recreate SIP UDP socket %d of %d, "
+                             "continuing without it", i+1, tp->shard_cnt));
+                continue;
+            }
+            udp_set_socket(tp, i, sock, NULL);
+        }
 
     } else {
 
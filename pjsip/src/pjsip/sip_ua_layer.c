@@ -72,6 +72,18 @@ struct dlg_set
 };
 
 
+/* Stripe of the dialog table. Dialog sets are distributed among the
+ * stripes by the hash value of the local tag, and each stripe is
+ * protected by its own mutex.
+ */
+typedef struct dlg_stripe
+{
+    pj_mutex_t          *mutex;
+    pj_pool_t           *pool;
+    pj_hash_table_t     *dlg_table;
+    struct dlg_set       free_dlgset_nodes;
+} dlg_stripe;
+
 /*
  * Module interface.
  */
@@ -80,10 +92,9 @@ static struct user_agent
     pjsip_module         mod;
     pj_pool_t           *pool;
     pjsip_endpoint      *endpt;
-    pj_mutex_t          *mutex;
-    pj_hash_table_t     *dlg_table;
     pjsip_ua_init_param  param;
-    struct dlg_set       free_dlgset_nodes;
+    unsigned             stripe_cnt;
+    dlg_stripe          *stripes;
 
 } mod_ua = 
 {
@@ -104,6 +115,25 @@ static struct user_agent
   }
 };
 
+/* Destroy the stripes' mutexes and release their pools, except the first
+ * stripe's pool which is the module pool.
+ */
+static void destroy_stripes(void)
+{
+    unsigned i;
+
+    for (i=0; i<mod_ua.stripe_cnt; ++i) {
+        dlg_stripe *stripe = &mod_ua.stripes[i];
+
+        if (stripe->mutex)
+            pj_mutex_destroy(stripe->mutex);
+        if (stripe->pool && stripe->pool != mod_ua.pool)
+            pjsip_endpt_release_pool(mod_ua.endpt, stripe->pool);
+    }
+    mod_ua.stripe_cnt = 0;
+    mod_ua.stripes = NULL;
+}
+
 /* 
  * mod_ua_load()
  *
@@ -111,6 +141,7 @@ static struct user_agent
  */
 static pj_status_t mod_ua_load(pjsip_endpoint *endpt)
 {
+    unsigned i;
     pj_status_t status;
 
     /* Initialize the user agent. */
@@ -120,25 +151,68 @@ static pj_status_t mod_ua_load(pjsip_endpoint *endpt)
     if (mod_ua.pool == NULL)
         return PJ_ENOMEM;
 
-    status = pj_mutex_create_recursive(mod_ua.pool, " ua%p", &mod_ua.mutex);
-    if (status != PJ_SUCCESS)
-        return status;
+    mod_ua.stripe_cnt = mod_ua.param.lock_stripe_cnt;
+    if (mod_ua.stripe_cnt == 0)
+        mod_ua.stripe_cnt = PJSIP_UA_LOCK_STRIPE_CNT;
+    if (mod_ua.stripe_cnt == 0)
+        mod_ua.stripe_cnt = 1;
+    mod_ua.stripes = (dlg_stripe*) pj_pool_calloc(mod_ua.pool,
+                                                  mod_ua.stripe_cnt,
+                                                  sizeof(dlg_stripe));
+
+    for (i=0; i<mod_ua.stripe_cnt; ++i) {
+        dlg_stripe *stripe = &mod_ua.stripes[i];
+
+        /* Each stripe allocates dialog set nodes and grows its dialog
+         * table from its own pool, since both happen while holding only
+         * the stripe's mutex.
+         */
+        if (i == 0) {
+            stripe->pool = mod_ua.pool;
+        } else {
+            stripe->pool = pjsip_endpt_create_pool(endpt, "ua%p",
+                                                   PJSIP_POOL_LEN_UA,
+                                                   PJSIP_POOL_INC_UA);
+            if (stripe->pool == NULL) {
+                status = PJ_ENOMEM;
+                goto on_error;
+            }
+        }
 
-    mod_ua.dlg_table = pj_hash_create(mod_ua.pool, PJSIP_MAX_DIALOG_COUNT);
-    if (mod_ua.dlg_table == NULL)
-        return PJ_ENOMEM;
+        status = pj_mutex_create_recursive(mod_ua.pool, " ua%p",
+                                           &stripe->mutex);
+        if (status != PJ_SUCCESS)
+            goto on_error;
 
-    pj_list_init(&mod_ua.free_dlgset_nodes);
+        /* The number of dialogs is not bounded, so use a table that grows
+         * rather than long chains.
+         */
+        stripe->dlg_table = pj_hash_create2(stripe->pool,
+                                            PJSIP_MAX_DIALOG_COUNT /
+                                                mod_ua.stripe_cnt,
+                                            PJ_HASH_TYPE_OPEN_ADDRESSING);
+        if (stripe->dlg_table == NULL) {
+            status = PJ_ENOMEM;
+            goto on_error;
+        }
+
+        pj_list_init(&stripe->free_dlgset_nodes);
+    }
 
     /* Initialize dialog lock. */
     status = pj_thread_local_alloc(&pjsip_dlg_lock_tls_id);
     if (status != PJ_SUCCESS)
-        return status;
+        goto on_error;
 
     pj_thread_local_set(pjsip_dlg_lock_tls_id, NULL);
 
     return PJ_SUCCESS;
 
+on_error:
+    destroy_stripes();
+    pjsip_endpt_release_pool(endpt, mod_ua.pool);
+    mod_ua.pool = NULL;
+    return status;
 }
 
 /*
@@ -149,7 +223,8 @@ static pj_status_t mod_ua_load(pjsip_endpoint *endpt)
 static pj_status_t mod_ua_unload(void)
 {
     pj_thread_local_free(pjsip_dlg_lock_tls_id);
-    pj_mutex_destroy(mod_ua.mutex);
+
+    destroy_stripes();
 
     /* Release pool */
     if (mod_ua.pool) {
@@ -264,21 +339,41 @@ PJ_DEF(void) pjsip_ua_create_dlg_set_key( pj_pool_t *pool,
 }
 */
 
+/*
+ * Get the stripe of the dialog table for the local tag hash value.
+ */
+static dlg_stripe *get_stripe(pj_uint32_t tag_hval)
+{
+    return &mod_ua.stripes[tag_hval % mod_ua.stripe_cnt];
+}
+
+/*
+ * Get the stripe of the dialog table for the local tag. If hval is zero,
+ * it will be filled with the hash value of the tag.
+ */
+static dlg_stripe *get_stripe_for_tag(const pj_str_t *tag, pj_uint32_t *hval)
+{
+    if (*hval == 0)
+        *hval = pj_hash_calc_tolower(0, NULL, tag);
+
+    return get_stripe(*hval);
+}
+
 /*
  * Acquire one dlg_set node to be put in the hash table.
  * This will first look in the free nodes list, then allocate
- * a new one from UA's pool when one is not available.
+ * a new one from stripe's pool when one is not available.
  */
-static struct dlg_set *alloc_dlgset_node(void)
+static struct dlg_set *alloc_dlgset_node(dlg_stripe *stripe)
 {
     struct dlg_set *set;
 
-    if (!pj_list_empty(&mod_ua.free_dlgset_nodes)) {
-        set = mod_ua.free_dlgset_nodes.next;
+    if (!pj_list_empty(&stripe->free_dlgset_nodes)) {
+        set = stripe->free_dlgset_nodes.next;
         pj_list_erase(set);
         return set;
     } else {
-        set = PJ_POOL_ALLOC_T(mod_ua.pool, struct dlg_set);
+        set = PJ_POOL_ALLOC_T(stripe->pool, struct dlg_set);
         return set;
     }
 }
@@ -290,6 +385,8 @@ static struct dlg_set *alloc_dlgset_node(void)
 PJ_DEF(pj_status_t) pjsip_ua_register_dlg( pjsip_user_agent *ua,
                                            pjsip_dialog *dlg )
 {
+    dlg_stripe *stripe;
+
     /* Sanity check. */
     PJ_ASSERT_RETURN(ua && dlg, PJ_EINVAL);
 
@@ -303,14 +400,15 @@ PJ_DEF(pj_status_t) pjsip_ua_register_dlg( pjsip_user_agent *ua,
     //                && dlg->remote.tag_hval != 0), PJ_EBUG);
 
     /* Lock the user agent. */
-    pj_mutex_lock(mod_ua.mutex);
+    stripe = get_stripe(dlg->local.tag_hval);
+    pj_mutex_lock(stripe->mutex);
 
     /* For UAC, check if there is existing dialog in the same set. */
     if (dlg->role == PJSIP_ROLE_UAC) {
         struct dlg_set *dlg_set;
 
         dlg_set = (struct dlg_set*)
-                  pj_hash_get_lower( mod_ua.dlg_table,
+                  pj_hash_get_lower( stripe->dlg_table,
                                      dlg->local.info->tag.ptr, 
                                      (unsigned)dlg->local.info->tag.slen,
                                      &dlg->local.tag_hval);
@@ -328,7 +426,7 @@ PJ_DEF(pj_status_t) pjsip_ua_register_dlg( pjsip_user_agent *ua,
             /* This is the first dialog in the dialog set. 
              * Create the dialog set and add this dialog to it.
              */
-            dlg_set = alloc_dlgset_node();
+            dlg_set = alloc_dlgset_node(stripe);
             dlg_set->ht_key = dlg->local.info->tag;
             pj_list_init(&dlg_set->dlg_list);
             pj_list_push_back(&dlg_set->dlg_list, dlg);
@@ -336,7 +434,7 @@ PJ_DEF(pj_status_t) pjsip_ua_register_dlg( pjsip_user_agent *ua,
             dlg->dlg_set = dlg_set;
 
             /* Register the dialog set in the hash table. */
-            pj_hash_set_np_lower(mod_ua.dlg_table, 
+            pj_hash_set_np_lower(stripe->dlg_table, 
                                  dlg_set->ht_key.ptr,
                                  (unsigned)dlg_set->ht_key.slen,
                                  dlg->local.tag_hval, dlg_set->ht_entry,
@@ -347,21 +445,21 @@ PJ_DEF(pj_status_t) pjsip_ua_register_dlg( pjsip_user_agent *ua,
         /* For UAS, create the dialog set with a single dialog as member. */
         struct dlg_set *dlg_set;
 
-        dlg_set = alloc_dlgset_node();
+        dlg_set = alloc_dlgset_node(stripe);
         dlg_set->ht_key = dlg->local.info->tag;
         pj_list_init(&dlg_set->dlg_list);
         pj_list_push_back(&dlg_set->dlg_list, dlg);
 
         dlg->dlg_set = dlg_set;
 
-        pj_hash_set_np_lower(mod_ua.dlg_table, 
+        pj_hash_set_np_lower(stripe->dlg_table, 
                              dlg_set->ht_key.ptr,
                              (unsigned)dlg_set->ht_key.slen,
                              dlg->local.tag_hval, dlg_set->ht_entry, dlg_set);
     }
 
     /* Unlock user agent. */
-    pj_mutex_unlock(mod_ua.mutex);
+    pj_mutex_unlock(stripe->mutex);
 
     /* Done. */
     return PJ_SUCCESS;
@@ -373,6 +471,7 @@ PJ_DEF(pj_status_t) pjsip_ua_unregister_dlg( pjsip_user_agent *ua,
 {
     struct dlg_set *dlg_set;
     pjsip_dialog *d;
+    dlg_stripe *stripe;
 
     /* Sanity-check arguments. */
     PJ_ASSERT_RETURN(ua && dlg, PJ_EINVAL);
@@ -381,7 +480,8 @@ PJ_DEF(pj_status_t) pjsip_ua_unregister_dlg( pjsip_user_agent *ua,
     PJ_ASSERT_RETURN(dlg->dlg_set, PJ_EINVALIDOP);
 
     /* Lock user agent. */
-    pj_mutex_lock(mod_ua.mutex);
+    stripe = get_stripe(dlg->local.tag_hval);
+    pj_mutex_lock(stripe->mutex);
 
     /* Find this dialog from the dialog set. */
     dlg_set = (struct dlg_set*) dlg->dlg_set;
@@ -392,7 +492,7 @@ PJ_DEF(pj_status_t) pjsip_ua_unregister_dlg( pjsip_user_agent *ua,
 
     if (d != dlg) {
         pj_assert(!"Dialog is not registered!");
-        pj_mutex_unlock(mod_ua.mutex);
+        pj_mutex_unlock(stripe->mutex);
         return PJ_EINVALIDOP;
     }
 
@@ -403,16 +503,16 @@ PJ_DEF(pj_status_t) pjsip_ua_unregister_dlg( pjsip_user_agent *ua,
     if (pj_list_empty(&dlg_set->dlg_list)) {
 
         /* Verify that the dialog set is valid */
-        pj_assert(pj_hash_get_lower(mod_ua.dlg_table, dlg_set->ht_key.ptr,
+        pj_assert(pj_hash_get_lower(stripe->dlg_table, dlg_set->ht_key.ptr,
                                     (unsigned)dlg_set->ht_key.slen,
                                     &dlg->local.tag_hval) == dlg_set);
 
-        pj_hash_set_lower(NULL, mod_ua.dlg_table, dlg_set->ht_key.ptr,
+        pj_hash_set_lower(NULL, stripe->dlg_table, dlg_set->ht_key.ptr,
                           (unsigned)dlg_set->ht_key.slen,
                           dlg->local.tag_hval, NULL);
 
         /* Return dlg_set to free nodes. */
-        pj_list_push_back(&mod_ua.free_dlgset_nodes, dlg_set);
+        pj_list_push_back(&stripe->free_dlgset_nodes, dlg_set);
     } else {
         /* If the just unregistered dialog is being used as hash key,
          * reset the dlg_set entry with a new key (i.e: from the first dialog
@@ -426,13 +526,13 @@ PJ_DEF(pj_status_t) pjsip_ua_unregister_dlg( pjsip_user_agent *ua,
             /* Verify that the old & new keys share the hash value */
             pj_assert(key_dlg->local.tag_hval == dlg->local.tag_hval);
 
-            pj_hash_set_lower(NULL, mod_ua.dlg_table, dlg_set->ht_key.ptr,
+            pj_hash_set_lower(NULL, stripe->dlg_table, dlg_set->ht_key.ptr,
                               (unsigned)dlg_set->ht_key.slen,
                               dlg->local.tag_hval, NULL);
 
             dlg_set->ht_key = key_dlg->local.info->tag;
 
-            pj_hash_set_np_lower(mod_ua.dlg_table,
+            pj_hash_set_np_lower(stripe->dlg_table,
                                  dlg_set->ht_key.ptr,
                                  (unsigned)dlg_set->ht_key.slen,
                                  key_dlg->local.tag_hval, dlg_set->ht_entry,
@@ -441,7 +541,7 @@ PJ_DEF(pj_status_t) pjsip_ua_unregister_dlg( pjsip_user_agent *ua,
     }
 
     /* Unlock user agent. */
-    pj_mutex_unlock(mod_ua.mutex);
+    pj_mutex_unlock(stripe->mutex);
 
     /* Done. */
     return PJ_SUCCESS;
@@ -470,13 +570,17 @@ PJ_DEF(pjsip_dialog*) pjsip_tsx_get_dlg( pjsip_transaction *tsx )
  */
 PJ_DEF(unsigned) pjsip_ua_get_dlg_set_count(void)
 {
-    unsigned count;
+    unsigned i, count = 0;
 
     PJ_ASSERT_RETURN(mod_ua.endpt, 0);
 
-    pj_mutex_lock(mod_ua.mutex);
-    count = pj_hash_count(mod_ua.dlg_table);
-    pj_mutex_unlock(mod_ua.mutex);
+    for (i=0; i<mod_ua.stripe_cnt; ++i) {
+        dlg_stripe *stripe = &mod_ua.stripes[i];
+
+        pj_mutex_lock(stripe->mutex);
+        count += pj_hash_count(stripe->dlg_table);
+        pj_mutex_unlock(stripe->mutex);
+    }
 
     return count;
 }
@@ -492,19 +596,22 @@ PJ_DEF(pjsip_dialog*) pjsip_ua_find_dialog(const pj_str_t *call_id,
 {
     struct dlg_set *dlg_set;
     pjsip_dialog *dlg;
+    dlg_stripe *stripe;
+    pj_uint32_t hval = 0;
 
     PJ_ASSERT_RETURN(call_id && local_tag && remote_tag, NULL);
 
     /* Lock user agent. */
-    pj_mutex_lock(mod_ua.mutex);
+    stripe = get_stripe_for_tag(local_tag, &hval);
+    pj_mutex_lock(stripe->mutex);
 
     /* Lookup the dialog set. */
     dlg_set = (struct dlg_set*)
-              pj_hash_get_lower(mod_ua.dlg_table, local_tag->ptr,
-                                (unsigned)local_tag->slen, NULL);
+              pj_hash_get_lower(stripe->dlg_table, local_tag->ptr,
+                                (unsigned)local_tag->slen, &hval);
     if (dlg_set == NULL) {
         /* Not found */
-        pj_mutex_unlock(mod_ua.mutex);
+        pj_mutex_unlock(stripe->mutex);
         return NULL;
     }
 
@@ -520,7 +627,7 @@ PJ_DEF(pjsip_dialog*) pjsip_ua_find_dialog(const pj_str_t *call_id,
 
     if (dlg == (pjsip_dialog*)&dlg_set->dlg_list) {
         /* Not found */
-        pj_mutex_unlock(mod_ua.mutex);
+        pj_mutex_unlock(stripe->mutex);
         return NULL;
     }
 
@@ -530,7 +637,7 @@ PJ_DEF(pjsip_dialog*) pjsip_ua_find_dialog(const pj_str_t *call_id,
         PJ_LOG(6, (THIS_FILE, "Dialog not found: local and remote tags "
                               "matched but not call id"));
 
-        pj_mutex_unlock(mod_ua.mutex);
+        pj_mutex_unlock(stripe->mutex);
         return NULL;
     }
 
@@ -546,18 +653,18 @@ PJ_DEF(pjsip_dialog*) pjsip_ua_find_dialog(const pj_str_t *call_id,
              */
 
             /* Unlock user agent. */
-            pj_mutex_unlock(mod_ua.mutex);
+            pj_mutex_unlock(stripe->mutex);
             /* Lock dialog */
             pjsip_dlg_inc_lock(dlg);
 
         } else {
             /* Unlock user agent. */
-            pj_mutex_unlock(mod_ua.mutex);
+            pj_mutex_unlock(stripe->mutex);
         }
 
     } else {
         /* Unlock user agent. */
-        pj_mutex_unlock(mod_ua.mutex);
+        pj_mutex_unlock(stripe->mutex);
     }
 
     return dlg;
@@ -566,9 +673,14 @@ PJ_DEF(pjsip_dialog*) pjsip_ua_find_dialog(const pj_str_t *call_id,
 
 /*
  * Find the first dialog in dialog set in hash table for an incoming message.
+ * On return, if p_stripe is not NULL, it is the stripe of the dialog table
+ * where the dialog set would be, and its mutex is locked.
  */
-static struct dlg_set *find_dlg_set_for_msg( pjsip_rx_data *rdata )
+static struct dlg_set *find_dlg_set_for_msg( pjsip_rx_data *rdata,
+                                             dlg_stripe **p_stripe )
 {
+    *p_stripe = NULL;
+
     /* CANCEL message doesn't have To tag, so we must lookup the dialog
      * by finding the INVITE UAS transaction being cancelled.
      */
@@ -591,18 +703,29 @@ static struct dlg_set *find_dlg_set_for_msg( pjsip_rx_data *rdata )
         pjsip_tsx_create_key(rdata->tp_info.pool, &key, role, 
                              pjsip_get_invite_method(), rdata);
 
-        /* Lookup the INVITE transaction */
-        tsx = pjsip_tsx_layer_find_tsx2(&key, PJ_TRUE);
+        /* Lookup the INVITE transaction. The transaction is locked so
+         * the dialog can't be destroyed until we have locked the dialog
+         * table stripe.
+         */
+        tsx = pjsip_tsx_layer_find_tsx(&key, PJ_TRUE);
 
         /* We should find the dialog attached to the INVITE transaction */
         if (tsx) {
+            struct dlg_set *dlg_set = NULL;
+
             dlg = (pjsip_dialog*) tsx->mod_data[mod_ua.mod.id];
-            pj_grp_lock_dec_ref(tsx->grp_lock);
 
             /* Dlg may be NULL on some extreme condition
              * (e.g. during debugging where initially there is a dialog)
              */
-            return dlg ? (struct dlg_set*) dlg->dlg_set : NULL;
+            if (dlg) {
+                *p_stripe = get_stripe(dlg->local.tag_hval);
+                pj_mutex_lock((*p_stripe)->mutex);
+                dlg_set = (struct dlg_set*) dlg->dlg_set;
+            }
+            pj_grp_lock_release(tsx->grp_lock);
+
+            return dlg_set;
 
         } else {
             return NULL;
@@ -612,6 +735,7 @@ static struct dlg_set *find_dlg_set_for_msg( pjsip_rx_data *rdata )
     } else {
         pj_str_t *tag;
         struct dlg_set *dlg_set;
+        pj_uint32_t hval = 0;
 
         if (rdata->msg_info.msg->type == PJSIP_REQUEST_MSG)
             tag = &rdata->msg_info.to->tag;
@@ -619,9 +743,12 @@ static struct dlg_set *find_dlg_set_for_msg( pjsip_rx_data *rdata )
             tag = &rdata->msg_info.from->tag;
 
         /* Lookup the dialog set. */
+        *p_stripe = get_stripe_for_tag(tag, &hval);
+        pj_mutex_lock((*p_stripe)->mutex);
+
         dlg_set = (struct dlg_set*)
-                  pj_hash_get_lower(mod_ua.dlg_table, tag->ptr, 
-                                    (unsigned)tag->slen, NULL);
+                  pj_hash_get_lower((*p_stripe)->dlg_table, tag->ptr, 
+                                    (unsigned)tag->slen, &hval);
         return dlg_set;
     }
 }
@@ -632,6 +759,7 @@ static pj_bool_t mod_ua_on_rx_request(pjsip_rx_data *rdata)
     struct dlg_set *dlg_set;
     pj_str_t *from_tag;
     pjsip_dialog *dlg;
+    dlg_stripe *stripe;
     pj_status_t status;
 
     /* Optimized path: bail out early if request is not CANCEL and it doesn't
@@ -649,18 +777,18 @@ static pj_bool_t mod_ua_on_rx_request(pjsip_rx_data *rdata)
 
 retry_on_deadlock:
 
-    /* Lock user agent before looking up the dialog hash table. */
-    pj_mutex_lock(mod_ua.mutex);
-
-    /* Lookup the dialog set, based on the To tag header. */
-    dlg_set = find_dlg_set_for_msg(rdata);
+    /* Lookup the dialog set, based on the To tag header. This locks
+     * the user agent dialog table.
+     */
+    dlg_set = find_dlg_set_for_msg(rdata, &stripe);
 
     /* If dialog is not found, respond with 481 (Call/Transaction
      * Does Not Exist).
      */
     if (dlg_set == NULL) {
         /* Unable to find dialog. */
-        pj_mutex_unlock(mod_ua.mutex);
+        if (stripe)
+            pj_mutex_unlock(stripe->mutex);
 
         if (rdata->msg_info.msg->line.req.method.id != PJSIP_ACK_METHOD) {
             PJ_LOG(5,(THIS_FILE, 
@@ -701,7 +829,7 @@ retry_on_deadlock:
 
         if (first_dlg->remote.info->tag.slen != 0) {
             /* Not found. Mulfunction UAC? */
-            pj_mutex_unlock(mod_ua.mutex);
+            pj_mutex_unlock(stripe->mutex);
 
             if (rdata->msg_info.msg->line.req.method.id != PJSIP_ACK_METHOD) {
                 PJ_LOG(5,(THIS_FILE, 
@@ -733,13 +861,13 @@ retry_on_deadlock:
          * because of deadlock. Release UA mutex, yield, and retry 
          * the whole thing once again.
          */
-        pj_mutex_unlock(mod_ua.mutex);
+        pj_mutex_unlock(stripe->mutex);
         pj_thread_sleep(0);
         goto retry_on_deadlock;
     }
 
     /* Done with processing in UA layer, release lock */
-    pj_mutex_unlock(mod_ua.mutex);
+    pj_mutex_unlock(stripe->mutex);
 
     /* Pass to dialog. */
     pjsip_dlg_on_rx_request(dlg, rdata);
@@ -759,6 +887,7 @@ static pj_bool_t mod_ua_on_rx_response(pjsip_rx_data *rdata)
     pjsip_transaction *tsx;
     struct dlg_set *dlg_set;
     pjsip_dialog *dlg;
+    dlg_stripe *stripe;
     pj_status_t status;
 
     /*
@@ -775,20 +904,21 @@ retry_on_deadlock:
 
     dlg = NULL;
 
-    /* Lock user agent dlg table before we're doing anything. */
-    pj_mutex_lock(mod_ua.mutex);
-
     /* Check if transaction is present. */
     tsx = pjsip_rdata_get_tsx(rdata);
     if (tsx) {
-        /* Check if dialog is present in the transaction. */
+        /* Check if dialog is present in the transaction. The transaction
+         * is locked by the caller, so the dialog can't go away.
+         */
         dlg = pjsip_tsx_get_dlg(tsx);
         if (!dlg) {
-            /* Unlock dialog hash table. */
-            pj_mutex_unlock(mod_ua.mutex);
             return PJ_FALSE;
         }
 
+        /* Lock user agent dlg table of the dialog. */
+        stripe = get_stripe(dlg->local.tag_hval);
+        pj_mutex_lock(stripe->mutex);
+
         /* Get the dialog set. */
         dlg_set = (struct dlg_set*) dlg->dlg_set;
 
@@ -803,6 +933,7 @@ retry_on_deadlock:
          * dialog.
          */
         pjsip_cseq_hdr *cseq_hdr = rdata->msg_info.cseq;
+        pj_uint32_t hval = 0;
 
         if (cseq_hdr->method.id != PJSIP_INVITE_METHOD ||
             rdata->msg_info.msg->line.status.code / 100 != 2)
@@ -811,22 +942,23 @@ retry_on_deadlock:
              * This must be some stateless response sent by other modules,
              * or a very late response.
              */
-            /* Unlock dialog hash table. */
-            pj_mutex_unlock(mod_ua.mutex);
             return PJ_FALSE;
         }
 
+        /* Lock user agent dlg table for the local tag. */
+        stripe = get_stripe_for_tag(&rdata->msg_info.from->tag, &hval);
+        pj_mutex_lock(stripe->mutex);
 
         /* Get the dialog set. */
         dlg_set = (struct dlg_set*)
-                  pj_hash_get_lower(mod_ua.dlg_table, 
+                  pj_hash_get_lower(stripe->dlg_table, 
                                     rdata->msg_info.from->tag.ptr,
                                     (unsigned)rdata->msg_info.from->tag.slen,
-                                    NULL);
+                                    &hval);
 
         if (!dlg_set) {
             /* Unlock dialog hash table. */
-            pj_mutex_unlock(mod_ua.mutex);
+            pj_mutex_unlock(stripe->mutex);
 
             /* Strayed 2xx response!! */
             PJ_LOG(4,(THIS_FILE, 
@@ -896,7 +1028,7 @@ retry_on_deadlock:
                 dlg = (*mod_ua.param.on_dlg_forked)(dlg_set->dlg_list.next, 
                                                     rdata);
                 if (dlg == NULL) {
-                    pj_mutex_unlock(mod_ua.mutex);
+                    pj_mutex_unlock(stripe->mutex);
                     return PJ_TRUE;
                 }
             } else {
@@ -942,13 +1074,13 @@ retry_on_deadlock:
          * situation, and for safety, try to avoid deadlock by releasing
          * UA mutex, yield, and retry the whole processing once again.
          */
-        pj_mutex_unlock(mod_ua.mutex);
+        pj_mutex_unlock(stripe->mutex);
         pj_thread_sleep(0);
         goto retry_on_deadlock;
     }
 
     /* We're done with processing in the UA layer, we can release the mutex */
-    pj_mutex_unlock(mod_ua.mutex);
+    pj_mutex_unlock(stripe->mutex);
 
     /* Pass the response to the dialog. */
     pjsip_dlg_on_rx_response(dlg, rdata);
@@ -994,21 +1126,26 @@ PJ_DEF(void) pjsip_ua_dump(pj_bool_t detail)
 #if PJ_LOG_MAX_LEVEL >= 3
     pj_hash_iterator_t itbuf, *it;
     char dlginfo[128];
+    unsigned i, count;
 
-    pj_mutex_lock(mod_ua.mutex);
+    count = pjsip_ua_get_dlg_set_count();
+    PJ_LOG(3, (THIS_FILE, "Number of dialog sets: %u", count));
 
-    PJ_LOG(3, (THIS_FILE, "Number of dialog sets: %u", 
-                          pj_hash_count(mod_ua.dlg_table)));
+    if (!detail || count == 0)
+        return;
 
-    if (detail && pj_hash_count(mod_ua.dlg_table)) {
-        PJ_LOG(3, (THIS_FILE, "Dumping dialog sets:"));
-        it = pj_hash_first(mod_ua.dlg_table, &itbuf);
-        for (; it != NULL; it = pj_hash_next(mod_ua.dlg_table, it))  {
+    PJ_LOG(3, (THIS_FILE, "Dumping dialog sets:"));
+    for (i=0; i<mod_ua.stripe_cnt; ++i) {
+        dlg_stripe *stripe = &mod_ua.stripes[i];
+
+        pj_mutex_lock(stripe->mutex);
+        it = pj_hash_first(stripe->dlg_table, &itbuf);
+        for (; it != NULL; it = pj_hash_next(stripe->dlg_table, it))  {
             struct dlg_set *dlg_set;
             pjsip_dialog *dlg;
             const char *title;
 
-            dlg_set = (struct dlg_set*) pj_hash_this(mod_ua.dlg_table, it);
+            dlg_set = (struct dlg_set*) pj_hash_this(stripe->dlg_table, it);
             if (!dlg_set || pj_list_empty(&dlg_set->dlg_list)) continue;
 
             /* First dialog in dialog set. */
@@ -1028,9 +1165,9 @@ PJ_DEF(void) pjsip_ua_dump(pj_bool_t detail)
                 dlg = dlg->next;
             }
         }
-    }
 
-    pj_mutex_unlock(mod_ua.mutex);
+        pj_mutex_unlock(stripe->mutex);
+    }
 #endif
 }
 
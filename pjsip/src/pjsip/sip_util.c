@@ -24,8 +24,13 @@
 #include <pjsip/sip_transaction.h>
 #include <pjsip/sip_module.h>
 #include <pjsip/sip_errno.h>
+#include <pjsip/sip_parser.h>
+#include <pjsip/sip_private.h>
+#include <pjsip/print_util.h>
+#include <pjlib-util/string.h>
 #include <pj/array.h>
 #include <pj/log.h>
+#include <pj/os.h>
 #include <pj/string.h>
 #include <pj/guid.h>
 #include <pj/pool.h>
@@ -106,20 +111,19 @@ PJ_DEF(pj_status_t) pjsip_target_set_add_from_msg( pjsip_target_set *tset,
     PJ_ASSERT_RETURN(tset && pool && msg, PJ_EINVAL);
 
     /* Scan for Contact headers and add the URI */
-    hdr = msg->hdr.next;
-    while (hdr != &msg->hdr) {
-        if (hdr->type == PJSIP_H_CONTACT) {
-            const pjsip_contact_hdr *cn_hdr = (const pjsip_contact_hdr*)hdr;
-
-            if (!cn_hdr->star) {
-                pj_status_t rc;
-                rc = pjsip_target_set_add_uri(tset, pool, cn_hdr->uri, 
-                                              cn_hdr->q1000);
-                if (rc == PJ_SUCCESS)
-                    ++added;
-            }
+    hdr = (const pjsip_hdr*) pjsip_msg_find_hdr(msg, PJSIP_H_CONTACT, NULL);
+    while (hdr) {
+        const pjsip_contact_hdr *cn_hdr = (const pjsip_contact_hdr*)hdr;
+
+        if (!cn_hdr->star) {
+            pj_status_t rc;
+            rc = pjsip_target_set_add_uri(tset, pool, cn_hdr->uri, 
+                                          cn_hdr->q1000);
+            if (rc == PJ_SUCCESS)
+                ++added;
         }
-        hdr = hdr->next;
+        hdr = (const pjsip_hdr*) pjsip_msg_find_hdr(msg, PJSIP_H_CONTACT,
+                                                    hdr->next);
     }
 
     return added ? PJ_SUCCESS : PJ_EEXISTS;
@@ -473,6 +477,82 @@ on_error:
     return status;
 }
 
+/*
+ * Get the pre-encoded copies of the request headers that are copied to
+ * the response (Via, Record-Route, Call-ID, From, and CSeq, in that
+ * order), creating them the first time. They are put in their own pool
+ * since the responses may outlive the rdata. Returns NULL on failure.
+ */
+static pjsip_rsp_hdr_cache* get_rsp_hdr(pjsip_endpoint *endpt,
+                                        pjsip_rx_data *rdata)
+{
+    pjsip_msg *req_msg = rdata->msg_info.msg;
+    pjsip_rsp_hdr_cache *cache;
+    const pjsip_hdr *hdr;
+    pj_pool_t *pool;
+
+    if (rdata->msg_info.rsp_hdr)
+        return rdata->msg_info.rsp_hdr;
+
+    if (!rdata->msg_info.via || !rdata->msg_info.cid ||
+        !rdata->msg_info.from || !rdata->msg_info.cseq)
+    {
+        return NULL;
+    }
+
+    pool = pjsip_endpt_create_pool(endpt, "rsphdr%p",
+                                   PJSIP_POOL_LEN_RSP_HDR,
+                                   PJSIP_POOL_INC_RSP_HDR);
+    if (!pool)
+        return NULL;
+
+    cache = PJ_POOL_ZALLOC_T(pool, pjsip_rsp_hdr_cache);
+    cache->pool = pool;
+    pj_list_init(&cache->hdr);
+
+    /* The rdata holds the first reference. */
+    if (pj_atomic_create(pool, 1, &cache->ref_cnt) != PJ_SUCCESS) {
+        pj_pool_release(pool);
+        return NULL;
+    }
+
+#define ADD_RSP_HDR(h)  do { \
+                            pjsip_hdr *e = (pjsip_hdr*) \
+                                           pjsip_hdr_encode(pool, h); \
+                            if (!e) goto on_error; \
+                            pj_list_push_back(&cache->hdr, e); \
+                        } while (0)
+
+    hdr = (const pjsip_hdr*) rdata->msg_info.via;
+    while (hdr) {
+        ADD_RSP_HDR(hdr);
+        hdr = (const pjsip_hdr*)
+              pjsip_msg_find_hdr(req_msg, PJSIP_H_VIA, hdr->next);
+    }
+
+    hdr = (const pjsip_hdr*)
+          pjsip_msg_find_hdr(req_msg, PJSIP_H_RECORD_ROUTE, NULL);
+    while (hdr) {
+        ADD_RSP_HDR(hdr);
+        hdr = (const pjsip_hdr*)
+              pjsip_msg_find_hdr(req_msg, PJSIP_H_RECORD_ROUTE, hdr->next);
+    }
+
+    ADD_RSP_HDR(rdata->msg_info.cid);
+    ADD_RSP_HDR(rdata->msg_info.from);
+    ADD_RSP_HDR(rdata->msg_info.cseq);
+
+#undef ADD_RSP_HDR
+
+    rdata->msg_info.rsp_hdr = cache;
+    return cache;
+
+on_error:
+    pj_atomic_destroy(cache->ref_cnt);
+    pj_pool_release(pool);
+    return NULL;
+}
+
 /*
  * Construct a minimal response message for the received request.
  */
@@ -488,6 +568,7 @@ PJ_DEF(pj_status_t) pjsip_endpt_create_response( pjsip_endpoint *endpt,
     pjsip_to_hdr *to_hdr;
     pjsip_via_hdr *top_via = NULL, *via;
     pjsip_rr_hdr *rr;
+    pjsip_rsp_hdr_cache *rsp_hdr;
     pj_status_t status;
 
     /* Check arguments. */
@@ -525,6 +606,36 @@ PJ_DEF(pj_status_t) pjsip_endpt_create_response( pjsip_endpoint *endpt,
     /* Set TX data attributes. */
     tdata->rx_timestamp = rdata->pkt_info.timestamp;
 
+    /* Share the pre-encoded headers, if enabled. */
+    if (pjsip_cfg()->endpt.encode_rsp_hdr &&
+        (rsp_hdr = get_rsp_hdr(endpt, (pjsip_rx_data*)rdata)) != NULL)
+    {
+        const pjsip_hdr *h;
+
+        pj_atomic_inc(rsp_hdr->ref_cnt);
+        tdata->rsp_hdr = rsp_hdr;
+
+        for (h=rsp_hdr->hdr.next; h!=&rsp_hdr->hdr; h=h->next) {
+            hdr = (pjsip_hdr*) pjsip_hdr_shallow_clone(tdata->pool, h);
+            if (top_via == NULL && hdr->type == PJSIP_H_VIA)
+                top_via = (pjsip_via_hdr*) hdr;
+            pjsip_msg_add_hdr(msg, hdr);
+        }
+
+        /* The last one is CSeq, put To header before it. To header is
+         * not pre-encoded since the tag may be modified.
+         */
+        to_hdr = (pjsip_to_hdr*) pjsip_hdr_clone(tdata->pool, 
+                                                 rdata->msg_info.to);
+        pj_list_insert_before(msg->hdr.prev, to_hdr);
+
+        if (to_hdr->tag.slen==0 && st_code > 100 && top_via) {
+            to_hdr->tag = top_via->branch_param;
+        }
+
+        goto on_return;
+    }
+
     /* Copy all the via headers, in order. */
     via = rdata->msg_info.via;
     while (via) {
@@ -582,6 +693,7 @@ PJ_DEF(pj_status_t) pjsip_endpt_create_response( pjsip_endpoint *endpt,
     hdr = (pjsip_hdr*) pjsip_hdr_clone(tdata->pool, rdata->msg_info.cseq);
     pjsip_msg_add_hdr( msg, hdr);
 
+on_return:
     /* All done. */
     *p_tdata = tdata;
 
@@ -590,6 +702,194 @@ PJ_DEF(pj_status_t) pjsip_endpt_create_response( pjsip_endpoint *endpt,
 }
 
 
+/*
+ * Print header and the trailing CRLF, as pjsip_msg_print() does.
+ */
+static int print_rsp_hdr(const void *hdr, char *buf, const char *endbuf)
+{
+    int len;
+
+    len = pjsip_hdr_print_on((void*)hdr, buf, endbuf-buf);
+    if (len <= 0)
+        return len;
+    if (len + 3 >= endbuf-buf)
+        return -1;
+
+    buf[len++] = '\r';
+    buf[len++] = '\n';
+    return len;
+}
+
+/*
+ * Print the To header of the request with the To tag of the response.
+ * This is what pjsip_fromto_hdr_print() prints for the To header of
+ * pjsip_endpt_create_response(), without cloning the header.
+ */
+static int print_rsp_to_hdr(const pjsip_to_hdr *hdr, const pj_str_t *tag,
+                            char *buf, const char *endbuf)
+{
+    pj_ssize_t printed;
+    char *startbuf = buf;
+    const pj_str_t *hname = pjsip_cfg()->endpt.use_compact_form? 
+                            &hdr->sname : &hdr->name;
+    const pjsip_parser_const_t *pc = pjsip_parser_const();
+
+    copy_advance(buf, (*hname));
+    copy_advance_char_check(buf, ':');
+    copy_advance_char_check(buf, ' ');
+
+    printed = pjsip_uri_print(PJSIP_URI_IN_FROMTO_HDR, hdr->uri, 
+                              buf, endbuf-buf);
+    if (printed < 1)
+        return -1;
+    buf += printed;
+
+    copy_advance_pair_escape(buf, ";tag=", 5, (*tag),
+                             pc->pjsip_TOKEN_SPEC);
+
+    printed = pjsip_param_print_on(&hdr->other_param, buf, endbuf-buf, 
+                                   &pc->pjsip_TOKEN_SPEC,
+                                   &pc->pjsip_TOKEN_SPEC, ';');
+    if (printed < 0)
+        return -1;
+    buf += printed;
+
+    if (3 >= endbuf-buf)
+        return -1;
+    *buf++ = '\r';
+    *buf++ = '\n';
+
+    return (int)(buf-startbuf);
+}
+
+/*
+ * Print stateless response directly from the request.
+ */
+PJ_DEF(pj_ssize_t) pjsip_print_stateless_response(const pjsip_rx_data *rdata,
+                                                  int st_code,
+                                                  const pj_str_t *st_text,
+                                                  const pjsip_hdr *hdr_list,
+                                                  char *buf, pj_size_t size)
+{
+    const pjsip_msg *req_msg;
+    const pjsip_via_hdr *via;
+    const pjsip_hdr *hdr;
+    char *startbuf = buf, *endbuf = buf + size;
+    pj_str_t clen_hdr = { "Content-Length:  0\r\n\r\n", 22 };
+    int len;
+
+    PJ_ASSERT_RETURN(rdata && buf, -1);
+    PJ_ASSERT_RETURN(st_code >= 100 && st_code <= 699, -1);
+
+    req_msg = rdata->msg_info.msg;
+    PJ_ASSERT_RETURN(req_msg->type == PJSIP_REQUEST_MSG, -1);
+    PJ_ASSERT_RETURN(req_msg->line.req.method.id != PJSIP_ACK_METHOD, -1);
+
+    if (st_text == NULL)
+        st_text = pjsip_get_status_text(st_code);
+
+    /* Status line. */
+    if (8 + 4 + st_text->slen + 2 >= endbuf-buf)
+        return -1;
+
+    pj_memcpy(buf, "SIP/2.0 ", 8);
+    buf += 8;
+    buf += pj_utoa(st_code, buf);
+    *buf++ = ' ';
+    pj_memcpy(buf, st_text->ptr, st_text->slen);
+    buf += st_text->slen;
+    *buf++ = '\r';
+    *buf++ = '\n';
+
+    /* All the Via headers, in order. */
+    via = rdata->msg_info.via;
+    while (via) {
+        len = print_rsp_hdr(via, buf, endbuf);
+        if (len < 0)
+            return -1;
+        buf += len;
+
+        if (via->next == (void*)&req_msg->hdr)
+            break;
+        via = (const pjsip_via_hdr*) 
+              pjsip_msg_find_hdr(req_msg, PJSIP_H_VIA, via->next);
+    }
+
+    /* All the Record-Route headers, in order. */
+    hdr = (const pjsip_hdr*)
+          pjsip_msg_find_hdr(req_msg, PJSIP_H_RECORD_ROUTE, NULL);
+    while (hdr) {
+        len = print_rsp_hdr(hdr, buf, endbuf);
+        if (len < 0)
+            return -1;
+        buf += len;
+
+        if (hdr->next == &req_msg->hdr)
+            break;
+        hdr = (const pjsip_hdr*)
+              pjsip_msg_find_hdr(req_msg, PJSIP_H_RECORD_ROUTE, hdr->next);
+    }
+
+    /* Call-ID and From. */
+    len = print_rsp_hdr(rdata->msg_info.cid, buf, endbuf);
+    if (len < 0)
+        return -1;
+    buf += len;
+
+    len = print_rsp_hdr(rdata->msg_info.from, buf, endbuf);
+    if (len < 0)
+        return -1;
+    buf += len;
+
+    /* To, with the tag derived from the Via branch as in
+     * pjsip_endpt_create_response().
+     */
+    if (rdata->msg_info.to->tag.slen == 0 && st_code > 100 &&
+        rdata->msg_info.via)
+    {
+        len = print_rsp_to_hdr(rdata->msg_info.to,
+                               &rdata->msg_info.via->branch_param,
+                               buf, endbuf);
+    } else {
+        len = print_rsp_hdr(rdata->msg_info.to, buf, endbuf);
+    }
+    if (len < 0)
+        return -1;
+    buf += len;
+
+    /* CSeq. */
+    len = print_rsp_hdr(rdata->msg_info.cseq, buf, endbuf);
+    if (len < 0)
+        return -1;
+    buf += len;
+
+    /* Additional headers. */
+    if (hdr_list) {
+        for (hdr=hdr_list->next; hdr!=hdr_list; hdr=hdr->next) {
+            len = print_rsp_hdr(hdr, buf, endbuf);
+            if (len < 0)
+                return -1;
+            buf += len;
+        }
+    }
+
+    /* Content-Length and the end of the headers, as printed by
+     * pjsip_msg_print().
+     */
+    if (pjsip_cfg()->endpt.use_compact_form) {
+        clen_hdr.ptr = "l:  0\r\n\r\n";
+        clen_hdr.slen = 9;
+    }
+    if (clen_hdr.slen >= endbuf-buf)
+        return -1;
+    pj_memcpy(buf, clen_hdr.ptr, clen_hdr.slen);
+    buf += clen_hdr.slen;
+
+    *buf = '\0';
+    return buf-startbuf;
+}
+
+
 /*
  * Construct ACK for 3xx-6xx final response (according to chapter 17.1.1 of
  * RFC3261). Note that the generation of ACK for 2xx response is different,
@@ -2012,6 +2312,114 @@ PJ_DEF(pj_status_t) pjsip_endpt_respond_stateless( pjsip_endpoint *endpt,
 }
 
 
+/*
+ * Callback when stateless raw response has been sent.
+ */
+static void raw_rsp_sent_cb(pjsip_transport *transport, void *token,
+                            pj_ssize_t sent)
+{
+    pjsip_tx_data *tdata = (pjsip_tx_data*) token;
+
+    if (sent < 0) {
+        PJ_PERROR(3,(transport->obj_name, (pj_status_t)-sent,
+                     "Error sending stateless raw response"));
+    }
+
+    tdata->is_pending = 0;
+    pjsip_endpt_release_raw_tdata(transport->endpt, tdata);
+}
+
+/*
+ * Send stateless response printed directly into transport buffer.
+ */
+PJ_DEF(pj_status_t) pjsip_endpt_respond_stateless_raw(pjsip_endpoint *endpt,
+                                                      pjsip_rx_data *rdata,
+                                                      int st_code,
+                                                      const pj_str_t *st_text,
+                                                      const pjsip_hdr *hdr_list)
+{
+    pjsip_transport *tp;
+    const pjsip_via_hdr *via;
+    pjsip_transaction *tsx;
+    pjsip_tx_data *tdata;
+    pj_sockaddr dst_addr;
+    pj_ssize_t len;
+    pj_status_t status;
+
+    /* Verify arguments. */
+    PJ_ASSERT_RETURN(endpt && rdata, PJ_EINVAL);
+    PJ_ASSERT_RETURN(rdata->msg_info.msg->type == PJSIP_REQUEST_MSG,
+                     PJSIP_ENOTREQUESTMSG);
+    PJ_ASSERT_RETURN(st_code >= 100 && st_code <= 699, PJ_EINVAL);
+    PJ_ASSERT_RETURN(rdata->msg_info.msg->line.req.method.id != 
+                     PJSIP_ACK_METHOD, PJ_EINVALIDOP);
+
+    /* Same as pjsip_endpt_respond_stateless(), the response must not
+     * be sent statelessly if UAS transaction is still running.
+     */
+    tsx = pjsip_rdata_get_tsx(rdata);
+    if (tsx && tsx->state < PJSIP_TSX_STATE_TERMINATED)
+        return PJ_EINVALIDOP;
+
+    tp = rdata->tp_info.transport;
+    via = rdata->msg_info.via;
+
+    /* Responses to be sent to maddr need server resolution, let the
+     * normal path handle them.
+     */
+    if (!PJSIP_TRANSPORT_IS_RELIABLE(tp) && via->maddr_param.slen) {
+        return pjsip_endpt_respond_stateless(endpt, rdata, st_code, st_text,
+                                             hdr_list, NULL);
+    }
+
+    /* Get the destination address, following pjsip_get_response_addr().
+     * The "received" parameter is always the source address of the
+     * request, so only the port may be different.
+     */
+    pj_memcpy(&dst_addr, &rdata->pkt_info.src_addr,
+              rdata->pkt_info.src_addr_len);
+    if (!PJSIP_TRANSPORT_IS_RELIABLE(tp) && via->rport_param < 0) {
+        int port = via->sent_by.port;
+        if (port == 0) {
+            port = pjsip_transport_get_default_port_for_type(
+                        (pjsip_transport_type_e)tp->key.type);
+        }
+        pj_sockaddr_set_port(&dst_addr, (pj_uint16_t)port);
+    }
+
+    /* Print the response to the transmit buffer. */
+    status = pjsip_endpt_acquire_raw_tdata(endpt, &tdata);
+    if (status != PJ_SUCCESS)
+        return status;
+
+    len = pjsip_print_stateless_response(rdata, st_code, st_text, hdr_list,
+                                         tdata->buf.start,
+                                         tdata->buf.end - tdata->buf.start);
+    if (len < 0) {
+        pjsip_endpt_release_raw_tdata(endpt, tdata);
+        return PJSIP_EMSGTOOLONG;
+    }
+    tdata->buf.cur = tdata->buf.start + len;
+
+    /* Send to the transport where the request was received. */
+    pjsip_transport_add_ref(tp);
+    tdata->is_pending = 1;
+
+    status = (*tp->send_msg)(tp, tdata, &dst_addr,
+                             rdata->pkt_info.src_addr_len, tdata,
+                             &raw_rsp_sent_cb);
+    if (status != PJ_EPENDING) {
+        tdata->is_pending = 0;
+        pjsip_endpt_release_raw_tdata(endpt, tdata);
+    } else {
+        status = PJ_SUCCESS;
+    }
+
+    pjsip_transport_dec_ref(tp);
+    return status;
+}
+
+
 /*
  * Get the event string from the event ID.
  */
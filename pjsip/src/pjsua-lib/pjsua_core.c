@@ -831,8 +831,19 @@ PJ_DEF(pj_status_t) pjsua_reconfigure_logging(const pjsua_logging_config *cfg)
 static int worker_thread(void *arg)
 {
     enum { TIMEOUT = 10 };
+    pj_timer_heap_t *th;
+    unsigned shard_cnt;
 
-    PJ_UNUSED_ARG(arg);
+    /* With sharded timer heap, bind each worker to a shard so workers
+     * don't contend on the same timer lock. Only do this when there are
+     * enough workers to poll every shard, otherwise poll all shards.
+     */
+    th = pjsip_endpt_get_timer_heap(pjsua_var.endpt);
+    shard_cnt = pj_timer_heap_get_shard_cnt(th);
+    if (shard_cnt > 1 && pjsua_var.ua_cfg.thread_cnt >= shard_cnt) {
+        int idx = (int)(pj_ssize_t)arg;
+        pj_timer_heap_set_thread_shard(th, idx % shard_cnt);
+    }
 
     while (!pjsua_var.thread_quit_flag) {
         int count;
@@ -1356,7 +1367,8 @@ PJ_DEF(pj_status_t) pjsua_init( const pjsua_config *ua_cfg,
             }
 #else
             status = pj_thread_create(pjsua_var.pool, tname, &worker_thread,
-                                      NULL, 0, 0, &pjsua_var.thread[ii]);
+                                      (void*)(pj_ssize_t)ii, 0, 0,
+                                      &pjsua_var.thread[ii]);
 #endif
             if (status != PJ_SUCCESS)
                 goto on_error;
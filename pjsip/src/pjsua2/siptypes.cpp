@@ -216,6 +216,9 @@ pjsip_tls_setting TlsConfig::toPj() const
     ts.sockopt_params   = this->sockOptParams.toPj();
     ts.sockopt_ignore_error = this->sockOptIgnoreError;
     ts.enable_renegotiation = this->enableRenegotiation;
+    ts.session_resumption = this->sessionResumption;
+    ts.session_timeout  = this->sessionTimeout;
+    ts.async_handshake  = this->asyncHandshake;
 
     return ts;
 }
@@ -246,6 +249,9 @@ void TlsConfig::fromPj(const pjsip_tls_setting &prm)
     this->sockOptParams.fromPj(prm.sockopt_params);
     this->sockOptIgnoreError = PJ2BOOL(prm.sockopt_ignore_error);
     this->enableRenegotiation = PJ2BOOL(prm.enable_renegotiation);
+    this->sessionResumption = PJ2BOOL(prm.session_resumption);
+    this->sessionTimeout = prm.session_timeout;
+    this->asyncHandshake = PJ2BOOL(prm.async_handshake);
 }
 
 void TlsConfig::readObject(const ContainerNode &node) PJSUA2_THROW(Error)
@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2008-2011 Teluu Inc. (http://www.teluu.com)
+ * Copyright (C) 2003-2008 Benny Prijono <benny@prijono.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "test.h"
+#include <pjsip.h>
+#include <pjlib.h>
+
+
+#define THIS_FILE   "auth_test.c"
+
+#define HFIND(msg,h,H) ((pjsip_##h##_hdr*) pjsip_msg_find_hdr(msg, PJSIP_H_##H, NULL))
+
+#define REALM       "pjsip.org"
+#define USER        "alice"
+#define SECRET      "auth-test-secret"
+
+static char passwd[32] = "secret";
+static unsigned lookup_cnt;
+
+/* Server credential lookup */
+static pj_status_t lookup_cred(pj_pool_t *pool,
+                               const pj_str_t *realm,
+                               const pj_str_t *acc_name,
+                               pjsip_cred_info *cred_info)
+{
+    PJ_UNUSED_ARG(pool);
+
+    ++lookup_cnt;
+    if (pj_strcmp2(acc_name, USER) != 0)
+        return PJSIP_EAUTHACCNOTFOUND;
+
+    cred_info->realm = *realm;
+    cred_info->scheme = pj_str("digest");
+    cred_info->username = pj_str(USER);
+    cred_info->data_type = PJSIP_CRED_DATA_PLAIN_PASSWD;
+    cred_info->data = pj_str(passwd);
+    return PJ_SUCCESS;
+}
+
+/* Create dummy rdata of the message */
+static void init_rdata(pjsip_rx_data *rdata, pj_pool_t *pool, pjsip_msg *msg)
+{
+    pj_bzero(rdata, sizeof(*rdata));
+    rdata->tp_info.pool = pool;
+    rdata->msg_info.msg = msg;
+    rdata->msg_info.from = HFIND(msg, from, FROM);
+    rdata->msg_info.to = HFIND(msg, to, TO);
+    rdata->msg_info.cseq = HFIND(msg, cseq, CSEQ);
+    rdata->msg_info.cid = HFIND(msg, cid, CALL_ID);
+    rdata->msg_info.via = HFIND(msg, via, VIA);
+}
+
+/* Challenge the request and let the client respond to the challenge */
+static pj_status_t challenge(pjsip_auth_srv *srv,
+                             pjsip_auth_clt_sess *clt,
+                             pjsip_tx_data *request,
+                             pj_str_t *nonce)
+{
+    pj_str_t qop = pj_str("auth");
+    pjsip_rx_data rdata;
+    pjsip_tx_data *response, *new_request;
+    pj_status_t status;
+
+    /* Start a new authorization round, so the client does not take the
+     * challenge as rejection of the previous authorization.
+     */
+    while (pjsip_msg_find_remove_hdr(request->msg, PJSIP_H_AUTHORIZATION,
+                                     NULL))
+        ;
+
+    init_rdata(&rdata, request->pool, request->msg);
+    status = pjsip_endpt_create_response(endpt, &rdata, 401, NULL, &response);
+    if (status != PJ_SUCCESS)
+        return status;
+
+    status = pjsip_auth_srv_challenge(srv, &qop, nonce, NULL, PJ_FALSE,
+                                      response);
+    if (status == PJ_SUCCESS) {
+        init_rdata(&rdata, response->pool, response->msg);
+        status = pjsip_auth_clt_reinit_req(clt, &rdata, request, &new_request);
+    }
+    if (status == PJ_SUCCESS)
+        pjsip_tx_data_dec_ref(new_request);
+
+    pjsip_tx_data_dec_ref(response);
+    return status;
+}
+
+static int verify(pjsip_auth_srv *srv, pjsip_tx_data *request,
+                  pj_status_t expected_status, int expected_code)
+{
+    pjsip_rx_data rdata;
+    pj_status_t status;
+    int code;
+
+    init_rdata(&rdata, request->pool, request->msg);
+    status = pjsip_auth_srv_verify(srv, &rdata, &code);
+    PJ_TEST_EQ(status, expected_status, NULL, return -10);
+    PJ_TEST_EQ(code, expected_code, NULL, return -20);
+    return 0;
+}
+
+int auth_test(void)
+{
+    pj_str_t str_target = pj_str("sip:" REALM);
+    pj_str_t str_from = pj_str("<sip:" USER "@" REALM ">");
+    pj_str_t realm = pj_str(REALM);
+    pj_str_t bad_nonce = pj_str("0123456789abcdef");
+    pjsip_auth_srv_cache_param param;
+    pjsip_auth_srv srv, srv2, srv3;
+    pjsip_auth_clt_sess clt;
+    pjsip_cred_info cred;
+    pjsip_tx_data *request = NULL;
+    pjsip_www_authenticate_hdr *chal;
+    pj_pool_t *pool;
+    int rc = 0;
+
+    pool = pjsip_endpt_create_pool(endpt, "authtest", 4000, 4000);
+    PJ_TEST_NOT_NULL(pool, NULL, return -100);
+
+    pj_bzero(&srv, sizeof(srv));
+    pj_bzero(&srv2, sizeof(srv2));
+    pj_bzero(&srv3, sizeof(srv3));
+    pj_bzero(&clt, sizeof(clt));
+
+    pjsip_auth_srv_cache_param_default(&param);
+    param.secret = pj_str(SECRET);
+    PJ_TEST_SUCCESS(pjsip_auth_srv_init(pool, &srv, &realm, &lookup_cred, 0),
+                    NULL, { rc = -110; goto on_return; });
+    PJ_TEST_SUCCESS(pjsip_auth_srv_enable_cache(pool, &srv, &param),
+                    NULL, { rc = -120; goto on_return; });
+
+    /* Other servers sharing the secret, the last with short nonce
+     * lifetime.
+     */
+    PJ_TEST_SUCCESS(pjsip_auth_srv_init(pool, &srv2, &realm, &lookup_cred, 0),
+                    NULL, { rc = -130; goto on_return; });
+    PJ_TEST_SUCCESS(pjsip_auth_srv_enable_cache(pool, &srv2, &param),
+                    NULL, { rc = -132; goto on_return; });
+    param.nonce_ttl = 1;
+    PJ_TEST_SUCCESS(pjsip_auth_srv_init(pool, &srv3, &realm, &lookup_cred, 0),
+                    NULL, { rc = -134; goto on_return; });
+    PJ_TEST_SUCCESS(pjsip_auth_srv_enable_cache(pool, &srv3, &param),
+                    NULL, { rc = -136; goto on_return; });
+
+    pj_bzero(&cred, sizeof(cred));
+    cred.realm = realm;
+    cred.scheme = pj_str("digest");
+    cred.username = pj_str(USER);
+    cred.data_type = PJSIP_CRED_DATA_PLAIN_PASSWD;
+    cred.data = pj_str(passwd);
+    PJ_TEST_SUCCESS(pjsip_auth_clt_init(&clt, endpt, pool, 0),
+                    NULL, { rc = -150; goto on_return; });
+    PJ_TEST_SUCCESS(pjsip_auth_clt_set_credentials(&clt, 1, &cred),
+                    NULL, { rc = -160; goto on_return; });
+
+    PJ_TEST_SUCCESS(pjsip_endpt_create_request(endpt, &pjsip_register_method,
+                                               &str_target, &str_from,
+                                               &str_from, &str_from, NULL, -1,
+                                               NULL, &request),
+                    NULL, { rc = -170; goto on_return; });
+
+    /* No authorization */
+    rc = verify(&srv, request, PJSIP_EAUTHNOAUTH, 401);
+    if (rc) { rc -= 200; goto on_return; }
+
+    /* Signed nonce, HA1 is cached after the first lookup */
+    lookup_cnt = 0;
+    PJ_TEST_SUCCESS(challenge(&srv, &clt, request, NULL),
+                    NULL, { rc = -300; goto on_return; });
+    chal = clt.cached_auth.next->last_chal;
+    PJ_TEST_EQ(chal->challenge.digest.nonce.slen, 40, NULL,
+               { rc = -310; goto on_return; });
+    PJ_TEST_TRUE(clt.cached_auth.next->ha1_cred != NULL, NULL,
+                 { rc = -320; goto on_return; });
+    rc = verify(&srv, request, PJ_SUCCESS, 200);
+    if (rc) { rc -= 330; goto on_return; }
+    PJ_TEST_EQ(lookup_cnt, 1, NULL, { rc = -340; goto on_return; });
+
+    /* Replayed nonce count */
+    rc = verify(&srv, request, PJSIP_EAUTHNCREPLAY, 401);
+    if (rc) { rc -= 400; goto on_return; }
+
+    /* Next nonce count is verified with the cached HA1 */
+    PJ_TEST_SUCCESS(challenge(&srv, &clt, request,
+                              &chal->challenge.digest.nonce),
+                    NULL, { rc = -500; goto on_return; });
+    rc = verify(&srv, request, PJ_SUCCESS, 200);
+    if (rc) { rc -= 510; goto on_return; }
+    PJ_TEST_EQ(lookup_cnt, 1, NULL, { rc = -520; goto on_return; });
+
+    /* Nonce not issued by the server */
+    PJ_TEST_SUCCESS(challenge(&srv, &clt, request, &bad_nonce),
+                    NULL, { rc = -600; goto on_return; });
+    rc = verify(&srv, request, PJSIP_EAUTHINNONCE, 401);
+    if (rc) { rc -= 610; goto on_return; }
+
+    /* Wrong password */
+    cred.data = pj_str("wrong");
+    PJ_TEST_SUCCESS(pjsip_auth_clt_set_credentials(&clt, 1, &cred),
+                    NULL, { rc = -700; goto on_return; });
+    PJ_TEST_SUCCESS(challenge(&srv, &clt, request, NULL),
+                    NULL, { rc = -710; goto on_return; });
+    rc = verify(&srv, request, PJSIP_EAUTHINVALIDDIGEST, 403);
+    if (rc) { rc -= 720; goto on_return; }
+
+    /* Password changed, the stale cached HA1 is replaced */
+    pj_ansi_strxcpy(passwd, "newsecret", sizeof(passwd));
+    cred.data = pj_str(passwd);
+    PJ_TEST_SUCCESS(pjsip_auth_clt_set_credentials(&clt, 1, &cred),
+                    NULL, { rc = -800; goto on_return; });
+    PJ_TEST_SUCCESS(challenge(&srv, &clt, request, NULL),
+                    NULL, { rc = -810; goto on_return; });
+    lookup_cnt = 0;
+    rc = verify(&srv, request, PJ_SUCCESS, 200);
+    if (rc) { rc -= 820; goto on_return; }
+    PJ_TEST_EQ(lookup_cnt, 1, NULL, { rc = -830; goto on_return; });
+
+    /* Verification on another server sharing the secret */
+    PJ_TEST_SUCCESS(challenge(&srv, &clt, request, NULL),
+                    NULL, { rc = -900; goto on_return; });
+    rc = verify(&srv2, request, PJ_SUCCESS, 200);
+    if (rc) { rc -= 910; goto on_return; }
+
+    /* Expired nonce */
+    PJ_TEST_SUCCESS(challenge(&srv3, &clt, request, NULL),
+                    NULL, { rc = -1000; goto on_return; });
+    pj_thread_sleep(2100);
+    rc = verify(&srv3, request, PJSIP_EAUTHSTALENONCE, 401);
+    if (rc) { rc -= 1010; goto on_return; }
+
+on_return:
+    if (request)
+        pjsip_tx_data_dec_ref(request);
+    if (clt.pool)
+        pjsip_auth_clt_deinit(&clt);
+    pjsip_auth_srv_deinit(&srv3);
+    pjsip_auth_srv_deinit(&srv2);
+    pjsip_auth_srv_deinit(&srv);
+    pjsip_endpt_release_pool(endpt, pool);
+    return rc;
+}
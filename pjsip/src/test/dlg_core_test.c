@@ -20,3 +20,169 @@
 #include "test.h"
 #include <pjsip.h>
 
+#include <pjlib.h>
+
+#define THIS_FILE   "dlg_core_test.c"
+
+
+/*
+ * Multithreaded dialog lookup benchmark. Several threads look up dialogs
+ * in the user agent dialog table concurrently, as worker threads do for
+ * incoming in-dialog requests, to measure the contention on the dialog
+ * table locks (see PJSIP_UA_LOCK_STRIPE_CNT).
+ */
+static struct dlg_bench_t
+{
+    pjsip_dialog      **dlg;
+    unsigned            dlg_cnt;
+    unsigned            lookup_cnt;
+    pj_bool_t           failed;
+} dlg_bench_data;
+
+static int dlg_lookup_thread(void *arg)
+{
+    unsigned i, idx = (unsigned)(pj_ssize_t)arg * 7919;
+
+    for (i=0; i<dlg_bench_data.lookup_cnt; ++i) {
+        pjsip_dialog *dlg;
+
+        idx = (idx + 1) % dlg_bench_data.dlg_cnt;
+        dlg = dlg_bench_data.dlg[idx];
+        if (pjsip_ua_find_dialog(&dlg->call_id->id, &dlg->local.info->tag,
+                                 &dlg->remote.info->tag, PJ_FALSE) != dlg)
+        {
+            dlg_bench_data.failed = PJ_TRUE;
+        }
+    }
+    return 0;
+}
+
+static int dlg_lookup_bench(pj_pool_t *pool, unsigned dlg_cnt,
+                            unsigned lookup_cnt,
+                            const unsigned thread_cnts[], unsigned cnt,
+                            unsigned speeds[])
+{
+    enum { MAX_THREADS = 16 };
+    pj_str_t local_uri = pj_str("<sip:dlg_bench@127.0.0.1>");
+    pj_str_t remote_uri = pj_str("<sip:remote@127.0.0.1>");
+    pj_thread_t *threads[MAX_THREADS];
+    unsigned i, t;
+    int rc = 0;
+
+    pj_bzero(&dlg_bench_data, sizeof(dlg_bench_data));
+    dlg_bench_data.dlg = (pjsip_dialog**)
+                         pj_pool_calloc(pool, dlg_cnt, sizeof(pjsip_dialog*));
+    dlg_bench_data.dlg_cnt = dlg_cnt;
+    dlg_bench_data.lookup_cnt = lookup_cnt;
+
+    /* Create the dialogs to be looked up */
+    for (i=0; i<dlg_cnt; ++i) {
+        PJ_TEST_SUCCESS(pjsip_dlg_create_uac(pjsip_ua_instance(), &local_uri,
+                                             &local_uri, &remote_uri,
+                                             &remote_uri,
+                                             &dlg_bench_data.dlg[i]),
+                        NULL, { rc=-110; goto on_return; });
+    }
+
+    PJ_TEST_EQ(pjsip_ua_get_dlg_set_count(), dlg_cnt, NULL,
+               { rc=-120; goto on_return; });
+
+    for (t=0; t<cnt; ++t) {
+        pj_timestamp t1, t2;
+        pj_uint32_t msec;
+
+        pj_assert(thread_cnts[t] <= MAX_THREADS);
+
+        pj_get_timestamp(&t1);
+        for (i=0; i<thread_cnts[t]; ++i) {
+            PJ_TEST_SUCCESS(pj_thread_create(pool, "dlgbench",
+                                             &dlg_lookup_thread,
+                                             (void*)(pj_ssize_t)i, 0, 0,
+                                             &threads[i]),
+                            NULL, { rc=-130; goto on_return; });
+        }
+        for (i=0; i<thread_cnts[t]; ++i) {
+            pj_thread_join(threads[i]);
+            pj_thread_destroy(threads[i]);
+        }
+        pj_get_timestamp(&t2);
+
+        PJ_TEST_EQ(dlg_bench_data.failed, PJ_FALSE, "dialog not found",
+                   { rc=-140; goto on_return; });
+
+        msec = pj_elapsed_msec(&t1, &t2);
+        speeds[t] = (unsigned)((pj_uint64_t)lookup_cnt * thread_cnts[t] *
+                               1000 / (msec ? msec : 1));
+    }
+
+on_return:
+    for (i=0; i<dlg_cnt; ++i) {
+        if (dlg_bench_data.dlg[i]) {
+            pjsip_dlg_terminate(dlg_bench_data.dlg[i]);
+            dlg_bench_data.dlg[i] = NULL;
+        }
+    }
+    PJ_TEST_EQ(pjsip_ua_get_dlg_set_count(), 0, NULL,
+               { if (rc==0) rc=-150; });
+
+    return rc;
+}
+
+
+int dlg_bench(void)
+{
+    const unsigned thread_cnts[] = { 1, 2, 4, 8 };
+    unsigned speeds[PJ_ARRAY_SIZE(thread_cnts)];
+    pj_bool_t ua_initialized = PJ_FALSE;
+    pj_pool_t *pool;
+    char desc[250];
+    unsigned i;
+    int rc;
+
+    /* Init UA layer */
+    if (pjsip_ua_instance()->id == -1) {
+        pjsip_ua_init_param ua_param;
+        pj_bzero(&ua_param, sizeof(ua_param));
+        PJ_TEST_SUCCESS(pjsip_ua_init_module(endpt, &ua_param), NULL,
+                        return -10);
+        ua_initialized = PJ_TRUE;
+    }
+
+    pool = pjsip_endpt_create_pool(endpt, "dlgbench", 4000, 4000);
+    PJ_TEST_NOT_NULL(pool, NULL, { rc=-20; goto on_return; });
+
+    PJ_LOG(3,(THIS_FILE, "   benchmarking multithreaded dialog lookup:"));
+    rc = dlg_lookup_bench(pool, 1000, 200000, thread_cnts,
+                          PJ_ARRAY_SIZE(thread_cnts), speeds);
+    if (rc != 0)
+        goto on_return;
+
+    for (i=0; i<PJ_ARRAY_SIZE(thread_cnts); ++i) {
+        PJ_LOG(3,(THIS_FILE, "    %d thread(s): %d lookups/sec",
+                  thread_cnts[i], speeds[i]));
+    }
+
+    pj_ansi_snprintf(desc, sizeof(desc),
+                     "Number of dialog lookups per second with "
+                     "<tt>pjsip_ua_find_dialog()</tt> from %d "
+                     "threads concurrently, with %d dialog table "
+                     "lock stripes.",
+                     thread_cnts[PJ_ARRAY_SIZE(thread_cnts)-1],
+                     PJSIP_UA_LOCK_STRIPE_CNT);
+
+    report_ival("dlg-lookup-mt-per-sec",
+                speeds[PJ_ARRAY_SIZE(thread_cnts)-1], "lookup/sec",
+                desc);
+
+on_return:
+    if (pool)
+        pjsip_endpt_release_pool(endpt, pool);
+
+    /* Leave the UA layer for the tests that want to initialize it with
+     * their own settings.
+     */
+    if (ua_initialized)
+        pjsip_ua_destroy();
+
+    return rc;
+}
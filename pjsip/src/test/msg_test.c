@@ -926,6 +926,315 @@ static int msg_benchmark(unsigned *p_detect, unsigned *p_parse,
 }
 #endif  /* INCLUDE_BENCHMARKS */
 
+/*****************************************************************************/
+/* Test lazy header parsing */
+
+static pjsip_msg *parse_rdata(pj_pool_t *pool, struct test_msg *entry,
+                              pj_bool_t lazy, pjsip_rx_data *rdata)
+{
+    pj_bool_t saved = pjsip_cfg()->endpt.lazy_hdr_parsing;
+    pjsip_msg *msg;
+
+    if (entry->len==0)
+        entry->len = pj_ansi_strlen(entry->msg);
+
+    pj_bzero(rdata, sizeof(*rdata));
+    rdata->tp_info.pool = pool;
+    pj_list_init(&rdata->msg_info.parse_err);
+
+    pjsip_cfg()->endpt.lazy_hdr_parsing = lazy;
+    msg = pjsip_parse_rdata(entry->msg, entry->len, rdata);
+    pjsip_cfg()->endpt.lazy_hdr_parsing = saved;
+
+    return msg;
+}
+
+static int lazy_hdr_test_entry(pj_pool_t *pool, struct test_msg *entry)
+{
+    pjsip_rx_data rdata1, rdata2;
+    pjsip_msg *msg1, *msg2;
+    pjsip_hdr *h1, *h2;
+    char buf1[PJSIP_MAX_PKT_LEN], buf2[PJSIP_MAX_PKT_LEN];
+    pj_ssize_t len1, len2;
+
+    msg1 = parse_rdata(pool, entry, PJ_FALSE, &rdata1);
+    msg2 = parse_rdata(pool, entry, PJ_TRUE, &rdata2);
+    PJ_TEST_NOT_NULL(msg1, NULL, return -300);
+    PJ_TEST_NOT_NULL(msg2, NULL, return -305);
+
+    /* Mandatory headers must have been parsed */
+    PJ_TEST_EQ(rdata1.msg_info.from!=NULL, rdata2.msg_info.from!=NULL,
+               NULL, return -310);
+    PJ_TEST_EQ(rdata1.msg_info.cid!=NULL, rdata2.msg_info.cid!=NULL,
+               NULL, return -311);
+    PJ_TEST_EQ(rdata1.msg_info.via!=NULL, rdata2.msg_info.via!=NULL,
+               NULL, return -312);
+    PJ_TEST_EQ(rdata1.msg_info.cseq!=NULL, rdata2.msg_info.cseq!=NULL,
+               NULL, return -313);
+    PJ_TEST_EQ(rdata1.msg_info.ctype!=NULL, rdata2.msg_info.ctype!=NULL,
+               NULL, return -314);
+
+    /* Deferred headers are printed with their raw values */
+    len2 = pjsip_msg_print(msg2, buf2, sizeof(buf2));
+    PJ_TEST_GT(len2, 0, NULL, return -320);
+
+    /* Look up every header in the lazily parsed message. */
+    for (h1=msg1->hdr.next; h1!=&msg1->hdr; h1=h1->next) {
+        if (h1->type != PJSIP_H_OTHER) {
+            h2 = (pjsip_hdr*)pjsip_msg_find_hdr(msg2, h1->type, NULL);
+        } else {
+            h2 = (pjsip_hdr*)pjsip_msg_find_hdr_by_name(msg2, &h1->name,
+                                                        NULL);
+        }
+        PJ_TEST_NOT_NULL(h2, h1->name.ptr, return -330);
+        PJ_TEST_EQ(h2->type, h1->type, h1->name.ptr, return -331);
+    }
+
+    /* Now the list must be identical to the fully parsed one */
+    for (h1=msg1->hdr.next, h2=msg2->hdr.next;
+         h1!=&msg1->hdr && h2!=&msg2->hdr;
+         h1=h1->next, h2=h2->next)
+    {
+        PJ_TEST_EQ(h2->type, h1->type, h1->name.ptr, return -340);
+        len1 = pjsip_hdr_print_on(h1, buf1, sizeof(buf1));
+        len2 = pjsip_hdr_print_on(h2, buf2, sizeof(buf2));
+        PJ_TEST_EQ(len1, len2, h1->name.ptr, return -341);
+        PJ_TEST_EQ(pj_memcmp(buf1, buf2, len1), 0, h1->name.ptr,
+                   return -342);
+    }
+    PJ_TEST_TRUE(h1==&msg1->hdr && h2==&msg2->hdr, NULL, return -345);
+
+    return 0;
+}
+
+static int lazy_hdr_test(void)
+{
+    static char msg[] =
+        "SIP/2.0 401 Unauthorized\r\n"
+        "Via: SIP/2.0/UDP 192.168.0.1:5060;branch=z9hG4bK-lazy\r\n"
+        "From: <sip:alice@example.com>;tag=1234\r\n"
+        "To: <sip:alice@example.com>;tag=5678\r\n"
+        "Call-ID: lazy@example.com\r\n"
+        "CSeq: 1 REGISTER\r\n"
+        "WWW-Authenticate: Digest realm=\"example.com\", nonce=\"abc\"\r\n"
+        "m: <sip:alice@192.168.0.1>;expires=60\r\n"
+        "Expires: bogus\r\n"
+        "Content-Length: 0\r\n"
+        "\r\n";
+    struct test_msg entry;
+    pjsip_rx_data rdata;
+    pjsip_msg *parsed;
+    pjsip_hdr *hdr;
+    pj_str_t name, sname;
+    pj_pool_t *pool;
+    unsigned i;
+    int rc = 0;
+
+    PJ_LOG(3,(THIS_FILE, "  lazy header parsing test.."));
+
+    for (i=0; i<PJ_ARRAY_SIZE(test_array); ++i) {
+        if (test_array[i].creator == NULL ||
+            test_array[i].expected_status != PJ_SUCCESS)
+        {
+            continue;
+        }
+
+        pool = pjsip_endpt_create_pool(endpt, NULL, POOL_SIZE, POOL_SIZE);
+        rc = lazy_hdr_test_entry(pool, &test_array[i]);
+        pjsip_endpt_release_pool(endpt, pool);
+        if (rc != 0)
+            return rc;
+    }
+
+    pj_bzero(&entry, sizeof(entry));
+    pj_ansi_strxcpy(entry.msg, msg, sizeof(entry.msg));
+    pool = pjsip_endpt_create_pool(endpt, NULL, POOL_SIZE, POOL_SIZE);
+
+    parsed = parse_rdata(pool, &entry, PJ_TRUE, &rdata);
+    PJ_TEST_NOT_NULL(parsed, NULL, { rc = -400; goto on_return; });
+
+    /* Deferred headers look like generic string headers until found */
+    hdr = parsed->hdr.next->next->next->next->next->next;
+    PJ_TEST_EQ(hdr->type, PJSIP_H_OTHER, NULL, { rc = -410; goto on_return; });
+    PJ_TEST_EQ(pj_strcmp2(&hdr->name, "WWW-Authenticate"), 0, NULL,
+               { rc = -411; goto on_return; });
+
+    /* Find by names, the header was received with its compact name */
+    name = pj_str("Contact");
+    sname = pj_str("m");
+    hdr = (pjsip_hdr*)pjsip_msg_find_hdr_by_names(parsed, &name, &sname,
+                                                  NULL);
+    PJ_TEST_NOT_NULL(hdr, NULL, { rc = -420; goto on_return; });
+    PJ_TEST_EQ(hdr->type, PJSIP_H_CONTACT, NULL,
+               { rc = -421; goto on_return; });
+
+    /* Find by type */
+    hdr = (pjsip_hdr*)pjsip_msg_find_hdr(parsed, PJSIP_H_WWW_AUTHENTICATE,
+                                         NULL);
+    PJ_TEST_NOT_NULL(hdr, NULL, { rc = -430; goto on_return; });
+    PJ_TEST_EQ(pj_strcmp2(&((pjsip_www_authenticate_hdr*)hdr)->
+                              challenge.digest.realm, "example.com"), 0,
+               NULL, { rc = -431; goto on_return; });
+
+    /* Invalid value is kept as generic string header */
+    hdr = (pjsip_hdr*)pjsip_msg_find_hdr(parsed, PJSIP_H_EXPIRES, NULL);
+    PJ_TEST_EQ(hdr, NULL, NULL, { rc = -440; goto on_return; });
+    name = pj_str("Expires");
+    hdr = (pjsip_hdr*)pjsip_msg_find_hdr_by_name(parsed, &name, NULL);
+    PJ_TEST_NOT_NULL(hdr, NULL, { rc = -441; goto on_return; });
+    PJ_TEST_EQ(pj_strcmp2(&((pjsip_generic_string_hdr*)hdr)->hvalue, "bogus"),
+               0, NULL, { rc = -442; goto on_return; });
+
+on_return:
+    pjsip_endpt_release_pool(endpt, pool);
+    return rc;
+}
+
+#if INCLUDE_BENCHMARKS
+/* Number of messages parsed per second with pjsip_parse_rdata() */
+static unsigned rdata_parse_benchmark(pj_bool_t lazy)
+{
+    pjsip_rx_data rdata;
+    pj_timestamp t1, t2;
+    pj_uint64_t usec;
+    unsigned i, loop, cnt = 0;
+
+    pj_get_timestamp(&t1);
+    for (loop=0; loop<LOOP; ++loop) {
+        for (i=0; i<PJ_ARRAY_SIZE(test_array); ++i) {
+            pj_pool_t *pool;
+
+            if (test_array[i].expected_status != PJ_SUCCESS)
+                continue;
+
+            pool = pjsip_endpt_create_pool(endpt, NULL, POOL_SIZE, POOL_SIZE);
+            if (parse_rdata(pool, &test_array[i], lazy, &rdata))
+                ++cnt;
+            pjsip_endpt_release_pool(endpt, pool);
+        }
+    }
+    pj_get_timestamp(&t2);
+
+    usec = pj_elapsed_usec(&t1, &t2);
+    return (unsigned)(cnt * PJ_UINT64(1000000) / (usec? usec : 1));
+}
+#endif  /* INCLUDE_BENCHMARKS */
+
+/*****************************************************************************/
+/* Test recovery from errors in headers */
+
+static struct test_msg bad_hdr_msg =
+{
+    "INVITE sip:user@foo SIP/2.0\r\n"
+    "Via: SIP/2.0 UDP host\r\n"
+    "Via: SIP/2.0/UDP host:5060;branch=z9hG4bK1234\r\n"
+    "From: <sip:alice@atlanta.com;tag=1234\r\n"
+    "From: <sip:alice@atlanta.com>;tag=1234\r\n"
+    "To: \"Bob <sip:bob@biloxi.com>\r\n"
+    "To: Bob <sip:bob@biloxi.com>\r\n"
+    "Call-ID: 12345678901234567890@bar\r\n"
+    "CSeq: x INVITE\r\n"
+    "CSeq: 1 INVITE\r\n"
+    "Contact: <sip:alice@pc33.atlanta.com>;q=0.5, <foo\r\n"
+    "Max-Forwards: -1\r\n"
+    "Route: <sip:proxy.atlanta.com;lr>\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n",
+    NULL, 0, PJ_SUCCESS
+};
+
+static int bad_hdr_test(void)
+{
+    static const char *bad_hnames[] = { "Via", "From", "To", "CSeq",
+                                        "Contact", "Max-Forwards" };
+    static const int bad_lines[] = { 2, 4, 6, 9, 11, 12 };
+    pj_pool_t *pool;
+    pjsip_rx_data rdata;
+    pjsip_msg *msg;
+    pjsip_parser_err_report *err;
+    unsigned i;
+    int rc = 0;
+
+    PJ_LOG(3,(THIS_FILE, "  bad header test"));
+
+    pool = pjsip_endpt_create_pool(endpt, NULL, POOL_SIZE, POOL_SIZE);
+    msg = parse_rdata(pool, &bad_hdr_msg, PJ_FALSE, &rdata);
+    PJ_TEST_NOT_NULL(msg, NULL, { rc = -500; goto on_return; });
+
+    /* Each bad header is reported and skipped */
+    PJ_TEST_EQ(pj_list_size(&rdata.msg_info.parse_err),
+               PJ_ARRAY_SIZE(bad_hnames), NULL,
+               { rc = -510; goto on_return; });
+    for (i=0, err=rdata.msg_info.parse_err.next;
+         err != &rdata.msg_info.parse_err; ++i, err=err->next)
+    {
+        PJ_TEST_EQ(pj_strcmp2(&err->hname, bad_hnames[i]), 0, bad_hnames[i],
+                   { rc = -520; goto on_return; });
+        PJ_TEST_EQ(err->line, bad_lines[i], bad_hnames[i],
+                   { rc = -521; goto on_return; });
+    }
+
+    /* The good headers are parsed */
+    PJ_TEST_NOT_NULL(rdata.msg_info.via, NULL,
+                     { rc = -530; goto on_return; });
+    PJ_TEST_EQ(rdata.msg_info.via->sent_by.port, 5060, NULL,
+               { rc = -531; goto on_return; });
+    PJ_TEST_NOT_NULL(rdata.msg_info.from, NULL,
+                     { rc = -532; goto on_return; });
+    PJ_TEST_EQ(pj_strcmp2(&rdata.msg_info.from->tag, "1234"), 0, NULL,
+               { rc = -533; goto on_return; });
+    PJ_TEST_NOT_NULL(rdata.msg_info.to, NULL,
+                     { rc = -534; goto on_return; });
+    PJ_TEST_NOT_NULL(rdata.msg_info.cseq, NULL,
+                     { rc = -535; goto on_return; });
+    PJ_TEST_EQ(rdata.msg_info.cseq->cseq, 1, NULL,
+               { rc = -536; goto on_return; });
+    PJ_TEST_NOT_NULL(rdata.msg_info.route, NULL,
+                     { rc = -537; goto on_return; });
+
+    /* The bad headers are not */
+    PJ_TEST_EQ(rdata.msg_info.max_fwd, NULL, NULL,
+               { rc = -540; goto on_return; });
+    PJ_TEST_EQ(pjsip_msg_find_hdr(msg, PJSIP_H_CONTACT, NULL), NULL, NULL,
+               { rc = -541; goto on_return; });
+    PJ_TEST_EQ(pjsip_msg_find_hdr(msg, PJSIP_H_VIA,
+                                  rdata.msg_info.via->next), NULL, NULL,
+               { rc = -542; goto on_return; });
+
+on_return:
+    pjsip_endpt_release_pool(endpt, pool);
+    return rc;
+}
+
+#if INCLUDE_BENCHMARKS
+/* Number of messages with bad headers parsed per second */
+static unsigned bad_hdr_benchmark(void)
+{
+    pj_timestamp t1, t2;
+    pj_uint64_t usec;
+    unsigned loop, cnt = 0;
+
+    pj_get_timestamp(&t1);
+    for (loop=0; loop<LOOP; ++loop) {
+        pjsip_parser_err_report err_list;
+        pj_pool_t *pool;
+
+        pool = pjsip_endpt_create_pool(endpt, NULL, POOL_SIZE, POOL_SIZE);
+        pj_list_init(&err_list);
+        if (pjsip_parse_msg(pool, bad_hdr_msg.msg, bad_hdr_msg.len,
+                            &err_list))
+        {
+            ++cnt;
+        }
+        pjsip_endpt_release_pool(endpt, pool);
+    }
+    pj_get_timestamp(&t2);
+
+    usec = pj_elapsed_usec(&t1, &t2);
+    return (unsigned)(cnt * PJ_UINT64(1000000) / (usec? usec : 1));
+}
+#endif  /* INCLUDE_BENCHMARKS */
+
 /*****************************************************************************/
 /* Test various header parsing and production */
 static int hdr_test_success(pjsip_hdr *h);
@@ -1990,6 +2299,73 @@ static int hdr_test(void)
 }
 
 
+/* Test that header parser lookup ignores case, for both the built-in
+ * header parsers and the ones registered by other modules, and that
+ * names that share first character and length with a known header are
+ * not mistaken for it.
+ */
+static int hdr_name_test(void)
+{
+    static const struct {
+        char           *hname;
+        char           *hcontent;
+        pjsip_hdr_e     type;
+    } data[] =
+    {
+        { "Call-ID",       "abc",                PJSIP_H_CALL_ID },
+        { "CALL-ID",       "abc",                PJSIP_H_CALL_ID },
+        { "call-id",       "abc",                PJSIP_H_CALL_ID },
+        { "cAlL-iD",       "abc",                PJSIP_H_CALL_ID },
+        { "I",             "abc",                PJSIP_H_CALL_ID },
+        { "Call-Ix",       "abc",                PJSIP_H_OTHER },
+        { "Xall-ID",       "abc",                PJSIP_H_OTHER },
+        { "VIA",           "SIP/2.0/UDP host",   PJSIP_H_VIA },
+        { "V",             "SIP/2.0/UDP host",   PJSIP_H_VIA },
+        { "Vie",           "SIP/2.0/UDP host",   PJSIP_H_OTHER },
+        { "content-LENGTH", "10",                PJSIP_H_CONTENT_LENGTH },
+        { "L",             "10",                 PJSIP_H_CONTENT_LENGTH },
+        { "CSEQ",          "1 INVITE",           PJSIP_H_CSEQ },
+        { "www-authenticate", "Digest realm=\"a\"",
+                                                 PJSIP_H_WWW_AUTHENTICATE },
+        { "AUTHORIZATION", "Digest username=\"a\"",
+                                                 PJSIP_H_AUTHORIZATION },
+        { "-",             "abc",                PJSIP_H_OTHER },
+        { "X-Custom",      "abc",                PJSIP_H_OTHER },
+    };
+    pj_pool_t *pool;
+    unsigned i;
+
+    PJ_LOG(3,(THIS_FILE, "  testing header name lookup.."));
+
+    pool = pjsip_endpt_create_pool(endpt, NULL, POOL_SIZE, POOL_SIZE);
+
+    for (i=0; i<PJ_ARRAY_SIZE(data); ++i) {
+        pj_str_t hname = pj_str(data[i].hname);
+        char hcontent[80];
+        int parsed_len;
+        pjsip_hdr *hdr;
+
+        pj_ansi_strxcpy(hcontent, data[i].hcontent, sizeof(hcontent));
+        hdr = (pjsip_hdr*) pjsip_parse_hdr(pool, &hname, hcontent,
+                                           strlen(hcontent), &parsed_len);
+        if (hdr == NULL) {
+            PJ_LOG(3,(THIS_FILE, "    error parsing header %s",
+                      data[i].hname));
+            pj_pool_release(pool);
+            return -800;
+        }
+        if (hdr->type != data[i].type) {
+            PJ_LOG(3,(THIS_FILE, "    header %s has type %d, expecting %d",
+                      data[i].hname, hdr->type, data[i].type));
+            pj_pool_release(pool);
+            return -810;
+        }
+    }
+
+    pj_pool_release(pool);
+    return 0;
+}
+
 /*****************************************************************************/
 
 int msg_test(void)
@@ -2008,10 +2384,22 @@ int msg_test(void)
     if (status != 0)
         return status;
 
+    status = hdr_name_test();
+    if (status != 0)
+        return status;
+
     status = simple_test();
     if (status != PJ_SUCCESS)
         return status;
 
+    status = lazy_hdr_test();
+    if (status != PJ_SUCCESS)
+        return status;
+
+    status = bad_hdr_test();
+    if (status != PJ_SUCCESS)
+        return status;
+
 #if INCLUDE_BENCHMARKS
     for (i=0; i<COUNT; ++i) {
         PJ_LOG(3,(THIS_FILE, "  benchmarking (%d of %d)..", i+1, COUNT));
@@ -2083,6 +2471,31 @@ int msg_test(void)
                 "SIP messages printed per second). "
                 "The value is derived from msg-print-per-sec above.");
 
+    /* Lazy header parsing */
+    max = rdata_parse_benchmark(PJ_FALSE);
+    PJ_LOG(3,("", "  Message parsing/sec with pjsip_parse_rdata()=%u", max));
+    max = rdata_parse_benchmark(PJ_TRUE);
+    PJ_LOG(3,("", "  Message parsing/sec with lazy header parsing=%u", max));
+
+    pj_ansi_snprintf(desc, sizeof(desc),
+                          "Number of SIP messages "
+                          "can be parsed by <tt>pjsip_parse_rdata()</tt> "
+                          "per second with lazy header parsing enabled, "
+                          "when no other headers are looked up (tested with "
+                          "%d message sets with average message length of "
+                          "%d bytes)", (int)PJ_ARRAY_SIZE(test_array), avg_len);
+    report_ival("msg-lazy-parse-per-sec", max, "msg/sec", desc);
+
+    /* Parsing messages with bad headers */
+    max = bad_hdr_benchmark();
+    PJ_LOG(3,("", "  Message with bad headers parsing/sec=%u", max));
+
+    pj_ansi_snprintf(desc, sizeof(desc),
+                          "Number of SIP messages with %d bad headers "
+                          "(which are reported and skipped) can be parsed "
+                          "by <tt>pjsip_parse_msg()</tt> per second", 6);
+    report_ival("msg-parse-err-per-sec", max, "msg/sec", desc);
+
 #endif  /* INCLUDE_BENCHMARKS */
 
     return PJ_SUCCESS;
@@ -310,12 +310,23 @@ int test_main(int argc, char *argv[])
     UT_ADD_TEST(&test_app.ut_app, txdata_test, 0);
 #endif
 
+#if INCLUDE_AUTH_TEST
+    UT_ADD_TEST(&test_app.ut_app, auth_test, 0);
+#endif
+
 #if INCLUDE_TSX_BENCH
     UT_ADD_TEST(&test_app.ut_app, tsx_bench, 0);
 #endif
 
+#if INCLUDE_DLG_BENCH
+    UT_ADD_TEST(&test_app.ut_app, dlg_bench, 0);
+#endif
+
 #if INCLUDE_LOOP_TEST
     UT_ADD_TEST(&test_app.ut_app, transport_loop_multi_test, 0);
+    UT_ADD_TEST(&test_app.ut_app, transport_loop_raw_rsp_test, 0);
+    UT_ADD_TEST(&test_app.ut_app, transport_loop_rx_worker_test, 0);
+    UT_ADD_TEST(&test_app.ut_app, transport_loop_overload_test, 0);
 #endif
 
 #if INCLUDE_RESOLVE_TEST
@@ -363,6 +374,7 @@ int test_main(int argc, char *argv[])
 
 #if INCLUDE_TCP_TEST
     UT_ADD_TEST(&test_app.ut_app, transport_tcp_test, 0);
+    UT_ADD_TEST(&test_app.ut_app, transport_tpmgr_test, 0);
 #endif
 
     /* Note: put exclusive tests last */
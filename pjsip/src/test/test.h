@@ -64,7 +64,9 @@ extern pj_caching_pool caching_pool;
 #define INCLUDE_MSG_TEST        INCLUDE_MESSAGING_GROUP
 #define INCLUDE_MULTIPART_TEST  INCLUDE_MESSAGING_GROUP
 #define INCLUDE_TXDATA_TEST     INCLUDE_MESSAGING_GROUP
+#define INCLUDE_AUTH_TEST       INCLUDE_MESSAGING_GROUP
 #define INCLUDE_TSX_BENCH       (INCLUDE_MESSAGING_GROUP && WITH_BENCHMARK)
+#define INCLUDE_DLG_BENCH       (INCLUDE_MESSAGING_GROUP && WITH_BENCHMARK)
 #define INCLUDE_UDP_TEST        INCLUDE_TRANSPORT_GROUP
 #define INCLUDE_LOOP_TEST       INCLUDE_TRANSPORT_GROUP
 #define INCLUDE_TCP_TEST        INCLUDE_TRANSPORT_GROUP
@@ -81,13 +83,19 @@ int msg_test(void);
 int msg_err_test(void);
 int multipart_test(void);
 int txdata_test(void);
+int auth_test(void);
 int tsx_bench(void);
+int dlg_bench(void);
 int tsx_destroy_test(void);
 int transport_udp_test(void);
 int transport_loop_test(void);
 int transport_loop_multi_test(void);
+int transport_loop_raw_rsp_test(void);
+int transport_loop_rx_worker_test(void);
+int transport_loop_overload_test(void);
 int transport_loop_resolve_error_test(void);
 int transport_tcp_test(void);
+int transport_tpmgr_test(void);
 int resolve_test(void);
 int regc_test(void);
 int inv_offer_answer_test(void);
@@ -175,6 +175,618 @@ on_return:
 #undef ERR
 }
 
+/* Stateless raw response test */
+static int raw_rsp_status;
+static int raw_rsp_cseq;
+
+static pj_bool_t raw_on_rx_request(pjsip_rx_data *rdata);
+static pj_bool_t raw_on_rx_response(pjsip_rx_data *rdata);
+
+static pjsip_module raw_rsp_tester_mod =
+{
+    NULL, NULL,                         /* prev and next        */
+    { "raw_rsp_test", 12},              /* Name.                */
+    -1,                                 /* Id                   */
+    PJSIP_MOD_PRIORITY_UA_PROXY_LAYER-1,/* Priority             */
+    NULL,                               /* load()               */
+    NULL,                               /* start()              */
+    NULL,                               /* stop()               */
+    NULL,                               /* unload()             */
+    &raw_on_rx_request,                 /* on_rx_request()      */
+    &raw_on_rx_response,                /* on_rx_response()     */
+    NULL,                               /* on_tx_request()      */
+    NULL,                               /* on_tx_response()     */
+    NULL,                               /* on_tsx_state()       */
+};
+
+static pj_bool_t raw_on_rx_request(pjsip_rx_data *rdata)
+{
+#define ERR(rc__)   {raw_rsp_status=rc__; return PJ_TRUE; }
+    const pj_str_t hname = { "X-Raw-Test", 10 };
+    pj_str_t hvalue;
+    pjsip_hdr hdr_list;
+    pjsip_generic_string_hdr *h;
+
+    if (!is_user_equal(rdata->msg_info.from, "transport_loop_raw_rsp_test"))
+        return PJ_FALSE;
+
+    pj_list_init(&hdr_list);
+    hvalue = pj_str("raw");
+    h = pjsip_generic_string_hdr_create(rdata->tp_info.pool, &hname, &hvalue);
+    pj_list_push_back(&hdr_list, h);
+
+    PJ_TEST_SUCCESS(pjsip_endpt_respond_stateless_raw(endpt, rdata,
+                                                      PJSIP_SC_NOT_FOUND,
+                                                      NULL, &hdr_list),
+                    NULL, ERR(-100));
+    return PJ_TRUE;
+#undef ERR
+}
+
+static pj_bool_t raw_on_rx_response(pjsip_rx_data *rdata)
+{
+#define ERR(rc__)   {raw_rsp_status=rc__; return PJ_TRUE; }
+    const pj_str_t hname = { "X-Raw-Test", 10 };
+    pjsip_generic_string_hdr *h;
+
+    if (!is_user_equal(rdata->msg_info.from, "transport_loop_raw_rsp_test"))
+        return PJ_FALSE;
+
+    PJ_TEST_EQ(rdata->msg_info.msg->line.status.code, PJSIP_SC_NOT_FOUND,
+               NULL, ERR(-150));
+    PJ_TEST_EQ(rdata->msg_info.cseq->cseq, raw_rsp_cseq, NULL, ERR(-160));
+    h = (pjsip_generic_string_hdr*)
+        pjsip_msg_find_hdr_by_name(rdata->msg_info.msg, &hname, NULL);
+    PJ_TEST_NOT_NULL(h, "X-Raw-Test header not found", ERR(-170));
+    PJ_TEST_EQ(pj_strcmp2(&h->hvalue, "raw"), 0, NULL, ERR(-180));
+
+    raw_rsp_status = 0;
+    return PJ_TRUE;
+#undef ERR
+}
+
+/* Test that responses sent with pjsip_endpt_respond_stateless_raw() are
+ * received intact, including when the transmit buffer is reused.
+ */
+int transport_loop_raw_rsp_test(void)
+{
+#define ERR(rc__)   { rc=rc__; goto on_return; }
+    enum { N = PJSIP_MAX_RAW_RSP_TDATA + 4, TIMEOUT=1000 };
+    pjsip_transport *loop = NULL;
+    int i, rc;
+
+    PJ_TEST_SUCCESS(pjsip_endpt_register_module(endpt, &raw_rsp_tester_mod),
+                    NULL, ERR(-5));
+    PJ_TEST_SUCCESS(pjsip_loop_start(endpt, &loop), NULL, ERR(-10));
+    pjsip_transport_add_ref(loop);
+
+    for (i=0; i<N; ++i) {
+        pj_str_t url;
+        pjsip_tpselector tp_sel;
+        pjsip_tx_data *tdata;
+        pj_time_val timeout, now;
+
+        raw_rsp_status = PJ_EPENDING;
+        raw_rsp_cseq = i + 1;
+
+        pj_bzero(&tp_sel, sizeof(tp_sel));
+        tp_sel.type = PJSIP_TPSELECTOR_TRANSPORT;
+        tp_sel.u.transport = loop;
+
+        url = pj_str("sip:transport_loop_raw_rsp_test@127.0.0.1");
+
+        PJ_TEST_SUCCESS(pjsip_endpt_create_request(endpt, &pjsip_options_method,
+                                                   &url, &url, &url,
+                                                   NULL, NULL, raw_rsp_cseq,
+                                                   NULL, &tdata),
+                        NULL, ERR(-20));
+        PJ_TEST_SUCCESS(pjsip_tx_data_set_transport(tdata, &tp_sel),
+                        NULL, ERR(-30));
+        PJ_TEST_SUCCESS(pjsip_endpt_send_request_stateless(endpt, tdata, NULL, NULL),
+                        NULL, ERR(-40));
+
+        pj_gettimeofday(&timeout);
+        now = timeout;
+        timeout.msec += TIMEOUT;
+        pj_time_val_normalize(&timeout);
+
+        while (raw_rsp_status==PJ_EPENDING && PJ_TIME_VAL_LT(now, timeout)) {
+            flush_events(100);
+            pj_gettimeofday(&now);
+        }
+
+        PJ_TEST_NEQ(raw_rsp_status, PJ_EPENDING, "test has timed-out",
+                    ERR(-50));
+        if (raw_rsp_status != 0) {
+            rc = -60;
+            goto on_return;
+        }
+    }
+
+    rc = 0;
+
+on_return:
+    if (loop) {
+        /* Order must be shutdown then dec_ref so it gets destroyed */
+        pjsip_transport_shutdown(loop);
+        pjsip_transport_dec_ref(loop);
+    }
+    if (raw_rsp_tester_mod.id != -1) {
+        pjsip_endpt_unregister_module(endpt, &raw_rsp_tester_mod);
+    }
+    /* let transport destroy run its course */
+    flush_events(500);
+    return rc;
+#undef ERR
+}
+
+/* Receive worker test */
+enum { RXW_CALLS = 4, RXW_MSGS = 50 };
+static struct rxw_call
+{
+    pj_thread_t *thread;
+    int          last_cseq;
+    int          err;
+} rxw_calls[RXW_CALLS];
+static pj_atomic_t *rxw_rx_cnt;
+
+static pj_bool_t rxw_on_rx_request(pjsip_rx_data *rdata);
+
+static pjsip_module rx_worker_tester_mod =
+{
+    NULL, NULL,                         /* prev and next        */
+    { "rx_worker_test", 14},            /* Name.                */
+    -1,                                 /* Id                   */
+    PJSIP_MOD_PRIORITY_UA_PROXY_LAYER-1,/* Priority             */
+    NULL,                               /* load()               */
+    NULL,                               /* start()              */
+    NULL,                               /* stop()               */
+    NULL,                               /* unload()             */
+    &rxw_on_rx_request,                 /* on_rx_request()      */
+    NULL,                               /* on_rx_response()     */
+    NULL,                               /* on_tx_request()      */
+    NULL,                               /* on_tx_response()     */
+    NULL,                               /* on_tsx_state()       */
+};
+
+static pj_bool_t rxw_on_rx_request(pjsip_rx_data *rdata)
+{
+    struct rxw_call *call;
+    int idx;
+
+    if (!is_user_equal(rdata->msg_info.from, "rx_worker_test"))
+        return PJ_FALSE;
+
+    /* Call-ID is "rxw-<index>" */
+    idx = rdata->msg_info.cid->id.ptr[rdata->msg_info.cid->id.slen-1] - '0';
+    call = &rxw_calls[idx];
+
+    /* Same call must be processed by the same thread, in order */
+    if (call->thread == NULL)
+        call->thread = pj_thread_this();
+    else if (call->thread != pj_thread_this())
+        call->err = -300;
+    if (rdata->msg_info.cseq->cseq != call->last_cseq + 1)
+        call->err = -310;
+    call->last_cseq = rdata->msg_info.cseq->cseq;
+
+    pj_atomic_inc(rxw_rx_cnt);
+    return PJ_TRUE;
+}
+
+/* Test that messages are processed by receive workers, in order for
+ * each Call-ID.
+ */
+int transport_loop_rx_worker_test(void)
+{
+#define ERR(rc__)   { rc=rc__; goto on_return; }
+    enum { TIMEOUT = 5000 };
+    pjsip_transport *loop = NULL;
+    pjsip_tpselector tp_sel;
+    pjsip_rx_worker_stat stat[RXW_CALLS];
+    pj_time_val timeout, now;
+    pj_pool_t *pool;
+    unsigned i, cnt, msg_cnt;
+    int j, rc;
+
+    pj_bzero(rxw_calls, sizeof(rxw_calls));
+    pool = pjsip_endpt_create_pool(endpt, "rxw", 512, 512);
+    PJ_TEST_SUCCESS(pj_atomic_create(pool, 0, &rxw_rx_cnt), NULL, ERR(-5));
+
+    PJ_TEST_SUCCESS(pjsip_endpt_register_module(endpt, &rx_worker_tester_mod),
+                    NULL, ERR(-10));
+    PJ_TEST_SUCCESS(pjsip_loop_start(endpt, &loop), NULL, ERR(-20));
+    pjsip_transport_add_ref(loop);
+
+    PJ_TEST_SUCCESS(pjsip_endpt_start_rx_workers(endpt, 2), NULL, ERR(-30));
+
+    pj_bzero(&tp_sel, sizeof(tp_sel));
+    tp_sel.type = PJSIP_TPSELECTOR_TRANSPORT;
+    tp_sel.u.transport = loop;
+
+    /* Interleave the calls */
+    for (j=1; j<=RXW_MSGS; ++j) {
+        for (i=0; i<RXW_CALLS; ++i) {
+            pj_str_t url = pj_str("sip:rx_worker_test@127.0.0.1");
+            char call_id_buf[16];
+            pj_str_t call_id;
+            pjsip_tx_data *tdata;
+
+            pj_ansi_snprintf(call_id_buf, sizeof(call_id_buf), "rxw-%d", i);
+            call_id = pj_str(call_id_buf);
+
+            PJ_TEST_SUCCESS(pjsip_endpt_create_request(endpt,
+                                                       &pjsip_options_method,
+                                                       &url, &url, &url,
+                                                       NULL, &call_id, j,
+                                                       NULL, &tdata),
+                            NULL, ERR(-40));
+            PJ_TEST_SUCCESS(pjsip_tx_data_set_transport(tdata, &tp_sel),
+                            NULL, ERR(-50));
+            PJ_TEST_SUCCESS(pjsip_endpt_send_request_stateless(endpt, tdata,
+                                                               NULL, NULL),
+                            NULL, ERR(-60));
+        }
+    }
+
+    pj_gettimeofday(&timeout);
+    now = timeout;
+    timeout.msec += TIMEOUT;
+    pj_time_val_normalize(&timeout);
+
+    while (pj_atomic_get(rxw_rx_cnt) < RXW_CALLS * RXW_MSGS &&
+           PJ_TIME_VAL_LT(now, timeout))
+    {
+        flush_events(100);
+        pj_gettimeofday(&now);
+    }
+
+    PJ_TEST_EQ(pj_atomic_get(rxw_rx_cnt), RXW_CALLS * RXW_MSGS,
+               "not all messages are received", ERR(-70));
+
+    for (i=0; i<RXW_CALLS; ++i) {
+        PJ_TEST_EQ(rxw_calls[i].err, 0, NULL, ERR(rxw_calls[i].err));
+        PJ_TEST_NEQ(rxw_calls[i].thread, pj_thread_this(),
+                    "message is not processed by worker", ERR(-80));
+    }
+
+    /* Check statistics */
+    cnt = PJ_ARRAY_SIZE(stat);
+    PJ_TEST_SUCCESS(pjsip_endpt_get_rx_worker_stat(endpt, &cnt, stat),
+                    NULL, ERR(-90));
+    PJ_TEST_EQ(cnt, 2, NULL, ERR(-100));
+    for (i=0, msg_cnt=0; i<cnt; ++i) {
+        PJ_TEST_EQ(stat[i].queue_len, 0, NULL, ERR(-110));
+        PJ_TEST_LTE(stat[i].avg_delay_usec, stat[i].max_delay_usec, NULL,
+                    ERR(-120));
+        msg_cnt += stat[i].msg_cnt;
+    }
+    PJ_TEST_GTE(msg_cnt, RXW_CALLS * RXW_MSGS, NULL, ERR(-130));
+
+    rc = 0;
+
+on_return:
+    pjsip_endpt_stop_rx_workers(endpt);
+    if (loop) {
+        pjsip_transport_shutdown(loop);
+        pjsip_transport_dec_ref(loop);
+    }
+    if (rx_worker_tester_mod.id != -1) {
+        pjsip_endpt_unregister_module(endpt, &rx_worker_tester_mod);
+    }
+    if (rxw_rx_cnt) {
+        pj_atomic_destroy(rxw_rx_cnt);
+        rxw_rx_cnt = NULL;
+    }
+    pj_pool_release(pool);
+    flush_events(500);
+    return rc;
+#undef ERR
+}
+
+/*
+ * Overload control test.
+ */
+static pj_bool_t oc_on_rx_request(pjsip_rx_data *rdata);
+static pj_bool_t oc_on_rx_response(pjsip_rx_data *rdata);
+
+static pjsip_module oc_tester_mod =
+{
+    NULL, NULL,                         /* prev and next        */
+    { "oc_test", 7},                    /* Name.                */
+    -1,                                 /* Id                   */
+    PJSIP_MOD_PRIORITY_UA_PROXY_LAYER-1,/* Priority             */
+    NULL,                               /* load()               */
+    NULL,                               /* start()              */
+    NULL,                               /* stop()               */
+    NULL,                               /* unload()             */
+    &oc_on_rx_request,                  /* on_rx_request()      */
+    &oc_on_rx_response,                 /* on_rx_response()     */
+    NULL,                               /* on_tx_request()      */
+    NULL,                               /* on_tx_response()     */
+    NULL,                               /* on_tsx_state()       */
+};
+
+static struct oc_test_state
+{
+    pj_atomic_t *rx_req_cnt;
+    pj_atomic_t *rx_503_cnt;
+    unsigned     proc_delay;
+    unsigned     expected_oc;
+    pjsip_transaction *tsx;
+    int          err;
+} oc_state;
+
+static pj_bool_t oc_on_rx_request(pjsip_rx_data *rdata)
+{
+    if (!is_user_equal(rdata->msg_info.from, "oc_test"))
+        return PJ_FALSE;
+
+    if (oc_state.proc_delay)
+        pj_thread_sleep(oc_state.proc_delay);
+
+    /* Keep a server transaction, without responding, for the INVITE whose
+     * retransmission must not be rejected.
+     */
+    if (pj_strcmp2(&rdata->msg_info.cid->id, "oc-retrans")==0) {
+        if (oc_state.tsx ||
+            pjsip_tsx_create_uas2(NULL, rdata, NULL,
+                                  &oc_state.tsx) != PJ_SUCCESS)
+        {
+            oc_state.err = -300;
+        } else {
+            pjsip_tsx_recv_msg(oc_state.tsx, rdata);
+        }
+    }
+
+    pj_atomic_inc(oc_state.rx_req_cnt);
+    return PJ_TRUE;
+}
+
+static pj_bool_t oc_on_rx_response(pjsip_rx_data *rdata)
+{
+    static const pj_str_t STR_OC = { "oc", 2 };
+    static const pj_str_t STR_OC_ALGO = { "oc-algo", 7 };
+    static const pj_str_t STR_OC_SEQ = { "oc-seq", 6 };
+    pjsip_via_hdr *via = rdata->msg_info.via;
+    pjsip_retry_after_hdr *ra;
+    pjsip_param *oc;
+
+    if (!is_user_equal(rdata->msg_info.from, "oc_test"))
+        return PJ_FALSE;
+
+    if (rdata->msg_info.msg->line.status.code != 503) {
+        oc_state.err = -400;
+        return PJ_TRUE;
+    }
+
+    ra = (pjsip_retry_after_hdr*)
+         pjsip_msg_find_hdr(rdata->msg_info.msg, PJSIP_H_RETRY_AFTER, NULL);
+    if (!ra || ra->ivalue != PJSIP_OVERLOAD_RETRY_AFTER)
+        oc_state.err = -410;
+
+    /* RFC 7339 parameters */
+    oc = pjsip_param_find(&via->other_param, &STR_OC);
+    if (!oc || oc->value.slen == 0)
+        oc_state.err = -420;
+    else if (oc_state.expected_oc &&
+             (unsigned)pj_strtoul(&oc->value) != oc_state.expected_oc)
+        oc_state.err = -430;
+    if (!pjsip_param_find(&via->other_param, &STR_OC_ALGO) ||
+        !pjsip_param_find(&via->other_param, &STR_OC_SEQ))
+    {
+        oc_state.err = -440;
+    }
+
+    pj_atomic_inc(oc_state.rx_503_cnt);
+    return PJ_TRUE;
+}
+
+static int oc_send_request(pjsip_transport *loop, const pjsip_method *method,
+                           const char *to_tag, const char *call_id, int cseq,
+                           pjsip_tx_data **p_tdata)
+{
+    static const pj_str_t STR_OC = { "oc", 2 };
+    pj_str_t url = pj_str("sip:oc_test@127.0.0.1");
+    pj_str_t cid = pj_str((char*)call_id);
+    pjsip_tpselector tp_sel;
+    pjsip_tx_data *tdata;
+    pjsip_via_hdr *via;
+    pjsip_param *oc;
+
+    PJ_TEST_SUCCESS(pjsip_endpt_create_request(endpt, method, &url, &url,
+                                               &url, NULL, &cid, cseq,
+                                               NULL, &tdata),
+                    NULL, return -10);
+
+    if (to_tag) {
+        pjsip_to_hdr *to = PJSIP_MSG_TO_HDR(tdata->msg);
+        pj_strdup2(tdata->pool, &to->tag, to_tag);
+    }
+
+    /* Indicate support for overload control */
+    via = (pjsip_via_hdr*) pjsip_msg_find_hdr(tdata->msg, PJSIP_H_VIA, NULL);
+    oc = PJ_POOL_ZALLOC_T(tdata->pool, pjsip_param);
+    oc->name = STR_OC;
+    pj_list_push_back(&via->other_param, oc);
+
+    pj_bzero(&tp_sel, sizeof(tp_sel));
+    tp_sel.type = PJSIP_TPSELECTOR_TRANSPORT;
+    tp_sel.u.transport = loop;
+    pjsip_tx_data_set_transport(tdata, &tp_sel);
+
+    /* Keep the request to be retransmitted by the caller */
+    if (p_tdata) {
+        pjsip_tx_data_add_ref(tdata);
+        *p_tdata = tdata;
+    }
+
+    PJ_TEST_SUCCESS(pjsip_endpt_send_request_stateless(endpt, tdata,
+                                                       NULL, NULL),
+                    NULL, return -20);
+    return 0;
+}
+
+static void oc_wait(unsigned total, unsigned timeout_msec)
+{
+    pj_time_val timeout, now;
+
+    pj_gettimeofday(&timeout);
+    now = timeout;
+    timeout.msec += timeout_msec;
+    pj_time_val_normalize(&timeout);
+
+    while ((unsigned)(pj_atomic_get(oc_state.rx_req_cnt) +
+                      pj_atomic_get(oc_state.rx_503_cnt)) < total &&
+           PJ_TIME_VAL_LT(now, timeout))
+    {
+        flush_events(100);
+        pj_gettimeofday(&now);
+    }
+}
+
+/* Test that new INVITE and REGISTER requests are rejected with 503 when
+ * the endpoint is overloaded, while other requests and retransmissions of
+ * requests that already have a server transaction are let through.
+ */
+int transport_loop_overload_test(void)
+{
+#define ERR(rc__)   { rc=rc__; goto on_return; }
+    enum { FORCED_CNT = 5, QUEUE_CNT = 20, TIMEOUT = 5000 };
+    pjsip_transport *loop = NULL;
+    pjsip_overload_param oc_prm;
+    pjsip_overload_stat oc_stat;
+    pjsip_tx_data *retrans_tdata = NULL;
+    pj_pool_t *pool;
+    unsigned rx_503_cnt;
+    int i, rc;
+
+    pj_bzero(&oc_state, sizeof(oc_state));
+    pool = pjsip_endpt_create_pool(endpt, "oc", 512, 512);
+    PJ_TEST_SUCCESS(pj_atomic_create(pool, 0, &oc_state.rx_req_cnt),
+                    NULL, ERR(-5));
+    PJ_TEST_SUCCESS(pj_atomic_create(pool, 0, &oc_state.rx_503_cnt),
+                    NULL, ERR(-6));
+
+    PJ_TEST_SUCCESS(pjsip_endpt_register_module(endpt, &oc_tester_mod),
+                    NULL, ERR(-10));
+    PJ_TEST_SUCCESS(pjsip_loop_start(endpt, &loop), NULL, ERR(-20));
+    pjsip_transport_add_ref(loop);
+
+    pjsip_overload_param_default(&oc_prm);
+    PJ_TEST_SUCCESS(pjsip_endpt_set_overload_param(endpt, &oc_prm), NULL,
+                    ERR(-30));
+
+    /* INVITE accepted while not overloaded */
+    rc = oc_send_request(loop, &pjsip_invite_method, NULL, "oc-retrans", 1,
+                         &retrans_tdata);
+    if (rc != 0)
+        goto on_return;
+    oc_wait(1, TIMEOUT);
+    PJ_TEST_EQ(oc_state.err, 0, NULL, ERR(oc_state.err));
+    PJ_TEST_EQ(pj_atomic_get(oc_state.rx_req_cnt), 1, NULL, ERR(-32));
+    PJ_TEST_NOT_NULL(oc_state.tsx, NULL, ERR(-34));
+    pj_atomic_set(oc_state.rx_req_cnt, 0);
+
+    /* Overloaded by application's policy: all new requests are rejected,
+     * requests within dialog are not.
+     */
+    PJ_TEST_SUCCESS(pjsip_endpt_set_overloaded(endpt, 100), NULL, ERR(-40));
+    oc_state.expected_oc = 100;
+
+    /* Its retransmission is absorbed by the transaction, and is neither
+     * rejected nor passed to the module.
+     */
+    PJ_TEST_SUCCESS(pjsip_endpt_send_request_stateless(endpt, retrans_tdata,
+                                                       NULL, NULL),
+                    NULL, ERR(-42));
+    retrans_tdata = NULL;
+
+    for (i=0; i<FORCED_CNT; ++i) {
+        rc = oc_send_request(loop, (i & 1) ? &pjsip_invite_method :
+                                             &pjsip_register_method,
+                             NULL, "oc-forced", i+1, NULL);
+        if (rc != 0)
+            goto on_return;
+    }
+    rc = oc_send_request(loop, &pjsip_invite_method,
+                         "oc-dlg", "oc-dlg", 1, NULL);
+    if (rc != 0)
+        goto on_return;
+    rc = oc_send_request(loop, &pjsip_options_method,
+                         NULL, "oc-options", 1, NULL);
+    if (rc != 0)
+        goto on_return;
+
+    oc_wait(FORCED_CNT + 2, TIMEOUT);
+    PJ_TEST_EQ(oc_state.err, 0, NULL, ERR(oc_state.err));
+    PJ_TEST_EQ(pj_atomic_get(oc_state.rx_503_cnt), FORCED_CNT, NULL,
+               ERR(-50));
+    PJ_TEST_EQ(pj_atomic_get(oc_state.rx_req_cnt), 2, NULL, ERR(-60));
+
+    PJ_TEST_SUCCESS(pjsip_endpt_get_overload_stat(endpt, &oc_stat), NULL,
+                    ERR(-70));
+    PJ_TEST_EQ(oc_stat.shed_cnt, FORCED_CNT, NULL, ERR(-80));
+    PJ_TEST_EQ(oc_stat.reduction, 100, NULL, ERR(-90));
+
+    /* Overloaded by the receive worker queue, which is made slow */
+    PJ_TEST_SUCCESS(pjsip_endpt_set_overloaded(endpt, 0), NULL, ERR(-100));
+    oc_prm.max_queue_len = 2;
+    oc_prm.max_queue_delay = 0;
+    PJ_TEST_SUCCESS(pjsip_endpt_set_overload_param(endpt, &oc_prm), NULL,
+                    ERR(-110));
+    PJ_TEST_SUCCESS(pjsip_endpt_start_rx_workers(endpt, 1), NULL, ERR(-120));
+
+    pj_atomic_set(oc_state.rx_req_cnt, 0);
+    pj_atomic_set(oc_state.rx_503_cnt, 0);
+    oc_state.expected_oc = 0;
+    oc_state.proc_delay = 20;
+
+    for (i=0; i<QUEUE_CNT; ++i) {
+        rc = oc_send_request(loop, &pjsip_register_method,
+                             NULL, "oc-queue", i+1, NULL);
+        if (rc != 0)
+            goto on_return;
+    }
+
+    oc_wait(QUEUE_CNT, TIMEOUT);
+    PJ_TEST_EQ(oc_state.err, 0, NULL, ERR(oc_state.err));
+    rx_503_cnt = pj_atomic_get(oc_state.rx_503_cnt);
+    PJ_TEST_EQ(rx_503_cnt + pj_atomic_get(oc_state.rx_req_cnt), QUEUE_CNT,
+               NULL, ERR(-130));
+    PJ_TEST_GT(rx_503_cnt, 0, "no request is rejected", ERR(-140));
+    PJ_TEST_GTE(pj_atomic_get(oc_state.rx_req_cnt), 3, NULL, ERR(-150));
+
+    PJ_TEST_SUCCESS(pjsip_endpt_get_overload_stat(endpt, &oc_stat), NULL,
+                    ERR(-160));
+    PJ_TEST_EQ(oc_stat.shed_cnt, FORCED_CNT + rx_503_cnt, NULL, ERR(-170));
+
+    rc = 0;
+
+on_return:
+    if (retrans_tdata)
+        pjsip_tx_data_dec_ref(retrans_tdata);
+    if (oc_state.tsx)
+        pjsip_tsx_terminate(oc_state.tsx, PJSIP_SC_REQUEST_TERMINATED);
+    pjsip_endpt_stop_rx_workers(endpt);
+    pjsip_endpt_set_overload_param(endpt, NULL);
+    if (loop) {
+        pjsip_transport_shutdown(loop);
+        pjsip_transport_dec_ref(loop);
+    }
+    if (oc_tester_mod.id != -1) {
+        pjsip_endpt_unregister_module(endpt, &oc_tester_mod);
+    }
+    if (oc_state.rx_req_cnt)
+        pj_atomic_destroy(oc_state.rx_req_cnt);
+    if (oc_state.rx_503_cnt)
+        pj_atomic_destroy(oc_state.rx_503_cnt);
+    pj_pool_release(pool);
+    flush_events(500);
+    return rc;
+#undef ERR
+}
+
 static void send_cb(pjsip_send_state *st, pj_ssize_t sent, pj_bool_t *cont)
 {
     int *loop_resolve_status = (int*)st->token;
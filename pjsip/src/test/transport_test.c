@@ -890,3 +890,121 @@ on_return:
 }
 
 
+
+
+///////////////////////////////////////////////////////////////////////////////
+/*
+ * Transport manager table test: register many connection oriented
+ * transports (without sockets), and check that each of them can be
+ * acquired by its remote address.
+ */
+static pj_atomic_t *tpmgr_destroy_cnt;
+
+static pj_status_t tpmgr_test_tp_destroy(pjsip_transport *tp)
+{
+    PJ_UNUSED_ARG(tp);
+    pj_atomic_inc(tpmgr_destroy_cnt);
+    return PJ_SUCCESS;
+}
+
+int transport_tpmgr_test(void)
+{
+#define ERR(rc__)   { rc=rc__; goto on_return; }
+    enum { COUNT = 20000, ROUNDS = 5 };
+    pjsip_tpmgr *tpmgr = pjsip_endpt_get_tpmgr(endpt);
+    pj_pool_t *pool;
+    pj_lock_t *lock = NULL;
+    pjsip_transport *tps;
+    pj_timestamp t1, t2;
+    unsigned i, j, reg_cnt = 0, lookup_per_sec;
+    pj_uint32_t elapsed;
+    int rc;
+
+    pool = pjsip_endpt_create_pool(endpt, "tpmgrtest", 4000, 4000);
+    PJ_TEST_NOT_NULL(pool, NULL, return -5);
+    PJ_TEST_SUCCESS(pj_atomic_create(pool, 0, &tpmgr_destroy_cnt), NULL,
+                    ERR(-10));
+    PJ_TEST_SUCCESS(pj_lock_create_recursive_mutex(pool, "tpmgrtest", &lock),
+                    NULL, ERR(-15));
+
+    tps = (pjsip_transport*) pj_pool_calloc(pool, COUNT,
+                                            sizeof(pjsip_transport));
+    for (i=0; i<COUNT; ++i) {
+        pjsip_transport *tp = &tps[i];
+        pj_sockaddr_in *addr = &tp->key.rem_addr.ipv4;
+
+        pj_ansi_snprintf(tp->obj_name, sizeof(tp->obj_name), "tpmgr%d", i);
+        tp->pool = pool;
+        PJ_TEST_SUCCESS(pj_atomic_create(pool, 0, &tp->ref_cnt), NULL,
+                        ERR(-20));
+        tp->lock = lock;
+        tp->key.type = PJSIP_TRANSPORT_TCP;
+        addr->sin_family = pj_AF_INET();
+        addr->sin_addr.s_addr = pj_htonl(0x0A000000 | i);
+        addr->sin_port = pj_htons(5060);
+        tp->type_name = "TCP";
+        tp->info = "TCP";
+        tp->flag = pjsip_transport_get_flag_from_type(PJSIP_TRANSPORT_TCP);
+        tp->addr_len = sizeof(pj_sockaddr_in);
+        tp->dir = PJSIP_TP_DIR_INCOMING;
+        tp->endpt = endpt;
+        tp->destroy = &tpmgr_test_tp_destroy;
+
+        PJ_TEST_SUCCESS(pjsip_transport_register(tpmgr, tp), NULL, ERR(-30));
+        ++reg_cnt;
+    }
+
+    pj_get_timestamp(&t1);
+    for (j=0; j<ROUNDS; ++j) {
+        for (i=0; i<COUNT; ++i) {
+            pjsip_transport *tp;
+
+            PJ_TEST_SUCCESS(pjsip_tpmgr_acquire_transport(
+                                tpmgr, PJSIP_TRANSPORT_TCP,
+                                &tps[i].key.rem_addr, sizeof(pj_sockaddr_in),
+                                NULL, &tp),
+                            NULL, ERR(-40));
+            PJ_TEST_EQ(tp, &tps[i], "wrong transport is acquired", ERR(-50));
+
+            /* Idle timer is scheduled once and left running while
+             * the transport is in use.
+             */
+            if (j > 0) {
+                PJ_TEST_NEQ(tp->idle_timer.id, 0, NULL, ERR(-60));
+            }
+            pjsip_transport_dec_ref(tp);
+        }
+    }
+    pj_get_timestamp(&t2);
+
+    elapsed = pj_elapsed_usec(&t1, &t2);
+    if (elapsed == 0)
+        elapsed = 1;
+    lookup_per_sec = (unsigned)((pj_uint64_t)COUNT * ROUNDS * 1000000 /
+                                elapsed);
+    PJ_LOG(3,(THIS_FILE, "    %d transports: %u acquire/release per sec",
+              COUNT, lookup_per_sec));
+    report_ival("tpmgr-acquire-per-sec", lookup_per_sec, "acquire/sec",
+                "Number of transport acquire and release per second, "
+                "with 20000 connection oriented transports registered");
+
+    rc = 0;
+
+on_return:
+    for (i=0; i<reg_cnt; ++i)
+        pjsip_transport_destroy(&tps[i]);
+    if (rc == 0) {
+        PJ_TEST_EQ(pj_atomic_get(tpmgr_destroy_cnt), COUNT, NULL, rc=-70);
+    }
+    for (i=0; i<reg_cnt; ++i)
+        pj_atomic_destroy(tps[i].ref_cnt);
+    if (tpmgr_destroy_cnt) {
+        pj_atomic_destroy(tpmgr_destroy_cnt);
+        tpmgr_destroy_cnt = NULL;
+    }
+    if (lock)
+        pj_lock_destroy(lock);
+    pj_pool_release(pool);
+    return rc;
+#undef ERR
+}
@@ -118,6 +118,70 @@ on_return:
 #undef ERR
 }
 
+/*
+ * Test UDP transport backed by several sockets bound with SO_REUSEPORT.
+ */
+static int sharded_transport_test(pj_bool_t sock_worker_thread)
+{
+#define ERR(rc__)   { rc=rc__; goto on_return; }
+    pjsip_udp_transport_cfg cfg;
+    pjsip_transport *udp_tp = NULL;
+    pj_sockaddr local_addr;
+    int rc, rtt;
+    pj_status_t status;
+
+    PJ_LOG(3,(THIS_FILE, "   sharded UDP transport test (worker thread=%d)",
+              sock_worker_thread));
+
+    pjsip_udp_transport_cfg_default(&cfg, pj_AF_INET());
+    pj_sockaddr_in_init(&cfg.bind_addr.ipv4, NULL, TEST_UDP_PORT);
+    cfg.sock_cnt = 4;
+    cfg.sock_worker_thread = sock_worker_thread;
+
+    status = pjsip_udp_transport_start2(endpt, &cfg, &udp_tp);
+    if (status == PJ_ENOTSUP) {
+        PJ_LOG(3,(THIS_FILE, "   SO_REUSEPORT is not supported, skipped"));
+        return 0;
+    }
+    PJ_TEST_SUCCESS(status, NULL, return -200);
+    PJ_TEST_EQ(pj_atomic_get(udp_tp->ref_cnt), 1, NULL, ERR(-210));
+
+    rc = generic_transport_test(udp_tp);
+    if (rc != 0)
+        goto on_return;
+
+    rc = transport_send_recv_test(PJSIP_TRANSPORT_UDP, udp_tp,
+                                  "127.0.0.1:"TEST_UDP_PORT_STR, &rtt);
+    if (rc != 0)
+        goto on_return;
+
+    /* Recreate all sockets and test again */
+    pj_sockaddr_cp(&local_addr, &udp_tp->local_addr);
+    PJ_TEST_SUCCESS(pjsip_udp_transport_pause(udp_tp,
+                                        PJSIP_UDP_TRANSPORT_DESTROY_SOCKET),
+                    NULL, ERR(-220));
+    PJ_TEST_SUCCESS(pjsip_udp_transport_restart2(udp_tp,
+                                        PJSIP_UDP_TRANSPORT_DESTROY_SOCKET,
+                                        PJ_INVALID_SOCKET, &local_addr,
+                                        NULL),
+                    NULL, ERR(-230));
+
+    rc = transport_send_recv_test(PJSIP_TRANSPORT_UDP, udp_tp,
+                                  "127.0.0.1:"TEST_UDP_PORT_STR, &rtt);
+    if (rc != 0)
+        goto on_return;
+
+    PJ_TEST_EQ(pj_atomic_get(udp_tp->ref_cnt), 1, NULL, ERR(-240));
+    rc = 0;
+
+on_return:
+    pjsip_transport_dec_ref(udp_tp);
+    PJ_TEST_SUCCESS(pjsip_transport_destroy(udp_tp), NULL,
+                    { if (rc==0) rc=-250; });
+    return rc;
+#undef ERR
+}
+
 /*
  * UDP transport test.
  */
@@ -184,6 +248,17 @@ int transport_udp_test(void)
     PJ_LOG(3,(THIS_FILE, "   Flushing events, 1 second..."));
     flush_events(1000);
 
+    /* Sharded transport, polled by endpoint and by own worker threads */
+    status = sharded_transport_test(PJ_FALSE);
+    if (status != 0)
+        return status;
+
+    status = sharded_transport_test(PJ_TRUE);
+    if (status != 0)
+        return status;
+
+    flush_events(500);
+
     /* Done */
     return 0;
 }
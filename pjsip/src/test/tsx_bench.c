@@ -91,17 +91,12 @@ on_error:
 
 
 
-static int uas_tsx_bench(unsigned working_set, pj_timestamp *p_elapsed)
+/* Create incoming request and "dummy" rdata for UAS transactions */
+static int create_uas_rdata(pjsip_tx_data **p_request, pjsip_rx_data *rdata,
+                            pjsip_via_hdr **p_via)
 {
-    unsigned i;
-    pjsip_transport *loop = NULL;
-    pjsip_tx_data *request = NULL;
+    pjsip_tx_data *request;
     pjsip_via_hdr *via;
-    pjsip_rx_data rdata;
-    pjsip_transaction **tsx;
-    pj_timestamp t1, t2, elapsed;
-    char branch_buf[80] = PJSIP_RFC3261_BRANCH_ID "0000000000";
-    int rc;
 
     /* Create the request first. */
     pj_str_t str_target = pj_str("sip:someuser@someprovider.com");
@@ -126,15 +121,37 @@ static int uas_tsx_bench(unsigned working_set, pj_timestamp *p_elapsed)
     
 
     /* Create "dummy" rdata from the tdata */
-    pj_bzero(&rdata, sizeof(pjsip_rx_data));
-    rdata.tp_info.pool = request->pool;
-    rdata.msg_info.msg = request->msg;
-    rdata.msg_info.from = (pjsip_from_hdr*) pjsip_msg_find_hdr(request->msg, PJSIP_H_FROM, NULL);
-    rdata.msg_info.to = (pjsip_to_hdr*) pjsip_msg_find_hdr(request->msg, PJSIP_H_TO, NULL);
-    rdata.msg_info.cseq = (pjsip_cseq_hdr*) pjsip_msg_find_hdr(request->msg, PJSIP_H_CSEQ, NULL);
-    rdata.msg_info.cid = (pjsip_cid_hdr*) pjsip_msg_find_hdr(request->msg, PJSIP_H_CALL_ID, NULL);
-    rdata.msg_info.via = via;
-    
+    pj_bzero(rdata, sizeof(pjsip_rx_data));
+    rdata->tp_info.pool = request->pool;
+    rdata->msg_info.msg = request->msg;
+    rdata->msg_info.from = (pjsip_from_hdr*) pjsip_msg_find_hdr(request->msg, PJSIP_H_FROM, NULL);
+    rdata->msg_info.to = (pjsip_to_hdr*) pjsip_msg_find_hdr(request->msg, PJSIP_H_TO, NULL);
+    rdata->msg_info.cseq = (pjsip_cseq_hdr*) pjsip_msg_find_hdr(request->msg, PJSIP_H_CSEQ, NULL);
+    rdata->msg_info.cid = (pjsip_cid_hdr*) pjsip_msg_find_hdr(request->msg, PJSIP_H_CALL_ID, NULL);
+    rdata->msg_info.via = via;
+
+    *p_request = request;
+    *p_via = via;
+    return 0;
+}
+
+
+static int uas_tsx_bench(unsigned working_set, pj_timestamp *p_elapsed)
+{
+    unsigned i;
+    pjsip_transport *loop = NULL;
+    pjsip_tx_data *request = NULL;
+    pjsip_via_hdr *via;
+    pjsip_rx_data rdata;
+    pjsip_transaction **tsx;
+    pj_timestamp t1, t2, elapsed;
+    char branch_buf[80] = PJSIP_RFC3261_BRANCH_ID "0000000000";
+    int rc;
+
+    rc = create_uas_rdata(&request, &rdata, &via);
+    if (rc != 0)
+        return rc;
+
     PJ_TEST_SUCCESS(pjsip_loop_start(endpt, &loop), NULL,
                     { pjsip_tx_data_dec_ref(request); return -220; });
     pjsip_transport_add_ref(loop);
@@ -191,6 +208,129 @@ on_error:
 
 
 
+/*
+ * Multithreaded lookup benchmark. Several threads look up transactions in
+ * the transaction layer concurrently, as worker threads do for incoming
+ * messages, to measure the contention on the transaction table locks
+ * (see pjsip_cfg()->tsx.lock_stripe_cnt).
+ */
+static struct mt_bench_t
+{
+    pj_str_t           *keys;
+    unsigned            key_cnt;
+    unsigned            lookup_cnt;
+    pj_bool_t           failed;
+} mt_bench;
+
+static int mt_lookup_thread(void *arg)
+{
+    unsigned i, idx = (unsigned)(pj_ssize_t)arg * 7919;
+
+    for (i=0; i<mt_bench.lookup_cnt; ++i) {
+        idx = (idx + 1) % mt_bench.key_cnt;
+        if (!pjsip_tsx_layer_find_tsx2(&mt_bench.keys[idx], PJ_FALSE))
+            mt_bench.failed = PJ_TRUE;
+    }
+    return 0;
+}
+
+static int mt_lookup_bench(unsigned working_set, unsigned lookup_cnt,
+                           const unsigned thread_cnts[], unsigned cnt,
+                           unsigned speeds[])
+{
+    enum { MAX_THREADS = 16 };
+    unsigned i, t;
+    pjsip_transport *loop = NULL;
+    pjsip_tx_data *request = NULL;
+    pjsip_via_hdr *via;
+    pjsip_rx_data rdata;
+    pjsip_transaction **tsx;
+    pj_thread_t *threads[MAX_THREADS];
+    char branch_buf[80] = PJSIP_RFC3261_BRANCH_ID "0000000000";
+    int rc;
+
+    rc = create_uas_rdata(&request, &rdata, &via);
+    if (rc != 0)
+        return rc;
+
+    PJ_TEST_SUCCESS(pjsip_loop_start(endpt, &loop), NULL,
+                    { pjsip_tx_data_dec_ref(request); return -320; });
+    pjsip_transport_add_ref(loop);
+    rdata.tp_info.transport = loop;
+
+    tsx = (pjsip_transaction**) pj_pool_zalloc(request->pool, working_set * sizeof(pjsip_transaction*));
+    pj_bzero(&mt_bench, sizeof(mt_bench));
+    mt_bench.keys = (pj_str_t*) pj_pool_zalloc(request->pool, working_set * sizeof(pj_str_t));
+    mt_bench.key_cnt = working_set;
+    mt_bench.lookup_cnt = lookup_cnt;
+
+    pj_bzero(&mod_tsx_user, sizeof(mod_tsx_user));
+    mod_tsx_user.id = -1;
+
+    /* Create the transactions to be looked up */
+    for (i=0; i<working_set; ++i) {
+        via->branch_param.ptr = branch_buf;
+        via->branch_param.slen = PJSIP_RFC3261_BRANCH_LEN + 
+                                    pj_ansi_snprintf(branch_buf+PJSIP_RFC3261_BRANCH_LEN,
+                                                     sizeof(branch_buf)-PJSIP_RFC3261_BRANCH_LEN,
+                                                    "-mt%d", i);
+        PJ_TEST_SUCCESS(pjsip_tsx_create_uas(&mod_tsx_user, &rdata, &tsx[i]),
+                        NULL, { rc=-330; goto on_error; });
+        mt_bench.keys[i] = tsx[i]->transaction_key;
+    }
+
+    for (t=0; t<cnt; ++t) {
+        pj_timestamp t1, t2;
+        pj_uint32_t msec;
+
+        pj_assert(thread_cnts[t] <= MAX_THREADS);
+
+        pj_get_timestamp(&t1);
+        for (i=0; i<thread_cnts[t]; ++i) {
+            PJ_TEST_SUCCESS(pj_thread_create(request->pool, "tsxbench",
+                                             &mt_lookup_thread,
+                                             (void*)(pj_ssize_t)i, 0, 0,
+                                             &threads[i]),
+                            NULL, { rc=-340; goto on_error; });
+        }
+        for (i=0; i<thread_cnts[t]; ++i) {
+            pj_thread_join(threads[i]);
+            pj_thread_destroy(threads[i]);
+        }
+        pj_get_timestamp(&t2);
+
+        PJ_TEST_EQ(mt_bench.failed, PJ_FALSE, "transaction not found",
+                   { rc=-350; goto on_error; });
+
+        msec = pj_elapsed_msec(&t1, &t2);
+        speeds[t] = (unsigned)((pj_uint64_t)lookup_cnt * thread_cnts[t] *
+                               1000 / (msec ? msec : 1));
+    }
+    rc = 0;
+
+on_error:
+    for (i=0; i<working_set; ++i) {
+        if (tsx[i]) {
+            pj_timer_heap_t *th;
+
+            pjsip_tsx_terminate(tsx[i], 601);
+            tsx[i] = NULL;
+
+            th = pjsip_endpt_get_timer_heap(endpt);
+            pj_timer_heap_poll(th, NULL);
+        }
+    }
+    pjsip_tx_data_dec_ref(request);
+    if (loop) {
+        /* Order must be shutdown then dec_ref so it gets destroyed */
+        pjsip_transport_shutdown(loop);
+        pjsip_transport_dec_ref(loop);
+    }
+    flush_events(2000);
+    return rc;
+}
+
+
 int tsx_bench(void)
 {
     enum { WORKING_SET=10000, REPEAT = 4 };
@@ -286,6 +426,41 @@ int tsx_bench(void)
     report_ival("create-uas-tsx-per-sec", 
                 speed, "tsx/sec", desc);
 
+
+    /*
+     * Benchmark multithreaded transaction lookup
+     */
+    {
+        const unsigned thread_cnts[] = { 1, 2, 4, 8 };
+        unsigned speeds[PJ_ARRAY_SIZE(thread_cnts)];
+
+        PJ_LOG(3,(THIS_FILE, "   benchmarking multithreaded transaction "
+                  "lookup (%d lock stripes):",
+                  pjsip_cfg()->tsx.lock_stripe_cnt));
+
+        status = mt_lookup_bench(1000, 200000, thread_cnts,
+                                 PJ_ARRAY_SIZE(thread_cnts), speeds);
+        if (status != PJ_SUCCESS)
+            return status;
+
+        for (i=0; i<PJ_ARRAY_SIZE(thread_cnts); ++i) {
+            PJ_LOG(3,(THIS_FILE, "    %d thread(s): %d lookups/sec",
+                      thread_cnts[i], speeds[i]));
+        }
+
+        pj_ansi_snprintf(desc, sizeof(desc),
+                         "Number of transaction lookups per second with "
+                         "<tt>pjsip_tsx_layer_find_tsx2()</tt> from %d "
+                         "threads concurrently, with %d transaction table "
+                         "lock stripes.",
+                         thread_cnts[PJ_ARRAY_SIZE(thread_cnts)-1],
+                         pjsip_cfg()->tsx.lock_stripe_cnt);
+
+        report_ival("tsx-lookup-mt-per-sec",
+                    speeds[PJ_ARRAY_SIZE(thread_cnts)-1], "lookup/sec",
+                    desc);
+    }
+
     return PJ_SUCCESS;
 }
 
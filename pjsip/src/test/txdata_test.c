@@ -162,6 +162,7 @@ static int core_txdata_test(void)
      * We should never do this in real application, as there are many
      * many more fields need to be initialized!!
      */
+    pj_bzero(&dummy_rdata, sizeof(dummy_rdata));
     dummy_rdata.msg_info.cid = HFIND(invite->msg, cid, CALL_ID);
     dummy_rdata.msg_info.clen = NULL;
     dummy_rdata.msg_info.cseq = HFIND(invite->msg, cseq, CSEQ);
@@ -679,6 +680,447 @@ on_error:
 
 
 
+/*
+ * Create request with several Via and Record-Route headers, and "dummy"
+ * rdata from it.
+ */
+static pj_status_t create_dummy_rdata(pj_pool_t *pool,
+                                      pjsip_rx_data *rdata,
+                                      pjsip_tx_data **p_request)
+{
+    pj_str_t str_target = pj_str("sip:someuser@someprovider.com");
+    pj_str_t str_from = pj_str("\"Local User\" <sip:txdata_test@serviceprovider.com>");
+    pj_str_t str_to = pj_str("\"Remote User\" <sip:remoteuser@serviceprovider.com>");
+    pj_str_t str_contact = str_from;
+    pj_str_t str_rr_name = pj_str("Record-Route");
+    pj_str_t str_rr_value = pj_str("<sip:proxy.serviceprovider.com;lr>");
+    pj_str_t str_rr;
+    pjsip_tx_data *request;
+    pjsip_via_hdr *via;
+    pjsip_rr_hdr *rr;
+    pj_status_t status;
+    unsigned i;
+
+    status = pjsip_endpt_create_request(endpt, &pjsip_invite_method,
+                                        &str_target, &str_from, &str_to,
+                                        &str_contact, NULL, -1, NULL,
+                                        &request);
+    if (status != PJ_SUCCESS)
+        return status;
+
+    via = pjsip_via_hdr_create(request->pool);
+    via->sent_by.host = pj_str("192.168.0.7");
+    via->sent_by.port = 5061;
+    via->transport = pj_str("udp");
+    via->rport_param = 0;
+    via->branch_param = pj_str("z9hG4bK012345678901234567890123456789");
+    via->recvd_param = pj_str("192.168.0.7");
+    for (i=0; i<2; ++i) {
+        pjsip_msg_insert_first_hdr(request->msg, (pjsip_hdr*)
+                                   pjsip_hdr_clone(request->pool, via));
+    }
+    pjsip_msg_insert_first_hdr(request->msg, (pjsip_hdr*)via);
+
+    /* Parser needs writable, NULL terminated input */
+    pj_strdup_with_null(request->pool, &str_rr, &str_rr_value);
+    rr = (pjsip_rr_hdr*) pjsip_parse_hdr(request->pool, &str_rr_name,
+                                         str_rr.ptr, str_rr.slen, NULL);
+    if (!rr) {
+        pjsip_tx_data_dec_ref(request);
+        return PJSIP_EINVALIDHDR;
+    }
+    pjsip_msg_add_hdr(request->msg, (pjsip_hdr*)rr);
+    pjsip_msg_add_hdr(request->msg, (pjsip_hdr*)
+                      pjsip_hdr_clone(request->pool, rr));
+
+    pj_bzero(rdata, sizeof(pjsip_rx_data));
+    rdata->tp_info.pool = pool;
+    rdata->msg_info.msg = request->msg;
+    rdata->msg_info.from = HFIND(request->msg, from, FROM);
+    rdata->msg_info.to = HFIND(request->msg, to, TO);
+    rdata->msg_info.cseq = HFIND(request->msg, cseq, CSEQ);
+    rdata->msg_info.cid = HFIND(request->msg, cid, CALL_ID);
+    rdata->msg_info.via = via;
+
+    *p_request = request;
+    return PJ_SUCCESS;
+}
+
+/* Print tdata, return the length or negative on error. */
+static int print_tdata(pjsip_tx_data *tdata, char *buf, unsigned size)
+{
+    pj_ssize_t len;
+
+    pjsip_tx_data_invalidate_msg(tdata);
+    if (pjsip_tx_data_encode(tdata) != PJ_SUCCESS)
+        return -1;
+
+    len = tdata->buf.cur - tdata->buf.start;
+    if (len >= (pj_ssize_t)size)
+        return -1;
+
+    pj_memcpy(buf, tdata->buf.start, len);
+    buf[len] = '\0';
+    return (int)len;
+}
+
+/*
+ * Test pre-encoded headers.
+ */
+static int encoded_hdr_test(void)
+{
+    enum { BUF_SIZE = 2000 };
+    pj_bool_t saved_encode_rsp_hdr = pjsip_cfg()->endpt.encode_rsp_hdr;
+    const int st_codes[] = { 100, 180, 200 };
+    pjsip_tx_data *request = NULL, *rsp = NULL, *enc_rsp = NULL;
+    pjsip_via_hdr *via, *enc_via, *via2;
+    pjsip_rx_data rdata;
+    pj_pool_t *pool;
+    char *buf1, *buf2;
+    int len1, len2;
+    unsigned i;
+    int rc = 0;
+
+    PJ_LOG(3,(THIS_FILE, "   pre-encoded header test"));
+
+    pool = pjsip_endpt_create_pool(endpt, "enc", 4000, 4000);
+    buf1 = (char*) pj_pool_alloc(pool, BUF_SIZE);
+    buf2 = (char*) pj_pool_alloc(pool, BUF_SIZE);
+
+    /* Basic properties */
+    via = pjsip_via_hdr_create(pool);
+    via->sent_by.host = pj_str("example.com");
+    via->transport = pj_str("UDP");
+    via->branch_param = pj_str("z9hG4bKabcd");
+
+    len1 = pjsip_hdr_print_on(via, buf1, BUF_SIZE);
+    enc_via = (pjsip_via_hdr*) pjsip_hdr_encode(pool, via);
+    if (!enc_via || !pjsip_hdr_is_encoded(enc_via) ||
+        pjsip_hdr_is_encoded(via) || enc_via->type != PJSIP_H_VIA ||
+        pj_strcmp(&enc_via->branch_param, &via->branch_param))
+    {
+        rc = -700; goto on_return;
+    }
+
+    /* Modifying pre-encoded header doesn't change the printed text */
+    enc_via->branch_param = pj_str("z9hG4bKxyz");
+    len2 = pjsip_hdr_print_on(enc_via, buf2, BUF_SIZE);
+    if (len1 <= 0 || len1 != len2 || pj_memcmp(buf1, buf2, len1)) {
+        rc = -710; goto on_return;
+    }
+
+    /* Buffer too small */
+    if (pjsip_hdr_print_on(enc_via, buf2, len1-1) != -1) {
+        rc = -715; goto on_return;
+    }
+
+    /* Shallow clone is pre-encoded, full clone is not. */
+    via2 = (pjsip_via_hdr*) pjsip_hdr_shallow_clone(pool, enc_via);
+    if (!pjsip_hdr_is_encoded(via2)) {
+        rc = -720; goto on_return;
+    }
+    via2 = (pjsip_via_hdr*) pjsip_hdr_clone(pool, enc_via);
+    if (pjsip_hdr_is_encoded(via2)) {
+        rc = -730; goto on_return;
+    }
+    len2 = pjsip_hdr_print_on(via2, buf2, BUF_SIZE);
+    if (len2 <= 0 || pj_memcmp(buf2+len2-3, "xyz", 3)) {
+        rc = -740; goto on_return;
+    }
+
+    /* Encoding an encoded header copies the text. */
+    via2 = (pjsip_via_hdr*) pjsip_hdr_encode(pool, enc_via);
+    len2 = pjsip_hdr_print_on(via2, buf2, BUF_SIZE);
+    if (!pjsip_hdr_is_encoded(via2) || len1 != len2 ||
+        pj_memcmp(buf1, buf2, len1))
+    {
+        rc = -750; goto on_return;
+    }
+
+    /* Responses created with and without pre-encoded headers must be
+     * printed the same.
+     */
+    if (create_dummy_rdata(pool, &rdata, &request) != PJ_SUCCESS) {
+        rc = -760; goto on_return;
+    }
+
+    for (i=0; i<PJ_ARRAY_SIZE(st_codes); ++i) {
+        pjsip_cfg()->endpt.encode_rsp_hdr = PJ_FALSE;
+        if (pjsip_endpt_create_response(endpt, &rdata, st_codes[i], NULL,
+                                        &rsp) != PJ_SUCCESS)
+        {
+            rc = -770; goto on_return;
+        }
+
+        pjsip_cfg()->endpt.encode_rsp_hdr = PJ_TRUE;
+        if (pjsip_endpt_create_response(endpt, &rdata, st_codes[i], NULL,
+                                        &enc_rsp) != PJ_SUCCESS)
+        {
+            rc = -780; goto on_return;
+        }
+
+        if (!rdata.msg_info.rsp_hdr ||
+            !pjsip_hdr_is_encoded(HFIND(enc_rsp->msg, via, VIA)) ||
+            !pjsip_hdr_is_encoded(HFIND(enc_rsp->msg, cseq, CSEQ)) ||
+            pjsip_hdr_is_encoded(HFIND(enc_rsp->msg, to, TO)))
+        {
+            rc = -790; goto on_return;
+        }
+
+        /* The response must still be usable after the request is gone */
+        if (i == PJ_ARRAY_SIZE(st_codes)-1)
+            pjsip_rx_data_release_rsp_hdr(&rdata);
+
+        len1 = print_tdata(rsp, buf1, BUF_SIZE);
+        len2 = print_tdata(enc_rsp, buf2, BUF_SIZE);
+        if (len1 <= 0 || len1 != len2 || pj_memcmp(buf1, buf2, len1)) {
+            PJ_LOG(3,(THIS_FILE, "    error: response mismatch:\n%s\n"
+                      "pre-encoded:\n%s", buf1, buf2));
+            rc = -800; goto on_return;
+        }
+
+        pjsip_tx_data_dec_ref(rsp);
+        pjsip_tx_data_dec_ref(enc_rsp);
+        rsp = enc_rsp = NULL;
+    }
+
+on_return:
+    pjsip_cfg()->endpt.encode_rsp_hdr = saved_encode_rsp_hdr;
+    if (request)
+        pjsip_rx_data_release_rsp_hdr(&rdata);
+    if (rsp)
+        pjsip_tx_data_dec_ref(rsp);
+    if (enc_rsp)
+        pjsip_tx_data_dec_ref(enc_rsp);
+    if (request)
+        pjsip_tx_data_dec_ref(request);
+    pj_pool_release(pool);
+    return rc;
+}
+
+/*
+ * Benchmark creating and printing three responses to the same request.
+ */
+static int encode_response_bench(pj_bool_t encode_rsp_hdr,
+                                 pj_timestamp *p_elapsed)
+{
+    pj_bool_t saved_encode_rsp_hdr = pjsip_cfg()->endpt.encode_rsp_hdr;
+    const int st_codes[] = { 100, 180, 200 };
+    pjsip_tx_data *request, *tdata;
+    pjsip_rx_data rdata;
+    pj_timestamp t1, t2;
+    pj_pool_t *pool;
+    unsigned i, j;
+    int rc = 0;
+
+    pool = pjsip_endpt_create_pool(endpt, "encbench", 4000, 4000);
+    if (create_dummy_rdata(pool, &rdata, &request) != PJ_SUCCESS) {
+        pj_pool_release(pool);
+        return -900;
+    }
+
+    pjsip_cfg()->endpt.encode_rsp_hdr = encode_rsp_hdr;
+    p_elapsed->u64 = 0;
+
+    for (i=0; i<LOOP; i+=PJ_ARRAY_SIZE(st_codes)) {
+        pj_get_timestamp(&t1);
+        for (j=0; j<PJ_ARRAY_SIZE(st_codes); ++j) {
+            if (pjsip_endpt_create_response(endpt, &rdata, st_codes[j],
+                                            NULL, &tdata) != PJ_SUCCESS)
+            {
+                rc = -910;
+                break;
+            }
+            if (pjsip_tx_data_encode(tdata) != PJ_SUCCESS)
+                rc = -920;
+            pjsip_tx_data_dec_ref(tdata);
+            if (rc)
+                break;
+        }
+        /* Done with the request */
+        pjsip_rx_data_release_rsp_hdr(&rdata);
+
+        pj_get_timestamp(&t2);
+        pj_sub_timestamp(&t2, &t1);
+        pj_add_timestamp(p_elapsed, &t2);
+
+        if (rc)
+            break;
+    }
+
+    pjsip_cfg()->endpt.encode_rsp_hdr = saved_encode_rsp_hdr;
+    pjsip_tx_data_dec_ref(request);
+    pj_pool_release(pool);
+    return rc;
+}
+
+/* Create the extra headers of a 401 response for stateless response tests */
+static void create_challenge_hdr(pj_pool_t *pool, pjsip_hdr *hdr_list)
+{
+    pjsip_www_authenticate_hdr *auth;
+
+    auth = pjsip_www_authenticate_hdr_create(pool);
+    auth->scheme = pj_str("Digest");
+    auth->challenge.digest.realm = pj_str("serviceprovider.com");
+    auth->challenge.digest.nonce = pj_str("5f1e0a9c3b7d2e4a6c8b0d1f3a5c7e9b");
+    auth->challenge.digest.algorithm = pj_str("MD5");
+    auth->challenge.digest.qop = pj_str("auth");
+
+    pj_list_init(hdr_list);
+    pj_list_push_back(hdr_list, auth);
+}
+
+/*
+ * Test printing stateless responses directly from the request.
+ */
+static int stateless_rsp_test(void)
+{
+    enum { BUF_SIZE = 2000 };
+    pj_bool_t saved_compact_form = pjsip_cfg()->endpt.use_compact_form;
+    const int st_codes[] = { 100, 401, 403, 503 };
+    pjsip_tx_data *request = NULL, *rsp = NULL;
+    pjsip_hdr hdr_list, *hdr;
+    pjsip_rx_data rdata;
+    pj_pool_t *pool;
+    char *buf1, *buf2;
+    int len1;
+    pj_ssize_t len2;
+    unsigned i, compact, size;
+    int rc = 0;
+
+    PJ_LOG(3,(THIS_FILE, "   stateless response printing test"));
+
+    pool = pjsip_endpt_create_pool(endpt, "rawrsp", 4000, 4000);
+    buf1 = (char*) pj_pool_alloc(pool, BUF_SIZE);
+    buf2 = (char*) pj_pool_alloc(pool, BUF_SIZE);
+
+    if (create_dummy_rdata(pool, &rdata, &request) != PJ_SUCCESS) {
+        rc = -1000; goto on_return;
+    }
+
+    for (compact=0; compact<2; ++compact) {
+        pjsip_cfg()->endpt.use_compact_form = compact;
+
+        for (i=0; i<PJ_ARRAY_SIZE(st_codes); ++i) {
+            /* 401 with challenge, 503 with Retry-After, and the challenge
+             * pre-encoded for 403 (it's just a header).
+             */
+            pj_list_init(&hdr_list);
+            if (st_codes[i] == 401) {
+                create_challenge_hdr(pool, &hdr_list);
+            } else if (st_codes[i] == 403) {
+                create_challenge_hdr(pool, &hdr_list);
+                hdr = (pjsip_hdr*) pjsip_hdr_encode(pool, hdr_list.next);
+                pj_list_init(&hdr_list);
+                pj_list_push_back(&hdr_list, hdr);
+            } else if (st_codes[i] == 503) {
+                pj_list_push_back(&hdr_list,
+                                  pjsip_retry_after_hdr_create(pool, 30));
+            }
+
+            if (pjsip_endpt_create_response(endpt, &rdata, st_codes[i],
+                                            NULL, &rsp) != PJ_SUCCESS)
+            {
+                rc = -1010; goto on_return;
+            }
+            for (hdr=hdr_list.next; hdr!=&hdr_list; hdr=hdr->next) {
+                pjsip_msg_add_hdr(rsp->msg, (pjsip_hdr*)
+                                  pjsip_hdr_clone(rsp->pool, hdr));
+            }
+
+            len1 = print_tdata(rsp, buf1, BUF_SIZE);
+            len2 = pjsip_print_stateless_response(&rdata, st_codes[i], NULL,
+                                                  &hdr_list, buf2, BUF_SIZE);
+            if (len1 <= 0 || len1 != len2 || pj_memcmp(buf1, buf2, len1)) {
+                PJ_LOG(3,(THIS_FILE, "    error: response mismatch:\n%s\n"
+                          "stateless:\n%s", buf1, buf2));
+                rc = -1020; goto on_return;
+            }
+
+            /* Buffer too small must be detected */
+            for (size=0; size<=(unsigned)len1; ++size) {
+                if (pjsip_print_stateless_response(&rdata, st_codes[i], NULL,
+                                                   &hdr_list, buf2,
+                                                   size) != -1)
+                {
+                    PJ_LOG(3,(THIS_FILE, "    error: buffer size %u not "
+                              "detected as too small", size));
+                    rc = -1030; goto on_return;
+                }
+            }
+
+            pjsip_tx_data_dec_ref(rsp);
+            rsp = NULL;
+        }
+    }
+
+on_return:
+    pjsip_cfg()->endpt.use_compact_form = saved_compact_form;
+    if (rsp)
+        pjsip_tx_data_dec_ref(rsp);
+    if (request)
+        pjsip_tx_data_dec_ref(request);
+    pj_pool_release(pool);
+    return rc;
+}
+
+/*
+ * Benchmark 401 responses, created and printed with the normal API or
+ * printed directly with pjsip_print_stateless_response().
+ */
+static int stateless_rsp_bench(pj_bool_t raw, pj_timestamp *p_elapsed)
+{
+    pjsip_tx_data *request, *tdata;
+    pjsip_hdr hdr_list, *hdr;
+    pjsip_rx_data rdata;
+    pj_timestamp t1, t2;
+    pj_pool_t *pool;
+    char *buf;
+    unsigned i;
+    int rc = 0;
+
+    pool = pjsip_endpt_create_pool(endpt, "rawbench", 4000, 4000);
+    if (create_dummy_rdata(pool, &rdata, &request) != PJ_SUCCESS) {
+        pj_pool_release(pool);
+        return -1100;
+    }
+    create_challenge_hdr(pool, &hdr_list);
+    buf = (char*) pj_pool_alloc(pool, PJSIP_MAX_PKT_LEN);
+
+    pj_get_timestamp(&t1);
+    for (i=0; i<LOOP && rc==0; ++i) {
+        if (raw) {
+            if (pjsip_print_stateless_response(&rdata, 401, NULL, &hdr_list,
+                                               buf, PJSIP_MAX_PKT_LEN) < 0)
+            {
+                rc = -1110;
+            }
+            continue;
+        }
+
+        if (pjsip_endpt_create_response(endpt, &rdata, 401, NULL,
+                                        &tdata) != PJ_SUCCESS)
+        {
+            rc = -1120;
+            break;
+        }
+        for (hdr=hdr_list.next; hdr!=&hdr_list; hdr=hdr->next) {
+            pjsip_msg_add_hdr(tdata->msg, (pjsip_hdr*)
+                              pjsip_hdr_clone(tdata->pool, hdr));
+        }
+        if (pjsip_tx_data_encode(tdata) != PJ_SUCCESS)
+            rc = -1130;
+        pjsip_tx_data_dec_ref(tdata);
+    }
+    pj_get_timestamp(&t2);
+    pj_sub_timestamp(&t2, &t1);
+    p_elapsed->u64 = t2.u64;
+
+    pjsip_tx_data_dec_ref(request);
+    pj_pool_release(pool);
+    return rc;
+}
+
 /*
  * create response benchmark
  */
@@ -773,7 +1215,7 @@ on_error:
 int txdata_test(void)
 {
     enum { REPEAT = 4 };
-    unsigned i, msgs;
+    unsigned i, j, msgs;
     pj_timestamp usec[REPEAT], min, freq;
     int status;
 
@@ -795,6 +1237,14 @@ int txdata_test(void)
     if (status != 0)
         return status;
 
+    status = encoded_hdr_test();
+    if (status != 0)
+        return status;
+
+    status = stateless_rsp_test();
+    if (status != 0)
+        return status;
+
 
     /*
      * Benchmark create_request()
@@ -850,6 +1300,66 @@ int txdata_test(void)
                 "per second with <tt>pjsip_endpt_create_response()</tt>");
 
 
+    /*
+     * Benchmark creating and printing three responses per request, with
+     * and without pre-encoded headers.
+     */
+    for (j=0; j<2; ++j) {
+        PJ_LOG(3,(THIS_FILE, "   benchmarking response encoding (%s):",
+                  (j ? "pre-encoded headers" : "normal")));
+        for (i=0; i<REPEAT; ++i) {
+            status = encode_response_bench(j, &usec[i]);
+            if (status != PJ_SUCCESS)
+                return status;
+        }
+
+        min.u64 = PJ_UINT64(0xFFFFFFFFFFFFFFF);
+        for (i=0; i<REPEAT; ++i) {
+            if (usec[i].u64 < min.u64) min.u64 = usec[i].u64;
+        }
+
+        msgs = (unsigned)(freq.u64 * LOOP / min.u64);
+
+        PJ_LOG(3,(THIS_FILE, "    Responses created and printed at %d "
+                  "responses/sec", msgs));
+    }
+
+    report_ival("encode-response-per-sec", 
+                msgs, "msg/sec",
+                "Number of responses that can be created and printed per "
+                "second, three responses per request, with "
+                "<tt>encode_rsp_hdr</tt> enabled");
+
+
+    /*
+     * Benchmark 401 responses with the normal API and printed directly
+     * from the request.
+     */
+    for (j=0; j<2; ++j) {
+        PJ_LOG(3,(THIS_FILE, "   benchmarking stateless 401 response (%s):",
+                  (j ? "raw" : "normal")));
+        for (i=0; i<REPEAT; ++i) {
+            status = stateless_rsp_bench(j, &usec[i]);
+            if (status != PJ_SUCCESS)
+                return status;
+        }
+
+        min.u64 = PJ_UINT64(0xFFFFFFFFFFFFFFF);
+        for (i=0; i<REPEAT; ++i) {
+            if (usec[i].u64 < min.u64) min.u64 = usec[i].u64;
+        }
+
+        msgs = (unsigned)(freq.u64 * LOOP / min.u64);
+
+        PJ_LOG(3,(THIS_FILE, "    Responses printed at %d responses/sec",
+                  msgs));
+    }
+
+    report_ival("raw-response-per-sec",
+                msgs, "msg/sec",
+                "Number of 401 responses that can be printed per second "
+                "with <tt>pjsip_print_stateless_response()</tt>");
+
     return 0;
 }
  